@@ -0,0 +1,385 @@
+/***************************************************************************
+  qgscontractionhierarchy.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscontractionhierarchy.h"
+#include "qgscsrgraph.h"
+#include "qgsgraphheap_p.h"
+#include "qgsfeedback.h"
+
+#include <QPair>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+//! Maximum number of vertices settled by a witness search
+static const int WITNESS_SETTLE_LIMIT = 500;
+
+struct QgsContractionArc
+{
+  int vertex;
+  double cost;
+};
+
+typedef QVector< QgsContractionArc > QgsContractionArcs;
+
+/**
+ * Contracts the vertices of a graph and collects the edges of the upward graphs.
+ */
+class QgsContractionBuilder
+{
+  public:
+
+    explicit QgsContractionBuilder( const QgsCsrGraph &graph )
+      : mOut( graph.vertexCount() )
+      , mIn( graph.vertexCount() )
+      , mContractedNeighbors( graph.vertexCount(), 0 )
+      , mWitnessHeap( graph.vertexCount() )
+      , mWitnessCosts( graph.vertexCount(), std::numeric_limits<double>::infinity() )
+    {
+      for ( int vertex = 0; vertex < graph.vertexCount(); ++vertex )
+      {
+        for ( int edge = graph.firstEdge( vertex ); edge < graph.endEdge( vertex ); ++edge )
+        {
+          // loops never lie on a shortest path
+          if ( graph.edgeTarget( edge ) != vertex )
+            addArc( vertex, graph.edgeTarget( edge ), graph.edgeCost( edge ) );
+        }
+      }
+    }
+
+    //! Returns the contraction priority of a vertex - the lower the earlier it is contracted
+    double priority( int vertex )
+    {
+      int edgeDifference = contract( vertex, false ) - mIn.at( vertex ).count() - mOut.at( vertex ).count();
+      return edgeDifference + mContractedNeighbors.at( vertex );
+    }
+
+    /**
+     * Contracts a \a vertex: adds the required shortcuts between its neighbors and removes it
+     * from the graph. Its remaining edges, which all lead to vertices contracted later, are
+     * returned in \a upward and \a downward. Returns number of added shortcuts.
+     */
+    int contractVertex( int vertex, QgsContractionArcs &upward, QgsContractionArcs &downward )
+    {
+      int shortcuts = contract( vertex, true );
+
+      upward = mOut.at( vertex );
+      downward = mIn.at( vertex );
+      Q_FOREACH ( const QgsContractionArc &arc, upward )
+      {
+        removeArc( mIn[arc.vertex], vertex );
+        mContractedNeighbors[arc.vertex]++;
+      }
+      Q_FOREACH ( const QgsContractionArc &arc, downward )
+      {
+        removeArc( mOut[arc.vertex], vertex );
+        mContractedNeighbors[arc.vertex]++;
+      }
+      mOut[vertex].clear();
+      mIn[vertex].clear();
+      return shortcuts;
+    }
+
+  private:
+
+    void addArc( int from, int to, double cost )
+    {
+      // keep only the cheapest of parallel edges
+      QgsContractionArcs &out = mOut[from];
+      for ( int i = 0; i < out.count(); ++i )
+      {
+        if ( out.at( i ).vertex == to )
+        {
+          if ( cost < out.at( i ).cost )
+          {
+            out[i].cost = cost;
+            QgsContractionArcs &in = mIn[to];
+            for ( int j = 0; j < in.count(); ++j )
+            {
+              if ( in.at( j ).vertex == from )
+                in[j].cost = cost;
+            }
+          }
+          return;
+        }
+      }
+
+      out.append( { to, cost } );
+      mIn[to].append( { from, cost } );
+    }
+
+    static void removeArc( QgsContractionArcs &arcs, int vertex )
+    {
+      for ( int i = 0; i < arcs.count(); ++i )
+      {
+        if ( arcs.at( i ).vertex == vertex )
+        {
+          arcs.remove( i );
+          return;
+        }
+      }
+    }
+
+    /**
+     * Finds the shortcuts needed when contracting \a vertex, and adds them if \a apply
+     * is true. Returns number of shortcuts.
+     */
+    int contract( int vertex, bool apply )
+    {
+      const QgsContractionArcs in = mIn.at( vertex );
+      const QgsContractionArcs out = mOut.at( vertex );
+      if ( in.isEmpty() || out.isEmpty() )
+        return 0;
+
+      double maxOutCost = 0;
+      Q_FOREACH ( const QgsContractionArc &arc, out )
+        maxOutCost = std::max( maxOutCost, arc.cost );
+
+      int shortcuts = 0;
+      Q_FOREACH ( const QgsContractionArc &inArc, in )
+      {
+        // a shortcut is not needed if there is a path avoiding the vertex
+        // which is not longer than the path over it
+        witnessSearch( inArc.vertex, vertex, inArc.cost + maxOutCost );
+        Q_FOREACH ( const QgsContractionArc &outArc, out )
+        {
+          if ( outArc.vertex == inArc.vertex )
+            continue;
+
+          double cost = inArc.cost + outArc.cost;
+          if ( mWitnessCosts.at( outArc.vertex ) > cost )
+          {
+            shortcuts++;
+            if ( apply )
+              addArc( inArc.vertex, outArc.vertex, cost );
+          }
+        }
+      }
+      return shortcuts;
+    }
+
+    //! Dijkstra search from \a source avoiding \a skipped vertex, limited by \a maxCost
+    void witnessSearch( int source, int skipped, double maxCost )
+    {
+      Q_FOREACH ( int vertex, mWitnessTouched )
+        mWitnessCosts[vertex] = std::numeric_limits<double>::infinity();
+      mWitnessTouched.clear();
+
+      mWitnessCosts[source] = 0;
+      mWitnessTouched << source;
+      mWitnessHeap.push( source, 0 );
+
+      int settled = 0;
+      while ( !mWitnessHeap.isEmpty() )
+      {
+        double cost;
+        int vertex = mWitnessHeap.pop( cost );
+        if ( cost > maxCost || ++settled > WITNESS_SETTLE_LIMIT )
+          break;
+
+        Q_FOREACH ( const QgsContractionArc &arc, mOut.at( vertex ) )
+        {
+          if ( arc.vertex == skipped )
+            continue;
+
+          double newCost = cost + arc.cost;
+          if ( newCost < mWitnessCosts.at( arc.vertex ) )
+          {
+            if ( std::isinf( mWitnessCosts.at( arc.vertex ) ) )
+              mWitnessTouched << arc.vertex;
+            mWitnessCosts[arc.vertex] = newCost;
+            mWitnessHeap.push( arc.vertex, newCost );
+          }
+        }
+      }
+      mWitnessHeap.clear();
+    }
+
+    QVector< QgsContractionArcs > mOut;
+    QVector< QgsContractionArcs > mIn;
+    QVector< int > mContractedNeighbors;
+
+    QgsGraphHeap<> mWitnessHeap;
+    QVector< double > mWitnessCosts;
+    QVector< int > mWitnessTouched;
+};
+
+struct QgsContractionHierarchy::SearchState
+{
+  explicit SearchState( int vertexCount )
+    : heap( vertexCount )
+    , costs( vertexCount, std::numeric_limits<double>::infinity() )
+  {}
+
+  QgsGraphHeap<> heap;
+  QVector<double> costs;
+  //! Vertices reached by the last search, in the order they were settled
+  QVector<int> settled;
+};
+
+///@endcond
+
+QgsContractionHierarchy::QgsContractionHierarchy( const QgsCsrGraph &graph, QgsFeedback *feedback )
+  : mRanks( graph.vertexCount(), -1 )
+{
+  int vertexCount = graph.vertexCount();
+  QgsContractionBuilder builder( graph );
+
+  // contraction order is driven by a priority queue with lazy updates: the priority
+  // of the next vertex is recalculated before contracting it and if it is no longer the
+  // lowest one, the vertex is queued again
+  QgsGraphHeap<> queue( vertexCount );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+    queue.push( vertex, builder.priority( vertex ) );
+
+  QVector< QgsContractionArcs > upward( vertexCount );
+  QVector< QgsContractionArcs > downward( vertexCount );
+  int rank = 0;
+  while ( !queue.isEmpty() )
+  {
+    if ( feedback && feedback->isCanceled() )
+      return;
+
+    double priority;
+    int vertex = queue.pop( priority );
+    priority = builder.priority( vertex );
+    if ( !queue.isEmpty() && priority > queue.topKey() )
+    {
+      queue.push( vertex, priority );
+      continue;
+    }
+
+    mShortcutCount += builder.contractVertex( vertex, upward[vertex], downward[vertex] );
+    mRanks[vertex] = rank++;
+
+    if ( feedback && rank % 1000 == 0 )
+      feedback->setProgress( 100.0 * rank / vertexCount );
+  }
+
+  // pack the upward graphs
+  mForward.offsets.reserve( vertexCount + 1 );
+  mBackward.offsets.reserve( vertexCount + 1 );
+  for ( int vertex = 0; vertex < vertexCount; ++vertex )
+  {
+    mForward.offsets << mForward.targets.count();
+    Q_FOREACH ( const QgsContractionArc &arc, upward.at( vertex ) )
+    {
+      mForward.targets << arc.vertex;
+      mForward.costs << arc.cost;
+    }
+
+    mBackward.offsets << mBackward.targets.count();
+    Q_FOREACH ( const QgsContractionArc &arc, downward.at( vertex ) )
+    {
+      mBackward.targets << arc.vertex;
+      mBackward.costs << arc.cost;
+    }
+  }
+  mForward.offsets << mForward.targets.count();
+  mBackward.offsets << mBackward.targets.count();
+
+  mValid = true;
+}
+
+void QgsContractionHierarchy::upwardSearch( const UpwardGraph &graph, int source, SearchState &state ) const
+{
+  Q_FOREACH ( int vertex, state.settled )
+    state.costs[vertex] = std::numeric_limits<double>::infinity();
+  state.settled.clear();
+
+  state.costs[source] = 0;
+  state.heap.push( source, 0 );
+  while ( !state.heap.isEmpty() )
+  {
+    double cost;
+    int vertex = state.heap.pop( cost );
+    state.settled << vertex;
+
+    for ( int edge = graph.offsets.at( vertex ); edge < graph.offsets.at( vertex + 1 ); ++edge )
+    {
+      int target = graph.targets.at( edge );
+      double newCost = cost + graph.costs.at( edge );
+      if ( newCost < state.costs.at( target ) )
+      {
+        state.costs[target] = newCost;
+        state.heap.push( target, newCost );
+      }
+    }
+  }
+}
+
+double QgsContractionHierarchy::cost( int fromVertex, int toVertex ) const
+{
+  QVector<double> costs = costMatrix( QVector<int>() << fromVertex, QVector<int>() << toVertex );
+  return costs.at( 0 );
+}
+
+QVector<double> QgsContractionHierarchy::costMatrix( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback ) const
+{
+  int vertexCount = mRanks.count();
+  QVector<double> result( origins.count() * destinations.count(), std::numeric_limits<double>::infinity() );
+  if ( !mValid )
+    return result;
+
+  SearchState state( vertexCount );
+
+  // the shortest path from an origin to a destination goes up the hierarchy from
+  // both of them to the highest ranked vertex on the path. Searches from the destinations
+  // leave their costs in buckets at the vertices they reach, searches from the origins
+  // then combine them with their own costs
+  QVector< QVector< QPair< int, double > > > buckets( vertexCount );
+  for ( int j = 0; j < destinations.count(); ++j )
+  {
+    int destination = destinations.at( j );
+    if ( destination < 0 || destination >= vertexCount )
+      continue;
+    if ( feedback && feedback->isCanceled() )
+      return result;
+
+    upwardSearch( mBackward, destination, state );
+    Q_FOREACH ( int vertex, state.settled )
+      buckets[vertex] << qMakePair( j, state.costs.at( vertex ) );
+  }
+
+  for ( int i = 0; i < origins.count(); ++i )
+  {
+    int origin = origins.at( i );
+    if ( origin < 0 || origin >= vertexCount )
+      continue;
+    if ( feedback && feedback->isCanceled() )
+      return result;
+
+    upwardSearch( mForward, origin, state );
+    double *row = result.data() + i * destinations.count();
+    Q_FOREACH ( int vertex, state.settled )
+    {
+      double cost = state.costs.at( vertex );
+      const QVector< QPair< int, double > > &bucket = buckets.at( vertex );
+      for ( int k = 0; k < bucket.count(); ++k )
+      {
+        double total = cost + bucket.at( k ).second;
+        if ( total < row[bucket.at( k ).first] )
+          row[bucket.at( k ).first] = total;
+      }
+    }
+
+    if ( feedback )
+      feedback->setProgress( 100.0 * ( i + 1 ) / origins.count() );
+  }
+
+  return result;
+}
@@ -0,0 +1,105 @@
+/***************************************************************************
+  qgscontractionhierarchy.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCONTRACTIONHIERARCHY_H
+#define QGSCONTRACTIONHIERARCHY_H
+
+#include <QVector>
+
+#include "qgis_analysis.h"
+
+class QgsCsrGraph;
+class QgsFeedback;
+
+/**
+ * \ingroup analysis
+ * \class QgsContractionHierarchy
+ * \brief Contraction hierarchy of a graph for fast shortest path cost queries.
+ *
+ * The preprocessing contracts the vertices of a QgsCsrGraph one by one, in order of their
+ * importance, adding shortcut edges which preserve the shortest paths among the remaining
+ * vertices. A query then only runs two small Dijkstra searches, upwards in the hierarchy from
+ * the origin and from the destination, instead of a search over the whole graph.
+ *
+ * The preprocessing pays off when many queries are run on the same graph, especially for
+ * origin-destination cost matrices, which are computed with bucket based many-to-many
+ * searches by costMatrix().
+ *
+ * Only path costs are available - the shortest path tree can be obtained with
+ * QgsGraphAnalyzer::dijkstra().
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsContractionHierarchy
+{
+  public:
+
+    /**
+     * Constructor for QgsContractionHierarchy, building the hierarchy for a \a graph.
+     *
+     * The optional \a feedback object can be used to report progress and to cancel the
+     * preprocessing, in which case the hierarchy is not valid.
+     */
+    explicit QgsContractionHierarchy( const QgsCsrGraph &graph, QgsFeedback *feedback = nullptr );
+
+    //! Returns true if the preprocessing was completed
+    bool isValid() const { return mValid; }
+
+    //! Returns number of vertices of the graph
+    int vertexCount() const { return mRanks.count(); }
+
+    //! Returns number of shortcut edges added by the preprocessing
+    int shortcutCount() const { return mShortcutCount; }
+
+    //! Returns position of a \a vertex in the contraction order, less important vertices have lower ranks
+    int rank( int vertex ) const { return mRanks.at( vertex ); }
+
+    /**
+     * Returns cost of the shortest path from \a fromVertex to \a toVertex, or infinity if
+     * there is no such path.
+     */
+    double cost( int fromVertex, int toVertex ) const;
+
+    /**
+     * Returns costs of the shortest paths from all \a origins to all \a destinations, as a
+     * matrix stored row by row: the cost from origins[i] to destinations[j] is at index
+     * i * destinations.count() + j. Unreachable destinations have infinite cost.
+     *
+     * The optional \a feedback object can be used to cancel the calculation.
+     */
+    QVector<double> costMatrix( const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback = nullptr ) const;
+
+  private:
+
+    //! Edges leading to vertices of higher rank, in CSR format
+    struct UpwardGraph
+    {
+      QVector<int> offsets;
+      QVector<int> targets;
+      QVector<double> costs;
+    };
+
+    struct SearchState;
+
+    void upwardSearch( const UpwardGraph &graph, int source, SearchState &state ) const;
+
+    //! Edges for the search from the origin
+    UpwardGraph mForward;
+    //! Reversed edges for the search from the destination
+    UpwardGraph mBackward;
+    QVector<int> mRanks;
+    int mShortcutCount = 0;
+    bool mValid = false;
+};
+
+#endif // QGSCONTRACTIONHIERARCHY_H
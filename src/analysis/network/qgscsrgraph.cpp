@@ -0,0 +1,44 @@
+/***************************************************************************
+  qgscsrgraph.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#include "qgscsrgraph.h"
+#include "qgsgraph.h"
+
+QgsCsrGraph::QgsCsrGraph( const QgsGraph *graph, int strategyIndex )
+{
+  int vertexCount = graph->vertexCount();
+  int edgeCount = graph->edgeCount();
+
+  // count outgoing edges of each vertex, then turn the counts into offsets
+  mOffsets.fill( 0, vertexCount + 1 );
+  for ( int i = 0; i < edgeCount; ++i )
+    mOffsets[graph->edge( i ).outVertex() + 1]++;
+  for ( int i = 0; i < vertexCount; ++i )
+    mOffsets[i + 1] += mOffsets.at( i );
+
+  mTargets.resize( edgeCount );
+  mCosts.resize( edgeCount );
+  mSourceEdges.resize( edgeCount );
+
+  // edges keep their original order for each vertex
+  QVector<int> next = mOffsets;
+  for ( int i = 0; i < edgeCount; ++i )
+  {
+    const QgsGraphEdge &edge = graph->edge( i );
+    int pos = next[edge.outVertex()]++;
+    mTargets[pos] = edge.inVertex();
+    mCosts[pos] = edge.cost( strategyIndex ).toDouble();
+    mSourceEdges[pos] = i;
+  }
+}
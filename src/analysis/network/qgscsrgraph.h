@@ -0,0 +1,84 @@
+/***************************************************************************
+  qgscsrgraph.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSCSRGRAPH_H
+#define QGSCSRGRAPH_H
+
+#include <QVector>
+
+#include "qgis_analysis.h"
+
+class QgsGraph;
+
+/**
+ * \ingroup analysis
+ * \class QgsCsrGraph
+ * \brief Compact read-only graph stored in compressed sparse row (CSR) format.
+ *
+ * Outgoing edges of all vertices are kept in flat arrays sorted by their start vertex,
+ * with the cost of a single optimization strategy converted to double. Compared to
+ * QgsGraph, which stores lists of edge ids and QVariant costs for every vertex and edge,
+ * this needs a fraction of the memory and allows fast shortest path searches on large
+ * networks with QgsGraphAnalyzer and QgsContractionHierarchy.
+ *
+ * Vertex indexes are the same as in the QgsGraph the CSR graph was created from.
+ * \since QGIS 3.0
+ */
+class ANALYSIS_EXPORT QgsCsrGraph
+{
+  public:
+
+    //! Constructor for an empty graph
+    QgsCsrGraph() = default;
+
+    /**
+     * Constructor for QgsCsrGraph from a \a graph, using the edge costs of the optimization
+     * strategy with index \a strategyIndex.
+     */
+    QgsCsrGraph( const QgsGraph *graph, int strategyIndex );
+
+    //! Returns number of vertices
+    int vertexCount() const { return mOffsets.isEmpty() ? 0 : mOffsets.count() - 1; }
+
+    //! Returns number of edges
+    int edgeCount() const { return mTargets.count(); }
+
+    /**
+     * Returns index of the first outgoing edge of \a vertex. The outgoing edges of
+     * a vertex are numbered from firstEdge() to endEdge() - 1.
+     */
+    int firstEdge( int vertex ) const { return mOffsets.at( vertex ); }
+
+    //! Returns index past the last outgoing edge of \a vertex
+    int endEdge( int vertex ) const { return mOffsets.at( vertex + 1 ); }
+
+    //! Returns index of the vertex an \a edge leads to
+    int edgeTarget( int edge ) const { return mTargets.at( edge ); }
+
+    //! Returns cost of an \a edge
+    double edgeCost( int edge ) const { return mCosts.at( edge ); }
+
+    //! Returns index of an \a edge in the source QgsGraph
+    int sourceEdge( int edge ) const { return mSourceEdges.at( edge ); }
+
+  private:
+
+    //! First edge of each vertex, with an additional item for the end of the last vertex
+    QVector<int> mOffsets;
+    QVector<int> mTargets;
+    QVector<double> mCosts;
+    QVector<int> mSourceEdges;
+};
+
+#endif // QGSCSRGRAPH_H
@@ -13,14 +13,16 @@
 *                                                                          *
 ***************************************************************************/
 
+#include <cmath>
 #include <limits>
 
-#include <QMap>
 #include <QVector>
-#include <QPair>
 
 #include "qgsgraph.h"
 #include "qgsgraphanalyzer.h"
+#include "qgscsrgraph.h"
+#include "qgsgraphheap_p.h"
+#include "qgsfeedback.h"
 
 void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int criterionNum, QVector<int> *resultTree, QVector<double> *resultCost )
 {
@@ -44,19 +46,13 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
     resultTree->insert( resultTree->begin(), source->vertexCount(), -1 );
   }
 
-  // QMultiMap< cost, vertexIdx > not_begin
-  // I use it and don't create any struct or class
-  QMultiMap< double, int > not_begin;
-  QMultiMap< double, int >::iterator it;
+  QgsGraphHeap<> not_begin( source->vertexCount() );
+  not_begin.push( startPointIdx, 0.0 );
 
-  not_begin.insert( 0.0, startPointIdx );
-
-  while ( !not_begin.empty() )
+  while ( !not_begin.isEmpty() )
   {
-    it = not_begin.begin();
-    double curCost = it.key();
-    int curVertex = it.value();
-    not_begin.erase( it );
+    double curCost;
+    int curVertex = not_begin.pop( curCost );
 
     // edge index list
     QgsGraphEdgeIds l = source->vertex( curVertex ).outEdges();
@@ -73,7 +69,7 @@ void QgsGraphAnalyzer::dijkstra( const QgsGraph *source, int startPointIdx, int
         {
           ( *resultTree )[ arc.inVertex()] = *arcIt;
         }
-        not_begin.insert( cost, arc.inVertex() );
+        not_begin.push( arc.inVertex(), cost );
       }
     }
   }
@@ -118,3 +114,110 @@ QgsGraph *QgsGraphAnalyzer::shortestTree( const QgsGraph *source, int startVerte
 
   return treeResult;
 }
+
+void QgsGraphAnalyzer::dijkstra( const QgsCsrGraph *graph, int startVertexIdx, QVector<int> *resultTree, QVector<double> *resultCost )
+{
+  QVector<double> costs( graph->vertexCount(), std::numeric_limits<double>::infinity() );
+  if ( resultTree )
+    resultTree->fill( -1, graph->vertexCount() );
+
+  costs[ startVertexIdx ] = 0.0;
+  QgsGraphHeap<> heap( graph->vertexCount() );
+  heap.push( startVertexIdx, 0.0 );
+  while ( !heap.isEmpty() )
+  {
+    double curCost;
+    int curVertex = heap.pop( curCost );
+
+    for ( int edge = graph->firstEdge( curVertex ); edge < graph->endEdge( curVertex ); ++edge )
+    {
+      int target = graph->edgeTarget( edge );
+      double cost = curCost + graph->edgeCost( edge );
+      if ( cost < costs.at( target ) )
+      {
+        costs[ target ] = cost;
+        if ( resultTree )
+          ( *resultTree )[ target ] = graph->sourceEdge( edge );
+        heap.push( target, cost );
+      }
+    }
+  }
+
+  if ( resultCost )
+    *resultCost = costs;
+}
+
+QVector<double> QgsGraphAnalyzer::costMatrix( const QgsCsrGraph *graph, const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback )
+{
+  int vertexCount = graph->vertexCount();
+  QVector<double> result( origins.count() * destinations.count(), std::numeric_limits<double>::infinity() );
+
+  // column of each destination vertex in the result, or -1
+  QVector<int> firstColumn( vertexCount, -1 );
+  QVector<int> nextColumn( destinations.count(), -1 );
+  int destinationVertices = 0;
+  for ( int j = destinations.count() - 1; j >= 0; --j )
+  {
+    int destination = destinations.at( j );
+    if ( destination < 0 || destination >= vertexCount )
+      continue;
+    if ( firstColumn.at( destination ) < 0 )
+      destinationVertices++;
+    nextColumn[j] = firstColumn.at( destination );
+    firstColumn[destination] = j;
+  }
+
+  QVector<double> costs( vertexCount, std::numeric_limits<double>::infinity() );
+  QVector<int> touched;
+  QgsGraphHeap<> heap( vertexCount );
+  for ( int i = 0; i < origins.count(); ++i )
+  {
+    int origin = origins.at( i );
+    if ( origin < 0 || origin >= vertexCount )
+      continue;
+    if ( feedback && feedback->isCanceled() )
+      break;
+
+    Q_FOREACH ( int vertex, touched )
+      costs[vertex] = std::numeric_limits<double>::infinity();
+    touched.clear();
+
+    costs[origin] = 0.0;
+    touched << origin;
+    heap.push( origin, 0.0 );
+
+    // the search stops as soon as all destinations are settled
+    double *row = result.data() + i * destinations.count();
+    int remaining = destinationVertices;
+    while ( !heap.isEmpty() && remaining > 0 )
+    {
+      double curCost;
+      int curVertex = heap.pop( curCost );
+      if ( firstColumn.at( curVertex ) >= 0 )
+      {
+        for ( int j = firstColumn.at( curVertex ); j >= 0; j = nextColumn.at( j ) )
+          row[j] = curCost;
+        remaining--;
+      }
+
+      for ( int edge = graph->firstEdge( curVertex ); edge < graph->endEdge( curVertex ); ++edge )
+      {
+        int target = graph->edgeTarget( edge );
+        double cost = curCost + graph->edgeCost( edge );
+        if ( cost < costs.at( target ) )
+        {
+          if ( std::isinf( costs.at( target ) ) )
+            touched << target;
+          costs[ target ] = cost;
+          heap.push( target, cost );
+        }
+      }
+    }
+    heap.clear();
+
+    if ( feedback )
+      feedback->setProgress( 100.0 * ( i + 1 ) / origins.count() );
+  }
+
+  return result;
+}
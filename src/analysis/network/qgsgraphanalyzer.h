@@ -22,6 +22,8 @@
 #include "qgis_analysis.h"
 
 class QgsGraph;
+class QgsCsrGraph;
+class QgsFeedback;
 
 /** \ingroup analysis
  *  This class performs graph analysis, e.g. calculates shortest path between two
@@ -80,6 +82,31 @@ class ANALYSIS_EXPORT QgsGraphAnalyzer
      * \param criterionNum index of the optimization strategy
      */
     static QgsGraph *shortestTree( const QgsGraph *source, int startVertexIdx, int criterionNum );
+
+    /**
+     * Solve shortest path problem on a compact \a graph using Dijkstra algorithm
+     * \param graph source graph
+     * \param startVertexIdx index of the start vertex
+     * \param resultTree array that represents shortest path tree. resultTree[ vertexIndex ] == inboundingArcIndex if vertex reachable, otherwise resultTree[ vertexIndex ] == -1.
+     * Arc indexes refer to the QgsGraph the compact graph was created from.
+     * \param resultCost array of the paths costs
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static void dijkstra( const QgsCsrGraph *graph, int startVertexIdx, QVector<int> *resultTree = nullptr, QVector<double> *resultCost = nullptr ) SIP_SKIP;
+
+    /**
+     * Returns costs of the shortest paths from all \a origins to all \a destinations in a \a graph,
+     * as a matrix stored row by row: the cost from origins[i] to destinations[j] is at index
+     * i * destinations.count() + j. Unreachable destinations have infinite cost.
+     *
+     * A Dijkstra search is run from each origin, until all destinations are reached. For large
+     * matrices QgsContractionHierarchy::costMatrix() is usually much faster.
+     *
+     * The optional \a feedback object can be used to cancel the calculation.
+     * \since QGIS 3.0
+     */
+    static QVector<double> costMatrix( const QgsCsrGraph *graph, const QVector<int> &origins, const QVector<int> &destinations, QgsFeedback *feedback = nullptr );
 };
 
 #endif // QGSGRAPHANALYZER_H
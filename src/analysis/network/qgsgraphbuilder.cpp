@@ -20,6 +20,7 @@
 
 #include "qgsgraphbuilder.h"
 #include "qgsgraph.h"
+#include "qgscsrgraph.h"
 
 #include "qgsfeature.h"
 #include "qgsgeometry.h"
@@ -51,3 +52,11 @@ QgsGraph *QgsGraphBuilder::graph()
   mGraph = nullptr;
   return res;
 }
+
+QgsCsrGraph *QgsGraphBuilder::csrGraph( int strategyIndex ) const
+{
+  if ( !mGraph )
+    return nullptr;
+
+  return new QgsCsrGraph( mGraph, strategyIndex );
+}
@@ -25,6 +25,7 @@
 class QgsDistanceArea;
 class QgsCoordinateTransform;
 class QgsGraph;
+class QgsCsrGraph;
 
 /**
 * \ingroup analysis
@@ -55,6 +56,13 @@ class ANALYSIS_EXPORT QgsGraphBuilder : public QgsGraphBuilderInterface
      */
     QgsGraph *graph() SIP_FACTORY;
 
+    /**
+     * Returns a compact copy of the generated graph, with edge costs of the strategy with index
+     * \a strategyIndex. It must be called before graph(), otherwise nullptr is returned.
+     * \since QGIS 3.0
+     */
+    QgsCsrGraph *csrGraph( int strategyIndex = 0 ) const SIP_FACTORY;
+
   private:
 
     QgsGraph *mGraph = nullptr;
@@ -0,0 +1,159 @@
+/***************************************************************************
+  qgsgraphheap_p.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+****************************************************************************
+*                                                                          *
+*   This program is free software; you can redistribute it and/or modify   *
+*   it under the terms of the GNU General Public License as published by   *
+*   the Free Software Foundation; either version 2 of the License, or      *
+*   (at your option) any later version.                                    *
+*                                                                          *
+***************************************************************************/
+
+#ifndef QGSGRAPHHEAP_PRIVATE_H
+#define QGSGRAPHHEAP_PRIVATE_H
+
+/// @cond PRIVATE
+
+//
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the QGIS API.  It exists purely as an
+// implementation detail.  This header file may change from version to
+// version without notice, or even be removed.
+//
+
+#include <QVector>
+
+#include <algorithm>
+
+/**
+ * Indexed d-ary min-heap of graph vertices keyed by their tentative distance, as used by
+ * the Dijkstra searches of QgsGraphAnalyzer and QgsContractionHierarchy.
+ *
+ * Each vertex is in the heap at most once: pushing a vertex which is already queued
+ * decreases its key. A heap may be reused for many searches over the same graph, clearing
+ * it only touches the vertices left in the heap.
+ */
+template <int D = 4>
+class QgsGraphHeap
+{
+  public:
+
+    //! Constructor for a heap of vertices with indexes 0 to \a vertexCount - 1
+    explicit QgsGraphHeap( int vertexCount )
+      : mPositions( vertexCount, -1 )
+    {}
+
+    bool isEmpty() const { return mVertices.isEmpty(); }
+
+    //! Returns true if \a vertex is in the heap
+    bool contains( int vertex ) const { return mPositions.at( vertex ) >= 0; }
+
+    //! Returns the smallest key in the heap, which must not be empty
+    double topKey() const { return mKeys.at( 0 ); }
+
+    /**
+     * Inserts \a vertex with given \a key or, if it is already queued with a larger
+     * key, decreases its key.
+     */
+    void push( int vertex, double key )
+    {
+      int pos = mPositions.at( vertex );
+      if ( pos < 0 )
+      {
+        pos = mVertices.count();
+        mVertices.append( vertex );
+        mKeys.append( key );
+      }
+      else if ( key >= mKeys.at( pos ) )
+      {
+        return;
+      }
+      siftUp( pos, vertex, key );
+    }
+
+    //! Removes the vertex with the smallest key and returns it, its key is stored in \a key
+    int pop( double &key )
+    {
+      int vertex = mVertices.at( 0 );
+      key = mKeys.at( 0 );
+      mPositions[vertex] = -1;
+
+      int lastVertex = mVertices.last();
+      double lastKey = mKeys.last();
+      mVertices.removeLast();
+      mKeys.removeLast();
+      if ( !mVertices.isEmpty() )
+        siftDown( 0, lastVertex, lastKey );
+      return vertex;
+    }
+
+    //! Removes all vertices from the heap
+    void clear()
+    {
+      for ( int i = 0; i < mVertices.count(); ++i )
+        mPositions[mVertices.at( i )] = -1;
+      mVertices.clear();
+      mKeys.clear();
+    }
+
+  private:
+
+    void siftUp( int pos, int vertex, double key )
+    {
+      while ( pos > 0 )
+      {
+        int parent = ( pos - 1 ) / D;
+        if ( mKeys.at( parent ) <= key )
+          break;
+        place( pos, mVertices.at( parent ), mKeys.at( parent ) );
+        pos = parent;
+      }
+      place( pos, vertex, key );
+    }
+
+    void siftDown( int pos, int vertex, double key )
+    {
+      int count = mVertices.count();
+      while ( true )
+      {
+        int first = pos * D + 1;
+        if ( first >= count )
+          break;
+
+        int last = std::min( first + D, count );
+        int best = first;
+        for ( int child = first + 1; child < last; ++child )
+        {
+          if ( mKeys.at( child ) < mKeys.at( best ) )
+            best = child;
+        }
+        if ( mKeys.at( best ) >= key )
+          break;
+
+        place( pos, mVertices.at( best ), mKeys.at( best ) );
+        pos = best;
+      }
+      place( pos, vertex, key );
+    }
+
+    void place( int pos, int vertex, double key )
+    {
+      mVertices[pos] = vertex;
+      mKeys[pos] = key;
+      mPositions[vertex] = pos;
+    }
+
+    //! Heap position of each vertex, -1 if the vertex is not in the heap
+    QVector<int> mPositions;
+    QVector<int> mVertices;
+    QVector<double> mKeys;
+};
+
+/// @endcond
+
+#endif // QGSGRAPHHEAP_PRIVATE_H
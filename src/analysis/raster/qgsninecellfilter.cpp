@@ -20,6 +20,12 @@
 #include "cpl_string.h"
 #include "qgsfeedback.h"
 #include <QFile>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <vector>
 
 QgsNineCellFilter::QgsNineCellFilter( const QString &inputFile, const QString &outputFile, const QString &outputFormat )
   : mInputFile( inputFile )
@@ -43,6 +49,89 @@ QgsNineCellFilter::QgsNineCellFilter()
 {
 }
 
+namespace
+{
+  //! Target size in bytes of the input rows of a strip
+  const qint64 STRIP_SIZE = 4 * 1024 * 1024;
+
+  //! Computes the output rows of a strip of a batch of rows
+  struct ProcessStrip
+  {
+    typedef void result_type;
+
+    ProcessStrip( QgsNineCellFilter *filter, float *input, float *output, int xSize, int stripHeight, int rowCount, QgsFeedback *feedback )
+      : mFilter( filter )
+      , mInput( input )
+      , mOutput( output )
+      , mXSize( xSize )
+      , mStripHeight( stripHeight )
+      , mRowCount( rowCount )
+      , mFeedback( feedback )
+    {}
+
+    void operator()( int strip )
+    {
+      const int paddedWidth = mXSize + 2;
+      const int lastRow = std::min( ( strip + 1 ) * mStripHeight, mRowCount );
+      for ( int row = strip * mStripHeight; row < lastRow; ++row )
+      {
+        if ( mFeedback && mFeedback->isCanceled() )
+        {
+          return;
+        }
+
+        //output row i is computed from input rows i to i + 2, the padding columns are the border
+        float *scanLine1 = mInput + static_cast< size_t >( row ) * paddedWidth;
+        float *scanLine2 = scanLine1 + paddedWidth;
+        float *scanLine3 = scanLine2 + paddedWidth;
+        float *resultLine = mOutput + static_cast< size_t >( row ) * mXSize;
+        for ( int j = 0; j < mXSize; ++j )
+        {
+          resultLine[j] = mFilter->processNineCellWindow( &scanLine1[j], &scanLine1[j + 1], &scanLine1[j + 2],
+                          &scanLine2[j], &scanLine2[j + 1], &scanLine2[j + 2],
+                          &scanLine3[j], &scanLine3[j + 1], &scanLine3[j + 2] );
+        }
+      }
+    }
+
+    QgsNineCellFilter *mFilter = nullptr;
+    float *mInput = nullptr;
+    float *mOutput = nullptr;
+    int mXSize;
+    int mStripHeight;
+    int mRowCount;
+    QgsFeedback *mFeedback = nullptr;
+  };
+
+  //! Writes the output rows of a batch
+  class WriteRows : public QRunnable
+  {
+    public:
+      WriteRows( GDALRasterBandH band, float *rows, int xSize, int firstRow, int rowCount )
+        : mBand( band )
+        , mRows( rows )
+        , mXSize( xSize )
+        , mFirstRow( firstRow )
+        , mRowCount( rowCount )
+      {}
+
+      void run() override
+      {
+        if ( GDALRasterIO( mBand, GF_Write, 0, mFirstRow, mXSize, mRowCount, mRows, mXSize, mRowCount, GDT_Float32, 0, 0 ) != CE_None )
+        {
+          QgsDebugMsg( "Raster IO Error" );
+        }
+      }
+
+    private:
+      GDALRasterBandH mBand;
+      float *mRows = nullptr;
+      int mXSize;
+      int mFirstRow;
+      int mRowCount;
+  };
+}
+
 int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
 {
   GDALAllRegister();
@@ -96,15 +185,31 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
     return 6;
   }
 
-  //keep only three scanlines in memory at a time
-  float *scanLine1 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine2 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-  float *scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  //the rows are computed in strips of rows aligned to the blocks of the input, one per thread
+  const int paddedWidth = xSize + 2;
+  int blockXSize = 0;
+  int blockYSize = 0;
+  GDALGetBlockSize( rasterBand, &blockXSize, &blockYSize );
+  int stripHeight = std::max( 1, static_cast< int >( STRIP_SIZE / ( sizeof( float ) * paddedWidth ) ) );
+  if ( blockYSize > 0 && blockYSize <= stripHeight )
+  {
+    stripHeight -= stripHeight % blockYSize;
+  }
+  const int threadCount = std::max( 1, QThreadPool::globalInstance()->maxThreadCount() );
+  const int batchHeight = std::min( stripHeight * threadCount, ySize );
 
-  float *resultLine = ( float * ) CPLMalloc( sizeof( float ) * xSize );
+  //input rows have one more row above and below the batch and one nodata column on each side
+  std::vector< float > input( static_cast< size_t >( batchHeight + 2 ) * paddedWidth );
+  std::vector< float > output[2];
+  output[0].resize( static_cast< size_t >( batchHeight ) * xSize );
+  output[1].resize( static_cast< size_t >( batchHeight ) * xSize );
 
-  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
-  for ( int i = 0; i < ySize; ++i )
+  //results are written by a dedicated thread while the next batch is computed
+  QThreadPool writerPool;
+  writerPool.setMaxThreadCount( 1 );
+
+  int batch = 0;
+  for ( int firstRow = 0; firstRow < ySize; firstRow += batchHeight, ++batch )
   {
     if ( feedback && feedback->isCanceled() )
     {
@@ -113,74 +218,25 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
 
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / ySize );
+      feedback->setProgress( 100.0 * static_cast< double >( firstRow ) / ySize );
     }
 
-    if ( i == 0 )
-    {
-      //fill scanline 1 with (input) nodata for the values above the first row and feed scanline2 with the first row
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine1[a] = mInputNodataValue;
-      }
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, 0, xSize, 1, scanLine2, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
-    }
-    else
-    {
-      //normally fetch only scanLine3 and release scanline 1 if we move forward one row
-      CPLFree( scanLine1 );
-      scanLine1 = scanLine2;
-      scanLine2 = scanLine3;
-      scanLine3 = ( float * ) CPLMalloc( sizeof( float ) * xSize );
-    }
+    int rowCount = std::min( batchHeight, ySize - firstRow );
+    readRows( rasterBand, input.data(), xSize, ySize, firstRow, rowCount );
 
-    if ( i == ySize - 1 ) //fill the row below the bottom with nodata values
+    QVector< int > strips;
+    for ( int strip = 0; strip * stripHeight < rowCount; ++strip )
     {
-      for ( int a = 0; a < xSize; ++a )
-      {
-        scanLine3[a] = mInputNodataValue;
-      }
-    }
-    else
-    {
-      if ( GDALRasterIO( rasterBand, GF_Read, 0, i + 1, xSize, 1, scanLine3, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-      {
-        QgsDebugMsg( "Raster IO Error" );
-      }
+      strips << strip;
     }
+    float *result = output[ batch % 2 ].data();
+    QtConcurrent::blockingMap( strips, ProcessStrip( this, input.data(), result, xSize, stripHeight, rowCount, feedback ) );
 
-    for ( int j = 0; j < xSize; ++j )
-    {
-      if ( j == 0 )
-      {
-        resultLine[j] = processNineCellWindow( &mInputNodataValue, &scanLine1[j], &scanLine1[j + 1], &mInputNodataValue, &scanLine2[j],
-                                               &scanLine2[j + 1], &mInputNodataValue, &scanLine3[j], &scanLine3[j + 1] );
-      }
-      else if ( j == xSize - 1 )
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &mInputNodataValue, &scanLine2[j - 1], &scanLine2[j],
-                                               &mInputNodataValue, &scanLine3[j - 1], &scanLine3[j], &mInputNodataValue );
-      }
-      else
-      {
-        resultLine[j] = processNineCellWindow( &scanLine1[j - 1], &scanLine1[j], &scanLine1[j + 1], &scanLine2[j - 1], &scanLine2[j],
-                                               &scanLine2[j + 1], &scanLine3[j - 1], &scanLine3[j], &scanLine3[j + 1] );
-      }
-    }
-
-    if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, xSize, 1, resultLine, xSize, 1, GDT_Float32, 0, 0 ) != CE_None )
-    {
-      QgsDebugMsg( "Raster IO Error" );
-    }
+    //the writer is done with the buffer of the batch before the previous one once it starts writing the previous one
+    writerPool.waitForDone();
+    writerPool.start( new WriteRows( outputRasterBand, result, xSize, firstRow, rowCount ) );
   }
-
-  CPLFree( resultLine );
-  CPLFree( scanLine1 );
-  CPLFree( scanLine2 );
-  CPLFree( scanLine3 );
+  writerPool.waitForDone();
 
   GDALClose( inputDataset );
 
@@ -195,6 +251,22 @@ int QgsNineCellFilter::processRaster( QgsFeedback *feedback )
   return 0;
 }
 
+void QgsNineCellFilter::readRows( GDALRasterBandH rasterBand, float *rows, int xSize, int ySize, int firstRow, int rowCount ) const
+{
+  //values outside the layer extent (if the 3x3 window is on the border) are sent to the processing method as (input) nodata values
+  const int paddedWidth = xSize + 2;
+  std::fill( rows, rows + static_cast< size_t >( rowCount + 2 ) * paddedWidth, mInputNodataValue );
+
+  int readFirstRow = std::max( firstRow - 1, 0 );
+  int readRowCount = std::min( firstRow + rowCount, ySize - 1 ) - readFirstRow + 1;
+  float *target = rows + static_cast< size_t >( readFirstRow - firstRow + 1 ) * paddedWidth + 1;
+  if ( GDALRasterIO( rasterBand, GF_Read, 0, readFirstRow, xSize, readRowCount, target, xSize, readRowCount, GDT_Float32,
+                     0, sizeof( float ) * paddedWidth ) != CE_None )
+  {
+    QgsDebugMsg( "Raster IO Error" );
+  }
+}
+
 GDALDatasetH QgsNineCellFilter::openInputFile( int &nCellsX, int &nCellsY )
 {
   GDALDatasetH inputDataset = GDALOpen( mInputFile.toUtf8().constData(), GA_ReadOnly );
@@ -21,13 +21,17 @@
 #include <QString>
 #include "gdal.h"
 #include "qgis_analysis.h"
+#include "qgis_sip.h"
 
 class QgsFeedback;
 
 /** \ingroup analysis
  * Base class for raster analysis methods that work with a 3x3 cell filter and calculate the value of each cell based on
 the cell value and the eight neighbour cells. Common examples are slope and aspect calculation in DEMs. Subclasses only implement
-the method that calculates the new value from the nine values. Everything else (reading file, writing file) is done by this subclass*/
+the method that calculates the new value from the nine values. Everything else (reading file, writing file) is done by this subclass.
+
+Rows are read in batches of strips aligned to the blocks of the input, the strips are computed concurrently
+on the global thread pool and the results are written by a dedicated thread.*/
 
 class ANALYSIS_EXPORT QgsNineCellFilter
 {
@@ -38,8 +42,9 @@ class ANALYSIS_EXPORT QgsNineCellFilter
 
     /** Starts the calculation, reads from mInputFile and stores the result in mOutputFile
       \param feedback feedback object that receives update and that is checked for cancelation.
-      \returns 0 in case of success*/
-    int processRaster( QgsFeedback *feedback = nullptr );
+      \returns 0 in case of success
+      \note the Python GIL is released, as processNineCellWindow() may be called from other threads*/
+    int processRaster( QgsFeedback *feedback = nullptr ) SIP_RELEASEGIL;
 
     double cellSizeX() const { return mCellSizeX; }
     void setCellSizeX( double size ) { mCellSizeX = size; }
@@ -55,7 +60,8 @@ class ANALYSIS_EXPORT QgsNineCellFilter
     void setOutputNodataValue( double value ) { mOutputNodataValue = value; }
 
     /** Calculates output value from nine input values. The input values and the output value can be equal to the
-      nodata value if not present or outside of the border. Must be implemented by subclasses*/
+      nodata value if not present or outside of the border. Must be implemented by subclasses.
+      This is called concurrently from several threads, so implementations must not modify the filter*/
     virtual float processNineCellWindow( float *x11, float *x21, float *x31,
                                          float *x12, float *x22, float *x32,
                                          float *x13, float *x23, float *x33 ) = 0;
@@ -75,6 +81,10 @@ class ANALYSIS_EXPORT QgsNineCellFilter
       \returns the output dataset or nullptr in case of error*/
     GDALDatasetH openOutputFile( GDALDatasetH inputDataset, GDALDriverH outputDriver );
 
+    /** Reads \a rowCount rows from \a firstRow with the row above and the row below into \a rows.
+      Each row is padded with a nodata value on each side, and rows outside of the raster are nodata*/
+    void readRows( GDALRasterBandH rasterBand, float *rows, int xSize, int ySize, int firstRow, int rowCount ) const;
+
   protected:
 
     QString mInputFile;
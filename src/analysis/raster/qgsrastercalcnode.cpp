@@ -16,6 +16,7 @@
 #include "qgsrasterblock.h"
 #include "qgsrastermatrix.h"
 #include <cfloat>
+#include <cmath>
 
 QgsRasterCalcNode::QgsRasterCalcNode()
   : mType( tNumber )
@@ -231,6 +232,118 @@ bool QgsRasterCalcNode::calculate( QMap<QString, QgsRasterBlock * > &rasterData,
   return false;
 }
 
+bool QgsRasterCalcNode::prepareRasterRefs( const QStringList &rasterRefs )
+{
+  switch ( mType )
+  {
+    case tRasterRef:
+      mRasterIndex = rasterRefs.indexOf( mRasterName );
+      return mRasterIndex >= 0;
+    case tMatrix:
+      return false;
+    case tNumber:
+      return true;
+    case tOperator:
+      break;
+  }
+
+  return ( !mLeft || mLeft->prepareRasterRefs( rasterRefs ) ) &&
+         ( !mRight || mRight->prepareRasterRefs( rasterRefs ) );
+}
+
+double QgsRasterCalcNode::calculatePixel( const double *rasterValues, double nodataValue ) const
+{
+  switch ( mType )
+  {
+    case tRasterRef:
+      return rasterValues[ mRasterIndex ];
+    case tNumber:
+      return mNumber;
+    case tMatrix:
+      return nodataValue; // not supported, see prepareRasterRefs()
+    case tOperator:
+      break;
+  }
+
+  //operations with nodata values always generate nodata, like the matrix operations
+  if ( !mLeft )
+  {
+    return nodataValue;
+  }
+  double left = mLeft->calculatePixel( rasterValues, nodataValue );
+  if ( left == nodataValue )
+  {
+    return nodataValue;
+  }
+  double right = 0;
+  if ( mRight )
+  {
+    right = mRight->calculatePixel( rasterValues, nodataValue );
+    if ( right == nodataValue )
+    {
+      return nodataValue;
+    }
+  }
+
+  switch ( mOperator )
+  {
+    case opPLUS:
+      return left + right;
+    case opMINUS:
+      return left - right;
+    case opMUL:
+      return left * right;
+    case opDIV:
+      return right == 0 ? nodataValue : left / right;
+    case opPOW:
+      //no complex numbers
+      if ( ( left == 0 && right < 0 ) || ( left < 0 && ( right - std::floor( right ) ) > 0 ) )
+      {
+        return nodataValue;
+      }
+      return std::pow( left, right );
+    case opEQ:
+      return left == right ? 1.0 : 0.0;
+    case opNE:
+      return left == right ? 0.0 : 1.0;
+    case opGT:
+      return left > right ? 1.0 : 0.0;
+    case opLT:
+      return left < right ? 1.0 : 0.0;
+    case opGE:
+      return left >= right ? 1.0 : 0.0;
+    case opLE:
+      return left <= right ? 1.0 : 0.0;
+    case opAND:
+      return left && right ? 1.0 : 0.0;
+    case opOR:
+      return left || right ? 1.0 : 0.0;
+    case opSQRT:
+      return left < 0 ? nodataValue : std::sqrt( left );
+    case opSIN:
+      return std::sin( left );
+    case opCOS:
+      return std::cos( left );
+    case opTAN:
+      return std::tan( left );
+    case opASIN:
+      return std::asin( left );
+    case opACOS:
+      return std::acos( left );
+    case opATAN:
+      return std::atan( left );
+    case opSIGN:
+      return -left;
+    case opLOG:
+      return left <= 0 ? nodataValue : ::log( left );
+    case opLOG10:
+      return left <= 0 ? nodataValue : ::log10( left );
+    case opNONE:
+      break;
+  }
+  return nodataValue;
+}
+
 QgsRasterCalcNode *QgsRasterCalcNode::parseRasterCalcString( const QString &str, QString &parserErrorMsg )
 {
   extern QgsRasterCalcNode *localParseRasterCalcString( const QString & str, QString & parserErrorMsg );
@@ -23,6 +23,7 @@
 #include "qgis_sip.h"
 #include "qgis.h"
 #include <QString>
+#include <QStringList>
 #include "qgis_analysis.h"
 
 class QgsRasterBlock;
@@ -100,6 +101,26 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
      */
     bool calculate( QMap<QString, QgsRasterBlock * > &rasterData, QgsRasterMatrix &result, int row = -1 ) const SIP_SKIP;
 
+    /** Resolves the raster references of the node and its children to indexes in
+     * \a rasterRefs, which is required before calling calculatePixel().
+     * \returns false if a referenced raster is not in \a rasterRefs or if the node
+     * contains a matrix
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    bool prepareRasterRefs( const QStringList &rasterRefs ) SIP_SKIP;
+
+    /** Calculates the result of raster calculation for a single pixel. Unlike calculate(),
+     * no intermediate matrices are allocated, and the whole node tree is evaluated for
+     * each pixel. The same node may be used concurrently from several threads.
+     * \param rasterValues values of the pixel in the referenced rasters, in the order of the
+     * references passed to prepareRasterRefs(). No data values must be equal to \a nodataValue
+     * \param nodataValue no data value of the input values and of the result
+     * \since QGIS 3.0
+     * \note not available in Python bindings
+     */
+    double calculatePixel( const double *rasterValues, double nodataValue ) const SIP_SKIP;
+
     static QgsRasterCalcNode *parseRasterCalcString( const QString &str, QString &parserErrorMsg ) SIP_FACTORY;
 
   private:
@@ -112,6 +133,8 @@ class ANALYSIS_EXPORT QgsRasterCalcNode
     QgsRasterCalcNode *mRight = nullptr;
     double mNumber;
     QString mRasterName;
+    //! Index of the referenced raster, see prepareRasterRefs()
+    int mRasterIndex = -1;
     QgsRasterMatrix *mMatrix = nullptr;
     Operator mOperator;
 
@@ -25,6 +25,11 @@
 #include "qgsfeedback.h"
 
 #include <QFile>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 #include <cpl_string.h>
 #include <gdalwarper.h>
@@ -56,51 +61,74 @@ QgsRasterCalculator::QgsRasterCalculator( const QString &formulaString, const QS
 {
 }
 
+namespace
+{
+  //! Target size in bytes of the input values of a strip of rows
+  const qint64 STRIP_SIZE = 16 * 1024 * 1024;
+
+  //! Calculates a row of a strip from the input blocks of the strip
+  struct CalculateRow
+  {
+    typedef void result_type;
+
+    CalculateRow( const QgsRasterCalcNode *node, const QVector< QgsRasterBlock * > &inputBlocks, float *result, int nColumns, double nodataValue )
+      : mNode( node )
+      , mInputBlocks( inputBlocks )
+      , mResult( result )
+      , mNumColumns( nColumns )
+      , mNodataValue( nodataValue )
+    {}
+
+    void operator()( int row )
+    {
+      QVector< double > values( mInputBlocks.size() );
+      float *resultRow = mResult + static_cast< qgssize >( row ) * mNumColumns;
+      for ( int j = 0; j < mNumColumns; ++j )
+      {
+        qgssize index = static_cast< qgssize >( row ) * mNumColumns + j;
+        for ( int i = 0; i < mInputBlocks.size(); ++i )
+        {
+          //convert input no data to result no data
+          QgsRasterBlock *block = mInputBlocks.at( i );
+          values[i] = block->isNoData( index ) ? mNodataValue : block->value( index );
+        }
+        resultRow[j] = static_cast< float >( mNode->calculatePixel( values.constData(), mNodataValue ) );
+      }
+    }
+
+    const QgsRasterCalcNode *mNode = nullptr;
+    QVector< QgsRasterBlock * > mInputBlocks;
+    float *mResult = nullptr;
+    int mNumColumns;
+    double mNodataValue;
+  };
+}
+
 int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
 {
   //prepare search string / tree
   QString errorString;
-  QgsRasterCalcNode *calcNode = QgsRasterCalcNode::parseRasterCalcString( mFormulaString, errorString );
+  std::unique_ptr< QgsRasterCalcNode > calcNode( QgsRasterCalcNode::parseRasterCalcString( mFormulaString, errorString ) );
   if ( !calcNode )
   {
     //error
     return static_cast<int>( ParserError );
   }
 
-  QMap< QString, QgsRasterBlock * > inputBlocks;
+  QStringList rasterRefs;
   QVector<QgsRasterCalculatorEntry>::const_iterator it = mRasterEntries.constBegin();
   for ( ; it != mRasterEntries.constEnd(); ++it )
   {
     if ( !it->raster ) // no raster layer in entry
     {
-      delete calcNode;
-      qDeleteAll( inputBlocks );
       return static_cast< int >( InputLayerError );
     }
+    rasterRefs << it->ref;
+  }
 
-    QgsRasterBlock *block = nullptr;
-    // if crs transform needed
-    if ( it->raster->crs() != mOutputCrs )
-    {
-      QgsRasterProjector proj;
-      proj.setCrs( it->raster->crs(), mOutputCrs );
-      proj.setInput( it->raster->dataProvider() );
-      proj.setPrecision( QgsRasterProjector::Exact );
-
-      block = proj.block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    else
-    {
-      block = it->raster->dataProvider()->block( it->bandNumber, mOutputRectangle, mNumOutputColumns, mNumOutputRows );
-    }
-    if ( block->isEmpty() )
-    {
-      delete block;
-      delete calcNode;
-      qDeleteAll( inputBlocks );
-      return static_cast<int>( MemoryError );
-    }
-    inputBlocks.insert( it->ref, block );
+  if ( !calcNode->prepareRasterRefs( rasterRefs ) )
+  {
+    return static_cast< int >( InputLayerError ); // formula references a raster which is not in the entries
   }
 
   //open output dataset for writing
@@ -111,21 +139,28 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
   }
 
   GDALDatasetH outputDataset = openOutputFile( outputDriver );
+  if ( !outputDataset )
+  {
+    return static_cast< int >( CreateOutputError );
+  }
   GDALSetProjection( outputDataset, mOutputCrs.toWkt().toLocal8Bit().data() );
   GDALRasterBandH outputRasterBand = GDALGetRasterBand( outputDataset, 1 );
 
   float outputNodataValue = -FLT_MAX;
   GDALSetRasterNoDataValue( outputRasterBand, outputNodataValue );
 
-  QgsRasterMatrix resultMatrix;
-  resultMatrix.setNodataValue( outputNodataValue );
+  //the output is calculated in strips of rows, so that memory does not depend on the raster size
+  const qint64 rowSize = static_cast< qint64 >( sizeof( double ) ) * mNumOutputColumns * std::max( 1, mRasterEntries.size() );
+  const int stripHeight = static_cast< int >( std::min< qint64 >( mNumOutputRows, std::max< qint64 >( 1, STRIP_SIZE / rowSize ) ) );
+  const double rowHeight = mOutputRectangle.height() / mNumOutputRows;
+  std::vector< float > calcData( static_cast< size_t >( stripHeight ) * mNumOutputColumns );
 
-  //read / write line by line
-  for ( int i = 0; i < mNumOutputRows; ++i )
+  Result result = Success;
+  for ( int firstRow = 0; firstRow < mNumOutputRows; firstRow += stripHeight )
   {
     if ( feedback )
     {
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / mNumOutputRows );
+      feedback->setProgress( 100.0 * static_cast< double >( firstRow ) / mNumOutputRows );
     }
 
     if ( feedback && feedback->isCanceled() )
@@ -133,42 +168,71 @@ int QgsRasterCalculator::processCalculation( QgsFeedback *feedback )
       break;
     }
 
-    if ( calcNode->calculate( inputBlocks, resultMatrix, i ) )
+    int rowCount = std::min( stripHeight, mNumOutputRows - firstRow );
+    QgsRectangle stripExtent( mOutputRectangle.xMinimum(), mOutputRectangle.yMaximum() - ( firstRow + rowCount ) * rowHeight,
+                              mOutputRectangle.xMaximum(), mOutputRectangle.yMaximum() - firstRow * rowHeight );
+
+    //data providers are not thread safe, so the input blocks are read sequentially
+    QVector< QgsRasterBlock * > inputBlocks;
+    for ( it = mRasterEntries.constBegin(); it != mRasterEntries.constEnd(); ++it )
     {
-      bool resultIsNumber = resultMatrix.isNumber();
-      float *calcData = new float[mNumOutputColumns];
+      QgsRasterBlock *block = nullptr;
+      // if crs transform needed
+      if ( it->raster->crs() != mOutputCrs )
+      {
+        QgsRasterProjector proj;
+        proj.setCrs( it->raster->crs(), mOutputCrs );
+        proj.setInput( it->raster->dataProvider() );
+        proj.setPrecision( QgsRasterProjector::Exact );
+
+        block = proj.block( it->bandNumber, stripExtent, mNumOutputColumns, rowCount );
+      }
+      else
+      {
+        block = it->raster->dataProvider()->block( it->bandNumber, stripExtent, mNumOutputColumns, rowCount );
+      }
+      inputBlocks << block;
+      if ( block->isEmpty() )
+      {
+        result = MemoryError;
+        break;
+      }
+    }
 
-      for ( int j = 0; j < mNumOutputColumns; ++j )
+    if ( result == Success )
+    {
+      QVector< int > rows;
+      rows.reserve( rowCount );
+      for ( int i = 0; i < rowCount; ++i )
       {
-        calcData[j] = ( float )( resultIsNumber ? resultMatrix.number() : resultMatrix.data()[j] );
+        rows << i;
       }
+      QtConcurrent::blockingMap( rows, CalculateRow( calcNode.get(), inputBlocks, calcData.data(), mNumOutputColumns, outputNodataValue ) );
 
-      //write scanline to the dataset
-      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, i, mNumOutputColumns, 1, calcData, mNumOutputColumns, 1, GDT_Float32, 0, 0 ) != CE_None )
+      //write strip to the dataset
+      if ( GDALRasterIO( outputRasterBand, GF_Write, 0, firstRow, mNumOutputColumns, rowCount, calcData.data(), mNumOutputColumns, rowCount, GDT_Float32, 0, 0 ) != CE_None )
       {
         QgsDebugMsg( "RasterIO error!" );
       }
-
-      delete[] calcData;
     }
 
+    qDeleteAll( inputBlocks );
+    if ( result != Success )
+    {
+      break;
+    }
   }
 
-  if ( feedback )
+  if ( feedback && !feedback->isCanceled() && result == Success )
   {
     feedback->setProgress( 100.0 );
   }
 
-  //close datasets and release memory
-  delete calcNode;
-  qDeleteAll( inputBlocks );
-  inputBlocks.clear();
-
-  if ( feedback && feedback->isCanceled() )
+  if ( result != Success || ( feedback && feedback->isCanceled() ) )
   {
     //delete the dataset without closing (because it is faster)
     GDALDeleteDataset( outputDriver, mOutputFile.toUtf8().constData() );
-    return static_cast< int >( Canceled );
+    return static_cast< int >( result != Success ? result : Canceled );
   }
   GDALClose( outputDataset );
 
@@ -27,6 +27,59 @@
 #include "qgslogger.h"
 
 #include <QFile>
+#include <QtConcurrentMap>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+//! Maximum number of polygons of a batch
+static const int MAX_BATCH_ZONES = 1024;
+//! Maximum number of raster cells read for a batch of polygons
+static const qgssize MAX_BATCH_CELLS = 16 * 1024 * 1024;
+
+///@cond PRIVATE
+
+struct QgsZonalStatistics::Zone
+{
+  QgsFeatureId id = 0;
+  QgsGeometry geometry;
+  int offsetX = 0;
+  int offsetY = 0;
+  int nCellsX = 0;
+  int nCellsY = 0;
+  //! Raster block of the cells covering the bounding box of the polygon
+  std::shared_ptr< QgsRasterBlock > block;
+  FeatureStats stats;
+};
+
+class QgsZonalStatistics::ZoneStatisticsCalculator
+{
+  public:
+    typedef void result_type;
+
+    ZoneStatisticsCalculator( const QgsZonalStatistics *zonalStatistics, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox )
+      : mZonalStatistics( zonalStatistics )
+      , mCellSizeX( cellSizeX )
+      , mCellSizeY( cellSizeY )
+      , mRasterBBox( rasterBBox )
+    {}
+
+    void operator()( Zone &zone )
+    {
+      mZonalStatistics->statisticsFromMiddlePointTest( zone.geometry, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY,
+          mCellSizeX, mCellSizeY, mRasterBBox, zone.block.get(), zone.stats );
+    }
+
+  private:
+    const QgsZonalStatistics *mZonalStatistics = nullptr;
+    double mCellSizeX;
+    double mCellSizeY;
+    QgsRectangle mRasterBBox;
+};
+
+///@endcond
 
 QgsZonalStatistics::QgsZonalStatistics( QgsVectorLayer *polygonLayer, QgsRasterLayer *rasterLayer, const QString &attributePrefix, int rasterBand, QgsZonalStatistics::Statistics stats )
   : mRasterLayer( rasterLayer )
@@ -212,134 +265,165 @@ int QgsZonalStatistics::calculateStatistics( QgsFeedback *feedback )
   bool statsStoreValueCount = ( mStatistics & QgsZonalStatistics::Minority ) ||
                               ( mStatistics & QgsZonalStatistics::Majority );
 
-  FeatureStats featureStats( statsStoreValues, statsStoreValueCount );
   int featureCounter = 0;
 
+  //the polygons are processed in batches: the raster blocks are read sequentially because the
+  //data provider is not thread safe, then the statistics of the batch are calculated in parallel
+  QList< Zone > zones;
+  qgssize batchCells = 0;
+  bool finished = false;
+
   QgsChangedAttributesMap changeMap;
-  while ( fi.nextFeature( f ) )
+  while ( !finished )
   {
     if ( feedback && feedback->isCanceled() )
     {
       break;
     }
 
-    if ( feedback )
-    {
-      feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
-    }
-
-    if ( !f.hasGeometry() )
+    finished = !fi.nextFeature( f );
+    if ( !finished )
     {
+      if ( feedback )
+      {
+        feedback->setProgress( 100.0 * static_cast< double >( featureCounter ) / featureCount );
+      }
       ++featureCounter;
-      continue;
-    }
-    QgsGeometry featureGeometry = f.geometry();
 
-    QgsRectangle featureRect = featureGeometry.boundingBox().intersect( &rasterBBox );
-    if ( featureRect.isEmpty() )
-    {
-      ++featureCounter;
-      continue;
-    }
+      if ( !f.hasGeometry() )
+      {
+        continue;
+      }
+      QgsGeometry featureGeometry = f.geometry();
 
-    int offsetX, offsetY, nCellsX, nCellsY;
-    if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, offsetX, offsetY, nCellsX, nCellsY ) != 0 )
-    {
-      ++featureCounter;
-      continue;
-    }
+      QgsRectangle featureRect = featureGeometry.boundingBox().intersect( &rasterBBox );
+      if ( featureRect.isEmpty() )
+      {
+        continue;
+      }
 
-    //avoid access to cells outside of the raster (may occur because of rounding)
-    if ( ( offsetX + nCellsX ) > nCellsXProvider )
-    {
-      nCellsX = nCellsXProvider - offsetX;
-    }
-    if ( ( offsetY + nCellsY ) > nCellsYProvider )
-    {
-      nCellsY = nCellsYProvider - offsetY;
-    }
+      Zone zone;
+      zone.id = f.id();
+      zone.geometry = featureGeometry;
+      zone.stats = FeatureStats( statsStoreValues, statsStoreValueCount );
+      if ( cellInfoForBBox( rasterBBox, featureRect, cellsizeX, cellsizeY, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY ) != 0 )
+      {
+        continue;
+      }
 
-    statisticsFromMiddlePointTest( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                   rasterBBox, featureStats );
+      //avoid access to cells outside of the raster (may occur because of rounding)
+      if ( ( zone.offsetX + zone.nCellsX ) > nCellsXProvider )
+      {
+        zone.nCellsX = nCellsXProvider - zone.offsetX;
+      }
+      if ( ( zone.offsetY + zone.nCellsY ) > nCellsYProvider )
+      {
+        zone.nCellsY = nCellsYProvider - zone.offsetY;
+      }
 
-    if ( featureStats.count <= 1 )
-    {
-      //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
-      statisticsFromPreciseIntersection( featureGeometry, offsetX, offsetY, nCellsX, nCellsY, cellsizeX, cellsizeY,
-                                         rasterBBox, featureStats );
+      zone.block.reset( mRasterProvider->block( mRasterBand, featureRect, zone.nCellsX, zone.nCellsY ) );
+      batchCells += static_cast< qgssize >( zone.nCellsX ) * zone.nCellsY;
+      zones << zone;
+
+      if ( zones.size() < MAX_BATCH_ZONES && batchCells < MAX_BATCH_CELLS )
+      {
+        continue;
+      }
     }
 
-    //write the statistics value to the vector data provider
-    QgsAttributeMap changeAttributeMap;
-    if ( mStatistics & QgsZonalStatistics::Count )
-      changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
-    if ( mStatistics & QgsZonalStatistics::Sum )
-      changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
-    if ( featureStats.count > 0 )
+    //calculate the statistics of the batch
+    QtConcurrent::blockingMap( zones, ZoneStatisticsCalculator( this, cellsizeX, cellsizeY, rasterBBox ) );
+
+    for ( Zone &zone : zones )
     {
-      double mean = featureStats.sum / featureStats.count;
-      if ( mStatistics & QgsZonalStatistics::Mean )
-        changeAttributeMap.insert( meanIndex, QVariant( mean ) );
-      if ( mStatistics & QgsZonalStatistics::Median )
+      FeatureStats &featureStats = zone.stats;
+      if ( featureStats.count <= 1 )
       {
-        std::sort( featureStats.values.begin(), featureStats.values.end() );
-        int size =  featureStats.values.count();
-        bool even = ( size % 2 ) < 1;
-        double medianValue;
-        if ( even )
-        {
-          medianValue = ( featureStats.values.at( size / 2 - 1 ) + featureStats.values.at( size / 2 ) ) / 2;
-        }
-        else //odd
-        {
-          medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
-        }
-        changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
+        //the cell resolution is probably larger than the polygon area. We switch to precise pixel - polygon intersection in this case
+        //(not in the worker threads, as it relies on GEOS)
+        statisticsFromPreciseIntersection( zone.geometry, zone.offsetX, zone.offsetY, zone.nCellsX, zone.nCellsY, cellsizeX, cellsizeY,
+                                           rasterBBox, zone.block.get(), featureStats );
       }
-      if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
+
+      //write the statistics value to the vector data provider
+      QgsAttributeMap changeAttributeMap;
+      if ( mStatistics & QgsZonalStatistics::Count )
+        changeAttributeMap.insert( countIndex, QVariant( featureStats.count ) );
+      if ( mStatistics & QgsZonalStatistics::Sum )
+        changeAttributeMap.insert( sumIndex, QVariant( featureStats.sum ) );
+      if ( featureStats.count > 0 )
       {
-        double sumSquared = 0;
-        for ( int i = 0; i < featureStats.values.count(); ++i )
+        double mean = featureStats.sum / featureStats.count;
+        if ( mStatistics & QgsZonalStatistics::Mean )
+          changeAttributeMap.insert( meanIndex, QVariant( mean ) );
+        if ( mStatistics & QgsZonalStatistics::Median )
         {
-          double diff = featureStats.values.at( i ) - mean;
-          sumSquared += diff * diff;
+          //only the middle values need to be in place
+          int size =  featureStats.values.count();
+          bool even = ( size % 2 ) < 1;
+          double medianValue;
+          if ( even )
+          {
+            std::nth_element( featureStats.values.begin(), featureStats.values.begin() + size / 2, featureStats.values.end() );
+            float lowerValue = *std::max_element( featureStats.values.begin(), featureStats.values.begin() + size / 2 );
+            medianValue = ( lowerValue + featureStats.values.at( size / 2 ) ) / 2;
+          }
+          else //odd
+          {
+            std::nth_element( featureStats.values.begin(), featureStats.values.begin() + ( size + 1 ) / 2 - 1, featureStats.values.end() );
+            medianValue = featureStats.values.at( ( size + 1 ) / 2 - 1 );
+          }
+          changeAttributeMap.insert( medianIndex, QVariant( medianValue ) );
         }
-        double variance = sumSquared / featureStats.values.count();
-        if ( mStatistics & QgsZonalStatistics::StDev )
+        if ( mStatistics & QgsZonalStatistics::StDev || mStatistics & QgsZonalStatistics::Variance )
         {
-          double stdev = std::pow( variance, 0.5 );
-          changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
-        }
-        if ( mStatistics & QgsZonalStatistics::Variance )
-          changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
-      }
-      if ( mStatistics & QgsZonalStatistics::Min )
-        changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Max )
-        changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
-      if ( mStatistics & QgsZonalStatistics::Range )
-        changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
-      if ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority )
-      {
-        QList<int> vals = featureStats.valueCount.values();
-        std::sort( vals.begin(), vals.end() );
-        if ( mStatistics & QgsZonalStatistics::Minority )
-        {
-          float minorityKey = featureStats.valueCount.key( vals.first() );
-          changeAttributeMap.insert( minorityIndex, QVariant( minorityKey ) );
+          double sumSquared = 0;
+          for ( int i = 0; i < featureStats.values.count(); ++i )
+          {
+            double diff = featureStats.values.at( i ) - mean;
+            sumSquared += diff * diff;
+          }
+          double variance = sumSquared / featureStats.values.count();
+          if ( mStatistics & QgsZonalStatistics::StDev )
+          {
+            double stdev = std::pow( variance, 0.5 );
+            changeAttributeMap.insert( stdevIndex, QVariant( stdev ) );
+          }
+          if ( mStatistics & QgsZonalStatistics::Variance )
+            changeAttributeMap.insert( varianceIndex, QVariant( variance ) );
         }
-        if ( mStatistics & QgsZonalStatistics::Majority )
+        if ( mStatistics & QgsZonalStatistics::Min )
+          changeAttributeMap.insert( minIndex, QVariant( featureStats.min ) );
+        if ( mStatistics & QgsZonalStatistics::Max )
+          changeAttributeMap.insert( maxIndex, QVariant( featureStats.max ) );
+        if ( mStatistics & QgsZonalStatistics::Range )
+          changeAttributeMap.insert( rangeIndex, QVariant( featureStats.max - featureStats.min ) );
+        if ( ( mStatistics & QgsZonalStatistics::Minority || mStatistics & QgsZonalStatistics::Majority ) && !featureStats.valueCount.isEmpty() )
         {
-          float majKey = featureStats.valueCount.key( vals.last() );
-          changeAttributeMap.insert( majorityIndex, QVariant( majKey ) );
+          //smallest values first in case of ties
+          QMap< float, int >::const_iterator minorityIt = featureStats.valueCount.constBegin();
+          QMap< float, int >::const_iterator majorityIt = featureStats.valueCount.constBegin();
+          for ( QMap< float, int >::const_iterator it = featureStats.valueCount.constBegin(); it != featureStats.valueCount.constEnd(); ++it )
+          {
+            if ( it.value() < minorityIt.value() )
+              minorityIt = it;
+            if ( it.value() > majorityIt.value() )
+              majorityIt = it;
+          }
+          if ( mStatistics & QgsZonalStatistics::Minority )
+            changeAttributeMap.insert( minorityIndex, QVariant( minorityIt.key() ) );
+          if ( mStatistics & QgsZonalStatistics::Majority )
+            changeAttributeMap.insert( majorityIndex, QVariant( majorityIt.key() ) );
         }
+        if ( mStatistics & QgsZonalStatistics::Variety )
+          changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
       }
-      if ( mStatistics & QgsZonalStatistics::Variety )
-        changeAttributeMap.insert( varietyIndex, QVariant( featureStats.valueCount.count() ) );
+
+      changeMap.insert( zone.id, changeAttributeMap );
     }
 
-    changeMap.insert( f.id(), changeAttributeMap );
-    ++featureCounter;
+    zones.clear();
+    batchCells = 0;
   }
 
   vectorProvider->changeAttributeValues( changeMap );
@@ -387,66 +471,83 @@ int QgsZonalStatistics::cellInfoForBBox( const QgsRectangle &rasterBBox, const Q
 }
 
 void QgsZonalStatistics::statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const QgsRasterBlock *block, FeatureStats &stats ) const
 {
-  double cellCenterX, cellCenterY;
-
-  cellCenterY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
   stats.reset();
-
-  GEOSGeometry *polyGeos = poly.exportToGeos();
-  if ( !polyGeos )
+  if ( !block || block->isEmpty() || nCellsX <= 0 || nCellsY <= 0 )
   {
     return;
   }
 
-  GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
-  const GEOSPreparedGeometry *polyGeosPrepared = GEOSPrepare_r( geosctxt, polyGeos );
-  if ( !polyGeosPrepared )
-  {
-    GEOSGeom_destroy_r( geosctxt, polyGeos );
-    return;
-  }
+  QgsMultiPolygon polygons = poly.isMultipart() ? poly.asMultiPolygon() : QgsMultiPolygon() << poly.asPolygon();
 
-  GEOSCoordSequence *cellCenterCoords = nullptr;
-  GEOSGeometry *currentCellCenter = nullptr;
+  //top left corner of the cells
+  double cellsTop = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY;
+  double cellsLeft = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX;
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
-
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
-  for ( int i = 0; i < nCellsY; ++i )
+  //x coordinates where the ring edges cross the line of the cell centers of each row
+  std::vector< std::vector< double > > crossings( nCellsY );
+  for ( const QgsPolygon &polygon : qgsAsConst( polygons ) )
   {
-    cellCenterX = rasterBBox.xMinimum() + pixelOffsetX * cellSizeX + cellSizeX / 2;
-    for ( int j = 0; j < nCellsX; ++j )
+    for ( const QgsPolyline &ring : polygon )
     {
-      if ( validPixel( block->value( i, j ) ) )
+      for ( int k = 1; k < ring.size(); ++k )
       {
-        GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-        cellCenterCoords = GEOSCoordSeq_create_r( geosctxt, 1, 2 );
-        GEOSCoordSeq_setX_r( geosctxt, cellCenterCoords, 0, cellCenterX );
-        GEOSCoordSeq_setY_r( geosctxt, cellCenterCoords, 0, cellCenterY );
-        currentCellCenter = GEOSGeom_createPoint_r( geosctxt, cellCenterCoords );
-        if ( GEOSPreparedContains_r( geosctxt, polyGeosPrepared, currentCellCenter ) )
+        const QgsPointXY &p1 = ring.at( k - 1 );
+        const QgsPointXY &p2 = ring.at( k );
+        if ( p1.y() == p2.y() )
         {
-          stats.addValue( block->value( i, j ) );
+          continue;
+        }
+
+        //half open range of y, so that vertices shared by two edges are only counted once
+        double yLow = std::min( p1.y(), p2.y() );
+        double yHigh = std::max( p1.y(), p2.y() );
+        int firstRow = static_cast< int >( qBound( 0.0, std::floor( ( cellsTop - yHigh ) / cellSizeY - 0.5 ), nCellsY - 1.0 ) );
+        int lastRow = static_cast< int >( qBound( 0.0, std::floor( ( cellsTop - yLow ) / cellSizeY - 0.5 ) + 1, nCellsY - 1.0 ) );
+        double xPerY = ( p2.x() - p1.x() ) / ( p2.y() - p1.y() );
+        for ( int row = firstRow; row <= lastRow; ++row )
+        {
+          double y = cellsTop - ( row + 0.5 ) * cellSizeY;
+          if ( y < yLow || y >= yHigh )
+          {
+            continue;
+          }
+          crossings[row].push_back( p1.x() + ( y - p1.y() ) * xPerY );
         }
       }
-      cellCenterX += cellSizeX;
     }
-    cellCenterY -= cellSizeY;
   }
 
-  GEOSGeom_destroy_r( geosctxt, currentCellCenter );
-  GEOSPreparedGeom_destroy_r( geosctxt, polyGeosPrepared );
-  GEOSGeom_destroy_r( geosctxt, polyGeos );
-  delete block;
+  //cells with the center between pairs of crossings are inside the polygon (even-odd rule)
+  for ( int row = 0; row < nCellsY; ++row )
+  {
+    std::vector< double > &rowCrossings = crossings[row];
+    std::sort( rowCrossings.begin(), rowCrossings.end() );
+    for ( size_t k = 0; k + 1 < rowCrossings.size(); k += 2 )
+    {
+      int firstColumn = static_cast< int >( qBound( 0.0, std::ceil( ( rowCrossings[k] - cellsLeft ) / cellSizeX - 0.5 ), static_cast< double >( nCellsX ) ) );
+      int endColumn = static_cast< int >( qBound( 0.0, std::ceil( ( rowCrossings[k + 1] - cellsLeft ) / cellSizeX - 0.5 ), static_cast< double >( nCellsX ) ) );
+      for ( int column = firstColumn; column < endColumn; ++column )
+      {
+        double value = block->value( row, column );
+        if ( validPixel( value ) )
+        {
+          stats.addValue( value );
+        }
+      }
+    }
+  }
 }
 
 void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX,
-    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats )
+    int pixelOffsetY, int nCellsX, int nCellsY, double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const QgsRasterBlock *block, FeatureStats &stats ) const
 {
   stats.reset();
+  if ( !block || block->isEmpty() )
+  {
+    return;
+  }
 
   double currentY = rasterBBox.yMaximum() - pixelOffsetY * cellSizeY - cellSizeY / 2;
   QgsGeometry pixelRectGeometry;
@@ -456,10 +557,6 @@ void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &p
   double pixelArea = cellSizeX * cellSizeY;
   double weight = 0;
 
-  QgsRectangle featureBBox = poly.boundingBox().intersect( &rasterBBox );
-  QgsRectangle intersectBBox = rasterBBox.intersect( &featureBBox );
-
-  QgsRasterBlock *block = mRasterProvider->block( mRasterBand, intersectBBox, nCellsX, nCellsY );
   for ( int i = 0; i < nCellsY; ++i )
   {
     double currentX = rasterBBox.xMinimum() + cellSizeX / 2.0 + pixelOffsetX * cellSizeX;
@@ -490,7 +587,6 @@ void QgsZonalStatistics::statisticsFromPreciseIntersection( const QgsGeometry &p
     }
     currentY -= cellSizeY;
   }
-  delete block;
 }
 
 bool QgsZonalStatistics::validPixel( float value ) const
@@ -31,6 +31,7 @@ class QgsGeometry;
 class QgsVectorLayer;
 class QgsRasterLayer;
 class QgsRasterDataProvider;
+class QgsRasterBlock;
 class QgsRectangle;
 class QgsField;
 
@@ -121,13 +122,23 @@ class ANALYSIS_EXPORT QgsZonalStatistics
     int cellInfoForBBox( const QgsRectangle &rasterBBox, const QgsRectangle &featureBBox, double cellSizeX, double cellSizeY,
                          int &offsetX, int &offsetY, int &nCellsX, int &nCellsY ) const;
 
-    //! Returns statistics by considering the pixels where the center point is within the polygon (fast)
+    //! Polygon with the raster block covering its bounding box and its statistics
+    struct Zone;
+
+    //! Functor calculating the statistics of zones in worker threads
+    class ZoneStatisticsCalculator;
+
+    /**
+     * Returns statistics by considering the pixels where the center point is within the polygon (fast).
+     * The polygon is rasterized with scanlines along the rows of cell centers, so this method does not
+     * use GEOS and is safe to call from several threads.
+     */
     void statisticsFromMiddlePointTest( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                        double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+                                        double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const QgsRasterBlock *block, FeatureStats &stats ) const;
 
     //! Returns statistics with precise pixel - polygon intersection test (slow)
     void statisticsFromPreciseIntersection( const QgsGeometry &poly, int pixelOffsetX, int pixelOffsetY, int nCellsX, int nCellsY,
-                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, FeatureStats &stats );
+                                            double cellSizeX, double cellSizeY, const QgsRectangle &rasterBBox, const QgsRasterBlock *block, FeatureStats &stats ) const;
 
     //! Tests whether a pixel's value should be included in the result
     bool validPixel( float value ) const;
@@ -23,6 +23,9 @@
 #include <QColor>
 #include <QPainter>
 
+#include <algorithm>
+#include <vector>
+
 //determined via trial-and-error. Could possibly be optimised, or varied
 //depending on the image size.
 #define BLOCK_THREADS 16
@@ -66,29 +69,29 @@ void QgsImageOperation::runPixelOperationOnWholeImage( QImage &image, PixelOpera
 //rect operations
 
 template <typename RectOperation>
-void QgsImageOperation::runRectOperation( QImage &image, RectOperation &operation )
+void QgsImageOperation::runRectOperation( QImage &image, RectOperation &operation, LineOperationDirection direction )
 {
   //possibly could be tweaked for rect operations
   if ( image.height() * image.width() < 100000 )
   {
     //small image, don't multithread
     //this threshold was determined via testing various images
-    runRectOperationOnWholeImage( image, operation );
+    runRectOperationOnWholeImage( image, operation, direction );
   }
   else
   {
     //large image, multithread operation
-    runBlockOperationInThreads( image, operation, ByRow );
+    runBlockOperationInThreads( image, operation, direction );
   }
 }
 
 template <class RectOperation>
-void QgsImageOperation::runRectOperationOnWholeImage( QImage &image, RectOperation &operation )
+void QgsImageOperation::runRectOperationOnWholeImage( QImage &image, RectOperation &operation, LineOperationDirection direction )
 {
   ImageBlock fullImage;
   fullImage.beginLine = 0;
-  fullImage.endLine = image.height();
-  fullImage.lineLength = image.width();
+  fullImage.endLine = direction == ByRow ? image.height() : image.width();
+  fullImage.lineLength = direction == ByRow ? image.width() : image.height();
   fullImage.image = &image;
 
   operation( fullImage );
@@ -147,30 +150,36 @@ void QgsImageOperation::runLineOperationOnWholeImage( QImage &image, LineOperati
 template <typename BlockOperation>
 void QgsImageOperation::runBlockOperationInThreads( QImage &image, BlockOperation &operation, LineOperationDirection direction )
 {
-  QList< ImageBlock > blocks;
   unsigned int height = image.height();
   unsigned int width = image.width();
 
   unsigned int blockDimension1 = ( direction == QgsImageOperation::ByRow ) ? height : width;
   unsigned int blockDimension2 = ( direction == QgsImageOperation::ByRow ) ? width : height;
 
-  //chunk image up into vertical blocks
+  //process blocks
+  QList< ImageBlock > blocks = lineBlocks( blockDimension1, blockDimension2, &image );
+  QtConcurrent::blockingMap( blocks, operation );
+}
+
+QList< QgsImageOperation::ImageBlock > QgsImageOperation::lineBlocks( unsigned int lineCount, unsigned int lineLength, QImage *image )
+{
+  QList< ImageBlock > blocks;
+
+  //chunk image up into blocks of lines
   blocks.reserve( BLOCK_THREADS );
   unsigned int begin = 0;
-  unsigned int blockLen = blockDimension1 / BLOCK_THREADS;
+  unsigned int blockLen = lineCount / BLOCK_THREADS;
   for ( unsigned int block = 0; block < BLOCK_THREADS; ++block, begin += blockLen )
   {
     ImageBlock newBlock;
     newBlock.beginLine = begin;
     //make sure last block goes to end of image
-    newBlock.endLine = block < ( BLOCK_THREADS - 1 ) ? begin + blockLen : blockDimension1;
-    newBlock.lineLength = blockDimension2;
-    newBlock.image = &image;
+    newBlock.endLine = block < ( BLOCK_THREADS - 1 ) ? begin + blockLen : lineCount;
+    newBlock.lineLength = lineLength;
+    newBlock.image = image;
     blocks << newBlock;
   }
-
-  //process blocks
-  QtConcurrent::blockingMap( blocks, operation );
+  return blocks;
 }
 
 
@@ -381,7 +390,7 @@ void QgsImageOperation::distanceTransform( QImage &image, const DistanceTransfor
   ConvertToArrayPixelOperation convertToArray( image.width(), array, properties.shadeExterior );
   runPixelOperation( image, convertToArray );
 
-  //calculate distance transform (single threaded only)
+  //calculate distance transform
   distanceTransform2d( array, image.width(), image.height() );
 
   double spread;
@@ -478,45 +487,59 @@ double QgsImageOperation::maxValueInDistanceTransformArray( const double *array,
 /* distance transform of 2d function using squared distance */
 void QgsImageOperation::distanceTransform2d( double *im, int width, int height )
 {
-  int maxDimension = std::max( width, height );
-
-  double *f = new double[ maxDimension ];
-  int *v = new int[ maxDimension ];
-  double *z = new double[ maxDimension + 1 ];
-  double *d = new double[ maxDimension ];
-
-  // transform along columns
-  for ( int x = 0; x < width; x++ )
+  // each column, then each row, is transformed independently of the others
+  DistanceTransformLineOperation columnTransform( im, width, ByColumn );
+  DistanceTransformLineOperation rowTransform( im, width, ByRow );
+  if ( height * width < 100000 )
   {
-    for ( int y = 0; y < height; y++ )
-    {
-      f[y] = im[ x + y * width ];
-    }
-    distanceTransform1d( f, height, v, z, d );
-    for ( int y = 0; y < height; y++ )
-    {
-      im[ x + y * width ] = d[y];
-    }
+    //small image, don't multithread
+    ImageBlock columns;
+    columns.beginLine = 0;
+    columns.endLine = width;
+    columns.lineLength = height;
+    columnTransform( columns );
+
+    ImageBlock rows;
+    rows.beginLine = 0;
+    rows.endLine = height;
+    rows.lineLength = width;
+    rowTransform( rows );
+  }
+  else
+  {
+    QList< ImageBlock > columnBlocks = lineBlocks( width, height, nullptr );
+    QtConcurrent::blockingMap( columnBlocks, columnTransform );
+
+    QList< ImageBlock > rowBlocks = lineBlocks( height, width, nullptr );
+    QtConcurrent::blockingMap( rowBlocks, rowTransform );
   }
+}
+
+void QgsImageOperation::DistanceTransformLineOperation::operator()( QgsImageOperation::ImageBlock &block )
+{
+  int n = block.lineLength;
+  if ( n == 0 )
+    return;
 
-  // transform along rows
-  for ( int y = 0; y < height; y++ )
+  std::vector< double > f( n );
+  std::vector< int > v( n );
+  std::vector< double > z( n + 1 );
+  std::vector< double > d( n );
+
+  int step = mDirection == ByRow ? 1 : mWidth;
+  for ( unsigned int line = block.beginLine; line < block.endLine; ++line )
   {
-    for ( int x = 0; x < width; x++ )
+    double *ref = mDirection == ByRow ? mArray + static_cast< size_t >( line ) * mWidth : mArray + line;
+    for ( int i = 0; i < n; ++i )
     {
-      f[x] = im[  x + y * width ];
+      f[i] = ref[ static_cast< size_t >( i ) * step ];
     }
-    distanceTransform1d( f, width, v, z, d );
-    for ( int x = 0; x < width; x++ )
+    distanceTransform1d( f.data(), n, v.data(), z.data(), d.data() );
+    for ( int i = 0; i < n; ++i )
     {
-      im[  x + y * width ] = d[x];
+      ref[ static_cast< size_t >( i ) * step ] = d[i];
     }
   }
-
-  delete [] d;
-  delete [] f;
-  delete [] v;
-  delete [] z;
 }
 
 void QgsImageOperation::ShadeFromArrayOperation::operator()( QRgb &rgb, const int x, const int y )
@@ -579,14 +602,14 @@ void QgsImageOperation::stackBlur( QImage &image, const int radius, const bool a
   if ( alphaOnly )
     i1 = i2 = ( QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3 );
 
-  StackBlurLineOperation topToBottomBlur( alpha, QgsImageOperation::ByColumn, true, i1, i2 );
-  runLineOperation( *pImage, topToBottomBlur );
+  StackBlurColumnsOperation topToBottomBlur( alpha, true, i1, i2 );
+  runRectOperation( *pImage, topToBottomBlur, QgsImageOperation::ByColumn );
 
   StackBlurLineOperation leftToRightBlur( alpha, QgsImageOperation::ByRow, true, i1, i2 );
   runLineOperation( *pImage, leftToRightBlur );
 
-  StackBlurLineOperation bottomToTopBlur( alpha, QgsImageOperation::ByColumn, false, i1, i2 );
-  runLineOperation( *pImage, bottomToTopBlur );
+  StackBlurColumnsOperation bottomToTopBlur( alpha, false, i1, i2 );
+  runRectOperation( *pImage, bottomToTopBlur, QgsImageOperation::ByColumn );
 
   StackBlurLineOperation rightToLeftBlur( alpha, QgsImageOperation::ByRow, false, i1, i2 );
   runLineOperation( *pImage, rightToLeftBlur );
@@ -624,6 +647,62 @@ void QgsImageOperation::StackBlurLineOperation::operator()( QRgb *startRef, cons
   }
 }
 
+void QgsImageOperation::StackBlurColumnsOperation::operator()( QgsImageOperation::ImageBlock &block )
+{
+  // the columns of the block are blurred together, one row after the other,
+  // which reads the image in scanline order instead of one column at a time
+  int height = block.lineLength;
+  if ( height == 0 || block.endLine <= block.beginLine )
+    return;
+
+  int bpl = block.image->bytesPerLine();
+  int first = 4 * block.beginLine;
+  int channels = 4 * ( block.endLine - block.beginLine );
+
+  // running values of the channels of the columns of the block
+  std::vector< int > rgba( channels );
+  int *values = rgba.data();
+
+  unsigned char *p = block.image->scanLine( 0 ) + first;
+  int increment = bpl;
+  if ( !mForwardDirection )
+  {
+    p += ( height - 1 ) * bpl;
+    increment = -increment;
+  }
+
+  for ( int c = 0; c < channels; c += 4 )
+  {
+    for ( int i = mi1; i <= mi2; ++i )
+    {
+      values[c + i] = p[c + i] << 4;
+    }
+  }
+
+  p += increment;
+  for ( int j = 1; j < height; ++j, p += increment )
+  {
+    if ( mi1 == 0 && mi2 == 3 )
+    {
+      // all channels are blurred, the loop runs over a contiguous part of the scanline
+      for ( int c = 0; c < channels; ++c )
+      {
+        p[c] = ( values[c] += ( ( p[c] << 4 ) - values[c] ) * mAlpha / 16 ) >> 4;
+      }
+    }
+    else
+    {
+      for ( int c = 0; c < channels; c += 4 )
+      {
+        for ( int i = mi1; i <= mi2; ++i )
+        {
+          p[c + i] = ( values[c + i] += ( ( p[c + i] << 4 ) - values[c + i] ) * mAlpha / 16 ) >> 4;
+        }
+      }
+    }
+  }
+}
+
 //gaussian blur
 
 QImage *QgsImageOperation::gaussianBlur( QImage &image, const int radius )
@@ -676,85 +755,77 @@ void QgsImageOperation::GaussianBlurOperation::operator()( QgsImageOperation::Im
   int width = block.image->width();
   int height = block.image->height();
   int sourceBpl = block.image->bytesPerLine();
+  int kernelSize = mRadius * 2 + 1;
+
+  // the channels are accumulated for a whole line at once, so that the inner loops
+  // run over contiguous scanlines. The kernel taps are summed in the same order
+  // for each pixel as a per pixel loop would.
+  std::vector< double > accumulator( 4 * width );
+  double *acc = accumulator.data();
+  int lineChannels = 4 * width;
 
   unsigned char *outputLineRef = mDestImage->scanLine( block.beginLine );
-  QRgb *destRef = nullptr;
   if ( mDirection == ByRow )
   {
-    unsigned char *sourceFirstLine = block.image->scanLine( 0 );
-    unsigned char *sourceRef;
-
-    //blur along rows
+    //blur vertically, one destination row after the other
     for ( unsigned int y = block.beginLine; y < block.endLine; ++y, outputLineRef += mDestImageBpl )
     {
-      sourceRef = sourceFirstLine;
-      destRef = reinterpret_cast< QRgb * >( outputLineRef );
-      for ( int x = 0; x < width; ++x, ++destRef, sourceRef += 4 )
+      std::fill( accumulator.begin(), accumulator.end(), 0.0 );
+      for ( int i = 0; i < kernelSize; ++i )
       {
-        *destRef = gaussianBlurVertical( y, sourceRef, sourceBpl, height );
+        int sourceY = qBound( 0, static_cast< int >( y ) + ( i - mRadius ), height - 1 );
+        const unsigned char *sourceRef = block.image->constScanLine( 0 ) + static_cast< qgssize >( sourceBpl ) * sourceY;
+        double k = mKernel[i];
+        for ( int c = 0; c < lineChannels; ++c )
+        {
+          acc[c] += k * sourceRef[c];
+        }
       }
+      storeLine( acc, outputLineRef, lineChannels );
     }
   }
   else
   {
-    unsigned char *sourceRef = block.image->scanLine( block.beginLine );
+    //blur horizontally
+    const unsigned char *sourceRef = block.image->constScanLine( block.beginLine );
     for ( unsigned int y = block.beginLine; y < block.endLine; ++y, outputLineRef += mDestImageBpl, sourceRef += sourceBpl )
     {
-      destRef = reinterpret_cast< QRgb * >( outputLineRef );
-      for ( int x = 0; x < width; ++x, ++destRef )
+      std::fill( accumulator.begin(), accumulator.end(), 0.0 );
+      for ( int i = 0; i < kernelSize; ++i )
       {
-        *destRef = gaussianBlurHorizontal( x, sourceRef, width );
+        int offset = i - mRadius;
+        double k = mKernel[i];
+
+        // pixels whose tap falls inside the line, then pixels clamped to the first and last pixels
+        int begin = qBound( 0, -offset, width );
+        int end = qBound( begin, width - offset, width );
+        for ( int c = 4 * begin; c < 4 * end; ++c )
+        {
+          acc[c] += k * sourceRef[c + 4 * offset];
+        }
+        for ( int x = 0; x < begin; ++x )
+        {
+          for ( int c = 0; c < 4; ++c )
+            acc[4 * x + c] += k * sourceRef[c];
+        }
+        const unsigned char *lastPixel = sourceRef + 4 * ( width - 1 );
+        for ( int x = end; x < width; ++x )
+        {
+          for ( int c = 0; c < 4; ++c )
+            acc[4 * x + c] += k * lastPixel[c];
+        }
       }
+      storeLine( acc, outputLineRef, lineChannels );
     }
   }
 }
 
-inline QRgb QgsImageOperation::GaussianBlurOperation::gaussianBlurVertical( const int posy, unsigned char *sourceFirstLine, const int sourceBpl, const int height )
-{
-  double r = 0;
-  double b = 0;
-  double g = 0;
-  double a = 0;
-  int y;
-  unsigned char *ref;
-
-  for ( int i = 0; i <= mRadius * 2; ++i )
-  {
-    y = qBound( 0, posy + ( i - mRadius ), height - 1 );
-    ref = sourceFirstLine + sourceBpl * y;
-
-    QRgb *refRgb = reinterpret_cast< QRgb * >( ref );
-    r += mKernel[i] * qRed( *refRgb );
-    g += mKernel[i] * qGreen( *refRgb );
-    b += mKernel[i] * qBlue( *refRgb );
-    a += mKernel[i] * qAlpha( *refRgb );
-  }
-
-  return qRgba( r, g, b, a );
-}
-
-inline QRgb QgsImageOperation::GaussianBlurOperation::gaussianBlurHorizontal( const int posx, unsigned char *sourceFirstLine, const int width )
+inline void QgsImageOperation::GaussianBlurOperation::storeLine( const double *accumulator, unsigned char *destRef, const int channels )
 {
-  double r = 0;
-  double b = 0;
-  double g = 0;
-  double a = 0;
-  int x;
-  unsigned char *ref;
-
-  for ( int i = 0; i <= mRadius * 2; ++i )
+  for ( int c = 0; c < channels; ++c )
   {
-    x = qBound( 0, posx + ( i - mRadius ), width - 1 );
-    ref = sourceFirstLine + x * 4;
-
-    QRgb *refRgb = reinterpret_cast< QRgb * >( ref );
-    r += mKernel[i] * qRed( *refRgb );
-    g += mKernel[i] * qGreen( *refRgb );
-    b += mKernel[i] * qBlue( *refRgb );
-    a += mKernel[i] * qAlpha( *refRgb );
+    destRef[c] = static_cast< unsigned char >( static_cast< int >( accumulator[c] ) & 0xff );
   }
-
-  return qRgba( r, g, b, a );
 }
 
 
@@ -205,9 +205,12 @@ class CORE_EXPORT QgsImageOperation
       QImage *image = nullptr;
     };
 
+    //! Splits \a lineCount lines of \a lineLength pixels into blocks for the threads
+    static QList< ImageBlock > lineBlocks( unsigned int lineCount, unsigned int lineLength, QImage *image );
+
     //for rect operations
-    template <typename RectOperation> static void runRectOperation( QImage &image, RectOperation &operation );
-    template <class RectOperation> static void runRectOperationOnWholeImage( QImage &image, RectOperation &operation );
+    template <typename RectOperation> static void runRectOperation( QImage &image, RectOperation &operation, LineOperationDirection direction = ByRow );
+    template <class RectOperation> static void runRectOperationOnWholeImage( QImage &image, RectOperation &operation, LineOperationDirection direction );
 
     //for per pixel operations
     template <class PixelOperation> static void runPixelOperation( QImage &image, PixelOperation &operation );
@@ -386,6 +389,24 @@ class CORE_EXPORT QgsImageOperation
         double mSpreadSquared;
         const DistanceTransformProperties &mProperties;
     };
+    class DistanceTransformLineOperation
+    {
+      public:
+        DistanceTransformLineOperation( double *array, const int width, LineOperationDirection direction )
+          : mArray( array )
+          , mWidth( width )
+          , mDirection( direction )
+        { }
+
+        typedef void result_type;
+
+        void operator()( ImageBlock &block );
+
+      private:
+        double *mArray = nullptr;
+        int mWidth;
+        LineOperationDirection mDirection;
+    };
     static void distanceTransform2d( double *im, int width, int height );
     static void distanceTransform1d( double *f, int n, int *v, double *z, double *d );
     static double maxValueInDistanceTransformArray( const double *array, const unsigned int size );
@@ -416,6 +437,27 @@ class CORE_EXPORT QgsImageOperation
         int mi2;
     };
 
+    class StackBlurColumnsOperation
+    {
+      public:
+        StackBlurColumnsOperation( int alpha, bool forwardDirection, int i1, int i2 )
+          : mAlpha( alpha )
+          , mForwardDirection( forwardDirection )
+          , mi1( i1 )
+          , mi2( i2 )
+        { }
+
+        typedef void result_type;
+
+        void operator()( ImageBlock &block );
+
+      private:
+        int mAlpha;
+        bool mForwardDirection;
+        int mi1;
+        int mi2;
+    };
+
     static double *createGaussianKernel( const int radius );
 
     class GaussianBlurOperation
@@ -440,8 +482,7 @@ class CORE_EXPORT QgsImageOperation
         int mDestImageBpl;
         double *mKernel = nullptr;
 
-        inline QRgb gaussianBlurVertical( const int posy, unsigned char *sourceFirstLine, const int sourceBpl, const int height );
-        inline QRgb gaussianBlurHorizontal( const int posx, unsigned char *sourceFirstLine, const int width );
+        inline void storeLine( const double *accumulator, unsigned char *destRef, const int channels );
     };
 
     //flip
@@ -17,6 +17,8 @@
 #include "qgsexpressionfunction.h"
 #include "qgsexpressionprivate.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeaturerequest.h"
 #include "qgscolorramp.h"
 #include "qgslogger.h"
@@ -99,6 +101,9 @@ bool QgsExpression::checkExpression( const QString &text, const QgsExpressionCon
 void QgsExpression::setExpression( const QString &expression )
 {
   detach();
+  d->mBytecode.reset();
+  d->mBytecodeFields = QgsFields();
+  d->mBytecodeCompiled = false;
   d->mRootNode = ::parseExpression( expression, d->mParserErrorString );
   d->mEvalErrorString = QString();
   d->mExp = expression;
@@ -336,7 +341,36 @@ bool QgsExpression::prepare( const QgsExpressionContext *context )
     return false;
   }
 
-  return d->mRootNode->prepare( this, context );
+  d->mBytecode.reset();
+  d->mBytecodeCompiled = false;
+  d->mBytecodeFields = QgsFields();
+  if ( !d->mRootNode->prepare( this, context ) )
+    return false;
+
+  if ( context )
+    d->mBytecodeFields = context->fields();
+  return true;
+}
+
+/**
+ * Returns the bytecode for batch evaluation of the prepared tree, lowering it the first time
+ * it is needed so that single feature evaluation does not pay for it. Only field based
+ * expressions benefit from the bytecode, returns nullptr for the others or if the tree can
+ * not be lowered.
+ */
+static QgsExpressionBytecode *preparedBytecode( QgsExpressionPrivate *d )
+{
+  if ( !d->mBytecodeCompiled )
+  {
+    d->mBytecodeCompiled = true;
+    if ( d->mRootNode && !d->mBytecodeFields.isEmpty() )
+    {
+      std::unique_ptr<QgsExpressionBytecode> bytecode( new QgsExpressionBytecode() );
+      if ( bytecode->compile( d->mRootNode, d->mBytecodeFields ) )
+        d->mBytecode = std::move( bytecode );
+    }
+  }
+  return d->mBytecode.get();
 }
 
 QVariant QgsExpression::evaluate()
@@ -363,6 +397,63 @@ QVariant QgsExpression::evaluate( const QgsExpressionContext *context )
   return d->mRootNode->eval( this, context );
 }
 
+QVector<QVariant> QgsExpression::evaluate( const QgsFeatureBatch &batch, QgsExpressionContext *context )
+{
+  d->mEvalErrorString = QString();
+  if ( !d->mRootNode )
+  {
+    d->mEvalErrorString = tr( "No root node! Parsing failed?" );
+    return QVector<QVariant>( batch.count() );
+  }
+
+  QgsExpressionContext localContext;
+  if ( !context )
+    context = &localContext;
+
+  if ( QgsExpressionBytecode *bytecode = preparedBytecode( d ) )
+    return bytecode->evaluate( batch, this, context );
+
+  QVector<QVariant> results( batch.count() );
+  QString errorString;
+  for ( int row = 0; row < batch.count(); ++row )
+  {
+    context->setFeature( batch.feature( row ) );
+    results[row] = d->mRootNode->eval( this, context );
+    if ( hasEvalError() )
+    {
+      errorString = d->mEvalErrorString;
+      d->mEvalErrorString = QString();
+      results[row] = QVariant();
+    }
+  }
+  d->mEvalErrorString = errorString;
+  return results;
+}
+
+QVector<bool> QgsExpression::evaluateFilter( const QgsFeatureBatch &batch, QgsExpressionContext *context )
+{
+  QgsExpressionBytecode *bytecode = d->mRootNode ? preparedBytecode( d ) : nullptr;
+  if ( bytecode )
+  {
+    d->mEvalErrorString = QString();
+    QgsExpressionContext localContext;
+    return bytecode->evaluateFilter( batch, this, context ? context : &localContext );
+  }
+
+  QVector<QVariant> values = evaluate( batch, context );
+  QVector<bool> results( values.count(), false );
+  QString errorString = d->mEvalErrorString;
+  for ( int row = 0; row < values.count(); ++row )
+  {
+    d->mEvalErrorString = QString();
+    results[row] = QgsExpressionUtils::getTVLValue( values.at( row ), this ) == QgsExpressionUtils::True;
+    if ( hasEvalError() )
+      errorString = d->mEvalErrorString;
+  }
+  d->mEvalErrorString = errorString;
+  return results;
+}
+
 bool QgsExpression::hasEvalError() const
 {
   return !d->mEvalErrorString.isNull();
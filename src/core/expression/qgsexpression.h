@@ -41,6 +41,7 @@ class QgsDistanceArea;
 class QDomElement;
 class QgsExpressionContext;
 class QgsExpressionPrivate;
+class QgsFeatureBatch;
 class QgsExpressionNode;
 class QgsExpressionFunction;
 
@@ -220,6 +221,28 @@ class CORE_EXPORT QgsExpression
      */
     QVariant evaluate( const QgsExpressionContext *context );
 
+    /**
+     * Evaluates the expression for all features in a \a batch and returns one result for each of them.
+     *
+     * If prepare() was called with a context providing fields, the expression was lowered into
+     * bytecode which is evaluated over the whole batch at once, leaving only the parts which could
+     * not be lowered (e.g. most function calls) to the node tree. Otherwise the expression is
+     * evaluated feature by feature. The feature of \a context is changed during the evaluation.
+     * \note not available in Python bindings
+     * \see evaluateFilter()
+     * \since QGIS 3.0
+     */
+    QVector<QVariant> evaluate( const QgsFeatureBatch &batch, QgsExpressionContext *context ) SIP_SKIP;
+
+    /**
+     * Evaluates the expression as a filter for all features in a \a batch. Returns for each of them
+     * true if the expression is true for the feature.
+     * \note not available in Python bindings
+     * \see evaluate()
+     * \since QGIS 3.0
+     */
+    QVector<bool> evaluateFilter( const QgsFeatureBatch &batch, QgsExpressionContext *context ) SIP_SKIP;
+
     //! Returns true if an error occurred when evaluating last input
     bool hasEvalError() const;
     //! Returns evaluation error
@@ -0,0 +1,1118 @@
+/***************************************************************************
+                               qgsexpressionbytecode.cpp
+                             -------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsexpressionbytecode.h"
+#include "qgis.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsexpressionutils.h"
+#include "qgsfeaturebatch.h"
+
+#include <cmath>
+
+///@cond PRIVATE
+
+struct QgsExpressionBytecode::EvaluationState
+{
+  //! Values of a register for all features of a batch
+  struct Slot
+  {
+    QVector<double> numbers;
+    //! Exact values of integer registers, their numbers hold the same values as doubles
+    QVector<qint64> ints;
+    //! Null flags, see NullFlag
+    QVector<char> nulls;
+    QVector<char> logic;
+    QVector<QString> strings;
+    QVector<QVariant> variants;
+  };
+
+  int count = 0;
+  const QgsFeatureBatch *batch = nullptr;
+  QgsExpression *parent = nullptr;
+  QgsExpressionContext *context = nullptr;
+  QVector<Slot> values;
+  //! Rows for which the tree interpreter would have reported an evaluation error
+  QVector<char> errors;
+  QString errorString;
+  QVector<QgsFeature> features;
+};
+
+/**
+ * Null flags of register values. Values of string fields which are null are still strings for the
+ * tree interpreter, which concatenates them as empty strings with the + operator, while it returns
+ * null for untyped null values.
+ */
+enum NullFlag
+{
+  NotNull = 0,
+  UntypedNull = 1,
+  StringNull = 2,
+};
+
+///@endcond
+
+/**
+ * Integer arithmetics wrapping around on overflow like the qlonglong operations of the tree
+ * interpreter, without relying on undefined signed overflow.
+ */
+static qint64 addInt( qint64 x, qint64 y )
+{
+  return static_cast< qint64 >( static_cast< quint64 >( x ) + static_cast< quint64 >( y ) );
+}
+
+static qint64 subtractInt( qint64 x, qint64 y )
+{
+  return static_cast< qint64 >( static_cast< quint64 >( x ) - static_cast< quint64 >( y ) );
+}
+
+static qint64 multiplyInt( qint64 x, qint64 y )
+{
+  return static_cast< qint64 >( static_cast< quint64 >( x ) * static_cast< quint64 >( y ) );
+}
+
+static bool staticValue( QgsExpressionNode *node, QVariant &value )
+{
+  if ( node->hasCachedStaticValue() )
+  {
+    value = node->cachedStaticValue();
+    return true;
+  }
+  if ( node->nodeType() == QgsExpressionNode::ntLiteral )
+  {
+    value = static_cast< QgsExpressionNodeLiteral * >( node )->value();
+    return true;
+  }
+  return false;
+}
+
+static bool isIntegerType( QVariant::Type type )
+{
+  return type == QVariant::Int || type == QVariant::UInt || type == QVariant::LongLong || type == QVariant::ULongLong;
+}
+
+static bool compare( QgsExpressionNodeBinaryOperator::BinaryOperator op, double diff )
+{
+  // same as QgsExpressionNodeBinaryOperator::compare()
+  switch ( op )
+  {
+    case QgsExpressionNodeBinaryOperator::boEQ:
+      return qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boNE:
+      return !qgsDoubleNear( diff, 0.0 );
+    case QgsExpressionNodeBinaryOperator::boLT:
+      return diff < 0;
+    case QgsExpressionNodeBinaryOperator::boGT:
+      return diff > 0;
+    case QgsExpressionNodeBinaryOperator::boLE:
+      return diff <= 0;
+    case QgsExpressionNodeBinaryOperator::boGE:
+      return diff >= 0;
+    default:
+      Q_ASSERT( false );
+      return false;
+  }
+}
+
+bool QgsExpressionBytecode::compile( QgsExpressionNode *root, const QgsFields &fields )
+{
+  mFields = fields;
+  mInstructions.clear();
+  mRegisters.clear();
+  mConstants.clear();
+  mResult = -1;
+
+  if ( !root )
+    return false;
+
+  mResult = compileNode( root );
+  return !( mInstructions.count() == 1 && mInstructions.at( 0 ).op == EvalNode );
+}
+
+bool QgsExpressionBytecode::isFullyCompiled() const
+{
+  Q_FOREACH ( const Instruction &instruction, mInstructions )
+  {
+    if ( instruction.op == EvalNode )
+      return false;
+  }
+  return mResult >= 0;
+}
+
+int QgsExpressionBytecode::addInstruction( Instruction instruction, RegisterType type, bool isInteger )
+{
+  Register reg;
+  reg.type = type;
+  reg.isInteger = isInteger;
+  reg.producer = instruction.op;
+  instruction.dest = mRegisters.count();
+  mRegisters << reg;
+  mInstructions << instruction;
+  return instruction.dest;
+}
+
+int QgsExpressionBytecode::loadConstant( const QVariant &value )
+{
+  RegisterType type = Variant;
+  if ( value.isNull() )
+    type = Null;
+  else if ( isIntegerType( value.type() ) || ( value.type() == QVariant::Double && std::isfinite( value.toDouble() ) ) )
+    type = Number;
+  else if ( value.type() == QVariant::String )
+    type = String;
+
+  Instruction instruction;
+  instruction.op = LoadConstant;
+  instruction.constant = mConstants.count();
+  mConstants << value;
+  return addInstruction( instruction, type, isIntegerType( value.type() ) );
+}
+
+int QgsExpressionBytecode::compileNode( QgsExpressionNode *node )
+{
+  int reg = compileTyped( node );
+  if ( reg < 0 )
+    reg = compileFallback( node );
+  return reg;
+}
+
+int QgsExpressionBytecode::compileTyped( QgsExpressionNode *node )
+{
+  int instructionCount = mInstructions.count();
+  int registerCount = mRegisters.count();
+  int constantCount = mConstants.count();
+
+  int reg = -1;
+  QVariant value;
+  if ( staticValue( node, value ) )
+  {
+    reg = loadConstant( value );
+  }
+  else
+  {
+    switch ( node->nodeType() )
+    {
+      case QgsExpressionNode::ntColumnRef:
+      {
+        QString name = static_cast< QgsExpressionNodeColumnRef * >( node )->name();
+        int idx = mFields.lookupField( name );
+        if ( idx < 0 )
+          break;
+
+        QVariant::Type fieldType = mFields.at( idx ).type();
+        RegisterType type = Variant;
+        if ( fieldType == QVariant::Double || isIntegerType( fieldType ) )
+          type = Number;
+        else if ( fieldType == QVariant::String )
+          type = String;
+        else
+          break;
+
+        Instruction instruction;
+        instruction.op = LoadField;
+        instruction.fieldName = mFields.at( idx ).name();
+        reg = addInstruction( instruction, type, isIntegerType( fieldType ) );
+        break;
+      }
+
+      case QgsExpressionNode::ntUnaryOperator:
+        reg = compileUnary( static_cast< QgsExpressionNodeUnaryOperator * >( node ) );
+        break;
+
+      case QgsExpressionNode::ntBinaryOperator:
+        reg = compileBinary( static_cast< QgsExpressionNodeBinaryOperator * >( node ) );
+        break;
+
+      case QgsExpressionNode::ntInOperator:
+        reg = compileIn( static_cast< QgsExpressionNodeInOperator * >( node ) );
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  if ( reg < 0 )
+  {
+    // drop anything emitted for the operands
+    mInstructions.resize( instructionCount );
+    mRegisters.resize( registerCount );
+    mConstants.resize( constantCount );
+  }
+  return reg;
+}
+
+int QgsExpressionBytecode::compileUnary( QgsExpressionNodeUnaryOperator *node )
+{
+  Instruction instruction;
+  switch ( node->op() )
+  {
+    case QgsExpressionNodeUnaryOperator::uoNot:
+      instruction.op = Not;
+      instruction.a = toLogic( compileNode( node->operand() ) );
+      return addInstruction( instruction, Logic );
+
+    case QgsExpressionNodeUnaryOperator::uoMinus:
+    {
+      int reg = compileTyped( node->operand() );
+      if ( reg < 0 || mRegisters.at( reg ).type != Number )
+        return -1;
+
+      instruction.op = Negate;
+      instruction.a = reg;
+      return addInstruction( instruction, Number, mRegisters.at( reg ).isInteger );
+    }
+  }
+  return -1;
+}
+
+int QgsExpressionBytecode::compileBinary( QgsExpressionNodeBinaryOperator *node )
+{
+  typedef QgsExpressionNodeBinaryOperator Op;
+
+  Instruction instruction;
+  instruction.binaryOp = node->op();
+
+  switch ( node->op() )
+  {
+    case Op::boAnd:
+    case Op::boOr:
+      instruction.op = node->op() == Op::boAnd ? And : Or;
+      instruction.a = toLogic( compileNode( node->opLeft() ) );
+      instruction.b = toLogic( compileNode( node->opRight() ) );
+      return addInstruction( instruction, Logic );
+
+    case Op::boIs:
+    case Op::boIsNot:
+    {
+      // null checks do not depend on the type of the values, anything goes
+      int left = compileNode( node->opLeft() );
+      int right = compileNode( node->opRight() );
+      RegisterType leftType = mRegisters.at( left ).type;
+      RegisterType rightType = mRegisters.at( right ).type;
+
+      if ( leftType == Null || rightType == Null )
+      {
+        instruction.op = node->op() == Op::boIs ? IsNull : IsNotNull;
+        instruction.a = leftType == Null ? right : left;
+        return addInstruction( instruction, Logic );
+      }
+      instruction.a = left;
+      instruction.b = right;
+      if ( leftType == Number && rightType == Number )
+        instruction.op = IsNumbers;
+      else if ( leftType == String && rightType == String )
+        instruction.op = IsStrings;
+      else
+        return -1;
+      return addInstruction( instruction, Logic );
+    }
+
+    case Op::boEQ:
+    case Op::boNE:
+    case Op::boLE:
+    case Op::boGE:
+    case Op::boLT:
+    case Op::boGT:
+    case Op::boPlus:
+    case Op::boMinus:
+    case Op::boMul:
+    case Op::boDiv:
+    case Op::boIntDiv:
+    case Op::boMod:
+    case Op::boPow:
+    case Op::boConcat:
+      break;
+
+    default:
+      // regular expressions and LIKE are left to the tree interpreter
+      return -1;
+  }
+
+  int left = compileTyped( node->opLeft() );
+  if ( left < 0 )
+    return -1;
+  int right = compileTyped( node->opRight() );
+  if ( right < 0 )
+    return -1;
+
+  const Register &leftReg = mRegisters.at( left );
+  const Register &rightReg = mRegisters.at( right );
+  instruction.a = left;
+  instruction.b = right;
+
+  if ( leftReg.type == Null || rightReg.type == Null )
+  {
+    // integer division reports an error for nulls, everything else is null
+    if ( node->op() == Op::boIntDiv )
+      return -1;
+    return leftReg.type == Null ? left : right;
+  }
+
+  switch ( node->op() )
+  {
+    case Op::boEQ:
+    case Op::boNE:
+    case Op::boLE:
+    case Op::boGE:
+    case Op::boLT:
+    case Op::boGT:
+      if ( leftReg.type == Number && rightReg.type == Number )
+        instruction.op = CompareNumbers;
+      else if ( leftReg.type == String && rightReg.type == String )
+        instruction.op = CompareStrings;
+      else
+        return -1;
+      return addInstruction( instruction, Logic );
+
+    case Op::boConcat:
+      if ( leftReg.type != String || rightReg.type != String )
+        return -1;
+      instruction.op = Concat;
+      return addInstruction( instruction, String );
+
+    case Op::boPlus:
+      if ( leftReg.type == String && rightReg.type == String )
+      {
+        instruction.op = AddStrings;
+        return addInstruction( instruction, String );
+      }
+      FALLTHROUGH;
+
+    default:
+    {
+      if ( leftReg.type != Number || rightReg.type != Number )
+        return -1;
+
+      bool integer = false;
+      switch ( node->op() )
+      {
+        case Op::boPlus:
+        case Op::boMinus:
+        case Op::boMul:
+        case Op::boMod:
+          integer = leftReg.isInteger && rightReg.isInteger;
+          break;
+        case Op::boIntDiv:
+          integer = true;
+          break;
+        default:
+          break;
+      }
+      instruction.op = Arithmetic;
+      return addInstruction( instruction, Number, integer );
+    }
+  }
+}
+
+int QgsExpressionBytecode::compileIn( QgsExpressionNodeInOperator *node )
+{
+  if ( node->list()->count() == 0 )
+    return -1;
+
+  int reg = compileTyped( node->node() );
+  if ( reg < 0 )
+    return -1;
+
+  RegisterType type = mRegisters.at( reg ).type;
+  if ( type == Null )
+    return reg;
+  if ( type != Number && type != String )
+    return -1;
+
+  // only lists of constants of the same type as the value
+  QVariantList items;
+  Q_FOREACH ( QgsExpressionNode *item, node->list()->list() )
+  {
+    QVariant value;
+    if ( !staticValue( item, value ) )
+      return -1;
+    if ( !value.isNull() )
+    {
+      if ( type == Number && !( isIntegerType( value.type() ) || value.type() == QVariant::Double ) )
+        return -1;
+      if ( type == String && value.type() != QVariant::String )
+        return -1;
+    }
+    items << value;
+  }
+
+  Instruction instruction;
+  instruction.op = type == Number ? InNumbers : InStrings;
+  instruction.a = reg;
+  instruction.negate = node->isNotIn();
+  instruction.constant = mConstants.count();
+  instruction.constantCount = items.count();
+  mConstants << items.toVector();
+  return addInstruction( instruction, Logic );
+}
+
+int QgsExpressionBytecode::compileFallback( QgsExpressionNode *node )
+{
+  Instruction instruction;
+  instruction.op = EvalNode;
+  instruction.node = node;
+  return addInstruction( instruction, Variant );
+}
+
+int QgsExpressionBytecode::toLogic( int reg )
+{
+  if ( mRegisters.at( reg ).type == Logic )
+    return reg;
+
+  Instruction instruction;
+  instruction.op = ToLogic;
+  instruction.a = reg;
+  return addInstruction( instruction, Logic );
+}
+
+QString QgsExpressionBytecode::dump() const
+{
+  static const char *OP_NAMES[] =
+  {
+    "LoadField", "LoadConstant", "EvalNode", "ToLogic", "Not", "And", "Or", "IsNull", "IsNotNull", "Negate",
+    "Arithmetic", "CompareNumbers", "CompareStrings", "IsNumbers", "IsStrings", "Concat", "AddStrings", "InNumbers", "InStrings"
+  };
+
+  QStringList lines;
+  Q_FOREACH ( const Instruction &instruction, mInstructions )
+  {
+    QString line = QStringLiteral( "r%1 = %2" ).arg( instruction.dest ).arg( OP_NAMES[instruction.op] );
+    switch ( instruction.op )
+    {
+      case LoadField:
+        line += ' ' + QgsExpression::quotedColumnRef( instruction.fieldName );
+        break;
+      case LoadConstant:
+        line += ' ' + QgsExpression::quotedValue( mConstants.at( instruction.constant ) );
+        break;
+      case EvalNode:
+        line += ' ' + instruction.node->dump();
+        break;
+      default:
+        if ( instruction.a >= 0 )
+          line += QStringLiteral( " r%1" ).arg( instruction.a );
+        if ( instruction.b >= 0 )
+          line += QStringLiteral( " r%1" ).arg( instruction.b );
+        break;
+    }
+    lines << line;
+  }
+  return lines.join( '\n' );
+}
+
+QVector<QVariant> QgsExpressionBytecode::evaluate( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context ) const
+{
+  EvaluationState state;
+  run( batch, parent, context, state );
+
+  QVector<QVariant> results( state.count );
+  for ( int row = 0; row < state.count; ++row )
+    results[row] = resultValue( state, row );
+  return results;
+}
+
+QVector<bool> QgsExpressionBytecode::evaluateFilter( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context ) const
+{
+  EvaluationState state;
+  run( batch, parent, context, state );
+
+  QVector<bool> results( state.count, false );
+  if ( mResult < 0 )
+    return results;
+
+  const EvaluationState::Slot &slot = state.values.at( mResult );
+  for ( int row = 0; row < state.count; ++row )
+  {
+    if ( state.errors.at( row ) )
+      continue;
+
+    if ( mRegisters.at( mResult ).type == Logic )
+    {
+      results[row] = slot.logic.at( row ) == QgsExpressionUtils::True;
+    }
+    else
+    {
+      QVariant value = resultValue( state, row );
+      results[row] = QgsExpressionUtils::getTVLValue( value, parent ) == QgsExpressionUtils::True;
+      if ( parent->hasEvalError() )
+      {
+        state.errorString = parent->evalErrorString();
+        parent->setEvalErrorString( QString() );
+        results[row] = false;
+      }
+    }
+  }
+
+  if ( !state.errorString.isEmpty() )
+    parent->setEvalErrorString( state.errorString );
+  return results;
+}
+
+QVariant QgsExpressionBytecode::resultValue( const EvaluationState &state, int row ) const
+{
+  if ( mResult < 0 || state.errors.at( row ) )
+    return QVariant();
+
+  const EvaluationState::Slot &slot = state.values.at( mResult );
+  switch ( mRegisters.at( mResult ).type )
+  {
+    case Null:
+      return QVariant();
+
+    case Number:
+      if ( slot.nulls.at( row ) )
+        return QVariant();
+      if ( mRegisters.at( mResult ).isInteger )
+        return QVariant( static_cast< qlonglong >( slot.ints.at( row ) ) );
+      return QVariant( slot.numbers.at( row ) );
+
+    case Logic:
+      return QgsExpressionUtils::tvl2variant( static_cast< QgsExpressionUtils::TVL >( slot.logic.at( row ) ) );
+
+    case String:
+      if ( slot.nulls.at( row ) == StringNull )
+        return QVariant( QVariant::String );
+      if ( slot.nulls.at( row ) )
+        return QVariant();
+      return QVariant( slot.strings.at( row ) );
+
+    case Variant:
+      return slot.variants.at( row );
+  }
+  return QVariant();
+}
+
+void QgsExpressionBytecode::run( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context, EvaluationState &state ) const
+{
+  state.count = batch.count();
+  state.batch = &batch;
+  state.parent = parent;
+  state.context = context;
+  state.values.resize( mRegisters.count() );
+  state.errors.fill( 0, state.count );
+
+  Q_FOREACH ( const Instruction &instruction, mInstructions )
+  {
+    execute( instruction, state );
+  }
+
+  if ( !state.errorString.isEmpty() )
+    parent->setEvalErrorString( state.errorString );
+}
+
+void QgsExpressionBytecode::execute( const Instruction &instruction, EvaluationState &state ) const
+{
+  typedef QgsExpressionNodeBinaryOperator Op;
+
+  const int n = state.count;
+  EvaluationState::Slot &dest = state.values[instruction.dest];
+  const EvaluationState::Slot *a = instruction.a >= 0 ? &state.values.at( instruction.a ) : nullptr;
+  const EvaluationState::Slot *b = instruction.b >= 0 ? &state.values.at( instruction.b ) : nullptr;
+  const RegisterType destType = mRegisters.at( instruction.dest ).type;
+  const bool integer = mRegisters.at( instruction.dest ).isInteger;
+  const RegisterType typeA = instruction.a >= 0 ? mRegisters.at( instruction.a ).type : Null;
+  char *errors = state.errors.data();
+
+  switch ( destType )
+  {
+    case Number:
+      dest.numbers.resize( n );
+      if ( integer )
+        dest.ints.resize( n );
+      dest.nulls.fill( NotNull, n );
+      break;
+    case String:
+      dest.strings.resize( n );
+      dest.nulls.fill( NotNull, n );
+      break;
+    case Logic:
+      dest.logic.resize( n );
+      break;
+    case Variant:
+      dest.variants.resize( n );
+      break;
+    case Null:
+      break;
+  }
+
+  switch ( instruction.op )
+  {
+    case LoadField:
+    {
+      const QgsFeatureBatch &batch = *state.batch;
+      int column = batch.columnForField( batch.fields().lookupField( instruction.fieldName ) );
+      if ( column < 0 )
+      {
+        // not fetched
+        dest.nulls.fill( UntypedNull, n );
+        break;
+      }
+
+      if ( destType == Number )
+      {
+        const double *doubles = batch.doubleData( column );
+        const qint64 *ints = batch.int64Data( column );
+        for ( int i = 0; i < n; ++i )
+        {
+          dest.nulls[i] = batch.isNull( column, i ) ? UntypedNull : NotNull;
+          if ( integer )
+          {
+            qint64 value = 0;
+            if ( ints )
+              value = ints[i];
+            else if ( doubles )
+              value = static_cast< qint64 >( doubles[i] );
+            else
+            {
+              bool ok = false;
+              value = batch.value( column, i ).toLongLong( &ok );
+              if ( !ok )
+                dest.nulls[i] = UntypedNull;
+            }
+            dest.ints[i] = value;
+            dest.numbers[i] = static_cast< double >( value );
+          }
+          else if ( doubles )
+            dest.numbers[i] = doubles[i];
+          else if ( ints )
+            dest.numbers[i] = static_cast< double >( ints[i] );
+          else
+          {
+            bool ok = false;
+            dest.numbers[i] = batch.value( column, i ).toDouble( &ok );
+            if ( !ok )
+              dest.nulls[i] = UntypedNull;
+          }
+        }
+      }
+      else
+      {
+        bool isString = batch.columnType( column ) == QgsFeatureBatch::String;
+        for ( int i = 0; i < n; ++i )
+        {
+          // null values of string fields are typed
+          dest.nulls[i] = batch.isNull( column, i ) ? StringNull : NotNull;
+          if ( dest.nulls[i] )
+            continue;
+
+          if ( isString )
+          {
+            int length = 0;
+            const char *data = batch.stringData( column, i, length );
+            dest.strings[i] = QString::fromUtf8( data, length );
+          }
+          else
+            dest.strings[i] = batch.value( column, i ).toString();
+        }
+      }
+      break;
+    }
+
+    case LoadConstant:
+    {
+      const QVariant &value = mConstants.at( instruction.constant );
+      switch ( destType )
+      {
+        case Number:
+          dest.numbers.fill( value.toDouble(), n );
+          if ( integer )
+            dest.ints.fill( value.toLongLong(), n );
+          break;
+        case String:
+          dest.strings.fill( value.toString(), n );
+          break;
+        case Variant:
+          dest.variants.fill( value, n );
+          break;
+        case Logic:
+        case Null:
+          break;
+      }
+      break;
+    }
+
+    case EvalNode:
+    {
+      if ( state.features.count() != n )
+      {
+        state.features.resize( n );
+        for ( int i = 0; i < n; ++i )
+          state.features[i] = state.batch->feature( i );
+      }
+
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( errors[i] )
+          continue;
+
+        state.context->setFeature( state.features.at( i ) );
+        dest.variants[i] = instruction.node->eval( state.parent, state.context );
+        if ( state.parent->hasEvalError() )
+        {
+          errors[i] = 1;
+          state.errorString = state.parent->evalErrorString();
+          state.parent->setEvalErrorString( QString() );
+        }
+      }
+      break;
+    }
+
+    case ToLogic:
+    {
+      for ( int i = 0; i < n; ++i )
+      {
+        QgsExpressionUtils::TVL tvl = QgsExpressionUtils::Unknown;
+        switch ( typeA )
+        {
+          case Null:
+            break;
+          case Logic:
+            tvl = static_cast< QgsExpressionUtils::TVL >( a->logic.at( i ) );
+            break;
+          case Number:
+            if ( !a->nulls.at( i ) )
+              tvl = qgsDoubleNear( a->numbers.at( i ), 0.0 ) ? QgsExpressionUtils::False : QgsExpressionUtils::True;
+            break;
+          case String:
+          case Variant:
+          {
+            if ( errors[i] )
+              break;
+
+            QVariant value;
+            if ( typeA == Variant )
+              value = a->variants.at( i );
+            else if ( !a->nulls.at( i ) )
+              value = a->strings.at( i );
+
+            tvl = QgsExpressionUtils::getTVLValue( value, state.parent );
+            if ( state.parent->hasEvalError() )
+            {
+              errors[i] = 1;
+              state.errorString = state.parent->evalErrorString();
+              state.parent->setEvalErrorString( QString() );
+            }
+            break;
+          }
+        }
+        dest.logic[i] = tvl;
+      }
+      break;
+    }
+
+    case Not:
+      for ( int i = 0; i < n; ++i )
+        dest.logic[i] = QgsExpressionUtils::NOT[static_cast< int >( a->logic.at( i ) )];
+      break;
+
+    case And:
+      for ( int i = 0; i < n; ++i )
+        dest.logic[i] = QgsExpressionUtils::AND[static_cast< int >( a->logic.at( i ) )][static_cast< int >( b->logic.at( i ) )];
+      break;
+
+    case Or:
+      for ( int i = 0; i < n; ++i )
+        dest.logic[i] = QgsExpressionUtils::OR[static_cast< int >( a->logic.at( i ) )][static_cast< int >( b->logic.at( i ) )];
+      break;
+
+    case IsNull:
+    case IsNotNull:
+    {
+      const char isNullValue = instruction.op == IsNull ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      const char notNullValue = instruction.op == IsNull ? QgsExpressionUtils::False : QgsExpressionUtils::True;
+      for ( int i = 0; i < n; ++i )
+      {
+        bool isNull = true;
+        switch ( typeA )
+        {
+          case Null:
+            break;
+          case Number:
+          case String:
+            isNull = a->nulls.at( i );
+            break;
+          case Logic:
+            isNull = a->logic.at( i ) == QgsExpressionUtils::Unknown;
+            break;
+          case Variant:
+            isNull = a->variants.at( i ).isNull();
+            break;
+        }
+        dest.logic[i] = isNull ? isNullValue : notNullValue;
+      }
+      break;
+    }
+
+    case Negate:
+      for ( int i = 0; i < n; ++i )
+      {
+        dest.nulls[i] = a->nulls.at( i );
+        if ( integer )
+        {
+          dest.ints[i] = subtractInt( 0, a->ints.at( i ) );
+          dest.numbers[i] = static_cast< double >( dest.ints.at( i ) );
+          continue;
+        }
+        dest.numbers[i] = -a->numbers.at( i );
+        // the tree interpreter refuses non finite values
+        if ( !dest.nulls.at( i ) && !std::isfinite( a->numbers.at( i ) ) )
+          errors[i] = 1;
+      }
+      break;
+
+    case Arithmetic:
+    {
+      const Op::BinaryOperator op = instruction.binaryOp;
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) || b->nulls.at( i ) )
+        {
+          dest.nulls[i] = UntypedNull;
+          continue;
+        }
+
+        if ( integer && op != Op::boIntDiv )
+        {
+          // integer operands, computed with integers as by the tree interpreter
+          const qint64 x = a->ints.at( i );
+          const qint64 y = b->ints.at( i );
+          qint64 result = 0;
+          switch ( op )
+          {
+            case Op::boPlus:
+              result = addInt( x, y );
+              break;
+            case Op::boMinus:
+              result = subtractInt( x, y );
+              break;
+            case Op::boMul:
+              result = multiplyInt( x, y );
+              break;
+            case Op::boMod:
+              if ( y == 0 )
+                dest.nulls[i] = UntypedNull;
+              else
+                result = y == -1 ? 0 : x % y;
+              break;
+            default:
+              Q_ASSERT( false );
+              break;
+          }
+          dest.ints[i] = result;
+          dest.numbers[i] = static_cast< double >( result );
+          continue;
+        }
+
+        const double x = a->numbers.at( i );
+        const double y = b->numbers.at( i );
+        if ( !std::isfinite( x ) || !std::isfinite( y ) )
+        {
+          errors[i] = 1;
+          continue;
+        }
+
+        double result = 0;
+        switch ( op )
+        {
+          case Op::boPlus:
+            result = x + y;
+            break;
+          case Op::boMinus:
+            result = x - y;
+            break;
+          case Op::boMul:
+            result = x * y;
+            break;
+          case Op::boDiv:
+            if ( y == 0. )
+              dest.nulls[i] = UntypedNull;
+            else
+              result = x / y;
+            break;
+          case Op::boMod:
+            if ( y == 0. )
+              dest.nulls[i] = UntypedNull;
+            else
+              result = std::fmod( x, y );
+            break;
+          case Op::boIntDiv:
+            if ( y == 0. )
+              dest.nulls[i] = UntypedNull;
+            else
+              result = std::floor( x / y );
+            break;
+          case Op::boPow:
+            result = std::pow( x, y );
+            break;
+          default:
+            Q_ASSERT( false );
+            break;
+        }
+        if ( integer )
+        {
+          // integer division of doubles
+          dest.ints[i] = static_cast< qint64 >( result );
+          result = static_cast< double >( dest.ints.at( i ) );
+        }
+        dest.numbers[i] = result;
+      }
+      break;
+    }
+
+    case CompareNumbers:
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) || b->nulls.at( i ) )
+        {
+          dest.logic[i] = QgsExpressionUtils::Unknown;
+          continue;
+        }
+
+        const double x = a->numbers.at( i );
+        const double y = b->numbers.at( i );
+        if ( !std::isfinite( x ) || !std::isfinite( y ) )
+          errors[i] = 1;
+        dest.logic[i] = compare( instruction.binaryOp, x - y ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      }
+      break;
+
+    case CompareStrings:
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) || b->nulls.at( i ) )
+          dest.logic[i] = QgsExpressionUtils::Unknown;
+        else
+          dest.logic[i] = compare( instruction.binaryOp, QString::compare( a->strings.at( i ), b->strings.at( i ) ) ) ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      }
+      break;
+
+    case IsNumbers:
+    case IsStrings:
+    {
+      const bool is = instruction.binaryOp == Op::boIs;
+      for ( int i = 0; i < n; ++i )
+      {
+        const bool nullA = a->nulls.at( i );
+        const bool nullB = b->nulls.at( i );
+        bool equal = false;
+        if ( nullA || nullB )
+        {
+          equal = nullA && nullB;
+        }
+        else if ( instruction.op == IsNumbers )
+        {
+          if ( !std::isfinite( a->numbers.at( i ) ) || !std::isfinite( b->numbers.at( i ) ) )
+            errors[i] = 1;
+          equal = qgsDoubleNear( a->numbers.at( i ), b->numbers.at( i ) );
+        }
+        else
+        {
+          equal = QString::compare( a->strings.at( i ), b->strings.at( i ) ) == 0;
+        }
+        dest.logic[i] = equal == is ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+      }
+      break;
+    }
+
+    case Concat:
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) || b->nulls.at( i ) )
+          dest.nulls[i] = UntypedNull;
+        else
+          dest.strings[i] = a->strings.at( i ) + b->strings.at( i );
+      }
+      break;
+
+    case AddStrings:
+      // null strings are treated as empty strings, but untyped nulls make the result null
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) == UntypedNull || b->nulls.at( i ) == UntypedNull )
+          dest.nulls[i] = UntypedNull;
+        else
+          dest.strings[i] = ( a->nulls.at( i ) ? QString() : a->strings.at( i ) ) + ( b->nulls.at( i ) ? QString() : b->strings.at( i ) );
+      }
+      break;
+
+    case InNumbers:
+    case InStrings:
+    {
+      const char found = instruction.negate ? QgsExpressionUtils::False : QgsExpressionUtils::True;
+      const char notFound = instruction.negate ? QgsExpressionUtils::True : QgsExpressionUtils::False;
+
+      // prepare the list once, strings which look like numbers are compared as numbers
+      bool listHasNull = false;
+      bool anyDoubleSafe = false;
+      QVector<double> numbers;
+      QVector<bool> doubleSafe;
+      QStringList strings;
+      for ( int j = 0; j < instruction.constantCount; ++j )
+      {
+        const QVariant &item = mConstants.at( instruction.constant + j );
+        if ( item.isNull() )
+        {
+          listHasNull = true;
+          continue;
+        }
+        bool isDoubleSafe = QgsExpressionUtils::isDoubleSafe( item );
+        anyDoubleSafe = anyDoubleSafe || isDoubleSafe;
+        doubleSafe << isDoubleSafe;
+        numbers << ( isDoubleSafe ? item.toDouble() : 0.0 );
+        strings << item.toString();
+      }
+
+      for ( int i = 0; i < n; ++i )
+      {
+        if ( a->nulls.at( i ) )
+        {
+          dest.logic[i] = QgsExpressionUtils::Unknown;
+          continue;
+        }
+
+        bool match = false;
+        if ( instruction.op == InNumbers )
+        {
+          const double x = a->numbers.at( i );
+          if ( !std::isfinite( x ) )
+            errors[i] = 1;
+          for ( int j = 0; j < numbers.count() && !match; ++j )
+            match = qgsDoubleNear( x, numbers.at( j ) );
+        }
+        else
+        {
+          const QString &s = a->strings.at( i );
+          double x = 0;
+          bool valueDoubleSafe = false;
+          if ( anyDoubleSafe )
+          {
+            valueDoubleSafe = QgsExpressionUtils::isDoubleSafe( s );
+            x = valueDoubleSafe ? s.toDouble() : 0.0;
+          }
+          for ( int j = 0; j < strings.count() && !match; ++j )
+          {
+            if ( valueDoubleSafe && doubleSafe.at( j ) )
+              match = qgsDoubleNear( x, numbers.at( j ) );
+            else
+              match = QString::compare( s, strings.at( j ) ) == 0;
+          }
+        }
+
+        dest.logic[i] = match ? found : ( listHasNull ? QgsExpressionUtils::Unknown : notFound );
+      }
+      break;
+    }
+  }
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+                               qgsexpressionbytecode.h
+                             -------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSEXPRESSIONBYTECODE_H
+#define QGSEXPRESSIONBYTECODE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfields.h"
+#include "qgsexpressionnodeimpl.h"
+
+#include <QVector>
+#include <QVariant>
+
+class QgsExpression;
+class QgsExpressionContext;
+class QgsFeatureBatch;
+
+/** \ingroup core
+ * Register based bytecode program lowered from the node tree of a QgsExpression.
+ *
+ * Every register holds the values of one sub-expression for all features of a
+ * QgsFeatureBatch, in a typed slot (numbers, three valued logic or strings), so
+ * that each instruction runs as a tight loop over the batch instead of a virtual
+ * call and QVariant conversion per node and feature.
+ *
+ * Operators, field references, literals and static sub-expressions are lowered to
+ * bytecode. The largest sub-trees which cannot be lowered (e.g. function calls or
+ * comparisons between values of different types) are kept as instructions which
+ * evaluate the original nodes feature by feature, so results always match
+ * QgsExpression::evaluate().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsExpressionBytecode
+{
+  public:
+
+    //! Storage type of a register
+    enum RegisterType
+    {
+      Null, //!< Always null (NULL literal)
+      Number, //!< Double values
+      Logic, //!< Three valued logic, as QgsExpressionUtils::TVL
+      String, //!< String values
+      Variant, //!< Values which are not statically typed
+    };
+
+    //! Bytecode instructions
+    enum OpCode
+    {
+      LoadField, //!< Load field values of batch column
+      LoadConstant, //!< Load a constant value
+      EvalNode, //!< Evaluate an expression node with the tree interpreter for each feature
+      ToLogic, //!< Convert any register to three valued logic
+      Not, //!< Logical NOT
+      And, //!< Logical AND
+      Or, //!< Logical OR
+      IsNull, //!< IS NULL test
+      IsNotNull, //!< IS NOT NULL test
+      Negate, //!< Unary minus
+      Arithmetic, //!< Binary arithmetic operator of numbers
+      CompareNumbers, //!< Comparison of numbers
+      CompareStrings, //!< Comparison of strings
+      IsNumbers, //!< IS / IS NOT comparison of numbers
+      IsStrings, //!< IS / IS NOT comparison of strings
+      Concat, //!< String concatenation with || operator
+      AddStrings, //!< String concatenation with + operator
+      InNumbers, //!< IN / NOT IN with a list of numbers
+      InStrings, //!< IN / NOT IN with a list of strings
+    };
+
+    //! A single instruction of the program
+    struct Instruction
+    {
+      OpCode op = LoadConstant;
+      //! Destination register
+      int dest = -1;
+      //! First operand register
+      int a = -1;
+      //! Second operand register
+      int b = -1;
+      //! Binary operator for Arithmetic, Compare*, Is* instructions
+      QgsExpressionNodeBinaryOperator::BinaryOperator binaryOp = QgsExpressionNodeBinaryOperator::boEQ;
+      //! Field name for LoadField
+      QString fieldName;
+      //! Index of the constant for LoadConstant or of the first list item for In* instructions
+      int constant = -1;
+      //! Number of list items for In* instructions
+      int constantCount = 0;
+      //! True for NOT IN
+      bool negate = false;
+      //! Node evaluated by EvalNode
+      QgsExpressionNode *node = nullptr;
+    };
+
+    /**
+     * Lowers the tree of a prepared expression starting at \a root. Field references
+     * are typed using \a fields. Returns false if nothing could be lowered, i.e. the whole
+     * expression would be evaluated by the tree interpreter anyway.
+     * The nodes must outlive the program.
+     */
+    bool compile( QgsExpressionNode *root, const QgsFields &fields );
+
+    //! Returns true if the program does not need the tree interpreter for any part of the expression
+    bool isFullyCompiled() const;
+
+    //! Returns the instructions of the program
+    QVector<Instruction> instructions() const { return mInstructions; }
+
+    //! Returns a readable listing of the program, useful for debugging
+    QString dump() const;
+
+    /**
+     * Evaluates the program for all features in \a batch and returns one value for each of them.
+     * The \a context is used by the nodes evaluated by the tree interpreter, its feature is
+     * changed during the evaluation. Evaluation errors are reported to \a parent.
+     */
+    QVector<QVariant> evaluate( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context ) const;
+
+    /**
+     * Evaluates the program as a filter for all features in \a batch. Returns for each of them
+     * true if the result of the expression is true.
+     * \see evaluate()
+     */
+    QVector<bool> evaluateFilter( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context ) const;
+
+  private:
+
+    struct Register
+    {
+      RegisterType type = Null;
+      //! Numbers resulting from integer arithmetics are reported as integers
+      bool isInteger = false;
+      //! Instruction which writes the register
+      OpCode producer = LoadConstant;
+    };
+
+    struct EvaluationState;
+
+    int addInstruction( Instruction instruction, RegisterType type, bool isInteger = false );
+    int loadConstant( const QVariant &value );
+    int compileNode( QgsExpressionNode *node );
+    int compileTyped( QgsExpressionNode *node );
+    int compileUnary( QgsExpressionNodeUnaryOperator *node );
+    int compileBinary( QgsExpressionNodeBinaryOperator *node );
+    int compileIn( QgsExpressionNodeInOperator *node );
+    int compileFallback( QgsExpressionNode *node );
+    int toLogic( int reg );
+
+    void run( const QgsFeatureBatch &batch, QgsExpression *parent, QgsExpressionContext *context, EvaluationState &state ) const;
+    void execute( const Instruction &instruction, EvaluationState &state ) const;
+    QVariant resultValue( const EvaluationState &state, int row ) const;
+
+    QgsFields mFields;
+    QVector<Instruction> mInstructions;
+    QVector<Register> mRegisters;
+    QVector<QVariant> mConstants;
+    int mResult = -1;
+};
+
+#endif // QGSEXPRESSIONBYTECODE_H
@@ -236,6 +236,21 @@ class CORE_EXPORT QgsExpressionNode SIP_ABSTRACT
      */
     bool prepare( QgsExpression *parent, const QgsExpressionContext *context );
 
+    /**
+     * Returns true if the node was found to be static during prepare() and its
+     * value has been cached.
+     * \see cachedStaticValue()
+     * \since QGIS 3.0
+     */
+    bool hasCachedStaticValue() const { return mHasCachedValue; }
+
+    /**
+     * Returns the value cached by prepare() for a static node.
+     * \see hasCachedStaticValue()
+     * \since QGIS 3.0
+     */
+    QVariant cachedStaticValue() const { return mCachedStaticValue; }
+
 
   protected:
 
@@ -18,6 +18,8 @@ email                : morb at ozemail dot com dot au
 #include <cstdio>
 #include <cmath>
 
+#include <QMutex>
+
 #include "qgis.h"
 #include "qgsgeometry.h"
 #include "qgsgeometryeditutils.h"
@@ -32,6 +34,7 @@ email                : morb at ozemail dot com dot au
 #include "qgsmessagelog.h"
 #include "qgspointxy.h"
 #include "qgsrectangle.h"
+#include "qgswkbgeometryview.h"
 
 #include "qgsvectorlayer.h"
 #include "qgsgeometryvalidator.h"
@@ -46,12 +49,86 @@ email                : morb at ozemail dot com dot au
 #include "qgslinestring.h"
 #include "qgscircle.h"
 
+/**
+ * Owns the geometry of a QgsGeometry. Geometries created from WKB which can be
+ * viewed by QgsWkbGeometryView are kept as WKB, and only parsed when the
+ * geometry is first accessed.
+ */
+class QgsGeometryPointer
+{
+  public:
+
+    QgsGeometryPointer() = default;
+    ~QgsGeometryPointer() { delete mGeometry.load(); }
+
+    //! Returns the geometry, parsing the pending WKB if needed
+    QgsAbstractGeometry *get() const
+    {
+      QgsAbstractGeometry *geometry = mGeometry.loadAcquire();
+      if ( geometry || !mView.isValid() )
+        return geometry;
+
+      // the geometry may be shared by several threads
+      QMutexLocker locker( &mMutex );
+      geometry = mGeometry.load();
+      if ( !geometry )
+      {
+        QgsConstWkbPtr ptr( mView.wkb() );
+        geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+        mGeometry.storeRelease( geometry );
+      }
+      return geometry;
+    }
+
+    operator QgsAbstractGeometry *() const { return get(); }
+    QgsAbstractGeometry *operator->() const { return get(); }
+    QgsAbstractGeometry &operator*() const { return *get(); }
+
+    //! Returns true if there is a geometry, without parsing pending WKB
+    explicit operator bool() const { return mGeometry.load() || mView.isValid(); }
+
+    //! Sets the geometry, without deleting the previous one
+    QgsGeometryPointer &operator=( QgsAbstractGeometry *geometry )
+    {
+      mGeometry.store( geometry );
+      mView = QgsWkbGeometryView();
+      return *this;
+    }
+
+    //! Deletes the geometry and sets a new \a geometry
+    void reset( QgsAbstractGeometry *geometry = nullptr )
+    {
+      delete mGeometry.load();
+      *this = geometry;
+    }
+
+    //! Deletes the geometry and keeps the WKB of \a view, to be parsed when needed
+    void reset( const QgsWkbGeometryView &view )
+    {
+      reset();
+      mView = view;
+    }
+
+    //! Returns the view of the WKB, or nullptr if there is no WKB waiting to be parsed
+    const QgsWkbGeometryView *pendingView() const
+    {
+      return !mGeometry.loadAcquire() && mView.isValid() ? &mView : nullptr;
+    }
+
+  private:
+
+    mutable QAtomicPointer< QgsAbstractGeometry > mGeometry;
+    mutable QMutex mMutex;
+    QgsWkbGeometryView mView;
+
+    Q_DISABLE_COPY( QgsGeometryPointer )
+};
+
 struct QgsGeometryPrivate
 {
-  QgsGeometryPrivate(): ref( 1 ), geometry( nullptr ) {}
-  ~QgsGeometryPrivate() { delete geometry; }
+  QgsGeometryPrivate(): ref( 1 ) {}
   QAtomicInt ref;
-  QgsAbstractGeometry *geometry = nullptr;
+  QgsGeometryPointer geometry;
 };
 
 QgsGeometry::QgsGeometry()
@@ -97,14 +174,22 @@ void QgsGeometry::detach( bool cloneGeom )
   {
     ( void )d->ref.deref();
     QgsAbstractGeometry *cGeom = nullptr;
+    QgsWkbGeometryView view;
 
-    if ( d->geometry && cloneGeom )
+    if ( cloneGeom )
     {
-      cGeom = d->geometry->clone();
+      // WKB which has not been parsed yet is shared rather than cloned
+      if ( const QgsWkbGeometryView *pendingView = d->geometry.pendingView() )
+        view = *pendingView;
+      else if ( d->geometry )
+        cGeom = d->geometry->clone();
     }
 
     d = new QgsGeometryPrivate();
-    d->geometry = cGeom;
+    if ( view.isValid() )
+      d->geometry.reset( view );
+    else
+      d->geometry = cGeom;
   }
 }
 
@@ -121,13 +206,7 @@ void QgsGeometry::setGeometry( QgsAbstractGeometry *geometry )
   }
 
   detach( false );
-  if ( d->geometry )
-  {
-    delete d->geometry;
-    d->geometry = nullptr;
-  }
-
-  d->geometry = geometry;
+  d->geometry.reset( geometry );
 }
 
 bool QgsGeometry::isNull() const
@@ -135,6 +214,11 @@ bool QgsGeometry::isNull() const
   return !d->geometry;
 }
 
+const QgsWkbGeometryView *QgsGeometry::wkbView() const
+{
+  return d->geometry.pendingView();
+}
+
 QgsGeometry QgsGeometry::fromWkt( const QString &wkt )
 {
   std::unique_ptr< QgsAbstractGeometry > geom = QgsGeometryFactory::geomFromWkt( wkt );
@@ -242,14 +326,8 @@ QgsGeometry QgsGeometry::collectGeometry( const QList< QgsGeometry > &geometries
 
 void QgsGeometry::fromWkb( unsigned char *wkb, int length )
 {
-  detach( false );
-
-  if ( d->geometry )
-  {
-    delete d->geometry;
-  }
-  QgsConstWkbPtr ptr( wkb, length );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+  // the WKB is copied, so that it can be kept until it is parsed
+  fromWkb( length > 0 ? QByteArray( reinterpret_cast< const char * >( wkb ), length ) : QByteArray() );
   delete [] wkb;
 }
 
@@ -257,12 +335,17 @@ void QgsGeometry::fromWkb( const QByteArray &wkb )
 {
   detach( false );
 
-  if ( d->geometry )
+  // linear geometries are only parsed when they are accessed, as
+  // rendering them only needs the view of the WKB
+  QgsWkbGeometryView view( wkb );
+  if ( view.isValid() )
   {
-    delete d->geometry;
+    d->geometry.reset( view );
+    return;
   }
+
   QgsConstWkbPtr ptr( wkb );
-  d->geometry = QgsGeometryFactory::geomFromWkb( ptr ).release();
+  d->geometry.reset( QgsGeometryFactory::geomFromWkb( ptr ).release() );
 }
 
 GEOSGeometry *QgsGeometry::exportToGeos( double precision ) const
@@ -282,6 +365,10 @@ QgsWkbTypes::Type QgsGeometry::wkbType() const
   {
     return QgsWkbTypes::Unknown;
   }
+  else if ( const QgsWkbGeometryView *view = d->geometry.pendingView() )
+  {
+    return view->wkbType();
+  }
   else
   {
     return d->geometry->wkbType();
@@ -295,7 +382,7 @@ QgsWkbTypes::GeometryType QgsGeometry::type() const
   {
     return QgsWkbTypes::UnknownGeometry;
   }
-  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( d->geometry->wkbType() ) );
+  return static_cast< QgsWkbTypes::GeometryType >( QgsWkbTypes::geometryType( wkbType() ) );
 }
 
 bool QgsGeometry::isEmpty() const
@@ -305,6 +392,11 @@ bool QgsGeometry::isEmpty() const
     return true;
   }
 
+  if ( const QgsWkbGeometryView *view = d->geometry.pendingView() )
+  {
+    return view->isEmpty();
+  }
+
   return d->geometry->isEmpty();
 }
 
@@ -314,14 +406,13 @@ bool QgsGeometry::isMultipart() const
   {
     return false;
   }
-  return QgsWkbTypes::isMultiType( d->geometry->wkbType() );
+  return QgsWkbTypes::isMultiType( wkbType() );
 }
 
 void QgsGeometry::fromGeos( GEOSGeometry *geos )
 {
   detach( false );
-  delete d->geometry;
-  d->geometry = QgsGeos::fromGeos( geos );
+  d->geometry.reset( QgsGeos::fromGeos( geos ) );
   GEOSGeom_destroy_r( QgsGeos::getGEOSHandler(), geos );
 }
 
@@ -474,15 +565,14 @@ bool QgsGeometry::deleteVertex( int atVertex )
   {
     detach( true );
     //delete geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->removeGeometry( atVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry.get() )->removeGeometry( atVertex );
   }
 
   //if it is a point, set the geometry to nullptr
   if ( QgsWkbTypes::flatType( d->geometry->wkbType() ) == QgsWkbTypes::Point )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = nullptr;
+    d->geometry.reset();
     return true;
   }
 
@@ -509,7 +599,7 @@ bool QgsGeometry::insertVertex( double x, double y, int beforeVertex )
   {
     detach( true );
     //insert geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->insertGeometry( new QgsPoint( x, y ), beforeVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry.get() )->insertGeometry( new QgsPoint( x, y ), beforeVertex );
   }
 
   QgsVertexId id;
@@ -535,7 +625,7 @@ bool QgsGeometry::insertVertex( const QgsPoint &point, int beforeVertex )
   {
     detach( true );
     //insert geometry instead of point
-    return static_cast< QgsGeometryCollection * >( d->geometry )->insertGeometry( new QgsPoint( point ), beforeVertex );
+    return static_cast< QgsGeometryCollection * >( d->geometry.get() )->insertGeometry( new QgsPoint( point ), beforeVertex );
   }
 
   QgsVertexId id;
@@ -870,8 +960,7 @@ QgsGeometry::OperationResult QgsGeometry::reshapeGeometry( const QgsLineString &
   if ( errorCode == QgsGeometryEngine::Success && geom )
   {
     detach( false );
-    delete d->geometry;
-    d->geometry = geom;
+    d->geometry.reset( geom );
     return Success;
   }
 
@@ -915,8 +1004,7 @@ int QgsGeometry::makeDifferenceInPlace( const QgsGeometry &other )
 
   detach( false );
 
-  delete d->geometry;
-  d->geometry = diffGeom;
+  d->geometry.reset( diffGeom );
   return 0;
 }
 
@@ -943,6 +1031,10 @@ QgsGeometry QgsGeometry::makeDifference( const QgsGeometry &other ) const
 
 QgsRectangle QgsGeometry::boundingBox() const
 {
+  if ( const QgsWkbGeometryView *view = d->geometry.pendingView() )
+  {
+    return view->boundingBox();
+  }
   if ( d->geometry )
   {
     return d->geometry->boundingBox();
@@ -1912,12 +2004,12 @@ double QgsGeometry::lineLocatePoint( const QgsGeometry &point ) const
   QgsGeometry segmentized = *this;
   if ( QgsWkbTypes::isCurvedType( wkbType() ) )
   {
-    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry )->segmentize() );
+    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry.get() )->segmentize() );
   }
 
   QgsGeos geos( d->geometry );
   mLastError.clear();
-  return geos.lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry ) ), &mLastError );
+  return geos.lineLocatePoint( *( static_cast< QgsPoint * >( point.d->geometry.get() ) ), &mLastError );
 }
 
 double QgsGeometry::interpolateAngle( double distance ) const
@@ -1929,7 +2021,7 @@ double QgsGeometry::interpolateAngle( double distance ) const
   QgsGeometry segmentized = *this;
   if ( QgsWkbTypes::isCurvedType( wkbType() ) )
   {
-    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry )->segmentize() );
+    segmentized = QgsGeometry( static_cast< QgsCurve * >( d->geometry.get() )->segmentize() );
   }
 
   QgsVertexId previous;
@@ -2084,6 +2176,12 @@ QgsGeometry QgsGeometry::extrude( double x, double y )
 
 QByteArray QgsGeometry::exportToWkb() const
 {
+  // WKB which has not been parsed yet is the same as the one exported from the geometry
+  const QgsWkbGeometryView *view = d->geometry.pendingView();
+  if ( view && view->hasNativeByteOrder() )
+  {
+    return view->wkb().left( view->wkbSize() );
+  }
   return d->geometry ? d->geometry->asWkb() : QByteArray();
 }
 
@@ -2121,31 +2219,19 @@ QPointF QgsGeometry::asQPointF() const
 
 QPolygonF QgsGeometry::asQPolygonF() const
 {
-  QPolygonF result;
-  QgsPolyline polyline;
+  // the points are copied straight from the coordinate arrays of the line string or ring
+  const QgsCurve *curve = nullptr;
   QgsWkbTypes::Type type = wkbType();
   if ( type == QgsWkbTypes::LineString || type == QgsWkbTypes::LineString25D )
   {
-    polyline = asPolyline();
+    curve = static_cast< const QgsCurve * >( d->geometry.get() );
   }
   else if ( type == QgsWkbTypes::Polygon || type == QgsWkbTypes::Polygon25D )
   {
-    QgsPolygon polygon = asPolygon();
-    if ( polygon.size() < 1 )
-      return result;
-    polyline = polygon.at( 0 );
-  }
-  else
-  {
-    return result;
+    curve = static_cast< const QgsCurvePolygon * >( d->geometry.get() )->exteriorRing();
   }
 
-  QgsPolyline::const_iterator lineIt = polyline.constBegin();
-  for ( ; lineIt != polyline.constEnd(); ++lineIt )
-  {
-    result << lineIt->toQPointF();
-  }
-  return result;
+  return curve ? curve->asQPolygonF() : QPolygonF();
 }
 
 bool QgsGeometry::deleteRing( int ringNum, int partNum )
@@ -2671,13 +2757,13 @@ QgsGeometry QgsGeometry::smooth( const unsigned int iterations, const double off
 
     case QgsWkbTypes::LineString:
     {
-      QgsLineString *lineString = static_cast< QgsLineString * >( d->geometry );
+      QgsLineString *lineString = static_cast< QgsLineString * >( d->geometry.get() );
       return QgsGeometry( smoothLine( *lineString, iterations, offset, minimumDistance, maxAngle ) );
     }
 
     case QgsWkbTypes::MultiLineString:
     {
-      QgsMultiLineString *multiLine = static_cast< QgsMultiLineString * >( d->geometry );
+      QgsMultiLineString *multiLine = static_cast< QgsMultiLineString * >( d->geometry.get() );
 
       QgsMultiLineString *resultMultiline = new QgsMultiLineString();
       for ( int i = 0; i < multiLine->numGeometries(); ++i )
@@ -2689,13 +2775,13 @@ QgsGeometry QgsGeometry::smooth( const unsigned int iterations, const double off
 
     case QgsWkbTypes::Polygon:
     {
-      QgsPolygonV2 *poly = static_cast< QgsPolygonV2 * >( d->geometry );
+      QgsPolygonV2 *poly = static_cast< QgsPolygonV2 * >( d->geometry.get() );
       return QgsGeometry( smoothPolygon( *poly, iterations, offset, minimumDistance, maxAngle ) );
     }
 
     case QgsWkbTypes::MultiPolygon:
     {
-      QgsMultiPolygonV2 *multiPoly = static_cast< QgsMultiPolygonV2 * >( d->geometry );
+      QgsMultiPolygonV2 *multiPoly = static_cast< QgsMultiPolygonV2 * >( d->geometry.get() );
 
       QgsMultiPolygonV2 *resultMultiPoly = new QgsMultiPolygonV2();
       for ( int i = 0; i < multiPoly->numGeometries(); ++i )
@@ -3149,6 +3235,11 @@ QgsGeometryEngine *QgsGeometry::createGeometryEngine( const QgsAbstractGeometry
   return new QgsGeos( geometry );
 }
 
+QgsGeometryEngine *QgsGeometry::createGeometryEngine( const QgsGeometry &geometry, const QString &source, QgsFeatureId fid )
+{
+  return QgsGeos::cachedPreparedEngine( geometry, source, fid );
+}
+
 QDataStream &operator<<( QDataStream &out, const QgsGeometry &geometry )
 {
   out << geometry.exportToWkb();
@@ -81,6 +81,7 @@ typedef QVector<QVector<QVector<QgsPointXY>>> QgsMultiPolygon;
 class QgsRectangle;
 
 class QgsConstWkbPtr;
+class QgsWkbGeometryView;
 
 struct QgsGeometryPrivate;
 
@@ -165,6 +166,18 @@ class CORE_EXPORT QgsGeometry
      */
     bool isNull() const;
 
+    /**
+     * Returns a view of the WKB the geometry was created from, as long as the WKB has
+     * not been parsed into the geometry() yet, or nullptr otherwise.
+     *
+     * Geometries created with fromWkb() are only parsed when they are first accessed,
+     * and the view allows rendering them without building the geometry.
+     * \note not available in Python bindings
+     * \see fromWkb()
+     * \since QGIS 3.0
+     */
+    const QgsWkbGeometryView *wkbView() const SIP_SKIP;
+
     //! Creates a new geometry from a WKT string
     static QgsGeometry fromWkt( const QString &wkt );
     //! Creates a new geometry from a QgsPointXY object
@@ -200,6 +213,9 @@ class CORE_EXPORT QgsGeometry
 
     /**
      * Set the geometry, feeding in the buffer containing OGC Well-Known Binary
+     *
+     * Points, line strings and polygons and their multi part types are kept as
+     * WKB, and only parsed when the geometry is first accessed.
      * \since QGIS 3.0
      */
     void fromWkb( const QByteArray &wkb );
@@ -1462,6 +1478,18 @@ class CORE_EXPORT QgsGeometry
      */
     static QgsGeometryEngine *createGeometryEngine( const QgsAbstractGeometry *geometry ) SIP_FACTORY;
 
+    /**
+     * Creates and returns a new geometry engine for \a geometry, the geometry of the feature with
+     * id \a fid from \a source (e.g. a layer id), prepared for repeated predicate queries like
+     * intersects() or contains().
+     *
+     * The prepared geometry is taken from a cache shared with the engines created before for the same
+     * feature, so it is only built again when the geometry of the feature has changed. The \a geometry
+     * must outlive the engine.
+     * \since QGIS 3.0
+     */
+    static QgsGeometryEngine *createGeometryEngine( const QgsGeometry &geometry, const QString &source, QgsFeatureId fid ) SIP_FACTORY;
+
     /**
      * Upgrades a point list from QgsPointXY to QgsPointV2
      * \param input list of QgsPointXY objects to be upgraded
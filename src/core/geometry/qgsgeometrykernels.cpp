@@ -0,0 +1,191 @@
+/***************************************************************************
+  qgsgeometrykernels.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsgeometrykernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+QgsRectangle QgsGeometryKernels::boundingBox( const double *x, const double *y, int count )
+{
+  double xmin = std::numeric_limits<double>::max();
+  double ymin = std::numeric_limits<double>::max();
+  double xmax = -std::numeric_limits<double>::max();
+  double ymax = -std::numeric_limits<double>::max();
+
+  // conditional moves rather than branches, so that the loops map to min/max instructions
+  for ( int i = 0; i < count; ++i )
+  {
+    xmin = x[i] < xmin ? x[i] : xmin;
+    xmax = x[i] > xmax ? x[i] : xmax;
+  }
+  for ( int i = 0; i < count; ++i )
+  {
+    ymin = y[i] < ymin ? y[i] : ymin;
+    ymax = y[i] > ymax ? y[i] : ymax;
+  }
+  return QgsRectangle( xmin, ymin, xmax, ymax );
+}
+
+bool QgsGeometryKernels::allInside( const double *x, const double *y, int count, const QgsRectangle &rect )
+{
+  const double xmin = rect.xMinimum();
+  const double ymin = rect.yMinimum();
+  const double xmax = rect.xMaximum();
+  const double ymax = rect.yMaximum();
+
+  // blocks without early exit, which are vectorized, and a test between blocks
+  const int blockSize = 256;
+  for ( int start = 0; start < count; start += blockSize )
+  {
+    const int end = std::min( start + blockSize, count );
+    int outside = 0;
+    for ( int i = start; i < end; ++i )
+    {
+      // NaN coordinates are outside
+      outside += !( ( x[i] >= xmin ) & ( x[i] <= xmax ) & ( y[i] >= ymin ) & ( y[i] <= ymax ) );
+    }
+    if ( outside > 0 )
+      return false;
+  }
+  return true;
+}
+
+double QgsGeometryKernels::length( const double *x, const double *y, int count )
+{
+  // the segment lengths are summed in order, so that the result does not depend on the vector width
+  double length = 0;
+  for ( int i = 1; i < count; ++i )
+  {
+    const double dx = x[i] - x[i - 1];
+    const double dy = y[i] - y[i - 1];
+    length += std::sqrt( dx * dx + dy * dy );
+  }
+  return length;
+}
+
+void QgsGeometryKernels::transform( double *x, double *y, int count, const QTransform &t )
+{
+  // same formulas as QTransform::map() for each type of matrix
+  const double m11 = t.m11();
+  const double m12 = t.m12();
+  const double m21 = t.m21();
+  const double m22 = t.m22();
+  const double dx = t.dx();
+  const double dy = t.dy();
+
+  switch ( t.type() )
+  {
+    case QTransform::TxNone:
+      return;
+
+    case QTransform::TxTranslate:
+    case QTransform::TxScale:
+      for ( int i = 0; i < count; ++i )
+      {
+        x[i] = m11 * x[i] + dx;
+        y[i] = m22 * y[i] + dy;
+      }
+      return;
+
+    case QTransform::TxRotate:
+    case QTransform::TxShear:
+      for ( int i = 0; i < count; ++i )
+      {
+        const double px = x[i];
+        const double py = y[i];
+        x[i] = m11 * px + m21 * py + dx;
+        y[i] = m12 * px + m22 * py + dy;
+      }
+      return;
+
+    case QTransform::TxProject:
+      break;
+  }
+
+  // projective matrices are rare, and need the clipping of QTransform close to the horizon
+  for ( int i = 0; i < count; ++i )
+  {
+    qreal px, py;
+    t.map( x[i], y[i], &px, &py );
+    x[i] = px;
+    y[i] = py;
+  }
+}
+
+void QgsGeometryKernels::transform( QPolygonF &polygon, const QTransform &t )
+{
+  const int count = polygon.size();
+  if ( count == 0 )
+    return;
+
+  const double m11 = t.m11();
+  const double m12 = t.m12();
+  const double m21 = t.m21();
+  const double m22 = t.m22();
+  const double dx = t.dx();
+  const double dy = t.dy();
+
+  QPointF *points = polygon.data();
+  switch ( t.type() )
+  {
+    case QTransform::TxNone:
+      return;
+
+    case QTransform::TxTranslate:
+    case QTransform::TxScale:
+      for ( int i = 0; i < count; ++i )
+      {
+        points[i].rx() = m11 * points[i].x() + dx;
+        points[i].ry() = m22 * points[i].y() + dy;
+      }
+      return;
+
+    case QTransform::TxRotate:
+    case QTransform::TxShear:
+      for ( int i = 0; i < count; ++i )
+      {
+        const double px = points[i].x();
+        const double py = points[i].y();
+        points[i].rx() = m11 * px + m21 * py + dx;
+        points[i].ry() = m12 * px + m22 * py + dy;
+      }
+      return;
+
+    case QTransform::TxProject:
+      break;
+  }
+
+  for ( int i = 0; i < count; ++i )
+  {
+    points[i] = t.map( points[i] );
+  }
+}
+
+QPolygonF QgsGeometryKernels::toPolygon( const double *x, const double *y, int count )
+{
+  QPolygonF polygon( count );
+  QPointF *points = polygon.data();
+  for ( int i = 0; i < count; ++i )
+  {
+    points[i].rx() = x[i];
+    points[i].ry() = y[i];
+  }
+  return polygon;
+}
+
+///@endcond
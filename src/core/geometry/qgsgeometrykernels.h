@@ -0,0 +1,70 @@
+/***************************************************************************
+  qgsgeometrykernels.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSGEOMETRYKERNELS_H
+#define QGSGEOMETRYKERNELS_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsrectangle.h"
+
+#include <QPolygonF>
+#include <QTransform>
+
+///@cond PRIVATE
+
+/**
+ * \ingroup core
+ * \brief Bulk operations on the coordinate arrays of geometries.
+ *
+ * The kernels work on separate arrays of x and y coordinates, as stored by QgsLineString,
+ * or on the interleaved coordinates of a QPolygonF. They are written as plain loops without
+ * branches depending on the data, which the compiler can vectorize.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsGeometryKernels
+{
+  public:
+
+    /**
+     * Returns the bounding box of \a count points. Points with NaN
+     * coordinates are ignored.
+     */
+    static QgsRectangle boundingBox( const double *x, const double *y, int count );
+
+    /**
+     * Returns true if all of the \a count points are within \a rect,
+     * boundary included. Points with NaN coordinates are never within \a rect.
+     */
+    static bool allInside( const double *x, const double *y, int count, const QgsRectangle &rect );
+
+    //! Returns the length of the line through \a count points
+    static double length( const double *x, const double *y, int count );
+
+    //! Transforms \a count points in place with the matrix \a t
+    static void transform( double *x, double *y, int count, const QTransform &t );
+
+    //! Transforms the points of \a polygon in place with the matrix \a t
+    static void transform( QPolygonF &polygon, const QTransform &t );
+
+    //! Returns a polygon with the \a count points
+    static QPolygonF toPolygon( const double *x, const double *y, int count );
+};
+
+///@endcond
+
+#endif // QGSGEOMETRYKERNELS_H
@@ -25,6 +25,8 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsmultipolygon.h"
 #include "qgslogger.h"
 #include "qgspolygon.h"
+#include <QCache>
+#include <QPair>
 #include <limits>
 #include <cstdio>
 
@@ -101,7 +103,120 @@ class GEOSInit
     GEOSInit &operator=( const GEOSInit &rh );
 };
 
-static GEOSInit geosinit;
+/**
+ * Returns the GEOS context of the current thread. Each thread has its own context, so
+ * that GEOS errors are reported to the thread which caused them and geometry operations
+ * can run in several threads at once.
+ */
+static GEOSInit *geosinit()
+{
+  static thread_local GEOSInit sInit;
+  return &sInit;
+}
+
+//! GEOS geometry and prepared geometry of a feature, shared by the prepared geometry cache and the engines created from it
+class QgsGeosCacheEntry
+{
+  public:
+    QgsGeosCacheEntry( const QgsAbstractGeometry *geometry, uint hash, GEOSGeometry *geos )
+      : geometry( geometry->clone() )
+      , hash( hash )
+      , geos( geos )
+      , prepared( GEOSPrepare_r( geosinit()->ctxt, geos ) )
+    {}
+
+    ~QgsGeosCacheEntry()
+    {
+      GEOSPreparedGeom_destroy_r( geosinit()->ctxt, prepared );
+      GEOSGeom_destroy_r( geosinit()->ctxt, geos );
+    }
+
+    /**
+     * Deep copy of the geometry the entry was created for, compared to find out whether the feature has
+     * changed. A shallow copy would follow the changes made in place through QgsGeometry::geometry().
+     */
+    std::unique_ptr< QgsAbstractGeometry > geometry;
+    //! Hash of the vertices of the geometry, see geometryHash()
+    uint hash = 0;
+    GEOSGeometry *geos = nullptr;
+    const GEOSPreparedGeometry *prepared = nullptr;
+
+  private:
+    QgsGeosCacheEntry( const QgsGeosCacheEntry &rh );
+    QgsGeosCacheEntry &operator=( const QgsGeosCacheEntry &rh );
+};
+
+//! Prepared geometries of features, keyed by source and feature id and costing their number of vertices
+typedef QCache< QPair< QString, QgsFeatureId >, std::shared_ptr< QgsGeosCacheEntry > > QgsGeosPreparedCache;
+
+static QAtomicInt sPreparedCacheSize( 1000000 );
+
+// prepared geometries must not be used by several threads at once, so every thread has its own cache
+static QgsGeosPreparedCache *preparedCache()
+{
+  // the GEOS context must be created first, so that it is destroyed after the cached geometries
+  geosinit();
+
+  static thread_local QgsGeosPreparedCache sCache;
+  QgsGeosPreparedCache *cache = &sCache;
+  int maxCost = sPreparedCacheSize.load();
+  if ( cache->maxCost() != maxCost )
+    cache->setMaxCost( maxCost );
+  return cache;
+}
+
+//! Number of engines which were created from the prepared geometry cache of the current thread
+static thread_local int sPreparedCacheHits = 0;
+
+//! Hashes the type and vertices of a geometry, without exporting it
+static uint geometryHash( const QgsAbstractGeometry *geometry )
+{
+  const QgsWkbTypes::Type type = geometry->wkbType();
+  const bool hasZ = QgsWkbTypes::hasZ( type );
+  const bool hasM = QgsWkbTypes::hasM( type );
+  uint hash = qHash( static_cast< int >( type ) );
+  QgsVertexId id;
+  QgsPoint point;
+  while ( geometry->nextVertex( id, point ) )
+  {
+    hash = 31 * hash + qHash( id.part );
+    hash = 31 * hash + qHash( id.ring );
+    hash = 31 * hash + qHash( point.x() );
+    hash = 31 * hash + qHash( point.y() );
+    if ( hasZ )
+      hash = 31 * hash + qHash( point.z() );
+    if ( hasM )
+      hash = 31 * hash + qHash( point.m() );
+  }
+  return hash;
+}
+
+//! Returns true if both geometries have the same type and exactly the same vertices
+static bool sameVertices( const QgsAbstractGeometry *geometry1, const QgsAbstractGeometry *geometry2 )
+{
+  const QgsWkbTypes::Type type = geometry1->wkbType();
+  if ( geometry2->wkbType() != type )
+    return false;
+
+  const bool hasZ = QgsWkbTypes::hasZ( type );
+  const bool hasM = QgsWkbTypes::hasM( type );
+  QgsVertexId id1, id2;
+  QgsPoint point1, point2;
+  while ( true )
+  {
+    bool hasVertex1 = geometry1->nextVertex( id1, point1 );
+    bool hasVertex2 = geometry2->nextVertex( id2, point2 );
+    if ( hasVertex1 != hasVertex2 )
+      return false;
+    if ( !hasVertex1 )
+      return true;
+    if ( id1.part != id2.part || id1.ring != id2.ring ||
+         point1.x() != point2.x() || point1.y() != point2.y() ||
+         ( hasZ && point1.z() != point2.z() ) ||
+         ( hasM && point1.m() != point2.m() ) )
+      return false;
+  }
+}
 
 ///@endcond
 
@@ -114,12 +229,12 @@ class GEOSGeomScopedPtr
 {
   public:
     explicit GEOSGeomScopedPtr( GEOSGeometry *geom = nullptr ) : mGeom( geom ) {}
-    ~GEOSGeomScopedPtr() { GEOSGeom_destroy_r( geosinit.ctxt, mGeom ); }
+    ~GEOSGeomScopedPtr() { GEOSGeom_destroy_r( geosinit()->ctxt, mGeom ); }
     GEOSGeometry *get() const { return mGeom; }
     operator bool() const { return nullptr != mGeom; }
     void reset( GEOSGeometry *geom )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, mGeom );
+      GEOSGeom_destroy_r( geosinit()->ctxt, mGeom );
       mGeom = geom;
     }
 
@@ -140,30 +255,56 @@ QgsGeos::QgsGeos( const QgsAbstractGeometry *geometry, double precision )
   cacheGeos();
 }
 
+QgsGeos::QgsGeos( const QgsAbstractGeometry *geometry, const std::shared_ptr< QgsGeosCacheEntry > &cacheEntry )
+  : QgsGeometryEngine( geometry )
+  , mGeos( cacheEntry->geos )
+  , mGeosPrepared( cacheEntry->prepared )
+  , mPrecision( 0 )
+  , mCacheEntry( cacheEntry )
+{
+}
+
 QgsGeos::~QgsGeos()
 {
-  GEOSGeom_destroy_r( geosinit.ctxt, mGeos );
+  if ( !mCacheEntry )
+  {
+    GEOSGeom_destroy_r( geosinit()->ctxt, mGeos );
+    GEOSPreparedGeom_destroy_r( geosinit()->ctxt, mGeosPrepared );
+  }
   mGeos = nullptr;
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
   mGeosPrepared = nullptr;
 }
 
 void QgsGeos::geometryChanged()
 {
-  GEOSGeom_destroy_r( geosinit.ctxt, mGeos );
+  if ( mCacheEntry )
+  {
+    // the cached geometries belong to the former geometry, they are only released
+    mCacheEntry.reset();
+  }
+  else
+  {
+    GEOSGeom_destroy_r( geosinit()->ctxt, mGeos );
+    GEOSPreparedGeom_destroy_r( geosinit()->ctxt, mGeosPrepared );
+  }
   mGeos = nullptr;
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
   mGeosPrepared = nullptr;
   cacheGeos();
 }
 
 void QgsGeos::prepareGeometry()
 {
-  GEOSPreparedGeom_destroy_r( geosinit.ctxt, mGeosPrepared );
+  if ( mCacheEntry )
+  {
+    // already prepared by the cache
+    return;
+  }
+
+  GEOSPreparedGeom_destroy_r( geosinit()->ctxt, mGeosPrepared );
   mGeosPrepared = nullptr;
   if ( mGeos )
   {
-    mGeosPrepared = GEOSPrepare_r( geosinit.ctxt, mGeos );
+    mGeosPrepared = GEOSPrepare_r( geosinit()->ctxt, mGeos );
   }
 }
 
@@ -177,6 +318,78 @@ void QgsGeos::cacheGeos() const
   mGeos = asGeos( mGeometry, mPrecision );
 }
 
+QgsGeos *QgsGeos::cachedPreparedEngine( const QgsGeometry &geometry, const QString &source, QgsFeatureId fid )
+{
+  QgsGeosPreparedCache *cache = preparedCache();
+  if ( geometry.isNull() || cache->maxCost() <= 0 )
+  {
+    QgsGeos *engine = new QgsGeos( geometry.geometry() );
+    engine->prepareGeometry();
+    return engine;
+  }
+
+  const QPair< QString, QgsFeatureId > key( source, fid );
+  const QgsAbstractGeometry *abstractGeometry = geometry.geometry();
+  const uint hash = geometryHash( abstractGeometry );
+  std::shared_ptr< QgsGeosCacheEntry > entry;
+  if ( std::shared_ptr< QgsGeosCacheEntry > *cached = cache->object( key ) )
+  {
+    // the geometry may have been modified in place through QgsGeometry::geometry() since it was
+    // cached, even if it is still the same object, so a hit is always confirmed by the vertices.
+    // Only a matching hash needs them to be compared
+    if ( ( *cached )->hash == hash && sameVertices( ( *cached )->geometry.get(), abstractGeometry ) )
+      entry = *cached;
+  }
+
+  if ( entry )
+  {
+    sPreparedCacheHits++;
+  }
+  else
+  {
+    GEOSGeometry *geos = asGeos( abstractGeometry );
+    if ( !geos )
+      return new QgsGeos( abstractGeometry );
+
+    try
+    {
+      entry = std::make_shared< QgsGeosCacheEntry >( abstractGeometry, hash, geos );
+    }
+    catch ( GEOSException &e )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Exception: %1" ).arg( e.what() ), QObject::tr( "GEOS" ) );
+      GEOSGeom_destroy_r( geosinit()->ctxt, geos );
+      return new QgsGeos( abstractGeometry );
+    }
+
+    // geometries larger than the whole cache are not kept, but can still be used by the engine
+    int vertices = GEOSGetNumCoordinates_r( geosinit()->ctxt, geos );
+    cache->insert( key, new std::shared_ptr< QgsGeosCacheEntry >( entry ), std::max( 1, vertices ) );
+  }
+
+  return new QgsGeos( abstractGeometry, entry );
+}
+
+int QgsGeos::preparedGeometryCacheSize()
+{
+  return sPreparedCacheSize.load();
+}
+
+void QgsGeos::setPreparedGeometryCacheSize( int vertices )
+{
+  sPreparedCacheSize.store( std::max( 0, vertices ) );
+}
+
+void QgsGeos::clearPreparedGeometryCache()
+{
+  preparedCache()->clear();
+}
+
+int QgsGeos::preparedGeometryCacheHits()
+{
+  return sPreparedCacheHits;
+}
+
 QgsAbstractGeometry *QgsGeos::intersection( const QgsAbstractGeometry *geom, QString *errorMsg ) const
 {
   return overlay( geom, INTERSECTION, errorMsg );
@@ -197,7 +410,7 @@ QgsAbstractGeometry *QgsGeos::clip( const QgsRectangle &rect, QString *errorMsg
   try
   {
     GEOSGeomScopedPtr opGeom;
-    opGeom.reset( GEOSClipByRect_r( geosinit.ctxt, mGeos, rect.xMinimum(), rect.yMinimum(), rect.xMaximum(), rect.yMaximum() ) );
+    opGeom.reset( GEOSClipByRect_r( geosinit()->ctxt, mGeos, rect.xMinimum(), rect.yMinimum(), rect.xMaximum(), rect.yMaximum() ) );
     QgsAbstractGeometry *opResult = fromGeos( opGeom.get() );
     return opResult;
   }
@@ -216,7 +429,7 @@ QgsAbstractGeometry *QgsGeos::clip( const QgsRectangle &rect, QString *errorMsg
 
 void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes, int depth, QgsGeometryCollection *parts, const QgsRectangle &clipRect ) const
 {
-  int partType = GEOSGeomTypeId_r( geosinit.ctxt, currentPart );
+  int partType = GEOSGeomTypeId_r( geosinit()->ctxt, currentPart );
   if ( qgsDoubleNear( clipRect.width(), 0.0 ) && qgsDoubleNear( clipRect.height(), 0.0 ) )
   {
     if ( partType == GEOS_POINT )
@@ -232,10 +445,10 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
 
   if ( partType == GEOS_MULTILINESTRING || partType == GEOS_MULTIPOLYGON || partType == GEOS_GEOMETRYCOLLECTION )
   {
-    int partCount = GEOSGetNumGeometries_r( geosinit.ctxt, currentPart );
+    int partCount = GEOSGetNumGeometries_r( geosinit()->ctxt, currentPart );
     for ( int i = 0; i < partCount; ++i )
     {
-      subdivideRecursive( GEOSGetGeometryN_r( geosinit.ctxt, currentPart, i ), maxNodes, depth, parts, clipRect );
+      subdivideRecursive( GEOSGetGeometryN_r( geosinit()->ctxt, currentPart, i ), maxNodes, depth, parts, clipRect );
     }
     return;
   }
@@ -246,7 +459,7 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
     return;
   }
 
-  int vertexCount = GEOSGetNumCoordinates_r( geosinit.ctxt, currentPart );
+  int vertexCount = GEOSGetNumCoordinates_r( geosinit()->ctxt, currentPart );
   if ( vertexCount == 0 )
   {
     return;
@@ -289,9 +502,9 @@ void QgsGeos::subdivideRecursive( const GEOSGeometry *currentPart, int maxNodes,
   }
 
   GEOSGeomScopedPtr clipPart1;
-  clipPart1.reset( GEOSClipByRect_r( geosinit.ctxt, currentPart, halfClipRect1.xMinimum(), halfClipRect1.yMinimum(), halfClipRect1.xMaximum(), halfClipRect1.yMaximum() ) );
+  clipPart1.reset( GEOSClipByRect_r( geosinit()->ctxt, currentPart, halfClipRect1.xMinimum(), halfClipRect1.yMinimum(), halfClipRect1.xMaximum(), halfClipRect1.yMaximum() ) );
   GEOSGeomScopedPtr clipPart2;
-  clipPart2.reset( GEOSClipByRect_r( geosinit.ctxt, currentPart, halfClipRect2.xMinimum(), halfClipRect2.yMinimum(), halfClipRect2.xMaximum(), halfClipRect2.yMaximum() ) );
+  clipPart2.reset( GEOSClipByRect_r( geosinit()->ctxt, currentPart, halfClipRect2.xMinimum(), halfClipRect2.yMinimum(), halfClipRect2.xMaximum(), halfClipRect2.yMaximum() ) );
 
   ++depth;
 
@@ -346,13 +559,13 @@ QgsAbstractGeometry *QgsGeos::combine( const QList<QgsAbstractGeometry *> &geomL
   try
   {
     GEOSGeometry *geomCollection =  createGeosCollection( GEOS_GEOMETRYCOLLECTION, geosGeometries );
-    geomUnion = GEOSUnaryUnion_r( geosinit.ctxt, geomCollection );
-    GEOSGeom_destroy_r( geosinit.ctxt, geomCollection );
+    geomUnion = GEOSUnaryUnion_r( geosinit()->ctxt, geomCollection );
+    GEOSGeom_destroy_r( geosinit()->ctxt, geomCollection );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr )
 
   QgsAbstractGeometry *result = fromGeos( geomUnion );
-  GEOSGeom_destroy_r( geosinit.ctxt, geomUnion );
+  GEOSGeom_destroy_r( geosinit()->ctxt, geomUnion );
   return result;
 }
 
@@ -377,7 +590,7 @@ double QgsGeos::distance( const QgsAbstractGeometry *geom, QString *errorMsg ) c
 
   try
   {
-    GEOSDistance_r( geosinit.ctxt, mGeos, otherGeosGeom.get(), &distance );
+    GEOSDistance_r( geosinit()->ctxt, mGeos, otherGeosGeom.get(), &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -400,7 +613,7 @@ double QgsGeos::hausdorffDistance( const QgsAbstractGeometry *geom, QString *err
 
   try
   {
-    GEOSHausdorffDistance_r( geosinit.ctxt, mGeos, otherGeosGeom.get(), &distance );
+    GEOSHausdorffDistance_r( geosinit()->ctxt, mGeos, otherGeosGeom.get(), &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -423,7 +636,7 @@ double QgsGeos::hausdorffDistanceDensify( const QgsAbstractGeometry *geom, doubl
 
   try
   {
-    GEOSHausdorffDistanceDensify_r( geosinit.ctxt, mGeos, otherGeosGeom.get(), densifyFraction, &distance );
+    GEOSHausdorffDistanceDensify_r( geosinit()->ctxt, mGeos, otherGeosGeom.get(), densifyFraction, &distance );
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
 
@@ -481,11 +694,11 @@ QString QgsGeos::relate( const QgsAbstractGeometry *geom, QString *errorMsg ) co
   QString result;
   try
   {
-    char *r = GEOSRelate_r( geosinit.ctxt, mGeos, geosGeom.get() );
+    char *r = GEOSRelate_r( geosinit()->ctxt, mGeos, geosGeom.get() );
     if ( r )
     {
       result = QString( r );
-      GEOSFree_r( geosinit.ctxt, r );
+      GEOSFree_r( geosinit()->ctxt, r );
     }
   }
   catch ( GEOSException &e )
@@ -515,7 +728,7 @@ bool QgsGeos::relatePattern( const QgsAbstractGeometry *geom, const QString &pat
   bool result = false;
   try
   {
-    result = ( GEOSRelatePattern_r( geosinit.ctxt, mGeos, geosGeom.get(), pattern.toLocal8Bit().constData() ) == 1 );
+    result = ( GEOSRelatePattern_r( geosinit()->ctxt, mGeos, geosGeom.get(), pattern.toLocal8Bit().constData() ) == 1 );
   }
   catch ( GEOSException &e )
   {
@@ -538,7 +751,7 @@ double QgsGeos::area( QString *errorMsg ) const
 
   try
   {
-    if ( GEOSArea_r( geosinit.ctxt, mGeos, &area ) != 1 )
+    if ( GEOSArea_r( geosinit()->ctxt, mGeos, &area ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 );
@@ -554,7 +767,7 @@ double QgsGeos::length( QString *errorMsg ) const
   }
   try
   {
-    if ( GEOSLength_r( geosinit.ctxt, mGeos, &length ) != 1 )
+    if ( GEOSLength_r( geosinit()->ctxt, mGeos, &length ) != 1 )
       return -1.0;
   }
   CATCH_GEOS_WITH_ERRMSG( -1.0 )
@@ -580,7 +793,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitGeometry( const QgsLineSt
     return SplitCannotSplitPoint; //cannot split points
   }
 
-  if ( !GEOSisValid_r( geosinit.ctxt, mGeos ) )
+  if ( !GEOSisValid_r( geosinit()->ctxt, mGeos ) )
     return InvalidBaseGeometry;
 
   //make sure splitLine is valid
@@ -606,9 +819,9 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitGeometry( const QgsLineSt
       return InvalidInput;
     }
 
-    if ( !GEOSisValid_r( geosinit.ctxt, splitLineGeos ) || !GEOSisSimple_r( geosinit.ctxt, splitLineGeos ) )
+    if ( !GEOSisValid_r( geosinit()->ctxt, splitLineGeos ) || !GEOSisSimple_r( geosinit()->ctxt, splitLineGeos ) )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosinit()->ctxt, splitLineGeos );
       return InvalidInput;
     }
 
@@ -625,12 +838,12 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitGeometry( const QgsLineSt
     if ( mGeometry->dimension() == 1 )
     {
       returnCode = splitLinearGeometry( splitLineGeos, newGeometries );
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosinit()->ctxt, splitLineGeos );
     }
     else if ( mGeometry->dimension() == 2 )
     {
       returnCode = splitPolygonGeometry( splitLineGeos, newGeometries );
-      GEOSGeom_destroy_r( geosinit.ctxt, splitLineGeos );
+      GEOSGeom_destroy_r( geosinit()->ctxt, splitLineGeos );
     }
     else
     {
@@ -658,18 +871,18 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
   try
   {
     testPoints.clear();
-    GEOSGeometry *intersectionGeom = GEOSIntersection_r( geosinit.ctxt, mGeos, splitLine );
+    GEOSGeometry *intersectionGeom = GEOSIntersection_r( geosinit()->ctxt, mGeos, splitLine );
     if ( !intersectionGeom )
       return false;
 
     bool simple = false;
     int nIntersectGeoms = 1;
-    if ( GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom ) == GEOS_LINESTRING
-         || GEOSGeomTypeId_r( geosinit.ctxt, intersectionGeom ) == GEOS_POINT )
+    if ( GEOSGeomTypeId_r( geosinit()->ctxt, intersectionGeom ) == GEOS_LINESTRING
+         || GEOSGeomTypeId_r( geosinit()->ctxt, intersectionGeom ) == GEOS_POINT )
       simple = true;
 
     if ( !simple )
-      nIntersectGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, intersectionGeom );
+      nIntersectGeoms = GEOSGetNumGeometries_r( geosinit()->ctxt, intersectionGeom );
 
     for ( int i = 0; i < nIntersectGeoms; ++i )
     {
@@ -677,18 +890,18 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
       if ( simple )
         currentIntersectGeom = intersectionGeom;
       else
-        currentIntersectGeom = GEOSGetGeometryN_r( geosinit.ctxt, intersectionGeom, i );
+        currentIntersectGeom = GEOSGetGeometryN_r( geosinit()->ctxt, intersectionGeom, i );
 
-      const GEOSCoordSequence *lineSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentIntersectGeom );
+      const GEOSCoordSequence *lineSequence = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, currentIntersectGeom );
       unsigned int sequenceSize = 0;
       double x, y;
-      if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, lineSequence, &sequenceSize ) != 0 )
+      if ( GEOSCoordSeq_getSize_r( geosinit()->ctxt, lineSequence, &sequenceSize ) != 0 )
       {
         for ( unsigned int i = 0; i < sequenceSize; ++i )
         {
-          if ( GEOSCoordSeq_getX_r( geosinit.ctxt, lineSequence, i, &x ) != 0 )
+          if ( GEOSCoordSeq_getX_r( geosinit()->ctxt, lineSequence, i, &x ) != 0 )
           {
-            if ( GEOSCoordSeq_getY_r( geosinit.ctxt, lineSequence, i, &y ) != 0 )
+            if ( GEOSCoordSeq_getY_r( geosinit()->ctxt, lineSequence, i, &y ) != 0 )
             {
               testPoints.push_back( QgsPoint( x, y ) );
             }
@@ -696,7 +909,7 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
         }
       }
     }
-    GEOSGeom_destroy_r( geosinit.ctxt, intersectionGeom );
+    GEOSGeom_destroy_r( geosinit()->ctxt, intersectionGeom );
   }
   CATCH_GEOS_WITH_ERRMSG( 1 )
 
@@ -705,7 +918,7 @@ bool QgsGeos::topologicalTestPointsSplit( const GEOSGeometry *splitLine, QgsPoin
 
 GEOSGeometry *QgsGeos::linePointDifference( GEOSGeometry *GEOSsplitPoint ) const
 {
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int type = GEOSGeomTypeId_r( geosinit()->ctxt, mGeos );
 
   QgsMultiCurve *multiCurve = nullptr;
   if ( type == GEOS_MULTILINESTRING )
@@ -778,15 +991,15 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
     return InvalidBaseGeometry;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos ) )
+  if ( !GEOSIntersects_r( geosinit()->ctxt, splitLine, mGeos ) )
     return NothingHappened;
 
   //check that split line has no linear intersection
-  int linearIntersect = GEOSRelatePattern_r( geosinit.ctxt, mGeos, splitLine, "1********" );
+  int linearIntersect = GEOSRelatePattern_r( geosinit()->ctxt, mGeos, splitLine, "1********" );
   if ( linearIntersect > 0 )
     return InvalidInput;
 
-  int splitGeomType = GEOSGeomTypeId_r( geosinit.ctxt, splitLine );
+  int splitGeomType = GEOSGeomTypeId_r( geosinit()->ctxt, splitLine );
 
   GEOSGeometry *splitGeom = nullptr;
   if ( splitGeomType == GEOS_POINT )
@@ -795,22 +1008,22 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
   }
   else
   {
-    splitGeom = GEOSDifference_r( geosinit.ctxt, mGeos, splitLine );
+    splitGeom = GEOSDifference_r( geosinit()->ctxt, mGeos, splitLine );
   }
   QVector<GEOSGeometry *> lineGeoms;
 
-  int splitType = GEOSGeomTypeId_r( geosinit.ctxt, splitGeom );
+  int splitType = GEOSGeomTypeId_r( geosinit()->ctxt, splitGeom );
   if ( splitType == GEOS_MULTILINESTRING )
   {
-    int nGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, splitGeom );
+    int nGeoms = GEOSGetNumGeometries_r( geosinit()->ctxt, splitGeom );
     lineGeoms.reserve( nGeoms );
     for ( int i = 0; i < nGeoms; ++i )
-      lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, splitGeom, i ) );
+      lineGeoms << GEOSGeom_clone_r( geosinit()->ctxt, GEOSGetGeometryN_r( geosinit()->ctxt, splitGeom, i ) );
 
   }
   else
   {
-    lineGeoms << GEOSGeom_clone_r( geosinit.ctxt, splitGeom );
+    lineGeoms << GEOSGeom_clone_r( geosinit()->ctxt, splitGeom );
   }
 
   mergeGeometriesMultiTypeSplit( lineGeoms );
@@ -818,10 +1031,10 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitLinearGeometry( GEOSGeome
   for ( int i = 0; i < lineGeoms.size(); ++i )
   {
     newGeometries << fromGeos( lineGeoms[i] );
-    GEOSGeom_destroy_r( geosinit.ctxt, lineGeoms[i] );
+    GEOSGeom_destroy_r( geosinit()->ctxt, lineGeoms[i] );
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, splitGeom );
+  GEOSGeom_destroy_r( geosinit()->ctxt, splitGeom );
   return Success;
 }
 
@@ -834,7 +1047,7 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     return InvalidBaseGeometry;
 
   //first test if linestring intersects geometry. If not, return straight away
-  if ( !GEOSIntersects_r( geosinit.ctxt, splitLine, mGeos ) )
+  if ( !GEOSIntersects_r( geosinit()->ctxt, splitLine, mGeos ) )
     return NothingHappened;
 
   //first union all the polygon rings together (to get them noded, see JTS developer guide)
@@ -842,18 +1055,18 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
   if ( !nodedGeometry )
     return NodedGeometryError; //an error occurred during noding
 
-  GEOSGeometry *polygons = GEOSPolygonize_r( geosinit.ctxt, &nodedGeometry, 1 );
+  GEOSGeometry *polygons = GEOSPolygonize_r( geosinit()->ctxt, &nodedGeometry, 1 );
   if ( !polygons || numberOfGeometries( polygons ) == 0 )
   {
     if ( polygons )
-      GEOSGeom_destroy_r( geosinit.ctxt, polygons );
+      GEOSGeom_destroy_r( geosinit()->ctxt, polygons );
 
-    GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+    GEOSGeom_destroy_r( geosinit()->ctxt, nodedGeometry );
 
     return InvalidBaseGeometry;
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+  GEOSGeom_destroy_r( geosinit()->ctxt, nodedGeometry );
 
   //test every polygon if contained in original geometry
   //include in result if yes
@@ -865,8 +1078,8 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
 
   for ( int i = 0; i < numberOfGeometries( polygons ); i++ )
   {
-    const GEOSGeometry *polygon = GEOSGetGeometryN_r( geosinit.ctxt, polygons, i );
-    intersectGeometry = GEOSIntersection_r( geosinit.ctxt, mGeos, polygon );
+    const GEOSGeometry *polygon = GEOSGetGeometryN_r( geosinit()->ctxt, polygons, i );
+    intersectGeometry = GEOSIntersection_r( geosinit()->ctxt, mGeos, polygon );
     if ( !intersectGeometry )
     {
       QgsDebugMsg( "intersectGeometry is nullptr" );
@@ -874,18 +1087,18 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
     }
 
     double intersectionArea;
-    GEOSArea_r( geosinit.ctxt, intersectGeometry, &intersectionArea );
+    GEOSArea_r( geosinit()->ctxt, intersectGeometry, &intersectionArea );
 
     double polygonArea;
-    GEOSArea_r( geosinit.ctxt, polygon, &polygonArea );
+    GEOSArea_r( geosinit()->ctxt, polygon, &polygonArea );
 
     const double areaRatio = intersectionArea / polygonArea;
     if ( areaRatio > 0.99 && areaRatio < 1.01 )
-      testedGeometries << GEOSGeom_clone_r( geosinit.ctxt, polygon );
+      testedGeometries << GEOSGeom_clone_r( geosinit()->ctxt, polygon );
 
-    GEOSGeom_destroy_r( geosinit.ctxt, intersectGeometry );
+    GEOSGeom_destroy_r( geosinit()->ctxt, intersectGeometry );
   }
-  GEOSGeom_destroy_r( geosinit.ctxt, polygons );
+  GEOSGeom_destroy_r( geosinit()->ctxt, polygons );
 
   bool splitDone = true;
   int nGeometriesThis = numberOfGeometries( mGeos ); //original number of geometries
@@ -901,19 +1114,19 @@ QgsGeometryEngine::EngineOperationResult QgsGeos::splitPolygonGeometry( GEOSGeom
   {
     for ( int i = 0; i < testedGeometries.size(); ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( geosinit()->ctxt, testedGeometries[i] );
     }
     return NothingHappened;
   }
 
   int i;
-  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( geosinit.ctxt, testedGeometries[i] ); ++i )
+  for ( i = 0; i < testedGeometries.size() && GEOSisValid_r( geosinit()->ctxt, testedGeometries[i] ); ++i )
     ;
 
   if ( i < testedGeometries.size() )
   {
     for ( i = 0; i < testedGeometries.size(); ++i )
-      GEOSGeom_destroy_r( geosinit.ctxt, testedGeometries[i] );
+      GEOSGeom_destroy_r( geosinit()->ctxt, testedGeometries[i] );
 
     return InvalidBaseGeometry;
   }
@@ -930,16 +1143,16 @@ GEOSGeometry *QgsGeos::nodeGeometries( const GEOSGeometry *splitLine, const GEOS
     return nullptr;
 
   GEOSGeometry *geometryBoundary = nullptr;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( geosinit.ctxt, geom ) == GEOS_MULTIPOLYGON )
-    geometryBoundary = GEOSBoundary_r( geosinit.ctxt, geom );
+  if ( GEOSGeomTypeId_r( geosinit()->ctxt, geom ) == GEOS_POLYGON || GEOSGeomTypeId_r( geosinit()->ctxt, geom ) == GEOS_MULTIPOLYGON )
+    geometryBoundary = GEOSBoundary_r( geosinit()->ctxt, geom );
   else
-    geometryBoundary = GEOSGeom_clone_r( geosinit.ctxt, geom );
+    geometryBoundary = GEOSGeom_clone_r( geosinit()->ctxt, geom );
 
-  GEOSGeometry *splitLineClone = GEOSGeom_clone_r( geosinit.ctxt, splitLine );
-  GEOSGeometry *unionGeometry = GEOSUnion_r( geosinit.ctxt, splitLineClone, geometryBoundary );
-  GEOSGeom_destroy_r( geosinit.ctxt, splitLineClone );
+  GEOSGeometry *splitLineClone = GEOSGeom_clone_r( geosinit()->ctxt, splitLine );
+  GEOSGeometry *unionGeometry = GEOSUnion_r( geosinit()->ctxt, splitLineClone, geometryBoundary );
+  GEOSGeom_destroy_r( geosinit()->ctxt, splitLineClone );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, geometryBoundary );
+  GEOSGeom_destroy_r( geosinit()->ctxt, geometryBoundary );
   return unionGeometry;
 }
 
@@ -949,7 +1162,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
     return 1;
 
   //convert mGeos to geometry collection
-  int type = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int type = GEOSGeomTypeId_r( geosinit()->ctxt, mGeos );
   if ( type != GEOS_GEOMETRYCOLLECTION &&
        type != GEOS_MULTILINESTRING &&
        type != GEOS_MULTIPOLYGON &&
@@ -966,9 +1179,9 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
   {
     //is this geometry a part of the original multitype?
     bool isPart = false;
-    for ( int j = 0; j < GEOSGetNumGeometries_r( geosinit.ctxt, mGeos ); j++ )
+    for ( int j = 0; j < GEOSGetNumGeometries_r( geosinit()->ctxt, mGeos ); j++ )
     {
-      if ( GEOSEquals_r( geosinit.ctxt, copyList[i], GEOSGetGeometryN_r( geosinit.ctxt, mGeos, j ) ) )
+      if ( GEOSEquals_r( geosinit()->ctxt, copyList[i], GEOSGetGeometryN_r( geosinit()->ctxt, mGeos, j ) ) )
       {
         isPart = true;
         break;
@@ -989,7 +1202,7 @@ int QgsGeos::mergeGeometriesMultiTypeSplit( QVector<GEOSGeometry *> &splitResult
       else if ( type == GEOS_MULTIPOLYGON )
         splitResult << createGeosCollection( GEOS_MULTIPOLYGON, geomVector );
       else
-        GEOSGeom_destroy_r( geosinit.ctxt, copyList[i] );
+        GEOSGeom_destroy_r( geosinit()->ctxt, copyList[i] );
     }
   }
 
@@ -1034,7 +1247,7 @@ GEOSGeometry *QgsGeos::createGeosCollection( int typeId, const QVector<GEOSGeome
 
   try
   {
-    geom = GEOSGeom_createCollection_r( geosinit.ctxt, typeId, geomarr, nNotNullGeoms );
+    geom = GEOSGeom_createCollection_r( geosinit()->ctxt, typeId, geomarr, nNotNullGeoms );
   }
   catch ( GEOSException &e )
   {
@@ -1053,16 +1266,16 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
     return nullptr;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit()->ctxt, geos );
+  int nDims = GEOSGeom_getDimensions_r( geosinit()->ctxt, geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = ( ( nDims - nCoordDims ) == 1 );
 
-  switch ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) )
+  switch ( GEOSGeomTypeId_r( geosinit()->ctxt, geos ) )
   {
     case GEOS_POINT:                 // a point
     {
-      const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+      const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, geos );
       return ( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
     }
     case GEOS_LINESTRING:
@@ -1076,10 +1289,10 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
     case GEOS_MULTIPOINT:
     {
       QgsMultiPointV2 *multiPoint = new QgsMultiPointV2();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosinit()->ctxt, geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, GEOSGetGeometryN_r( geosinit()->ctxt, geos, i ) );
         if ( cs )
         {
           multiPoint->addGeometry( coordSeqPoint( cs, 0, hasZ, hasM ).clone() );
@@ -1090,10 +1303,10 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
     case GEOS_MULTILINESTRING:
     {
       QgsMultiLineString *multiLineString = new QgsMultiLineString();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosinit()->ctxt, geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsLineString *line = sequenceToLinestring( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ), hasZ, hasM );
+        QgsLineString *line = sequenceToLinestring( GEOSGetGeometryN_r( geosinit()->ctxt, geos, i ), hasZ, hasM );
         if ( line )
         {
           multiLineString->addGeometry( line );
@@ -1105,10 +1318,10 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
     {
       QgsMultiPolygonV2 *multiPolygon = new QgsMultiPolygonV2();
 
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosinit()->ctxt, geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsPolygonV2 *poly = fromGeosPolygon( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        QgsPolygonV2 *poly = fromGeosPolygon( GEOSGetGeometryN_r( geosinit()->ctxt, geos, i ) );
         if ( poly )
         {
           multiPolygon->addGeometry( poly );
@@ -1119,10 +1332,10 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
     case GEOS_GEOMETRYCOLLECTION:
     {
       QgsGeometryCollection *geomCollection = new QgsGeometryCollection();
-      int nParts = GEOSGetNumGeometries_r( geosinit.ctxt, geos );
+      int nParts = GEOSGetNumGeometries_r( geosinit()->ctxt, geos );
       for ( int i = 0; i < nParts; ++i )
       {
-        QgsAbstractGeometry *geom = fromGeos( GEOSGetGeometryN_r( geosinit.ctxt, geos, i ) );
+        QgsAbstractGeometry *geom = fromGeos( GEOSGetGeometryN_r( geosinit()->ctxt, geos, i ) );
         if ( geom )
         {
           geomCollection->addGeometry( geom );
@@ -1136,28 +1349,28 @@ QgsAbstractGeometry *QgsGeos::fromGeos( const GEOSGeometry *geos )
 
 QgsPolygonV2 *QgsGeos::fromGeosPolygon( const GEOSGeometry *geos )
 {
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, geos ) != GEOS_POLYGON )
+  if ( GEOSGeomTypeId_r( geosinit()->ctxt, geos ) != GEOS_POLYGON )
   {
     return nullptr;
   }
 
-  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit.ctxt, geos );
-  int nDims = GEOSGeom_getDimensions_r( geosinit.ctxt, geos );
+  int nCoordDims = GEOSGeom_getCoordinateDimension_r( geosinit()->ctxt, geos );
+  int nDims = GEOSGeom_getDimensions_r( geosinit()->ctxt, geos );
   bool hasZ = ( nCoordDims == 3 );
   bool hasM = ( ( nDims - nCoordDims ) == 1 );
 
   QgsPolygonV2 *polygon = new QgsPolygonV2();
 
-  const GEOSGeometry *ring = GEOSGetExteriorRing_r( geosinit.ctxt, geos );
+  const GEOSGeometry *ring = GEOSGetExteriorRing_r( geosinit()->ctxt, geos );
   if ( ring )
   {
     polygon->setExteriorRing( sequenceToLinestring( ring, hasZ, hasM ) );
   }
 
   QList<QgsCurve *> interiorRings;
-  for ( int i = 0; i < GEOSGetNumInteriorRings_r( geosinit.ctxt, geos ); ++i )
+  for ( int i = 0; i < GEOSGetNumInteriorRings_r( geosinit()->ctxt, geos ); ++i )
   {
-    ring = GEOSGetInteriorRingN_r( geosinit.ctxt, geos, i );
+    ring = GEOSGetInteriorRingN_r( geosinit()->ctxt, geos, i );
     if ( ring )
     {
       interiorRings.push_back( sequenceToLinestring( ring, hasZ, hasM ) );
@@ -1170,9 +1383,9 @@ QgsPolygonV2 *QgsGeos::fromGeosPolygon( const GEOSGeometry *geos )
 
 QgsLineString *QgsGeos::sequenceToLinestring( const GEOSGeometry *geos, bool hasZ, bool hasM )
 {
-  const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit.ctxt, geos );
+  const GEOSCoordSequence *cs = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, geos );
   unsigned int nPoints;
-  GEOSCoordSeq_getSize_r( geosinit.ctxt, cs, &nPoints );
+  GEOSCoordSeq_getSize_r( geosinit()->ctxt, cs, &nPoints );
   QVector< double > xOut;
   xOut.reserve( nPoints );
   QVector< double > yOut;
@@ -1189,18 +1402,18 @@ QgsLineString *QgsGeos::sequenceToLinestring( const GEOSGeometry *geos, bool has
   double m = 0;
   for ( unsigned int i = 0; i < nPoints; ++i )
   {
-    GEOSCoordSeq_getX_r( geosinit.ctxt, cs, i, &x );
+    GEOSCoordSeq_getX_r( geosinit()->ctxt, cs, i, &x );
     xOut << x;
-    GEOSCoordSeq_getY_r( geosinit.ctxt, cs, i, &y );
+    GEOSCoordSeq_getY_r( geosinit()->ctxt, cs, i, &y );
     yOut << y;
     if ( hasZ )
     {
-      GEOSCoordSeq_getZ_r( geosinit.ctxt, cs, i, &z );
+      GEOSCoordSeq_getZ_r( geosinit()->ctxt, cs, i, &z );
       zOut << z;
     }
     if ( hasM )
     {
-      GEOSCoordSeq_getOrdinate_r( geosinit.ctxt, cs, i, 3, &m );
+      GEOSCoordSeq_getOrdinate_r( geosinit()->ctxt, cs, i, 3, &m );
       mOut << m;
     }
   }
@@ -1213,13 +1426,13 @@ int QgsGeos::numberOfGeometries( GEOSGeometry *g )
   if ( !g )
     return 0;
 
-  int geometryType = GEOSGeomTypeId_r( geosinit.ctxt, g );
+  int geometryType = GEOSGeomTypeId_r( geosinit()->ctxt, g );
   if ( geometryType == GEOS_POINT || geometryType == GEOS_LINESTRING || geometryType == GEOS_LINEARRING
        || geometryType == GEOS_POLYGON )
     return 1;
 
   //calling GEOSGetNumGeometries is save for multi types and collections also in geos2
-  return GEOSGetNumGeometries_r( geosinit.ctxt, g );
+  return GEOSGetNumGeometries_r( geosinit()->ctxt, g );
 }
 
 QgsPoint QgsGeos::coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM )
@@ -1232,15 +1445,15 @@ QgsPoint QgsGeos::coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ,
   double x, y;
   double z = 0;
   double m = 0;
-  GEOSCoordSeq_getX_r( geosinit.ctxt, cs, i, &x );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, cs, i, &y );
+  GEOSCoordSeq_getX_r( geosinit()->ctxt, cs, i, &x );
+  GEOSCoordSeq_getY_r( geosinit()->ctxt, cs, i, &y );
   if ( hasZ )
   {
-    GEOSCoordSeq_getZ_r( geosinit.ctxt, cs, i, &z );
+    GEOSCoordSeq_getZ_r( geosinit()->ctxt, cs, i, &z );
   }
   if ( hasM )
   {
-    GEOSCoordSeq_getOrdinate_r( geosinit.ctxt, cs, i, 3, &m );
+    GEOSCoordSeq_getOrdinate_r( geosinit()->ctxt, cs, i, 3, &m );
   }
 
   QgsWkbTypes::Type t = QgsWkbTypes::Point;
@@ -1358,21 +1571,21 @@ QgsAbstractGeometry *QgsGeos::overlay( const QgsAbstractGeometry *geom, Overlay
     switch ( op )
     {
       case INTERSECTION:
-        opGeom.reset( GEOSIntersection_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSIntersection_r( geosinit()->ctxt, mGeos, geosGeom.get() ) );
         break;
       case DIFFERENCE:
-        opGeom.reset( GEOSDifference_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSDifference_r( geosinit()->ctxt, mGeos, geosGeom.get() ) );
         break;
       case UNION:
       {
-        GEOSGeometry *unionGeometry = GEOSUnion_r( geosinit.ctxt, mGeos, geosGeom.get() );
+        GEOSGeometry *unionGeometry = GEOSUnion_r( geosinit()->ctxt, mGeos, geosGeom.get() );
 
-        if ( unionGeometry && GEOSGeomTypeId_r( geosinit.ctxt, unionGeometry ) == GEOS_MULTILINESTRING )
+        if ( unionGeometry && GEOSGeomTypeId_r( geosinit()->ctxt, unionGeometry ) == GEOS_MULTILINESTRING )
         {
-          GEOSGeometry *mergedLines = GEOSLineMerge_r( geosinit.ctxt, unionGeometry );
+          GEOSGeometry *mergedLines = GEOSLineMerge_r( geosinit()->ctxt, unionGeometry );
           if ( mergedLines )
           {
-            GEOSGeom_destroy_r( geosinit.ctxt, unionGeometry );
+            GEOSGeom_destroy_r( geosinit()->ctxt, unionGeometry );
             unionGeometry = mergedLines;
           }
         }
@@ -1381,7 +1594,7 @@ QgsAbstractGeometry *QgsGeos::overlay( const QgsAbstractGeometry *geom, Overlay
       }
       break;
       case SYMDIFFERENCE:
-        opGeom.reset( GEOSSymDifference_r( geosinit.ctxt, mGeos, geosGeom.get() ) );
+        opGeom.reset( GEOSSymDifference_r( geosinit()->ctxt, mGeos, geosGeom.get() ) );
         break;
       default:    //unknown op
         return nullptr;
@@ -1420,25 +1633,25 @@ bool QgsGeos::relation( const QgsAbstractGeometry *geom, Relation r, QString *er
       switch ( r )
       {
         case INTERSECTS:
-          result = ( GEOSPreparedIntersects_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedIntersects_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case TOUCHES:
-          result = ( GEOSPreparedTouches_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedTouches_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case CROSSES:
-          result = ( GEOSPreparedCrosses_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedCrosses_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case WITHIN:
-          result = ( GEOSPreparedWithin_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedWithin_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case CONTAINS:
-          result = ( GEOSPreparedContains_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedContains_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case DISJOINT:
-          result = ( GEOSPreparedDisjoint_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedDisjoint_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         case OVERLAPS:
-          result = ( GEOSPreparedOverlaps_r( geosinit.ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
+          result = ( GEOSPreparedOverlaps_r( geosinit()->ctxt, mGeosPrepared, geosGeom.get() ) == 1 );
           break;
         default:
           return false;
@@ -1449,25 +1662,25 @@ bool QgsGeos::relation( const QgsAbstractGeometry *geom, Relation r, QString *er
     switch ( r )
     {
       case INTERSECTS:
-        result = ( GEOSIntersects_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSIntersects_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case TOUCHES:
-        result = ( GEOSTouches_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSTouches_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case CROSSES:
-        result = ( GEOSCrosses_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSCrosses_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case WITHIN:
-        result = ( GEOSWithin_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSWithin_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case CONTAINS:
-        result = ( GEOSContains_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSContains_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case DISJOINT:
-        result = ( GEOSDisjoint_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSDisjoint_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       case OVERLAPS:
-        result = ( GEOSOverlaps_r( geosinit.ctxt, mGeos, geosGeom.get() ) == 1 );
+        result = ( GEOSOverlaps_r( geosinit()->ctxt, mGeos, geosGeom.get() ) == 1 );
         break;
       default:
         return false;
@@ -1495,7 +1708,7 @@ QgsAbstractGeometry *QgsGeos::buffer( double distance, int segments, QString *er
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSBuffer_r( geosinit.ctxt, mGeos, distance, segments ) );
+    geos.reset( GEOSBuffer_r( geosinit()->ctxt, mGeos, distance, segments ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1511,7 +1724,7 @@ QgsAbstractGeometry *QgsGeos::buffer( double distance, int segments, int endCapS
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSBufferWithStyle_r( geosinit.ctxt, mGeos, distance, segments, endCapStyle, joinStyle, miterLimit ) );
+    geos.reset( GEOSBufferWithStyle_r( geosinit()->ctxt, mGeos, distance, segments, endCapStyle, joinStyle, miterLimit ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1526,7 +1739,7 @@ QgsAbstractGeometry *QgsGeos::simplify( double tolerance, QString *errorMsg ) co
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSTopologyPreserveSimplify_r( geosinit.ctxt, mGeos, tolerance ) );
+    geos.reset( GEOSTopologyPreserveSimplify_r( geosinit()->ctxt, mGeos, tolerance ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1541,7 +1754,7 @@ QgsAbstractGeometry *QgsGeos::interpolate( double distance, QString *errorMsg )
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSInterpolate_r( geosinit.ctxt, mGeos, distance ) );
+    geos.reset( GEOSInterpolate_r( geosinit()->ctxt, mGeos, distance ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1560,13 +1773,13 @@ QgsPoint *QgsGeos::centroid( QString *errorMsg ) const
 
   try
   {
-    geos.reset( GEOSGetCentroid_r( geosinit.ctxt,  mGeos ) );
+    geos.reset( GEOSGetCentroid_r( geosinit()->ctxt,  mGeos ) );
 
     if ( !geos )
       return nullptr;
 
-    GEOSGeomGetX_r( geosinit.ctxt, geos.get(), &x );
-    GEOSGeomGetY_r( geosinit.ctxt, geos.get(), &y );
+    GEOSGeomGetX_r( geosinit()->ctxt, geos.get(), &x );
+    GEOSGeomGetY_r( geosinit()->ctxt, geos.get(), &y );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
 
@@ -1582,7 +1795,7 @@ QgsAbstractGeometry *QgsGeos::envelope( QString *errorMsg ) const
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSEnvelope_r( geosinit.ctxt, mGeos ) );
+    geos.reset( GEOSEnvelope_r( geosinit()->ctxt, mGeos ) );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1601,15 +1814,15 @@ QgsPoint *QgsGeos::pointOnSurface( QString *errorMsg ) const
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSPointOnSurface_r( geosinit.ctxt, mGeos ) );
+    geos.reset( GEOSPointOnSurface_r( geosinit()->ctxt, mGeos ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( geosinit()->ctxt, geos.get() ) != 0 )
     {
       return nullptr;
     }
 
-    GEOSGeomGetX_r( geosinit.ctxt, geos.get(), &x );
-    GEOSGeomGetY_r( geosinit.ctxt, geos.get(), &y );
+    GEOSGeomGetX_r( geosinit()->ctxt, geos.get(), &x );
+    GEOSGeomGetY_r( geosinit()->ctxt, geos.get(), &y );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
 
@@ -1625,9 +1838,9 @@ QgsAbstractGeometry *QgsGeos::convexHull( QString *errorMsg ) const
 
   try
   {
-    GEOSGeometry *cHull = GEOSConvexHull_r( geosinit.ctxt, mGeos );
+    GEOSGeometry *cHull = GEOSConvexHull_r( geosinit()->ctxt, mGeos );
     QgsAbstractGeometry *cHullGeom = fromGeos( cHull );
-    GEOSGeom_destroy_r( geosinit.ctxt, cHull );
+    GEOSGeom_destroy_r( geosinit()->ctxt, cHull );
     return cHullGeom;
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
@@ -1642,7 +1855,7 @@ bool QgsGeos::isValid( QString *errorMsg ) const
 
   try
   {
-    return GEOSisValid_r( geosinit.ctxt, mGeos );
+    return GEOSisValid_r( geosinit()->ctxt, mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1661,7 +1874,7 @@ bool QgsGeos::isEqual( const QgsAbstractGeometry *geom, QString *errorMsg ) cons
     {
       return false;
     }
-    bool equal = GEOSEquals_r( geosinit.ctxt, mGeos, geosGeom.get() );
+    bool equal = GEOSEquals_r( geosinit()->ctxt, mGeos, geosGeom.get() );
     return equal;
   }
   CATCH_GEOS_WITH_ERRMSG( false );
@@ -1676,7 +1889,7 @@ bool QgsGeos::isEmpty( QString *errorMsg ) const
 
   try
   {
-    return GEOSisEmpty_r( geosinit.ctxt, mGeos );
+    return GEOSisEmpty_r( geosinit()->ctxt, mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1690,7 +1903,7 @@ bool QgsGeos::isSimple( QString *errorMsg ) const
 
   try
   {
-    return GEOSisSimple_r( geosinit.ctxt, mGeos );
+    return GEOSisSimple_r( geosinit()->ctxt, mGeos );
   }
   CATCH_GEOS_WITH_ERRMSG( false );
 }
@@ -1734,7 +1947,7 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
   GEOSCoordSequence *coordSeq = nullptr;
   try
   {
-    coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, numOutPoints, coordDims );
+    coordSeq = GEOSCoordSeq_create_r( geosinit()->ctxt, numOutPoints, coordDims );
     if ( !coordSeq )
     {
       QgsMessageLog::logMessage( QObject::tr( "Could not create coordinate sequence for %1 points in %2 dimensions" ).arg( numPoints ).arg( coordDims ), QObject::tr( "GEOS" ) );
@@ -1744,15 +1957,15 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
     {
       for ( int i = 0; i < numOutPoints; ++i )
       {
-        GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, i, std::round( line->xAt( i % numPoints ) / precision ) * precision );
-        GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, i, std::round( line->yAt( i % numPoints ) / precision ) * precision );
+        GEOSCoordSeq_setX_r( geosinit()->ctxt, coordSeq, i, std::round( line->xAt( i % numPoints ) / precision ) * precision );
+        GEOSCoordSeq_setY_r( geosinit()->ctxt, coordSeq, i, std::round( line->yAt( i % numPoints ) / precision ) * precision );
         if ( hasZ )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 2, std::round( line->zAt( i % numPoints ) / precision ) * precision );
+          GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, i, 2, std::round( line->zAt( i % numPoints ) / precision ) * precision );
         }
         if ( hasM )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 3, line->mAt( i % numPoints ) );
+          GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, i, 3, line->mAt( i % numPoints ) );
         }
       }
     }
@@ -1760,15 +1973,15 @@ GEOSCoordSequence *QgsGeos::createCoordinateSequence( const QgsCurve *curve, dou
     {
       for ( int i = 0; i < numOutPoints; ++i )
       {
-        GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, i, line->xAt( i % numPoints ) );
-        GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, i, line->yAt( i % numPoints ) );
+        GEOSCoordSeq_setX_r( geosinit()->ctxt, coordSeq, i, line->xAt( i % numPoints ) );
+        GEOSCoordSeq_setY_r( geosinit()->ctxt, coordSeq, i, line->yAt( i % numPoints ) );
         if ( hasZ )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 2, line->zAt( i % numPoints ) );
+          GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, i, 2, line->zAt( i % numPoints ) );
         }
         if ( hasM )
         {
-          GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, i, 3, line->mAt( i % numPoints ) );
+          GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, i, 3, line->mAt( i % numPoints ) );
         }
       }
     }
@@ -1800,7 +2013,7 @@ GEOSGeometry *QgsGeos::createGeosPointXY( double x, double y, bool hasZ, double
 
   try
   {
-    GEOSCoordSequence *coordSeq = GEOSCoordSeq_create_r( geosinit.ctxt, 1, coordDims );
+    GEOSCoordSequence *coordSeq = GEOSCoordSeq_create_r( geosinit()->ctxt, 1, coordDims );
     if ( !coordSeq )
     {
       QgsMessageLog::logMessage( QObject::tr( "Could not create coordinate sequence for point with %1 dimensions" ).arg( coordDims ), QObject::tr( "GEOS" ) );
@@ -1808,29 +2021,29 @@ GEOSGeometry *QgsGeos::createGeosPointXY( double x, double y, bool hasZ, double
     }
     if ( precision > 0. )
     {
-      GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, 0, std::round( x / precision ) * precision );
-      GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, 0, std::round( y / precision ) * precision );
+      GEOSCoordSeq_setX_r( geosinit()->ctxt, coordSeq, 0, std::round( x / precision ) * precision );
+      GEOSCoordSeq_setY_r( geosinit()->ctxt, coordSeq, 0, std::round( y / precision ) * precision );
       if ( hasZ )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 2, std::round( z / precision ) * precision );
+        GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, 0, 2, std::round( z / precision ) * precision );
       }
     }
     else
     {
-      GEOSCoordSeq_setX_r( geosinit.ctxt, coordSeq, 0, x );
-      GEOSCoordSeq_setY_r( geosinit.ctxt, coordSeq, 0, y );
+      GEOSCoordSeq_setX_r( geosinit()->ctxt, coordSeq, 0, x );
+      GEOSCoordSeq_setY_r( geosinit()->ctxt, coordSeq, 0, y );
       if ( hasZ )
       {
-        GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 2, z );
+        GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, 0, 2, z );
       }
     }
 #if 0 //disabled until geos supports m-coordinates
     if ( hasM )
     {
-      GEOSCoordSeq_setOrdinate_r( geosinit.ctxt, coordSeq, 0, 3, m );
+      GEOSCoordSeq_setOrdinate_r( geosinit()->ctxt, coordSeq, 0, 3, m );
     }
 #endif
-    geosPoint = GEOSGeom_createPoint_r( geosinit.ctxt, coordSeq );
+    geosPoint = GEOSGeom_createPoint_r( geosinit()->ctxt, coordSeq );
   }
   CATCH_GEOS( nullptr )
   return geosPoint;
@@ -1849,7 +2062,7 @@ GEOSGeometry *QgsGeos::createGeosLinestring( const QgsAbstractGeometry *curve, d
   GEOSGeometry *geosGeom = nullptr;
   try
   {
-    geosGeom = GEOSGeom_createLineString_r( geosinit.ctxt, coordSeq );
+    geosGeom = GEOSGeom_createLineString_r( geosinit()->ctxt, coordSeq );
   }
   CATCH_GEOS( nullptr )
   return geosGeom;
@@ -1870,7 +2083,7 @@ GEOSGeometry *QgsGeos::createGeosPolygon( const QgsAbstractGeometry *poly, doubl
   GEOSGeometry *geosPolygon = nullptr;
   try
   {
-    GEOSGeometry *exteriorRingGeos = GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( exteriorRing, precision, true ) );
+    GEOSGeometry *exteriorRingGeos = GEOSGeom_createLinearRing_r( geosinit()->ctxt, createCoordinateSequence( exteriorRing, precision, true ) );
 
 
     int nHoles = polygon->numInteriorRings();
@@ -1883,9 +2096,9 @@ GEOSGeometry *QgsGeos::createGeosPolygon( const QgsAbstractGeometry *poly, doubl
     for ( int i = 0; i < nHoles; ++i )
     {
       const QgsCurve *interiorRing = polygon->interiorRing( i );
-      holes[i] = GEOSGeom_createLinearRing_r( geosinit.ctxt, createCoordinateSequence( interiorRing, precision, true ) );
+      holes[i] = GEOSGeom_createLinearRing_r( geosinit()->ctxt, createCoordinateSequence( interiorRing, precision, true ) );
     }
-    geosPolygon = GEOSGeom_createPolygon_r( geosinit.ctxt, exteriorRingGeos, holes, nHoles );
+    geosPolygon = GEOSGeom_createPolygon_r( geosinit()->ctxt, exteriorRingGeos, holes, nHoles );
     delete[] holes;
   }
   CATCH_GEOS( nullptr )
@@ -1901,11 +2114,11 @@ QgsAbstractGeometry *QgsGeos::offsetCurve( double distance, int segments, int jo
   GEOSGeometry *offset = nullptr;
   try
   {
-    offset = GEOSOffsetCurve_r( geosinit.ctxt, mGeos, distance, segments, joinStyle, miterLimit );
+    offset = GEOSOffsetCurve_r( geosinit()->ctxt, mGeos, distance, segments, joinStyle, miterLimit );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr )
   QgsAbstractGeometry *offsetGeom = fromGeos( offset );
-  GEOSGeom_destroy_r( geosinit.ctxt, offset );
+  GEOSGeom_destroy_r( geosinit()->ctxt, offset );
   return offsetGeom;
 }
 
@@ -1919,18 +2132,18 @@ QgsAbstractGeometry *QgsGeos::singleSidedBuffer( double distance, int segments,
   GEOSGeomScopedPtr geos;
   try
   {
-    GEOSBufferParams *bp  = GEOSBufferParams_create_r( geosinit.ctxt );
-    GEOSBufferParams_setSingleSided_r( geosinit.ctxt, bp, 1 );
-    GEOSBufferParams_setQuadrantSegments_r( geosinit.ctxt, bp, segments );
-    GEOSBufferParams_setJoinStyle_r( geosinit.ctxt, bp, joinStyle );
-    GEOSBufferParams_setMitreLimit_r( geosinit.ctxt, bp, miterLimit );  //#spellok
+    GEOSBufferParams *bp  = GEOSBufferParams_create_r( geosinit()->ctxt );
+    GEOSBufferParams_setSingleSided_r( geosinit()->ctxt, bp, 1 );
+    GEOSBufferParams_setQuadrantSegments_r( geosinit()->ctxt, bp, segments );
+    GEOSBufferParams_setJoinStyle_r( geosinit()->ctxt, bp, joinStyle );
+    GEOSBufferParams_setMitreLimit_r( geosinit()->ctxt, bp, miterLimit );  //#spellok
 
     if ( side == 1 )
     {
       distance = -distance;
     }
-    geos.reset( GEOSBufferWithParams_r( geosinit.ctxt, mGeos, bp, distance ) );
-    GEOSBufferParams_destroy_r( geosinit.ctxt, bp );
+    geos.reset( GEOSBufferWithParams_r( geosinit()->ctxt, mGeos, bp, distance ) );
+    GEOSBufferParams_destroy_r( geosinit()->ctxt, bp );
   }
   CATCH_GEOS_WITH_ERRMSG( nullptr );
   return fromGeos( geos.get() );
@@ -1953,16 +2166,16 @@ QgsAbstractGeometry *QgsGeos::reshapeGeometry( const QgsLineString &reshapeWithL
   GEOSGeometry *reshapeLineGeos = createGeosLinestring( &reshapeWithLine, mPrecision );
 
   //single or multi?
-  int numGeoms = GEOSGetNumGeometries_r( geosinit.ctxt, mGeos );
+  int numGeoms = GEOSGetNumGeometries_r( geosinit()->ctxt, mGeos );
   if ( numGeoms == -1 )
   {
     if ( errorCode ) { *errorCode = InvalidBaseGeometry; }
-    GEOSGeom_destroy_r( geosinit.ctxt, reshapeLineGeos );
+    GEOSGeom_destroy_r( geosinit()->ctxt, reshapeLineGeos );
     return nullptr;
   }
 
   bool isMultiGeom = false;
-  int geosTypeId = GEOSGeomTypeId_r( geosinit.ctxt, mGeos );
+  int geosTypeId = GEOSGeomTypeId_r( geosinit()->ctxt, mGeos );
   if ( geosTypeId == GEOS_MULTILINESTRING || geosTypeId == GEOS_MULTIPOLYGON )
     isMultiGeom = true;
 
@@ -1983,8 +2196,8 @@ QgsAbstractGeometry *QgsGeos::reshapeGeometry( const QgsLineString &reshapeWithL
     if ( errorCode )
       *errorCode = Success;
     QgsAbstractGeometry *reshapeResult = fromGeos( reshapedGeometry );
-    GEOSGeom_destroy_r( geosinit.ctxt, reshapedGeometry );
-    GEOSGeom_destroy_r( geosinit.ctxt, reshapeLineGeos );
+    GEOSGeom_destroy_r( geosinit()->ctxt, reshapedGeometry );
+    GEOSGeom_destroy_r( geosinit()->ctxt, reshapeLineGeos );
     return reshapeResult;
   }
   else
@@ -2000,9 +2213,9 @@ QgsAbstractGeometry *QgsGeos::reshapeGeometry( const QgsLineString &reshapeWithL
       for ( int i = 0; i < numGeoms; ++i )
       {
         if ( isLine )
-          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ), reshapeLineGeos, mPrecision );
+          currentReshapeGeometry = reshapeLine( GEOSGetGeometryN_r( geosinit()->ctxt, mGeos, i ), reshapeLineGeos, mPrecision );
         else
-          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ), reshapeLineGeos, mPrecision );
+          currentReshapeGeometry = reshapePolygon( GEOSGetGeometryN_r( geosinit()->ctxt, mGeos, i ), reshapeLineGeos, mPrecision );
 
         if ( currentReshapeGeometry )
         {
@@ -2011,19 +2224,19 @@ QgsAbstractGeometry *QgsGeos::reshapeGeometry( const QgsLineString &reshapeWithL
         }
         else
         {
-          newGeoms[i] = GEOSGeom_clone_r( geosinit.ctxt, GEOSGetGeometryN_r( geosinit.ctxt, mGeos, i ) );
+          newGeoms[i] = GEOSGeom_clone_r( geosinit()->ctxt, GEOSGetGeometryN_r( geosinit()->ctxt, mGeos, i ) );
         }
       }
-      GEOSGeom_destroy_r( geosinit.ctxt, reshapeLineGeos );
+      GEOSGeom_destroy_r( geosinit()->ctxt, reshapeLineGeos );
 
       GEOSGeometry *newMultiGeom = nullptr;
       if ( isLine )
       {
-        newMultiGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, newGeoms, numGeoms );
+        newMultiGeom = GEOSGeom_createCollection_r( geosinit()->ctxt, GEOS_MULTILINESTRING, newGeoms, numGeoms );
       }
       else //multipolygon
       {
-        newMultiGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTIPOLYGON, newGeoms, numGeoms );
+        newMultiGeom = GEOSGeom_createCollection_r( geosinit()->ctxt, GEOS_MULTIPOLYGON, newGeoms, numGeoms );
       }
 
       delete[] newGeoms;
@@ -2038,12 +2251,12 @@ QgsAbstractGeometry *QgsGeos::reshapeGeometry( const QgsLineString &reshapeWithL
         if ( errorCode )
           *errorCode = Success;
         QgsAbstractGeometry *reshapedMultiGeom = fromGeos( newMultiGeom );
-        GEOSGeom_destroy_r( geosinit.ctxt, newMultiGeom );
+        GEOSGeom_destroy_r( geosinit()->ctxt, newMultiGeom );
         return reshapedMultiGeom;
       }
       else
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, newMultiGeom );
+        GEOSGeom_destroy_r( geosinit()->ctxt, newMultiGeom );
         if ( errorCode ) { *errorCode = NothingHappened; }
         return nullptr;
       }
@@ -2059,13 +2272,13 @@ QgsGeometry QgsGeos::mergeLines( QString *errorMsg ) const
     return QgsGeometry();
   }
 
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, mGeos ) != GEOS_MULTILINESTRING )
+  if ( GEOSGeomTypeId_r( geosinit()->ctxt, mGeos ) != GEOS_MULTILINESTRING )
     return QgsGeometry();
 
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSLineMerge_r( geosinit.ctxt, mGeos ) );
+    geos.reset( GEOSLineMerge_r( geosinit()->ctxt, mGeos ) );
   }
   CATCH_GEOS_WITH_ERRMSG( QgsGeometry() );
   return QgsGeometry( fromGeos( geos.get() ) );
@@ -2088,11 +2301,11 @@ QgsGeometry QgsGeos::closestPoint( const QgsGeometry &other, QString *errorMsg )
   double ny = 0.0;
   try
   {
-    GEOSCoordSequence *nearestCoord = GEOSNearestPoints_r( geosinit.ctxt, mGeos, otherGeom.get() );
+    GEOSCoordSequence *nearestCoord = GEOSNearestPoints_r( geosinit()->ctxt, mGeos, otherGeom.get() );
 
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord, 0, &nx );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord, 0, &ny );
-    GEOSCoordSeq_destroy_r( geosinit.ctxt, nearestCoord );
+    ( void )GEOSCoordSeq_getX_r( geosinit()->ctxt, nearestCoord, 0, &nx );
+    ( void )GEOSCoordSeq_getY_r( geosinit()->ctxt, nearestCoord, 0, &ny );
+    GEOSCoordSeq_destroy_r( geosinit()->ctxt, nearestCoord );
   }
   catch ( GEOSException &e )
   {
@@ -2125,14 +2338,14 @@ QgsGeometry QgsGeos::shortestLine( const QgsGeometry &other, QString *errorMsg )
   double ny2 = 0.0;
   try
   {
-    GEOSCoordSequence *nearestCoord = GEOSNearestPoints_r( geosinit.ctxt, mGeos, otherGeom.get() );
+    GEOSCoordSequence *nearestCoord = GEOSNearestPoints_r( geosinit()->ctxt, mGeos, otherGeom.get() );
 
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord, 0, &nx1 );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord, 0, &ny1 );
-    ( void )GEOSCoordSeq_getX_r( geosinit.ctxt, nearestCoord, 1, &nx2 );
-    ( void )GEOSCoordSeq_getY_r( geosinit.ctxt, nearestCoord, 1, &ny2 );
+    ( void )GEOSCoordSeq_getX_r( geosinit()->ctxt, nearestCoord, 0, &nx1 );
+    ( void )GEOSCoordSeq_getY_r( geosinit()->ctxt, nearestCoord, 0, &ny1 );
+    ( void )GEOSCoordSeq_getX_r( geosinit()->ctxt, nearestCoord, 1, &nx2 );
+    ( void )GEOSCoordSeq_getY_r( geosinit()->ctxt, nearestCoord, 1, &ny2 );
 
-    GEOSCoordSeq_destroy_r( geosinit.ctxt, nearestCoord );
+    GEOSCoordSeq_destroy_r( geosinit()->ctxt, nearestCoord );
   }
   catch ( GEOSException &e )
   {
@@ -2165,7 +2378,7 @@ double QgsGeos::lineLocatePoint( const QgsPoint &point, QString *errorMsg ) cons
   double distance = -1;
   try
   {
-    distance = GEOSProject_r( geosinit.ctxt, mGeos, otherGeom.get() );
+    distance = GEOSProject_r( geosinit()->ctxt, mGeos, otherGeom.get() );
   }
   catch ( GEOSException &e )
   {
@@ -2195,10 +2408,10 @@ QgsGeometry QgsGeos::polygonize( const QList<QgsAbstractGeometry *> &geometries,
 
   try
   {
-    GEOSGeomScopedPtr result( GEOSPolygonize_r( geosinit.ctxt, lineGeosGeometries, validLines ) );
+    GEOSGeomScopedPtr result( GEOSPolygonize_r( geosinit()->ctxt, lineGeosGeometries, validLines ) );
     for ( int i = 0; i < validLines; ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, lineGeosGeometries[i] );
+      GEOSGeom_destroy_r( geosinit()->ctxt, lineGeosGeometries[i] );
     }
     delete[] lineGeosGeometries;
     return QgsGeometry( fromGeos( result.get() ) );
@@ -2211,7 +2424,7 @@ QgsGeometry QgsGeos::polygonize( const QList<QgsAbstractGeometry *> &geometries,
     }
     for ( int i = 0; i < validLines; ++i )
     {
-      GEOSGeom_destroy_r( geosinit.ctxt, lineGeosGeometries[i] );
+      GEOSGeom_destroy_r( geosinit()->ctxt, lineGeosGeometries[i] );
     }
     delete[] lineGeosGeometries;
     return QgsGeometry();
@@ -2240,9 +2453,9 @@ QgsGeometry QgsGeos::voronoiDiagram( const QgsAbstractGeometry *extent, double t
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSVoronoiDiagram_r( geosinit.ctxt, mGeos, extentGeos, tolerance, edgesOnly ) );
+    geos.reset( GEOSVoronoiDiagram_r( geosinit()->ctxt, mGeos, extentGeos, tolerance, edgesOnly ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( geosinit()->ctxt, geos.get() ) != 0 )
     {
       return QgsGeometry();
     }
@@ -2262,9 +2475,9 @@ QgsGeometry QgsGeos::delaunayTriangulation( double tolerance, bool edgesOnly, QS
   GEOSGeomScopedPtr geos;
   try
   {
-    geos.reset( GEOSDelaunayTriangulation_r( geosinit.ctxt, mGeos, tolerance, edgesOnly ) );
+    geos.reset( GEOSDelaunayTriangulation_r( geosinit()->ctxt, mGeos, tolerance, edgesOnly ) );
 
-    if ( !geos || GEOSisEmpty_r( geosinit.ctxt, geos.get() ) != 0 )
+    if ( !geos || GEOSisEmpty_r( geosinit()->ctxt, geos.get() ) != 0 )
     {
       return QgsGeometry();
     }
@@ -2278,21 +2491,21 @@ QgsGeometry QgsGeos::delaunayTriangulation( double tolerance, bool edgesOnly, QS
 //! Extract coordinates of linestring's endpoints. Returns false on error.
 static bool _linestringEndpoints( const GEOSGeometry *linestring, double &x1, double &y1, double &x2, double &y2 )
 {
-  const GEOSCoordSequence *coordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, linestring );
+  const GEOSCoordSequence *coordSeq = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, linestring );
   if ( !coordSeq )
     return false;
 
   unsigned int coordSeqSize;
-  if ( GEOSCoordSeq_getSize_r( geosinit.ctxt, coordSeq, &coordSeqSize ) == 0 )
+  if ( GEOSCoordSeq_getSize_r( geosinit()->ctxt, coordSeq, &coordSeqSize ) == 0 )
     return false;
 
   if ( coordSeqSize < 2 )
     return false;
 
-  GEOSCoordSeq_getX_r( geosinit.ctxt, coordSeq, 0, &x1 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, coordSeq, 0, &y1 );
-  GEOSCoordSeq_getX_r( geosinit.ctxt, coordSeq, coordSeqSize - 1, &x2 );
-  GEOSCoordSeq_getY_r( geosinit.ctxt, coordSeq, coordSeqSize - 1, &y2 );
+  GEOSCoordSeq_getX_r( geosinit()->ctxt, coordSeq, 0, &x1 );
+  GEOSCoordSeq_getY_r( geosinit()->ctxt, coordSeq, 0, &y1 );
+  GEOSCoordSeq_getX_r( geosinit()->ctxt, coordSeq, coordSeqSize - 1, &x2 );
+  GEOSCoordSeq_getY_r( geosinit()->ctxt, coordSeq, coordSeqSize - 1, &y2 );
   return true;
 }
 
@@ -2318,12 +2531,12 @@ static GEOSGeometry *_mergeLinestrings( const GEOSGeometry *line1, const GEOSGeo
   // the intersection must be at the begin/end of both lines
   if ( intersectionAtOrigLineEndpoint && intersectionAtReshapeLineEndpoint )
   {
-    GEOSGeometry *g1 = GEOSGeom_clone_r( geosinit.ctxt, line1 );
-    GEOSGeometry *g2 = GEOSGeom_clone_r( geosinit.ctxt, line2 );
+    GEOSGeometry *g1 = GEOSGeom_clone_r( geosinit()->ctxt, line1 );
+    GEOSGeometry *g2 = GEOSGeom_clone_r( geosinit()->ctxt, line2 );
     GEOSGeometry *geoms[2] = { g1, g2 };
-    GEOSGeometry *multiGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, geoms, 2 );
-    GEOSGeometry *res = GEOSLineMerge_r( geosinit.ctxt, multiGeom );
-    GEOSGeom_destroy_r( geosinit.ctxt, multiGeom );
+    GEOSGeometry *multiGeom = GEOSGeom_createCollection_r( geosinit()->ctxt, GEOS_MULTILINESTRING, geoms, 2 );
+    GEOSGeometry *res = GEOSLineMerge_r( geosinit()->ctxt, multiGeom );
+    GEOSGeom_destroy_r( geosinit()->ctxt, multiGeom );
     return res;
   }
   else
@@ -2343,22 +2556,22 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
   try
   {
     //make sure there are at least two intersection between line and reshape geometry
-    GEOSGeometry *intersectGeom = GEOSIntersection_r( geosinit.ctxt, line, reshapeLineGeos );
+    GEOSGeometry *intersectGeom = GEOSIntersection_r( geosinit()->ctxt, line, reshapeLineGeos );
     if ( intersectGeom )
     {
-      atLeastTwoIntersections = ( GEOSGeomTypeId_r( geosinit.ctxt, intersectGeom ) == GEOS_MULTIPOINT
-                                  && GEOSGetNumGeometries_r( geosinit.ctxt, intersectGeom ) > 1 );
+      atLeastTwoIntersections = ( GEOSGeomTypeId_r( geosinit()->ctxt, intersectGeom ) == GEOS_MULTIPOINT
+                                  && GEOSGetNumGeometries_r( geosinit()->ctxt, intersectGeom ) > 1 );
       // one point is enough when extending line at its endpoint
-      if ( GEOSGeomTypeId_r( geosinit.ctxt, intersectGeom ) == GEOS_POINT )
+      if ( GEOSGeomTypeId_r( geosinit()->ctxt, intersectGeom ) == GEOS_POINT )
       {
-        const GEOSCoordSequence *intersectionCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, intersectGeom );
+        const GEOSCoordSequence *intersectionCoordSeq = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, intersectGeom );
         double xi, yi;
-        GEOSCoordSeq_getX_r( geosinit.ctxt, intersectionCoordSeq, 0, &xi );
-        GEOSCoordSeq_getY_r( geosinit.ctxt, intersectionCoordSeq, 0, &yi );
+        GEOSCoordSeq_getX_r( geosinit()->ctxt, intersectionCoordSeq, 0, &xi );
+        GEOSCoordSeq_getY_r( geosinit()->ctxt, intersectionCoordSeq, 0, &yi );
         oneIntersection = true;
         oneIntersectionPoint = QgsPointXY( xi, yi );
       }
-      GEOSGeom_destroy_r( geosinit.ctxt, intersectGeom );
+      GEOSGeom_destroy_r( geosinit()->ctxt, intersectGeom );
     }
   }
   catch ( GEOSException &e )
@@ -2383,36 +2596,36 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
   GEOSGeometry *endLineVertex = createGeosPointXY( x2, y2, false, 0, false, 0, 2, precision );
 
   bool isRing = false;
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, line ) == GEOS_LINEARRING
-       || GEOSEquals_r( geosinit.ctxt, beginLineVertex, endLineVertex ) == 1 )
+  if ( GEOSGeomTypeId_r( geosinit()->ctxt, line ) == GEOS_LINEARRING
+       || GEOSEquals_r( geosinit()->ctxt, beginLineVertex, endLineVertex ) == 1 )
     isRing = true;
 
   //node line and reshape line
   GEOSGeometry *nodedGeometry = nodeGeometries( reshapeLineGeos, line );
   if ( !nodedGeometry )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, beginLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, endLineVertex );
     return nullptr;
   }
 
   //and merge them together
-  GEOSGeometry *mergedLines = GEOSLineMerge_r( geosinit.ctxt, nodedGeometry );
-  GEOSGeom_destroy_r( geosinit.ctxt, nodedGeometry );
+  GEOSGeometry *mergedLines = GEOSLineMerge_r( geosinit()->ctxt, nodedGeometry );
+  GEOSGeom_destroy_r( geosinit()->ctxt, nodedGeometry );
   if ( !mergedLines )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, beginLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, endLineVertex );
     return nullptr;
   }
 
-  int numMergedLines = GEOSGetNumGeometries_r( geosinit.ctxt, mergedLines );
+  int numMergedLines = GEOSGetNumGeometries_r( geosinit()->ctxt, mergedLines );
   if ( numMergedLines < 2 ) //some special cases. Normally it is >2
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, beginLineVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, endLineVertex );
     if ( numMergedLines == 1 ) //reshape line is from begin to endpoint. So we keep the reshapeline
-      return GEOSGeom_clone_r( geosinit.ctxt, reshapeLineGeos );
+      return GEOSGeom_clone_r( geosinit()->ctxt, reshapeLineGeos );
     else
       return nullptr;
   }
@@ -2424,19 +2637,19 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
   {
     const GEOSGeometry *currentGeom = nullptr;
 
-    currentGeom = GEOSGetGeometryN_r( geosinit.ctxt, mergedLines, i );
-    const GEOSCoordSequence *currentCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, currentGeom );
+    currentGeom = GEOSGetGeometryN_r( geosinit()->ctxt, mergedLines, i );
+    const GEOSCoordSequence *currentCoordSeq = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, currentGeom );
     unsigned int currentCoordSeqSize;
-    GEOSCoordSeq_getSize_r( geosinit.ctxt, currentCoordSeq, &currentCoordSeqSize );
+    GEOSCoordSeq_getSize_r( geosinit()->ctxt, currentCoordSeq, &currentCoordSeqSize );
     if ( currentCoordSeqSize < 2 )
       continue;
 
     //get the two endpoints of the current line merge result
     double xBegin, xEnd, yBegin, yEnd;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, 0, &xBegin );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, 0, &yBegin );
-    GEOSCoordSeq_getX_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
-    GEOSCoordSeq_getY_r( geosinit.ctxt, currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
+    GEOSCoordSeq_getX_r( geosinit()->ctxt, currentCoordSeq, 0, &xBegin );
+    GEOSCoordSeq_getY_r( geosinit()->ctxt, currentCoordSeq, 0, &yBegin );
+    GEOSCoordSeq_getX_r( geosinit()->ctxt, currentCoordSeq, currentCoordSeqSize - 1, &xEnd );
+    GEOSCoordSeq_getY_r( geosinit()->ctxt, currentCoordSeq, currentCoordSeqSize - 1, &yEnd );
     GEOSGeometry *beginCurrentGeomVertex = createGeosPointXY( xBegin, yBegin, false, 0, false, 0, 2, precision );
     GEOSGeometry *endCurrentGeomVertex = createGeosPointXY( xEnd, yEnd, false, 0, false, 0, 2, precision );
 
@@ -2450,12 +2663,12 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
 
     //check how many endpoints equal the endpoints of the original line
     int nEndpointsSameAsOriginalLine = 0;
-    if ( GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex, beginLineVertex ) == 1
-         || GEOSEquals_r( geosinit.ctxt, beginCurrentGeomVertex, endLineVertex ) == 1 )
+    if ( GEOSEquals_r( geosinit()->ctxt, beginCurrentGeomVertex, beginLineVertex ) == 1
+         || GEOSEquals_r( geosinit()->ctxt, beginCurrentGeomVertex, endLineVertex ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
-    if ( GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex, beginLineVertex ) == 1
-         || GEOSEquals_r( geosinit.ctxt, endCurrentGeomVertex, endLineVertex ) == 1 )
+    if ( GEOSEquals_r( geosinit()->ctxt, endCurrentGeomVertex, beginLineVertex ) == 1
+         || GEOSEquals_r( geosinit()->ctxt, endCurrentGeomVertex, endLineVertex ) == 1 )
       nEndpointsSameAsOriginalLine += 1;
 
     //check if the current geometry overlaps the original geometry (GEOSOverlap does not seem to work with linestrings)
@@ -2470,28 +2683,28 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
     //logic to decide if this part belongs to the result
     if ( !isRing && nEndpointsSameAsOriginalLine == 1 && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosinit()->ctxt, currentGeom ) );
     }
     //for closed rings, we take one segment from the candidate list
     else if ( isRing && nEndpointsOnOriginalLine == 2 && currentGeomOverlapsOriginalGeom )
     {
-      probableParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      probableParts.push_back( GEOSGeom_clone_r( geosinit()->ctxt, currentGeom ) );
     }
     else if ( nEndpointsOnOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosinit()->ctxt, currentGeom ) );
     }
     else if ( nEndpointsSameAsOriginalLine == 2 && !currentGeomOverlapsOriginalGeom )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosinit()->ctxt, currentGeom ) );
     }
     else if ( currentGeomOverlapsOriginalGeom && currentGeomOverlapsReshapeLine )
     {
-      resultLineParts.push_back( GEOSGeom_clone_r( geosinit.ctxt, currentGeom ) );
+      resultLineParts.push_back( GEOSGeom_clone_r( geosinit()->ctxt, currentGeom ) );
     }
 
-    GEOSGeom_destroy_r( geosinit.ctxt, beginCurrentGeomVertex );
-    GEOSGeom_destroy_r( geosinit.ctxt, endCurrentGeomVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, beginCurrentGeomVertex );
+    GEOSGeom_destroy_r( geosinit()->ctxt, endCurrentGeomVertex );
   }
 
   //add the longest segment from the probable list for rings (only used for polygon rings)
@@ -2504,24 +2717,24 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
     for ( int i = 0; i < probableParts.size(); ++i )
     {
       currentGeom = probableParts.at( i );
-      GEOSLength_r( geosinit.ctxt, currentGeom, &currentLength );
+      GEOSLength_r( geosinit()->ctxt, currentGeom, &currentLength );
       if ( currentLength > maxLength )
       {
         maxLength = currentLength;
-        GEOSGeom_destroy_r( geosinit.ctxt, maxGeom );
+        GEOSGeom_destroy_r( geosinit()->ctxt, maxGeom );
         maxGeom = currentGeom;
       }
       else
       {
-        GEOSGeom_destroy_r( geosinit.ctxt, currentGeom );
+        GEOSGeom_destroy_r( geosinit()->ctxt, currentGeom );
       }
     }
     resultLineParts.push_back( maxGeom );
   }
 
-  GEOSGeom_destroy_r( geosinit.ctxt, beginLineVertex );
-  GEOSGeom_destroy_r( geosinit.ctxt, endLineVertex );
-  GEOSGeom_destroy_r( geosinit.ctxt, mergedLines );
+  GEOSGeom_destroy_r( geosinit()->ctxt, beginLineVertex );
+  GEOSGeom_destroy_r( geosinit()->ctxt, endLineVertex );
+  GEOSGeom_destroy_r( geosinit()->ctxt, mergedLines );
 
   GEOSGeometry *result = nullptr;
   if ( resultLineParts.size() < 1 )
@@ -2540,18 +2753,18 @@ GEOSGeometry *QgsGeos::reshapeLine( const GEOSGeometry *line, const GEOSGeometry
     }
 
     //create multiline from resultLineParts
-    GEOSGeometry *multiLineGeom = GEOSGeom_createCollection_r( geosinit.ctxt, GEOS_MULTILINESTRING, lineArray, resultLineParts.size() );
+    GEOSGeometry *multiLineGeom = GEOSGeom_createCollection_r( geosinit()->ctxt, GEOS_MULTILINESTRING, lineArray, resultLineParts.size() );
     delete [] lineArray;
 
     //then do a linemerge with the newly combined partstrings
-    result = GEOSLineMerge_r( geosinit.ctxt, multiLineGeom );
-    GEOSGeom_destroy_r( geosinit.ctxt, multiLineGeom );
+    result = GEOSLineMerge_r( geosinit()->ctxt, multiLineGeom );
+    GEOSGeom_destroy_r( geosinit()->ctxt, multiLineGeom );
   }
 
   //now test if the result is a linestring. Otherwise something went wrong
-  if ( GEOSGeomTypeId_r( geosinit.ctxt, result ) != GEOS_LINESTRING )
+  if ( GEOSGeomTypeId_r( geosinit()->ctxt, result ) != GEOS_LINESTRING )
   {
-    GEOSGeom_destroy_r( geosinit.ctxt, result );
+    GEOSGeom_destroy_r( geosinit()->ctxt, result );
     return nullptr;
   }
 
@@ -2565,13 +2778,13 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
   int lastIntersectingRing = -2;
   const GEOSGeometry *lastIntersectingGeom = nullptr;
 
-  int nRings = GEOSGetNumInteriorRings_r( geosinit.ctxt, polygon );
+  int nRings = GEOSGetNumInteriorRings_r( geosinit()->ctxt, polygon );
   if ( nRings < 0 )
     return nullptr;
 
   //does outer ring intersect?
-  const GEOSGeometry *outerRing = GEOSGetExteriorRing_r( geosinit.ctxt, polygon );
-  if ( GEOSIntersects_r( geosinit.ctxt, outerRing, reshapeLineGeos ) == 1 )
+  const GEOSGeometry *outerRing = GEOSGetExteriorRing_r( geosinit()->ctxt, polygon );
+  if ( GEOSIntersects_r( geosinit()->ctxt, outerRing, reshapeLineGeos ) == 1 )
   {
     ++nIntersections;
     lastIntersectingRing = -1;
@@ -2585,8 +2798,8 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
   {
     for ( int i = 0; i < nRings; ++i )
     {
-      innerRings[i] = GEOSGetInteriorRingN_r( geosinit.ctxt, polygon, i );
-      if ( GEOSIntersects_r( geosinit.ctxt, innerRings[i], reshapeLineGeos ) == 1 )
+      innerRings[i] = GEOSGetInteriorRingN_r( geosinit()->ctxt, polygon, i );
+      if ( GEOSIntersects_r( geosinit()->ctxt, innerRings[i], reshapeLineGeos ) == 1 )
       {
         ++nIntersections;
         lastIntersectingRing = i;
@@ -2616,12 +2829,12 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
 
   //if reshaping took place, we need to reassemble the polygon and its rings
   GEOSGeometry *newRing = nullptr;
-  const GEOSCoordSequence *reshapeSequence = GEOSGeom_getCoordSeq_r( geosinit.ctxt, reshapeResult );
-  GEOSCoordSequence *newCoordSequence = GEOSCoordSeq_clone_r( geosinit.ctxt, reshapeSequence );
+  const GEOSCoordSequence *reshapeSequence = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, reshapeResult );
+  GEOSCoordSequence *newCoordSequence = GEOSCoordSeq_clone_r( geosinit()->ctxt, reshapeSequence );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, reshapeResult );
+  GEOSGeom_destroy_r( geosinit()->ctxt, reshapeResult );
 
-  newRing = GEOSGeom_createLinearRing_r( geosinit.ctxt, newCoordSequence );
+  newRing = GEOSGeom_createLinearRing_r( geosinit()->ctxt, newCoordSequence );
   if ( !newRing )
   {
     delete [] innerRings;
@@ -2632,13 +2845,13 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
   if ( lastIntersectingRing == -1 )
     newOuterRing = newRing;
   else
-    newOuterRing = GEOSGeom_clone_r( geosinit.ctxt, outerRing );
+    newOuterRing = GEOSGeom_clone_r( geosinit()->ctxt, outerRing );
 
   //check if all the rings are still inside the outer boundary
   QList<GEOSGeometry *> ringList;
   if ( nRings > 0 )
   {
-    GEOSGeometry *outerRingPoly = GEOSGeom_createPolygon_r( geosinit.ctxt, GEOSGeom_clone_r( geosinit.ctxt, newOuterRing ), nullptr, 0 );
+    GEOSGeometry *outerRingPoly = GEOSGeom_createPolygon_r( geosinit()->ctxt, GEOSGeom_clone_r( geosinit()->ctxt, newOuterRing ), nullptr, 0 );
     if ( outerRingPoly )
     {
       GEOSGeometry *currentRing = nullptr;
@@ -2647,16 +2860,16 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
         if ( lastIntersectingRing == i )
           currentRing = newRing;
         else
-          currentRing = GEOSGeom_clone_r( geosinit.ctxt, innerRings[i] );
+          currentRing = GEOSGeom_clone_r( geosinit()->ctxt, innerRings[i] );
 
         //possibly a ring is no longer contained in the result polygon after reshape
-        if ( GEOSContains_r( geosinit.ctxt, outerRingPoly, currentRing ) == 1 )
+        if ( GEOSContains_r( geosinit()->ctxt, outerRingPoly, currentRing ) == 1 )
           ringList.push_back( currentRing );
         else
-          GEOSGeom_destroy_r( geosinit.ctxt, currentRing );
+          GEOSGeom_destroy_r( geosinit()->ctxt, currentRing );
       }
     }
-    GEOSGeom_destroy_r( geosinit.ctxt, outerRingPoly );
+    GEOSGeom_destroy_r( geosinit()->ctxt, outerRingPoly );
   }
 
   GEOSGeometry **newInnerRings = new GEOSGeometry*[ringList.size()];
@@ -2665,7 +2878,7 @@ GEOSGeometry *QgsGeos::reshapePolygon( const GEOSGeometry *polygon, const GEOSGe
 
   delete [] innerRings;
 
-  GEOSGeometry *reshapedPolygon = GEOSGeom_createPolygon_r( geosinit.ctxt, newOuterRing, newInnerRings, ringList.size() );
+  GEOSGeometry *reshapedPolygon = GEOSGeom_createPolygon_r( geosinit()->ctxt, newOuterRing, newInnerRings, ringList.size() );
   delete[] newInnerRings;
 
   return reshapedPolygon;
@@ -2680,21 +2893,21 @@ int QgsGeos::lineContainedInLine( const GEOSGeometry *line1, const GEOSGeometry
 
   double bufferDistance = std::pow( 10.0L, geomDigits( line2 ) - 11 );
 
-  GEOSGeometry *bufferGeom = GEOSBuffer_r( geosinit.ctxt, line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS );
+  GEOSGeometry *bufferGeom = GEOSBuffer_r( geosinit()->ctxt, line2, bufferDistance, DEFAULT_QUADRANT_SEGMENTS );
   if ( !bufferGeom )
     return -2;
 
-  GEOSGeometry *intersectionGeom = GEOSIntersection_r( geosinit.ctxt, bufferGeom, line1 );
+  GEOSGeometry *intersectionGeom = GEOSIntersection_r( geosinit()->ctxt, bufferGeom, line1 );
 
   //compare ratio between line1Length and intersectGeomLength (usually close to 1 if line1 is contained in line2)
   double intersectGeomLength;
   double line1Length;
 
-  GEOSLength_r( geosinit.ctxt, intersectionGeom, &intersectGeomLength );
-  GEOSLength_r( geosinit.ctxt, line1, &line1Length );
+  GEOSLength_r( geosinit()->ctxt, intersectionGeom, &intersectGeomLength );
+  GEOSLength_r( geosinit()->ctxt, line1, &line1Length );
 
-  GEOSGeom_destroy_r( geosinit.ctxt, bufferGeom );
-  GEOSGeom_destroy_r( geosinit.ctxt, intersectionGeom );
+  GEOSGeom_destroy_r( geosinit()->ctxt, bufferGeom );
+  GEOSGeom_destroy_r( geosinit()->ctxt, intersectionGeom );
 
   double intersectRatio = line1Length / intersectGeomLength;
   if ( intersectRatio > 0.9 && intersectRatio < 1.1 )
@@ -2710,49 +2923,49 @@ int QgsGeos::pointContainedInLine( const GEOSGeometry *point, const GEOSGeometry
 
   double bufferDistance = std::pow( 10.0L, geomDigits( line ) - 11 );
 
-  GEOSGeometry *lineBuffer = GEOSBuffer_r( geosinit.ctxt, line, bufferDistance, 8 );
+  GEOSGeometry *lineBuffer = GEOSBuffer_r( geosinit()->ctxt, line, bufferDistance, 8 );
   if ( !lineBuffer )
     return -2;
 
   bool contained = false;
-  if ( GEOSContains_r( geosinit.ctxt, lineBuffer, point ) == 1 )
+  if ( GEOSContains_r( geosinit()->ctxt, lineBuffer, point ) == 1 )
     contained = true;
 
-  GEOSGeom_destroy_r( geosinit.ctxt, lineBuffer );
+  GEOSGeom_destroy_r( geosinit()->ctxt, lineBuffer );
   return contained;
 }
 
 int QgsGeos::geomDigits( const GEOSGeometry *geom )
 {
-  GEOSGeomScopedPtr bbox( GEOSEnvelope_r( geosinit.ctxt, geom ) );
+  GEOSGeomScopedPtr bbox( GEOSEnvelope_r( geosinit()->ctxt, geom ) );
   if ( !bbox.get() )
     return -1;
 
-  const GEOSGeometry *bBoxRing = GEOSGetExteriorRing_r( geosinit.ctxt, bbox.get() );
+  const GEOSGeometry *bBoxRing = GEOSGetExteriorRing_r( geosinit()->ctxt, bbox.get() );
   if ( !bBoxRing )
     return -1;
 
-  const GEOSCoordSequence *bBoxCoordSeq = GEOSGeom_getCoordSeq_r( geosinit.ctxt, bBoxRing );
+  const GEOSCoordSequence *bBoxCoordSeq = GEOSGeom_getCoordSeq_r( geosinit()->ctxt, bBoxRing );
 
   if ( !bBoxCoordSeq )
     return -1;
 
   unsigned int nCoords = 0;
-  if ( !GEOSCoordSeq_getSize_r( geosinit.ctxt, bBoxCoordSeq, &nCoords ) )
+  if ( !GEOSCoordSeq_getSize_r( geosinit()->ctxt, bBoxCoordSeq, &nCoords ) )
     return -1;
 
   int maxDigits = -1;
   for ( unsigned int i = 0; i < nCoords - 1; ++i )
   {
     double t;
-    GEOSCoordSeq_getX_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getX_r( geosinit()->ctxt, bBoxCoordSeq, i, &t );
 
     int digits;
     digits = std::ceil( std::log10( std::fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
 
-    GEOSCoordSeq_getY_r( geosinit.ctxt, bBoxCoordSeq, i, &t );
+    GEOSCoordSeq_getY_r( geosinit()->ctxt, bBoxCoordSeq, i, &t );
     digits = std::ceil( std::log10( std::fabs( t ) ) );
     if ( digits > maxDigits )
       maxDigits = digits;
@@ -2763,5 +2976,5 @@ int QgsGeos::geomDigits( const GEOSGeometry *geom )
 
 GEOSContextHandle_t QgsGeos::getGEOSHandler()
 {
-  return geosinit.ctxt;
+  return geosinit()->ctxt;
 }
@@ -22,11 +22,13 @@ email                : marco.hugentobler at sourcepole dot com
 #include "qgsgeometryengine.h"
 #include "qgsgeometry.h"
 #include <geos_c.h>
+#include <memory>
 
 class QgsLineString;
 class QgsPolygonV2;
 class QgsGeometry;
 class QgsGeometryCollection;
+class QgsGeosCacheEntry;
 
 /** \ingroup core
  * Does vector analysis using the geos library and handles import, export, exception handling*
@@ -257,14 +259,68 @@ class CORE_EXPORT QgsGeos: public QgsGeometryEngine
     static GEOSGeometry *asGeos( const QgsAbstractGeometry *geom, double precision = 0 );
     static QgsPoint coordSeqPoint( const GEOSCoordSequence *cs, int i, bool hasZ, bool hasM );
 
+    //! Returns the GEOS context of the current thread
     static GEOSContextHandle_t getGEOSHandler();
 
+    /**
+     * Returns a new GEOS geometry engine for \a geometry, the geometry of the feature with id \a fid
+     * from \a source (e.g. a layer id). The engine is already prepared for predicate queries.
+     *
+     * The GEOS geometry and the prepared geometry are kept in a cache and shared with the engines
+     * created later on for the same feature, as long as its geometry has not changed. Each thread
+     * has its own cache, bounded to preparedGeometryCacheSize() vertices, with the least recently
+     * used geometries removed first.
+     *
+     * The \a geometry must outlive the engine.
+     * \see QgsGeometry::createGeometryEngine()
+     * \since QGIS 3.0
+     */
+    static QgsGeos *cachedPreparedEngine( const QgsGeometry &geometry, const QString &source, QgsFeatureId fid );
+
+    /**
+     * Returns the maximum number of vertices of the geometries kept in the prepared
+     * geometry cache of each thread.
+     * \see setPreparedGeometryCacheSize()
+     * \see cachedPreparedEngine()
+     * \since QGIS 3.0
+     */
+    static int preparedGeometryCacheSize();
+
+    /**
+     * Sets the maximum number of vertices of the geometries kept in the prepared
+     * geometry cache of each thread. A size of 0 disables the cache.
+     * \see preparedGeometryCacheSize()
+     * \see cachedPreparedEngine()
+     * \since QGIS 3.0
+     */
+    static void setPreparedGeometryCacheSize( int vertices );
+
+    /**
+     * Removes all geometries from the prepared geometry cache of the current thread.
+     * Engines which were created from the cache stay valid.
+     * \see cachedPreparedEngine()
+     * \since QGIS 3.0
+     */
+    static void clearPreparedGeometryCache();
+
+    /**
+     * Returns the number of engines which were created by cachedPreparedEngine() from a geometry
+     * already in the prepared geometry cache of the current thread.
+     * \see cachedPreparedEngine()
+     * \since QGIS 3.0
+     */
+    static int preparedGeometryCacheHits();
 
   private:
     mutable GEOSGeometry *mGeos;
     const GEOSPreparedGeometry *mGeosPrepared = nullptr;
     double mPrecision;
 
+    //! Cached GEOS and prepared geometries shared by the engine, which then owns neither mGeos nor mGeosPrepared
+    std::shared_ptr< QgsGeosCacheEntry > mCacheEntry;
+
+    QgsGeos( const QgsAbstractGeometry *geometry, const std::shared_ptr< QgsGeosCacheEntry > &cacheEntry );
+
     enum Overlay
     {
       INTERSECTION,
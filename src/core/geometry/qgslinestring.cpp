@@ -19,6 +19,7 @@
 #include "qgsapplication.h"
 #include "qgscompoundcurve.h"
 #include "qgscoordinatetransform.h"
+#include "qgsgeometrykernels.h"
 #include "qgsgeometryutils.h"
 #include "qgsmaptopixel.h"
 #include "qgswkbptr.h"
@@ -212,26 +213,7 @@ void QgsLineString::fromWkbPoints( QgsWkbTypes::Type type, const QgsConstWkbPtr
 
 QgsRectangle QgsLineString::calculateBoundingBox() const
 {
-  double xmin = std::numeric_limits<double>::max();
-  double ymin = std::numeric_limits<double>::max();
-  double xmax = -std::numeric_limits<double>::max();
-  double ymax = -std::numeric_limits<double>::max();
-
-  Q_FOREACH ( double x, mX )
-  {
-    if ( x < xmin )
-      xmin = x;
-    if ( x > xmax )
-      xmax = x;
-  }
-  Q_FOREACH ( double y, mY )
-  {
-    if ( y < ymin )
-      ymin = y;
-    if ( y > ymax )
-      ymax = y;
-  }
-  return QgsRectangle( xmin, ymin, xmax, ymax );
+  return QgsGeometryKernels::boundingBox( mX.constData(), mY.constData(), mX.size() );
 }
 
 /***************************************************************************
@@ -322,16 +304,7 @@ QString QgsLineString::asJSON( int precision ) const
 
 double QgsLineString::length() const
 {
-  double length = 0;
-  int size = mX.size();
-  double dx, dy;
-  for ( int i = 1; i < size; ++i )
-  {
-    dx = mX.at( i ) - mX.at( i - 1 );
-    dy = mY.at( i ) - mY.at( i - 1 );
-    length += std::sqrt( dx * dx + dy * dy );
-  }
-  return length;
+  return QgsGeometryKernels::length( mX.constData(), mY.constData(), mX.size() );
 }
 
 QgsPoint QgsLineString::startPoint() const
@@ -634,6 +607,11 @@ QgsLineString *QgsLineString::reversed() const
  * See details in QEP #17
  ****************************************************************************/
 
+QPolygonF QgsLineString::asQPolygonF() const
+{
+  return QgsGeometryKernels::toPolygon( mX.constData(), mY.constData(), mX.size() );
+}
+
 void QgsLineString::draw( QPainter &p ) const
 {
   p.drawPolyline( asQPolygonF() );
@@ -727,14 +705,7 @@ void QgsLineString::transform( const QgsCoordinateTransform &ct, QgsCoordinateTr
 
 void QgsLineString::transform( const QTransform &t )
 {
-  int nPoints = numPoints();
-  for ( int i = 0; i < nPoints; ++i )
-  {
-    qreal x, y;
-    t.map( mX.at( i ), mY.at( i ), &x, &y );
-    mX[i] = x;
-    mY[i] = y;
-  }
+  QgsGeometryKernels::transform( mX.data(), mY.data(), mX.size(), t );
   clearCache();
 }
 
@@ -97,6 +97,27 @@ class CORE_EXPORT QgsLineString: public QgsCurve
      */
     double mAt( int index ) const;
 
+#ifndef SIP_RUN
+
+    /**
+     * Returns a const pointer to the x-coordinates of the line string, which
+     * stays valid until the line string is modified.
+     * \see yData()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    const double *xData() const SIP_SKIP { return mX.constData(); }
+
+    /**
+     * Returns a const pointer to the y-coordinates of the line string, which
+     * stays valid until the line string is modified.
+     * \see xData()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    const double *yData() const SIP_SKIP { return mY.constData(); }
+#endif
+
     /** Sets the x-coordinate of the specified node in the line string.
      * \param index index of node, where the first node in the line is 0. Corresponding
      * node must already exist in line string.
@@ -191,6 +212,7 @@ class CORE_EXPORT QgsLineString: public QgsCurve
     int numPoints() const override;
     virtual int nCoordinates() const override { return mX.size(); }
     void points( QgsPointSequence &pt SIP_OUT ) const override;
+    QPolygonF asQPolygonF() const override;
 
     void draw( QPainter &p ) const override;
 
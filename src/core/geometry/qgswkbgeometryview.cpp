@@ -0,0 +1,467 @@
+/***************************************************************************
+  qgswkbgeometryview.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgswkbgeometryview.h"
+#include "qgswkbptr.h"
+
+#include <cmath>
+#include <limits>
+
+///@cond PRIVATE
+
+namespace
+{
+  const int HEADER_SIZE = 1 + sizeof( int );
+
+  /**
+   * Reads the header of a geometry. Returns QgsWkbTypes::Unknown if the byte order
+   * is not valid, and clears \a nativeByteOrder if it is not the one of the machine.
+   */
+  QgsWkbTypes::Type readHeader( QgsConstWkbPtr &wkbPtr, bool &nativeByteOrder )
+  {
+    if ( wkbPtr.remaining() < HEADER_SIZE )
+      return QgsWkbTypes::Unknown;
+
+    const unsigned char byteOrder = *static_cast< const unsigned char * >( wkbPtr );
+    if ( byteOrder != QgsApplication::XDR && byteOrder != QgsApplication::NDR )
+      return QgsWkbTypes::Unknown;
+    nativeByteOrder = nativeByteOrder && byteOrder == QgsApplication::endian();
+
+    return wkbPtr.readHeader();
+  }
+
+  //! Skips \a count points of \a pointSize bytes, returns false if the WKB is too short
+  bool skipPoints( QgsConstWkbPtr &wkbPtr, int count, int pointSize )
+  {
+    if ( count < 0 || count > wkbPtr.remaining() / pointSize )
+      return false;
+
+    wkbPtr += count * pointSize;
+    return true;
+  }
+
+  /**
+   * Skips the coordinates of a point, line string or polygon of \a type, following its header.
+   * Sets \a count to the number of points of a line string or the number of rings of a polygon,
+   * and \a empty to whether the geometry is empty. Returns false if the WKB is not valid.
+   */
+  bool skipSingleGeometry( QgsConstWkbPtr &wkbPtr, QgsWkbTypes::Type type, int &count, bool &empty )
+  {
+    const int pointSize = QgsWkbTypes::coordDimensions( type ) * sizeof( double );
+    switch ( QgsWkbTypes::flatType( type ) )
+    {
+      case QgsWkbTypes::Point:
+        count = 1;
+        empty = false;
+        return skipPoints( wkbPtr, 1, pointSize );
+
+      case QgsWkbTypes::LineString:
+        wkbPtr >> count;
+        empty = count == 0;
+        return skipPoints( wkbPtr, count, pointSize );
+
+      case QgsWkbTypes::Polygon:
+      {
+        wkbPtr >> count;
+        if ( count < 0 || count > wkbPtr.remaining() / static_cast< int >( sizeof( int ) ) )
+          return false;
+
+        empty = true;
+        for ( int i = 0; i < count; ++i )
+        {
+          int nPoints;
+          wkbPtr >> nPoints;
+          if ( i == 0 )
+            empty = nPoints == 0;
+          if ( !skipPoints( wkbPtr, nPoints, pointSize ) )
+            return false;
+        }
+        return true;
+      }
+
+      default:
+        return false;
+    }
+  }
+
+  //! Returns the bounding box of the points following \a wkbPtr, as QgsLineString::boundingBox()
+  QgsRectangle pointsBoundingBox( QgsConstWkbPtr &wkbPtr, int skipZM )
+  {
+    double xmin = std::numeric_limits<double>::max();
+    double ymin = std::numeric_limits<double>::max();
+    double xmax = -std::numeric_limits<double>::max();
+    double ymax = -std::numeric_limits<double>::max();
+
+    int count;
+    wkbPtr >> count;
+    for ( int i = 0; i < count; ++i )
+    {
+      double x, y;
+      wkbPtr >> x >> y;
+      wkbPtr += skipZM;
+      xmin = x < xmin ? x : xmin;
+      xmax = x > xmax ? x : xmax;
+      ymin = y < ymin ? y : ymin;
+      ymax = y > ymax ? y : ymax;
+    }
+    return QgsRectangle( xmin, ymin, xmax, ymax );
+  }
+
+  //! Sums of the parts of a geometry, from which its centroid is computed
+  struct CentroidSums
+  {
+    bool hasAreaBase = false;
+    double areaBaseX = 0;
+    double areaBaseY = 0;
+    double area2 = 0;
+    double areaX3 = 0;
+    double areaY3 = 0;
+    double length = 0;
+    double lineX = 0;
+    double lineY = 0;
+    int pointCount = 0;
+    double pointX = 0;
+    double pointY = 0;
+
+    void addPoint( double x, double y )
+    {
+      pointCount++;
+      pointX += x;
+      pointY += y;
+    }
+  };
+
+  enum PointsType
+  {
+    Line,
+    Shell,
+    Hole,
+  };
+
+  /**
+   * Adds the points following \a wkbPtr to the centroid sums. The triangles of rings are
+   * added with the signs used by GEOS, so that holes are subtracted from the shells.
+   */
+  void addPoints( QgsConstWkbPtr &wkbPtr, int skipZM, PointsType type, CentroidSums &sums )
+  {
+    int count;
+    wkbPtr >> count;
+
+    double x0 = 0, y0 = 0, prevX = 0, prevY = 0;
+    double area2 = 0, areaX3 = 0, areaY3 = 0;
+    double length = 0, lineX = 0, lineY = 0;
+    for ( int i = 0; i < count; ++i )
+    {
+      double x, y;
+      wkbPtr >> x >> y;
+      wkbPtr += skipZM;
+
+      if ( i == 0 )
+      {
+        x0 = x;
+        y0 = y;
+        if ( type == Shell && !sums.hasAreaBase )
+        {
+          sums.hasAreaBase = true;
+          sums.areaBaseX = x;
+          sums.areaBaseY = y;
+        }
+      }
+      else
+      {
+        if ( type != Line )
+        {
+          const double bx = sums.areaBaseX;
+          const double by = sums.areaBaseY;
+          const double triangleArea2 = ( prevX - bx ) * ( y - by ) - ( x - bx ) * ( prevY - by );
+          area2 += triangleArea2;
+          areaX3 += triangleArea2 * ( bx + prevX + x );
+          areaY3 += triangleArea2 * ( by + prevY + y );
+        }
+
+        const double segmentLength = std::sqrt( ( x - prevX ) * ( x - prevX ) + ( y - prevY ) * ( y - prevY ) );
+        if ( segmentLength > 0 )
+        {
+          length += segmentLength;
+          lineX += segmentLength * ( prevX + x ) / 2;
+          lineY += segmentLength * ( prevY + y ) / 2;
+        }
+      }
+      prevX = x;
+      prevY = y;
+    }
+
+    if ( type != Line )
+    {
+      // the sum of the triangles is twice the signed area of the ring, which is positive for counter clockwise rings
+      const bool counterClockwise = area2 > 0;
+      const double sign = ( type == Shell ) != counterClockwise ? 1 : -1;
+      sums.area2 += sign * area2;
+      sums.areaX3 += sign * areaX3;
+      sums.areaY3 += sign * areaY3;
+    }
+
+    sums.length += length;
+    sums.lineX += lineX;
+    sums.lineY += lineY;
+    if ( length == 0 && count > 0 )
+      sums.addPoint( x0, y0 );
+  }
+}
+
+///@endcond
+
+QgsWkbGeometryView::QgsWkbGeometryView( const QByteArray &wkb )
+{
+  bool nativeByteOrder = true;
+  bool empty = true;
+  int partCount = 0;
+  QVector< int > partOffsets;
+  int size = 0;
+
+  try
+  {
+    QgsConstWkbPtr wkbPtr( wkb );
+    const unsigned char *start = wkbPtr;
+
+    const QgsWkbTypes::Type type = readHeader( wkbPtr, nativeByteOrder );
+    switch ( QgsWkbTypes::flatType( type ) )
+    {
+      case QgsWkbTypes::Point:
+      case QgsWkbTypes::LineString:
+      case QgsWkbTypes::Polygon:
+      {
+        int count = 0;
+        if ( !skipSingleGeometry( wkbPtr, type, count, empty ) )
+          return;
+        partCount = count > 0 ? 1 : 0;
+        break;
+      }
+
+      case QgsWkbTypes::MultiPoint:
+      case QgsWkbTypes::MultiLineString:
+      case QgsWkbTypes::MultiPolygon:
+      {
+        // parsing 2.5D collections changes their type to the Z type
+        if ( type == QgsWkbTypes::MultiPoint25D || type == QgsWkbTypes::MultiLineString25D || type == QgsWkbTypes::MultiPolygon25D )
+          return;
+
+        wkbPtr >> partCount;
+        if ( partCount < 0 || partCount > wkbPtr.remaining() / HEADER_SIZE )
+          return;
+
+        // parts of other dimensions would change the type of the collection too
+        const QgsWkbTypes::Type partType = QgsWkbTypes::singleType( type );
+        partOffsets.reserve( partCount );
+        for ( int i = 0; i < partCount; ++i )
+        {
+          partOffsets << static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - start );
+          if ( readHeader( wkbPtr, nativeByteOrder ) != partType )
+            return;
+
+          int count = 0;
+          bool partEmpty = true;
+          if ( !skipSingleGeometry( wkbPtr, partType, count, partEmpty ) )
+            return;
+          empty = empty && partEmpty;
+        }
+        break;
+      }
+
+      default:
+        return;
+    }
+
+    mWkbType = type;
+    size = static_cast< int >( static_cast< const unsigned char * >( wkbPtr ) - start );
+  }
+  catch ( const QgsWkbException &e )
+  {
+    Q_UNUSED( e );
+    return;
+  }
+
+  mWkb = wkb;
+  mSize = size;
+  mNativeByteOrder = nativeByteOrder;
+  mEmpty = empty;
+  mPartCount = partCount;
+  mPartOffsets = partOffsets;
+}
+
+QgsRectangle QgsWkbGeometryView::boundingBox() const
+{
+  if ( !isValid() )
+    return QgsRectangle();
+
+  const bool multi = QgsWkbTypes::isMultiType( mWkbType );
+  const int nParts = multi ? mPartOffsets.size() : 1;
+  if ( nParts == 0 )
+    return QgsRectangle();
+
+  QgsRectangle bbox;
+  for ( int part = 0; part < nParts; ++part )
+  {
+    const int offset = multi ? mPartOffsets.at( part ) : 0;
+    QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + offset, mSize - offset );
+    const QgsWkbTypes::Type type = wkbPtr.readHeader();
+    const int skipZM = ( QgsWkbTypes::coordDimensions( type ) - 2 ) * sizeof( double );
+
+    QgsRectangle partBox;
+    switch ( QgsWkbTypes::flatType( type ) )
+    {
+      case QgsWkbTypes::Point:
+      {
+        double x, y;
+        wkbPtr >> x >> y;
+        partBox = QgsRectangle( x, y, x, y );
+        break;
+      }
+
+      case QgsWkbTypes::LineString:
+        partBox = pointsBoundingBox( wkbPtr, skipZM );
+        break;
+
+      case QgsWkbTypes::Polygon:
+      {
+        // the bounding box of a polygon is the one of its exterior ring
+        int nRings;
+        wkbPtr >> nRings;
+        if ( nRings > 0 )
+          partBox = pointsBoundingBox( wkbPtr, skipZM );
+        break;
+      }
+
+      default:
+        break;
+    }
+
+    if ( part == 0 )
+      bbox = partBox;
+    else
+      bbox.combineExtentWith( partBox );
+  }
+  return bbox;
+}
+
+QgsPointXY QgsWkbGeometryView::centroid() const
+{
+  if ( !isValid() )
+    return QgsPointXY();
+
+  const bool multi = QgsWkbTypes::isMultiType( mWkbType );
+  const int nParts = multi ? mPartOffsets.size() : 1;
+
+  CentroidSums sums;
+  for ( int part = 0; part < nParts; ++part )
+  {
+    const int offset = multi ? mPartOffsets.at( part ) : 0;
+    QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + offset, mSize - offset );
+    const QgsWkbTypes::Type type = wkbPtr.readHeader();
+    const int skipZM = ( QgsWkbTypes::coordDimensions( type ) - 2 ) * sizeof( double );
+
+    switch ( QgsWkbTypes::flatType( type ) )
+    {
+      case QgsWkbTypes::Point:
+      {
+        double x, y;
+        wkbPtr >> x >> y;
+        sums.addPoint( x, y );
+        break;
+      }
+
+      case QgsWkbTypes::LineString:
+        addPoints( wkbPtr, skipZM, Line, sums );
+        break;
+
+      case QgsWkbTypes::Polygon:
+      {
+        int nRings;
+        wkbPtr >> nRings;
+        for ( int i = 0; i < nRings; ++i )
+        {
+          if ( i == 0 )
+          {
+            // as GEOS, empty polygons are skipped
+            int nPoints;
+            wkbPtr >> nPoints;
+            wkbPtr -= sizeof( int );
+            if ( nPoints == 0 )
+              break;
+          }
+          addPoints( wkbPtr, skipZM, i == 0 ? Shell : Hole, sums );
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+  if ( sums.area2 != 0 )
+    return QgsPointXY( sums.areaX3 / 3 / sums.area2, sums.areaY3 / 3 / sums.area2 );
+  else if ( sums.length > 0 )
+    return QgsPointXY( sums.lineX / sums.length, sums.lineY / sums.length );
+  else if ( sums.pointCount > 0 )
+    return QgsPointXY( sums.pointX / sums.pointCount, sums.pointY / sums.pointCount );
+  return QgsPointXY();
+}
+
+void QgsWkbGeometryView::partRings( int part, QList< QPolygonF > &rings ) const
+{
+  rings.clear();
+
+  if ( !isValid() || part < 0 || part >= mPartCount )
+    return;
+
+  const int offset = QgsWkbTypes::isMultiType( mWkbType ) ? mPartOffsets.at( part ) : 0;
+  QgsConstWkbPtr wkbPtr( reinterpret_cast< const unsigned char * >( mWkb.constData() ) + offset, mSize - offset );
+  const QgsWkbTypes::Type type = wkbPtr.readHeader();
+  switch ( QgsWkbTypes::flatType( type ) )
+  {
+    case QgsWkbTypes::Point:
+    {
+      QPointF point;
+      wkbPtr >> point;
+      rings << ( QPolygonF() << point );
+      break;
+    }
+
+    case QgsWkbTypes::LineString:
+    {
+      QPolygonF points;
+      wkbPtr >> points;
+      rings << points;
+      break;
+    }
+
+    case QgsWkbTypes::Polygon:
+    {
+      int nRings;
+      wkbPtr >> nRings;
+      rings.reserve( nRings );
+      for ( int i = 0; i < nRings; ++i )
+      {
+        QPolygonF ring;
+        wkbPtr >> ring;
+        rings << ring;
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
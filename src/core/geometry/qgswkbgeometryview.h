@@ -0,0 +1,114 @@
+/***************************************************************************
+  qgswkbgeometryview.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSWKBGEOMETRYVIEW_H
+#define QGSWKBGEOMETRYVIEW_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgspointxy.h"
+#include "qgsrectangle.h"
+#include "qgswkbtypes.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QPolygonF>
+#include <QVector>
+
+/**
+ * \ingroup core
+ * \brief A read only view of a geometry stored as WKB.
+ *
+ * The view answers the questions asked while rendering a geometry, such as its type,
+ * bounding box and vertices, straight from the WKB and without building a QgsAbstractGeometry.
+ * The WKB is shared with the view, not copied.
+ *
+ * Only linear geometries, i.e. points, line strings and polygons and their multi part
+ * types, can be viewed. The WKB is checked once when the view is created, and the view
+ * is invalid if the WKB is truncated, holds any other type of geometry, or is of a
+ * type which would be changed when parsed into a QgsAbstractGeometry (like multi part
+ * geometries with parts of different dimensions).
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsWkbGeometryView
+{
+  public:
+
+    //! Constructor for an invalid view
+    QgsWkbGeometryView() = default;
+
+    //! Constructor for a view of the geometry stored in \a wkb
+    explicit QgsWkbGeometryView( const QByteArray &wkb );
+
+    //! Returns true if the WKB holds a geometry which can be viewed
+    bool isValid() const { return mSize > 0; }
+
+    /**
+     * Returns the viewed WKB. It may be followed by bytes which are not part
+     * of the geometry.
+     * \see wkbSize()
+     */
+    QByteArray wkb() const { return mWkb; }
+
+    //! Returns the number of bytes of the geometry in the WKB
+    int wkbSize() const { return mSize; }
+
+    //! Returns true if the WKB is stored in the byte order of the machine
+    bool hasNativeByteOrder() const { return mNativeByteOrder; }
+
+    //! Returns the WKB type of the geometry
+    QgsWkbTypes::Type wkbType() const { return mWkbType; }
+
+    //! Returns the number of parts of the geometry, as QgsAbstractGeometry::partCount()
+    int partCount() const { return mPartCount; }
+
+    //! Returns true if the geometry is empty, as QgsAbstractGeometry::isEmpty()
+    bool isEmpty() const { return mEmpty; }
+
+    //! Returns the bounding box of the geometry, as QgsAbstractGeometry::boundingBox()
+    QgsRectangle boundingBox() const;
+
+    /**
+     * Returns the centroid of the geometry, computed as by GEOS: the area weighted centroid of
+     * the polygons, or if they have no area the length weighted centroid of the lines, or else
+     * the average of the points. Returns a point at the origin for empty geometries.
+     */
+    QgsPointXY centroid() const;
+
+    /**
+     * Reads the vertices of a \a part of the geometry into \a rings. Each ring of a polygon
+     * is read into its own QPolygonF, starting with the exterior ring, while a line string
+     * or a point is read into a single QPolygonF. Z and M values are skipped.
+     * \see partCount()
+     */
+    void partRings( int part, QList< QPolygonF > &rings ) const;
+
+  private:
+
+    QByteArray mWkb;
+    int mSize = 0;
+    QgsWkbTypes::Type mWkbType = QgsWkbTypes::Unknown;
+    bool mNativeByteOrder = true;
+    bool mEmpty = true;
+    int mPartCount = 0;
+
+    //! Offsets of the parts of multi part geometries in the WKB
+    QVector< int > mPartOffsets;
+
+};
+
+#endif // QGSWKBGEOMETRYVIEW_H
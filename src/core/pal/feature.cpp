@@ -429,6 +429,23 @@ int FeaturePart::createCandidatesAtOrderedPositionsOverPoint( double x, double y
   return lPos.count();
 }
 
+int FeaturePart::createCandidateFromCache( QList<LabelPosition *> &lPos, double bbox[4] )
+{
+  const QgsLabelCache::Placement &placement = mLF->cachedPlacement();
+  LabelPosition *lp = new LabelPosition( 0, placement.position.x(), placement.position.y(), getLabelWidth(), getLabelHeight(),
+                                         placement.angle, 0.0, this, placement.reversed, static_cast< LabelPosition::Quadrant >( placement.quadrant ) );
+
+  bool inside = mLF->layer()->pal->getShowPartial() ? lp->isIntersect( bbox ) : lp->isInside( bbox );
+  if ( !inside )
+  {
+    delete lp;
+    return 0;
+  }
+
+  lPos << lp;
+  return 1;
+}
+
 int FeaturePart::createCandidatesAroundPoint( double x, double y, QList< LabelPosition * > &lPos, double angle )
 {
   double labelWidth = getLabelWidth();
@@ -1531,6 +1548,10 @@ int FeaturePart::createCandidates( QList< LabelPosition *> &lPos,
   {
     lPos << new LabelPosition( 0, mLF->fixedPosition().x(), mLF->fixedPosition().y(), getLabelWidth(), getLabelHeight(), angle, 0.0, this );
   }
+  else if ( mLF->hasCachedPlacement() && createCandidateFromCache( lPos, bbox ) > 0 )
+  {
+    // the label keeps its placement from the previous solution
+  }
   else
   {
     switch ( type )
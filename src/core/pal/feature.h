@@ -131,6 +131,14 @@ namespace pal
        */
       int createCandidates( QList<LabelPosition *> &lPos, double bboxMin[2], double bboxMax[2], PointSet *mapShape, RTree<LabelPosition *, double, 2, double> *candidates );
 
+      /** Generate the single candidate of a label keeping its placement from a previous
+       * labeling solution (see QgsLabelFeature::cachedPlacement()).
+       * \param lPos pointer to an array of candidates, will be filled by generated candidate
+       * \param bbox map extent
+       * \returns the number of generated candidates, 0 if the cached placement is outside of the map extent
+       */
+      int createCandidateFromCache( QList<LabelPosition *> &lPos, double bbox[4] );
+
       /** Generate candidates for point feature, located around a specified point.
        * \param x x coordinate of the point
        * \param y y coordinate of the point
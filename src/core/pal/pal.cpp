@@ -247,6 +247,7 @@ Problem *Pal::extract( double lambda_min, double phi_min, double lambda_max, dou
   bby[2] = bby[3] = amax[1] = prob->bbox[3] = phi_max;
 
   prob->pal = this;
+  prob->mSplitComponents = splitProblems;
 
   QLinkedList<Feats *> *fFeats = new QLinkedList<Feats *>;
 
@@ -626,6 +627,16 @@ bool Pal::getShowPartial()
   return showPartial;
 }
 
+void Pal::setSplitProblems( bool split )
+{
+  splitProblems = split;
+}
+
+bool Pal::getSplitProblems()
+{
+  return splitProblems;
+}
+
 SearchMethod Pal::getSearch()
 {
   return searchMethod;
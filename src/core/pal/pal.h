@@ -167,6 +167,21 @@ namespace pal
        */
       bool getShowPartial();
 
+      /**
+       * \brief Set flag to solve the independent sub problems of the
+       * extracted problems concurrently
+       *
+       * \param split flag value
+       */
+      void setSplitProblems( bool split );
+
+      /**
+       * \brief Get flag to solve independent sub problems concurrently
+       *
+       * \returns value of flag
+       */
+      bool getSplitProblems();
+
       /**
        * \brief set # candidates to generate for points features
        * Higher the value is, longer Pal::labeller will spend time
@@ -263,6 +278,9 @@ namespace pal
        */
       bool showPartial;
 
+      //! Solve the independent sub problems concurrently, see Problem::solveComponents()
+      bool splitProblems = false;
+
       //! Callback that may be called from PAL to check whether the job has not been canceled in meanwhile
       FnIsCanceled fnIsCanceled;
       //! Application-specific context for the cancelation check function
@@ -36,6 +36,11 @@ pal::PalStat::PalStat()
   nbLabelledObjects = 0;
   layersNbObjects = nullptr;
   layersNbLabelledObjects = nullptr;
+  nbComponents = 0;
+  largestComponentSize = 0;
+  nbSubProblems = 0;
+  solvingTime = 0.0;
+  subProblemsTime = 0.0;
 }
 
 pal::PalStat::~PalStat()
@@ -83,3 +88,27 @@ int pal::PalStat::getLayerNbLabelledObjects( int layerId )
     return -1;
 }
 
+int pal::PalStat::getNbComponents()
+{
+  return nbComponents;
+}
+
+int pal::PalStat::getLargestComponentSize()
+{
+  return largestComponentSize;
+}
+
+int pal::PalStat::getNbSubProblems()
+{
+  return nbSubProblems;
+}
+
+double pal::PalStat::getSolvingTime()
+{
+  return solvingTime;
+}
+
+double pal::PalStat::getSubProblemsTime()
+{
+  return subProblemsTime;
+}
@@ -89,6 +89,38 @@ namespace pal
        */
       int getLayerNbLabelledObjects( int layerId );
 
+      /**
+       * \brief the number of independent connected components of the candidates overlap graph
+       * \since QGIS 3.0
+       */
+      int getNbComponents();
+
+      /**
+       * \brief the number of features in the largest component
+       * \since QGIS 3.0
+       */
+      int getLargestComponentSize();
+
+      /**
+       * \brief the number of sub problems which were solved concurrently
+       * \since QGIS 3.0
+       */
+      int getNbSubProblems();
+
+      /**
+       * \brief the wall clock time spent solving the problem, in milliseconds
+       * \since QGIS 3.0
+       */
+      double getSolvingTime();
+
+      /**
+       * \brief the time spent solving the sub problems summed over all the threads, in milliseconds
+       *
+       * Its ratio to getSolvingTime() is the speedup of the concurrent solver.
+       * \since QGIS 3.0
+       */
+      double getSubProblemsTime();
+
     private:
       int nbObjects;
       int nbLabelledObjects;
@@ -99,6 +131,12 @@ namespace pal
       int *layersNbObjects; // [nbLayers]
       int *layersNbLabelledObjects; // [nbLayers]
 
+      int nbComponents;
+      int largestComponentSize;
+      int nbSubProblems;
+      double solvingTime;
+      double subProblemsTime;
+
       PalStat();
 
   };
@@ -43,6 +43,9 @@
 
 #include "qgslabelingengine.h"
 
+#include <QElapsedTimer>
+#include <QtConcurrentMap>
+
 using namespace pal;
 
 inline void delete_chain( Chain *chain )
@@ -396,6 +399,12 @@ void Problem::popmusic()
   if ( nbft == 0 )
     return;
 
+  if ( mSplitComponents )
+  {
+    solveComponents( &Problem::popmusic );
+    return;
+  }
+
   int i;
   int seed;
   bool *ok = new bool[nbft];
@@ -2144,6 +2153,12 @@ void Problem::chain_search()
   if ( nbft == 0 )
     return;
 
+  if ( mSplitComponents )
+  {
+    solveComponents( &Problem::chain_search );
+    return;
+  }
+
   int i;
   int seed;
   bool *ok = new bool[nbft];
@@ -2237,6 +2252,244 @@ void Problem::chain_search()
   delete[] ok;
 }
 
+/**
+ * Minimum number of features of the groups of components solved as
+ * independent problems, smaller groups do not pay off the setup costs.
+ */
+static const int MIN_SUBPROBLEM_SIZE = 500;
+
+typedef struct
+{
+  int *parent = nullptr;
+  int feature;
+} ComponentContext;
+
+inline int componentRoot( int *parent, int feature )
+{
+  while ( parent[feature] != feature )
+  {
+    parent[feature] = parent[parent[feature]];
+    feature = parent[feature];
+  }
+  return feature;
+}
+
+bool componentCallback( LabelPosition *lp, void *ctx )
+{
+  ComponentContext *context = reinterpret_cast< ComponentContext * >( ctx );
+
+  // the search and the conflict tests only ever see overlapping bounding boxes
+  int root1 = componentRoot( context->parent, context->feature );
+  int root2 = componentRoot( context->parent, lp->getProblemFeatureId() );
+  if ( root1 < root2 )
+    context->parent[root2] = root1;
+  else if ( root2 < root1 )
+    context->parent[root1] = root2;
+
+  return true;
+}
+
+typedef struct
+{
+  Problem *problem = nullptr;
+  QVector<int> features;
+  double elapsed = 0.0;
+} SubProblem;
+
+struct SolveSubProblem
+{
+  explicit SolveSubProblem( void ( Problem::*search )() )
+    : search( search )
+  {}
+
+  typedef void result_type;
+
+  void operator()( SubProblem &subProblem )
+  {
+    QElapsedTimer timer;
+    timer.start();
+    try
+    {
+      ( subProblem.problem->*search )();
+    }
+    catch ( InternalException::Empty )
+    {
+      // the sub problem keeps its partial solution
+    }
+    subProblem.elapsed = timer.nsecsElapsed() / 1000000.0;
+  }
+
+  void ( Problem::*search )();
+};
+
+QVector< QVector<int> > Problem::componentGroups()
+{
+  QVector<int> parent( nbft );
+  for ( int i = 0; i < nbft; i++ )
+    parent[i] = i;
+
+  ComponentContext context;
+  context.parent = parent.data();
+
+  double amin[2];
+  double amax[2];
+
+  for ( int i = 0; i < nbft; i++ )
+  {
+    context.feature = i;
+    for ( int j = 0; j < featNbLp[i]; j++ )
+    {
+      mLabelPositions.at( featStartId[i] + j )->getBoundingBox( amin, amax );
+      candidates->Search( amin, amax, componentCallback, reinterpret_cast< void * >( &context ) );
+    }
+  }
+
+  // components are numbered in order of their first feature
+  QVector<int> componentId( nbft, -1 );
+  QVector< QVector<int> > components;
+  for ( int i = 0; i < nbft; i++ )
+  {
+    int root = componentRoot( parent.data(), i );
+    if ( componentId[root] < 0 )
+    {
+      componentId[root] = components.size();
+      components.append( QVector<int>() );
+    }
+    components[componentId[root]].append( i );
+  }
+
+  mNbComponents = components.size();
+  mLargestComponentSize = 0;
+
+  // pack consecutive components, so that the groups only depend on the problem
+  QVector< QVector<int> > groups;
+  QVector<int> group;
+  Q_FOREACH ( const QVector<int> &component, components )
+  {
+    mLargestComponentSize = std::max( mLargestComponentSize, component.size() );
+    group += component;
+    if ( group.size() >= MIN_SUBPROBLEM_SIZE )
+    {
+      groups.append( group );
+      group.clear();
+    }
+  }
+  if ( !group.isEmpty() )
+  {
+    if ( groups.isEmpty() )
+      groups.append( group );
+    else
+      groups.last() += group;
+  }
+
+  for ( int i = 0; i < groups.size(); i++ )
+    std::sort( groups[i].begin(), groups[i].end() );
+
+  return groups;
+}
+
+Problem *Problem::createSubProblem( const QVector<int> &features )
+{
+  Problem *subProblem = new Problem();
+  subProblem->mSplitComponents = false;
+  subProblem->pal = pal;
+  subProblem->displayAll = displayAll;
+  for ( int i = 0; i < 4; i++ )
+    subProblem->bbox[i] = bbox[i];
+
+  subProblem->nbft = features.size();
+  subProblem->featStartId = new int[subProblem->nbft];
+  subProblem->featNbLp = new int[subProblem->nbft];
+  subProblem->inactiveCost = new double[subProblem->nbft];
+
+  int lpId = 0;
+  for ( int i = 0; i < features.size(); i++ )
+  {
+    int feature = features.at( i );
+    subProblem->featStartId[i] = lpId;
+    subProblem->featNbLp[i] = featNbLp[feature];
+    subProblem->inactiveCost[i] = inactiveCost[feature];
+
+    for ( int j = 0; j < featNbLp[feature]; j++, lpId++ )
+    {
+      LabelPosition *lp = mLabelPositions.at( featStartId[feature] + j );
+      lp->setProblemIds( i, lpId );
+      lp->insertIntoIndex( subProblem->candidates );
+      subProblem->mLabelPositions.append( lp );
+    }
+  }
+
+  subProblem->nblp = lpId;
+  subProblem->all_nblp = lpId;
+  return subProblem;
+}
+
+void Problem::mergeSubProblem( Problem *subProblem, const QVector<int> &features )
+{
+  for ( int i = 0; i < features.size(); i++ )
+  {
+    int feature = features.at( i );
+    for ( int j = 0; j < featNbLp[feature]; j++ )
+    {
+      mLabelPositions.at( featStartId[feature] + j )->setProblemIds( feature, featStartId[feature] + j );
+    }
+
+    int label = subProblem->sol ? subProblem->sol->s[i] : -1;
+    if ( label >= 0 )
+    {
+      label = featStartId[feature] + label - subProblem->featStartId[i];
+      mLabelPositions.at( label )->insertIntoIndex( candidates_sol );
+    }
+    sol->s[feature] = label;
+  }
+
+  // the candidates belong to this problem
+  subProblem->mLabelPositions.clear();
+}
+
+void Problem::solveComponents( void ( Problem::*search )() )
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  mSplitComponents = false;
+
+  QVector< QVector<int> > groups = componentGroups();
+  mNbSubProblems = groups.size();
+
+  if ( groups.size() < 2 )
+  {
+    ( this->*search )();
+    mSolvingTime = timer.nsecsElapsed() / 1000000.0;
+    mSubProblemsTime = mSolvingTime;
+    return;
+  }
+
+  QList< SubProblem > subProblems;
+  Q_FOREACH ( const QVector<int> &group, groups )
+  {
+    SubProblem subProblem;
+    subProblem.features = group;
+    subProblem.problem = createSubProblem( group );
+    subProblems << subProblem;
+  }
+
+  QtConcurrent::blockingMap( subProblems, SolveSubProblem( search ) );
+
+  // merge in order of the groups, whichever thread solved them
+  init_sol_empty();
+  mSubProblemsTime = 0.0;
+  Q_FOREACH ( const SubProblem &subProblem, subProblems )
+  {
+    mergeSubProblem( subProblem.problem, subProblem.features );
+    mSubProblemsTime += subProblem.elapsed;
+    delete subProblem.problem;
+  }
+
+  solution_cost();
+  mSolvingTime = timer.nsecsElapsed() / 1000000.0;
+}
+
 bool Problem::compareLabelArea( pal::LabelPosition *l1, pal::LabelPosition *l2 )
 {
   return l1->getWidth() * l1->getHeight() > l2->getWidth() * l2->getHeight();
@@ -2285,6 +2538,12 @@ PalStat *Problem::getStats()
   stats->nbObjects = nbft;
   stats->nbLabelledObjects = 0;
 
+  stats->nbComponents = mNbComponents;
+  stats->largestComponentSize = mLargestComponentSize;
+  stats->nbSubProblems = mNbSubProblems;
+  stats->solvingTime = mSolvingTime;
+  stats->subProblemsTime = mSubProblemsTime;
+
   stats->nbLayers = nbLabelledLayers;
   stats->layersNbObjects = new int[stats->nbLayers];
   stats->layersNbLabelledObjects = new int[stats->nbLayers];
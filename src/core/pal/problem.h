@@ -36,6 +36,7 @@
 #include "qgis_core.h"
 #include <list>
 #include <QList>
+#include <QVector>
 #include "rtree.hpp"
 
 namespace pal
@@ -244,6 +245,55 @@ namespace pal
 
       int *featWrap = nullptr;
 
+      /**
+       * If true, chain_search() and popmusic() split the problem into
+       * independent sub problems through solveComponents(). The placement may
+       * then differ from the one of the search over the whole problem.
+       */
+      bool mSplitComponents = false;
+
+      //! # connected components of the candidates overlap graph
+      int mNbComponents = 0;
+      //! # features in the largest component
+      int mLargestComponentSize = 0;
+      //! # sub problems solved concurrently
+      int mNbSubProblems = 0;
+      //! wall clock time spent by the solver, in milliseconds
+      double mSolvingTime = 0.0;
+      //! time spent solving the sub problems, summed over all threads, in milliseconds
+      double mSubProblemsTime = 0.0;
+
+      /**
+       * Solves the problem with \a search, which is either chain_search()
+       * or popmusic().
+       *
+       * Features whose candidates cannot overlap never interact in the search,
+       * so the connected components of the candidates overlap graph are packed
+       * into groups which are solved concurrently on the global thread pool as
+       * independent problems. The groups only depend on the problem, and their
+       * solutions are merged in order, so that the solution does not depend on
+       * the number of threads.
+       */
+      void solveComponents( void ( Problem::*search )() );
+
+      /**
+       * Returns the groups of features, in increasing order, which can be
+       * solved as independent problems.
+       */
+      QVector< QVector<int> > componentGroups();
+
+      /**
+       * Creates a problem restricted to the given \a features. The candidates
+       * are renumbered for the sub problem but remain owned by this problem.
+       */
+      Problem *createSubProblem( const QVector<int> &features );
+
+      /**
+       * Copies the solution of a \a subProblem created from \a features into
+       * this problem and gives the candidates their original numbers back.
+       */
+      void mergeSubProblem( Problem *subProblem, const QVector<int> &features );
+
       Chain *chain( SubPart *part, int seed );
 
       Chain *chain( int seed );
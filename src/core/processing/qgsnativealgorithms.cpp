@@ -24,9 +24,20 @@
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
 #include "qgswkbtypes.h"
+#include "qgsspatialindex.h"
+#include "qgsspatialpartitions.h"
+
+#include <QThreadPool>
+#include <QtConcurrentMap>
 
 ///@cond PRIVATE
 
+//! Maximum number of input geometries kept in memory by the partitioned algorithms
+static const int MAX_PENDING_GEOMETRIES = 50000;
+
+//! Number of features buffered in parallel at once
+static const int BUFFER_CHUNK_SIZE = 1024;
+
 QgsNativeAlgorithms::QgsNativeAlgorithms( QObject *parent )
   : QgsProcessingProvider( parent )
 {}
@@ -132,6 +143,22 @@ QgsBufferAlgorithm *QgsBufferAlgorithm::createInstance() const
   return new QgsBufferAlgorithm();
 }
 
+//! Geometry of a feature to buffer, with the buffer parameters
+struct BufferTask
+{
+  QgsGeometry geometry;
+  double distance;
+  int segments;
+  QgsGeometry::EndCapStyle endCapStyle;
+  QgsGeometry::JoinStyle joinStyle;
+  double miterLimit;
+};
+
+static QgsGeometry bufferTask( const BufferTask &task )
+{
+  return task.geometry.buffer( task.distance, task.segments, task.endCapStyle, task.joinStyle, task.miterLimit );
+}
+
 QVariantMap QgsBufferAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   std::unique_ptr< QgsFeatureSource > source( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
@@ -164,6 +191,40 @@ QVariantMap QgsBufferAlgorithm::processAlgorithm( const QVariantMap &parameters,
   QList< QgsGeometry > bufferedGeometriesForDissolve;
   QgsAttributes dissolveAttrs;
 
+  // the features are read and the dynamic distances evaluated in this thread, while the
+  // buffers of each chunk of features are computed in parallel, each thread with its own
+  // GEOS context. The output is then written in the order of the source.
+  QgsFeatureList features;
+  QList< BufferTask > tasks;
+  auto bufferFeatures = [&]()
+  {
+    QList< QgsGeometry > buffers = QtConcurrent::blockingMapped( tasks, bufferTask );
+    int task = 0;
+    Q_FOREACH ( QgsFeature out, features )
+    {
+      if ( out.hasGeometry() )
+      {
+        QgsGeometry outputGeometry = buffers.at( task++ );
+        if ( !outputGeometry )
+        {
+          QgsMessageLog::logMessage( QObject::tr( "Error calculating buffer for feature %1" ).arg( out.id() ), QObject::tr( "Processing" ), QgsMessageLog::WARNING );
+        }
+        if ( dissolve )
+          bufferedGeometriesForDissolve << outputGeometry;
+        else
+          out.setGeometry( outputGeometry );
+      }
+
+      if ( !dissolve )
+        sink->addFeature( out, QgsFeatureSink::FastInsert );
+    }
+
+    current += features.size();
+    feedback->setProgress( current * step );
+    features.clear();
+    tasks.clear();
+  };
+
   while ( it.nextFeature( f ) )
   {
     if ( feedback->isCanceled() )
@@ -173,8 +234,7 @@ QVariantMap QgsBufferAlgorithm::processAlgorithm( const QVariantMap &parameters,
     if ( dissolveAttrs.isEmpty() )
       dissolveAttrs = f.attributes();
 
-    QgsFeature out = f;
-    if ( out.hasGeometry() )
+    if ( f.hasGeometry() )
     {
       if ( dynamicBuffer )
       {
@@ -182,25 +242,35 @@ QVariantMap QgsBufferAlgorithm::processAlgorithm( const QVariantMap &parameters,
         bufferDistance = QgsProcessingParameters::parameterAsDouble( distanceParamDef, parameters, context );
       }
 
-      QgsGeometry outputGeometry = f.geometry().buffer( bufferDistance, segments, endCapStyle, joinStyle, miterLimit );
-      if ( !outputGeometry )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Error calculating buffer for feature %1" ).arg( f.id() ), QObject::tr( "Processing" ), QgsMessageLog::WARNING );
-      }
-      if ( dissolve )
-        bufferedGeometriesForDissolve << outputGeometry;
-      else
-        out.setGeometry( outputGeometry );
+      BufferTask task;
+      task.geometry = f.geometry();
+      task.distance = bufferDistance;
+      task.segments = segments;
+      task.endCapStyle = endCapStyle;
+      task.joinStyle = joinStyle;
+      task.miterLimit = miterLimit;
+      tasks << task;
     }
 
-    if ( !dissolve )
-      sink->addFeature( out, QgsFeatureSink::FastInsert );
+    features << f;
+    if ( features.size() >= BUFFER_CHUNK_SIZE )
+      bufferFeatures();
+  }
 
-    feedback->setProgress( current * step );
-    current++;
+  if ( feedback->isCanceled() )
+  {
+    // the features read since the last chunk are neither buffered nor written
+    if ( !features.isEmpty() )
+      feedback->pushInfo( QObject::tr( "Buffering canceled, %1 features were read but not buffered" ).arg( features.size() ) );
+    features.clear();
+    tasks.clear();
+  }
+  else
+  {
+    bufferFeatures();
   }
 
-  if ( dissolve )
+  if ( dissolve && !feedback->isCanceled() )
   {
     QgsGeometry finalGeometry = QgsGeometry::unaryUnion( bufferedGeometriesForDissolve );
     QgsFeature f;
@@ -238,6 +308,39 @@ QgsDissolveAlgorithm *QgsDissolveAlgorithm::createInstance() const
   return new QgsDissolveAlgorithm();
 }
 
+//! Key of the geometries of a group of features within a cell of the partitions
+typedef QPair< int, int > GroupCell;
+
+/**
+ * Combines the geometries of each group within each cell, if there are several of them
+ * or if \a all is true. The unions are computed in parallel, each thread having its own
+ * GEOS context. If a union fails, the error is reported to \a feedback and the geometries
+ * are kept uncombined.
+ */
+static void combineGeometries( QMap< GroupCell, QList< QgsGeometry > > &geometries, bool all, QgsProcessingFeedback *feedback )
+{
+  QList< GroupCell > keys;
+  QList< QList< QgsGeometry > > lists;
+  for ( auto it = geometries.constBegin(); it != geometries.constEnd(); ++it )
+  {
+    if ( all || it.value().size() > 1 )
+    {
+      keys << it.key();
+      lists << it.value();
+    }
+  }
+
+  QList< QgsGeometry > unions = QtConcurrent::blockingMapped( lists, QgsGeometry::unaryUnion );
+
+  for ( int i = 0; i < keys.size(); ++i )
+  {
+    if ( unions.at( i ).isNull() )
+      feedback->reportError( QObject::tr( "Error combining %1 geometries, they are kept separate" ).arg( lists.at( i ).size() ) );
+    else
+      geometries[ keys.at( i ) ] = QList< QgsGeometry >() << unions.at( i );
+  }
+}
+
 QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   std::unique_ptr< QgsFeatureSource > source( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
@@ -252,6 +355,14 @@ QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameter
 
   QStringList fields = parameterAsFields( parameters, QStringLiteral( "FIELD" ), context );
 
+  QList< int > fieldIndexes;
+  Q_FOREACH ( const QString &field, fields )
+  {
+    int index = source->fields().lookupField( field );
+    if ( index >= 0 )
+      fieldIndexes << index;
+  }
+
   long count = source->featureCount();
 
   QgsFeature f;
@@ -260,109 +371,105 @@ QVariantMap QgsDissolveAlgorithm::processAlgorithm( const QVariantMap &parameter
   double step = count > 0 ? 100.0 / count : 1;
   int current = 0;
 
-  if ( fields.isEmpty() )
+  // the features are assigned to the cells of a grid, and the geometries of each group
+  // within each cell are combined whenever too many geometries are kept in memory. The
+  // cells are then merged four by four, until the whole extent is covered by one cell.
+  QgsSpatialPartitions partitions( source->sourceExtent(), QThreadPool::globalInstance()->maxThreadCount() );
+
+  // attributes of the first feature of each group
+  QList< QgsAttributes > groupAttributes;
+  QHash< QVariant, int > groupIndexes;
+  // sorted, so that the geometries are combined in the same order on each run
+  QMap< GroupCell, QList< QgsGeometry > > geometries;
+  int pendingGeometries = 0;
+
+  while ( it.nextFeature( f ) )
   {
-    // dissolve all - not using fields
-    bool firstFeature = true;
-    // we dissolve geometries in blocks using unaryUnion
-    QList< QgsGeometry > geomQueue;
-    QgsFeature outputFeature;
+    if ( feedback->isCanceled() )
+    {
+      break;
+    }
 
-    while ( it.nextFeature( f ) )
+    int group = 0;
+    if ( fieldIndexes.isEmpty() )
     {
-      if ( feedback->isCanceled() )
+      // dissolve all - not using fields
+      if ( groupAttributes.isEmpty() )
+        groupAttributes << f.attributes();
+    }
+    else
+    {
+      QVariantList indexAttributes;
+      Q_FOREACH ( int index, fieldIndexes )
       {
-        break;
+        indexAttributes << f.attribute( index );
       }
 
-      if ( firstFeature )
+      group = groupIndexes.value( indexAttributes, -1 );
+      if ( group < 0 )
       {
-        outputFeature = f;
-        firstFeature = false;
+        group = groupAttributes.size();
+        groupIndexes.insert( indexAttributes, group );
+        groupAttributes << f.attributes();
       }
+    }
 
-      if ( f.hasGeometry() && f.geometry() )
+    if ( f.hasGeometry() && f.geometry() )
+    {
+      geometries[ qMakePair( group, partitions.cell( f.geometry().boundingBox() ) ) ].append( f.geometry() );
+      if ( ++pendingGeometries >= MAX_PENDING_GEOMETRIES )
       {
-        geomQueue.append( f.geometry() );
-        if ( geomQueue.length() > 10000 )
-        {
-          // queue too long, combine it
-          QgsGeometry tempOutputGeometry = QgsGeometry::unaryUnion( geomQueue );
-          geomQueue.clear();
-          geomQueue << tempOutputGeometry;
-        }
+        combineGeometries( geometries, false, feedback );
+        pendingGeometries = 0;
       }
-
-      feedback->setProgress( current * step );
-      current++;
     }
 
-    outputFeature.setGeometry( QgsGeometry::unaryUnion( geomQueue ) );
-    sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+    feedback->setProgress( current * step );
+    current++;
   }
-  else
+
+  // cascaded merge of the cells
+  combineGeometries( geometries, false, feedback );
+  for ( int size = partitions.size(); size > 1 && !feedback->isCanceled(); size /= 2 )
   {
-    QList< int > fieldIndexes;
-    Q_FOREACH ( const QString &field, fields )
+    QMap< GroupCell, QList< QgsGeometry > > parentGeometries;
+    for ( auto geomIt = geometries.constBegin(); geomIt != geometries.constEnd(); ++geomIt )
     {
-      int index = source->fields().lookupField( field );
-      if ( index >= 0 )
-        fieldIndexes << index;
+      parentGeometries[ qMakePair( geomIt.key().first, QgsSpatialPartitions::parentCell( geomIt.key().second, size ) ) ] << geomIt.value();
     }
+    geometries = parentGeometries;
+    // the unions of the last level are also computed for single geometries, as they are
+    // modified by the union (e.g. lines are split at their intersections)
+    combineGeometries( geometries, size == 2, feedback );
+  }
 
-    QHash< QVariant, QgsAttributes > attributeHash;
-    QHash< QVariant, QList< QgsGeometry > > geometryHash;
+  if ( fieldIndexes.isEmpty() && groupAttributes.isEmpty() )
+  {
+    // empty source
+    groupAttributes << QgsAttributes();
+  }
 
-    while ( it.nextFeature( f ) )
+  for ( int group = 0; group < groupAttributes.size(); ++group )
+  {
+    if ( feedback->isCanceled() )
     {
-      if ( feedback->isCanceled() )
-      {
-        break;
-      }
-
-      QVariantList indexAttributes;
-      Q_FOREACH ( int index, fieldIndexes )
-      {
-        indexAttributes << f.attribute( index );
-      }
-
-      if ( !attributeHash.contains( indexAttributes ) )
-      {
-        // keep attributes of first feature
-        attributeHash.insert( indexAttributes, f.attributes() );
-      }
-
-      if ( f.hasGeometry() && f.geometry() )
-      {
-        geometryHash[ indexAttributes ].append( f.geometry() );
-      }
+      break;
     }
 
-    int numberFeatures = attributeHash.count();
-    QHash< QVariant, QgsAttributes >::const_iterator attrIt = attributeHash.constBegin();
-    for ( ; attrIt != attributeHash.constEnd(); ++attrIt )
+    QgsFeature outputFeature;
+    // several geometries are left if their union failed
+    const QList< QgsGeometry > groupGeometries = geometries.value( qMakePair( group, 0 ) );
+    QgsGeometry geom = groupGeometries.size() > 1 ? QgsGeometry::collectGeometry( groupGeometries ) : groupGeometries.value( 0 );
+    if ( !geom.isNull() )
     {
-      if ( feedback->isCanceled() )
-      {
-        break;
-      }
-
-      QgsFeature outputFeature;
-      if ( geometryHash.contains( attrIt.key() ) )
+      if ( !fieldIndexes.isEmpty() && !geom.isMultipart() )
       {
-        QgsGeometry geom = QgsGeometry::unaryUnion( geometryHash.value( attrIt.key() ) );
-        if ( !geom.isMultipart() )
-        {
-          geom.convertToMultiType();
-        }
-        outputFeature.setGeometry( geom );
+        geom.convertToMultiType();
       }
-      outputFeature.setAttributes( attrIt.value() );
-      sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
-
-      feedback->setProgress( current * 100.0 / numberFeatures );
-      current++;
+      outputFeature.setGeometry( geom );
     }
+    outputFeature.setAttributes( groupAttributes.at( group ) );
+    sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
   }
 
   QVariantMap outputs;
@@ -392,6 +499,100 @@ QgsClipAlgorithm *QgsClipAlgorithm::createInstance() const
   return new QgsClipAlgorithm();
 }
 
+/**
+ * Clips \a geometries, which are all within \a extent, with the union of the \a mask
+ * geometries. The mask is intersected with the extent and prepared once for all the
+ * geometries.
+ *
+ * Returns the clipped geometries, in the order of \a geometries. Geometries outside of
+ * the mask are returned as null geometries, as those which could not be clipped. The
+ * indexes of the latter are added to \a failures.
+ */
+static QList< QgsGeometry > clipGeometries( const QList< QgsGeometry > &mask, const QgsRectangle &extent, const QList< QgsGeometry > &geometries, QList< int > *failures )
+{
+  QList< QgsGeometry > results;
+  if ( mask.isEmpty() )
+  {
+    // no mask around the geometries
+    for ( int i = 0; i < geometries.size(); ++i )
+      results << QgsGeometry();
+    return results;
+  }
+
+  // only the part of the mask around the geometries is needed. The extent is slightly
+  // enlarged, so that the boundary of the clipped mask does not touch the geometries.
+  QgsRectangle maskExtent = extent;
+  double margin = 0.01 * ( extent.width() + extent.height() );
+  maskExtent.grow( margin > 0 ? margin : 1 );
+  QgsGeometry combinedClipGeom = QgsGeometry::unaryUnion( mask ).intersection( QgsGeometry::fromRect( maskExtent ) );
+  if ( combinedClipGeom.isNull() )
+  {
+    // the geometries cannot be clipped without the mask
+    for ( int i = 0; i < geometries.size(); ++i )
+    {
+      results << QgsGeometry();
+      if ( failures )
+        *failures << i;
+    }
+    return results;
+  }
+
+  // use prepared geometries for faster intersection tests
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( combinedClipGeom.geometry() ) );
+  engine->prepareGeometry();
+
+  for ( int i = 0; i < geometries.size(); ++i )
+  {
+    const QgsGeometry &geometry = geometries.at( i );
+    if ( !engine->intersects( geometry.geometry() ) )
+    {
+      results << QgsGeometry();
+    }
+    else if ( engine->contains( geometry.geometry() ) )
+    {
+      // clip geometry totally contains feature geometry, so no need to perform intersection
+      results << geometry;
+    }
+    else
+    {
+      QgsGeometry newGeometry = combinedClipGeom.intersection( geometry );
+      if ( newGeometry.wkbType() == QgsWkbTypes::Unknown || QgsWkbTypes::flatType( newGeometry.geometry()->wkbType() ) == QgsWkbTypes::GeometryCollection )
+      {
+        QgsGeometry intCom = geometry.combine( newGeometry );
+        QgsGeometry intSym = geometry.symDifference( newGeometry );
+        newGeometry = intCom.difference( intSym );
+      }
+      results << newGeometry;
+      if ( newGeometry.isNull() && failures )
+        *failures << i;
+    }
+  }
+  return results;
+}
+
+//! Features of a cell of the partitions, and the mask geometries around them
+struct ClipTask
+{
+  QgsFeatureList features;
+  QList< QgsGeometry > geometries;
+  QgsRectangle extent;
+  QList< QgsGeometry > mask;
+};
+
+//! Clipped geometries of a ClipTask
+struct ClipResult
+{
+  QList< QgsGeometry > geometries;
+  QList< int > failures;
+};
+
+static ClipResult clipTask( const ClipTask &task )
+{
+  ClipResult result;
+  result.geometries = clipGeometries( task.mask, task.extent, task.geometries, &result.failures );
+  return result;
+}
+
 QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, QgsProcessingContext &context, QgsProcessingFeedback *feedback )
 {
   std::unique_ptr< QgsFeatureSource > featureSource( parameterAsSource( parameters, QStringLiteral( "INPUT" ), context ) );
@@ -408,14 +609,24 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
   if ( !sink )
     return QVariantMap();
 
-  // first build up a list of clip geometries
+  // first build up a list of clip geometries, indexed by their bounding boxes
   QList< QgsGeometry > clipGeoms;
+  QgsSpatialIndex clipIndex;
+  QgsRectangle clipExtent;
   QgsFeatureIterator it = maskSource->getFeatures( QgsFeatureRequest().setSubsetOfAttributes( QList< int >() ).setDestinationCrs( featureSource->sourceCrs() ) );
   QgsFeature f;
   while ( it.nextFeature( f ) )
   {
     if ( f.hasGeometry() )
+    {
+      QgsRectangle bbox = f.geometry().boundingBox();
+      clipIndex.insertFeature( clipGeoms.size(), bbox );
+      if ( clipGeoms.isEmpty() )
+        clipExtent = bbox;
+      else
+        clipExtent.combineExtentWith( bbox );
       clipGeoms << f.geometry();
+    }
   }
 
   QVariantMap outputs;
@@ -424,104 +635,83 @@ QVariantMap QgsClipAlgorithm::processAlgorithm( const QVariantMap &parameters, Q
   if ( clipGeoms.isEmpty() )
     return outputs;
 
-  // are we clipping against a single feature? if so, we can show finer progress reports
-  bool singleClipFeature = false;
-  QgsGeometry combinedClipGeom;
-  if ( clipGeoms.length() > 1 )
-  {
-    combinedClipGeom = QgsGeometry::unaryUnion( clipGeoms );
-    singleClipFeature = false;
-  }
-  else
-  {
-    combinedClipGeom = clipGeoms.at( 0 );
-    singleClipFeature = true;
-  }
-
-  // use prepared geometries for faster intersection tests
-  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( combinedClipGeom.geometry() ) );
-  engine->prepareGeometry();
-
-  QgsFeatureIds testedFeatureIds;
+  // the features around the clip geometries are assigned to the cells of a grid. Whenever too
+  // many features are kept in memory, the features of each cell are clipped in parallel with the
+  // union of the clip geometries around them, which is much smaller than the union of all the clip
+  // geometries. Each thread has its own GEOS context.
+  QgsSpatialPartitions partitions( clipExtent, QThreadPool::globalInstance()->maxThreadCount() );
+  // the cells are sorted, so that the features are written in the same order on each run
+  QMap< int, QgsFeatureList > cellFeatures;
+  int pendingFeatures = 0;
 
-  int i = -1;
-  Q_FOREACH ( const QgsGeometry &clipGeom, clipGeoms )
+  auto clipFeatures = [&]()
   {
-    i++;
-    if ( feedback->isCanceled() )
+    QList< ClipTask > tasks;
+    for ( auto cellIt = cellFeatures.constBegin(); cellIt != cellFeatures.constEnd(); ++cellIt )
     {
-      break;
+      ClipTask task;
+      task.features = cellIt.value();
+      task.extent = task.features.at( 0 ).geometry().boundingBox();
+      Q_FOREACH ( const QgsFeature &feature, task.features )
+      {
+        task.geometries << feature.geometry();
+        task.extent.combineExtentWith( feature.geometry().boundingBox() );
+      }
+      Q_FOREACH ( QgsFeatureId id, clipIndex.intersects( task.extent ) )
+        task.mask << clipGeoms.at( static_cast< int >( id ) );
+      tasks << task;
     }
+    cellFeatures.clear();
+    pendingFeatures = 0;
 
-    QgsFeatureIterator inputIt = featureSource->getFeatures( QgsFeatureRequest().setFilterRect( clipGeom.boundingBox() ) );
-    QgsFeatureList inputFeatures;
-    QgsFeature f;
-    while ( inputIt.nextFeature( f ) )
-      inputFeatures << f;
-
-    if ( inputFeatures.isEmpty() )
-      continue;
-
-    double step = 0;
-    if ( singleClipFeature )
-      step = 100.0 / inputFeatures.length();
+    QList< ClipResult > results = QtConcurrent::blockingMapped( tasks, clipTask );
 
-    int current = 0;
-    Q_FOREACH ( const QgsFeature &inputFeature, inputFeatures )
+    for ( int i = 0; i < tasks.size(); ++i )
     {
-      if ( feedback->isCanceled() )
-      {
-        break;
-      }
+      const QgsFeatureList &features = tasks.at( i ).features;
+      const ClipResult &result = results.at( i );
+      Q_FOREACH ( int failure, result.failures )
+        feedback->pushInfo( QObject::tr( "Error clipping feature %1" ).arg( features.at( failure ).id() ) );
 
-      if ( !inputFeature.hasGeometry() )
-        continue;
-
-      if ( testedFeatureIds.contains( inputFeature.id() ) )
+      for ( int j = 0; j < features.size(); ++j )
       {
-        // don't retest a feature we have already checked
-        continue;
-      }
-      testedFeatureIds.insert( inputFeature.id() );
-
-      if ( !engine->intersects( inputFeature.geometry().geometry() ) )
-        continue;
+        if ( result.geometries.at( j ).isNull() )
+          continue;
 
-      QgsGeometry newGeometry;
-      if ( !engine->contains( inputFeature.geometry().geometry() ) )
-      {
-        QgsGeometry currentGeometry = inputFeature.geometry();
-        newGeometry = combinedClipGeom.intersection( currentGeometry );
-        if ( newGeometry.wkbType() == QgsWkbTypes::Unknown || QgsWkbTypes::flatType( newGeometry.geometry()->wkbType() ) == QgsWkbTypes::GeometryCollection )
-        {
-          QgsGeometry intCom = inputFeature.geometry().combine( newGeometry );
-          QgsGeometry intSym = inputFeature.geometry().symDifference( newGeometry );
-          newGeometry = intCom.difference( intSym );
-        }
+        QgsFeature outputFeature;
+        outputFeature.setGeometry( result.geometries.at( j ) );
+        outputFeature.setAttributes( features.at( j ).attributes() );
+        sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
       }
-      else
-      {
-        // clip geometry totally contains feature geometry, so no need to perform intersection
-        newGeometry = inputFeature.geometry();
-      }
-
-      QgsFeature outputFeature;
-      outputFeature.setGeometry( newGeometry );
-      outputFeature.setAttributes( inputFeature.attributes() );
-      sink->addFeature( outputFeature, QgsFeatureSink::FastInsert );
+    }
+  };
 
+  long count = featureSource->featureCount();
+  double step = count > 0 ? 100.0 / count : 1;
+  int current = 0;
 
-      if ( singleClipFeature )
-        feedback->setProgress( current * step );
+  QgsFeatureIterator inputIt = featureSource->getFeatures( QgsFeatureRequest().setFilterRect( clipExtent ) );
+  while ( inputIt.nextFeature( f ) )
+  {
+    if ( feedback->isCanceled() )
+    {
+      break;
     }
 
-    if ( !singleClipFeature )
+    if ( f.hasGeometry() )
     {
-      // coarse progress report for multiple clip geometries
-      feedback->setProgress( 100.0 * static_cast< double >( i ) / clipGeoms.length() );
+      cellFeatures[ partitions.cell( f.geometry().boundingBox() ) ] << f;
+      if ( ++pendingFeatures >= MAX_PENDING_GEOMETRIES )
+        clipFeatures();
     }
+
+    feedback->setProgress( current * step );
+    current++;
   }
 
+  if ( !feedback->isCanceled() )
+    clipFeatures();
+
   return outputs;
 }
 
@@ -552,16 +742,22 @@ bool QgsTransformAlgorithm::prepareAlgorithm( const QVariantMap &parameters, Qgs
 QgsFeature QgsTransformAlgorithm::processFeature( const QgsFeature &f, QgsProcessingFeedback * )
 {
   QgsFeature feature = f;
-  if ( !mCreatedTransform )
+  QgsCoordinateTransform transform;
   {
-    mCreatedTransform = true;
-    mTransform = QgsCoordinateTransform( sourceCrs(), mDestCrs );
+    // features are processed in parallel
+    QMutexLocker locker( &mTransformMutex );
+    if ( !mCreatedTransform )
+    {
+      mCreatedTransform = true;
+      mTransform = QgsCoordinateTransform( sourceCrs(), mDestCrs );
+    }
+    transform = mTransform;
   }
 
   if ( feature.hasGeometry() )
   {
     QgsGeometry g = feature.geometry();
-    if ( g.transform( mTransform ) == 0 )
+    if ( g.transform( transform ) == 0 )
     {
       feature.setGeometry( g );
     }
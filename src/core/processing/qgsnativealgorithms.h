@@ -25,6 +25,8 @@
 #include "qgsprocessingalgorithm.h"
 #include "qgsprocessingprovider.h"
 
+#include <QMutex>
+
 ///@cond PRIVATE
 
 class QgsNativeAlgorithms: public QgsProcessingProvider
@@ -63,6 +65,7 @@ class QgsCentroidAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsCentroidAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagProcessFeaturesInParallel; }
 
   protected:
 
@@ -88,6 +91,7 @@ class QgsTransformAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector general" ); }
     QString shortHelpString() const override;
     QgsTransformAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagProcessFeaturesInParallel; }
 
   protected:
 
@@ -100,6 +104,8 @@ class QgsTransformAlgorithm : public QgsProcessingFeatureBasedAlgorithm
 
   private:
 
+    //! Protects the transform, which is created by the first call to processFeature()
+    QMutex mTransformMutex;
     bool mCreatedTransform = false;
     QgsCoordinateReferenceSystem mDestCrs;
     QgsCoordinateTransform mTransform;
@@ -259,6 +265,7 @@ class QgsSubdivideAlgorithm : public QgsProcessingFeatureBasedAlgorithm
     QString group() const override { return QObject::tr( "Vector geometry" ); }
     QString shortHelpString() const override;
     QgsSubdivideAlgorithm *createInstance() const override SIP_FACTORY;
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagProcessFeaturesInParallel; }
 
   protected:
     QString outputName() const override { return QObject::tr( "Subdivided" ); }
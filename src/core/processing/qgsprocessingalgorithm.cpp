@@ -27,6 +27,9 @@
 #include "qgsmessagelog.h"
 #include "qgsprocessingfeedback.h"
 
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
 QgsProcessingAlgorithm::~QgsProcessingAlgorithm()
 {
   qDeleteAll( mParameters );
@@ -612,6 +615,136 @@ bool QgsProcessingAlgorithm::createAutoOutputForParameter( QgsProcessingParamete
 // QgsProcessingFeatureBasedAlgorithm
 //
 
+///@cond PRIVATE
+
+//! Number of features read from the source and processed in parallel at once
+static const int PARALLEL_CHUNK_SIZE = 1024;
+
+/**
+ * Feedback passed to processFeature() in worker threads, which keeps the messages
+ * so that they can be pushed to the algorithm feedback in the order of the features.
+ */
+class QgsProcessingBufferedFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    enum MessageType
+    {
+      ProgressText,
+      Error,
+      Info,
+      CommandInfo,
+      DebugInfo,
+      ConsoleInfo
+    };
+
+    typedef QList< QPair< MessageType, QString > > Messages;
+
+    void setProgressText( const QString &text ) override { mMessages << qMakePair( ProgressText, text ); }
+    void reportError( const QString &error ) override { mMessages << qMakePair( Error, error ); }
+    void pushInfo( const QString &info ) override { mMessages << qMakePair( Info, info ); }
+    void pushCommandInfo( const QString &info ) override { mMessages << qMakePair( CommandInfo, info ); }
+    void pushDebugInfo( const QString &info ) override { mMessages << qMakePair( DebugInfo, info ); }
+    void pushConsoleInfo( const QString &info ) override { mMessages << qMakePair( ConsoleInfo, info ); }
+
+    Messages messages() const { return mMessages; }
+
+    //! Pushes buffered \a messages to \a feedback
+    static void push( const Messages &messages, QgsProcessingFeedback *feedback )
+    {
+      for ( const QPair< MessageType, QString > &message : messages )
+      {
+        switch ( message.first )
+        {
+          case ProgressText:
+            feedback->setProgressText( message.second );
+            break;
+          case Error:
+            feedback->reportError( message.second );
+            break;
+          case Info:
+            feedback->pushInfo( message.second );
+            break;
+          case CommandInfo:
+            feedback->pushCommandInfo( message.second );
+            break;
+          case DebugInfo:
+            feedback->pushDebugInfo( message.second );
+            break;
+          case ConsoleInfo:
+            feedback->pushConsoleInfo( message.second );
+            break;
+        }
+      }
+    }
+
+  private:
+
+    Messages mMessages;
+};
+
+//! Result of processFeature() in a worker thread
+struct QgsProcessingFeatureBasedAlgorithm::ProcessedFeature
+{
+  QgsFeature feature;
+  QgsProcessingBufferedFeedback::Messages messages;
+  //! Message of the exception thrown by processFeature(), if any
+  QString error;
+  bool failed = false;
+};
+
+//! Functor calling processFeature() in worker threads
+class QgsProcessingFeatureBasedAlgorithm::FeatureProcessor
+{
+  public:
+
+    typedef ProcessedFeature result_type;
+
+    FeatureProcessor( QgsProcessingFeatureBasedAlgorithm *algorithm, QgsProcessingFeedback *feedback )
+      : mAlgorithm( algorithm )
+      , mFeedback( feedback )
+    {}
+
+    ProcessedFeature operator()( const QgsFeature &feature ) const
+    {
+      ProcessedFeature result;
+      // skipped features are discarded anyway
+      if ( mFeedback->isCanceled() )
+        return result;
+
+      QgsProcessingBufferedFeedback feedback;
+      try
+      {
+        result.feature = mAlgorithm->processFeature( feature, &feedback );
+      }
+      catch ( QgsException &e )
+      {
+        // rethrown from the main thread as a QgsProcessingException, once the previous features are added to the sink
+        result.error = e.what();
+        result.failed = true;
+      }
+      catch ( std::exception &e )
+      {
+        result.error = QString::fromLocal8Bit( e.what() );
+        result.failed = true;
+      }
+      catch ( ... )
+      {
+        result.error = QObject::tr( "Unknown error while processing feature %1" ).arg( feature.id() );
+        result.failed = true;
+      }
+      result.messages = feedback.messages();
+      return result;
+    }
+
+  private:
+
+    QgsProcessingFeatureBasedAlgorithm *mAlgorithm = nullptr;
+    QgsProcessingFeedback *mFeedback = nullptr;
+};
+
+///@endcond
+
 void QgsProcessingFeatureBasedAlgorithm::initAlgorithm( const QVariantMap &config )
 {
   addParameter( new QgsProcessingParameterFeatureSource( QStringLiteral( "INPUT" ), QObject::tr( "Input layer" ) ) );
@@ -643,24 +776,32 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
 
   long count = mSource->featureCount();
 
-  QgsFeature f;
   QgsFeatureIterator it = mSource->getFeatures();
 
   double step = count > 0 ? 100.0 / count : 1;
-  int current = 0;
-  while ( it.nextFeature( f ) )
+
+  if ( ( flags() & FlagProcessFeaturesInParallel ) && QThreadPool::globalInstance()->maxThreadCount() > 1 )
   {
-    if ( feedback->isCanceled() )
+    processFeaturesInParallel( it, sink.get(), step, feedback );
+  }
+  else
+  {
+    QgsFeature f;
+    int current = 0;
+    while ( it.nextFeature( f ) )
     {
-      break;
-    }
+      if ( feedback->isCanceled() )
+      {
+        break;
+      }
 
-    QgsFeature transformed = processFeature( f, feedback );
-    if ( transformed.isValid() )
-      sink->addFeature( transformed, QgsFeatureSink::FastInsert );
+      QgsFeature transformed = processFeature( f, feedback );
+      if ( transformed.isValid() )
+        sink->addFeature( transformed, QgsFeatureSink::FastInsert );
 
-    feedback->setProgress( current * step );
-    current++;
+      feedback->setProgress( current * step );
+      current++;
+    }
   }
 
   mSource.reset();
@@ -669,3 +810,41 @@ QVariantMap QgsProcessingFeatureBasedAlgorithm::processAlgorithm( const QVariant
   outputs.insert( QStringLiteral( "OUTPUT" ), dest );
   return outputs;
 }
+
+void QgsProcessingFeatureBasedAlgorithm::processFeaturesInParallel( QgsFeatureIterator &it, QgsFeatureSink *sink, double step, QgsProcessingFeedback *feedback )
+{
+  // features are read from this thread only, as feature iterators are not thread safe
+  auto readChunk = [&it, feedback]()
+  {
+    QList< QgsFeature > features;
+    QgsFeature f;
+    while ( features.size() < PARALLEL_CHUNK_SIZE && !feedback->isCanceled() && it.nextFeature( f ) )
+      features << f;
+    return features;
+  };
+
+  int current = 0;
+  QList< QgsFeature > features = readChunk();
+  while ( !features.isEmpty() )
+  {
+    // blockingMapped also processes features in this thread, so the chunk is completed even when
+    // all the threads of the global pool are busy, e.g. running the task of this algorithm
+    const QList< ProcessedFeature > results = QtConcurrent::blockingMapped( features, FeatureProcessor( this, feedback ) );
+
+    // the results of QtConcurrent::blockingMapped are in the order of the input features, so the
+    // output is the same as when the features are processed serially
+    Q_FOREACH ( const ProcessedFeature &result, results )
+    {
+      QgsProcessingBufferedFeedback::push( result.messages, feedback );
+      if ( result.failed )
+        throw QgsProcessingException( result.error );
+
+      if ( result.feature.isValid() )
+        sink->addFeature( result.feature, QgsFeatureSink::FastInsert );
+    }
+
+    current += features.size();
+    feedback->setProgress( current * step );
+    features = readChunk();
+  }
+}
@@ -71,6 +71,7 @@ class CORE_EXPORT QgsProcessingAlgorithm
       FlagSupportsBatch = 1 << 3,  //!< Algorithm supports batch mode
       FlagCanCancel = 1 << 4, //!< Algorithm can be canceled
       FlagRequiresMatchingCrs = 1 << 5, //!< Algorithm requires that all input layers have matching coordinate reference systems
+      FlagProcessFeaturesInParallel = 1 << 6, //!< Features may be processed in parallel by worker threads. Only used by QgsProcessingFeatureBasedAlgorithm subclasses, whose processFeature() implementation must be thread safe
       FlagDeprecated = FlagHideFromToolbox | FlagHideFromModeler, //!< Algorithm is deprecated
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -819,6 +820,12 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
      * prevent the algorithm execution from continuing. This can be annoying for users though as it
      * can break valid model execution - so use with extreme caution, and consider using
      * \a feedback to instead report non-fatal processing failures for features instead.
+     *
+     * If the algorithm flags() include FlagProcessFeaturesInParallel, this method is called
+     * concurrently from worker threads, and must not modify the algorithm or share any other
+     * state without synchronization. The features are still added to the output sink in the
+     * order of the source, and the messages pushed to \a feedback are reported in that order
+     * too. Algorithms implemented in Python must not set this flag.
      */
     virtual QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) = 0;
 
@@ -827,6 +834,15 @@ class CORE_EXPORT QgsProcessingFeatureBasedAlgorithm : public QgsProcessingAlgor
 
   private:
 
+    struct ProcessedFeature;
+    class FeatureProcessor;
+
+    /**
+     * Processes the features returned by the iterator \a it in parallel and adds
+     * them to \a sink, see FlagProcessFeaturesInParallel.
+     */
+    void processFeaturesInParallel( QgsFeatureIterator &it, QgsFeatureSink *sink, double step, QgsProcessingFeedback *feedback );
+
     std::unique_ptr< QgsFeatureSource > mSource;
 
 };
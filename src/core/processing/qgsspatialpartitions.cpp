@@ -0,0 +1,41 @@
+/***************************************************************************
+  qgsspatialpartitions.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsspatialpartitions.h"
+
+///@cond PRIVATE
+
+//! Maximum number of cells along each axis of the grid
+static const int MAX_GRID_SIZE = 64;
+
+QgsSpatialPartitions::QgsSpatialPartitions( const QgsRectangle &extent, int threads )
+  : mExtent( extent )
+{
+  // a few cells per thread, so that dense cells do not leave the other threads idle
+  while ( mSize * mSize < 4 * threads && mSize < MAX_GRID_SIZE )
+    mSize *= 2;
+}
+
+int QgsSpatialPartitions::cell( const QgsRectangle &boundingBox ) const
+{
+  QgsPointXY center = boundingBox.center();
+  int x = mExtent.width() > 0 ? static_cast< int >( ( center.x() - mExtent.xMinimum() ) / mExtent.width() * mSize ) : 0;
+  int y = mExtent.height() > 0 ? static_cast< int >( ( center.y() - mExtent.yMinimum() ) / mExtent.height() * mSize ) : 0;
+  // features may lie outside of an outdated source extent
+  x = qBound( 0, x, mSize - 1 );
+  y = qBound( 0, y, mSize - 1 );
+  return y * mSize + x;
+}
+
+///@endcond
@@ -0,0 +1,68 @@
+/***************************************************************************
+  qgsspatialpartitions.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSPATIALPARTITIONS_H
+#define QGSSPATIALPARTITIONS_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsrectangle.h"
+
+///@cond PRIVATE
+
+/**
+ * \ingroup core
+ * \brief A grid of cells covering an extent, used to split the features of a source
+ * into spatially coherent partitions which are processed in parallel.
+ *
+ * Features are assigned to the cell containing the center of their bounding box, so
+ * that each feature belongs to exactly one cell. The grid has a power of two cells
+ * along each axis, so that the partial results of the cells can be merged in a cascade,
+ * the four cells of a quadtree node being merged into their parent cell, see parentCell().
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsSpatialPartitions
+{
+  public:
+
+    /**
+     * Constructor for a grid covering \a extent, with enough cells to keep
+     * \a threads worker threads busy.
+     */
+    QgsSpatialPartitions( const QgsRectangle &extent, int threads );
+
+    //! Returns the number of cells along each axis of the grid
+    int size() const { return mSize; }
+
+    //! Returns the cell containing the center of \a boundingBox, numbered row by row
+    int cell( const QgsRectangle &boundingBox ) const;
+
+    /**
+     * Returns the cell of a grid with \a size / 2 cells along each axis
+     * which contains \a cell of a grid with \a size cells along each axis.
+     */
+    static int parentCell( int cell, int size ) { return ( cell / size / 2 ) * ( size / 2 ) + ( cell % size ) / 2; }
+
+  private:
+
+    QgsRectangle mExtent;
+    int mSize = 1;
+};
+
+///@endcond
+
+#endif // QGSSPATIALPARTITIONS_H
@@ -15,6 +15,7 @@
 #include "qgsmemoryfeatureiterator.h"
 #include "qgsmemoryprovider.h"
 
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgsgeometryengine.h"
 #include "qgslogger.h"
@@ -91,71 +92,100 @@ bool QgsMemoryFeatureIterator::fetchFeature( QgsFeature &feature )
 {
   feature.setValid( false );
 
-  if ( mClosed )
+  const QgsFeature *storedFeature = nextStoredFeature();
+  if ( !storedFeature )
     return false;
 
+  // copy feature
+  feature = *storedFeature;
+  feature.setValid( true );
+  feature.setFields( mSource->mFields ); // allow name-based attribute lookups
+  geometryToDestinationCrs( feature, mTransform );
+  return true;
+}
+
+
+int QgsMemoryFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  // geometries need to be transformed feature by feature
+  if ( mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  // fill the columns straight from the stored features, without copying them first
+  int count = 0;
+  const QgsFeature *storedFeature = nullptr;
+  while ( count < maxFeatures && ( storedFeature = nextStoredFeature() ) )
+  {
+    batch.appendFeature( *storedFeature );
+    ++count;
+  }
+  return count;
+}
+
+
+const QgsFeature *QgsMemoryFeatureIterator::nextStoredFeature()
+{
+  if ( mClosed )
+    return nullptr;
+
   if ( mUsingFeatureIdList )
-    return nextFeatureUsingList( feature );
+    return nextFeatureUsingList();
   else
-    return nextFeatureTraverseAll( feature );
+    return nextFeatureTraverseAll();
 }
 
 
-bool QgsMemoryFeatureIterator::nextFeatureUsingList( QgsFeature &feature )
+const QgsFeature *QgsMemoryFeatureIterator::nextFeatureUsingList()
 {
-  bool hasFeature = false;
+  const QgsFeature *feature = nullptr;
 
   // option 1: we have a list of features to traverse
   while ( mFeatureIdListIterator != mFeatureIdList.constEnd() )
   {
+    QgsFeatureMap::const_iterator it = mSource->mFeatures.constFind( *mFeatureIdListIterator );
+    ++mFeatureIdListIterator;
+    if ( it == mSource->mFeatures.constEnd() )
+      continue;
+
+    bool hasFeature = false;
     if ( !mFilterRect.isNull() && mRequest.flags() & QgsFeatureRequest::ExactIntersect )
     {
       // do exact check in case we're doing intersection
-      if ( mSource->mFeatures.value( *mFeatureIdListIterator ).hasGeometry() && mSelectRectEngine->intersects( mSource->mFeatures.value( *mFeatureIdListIterator ).geometry().geometry() ) )
+      if ( it->hasGeometry() && mSelectRectEngine->intersects( it->geometry().geometry() ) )
         hasFeature = true;
     }
     else
       hasFeature = true;
 
-    if ( mSubsetExpression )
+    if ( hasFeature && mSubsetExpression )
     {
-      mSource->mExpressionContext.setFeature( mSource->mFeatures.value( *mFeatureIdListIterator ) );
+      mSource->mExpressionContext.setFeature( *it );
       if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
         hasFeature = false;
     }
 
     if ( hasFeature )
+    {
+      feature = &it.value();
       break;
-
-    ++mFeatureIdListIterator;
+    }
   }
 
-  // copy feature
-  if ( hasFeature )
-  {
-    feature = mSource->mFeatures.value( *mFeatureIdListIterator );
-    ++mFeatureIdListIterator;
-  }
-  else
+  if ( !feature )
     close();
 
-  if ( hasFeature )
-  {
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
-  }
-
-  return hasFeature;
+  return feature;
 }
 
 
-bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
+const QgsFeature *QgsMemoryFeatureIterator::nextFeatureTraverseAll()
 {
-  bool hasFeature = false;
+  const QgsFeature *feature = nullptr;
 
   // option 2: traversing the whole layer
   while ( mSelectIterator != mSource->mFeatures.constEnd() )
   {
+    bool hasFeature = false;
     if ( mFilterRect.isNull() )
     {
       // selection rect empty => using all features
@@ -177,7 +207,7 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
       }
     }
 
-    if ( mSubsetExpression )
+    if ( hasFeature && mSubsetExpression )
     {
       mSource->mExpressionContext.setFeature( *mSelectIterator );
       if ( !mSubsetExpression->evaluate( &mSource->mExpressionContext ).toBool() )
@@ -185,24 +215,18 @@ bool QgsMemoryFeatureIterator::nextFeatureTraverseAll( QgsFeature &feature )
     }
 
     if ( hasFeature )
-      break;
+      feature = &mSelectIterator.value();
 
     ++mSelectIterator;
-  }
 
-  // copy feature
-  if ( hasFeature )
-  {
-    feature = mSelectIterator.value();
-    ++mSelectIterator;
-    feature.setValid( true );
-    feature.setFields( mSource->mFields ); // allow name-based attribute lookups
-    geometryToDestinationCrs( feature, mTransform );
+    if ( feature )
+      break;
   }
-  else
+
+  if ( !feature )
     close();
 
-  return hasFeature;
+  return feature;
 }
 
 bool QgsMemoryFeatureIterator::rewind()
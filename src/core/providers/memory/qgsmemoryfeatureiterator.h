@@ -63,10 +63,13 @@ class QgsMemoryFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Qgs
   protected:
 
     virtual bool fetchFeature( QgsFeature &feature ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
 
   private:
-    bool nextFeatureUsingList( QgsFeature &feature );
-    bool nextFeatureTraverseAll( QgsFeature &feature );
+    //! Returns the next stored feature matching the request or nullptr at the end
+    const QgsFeature *nextStoredFeature();
+    const QgsFeature *nextFeatureUsingList();
+    const QgsFeature *nextFeatureTraverseAll();
 
     QgsGeometry mSelectRectGeom;
     std::unique_ptr< QgsGeometryEngine > mSelectRectEngine;
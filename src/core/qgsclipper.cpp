@@ -19,6 +19,8 @@
 #include "qgsclipper.h"
 #include "qgsgeometry.h"
 #include "qgscurve.h"
+#include "qgsgeometrykernels.h"
+#include "qgslinestring.h"
 #include "qgslogger.h"
 
 // Where has all the code gone?
@@ -40,7 +42,48 @@ const double QgsClipper::SMALL_NUM = 1e-12;
 
 QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent )
 {
+  // line strings are clipped straight from their coordinate arrays
+  if ( const QgsLineString *lineString = qgsgeometry_cast< const QgsLineString * >( &curve ) )
+  {
+    return clippedLine( lineString->xData(), lineString->yData(), lineString->numPoints(), clipExtent );
+  }
+
   const int nPoints = curve.numPoints();
+  QVector<double> x( nPoints );
+  QVector<double> y( nPoints );
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    x[i] = curve.xAt( i );
+    y[i] = curve.yAt( i );
+  }
+  return clippedLine( x.constData(), y.constData(), nPoints, clipExtent );
+}
+
+QPolygonF QgsClipper::clippedLine( const QPolygonF &points, const QgsRectangle &clipExtent )
+{
+  if ( points.size() > 1 && clipExtent.contains( QgsRectangle( points.boundingRect() ) ) )
+  {
+    return points;
+  }
+
+  const int nPoints = points.size();
+  QVector<double> x( nPoints );
+  QVector<double> y( nPoints );
+  for ( int i = 0; i < nPoints; ++i )
+  {
+    x[i] = points.at( i ).x();
+    y[i] = points.at( i ).y();
+  }
+  return clippedLine( x.constData(), y.constData(), nPoints, clipExtent );
+}
+
+QPolygonF QgsClipper::clippedLine( const double *x, const double *y, int nPoints, const QgsRectangle &clipExtent )
+{
+  // most lines are totally inside of the extent, and do not need to be clipped segment by segment
+  if ( nPoints > 1 && QgsGeometryKernels::allInside( x, y, nPoints, clipExtent ) )
+  {
+    return QgsGeometryKernels::toPolygon( x, y, nPoints );
+  }
 
   double p0x, p0y, p1x = 0.0, p1y = 0.0; //original coordinates
   double p1x_c, p1y_c; //clipped end coordinates
@@ -53,8 +96,8 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
   {
     if ( i == 0 )
     {
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = x[i];
+      p1y = y[i];
       continue;
     }
     else
@@ -62,8 +105,8 @@ QPolygonF QgsClipper::clippedLine( const QgsCurve &curve, const QgsRectangle &cl
       p0x = p1x;
       p0y = p1y;
 
-      p1x = curve.xAt( i );
-      p1y = curve.yAt( i );
+      p1x = x[i];
+      p1y = y[i];
 
       p1x_c = p1x;
       p1y_c = p1y;
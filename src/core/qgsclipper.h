@@ -106,6 +106,14 @@ class CORE_EXPORT QgsClipper
      */
     static QPolygonF clippedLine( const QgsCurve &curve, const QgsRectangle &clipExtent );
 
+    /** Takes a linestring and clips it to clipExtent
+     * \param points the points of the linestring
+     * \param clipExtent clipping bounds
+     * \returns clipped line coordinates
+     * \since QGIS 3.0
+     */
+    static QPolygonF clippedLine( const QPolygonF &points, const QgsRectangle &clipExtent );
+
   private:
 
     // Used when testing for equivalance to 0.0
@@ -122,6 +130,9 @@ class CORE_EXPORT QgsClipper
 
     static void trimPolygonToBoundary( const QPolygonF &inPts, QPolygonF &outPts, const QgsRectangle &rect, Boundary b, double boundaryValue );
 
+    //! Clips the line through \a nPoints points to \a clipExtent
+    static QPolygonF clippedLine( const double *x, const double *y, int nPoints, const QgsRectangle &clipExtent );
+
     // Determines if a point is inside or outside the given boundary
     static bool inside( const double x, const double y, Boundary b );
 
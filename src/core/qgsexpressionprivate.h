@@ -24,6 +24,8 @@
 #include "qgsdistancearea.h"
 #include "qgsunittypes.h"
 #include "qgsexpressionnode.h"
+#include "qgsexpressionbytecode.h"
+#include "qgsfields.h"
 
 ///@cond
 
@@ -49,6 +51,7 @@ class QgsExpressionPrivate
       , mParserErrorString( other.mParserErrorString )
       , mEvalErrorString( other.mEvalErrorString )
       , mExp( other.mExp )
+      , mBytecodeFields( other.mBytecodeFields )
       , mCalc( other.mCalc )
       , mDistanceUnit( other.mDistanceUnit )
       , mAreaUnit( other.mAreaUnit )
@@ -68,6 +71,13 @@ class QgsExpressionPrivate
 
     QString mExp;
 
+    //! Bytecode lowered from the prepared tree, refers to its nodes so it is never shared between copies
+    std::unique_ptr<QgsExpressionBytecode> mBytecode;
+    //! Fields the tree was prepared for, the bytecode is compiled for them on the first batch evaluation, also by copies
+    QgsFields mBytecodeFields;
+    //! True once compiling the bytecode was attempted since the tree was prepared
+    bool mBytecodeCompiled = false;
+
     std::shared_ptr<QgsDistanceArea> mCalc;
     QgsUnitTypes::DistanceUnit mDistanceUnit;
     QgsUnitTypes::AreaUnit mAreaUnit;
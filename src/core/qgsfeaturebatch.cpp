@@ -0,0 +1,347 @@
+/***************************************************************************
+    qgsfeaturebatch.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgsfeaturebatch.h"
+
+#include "qgsgeometry.h"
+
+#include <cstring>
+
+QgsFeatureBatch::QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes, bool fetchGeometry )
+{
+  setColumns( fields, attributes, fetchGeometry );
+}
+
+void QgsFeatureBatch::setColumns( const QgsFields &fields, const QgsAttributeList &attributes, bool fetchGeometry )
+{
+  mFields = fields;
+  mFetchGeometry = fetchGeometry;
+  mColumns.clear();
+  mFieldColumns.fill( -1, fields.count() );
+
+  Q_FOREACH ( int idx, attributes )
+  {
+    if ( idx < 0 || idx >= fields.count() || mFieldColumns.at( idx ) >= 0 )
+      continue;
+
+    Column column;
+    column.fieldIndex = idx;
+    column.fieldType = fields.at( idx ).type();
+    column.type = columnTypeForField( column.fieldType );
+    mFieldColumns[idx] = mColumns.count();
+    mColumns << column;
+  }
+
+  clear();
+}
+
+void QgsFeatureBatch::clear()
+{
+  // resizing keeps the allocated memory around for the next batch
+  for ( int i = 0; i < mColumns.count(); ++i )
+  {
+    Column &column = mColumns[i];
+    column.nulls.resize( 0 );
+    column.doubles.resize( 0 );
+    column.ints.resize( 0 );
+    column.strings.resize( 0 );
+    column.stringOffsets.resize( 0 );
+    column.stringLengths.resize( 0 );
+    column.variants.resize( 0 );
+  }
+
+  mIds.resize( 0 );
+  mWkb.resize( 0 );
+  mWkbOffsets.resize( 0 );
+  mWkbSizes.resize( 0 );
+}
+
+int QgsFeatureBatch::columnForField( int fieldIndex ) const
+{
+  return mFieldColumns.value( fieldIndex, -1 );
+}
+
+const double *QgsFeatureBatch::doubleData( int column ) const
+{
+  const Column &c = mColumns.at( column );
+  return c.type == Double ? c.doubles.constData() : nullptr;
+}
+
+const qint64 *QgsFeatureBatch::int64Data( int column ) const
+{
+  const Column &c = mColumns.at( column );
+  return c.type == Int64 ? c.ints.constData() : nullptr;
+}
+
+const char *QgsFeatureBatch::stringData( int column, int row, int &length ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.type != String )
+  {
+    length = 0;
+    return nullptr;
+  }
+
+  length = c.stringLengths.at( row );
+  return c.strings.constData() + c.stringOffsets.at( row );
+}
+
+double QgsFeatureBatch::doubleValue( int column, int row, bool *ok ) const
+{
+  const Column &c = mColumns.at( column );
+  bool valid = !c.nulls.at( row ) && ( c.type == Double || c.type == Int64 );
+  if ( ok )
+    *ok = valid;
+  if ( !valid )
+    return 0.0;
+
+  return c.type == Double ? c.doubles.at( row ) : static_cast< double >( c.ints.at( row ) );
+}
+
+QVariant QgsFeatureBatch::value( int column, int row ) const
+{
+  const Column &c = mColumns.at( column );
+  if ( c.nulls.at( row ) )
+    return QVariant( c.fieldType );
+
+  QVariant v;
+  switch ( c.type )
+  {
+    case Double:
+      v = c.doubles.at( row );
+      break;
+    case Int64:
+      v = c.ints.at( row );
+      break;
+    case String:
+      return QString::fromUtf8( c.strings.constData() + c.stringOffsets.at( row ), c.stringLengths.at( row ) );
+    case Variant:
+      return c.variants.at( row );
+  }
+
+  if ( v.type() != c.fieldType )
+    v.convert( c.fieldType );
+  return v;
+}
+
+const unsigned char *QgsFeatureBatch::wkb( int row, int &size ) const
+{
+  size = mWkbSizes.value( row );
+  if ( size <= 0 )
+    return nullptr;
+
+  return reinterpret_cast< const unsigned char * >( mWkb.constData() ) + mWkbOffsets.at( row );
+}
+
+QgsGeometry QgsFeatureBatch::geometry( int row ) const
+{
+  int size = 0;
+  const unsigned char *data = wkb( row, size );
+  if ( !data )
+    return QgsGeometry();
+
+  // QgsGeometry takes ownership of the buffer
+  unsigned char *copy = new unsigned char[size];
+  memcpy( copy, data, size );
+  QgsGeometry g;
+  g.fromWkb( copy, size );
+  return g;
+}
+
+QgsFeature QgsFeatureBatch::feature( int row ) const
+{
+  QgsFeature f( mFields, mIds.at( row ) );
+  for ( int column = 0; column < mColumns.count(); ++column )
+  {
+    f.setAttribute( mColumns.at( column ).fieldIndex, value( column, row ) );
+  }
+  if ( hasGeometry( row ) )
+    f.setGeometry( geometry( row ) );
+  f.setValid( true );
+  return f;
+}
+
+void QgsFeatureBatch::appendFeature( const QgsFeature &feature )
+{
+  addRow( feature.id() );
+
+  const QgsAttributes attributes = feature.attributes();
+  for ( int column = 0; column < mColumns.count(); ++column )
+  {
+    int idx = mColumns.at( column ).fieldIndex;
+    if ( idx < attributes.count() )
+      setValue( column, attributes.at( idx ) );
+  }
+
+  if ( mFetchGeometry && feature.hasGeometry() )
+  {
+    QByteArray wkb = feature.geometry().exportToWkb();
+    if ( !wkb.isEmpty() )
+      memcpy( allocateWkb( wkb.size() ), wkb.constData(), wkb.size() );
+  }
+}
+
+void QgsFeatureBatch::addRow( QgsFeatureId id )
+{
+  mIds.append( id );
+
+  for ( int i = 0; i < mColumns.count(); ++i )
+  {
+    Column &column = mColumns[i];
+    column.nulls.append( true );
+    switch ( column.type )
+    {
+      case Double:
+        column.doubles.append( 0.0 );
+        break;
+      case Int64:
+        column.ints.append( 0 );
+        break;
+      case String:
+        column.stringOffsets.append( column.strings.size() );
+        column.stringLengths.append( 0 );
+        break;
+      case Variant:
+        column.variants.append( QVariant( column.fieldType ) );
+        break;
+    }
+  }
+
+  if ( mFetchGeometry )
+  {
+    mWkbOffsets.append( mWkb.size() );
+    mWkbSizes.append( 0 );
+  }
+}
+
+void QgsFeatureBatch::setDouble( int column, double value )
+{
+  Column &c = mColumns[column];
+  int row = mIds.count() - 1;
+  switch ( c.type )
+  {
+    case Double:
+      c.doubles[row] = value;
+      break;
+    case Int64:
+      c.ints[row] = static_cast< qint64 >( value );
+      break;
+    case String:
+    case Variant:
+      setValue( column, value );
+      return;
+  }
+  c.nulls[row] = false;
+}
+
+void QgsFeatureBatch::setInt64( int column, qint64 value )
+{
+  Column &c = mColumns[column];
+  int row = mIds.count() - 1;
+  switch ( c.type )
+  {
+    case Double:
+      c.doubles[row] = static_cast< double >( value );
+      break;
+    case Int64:
+      c.ints[row] = value;
+      break;
+    case String:
+    case Variant:
+      setValue( column, value );
+      return;
+  }
+  c.nulls[row] = false;
+}
+
+void QgsFeatureBatch::setString( int column, const char *utf8, int length )
+{
+  Column &c = mColumns[column];
+  if ( c.type != String )
+  {
+    setValue( column, QString::fromUtf8( utf8, length ) );
+    return;
+  }
+
+  int row = mIds.count() - 1;
+  c.stringOffsets[row] = c.strings.size();
+  c.stringLengths[row] = length;
+  c.strings.append( utf8, length );
+  c.nulls[row] = false;
+}
+
+void QgsFeatureBatch::setValue( int column, const QVariant &value )
+{
+  if ( value.isNull() )
+    return; // rows start as null
+
+  Column &c = mColumns[column];
+  int row = mIds.count() - 1;
+  bool ok = true;
+  switch ( c.type )
+  {
+    case Double:
+      c.doubles[row] = value.toDouble( &ok );
+      break;
+    case Int64:
+      c.ints[row] = value.type() == QVariant::Bool ? value.toBool() : value.toLongLong( &ok );
+      break;
+    case String:
+    {
+      QByteArray utf8 = value.toString().toUtf8();
+      c.stringOffsets[row] = c.strings.size();
+      c.stringLengths[row] = utf8.size();
+      c.strings.append( utf8 );
+      break;
+    }
+    case Variant:
+      c.variants[row] = value;
+      break;
+  }
+  c.nulls[row] = !ok;
+}
+
+unsigned char *QgsFeatureBatch::allocateWkb( int size )
+{
+  if ( !mFetchGeometry || mIds.isEmpty() )
+    return nullptr;
+
+  int row = mIds.count() - 1;
+  int offset = mWkb.size();
+  mWkb.resize( offset + size );
+  mWkbOffsets[row] = offset;
+  mWkbSizes[row] = size;
+  return reinterpret_cast< unsigned char * >( mWkb.data() ) + offset;
+}
+
+QgsFeatureBatch::ColumnType QgsFeatureBatch::columnTypeForField( QVariant::Type type )
+{
+  switch ( type )
+  {
+    case QVariant::Double:
+      return Double;
+
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Bool:
+      return Int64;
+
+    case QVariant::String:
+      return String;
+
+    default:
+      return Variant;
+  }
+}
@@ -0,0 +1,211 @@
+/***************************************************************************
+    qgsfeaturebatch.h
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#ifndef QGSFEATUREBATCH_H
+#define QGSFEATUREBATCH_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgsfields.h"
+
+#include <QByteArray>
+#include <QVector>
+
+/** \ingroup core
+ * Block of features stored column by column, as filled by QgsFeatureIterator::nextBatch().
+ *
+ * Every requested attribute gets a typed column: numeric fields are kept in contiguous
+ * arrays of doubles or 64 bit integers and string fields as UTF-8 bytes addressed by
+ * row. Other field types fall back to QVariant storage. Geometries are packed as WKB
+ * in a single buffer. Compared to fetching QgsFeature objects one by one this avoids
+ * several allocations and the QVariant boxing of attribute values per feature.
+ *
+ * The column layout is defined by the caller, then the same batch may be refilled by
+ * repeated calls to QgsFeatureIterator::nextBatch(). Attributes which were not fetched
+ * by the iterator are reported as null.
+ *
+ * \note not available in Python bindings
+ * \since QGIS 3.0
+ */
+class CORE_EXPORT QgsFeatureBatch
+{
+  public:
+
+    //! Storage type of a column
+    enum ColumnType
+    {
+      Double, //!< Column of double values
+      Int64, //!< Column of 64 bit integer values (used for integer and boolean fields)
+      String, //!< Column of UTF-8 encoded strings
+      Variant, //!< Column of QVariant values (all other field types)
+    };
+
+    //! Constructor for an empty batch without any columns
+    QgsFeatureBatch() = default;
+
+    /**
+     * Constructor for QgsFeatureBatch with a column for each of the \a attributes,
+     * given as indexes into \a fields. If \a fetchGeometry is false then
+     * geometries are not stored in the batch.
+     */
+    QgsFeatureBatch( const QgsFields &fields, const QgsAttributeList &attributes, bool fetchGeometry = true );
+
+    /**
+     * Sets up the column layout of the batch - one column for each of \a attributes,
+     * given as indexes into \a fields. Any features in the batch are removed.
+     */
+    void setColumns( const QgsFields &fields, const QgsAttributeList &attributes, bool fetchGeometry = true );
+
+    //! Removes all features from the batch, the column layout is kept
+    void clear();
+
+    //! Returns number of features in the batch
+    int count() const { return mIds.count(); }
+
+    //! Returns true if there are no features in the batch
+    bool isEmpty() const { return mIds.isEmpty(); }
+
+    //! Returns the fields the batch columns refer to
+    QgsFields fields() const { return mFields; }
+
+    //! Returns number of attribute columns
+    int columnCount() const { return mColumns.count(); }
+
+    //! Returns index of the column storing field with given index or -1 if the field is not in the batch
+    int columnForField( int fieldIndex ) const;
+
+    //! Returns index of the field stored in a column
+    int fieldIndex( int column ) const { return mColumns.at( column ).fieldIndex; }
+
+    //! Returns storage type of a column
+    ColumnType columnType( int column ) const { return mColumns.at( column ).type; }
+
+    //! Returns true if geometries are stored in the batch
+    bool fetchGeometry() const { return mFetchGeometry; }
+
+    //! Returns ID of the feature at \a row
+    QgsFeatureId id( int row ) const { return mIds.at( row ); }
+
+    //! Returns IDs of all features in the batch
+    const QVector<QgsFeatureId> &ids() const { return mIds; }
+
+    //! Returns true if the attribute value in \a column is null for feature at \a row
+    bool isNull( int column, int row ) const { return mColumns.at( column ).nulls.at( row ); }
+
+    /**
+     * Returns values of a Double column (one for each feature, null values are stored as 0)
+     * or nullptr if the column is of another type.
+     */
+    const double *doubleData( int column ) const;
+
+    /**
+     * Returns values of an Int64 column (one for each feature, null values are stored as 0)
+     * or nullptr if the column is of another type.
+     */
+    const qint64 *int64Data( int column ) const;
+
+    /**
+     * Returns UTF-8 data of a String column for feature at \a row and stores its size to \a length.
+     * The data is not null terminated. Returns nullptr if the column is of another type.
+     */
+    const char *stringData( int column, int row, int &length ) const;
+
+    /**
+     * Returns the value of a numeric (Double or Int64) column at \a row as a double. The
+     * \a ok argument is set to false if the value is null or the column is not numeric.
+     */
+    double doubleValue( int column, int row, bool *ok = nullptr ) const;
+
+    //! Returns the value in \a column at \a row converted to the type of the column's field
+    QVariant value( int column, int row ) const;
+
+    //! Returns true if the feature at \a row has a geometry
+    bool hasGeometry( int row ) const { return mWkbSizes.value( row ) > 0; }
+
+    /**
+     * Returns WKB of the geometry of feature at \a row and stores its size to \a size.
+     * Returns nullptr if the feature has no geometry.
+     */
+    const unsigned char *wkb( int row, int &size ) const;
+
+    //! Returns the geometry of feature at \a row (this parses the stored WKB)
+    QgsGeometry geometry( int row ) const;
+
+    //! Creates a feature from the data at \a row
+    QgsFeature feature( int row ) const;
+
+    /**
+     * Appends a feature to the batch. Only attributes with a column in the batch are copied.
+     * This is the generic way of filling the batch for iterators without native support.
+     */
+    void appendFeature( const QgsFeature &feature );
+
+    /**
+     * Starts a new row for feature with given \a id. All attributes of the new row are null
+     * and it has no geometry until they are set with setDouble(), setInt64(), setString(),
+     * setValue() and allocateWkb().
+     */
+    void addRow( QgsFeatureId id );
+
+    //! Sets value of the last row in \a column, which should be a Double or Int64 column
+    void setDouble( int column, double value );
+
+    //! Sets value of the last row in \a column, which should be a Double or Int64 column
+    void setInt64( int column, qint64 value );
+
+    //! Sets UTF-8 encoded value of the last row in \a column, which should be a String column
+    void setString( int column, const char *utf8, int length );
+
+    //! Sets value of the last row in \a column, converting it to the column's storage type
+    void setValue( int column, const QVariant &value );
+
+    /**
+     * Reserves \a size bytes for WKB geometry of the last row and returns pointer
+     * where the WKB should be written to. The pointer is only valid until the batch
+     * is modified again. Returns nullptr if geometries are not stored.
+     */
+    unsigned char *allocateWkb( int size );
+
+  private:
+
+    struct Column
+    {
+      int fieldIndex = -1;
+      QVariant::Type fieldType = QVariant::Invalid;
+      ColumnType type = Variant;
+      QVector<bool> nulls;
+      QVector<double> doubles;
+      QVector<qint64> ints;
+      QByteArray strings;
+      QVector<int> stringOffsets;
+      QVector<int> stringLengths;
+      QVector<QVariant> variants;
+    };
+
+    static ColumnType columnTypeForField( QVariant::Type type );
+
+    QgsFields mFields;
+    QVector<Column> mColumns;
+    //! Column index for each field (-1 for fields not in the batch)
+    QVector<int> mFieldColumns;
+    bool mFetchGeometry = true;
+
+    QVector<QgsFeatureId> mIds;
+    QByteArray mWkb;
+    QVector<int> mWkbOffsets;
+    QVector<int> mWkbSizes;
+};
+
+#endif // QGSFEATUREBATCH_H
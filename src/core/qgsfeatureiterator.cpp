@@ -13,6 +13,7 @@
  *                                                                         *
  ***************************************************************************/
 #include "qgsfeatureiterator.h"
+#include "qgsfeaturebatch.h"
 #include "qgslogger.h"
 
 #include "qgssimplifymethod.h"
@@ -77,6 +78,41 @@ bool QgsAbstractFeatureIterator::nextFeature( QgsFeature &f )
   return dataOk;
 }
 
+int QgsAbstractFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  batch.clear();
+
+  if ( mRequest.limit() >= 0 )
+    maxFeatures = static_cast< int >( qMin( static_cast< long >( maxFeatures ), mRequest.limit() - mFetchedCount ) );
+  if ( maxFeatures <= 0 )
+    return 0;
+
+  if ( mUseCachedFeatures || ( mRequest.filterType() != QgsFeatureRequest::FilterNone && mRequest.filterType() != QgsFeatureRequest::FilterRect ) )
+  {
+    // filtering is done feature by feature, nextFeature() takes care of the fetched count
+    QgsFeature f;
+    while ( batch.count() < maxFeatures && nextFeature( f ) )
+      batch.appendFeature( f );
+    return batch.count();
+  }
+
+  int count = fetchBatch( batch, maxFeatures );
+  mFetchedCount += count;
+  return count;
+}
+
+int QgsAbstractFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  QgsFeature f;
+  int count = 0;
+  while ( count < maxFeatures && fetchFeature( f ) )
+  {
+    batch.appendFeature( f );
+    ++count;
+  }
+  return count;
+}
+
 bool QgsAbstractFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
 {
   while ( fetchFeature( f ) )
@@ -19,6 +19,7 @@
 #include "qgsfeaturerequest.h"
 #include "qgsindexedfeature.h"
 
+class QgsFeatureBatch;
 
 
 /** \ingroup core
@@ -58,6 +59,16 @@ class CORE_EXPORT QgsAbstractFeatureIterator
     //! fetch next feature, return true on success
     virtual bool nextFeature( QgsFeature &f );
 
+    /**
+     * Fetches up to \a maxFeatures next features into a columnar \a batch. The batch is
+     * cleared first and keeps its column layout. Returns the number of fetched features,
+     * 0 when the iteration is finished.
+     * \see fetchBatch()
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    virtual int nextBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     //! reset the iterator to the starting position
     virtual bool rewind() = 0;
     //! end of iterating: free the resources / lock
@@ -89,6 +100,19 @@ class CORE_EXPORT QgsAbstractFeatureIterator
      */
     virtual bool fetchFeature( QgsFeature &f ) = 0;
 
+    /**
+     * Appends up to \a maxFeatures next features to \a batch and returns how many
+     * were added. Providers which are able to fill the batch columns straight from
+     * their source data should reimplement this method - the default implementation
+     * calls fetchFeature() for each feature.
+     *
+     * This is only called for requests without an expression or feature ID filter,
+     * other requests are served feature by feature through nextFeature().
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     /**
      * By default, the iterator will fetch all features and check if the feature
      * matches the expression.
@@ -269,6 +293,15 @@ class CORE_EXPORT QgsFeatureIterator
     QgsFeatureIterator &operator=( const QgsFeatureIterator &other );
 
     bool nextFeature( QgsFeature &f );
+
+    /**
+     * Fetches up to \a maxFeatures next features into a columnar \a batch.
+     * Returns the number of fetched features, 0 when the iteration is finished.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    int nextBatch( QgsFeatureBatch &batch, int maxFeatures ) SIP_SKIP;
+
     bool rewind();
     bool close();
 
@@ -330,6 +363,11 @@ inline bool QgsFeatureIterator::nextFeature( QgsFeature &f )
   return mIter ? mIter->nextFeature( f ) : false;
 }
 
+inline int QgsFeatureIterator::nextBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  return mIter ? mIter->nextBatch( batch, maxFeatures ) : 0;
+}
+
 inline bool QgsFeatureIterator::rewind()
 {
   if ( mIter )
@@ -0,0 +1,117 @@
+/***************************************************************************
+  qgslabelcache.cpp
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgslabelcache.h"
+
+#include "qgsgeometry.h"
+#include "qgslabelfeature.h"
+#include "qgsmapsettings.h"
+
+#include <QDataStream>
+
+bool QgsLabelCache::init( const QgsMapSettings &settings )
+{
+  const QgsLabelingEngineSettings &engineSettings = settings.labelingEngineSettings();
+  int candPoint, candLine, candPolygon;
+  engineSettings.numCandidatePositions( candPoint, candLine, candPolygon );
+
+  QMutexLocker lock( &mMutex );
+
+  // labels of rotated maps are registered in a frame rotated around the
+  // center of the extent, which moves when the map is panned
+  if ( !qgsDoubleNear( settings.rotation(), 0.0 ) )
+  {
+    mPlacements.clear();
+    return false;
+  }
+
+  if ( qgsDoubleNear( settings.mapUnitsPerPixel(), mMapUnitsPerPixel ) &&
+       settings.destinationCrs() == mCrs &&
+       qgsDoubleNear( settings.outputDpi(), mDpi ) &&
+       engineSettings.flags() == mFlags &&
+       engineSettings.searchMethod() == mSearchMethod &&
+       candPoint == mCandPoint && candLine == mCandLine && candPolygon == mCandPolygon )
+    return true;
+
+  mPlacements.clear();
+
+  mMapUnitsPerPixel = settings.mapUnitsPerPixel();
+  mCrs = settings.destinationCrs();
+  mDpi = settings.outputDpi();
+  mFlags = engineSettings.flags();
+  mSearchMethod = engineSettings.searchMethod();
+  mCandPoint = candPoint;
+  mCandLine = candLine;
+  mCandPolygon = candPolygon;
+
+  return false;
+}
+
+void QgsLabelCache::clear()
+{
+  QMutexLocker lock( &mMutex );
+  mPlacements.clear();
+}
+
+void QgsLabelCache::clearLayer( const QString &layerId )
+{
+  QMutexLocker lock( &mMutex );
+  mPlacements.remove( layerId );
+}
+
+QgsLabelCache::FeaturePlacements QgsLabelCache::placements( const QString &layerId, const QString &providerId ) const
+{
+  QMutexLocker lock( &mMutex );
+  return mPlacements.value( layerId ).value( providerId );
+}
+
+void QgsLabelCache::setPlacements( const Placements &placements )
+{
+  QMutexLocker lock( &mMutex );
+  mPlacements = placements;
+}
+
+uint QgsLabelCache::signature( const QgsLabelFeature *feature )
+{
+  QByteArray data;
+  QDataStream stream( &data, QIODevice::WriteOnly );
+  stream << feature->labelText()
+         << feature->size()
+         << feature->priority()
+         << feature->hasFixedAngle() << feature->fixedAngle()
+         << feature->hasFixedQuadrant() << feature->quadOffset()
+         << feature->positionOffset().x() << feature->positionOffset().y()
+         << feature->distLabel() << feature->repeatDistance()
+         << static_cast< int >( feature->offsetType() )
+         << feature->alwaysShow();
+  Q_FOREACH ( QgsPalLayerSettings::PredefinedPointPosition position, feature->predefinedPositionOrder() )
+    stream << static_cast< int >( position );
+
+  if ( !feature->permissibleZone().isNull() )
+    data.append( feature->permissibleZone().exportToWkb() );
+
+  if ( feature->geometry() )
+  {
+    GEOSContextHandle_t geosctxt = QgsGeometry::getGEOSHandler();
+    size_t size = 0;
+    unsigned char *wkb = GEOSGeomToWKB_buf_r( geosctxt, feature->geometry(), &size );
+    if ( wkb )
+    {
+      data.append( reinterpret_cast< const char * >( wkb ), static_cast< int >( size ) );
+      GEOSFree_r( geosctxt, wkb );
+    }
+  }
+
+  return qHash( data );
+}
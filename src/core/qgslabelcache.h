@@ -0,0 +1,125 @@
+/***************************************************************************
+  qgslabelcache.h
+  --------------------------------------
+  Date                 : October 2017
+  Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSLABELCACHE_H
+#define QGSLABELCACHE_H
+
+#define SIP_NO_FILE
+
+#include "qgis_core.h"
+#include "qgsfeature.h"
+#include "qgscoordinatereferencesystem.h"
+#include "qgslabelingenginesettings.h"
+#include "qgspointxy.h"
+
+#include <QHash>
+#include <QMutex>
+
+class QgsLabelFeature;
+class QgsMapSettings;
+
+/** \ingroup core
+ * \brief The QgsLabelCache class keeps the placements of the labels from the
+ * last labeling solution, so that the labeling engine does not need to search
+ * the placement of all the labels again after the map is panned or zoomed.
+ *
+ * Each label which was placed keeps its previous placement as its only candidate,
+ * as long as the label feature did not change (see signature()) and the placement
+ * is still within the map extent. The other labels, e.g. those of features entering
+ * the view, get all their candidates and the problem is solved as usual.
+ *
+ * Placements are only valid for the map units per pixel, destination CRS, DPI
+ * and labeling engine settings they were computed for, see init().
+ *
+ * The class is thread-safe (the map renderer cache owning it is shared between
+ * successive rendering jobs).
+ *
+ * \note this class is not a part of public API yet. See notes in QgsLabelingEngine
+ * \since QGIS 3.0
+ * \note not available in Python bindings
+ */
+class CORE_EXPORT QgsLabelCache
+{
+  public:
+
+    //! Placement of a label in a previous labeling solution
+    struct Placement
+    {
+      //! Signature of the label feature the placement was computed for
+      uint signature = 0;
+      //! Coordinates of the down-left corner of the label, as passed to the pal::LabelPosition constructor
+      QgsPointXY position;
+      //! Angle of the label in radians, as passed to the pal::LabelPosition constructor
+      double angle = 0.0;
+      //! Whether the label is reversed
+      bool reversed = false;
+      //! Quadrant of the label (a pal::LabelPosition::Quadrant value)
+      int quadrant = 0;
+    };
+
+    //! Placements by feature id
+    typedef QHash< QgsFeatureId, Placement > FeaturePlacements;
+    //! Placements by layer id, then by provider id
+    typedef QHash< QString, QHash< QString, FeaturePlacements > > Placements;
+
+    QgsLabelCache() = default;
+
+    //! QgsLabelCache cannot be copied
+    QgsLabelCache( const QgsLabelCache &rh ) = delete;
+    //! QgsLabelCache cannot be copied
+    QgsLabelCache &operator=( const QgsLabelCache &rh ) = delete;
+
+    /**
+     * Prepares the cache for labeling a map with the given \a settings, and
+     * clears the cached placements if they were computed for other settings.
+     * \returns true if the cached placements may be reused
+     */
+    bool init( const QgsMapSettings &settings );
+
+    //! Clears all the cached placements
+    void clear();
+
+    //! Clears the cached placements of the labels of a layer
+    void clearLayer( const QString &layerId );
+
+    //! Returns the cached placements of the labels of a provider
+    FeaturePlacements placements( const QString &layerId, const QString &providerId ) const;
+
+    //! Replaces the cached placements by those of a new labeling solution
+    void setPlacements( const Placements &placements );
+
+    /**
+     * Returns a signature of the properties of a label \a feature which
+     * affect its placement, including its geometry. A cached placement is only
+     * reused if the signature of the feature did not change.
+     */
+    static uint signature( const QgsLabelFeature *feature );
+
+  private:
+
+    mutable QMutex mMutex;
+
+    double mMapUnitsPerPixel = 0;
+    QgsCoordinateReferenceSystem mCrs;
+    double mDpi = 0;
+    QgsLabelingEngineSettings::Flags mFlags;
+    QgsLabelingEngineSettings::Search mSearchMethod = QgsLabelingEngineSettings::Chain;
+    int mCandPoint = 0;
+    int mCandLine = 0;
+    int mCandPolygon = 0;
+
+    Placements mPlacements;
+};
+
+#endif // QGSLABELCACHE_H
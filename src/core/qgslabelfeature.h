@@ -7,6 +7,7 @@
 #include "qgspallabeling.h"
 #include "geos_c.h"
 #include "qgsmargins.h"
+#include "qgslabelcache.h"
 
 namespace pal
 {
@@ -164,6 +165,30 @@ class CORE_EXPORT QgsLabelFeature
     //! Set coordinates of the fixed position (relevant only if hasFixedPosition() returns true)
     void setFixedPosition( const QgsPointXY &point ) { mFixedPosition = point; }
 
+    /**
+     * Returns true if the label keeps its placement from a previous labeling
+     * solution, which is then its only candidate.
+     * \see cachedPlacement()
+     * \since QGIS 3.0
+     */
+    bool hasCachedPlacement() const { return mHasCachedPlacement; }
+
+    /**
+     * Returns the placement of the label in a previous labeling solution
+     * (relevant only if hasCachedPlacement() returns true).
+     * \see setCachedPlacement()
+     * \since QGIS 3.0
+     */
+    const QgsLabelCache::Placement &cachedPlacement() const { return mCachedPlacement; }
+
+    /**
+     * Sets the placement of the label in a previous labeling solution. Candidates
+     * are only searched for the label if this placement is outside of the map extent.
+     * \see cachedPlacement()
+     * \since QGIS 3.0
+     */
+    void setCachedPlacement( const QgsLabelCache::Placement &placement ) { mCachedPlacement = placement; mHasCachedPlacement = true; }
+
     //! Whether the label should use a fixed angle instead of using angle from automatic placement
     bool hasFixedAngle() const { return mHasFixedAngle; }
     //! Set whether the label should use a fixed angle instead of using angle from automatic placement
@@ -349,6 +374,10 @@ class CORE_EXPORT QgsLabelFeature
     QString mLabelText;
     //! extra information for curved labels (may be null)
     pal::LabelInfo *mInfo = nullptr;
+    //! whether the label keeps its placement from a previous solution
+    bool mHasCachedPlacement = false;
+    //! placement from a previous solution
+    QgsLabelCache::Placement mCachedPlacement;
 
   private:
 
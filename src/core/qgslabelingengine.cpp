@@ -25,6 +25,7 @@
 #include "problem.h"
 #include "qgsrendercontext.h"
 #include "qgsmaplayer.h"
+#include "qgslabelcache.h"
 
 
 // helper function for checking for job cancelation within PAL
@@ -33,6 +34,17 @@ static bool _palIsCanceled( void *ctx )
   return ( reinterpret_cast< QgsRenderContext * >( ctx ) )->renderingStopped();
 }
 
+// whether the labels of a provider may keep their placement between runs
+static bool _canCacheLabels( const QgsAbstractLabelProvider *provider )
+{
+  // merged lines, parts and curved labels are not a single straight label per feature
+  QgsAbstractLabelProvider::Flags flags = provider->flags();
+  return !flags.testFlag( QgsAbstractLabelProvider::MergeConnectedLines ) &&
+         !flags.testFlag( QgsAbstractLabelProvider::LabelPerFeaturePart ) &&
+         provider->placement() != QgsPalLayerSettings::Curved &&
+         provider->placement() != QgsPalLayerSettings::PerimeterCurved;
+}
+
 /** \ingroup core
  * \class QgsLabelSorter
  * Helper class for sorting labels into correct draw order
@@ -161,8 +173,20 @@ void QgsLabelingEngine::processProvider( QgsAbstractLabelProvider *provider, Qgs
 
   QList<QgsLabelFeature *> features = provider->labelFeatures( context );
 
+  QgsLabelCache::FeaturePlacements cachedPlacements;
+  if ( mUseLabelCache && _canCacheLabels( provider ) )
+    cachedPlacements = mLabelCache->placements( provider->layerId(), provider->providerId() );
+
   Q_FOREACH ( QgsLabelFeature *feature, features )
   {
+    if ( !cachedPlacements.isEmpty() && !feature->hasFixedPosition() )
+    {
+      // reuse the previous placement if nothing affecting it changed
+      QgsLabelCache::FeaturePlacements::const_iterator cached = cachedPlacements.constFind( feature->id() );
+      if ( cached != cachedPlacements.constEnd() && cached->signature == QgsLabelCache::signature( feature ) )
+        feature->setCachedPlacement( *cached );
+    }
+
     try
     {
       l->registerFeature( feature );
@@ -219,7 +243,9 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   p.setPolyP( candPolygon );
 
   p.setShowPartial( settings.testFlag( QgsLabelingEngineSettings::UsePartialCandidates ) );
+  p.setSplitProblems( settings.testFlag( QgsLabelingEngineSettings::SplitProblems ) );
 
+  mUseLabelCache = mLabelCache && mLabelCache->init( mMapSettings );
 
   // for each provider: get labels and register them in PAL
   Q_FOREACH ( QgsAbstractLabelProvider *provider, mProviders )
@@ -320,6 +346,9 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
   }
   painter->setRenderHint( QPainter::Antialiasing );
 
+  if ( mLabelCache )
+    updateLabelCache( *labels );
+
   // sort labels
   std::sort( labels->begin(), labels->end(), QgsLabelSorter( mMapSettings ) );
 
@@ -350,6 +379,37 @@ void QgsLabelingEngine::run( QgsRenderContext &context )
 
 }
 
+void QgsLabelingEngine::updateLabelCache( const QList<pal::LabelPosition *> &labels )
+{
+  QgsLabelCache::Placements placements;
+  Q_FOREACH ( pal::LabelPosition *label, labels )
+  {
+    QgsLabelFeature *lf = label->getFeaturePart()->feature();
+    if ( !lf || lf->hasFixedPosition() || lf->repeatDistance() > 0 || label->getNextPart() || !_canCacheLabels( lf->provider() ) )
+      continue;
+
+    QgsLabelCache::Placement placement;
+    placement.signature = QgsLabelCache::signature( lf );
+    if ( label->getUpsideDown() )
+    {
+      // the pal::LabelPosition constructor turns the label upside down again
+      placement.position = QgsPointXY( label->getX( 2 ), label->getY( 2 ) );
+      placement.angle = label->getAlpha() + M_PI;
+    }
+    else
+    {
+      placement.position = QgsPointXY( label->getX(), label->getY() );
+      placement.angle = label->getAlpha();
+    }
+    placement.reversed = label->getReversed();
+    placement.quadrant = label->getQuadrant();
+
+    placements[ lf->provider()->layerId()][ lf->provider()->providerId()].insert( lf->id(), placement );
+  }
+
+  mLabelCache->setPlacements( placements );
+}
+
 QgsLabelingResults *QgsLabelingEngine::takeResults()
 {
   return mResults.release();
@@ -26,6 +26,7 @@
 
 
 class QgsLabelingEngine;
+class QgsLabelCache;
 
 
 /** \ingroup core
@@ -190,6 +191,15 @@ class CORE_EXPORT QgsLabelingEngine
      */
     QList< QgsMapLayer * > participatingLayers() const;
 
+    /**
+     * Sets a \a cache keeping the label placements between runs of the engine.
+     * Labels which were placed by the previous run keep their placement, so that
+     * only the placement of new or changed labels needs to be searched. The cache
+     * is not owned by the engine and may be null to disable it.
+     * \since QGIS 3.0
+     */
+    void setLabelCache( QgsLabelCache *cache ) { mLabelCache = cache; }
+
     //! Add provider of label features. Takes ownership of the provider
     void addProvider( QgsAbstractLabelProvider *provider );
 
@@ -208,6 +218,9 @@ class CORE_EXPORT QgsLabelingEngine
   protected:
     void processProvider( QgsAbstractLabelProvider *provider, QgsRenderContext &context, pal::Pal &p );
 
+    //! Stores the placements of the \a labels of the solution in the label cache
+    void updateLabelCache( const QList<pal::LabelPosition *> &labels );
+
   protected:
     //! Associated map settings instance
     QgsMapSettings mMapSettings;
@@ -219,6 +232,11 @@ class CORE_EXPORT QgsLabelingEngine
     //! Resulting labeling layout
     std::unique_ptr< QgsLabelingResults > mResults;
 
+    //! Cache of the label placements between runs (not owned)
+    QgsLabelCache *mLabelCache = nullptr;
+    //! Whether the cached placements are valid for the current map settings
+    bool mUseLabelCache = false;
+
 };
 
 
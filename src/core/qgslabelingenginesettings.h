@@ -22,6 +22,7 @@ class CORE_EXPORT QgsLabelingEngineSettings
       RenderOutlineLabels   = 1 << 3,  //!< Whether to render labels as text or outlines
       DrawLabelRectOnly     = 1 << 4,  //!< Whether to only draw the label rect and not the actual label text (used for unit tests)
       DrawCandidates        = 1 << 5,  //!< Whether to draw rectangles of generated candidates (good for debugging)
+      SplitProblems         = 1 << 6,  //!< Whether to solve independent groups of labels concurrently. Faster on large maps, but the placement may differ from the default search. Since QGIS 3.0
     };
     Q_DECLARE_FLAGS( Flags, Flag )
 
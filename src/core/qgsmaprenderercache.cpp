@@ -45,6 +45,8 @@ void QgsMapRendererCache::clearInternal()
   }
   mCachedImages.clear();
   mConnectedLayers.clear();
+  mLabelCache.clear();
+  mLabelCacheLayers.clear();
 }
 
 void QgsMapRendererCache::dropUnusedConnections()
@@ -63,6 +65,16 @@ void QgsMapRendererCache::dropUnusedConnections()
   mConnectedLayers = stillDepends;
 }
 
+void QgsMapRendererCache::connectLayer( QgsMapLayer *layer )
+{
+  if ( mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
+    return;
+
+  connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
+  connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
+  mConnectedLayers << layer;
+}
+
 QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
 {
   QSet< QgsWeakMapLayerPointer > result;
@@ -75,6 +87,11 @@ QSet<QgsWeakMapLayerPointer > QgsMapRendererCache::dependentLayers() const
         result << l;
     }
   }
+  Q_FOREACH ( const QgsWeakMapLayerPointer &l, mLabelCacheLayers )
+  {
+    if ( l.data() )
+      result << l;
+  }
   return result;
 }
 
@@ -87,7 +104,9 @@ bool QgsMapRendererCache::init( const QgsRectangle &extent, double scale )
        qgsDoubleNear( scale, mScale ) )
     return true;
 
-  clearInternal();
+  // the label placements remain valid for another extent, see QgsLabelCache::init()
+  mCachedImages.clear();
+  dropUnusedConnections();
 
   // set new params
   mExtent = extent;
@@ -109,18 +128,29 @@ void QgsMapRendererCache::setCacheImage( const QString &cacheKey, const QImage &
     if ( layer )
     {
       params.dependentLayers << layer;
-      if ( !mConnectedLayers.contains( QgsWeakMapLayerPointer( layer ) ) )
-      {
-        connect( layer, &QgsMapLayer::repaintRequested, this, &QgsMapRendererCache::layerRequestedRepaint );
-        connect( layer, &QgsMapLayer::willBeDeleted, this, &QgsMapRendererCache::layerRequestedRepaint );
-        mConnectedLayers << layer;
-      }
+      connectLayer( layer );
     }
   }
 
   mCachedImages[cacheKey] = params;
 }
 
+void QgsMapRendererCache::setLabelCacheLayers( const QList<QgsMapLayer *> &layers )
+{
+  QMutexLocker lock( &mMutex );
+
+  mLabelCacheLayers.clear();
+  Q_FOREACH ( QgsMapLayer *layer, layers )
+  {
+    if ( layer )
+    {
+      mLabelCacheLayers << layer;
+      connectLayer( layer );
+    }
+  }
+  dropUnusedConnections();
+}
+
 bool QgsMapRendererCache::hasCacheImage( const QString &cacheKey ) const
 {
   return mCachedImages.contains( cacheKey );
@@ -161,6 +191,11 @@ void QgsMapRendererCache::layerRequestedRepaint()
 
     it = mCachedImages.erase( it );
   }
+  if ( mLabelCacheLayers.contains( layer ) )
+  {
+    mLabelCache.clearLayer( layer->id() );
+    mLabelCacheLayers.removeAll( layer );
+  }
   dropUnusedConnections();
 }
 
@@ -23,6 +23,7 @@
 
 #include "qgsrectangle.h"
 #include "qgsmaplayer.h"
+#include "qgslabelcache.h"
 
 
 /** \ingroup core
@@ -34,6 +35,11 @@
  * If triggered, the cache removes the rendered image (and disconnects from the
  * layers).
  *
+ * The cache also keeps the placements of the labels from the last labeling
+ * solution (see QgsLabelCache), which unlike the images remain valid when the
+ * map is panned. The placements of the labels of a layer are cleared when the
+ * layer requests a repaint.
+ *
  * The class is thread-safe (multiple classes can access the same instance safely).
  *
  * \since QGIS 2.4
@@ -96,6 +102,22 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
      */
     void clearCacheImage( const QString &cacheKey );
 
+    /**
+     * Returns the cache of label placements, used by the labeling engine.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    QgsLabelCache *labelCache() SIP_SKIP { return &mLabelCache; }
+
+    /**
+     * Sets the \a layers whose labels have their placements in the label cache.
+     * The placements of the labels of a layer are cleared when it requests a repaint.
+     * \note not available in Python bindings
+     * \see labelCache()
+     * \since QGIS 3.0
+     */
+    void setLabelCacheLayers( const QList< QgsMapLayer * > &layers ) SIP_SKIP;
+
   private slots:
     //! Remove layer (that emitted the signal) from the cache
     void layerRequestedRepaint();
@@ -111,6 +133,9 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     //! Invalidate cache contents (without locking)
     void clearInternal();
 
+    //! Connects to the signals of a layer the cache depends on (without locking)
+    void connectLayer( QgsMapLayer *layer );
+
     //! Disconnects from layers we no longer care about
     void dropUnusedConnections();
 
@@ -124,6 +149,11 @@ class CORE_EXPORT QgsMapRendererCache : public QObject
     QMap<QString, CacheParameters> mCachedImages;
     //! List of all layers on which this cache is currently connected
     QSet< QgsWeakMapLayerPointer > mConnectedLayers;
+
+    //! Placements of the labels from the last labeling solution
+    QgsLabelCache mLabelCache;
+    //! Layers whose labels have their placements in the label cache
+    QgsWeakMapLayerPointerList mLabelCacheLayers;
 };
 
 
@@ -18,6 +18,7 @@
 #include <QPainter>
 #include <QTime>
 #include <QTimer>
+#include <QThreadPool>
 #include <QtConcurrentMap>
 
 #include "qgslogger.h"
@@ -36,6 +37,10 @@
 #include "qgsmaplayerlistutils.h"
 #include "qgsvectorlayerlabeling.h"
 #include "qgssettings.h"
+#include "qgsrenderer.h"
+#include "qgspainteffect.h"
+#include "qgssymbol.h"
+#include "qgssymbollayer.h"
 
 ///@cond PRIVATE
 
@@ -344,6 +349,265 @@ LayerRenderJobs QgsMapRendererJob::prepareJobs( QPainter *painter, QgsLabelingEn
   return layerJobs;
 }
 
+LayerRenderJobs QgsMapRendererJob::prepareTileJobs( LayerRenderJobs &jobs )
+{
+  LayerRenderJobs tileJobs;
+
+  // tile extents are calculated from axis-aligned pixel rectangles
+  if ( !mSettings.testFlag( QgsMapSettings::RenderLayerTiles ) || !qgsDoubleNear( mSettings.rotation(), 0.0 ) )
+    return tileJobs;
+
+  // only split layers if there are more threads available than layers to render
+  int jobsToRender = 0;
+  for ( LayerRenderJobs::const_iterator it = jobs.constBegin(); it != jobs.constEnd(); ++it )
+  {
+    if ( !it->cached && it->renderer )
+      jobsToRender++;
+  }
+  if ( jobsToRender == 0 )
+    return tileJobs;
+
+  int tileCount = QThreadPool::globalInstance()->maxThreadCount() / jobsToRender;
+
+  // smaller tiles are not worth the overhead of extra feature requests and symbol setup
+  static const int MIN_TILE_SIZE = 256;
+
+  const QSize outputSize = mSettings.outputSize();
+  int columns = std::min( static_cast< int >( std::ceil( std::sqrt( static_cast< double >( tileCount ) ) ) ), outputSize.width() / MIN_TILE_SIZE );
+  columns = std::max( columns, 1 );
+  int rows = std::min( tileCount / columns, outputSize.height() / MIN_TILE_SIZE );
+  rows = std::max( rows, 1 );
+  if ( columns * rows < 2 )
+    return tileJobs;
+
+  const QgsMapToPixel &mtp = mSettings.mapToPixel();
+
+  for ( LayerRenderJobs::iterator it = jobs.begin(); it != jobs.end(); ++it )
+  {
+    LayerRenderJob &job = *it;
+    QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( job.layer.data() );
+    QgsVectorLayerRenderer *parentRenderer = dynamic_cast<QgsVectorLayerRenderer *>( job.renderer );
+    if ( !vl || !parentRenderer )
+      continue;
+
+    bool hasStyleOverride = mSettings.layerStyleOverrides().contains( vl->id() );
+    if ( hasStyleOverride )
+      vl->styleManager()->setOverrideStyle( mSettings.layerStyleOverrides().value( vl->id() ) );
+
+    // features just outside of a tile may still have symbols reaching into it
+    int margin = 0;
+    int firstTileJob = tileJobs.count();
+    bool valid = canRenderLayerInTiles( job, margin ) && margin < MIN_TILE_SIZE;
+    for ( int row = 0; valid && row < rows; ++row )
+    {
+      for ( int column = 0; valid && column < columns; ++column )
+      {
+        QRect tileRect( QPoint( column * outputSize.width() / columns, row * outputSize.height() / rows ),
+                        QPoint( ( column + 1 ) * outputSize.width() / columns - 1, ( row + 1 ) * outputSize.height() / rows - 1 ) );
+
+        QRect requestRect = tileRect.adjusted( -margin, -margin, margin, margin );
+        QgsRectangle r1( mtp.toMapCoordinates( requestRect.left(), requestRect.top() ),
+                         mtp.toMapCoordinates( requestRect.right() + 1, requestRect.bottom() + 1 ) ), r2;
+        QgsCoordinateTransform ct = job.context.coordinateTransform();
+        if ( ct.isValid() )
+        {
+          reprojectToLayerExtent( vl, ct, r1, r2 );
+        }
+        if ( !r1.isFinite() || !r2.isFinite() )
+        {
+          valid = false;
+          break;
+        }
+
+        QImage *img = new QImage( tileRect.size(), mSettings.outputImageFormat() );
+        if ( img->isNull() )
+        {
+          delete img;
+          valid = false;
+          break;
+        }
+
+        tileJobs.append( LayerRenderJob() );
+        LayerRenderJob &tileJob = tileJobs.last();
+        tileJob.cached = false;
+        tileJob.img = img;
+        tileJob.blendMode = job.blendMode;
+        tileJob.opacity = job.opacity;
+        tileJob.layer = vl;
+        tileJob.renderingTime = -1;
+        tileJob.tileRect = tileRect;
+        tileJob.parentJob = &job;
+
+        // labeling engine is left unset - labels are registered through the parent renderer's providers
+        tileJob.context = QgsRenderContext::fromMapSettings( mSettings );
+        tileJob.context.expressionContext().appendScope( QgsExpressionContextUtils::layerScope( vl ) );
+        tileJob.context.setCoordinateTransform( ct );
+        tileJob.context.setExtent( r1 );
+        if ( mFeatureFilterProvider )
+          tileJob.context.setFeatureFilterProvider( mFeatureFilterProvider );
+
+        QPainter *tilePainter = new QPainter( tileJob.img );
+        tilePainter->setRenderHint( QPainter::Antialiasing, mSettings.testFlag( QgsMapSettings::Antialiasing ) );
+        tilePainter->translate( -tileRect.topLeft() );
+        tileJob.context.setPainter( tilePainter );
+
+        tileJob.renderer = new QgsVectorLayerRenderer( vl, tileJob.context, parentRenderer, tileRect, outputSize );
+      }
+    }
+
+    if ( hasStyleOverride )
+      vl->styleManager()->restoreOverrideStyle();
+
+    if ( !valid )
+    {
+      // render the layer as a whole
+      while ( tileJobs.count() > firstTileJob )
+      {
+        LayerRenderJob tileJob = tileJobs.takeLast();
+        delete tileJob.renderer;
+        delete tileJob.context.painter();
+        delete tileJob.img;
+      }
+      continue;
+    }
+
+    job.tiled = true;
+  }
+
+  return tileJobs;
+}
+
+void QgsMapRendererJob::composeTileJobs( const LayerRenderJobs &tileJobs )
+{
+  for ( LayerRenderJobs::const_iterator it = tileJobs.constBegin(); it != tileJobs.constEnd(); ++it )
+  {
+    const LayerRenderJob &tileJob = *it;
+    LayerRenderJob *job = tileJob.parentJob;
+    if ( !job || !job->img )
+      continue;
+
+    if ( !job->imageInitialized )
+    {
+      job->img->fill( 0 );
+      job->imageInitialized = true;
+    }
+
+    job->renderingTime = std::max( job->renderingTime, tileJob.renderingTime );
+
+    if ( !tileJob.imageInitialized )
+      continue; // tile was not rendered
+
+    job->context.painter()->drawImage( tileJob.tileRect.topLeft(), *tileJob.img );
+  }
+
+  // the tiles registered their features for labeling in whatever order they were drawn
+  QSet< LayerRenderJob * > parentJobs;
+  for ( LayerRenderJobs::const_iterator it = tileJobs.constBegin(); it != tileJobs.constEnd(); ++it )
+  {
+    if ( it->parentJob )
+      parentJobs.insert( it->parentJob );
+  }
+  Q_FOREACH ( LayerRenderJob *job, parentJobs )
+  {
+    if ( QgsVectorLayerRenderer *renderer = dynamic_cast< QgsVectorLayerRenderer * >( job->renderer ) )
+      renderer->sortLabelFeatures();
+  }
+}
+
+/**
+ * Returns the largest distance in pixels from a feature at which \a symbol may draw,
+ * or -1 if the distance is unknown (e.g. it depends on data defined properties).
+ */
+static double maxSymbolExtent( QgsSymbol *symbol, QgsRenderContext &context )
+{
+  // symbol layer types whose extent is known from their bounds or estimated bleed
+  static const QStringList BOUNDED_LAYER_TYPES = QStringList()
+      << QStringLiteral( "SimpleMarker" ) << QStringLiteral( "FilledMarker" ) << QStringLiteral( "SvgMarker" )
+      << QStringLiteral( "FontMarker" ) << QStringLiteral( "EllipseMarker" )
+      << QStringLiteral( "SimpleLine" ) << QStringLiteral( "MarkerLine" )
+      << QStringLiteral( "SimpleFill" ) << QStringLiteral( "GradientFill" ) << QStringLiteral( "ShapeburstFill" )
+      << QStringLiteral( "SVGFill" ) << QStringLiteral( "LinePatternFill" ) << QStringLiteral( "PointPatternFill" )
+      << QStringLiteral( "CentroidFill" ) << QStringLiteral( "RasterFill" );
+
+  if ( !symbol || symbol->hasDataDefinedProperties() )
+    return -1;
+
+  double markerExtent = 0;
+  if ( symbol->type() == QgsSymbol::Marker )
+  {
+    QRectF bounds = static_cast< QgsMarkerSymbol * >( symbol )->bounds( QPointF( 0, 0 ), context );
+    markerExtent = std::max( std::max( std::fabs( bounds.left() ), std::fabs( bounds.right() ) ),
+                             std::max( std::fabs( bounds.top() ), std::fabs( bounds.bottom() ) ) );
+  }
+
+  double extent = markerExtent;
+  for ( int i = 0; i < symbol->symbolLayerCount(); ++i )
+  {
+    QgsSymbolLayer *layer = symbol->symbolLayer( i );
+    if ( !BOUNDED_LAYER_TYPES.contains( layer->layerType() ) )
+      return -1;
+    if ( layer->paintEffect() && layer->paintEffect()->enabled() )
+      return -1;
+
+    double layerExtent = markerExtent + layer->estimateMaxBleed( context );
+    if ( layer->subSymbol() )
+    {
+      double subSymbolExtent = maxSymbolExtent( layer->subSymbol(), context );
+      if ( subSymbolExtent < 0 )
+        return -1;
+      layerExtent += subSymbolExtent;
+    }
+    extent = std::max( extent, layerExtent );
+  }
+  return extent;
+}
+
+bool QgsMapRendererJob::canRenderLayerInTiles( const LayerRenderJob &job, int &margin )
+{
+  if ( job.cached || !job.renderer || !job.img )
+    return false;
+
+  QgsVectorLayer *vl = qobject_cast<QgsVectorLayer *>( job.layer.data() );
+  if ( !vl || !vl->renderer() )
+    return false;
+
+  // renderers combining several features (heatmap, point displacement, inverted polygons...)
+  // need to see all of them at once
+  QString rendererType = vl->renderer()->type();
+  if ( rendererType != QLatin1String( "singleSymbol" ) &&
+       rendererType != QLatin1String( "categorizedSymbol" ) &&
+       rendererType != QLatin1String( "graduatedSymbol" ) &&
+       rendererType != QLatin1String( "RuleRenderer" ) )
+    return false;
+
+  // layer paint effects are applied to the whole rendered layer
+  if ( vl->renderer()->paintEffect() && vl->renderer()->paintEffect()->enabled() )
+    return false;
+
+  // symbols reaching arbitrarily far away from their features would be cut at the tile seams
+  QgsRenderContext context( job.context );
+  std::unique_ptr< QgsFeatureRenderer > renderer( vl->renderer()->clone() );
+  renderer->startRender( context, vl->fields() );
+  double extent = 0;
+  Q_FOREACH ( QgsSymbol *symbol, renderer->symbols( context ) )
+  {
+    double symbolExtent = maxSymbolExtent( symbol, context );
+    if ( symbolExtent < 0 )
+    {
+      extent = -1;
+      break;
+    }
+    extent = std::max( extent, symbolExtent );
+  }
+  renderer->stopRender( context );
+  if ( extent < 0 )
+    return false;
+
+  // plus a pixel of antialiasing
+  margin = static_cast< int >( std::ceil( extent ) ) + 1;
+  return true;
+}
+
 LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool canUseLabelCache )
 {
   LabelRenderJob job;
@@ -378,6 +642,10 @@ LabelRenderJob QgsMapRendererJob::prepareLabelingJob( QPainter *painter, QgsLabe
       else
       {
         job.img = mypFlattenedImage;
+
+        // labels keep their placements from the previous rendering, see cleanupLabelJob()
+        if ( mCache && labelingEngine2 )
+          labelingEngine2->setLabelCache( mCache->labelCache() );
       }
     }
   }
@@ -396,7 +664,7 @@ void QgsMapRendererJob::cleanupJobs( LayerRenderJobs &jobs )
       delete job.context.painter();
       job.context.setPainter( nullptr );
 
-      if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer )
+      if ( mCache && !job.cached && !job.context.renderingStopped() && job.layer && !job.parentJob )
       {
         QgsDebugMsg( "caching image for " + ( job.layer ? job.layer->id() : QString() ) );
         mCache->setCacheImage( job.layer->id(), *job.img, QList< QgsMapLayer * >() << job.layer );
@@ -428,6 +696,7 @@ void QgsMapRendererJob::cleanupLabelJob( LabelRenderJob &job )
     {
       QgsDebugMsg( "caching label result image" );
       mCache->setCacheImage( LABEL_CACHE_ID, *job.img, _qgis_listQPointerToRaw( job.participatingLayers ) );
+      mCache->setLabelCacheLayers( _qgis_listQPointerToRaw( job.participatingLayers ) );
     }
 
     delete job.img;
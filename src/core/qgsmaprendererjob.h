@@ -54,6 +54,12 @@ struct LayerRenderJob
   bool cached; // if true, img already contains cached image from previous rendering
   QgsWeakMapLayerPointer layer;
   int renderingTime; //!< Time it took to render the layer in ms (it is -1 if not rendered or still rendering)
+  //! True if the layer is drawn by separate tile jobs rather than by this job's renderer
+  bool tiled = false;
+  //! Pixel rectangle of the map drawn by this job if it renders just a tile of a layer (null otherwise)
+  QRect tileRect;
+  //! Job of the whole layer which the tile image gets composed into (only set for tile jobs)
+  LayerRenderJob *parentJob = nullptr;
 };
 
 typedef QList<LayerRenderJob> LayerRenderJobs;
@@ -243,6 +249,24 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
      */
     LabelRenderJob prepareLabelingJob( QPainter *painter, QgsLabelingEngine *labelingEngine2, bool canUseLabelCache = true ) SIP_SKIP;
 
+    /**
+     * Splits rendering of suitable vector layers from \a jobs into tiles, so that otherwise
+     * idle threads can draw parts of a single layer in parallel. Does nothing unless the
+     * QgsMapSettings::RenderLayerTiles flag is set. The layer jobs which get split are marked
+     * as tiled and must not be rendered themselves, instead the images of the returned tile
+     * jobs are composed into them with composeTileJobs().
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    LayerRenderJobs prepareTileJobs( LayerRenderJobs &jobs ) SIP_SKIP;
+
+    /**
+     * Draws images of finished tile jobs into the images of their parent layer jobs.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    static void composeTileJobs( const LayerRenderJobs &tileJobs ) SIP_SKIP;
+
     //! \note not available in Python bindings
     static QImage composeImage( const QgsMapSettings &settings, const LayerRenderJobs &jobs, const LabelRenderJob &labelJob ) SIP_SKIP;
 
@@ -275,6 +299,13 @@ class CORE_EXPORT QgsMapRendererJob : public QObject
 
     bool needTemporaryImage( QgsMapLayer *ml );
 
+    /**
+     * Returns true if the layer rendered by the job gives identical output when drawn as separate tiles.
+     * The \a margin in pixels by which the tiles must be extended to catch all the symbols reaching
+     * into them is set to the largest distance the symbols of the layer may draw at from the features.
+     */
+    static bool canRenderLayerInTiles( const LayerRenderJob &job, int &margin );
+
     const QgsFeatureFilterProvider *mFeatureFilterProvider = nullptr;
 };
 
@@ -59,15 +59,27 @@ void QgsMapRendererParallelJob::start()
 
   bool canUseLabelCache = prepareLabelCache();
   mLayerJobs = prepareJobs( nullptr, mLabelingEngineV2.get() );
+  mTileJobs = prepareTileJobs( mLayerJobs );
   mLabelJob = prepareLabelingJob( nullptr, mLabelingEngineV2.get(), canUseLabelCache );
 
+  mRenderQueue.clear();
+  for ( LayerRenderJobs::iterator it = mLayerJobs.begin(); it != mLayerJobs.end(); ++it )
+  {
+    if ( !it->tiled )
+      mRenderQueue << &( *it );
+  }
+  for ( LayerRenderJobs::iterator it = mTileJobs.begin(); it != mTileJobs.end(); ++it )
+  {
+    mRenderQueue << &( *it );
+  }
+
   QgsDebugMsg( QString( "QThreadPool max thread count is %1" ).arg( QThreadPool::globalInstance()->maxThreadCount() ) );
 
   // start async job
 
   connect( &mFutureWatcher, &QFutureWatcher<void>::finished, this, &QgsMapRendererParallelJob::renderLayersFinished );
 
-  mFuture = QtConcurrent::map( mLayerJobs, renderLayerStatic );
+  mFuture = QtConcurrent::map( mRenderQueue, renderQueuedJobStatic );
   mFutureWatcher.setFuture( mFuture );
 }
 
@@ -85,6 +97,12 @@ void QgsMapRendererParallelJob::cancel()
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
   }
+  for ( LayerRenderJobs::iterator it = mTileJobs.begin(); it != mTileJobs.end(); ++it )
+  {
+    it->context.setRenderingStopped( true );
+    if ( it->renderer && it->renderer->feedback() )
+      it->renderer->feedback()->cancel();
+  }
 
   if ( mStatus == RenderingLayers )
   {
@@ -121,6 +139,12 @@ void QgsMapRendererParallelJob::cancelWithoutBlocking()
     if ( it->renderer && it->renderer->feedback() )
       it->renderer->feedback()->cancel();
   }
+  for ( LayerRenderJobs::iterator it = mTileJobs.begin(); it != mTileJobs.end(); ++it )
+  {
+    it->context.setRenderingStopped( true );
+    if ( it->renderer && it->renderer->feedback() )
+      it->renderer->feedback()->cancel();
+  }
 
   if ( mStatus == RenderingLayers )
   {
@@ -195,6 +219,8 @@ void QgsMapRendererParallelJob::renderLayersFinished()
 {
   Q_ASSERT( mStatus == RenderingLayers );
 
+  composeTileJobs( mTileJobs );
+
   // compose final image
   mFinalImage = composeImage( mSettings, mLayerJobs, mLabelJob );
 
@@ -223,6 +249,10 @@ void QgsMapRendererParallelJob::renderingFinished()
 
   logRenderingTime( mLayerJobs, mLabelJob );
 
+  // tile renderers share label providers of the layer renderers, so clean them up first
+  cleanupJobs( mTileJobs );
+  mRenderQueue.clear();
+
   cleanupJobs( mLayerJobs );
 
   cleanupLabelJob( mLabelJob );
@@ -273,6 +303,10 @@ void QgsMapRendererParallelJob::renderLayerStatic( LayerRenderJob &job )
   QgsDebugMsgLevel( QString( "job %1 end [%2 ms] (layer %3)" ).arg( reinterpret_cast< quint64 >( &job ), 0, 16 ).arg( job.renderingTime ).arg( job.layer ? job.layer->id() : QString() ), 2 );
 }
 
+void QgsMapRendererParallelJob::renderQueuedJobStatic( LayerRenderJob *job )
+{
+  renderLayerStatic( *job );
+}
 
 void QgsMapRendererParallelJob::renderLabelsStatic( QgsMapRendererParallelJob *self )
 {
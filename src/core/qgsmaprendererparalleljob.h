@@ -58,6 +58,8 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     //! \note not available in Python bindings
     static void renderLayerStatic( LayerRenderJob &job ) SIP_SKIP;
     //! \note not available in Python bindings
+    static void renderQueuedJobStatic( LayerRenderJob *job ) SIP_SKIP;
+    //! \note not available in Python bindings
     static void renderLabelsStatic( QgsMapRendererParallelJob *self ) SIP_SKIP;
 
     QImage mFinalImage;
@@ -69,6 +71,10 @@ class CORE_EXPORT QgsMapRendererParallelJob : public QgsMapRendererQImageJob
     QFutureWatcher<void> mFutureWatcher;
 
     LayerRenderJobs mLayerJobs;
+    //! Jobs rendering tiles of layers which are split for parallel rendering
+    LayerRenderJobs mTileJobs;
+    //! Layer and tile jobs to be rendered by worker threads
+    QList< LayerRenderJob * > mRenderQueue;
     LabelRenderJob mLabelJob;
 
     //! New labeling engine
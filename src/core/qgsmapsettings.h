@@ -188,6 +188,7 @@ class CORE_EXPORT QgsMapSettings
       DrawSymbolBounds         = 0x80,  //!< Draw bounds of symbols (for debugging/testing)
       RenderMapTile            = 0x100, //!< Draw map such that there are no problems between adjacent tiles
       RenderPartialOutput      = 0x200, //!< Whether to make extra effort to update map image with partially rendered layers (better for interactive map canvas). Added in QGIS 3.0
+      RenderLayerTiles         = 0x400, //!< Split rendering of individual vector layers into tiles rendered in parallel when threads are idle (QgsMapRendererParallelJob only). The labels of the tiled layers are registered in feature id order rather than in the order of the data provider. Added in QGIS 3.0
       // TODO: ignore scale-based visibility (overview)
     };
     Q_DECLARE_FLAGS( Flags, Flag )
@@ -21,6 +21,7 @@
 #include <QVector>
 #include <QTransform>
 
+#include "qgsgeometrykernels.h"
 #include "qgslogger.h"
 #include "qgspointxy.h"
 
@@ -261,6 +262,11 @@ void QgsMapToPixel::transformInPlace( float &x, float &y ) const
   y = my;
 }
 
+void QgsMapToPixel::transformInPlace( QPolygonF &points ) const
+{
+  QgsGeometryKernels::transform( points, mMatrix );
+}
+
 QTransform QgsMapToPixel::transform() const
 {
   // NOTE: operations are done in the reverse order in which
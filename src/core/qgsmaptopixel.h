@@ -19,6 +19,7 @@
 
 #include "qgis_core.h"
 #include "qgis_sip.h"
+#include <QPolygonF>
 #include <QTransform>
 #include <vector>
 #include "qgsunittypes.h"
@@ -113,6 +114,14 @@ class CORE_EXPORT QgsMapToPixel
       for ( int i = 0; i < x.size(); ++i )
         transformInPlace( x[i], y[i] );
     }
+
+    /**
+     * Transforms the map coordinates of \a points to device coordinates in place,
+     * all at once. Intended as a fast way to transform the vertices of geometries.
+     * \note not available in Python bindings
+     * \since QGIS 3.0
+     */
+    void transformInPlace( QPolygonF &points ) const SIP_SKIP;
 #endif
 
     QgsPointXY toMapCoordinates( int x, int y ) const;
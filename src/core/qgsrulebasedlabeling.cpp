@@ -48,6 +48,13 @@ void QgsRuleBasedLabelProvider::registerFeature( QgsFeature &feature, QgsRenderC
   mRules->rootRule()->registerFeature( feature, context, mSubProviders, obstacleGeometry );
 }
 
+void QgsRuleBasedLabelProvider::sortLabelFeatures()
+{
+  // features are registered with the sub-providers
+  Q_FOREACH ( QgsVectorLayerLabelProvider *provider, mSubProviders )
+    provider->sortLabelFeatures();
+}
+
 QList<QgsAbstractLabelProvider *> QgsRuleBasedLabelProvider::subProviders()
 {
   QList<QgsAbstractLabelProvider *> lst;
@@ -25,6 +25,16 @@
 
 #include "SpatialIndex.h"
 
+#include <QFile>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <queue>
+
 using namespace SpatialIndex;
 
 
@@ -150,6 +160,464 @@ class QgsFeatureIteratorDataStream : public IDataStream
 };
 
 
+/** \ingroup core
+ * \class QgsPackedRTree
+ * \brief Read-only packed Hilbert R-tree loaded from a file written by QgsSpatialIndex::writeToFile().
+ *
+ * The file starts with a header, followed by the end offsets of the tree levels and by
+ * the entries of all levels, leaves first. Leaf entries are sorted along the Hilbert curve
+ * of their centers and hold feature IDs, entries of the upper levels hold the index of
+ * their first child. All nodes except the last one of a level are full.
+ *
+ * The file is memory-mapped, so opening it does not depend on the size of the index.
+ * \note not available in Python bindings
+ */
+class QgsPackedRTree
+{
+  public:
+
+    struct Entry
+    {
+      double xMin;
+      double yMin;
+      double xMax;
+      double yMax;
+      qint64 value;
+    };
+
+    QgsPackedRTree() = default;
+
+    /**
+     * Sorts \a items and writes them as a packed R-tree to \a fileName, together with the
+     * modification time and feature count of the data source used for validation.
+     */
+    static bool write( const QString &fileName, QVector<Entry> &items, const QDateTime &sourceModified, long sourceFeatureCount );
+
+    /**
+     * Maps the packed R-tree from \a fileName. Returns false if the file is not a valid
+     * index or it does not match \a sourceModified (if valid) and \a sourceFeatureCount
+     * (if not negative).
+     */
+    bool open( const QString &fileName, const QDateTime &sourceModified, long sourceFeatureCount );
+
+    //! Returns number of indexed items
+    int count() const { return mHeader ? static_cast< int >( mHeader->itemCount ) : 0; }
+
+    //! Returns the indexed items (leaf entries)
+    const Entry *items() const { return mEntries; }
+
+    void intersects( const QgsRectangle &rect, QList<QgsFeatureId> &list ) const;
+
+    void nearestNeighbor( const QgsPointXY &point, int neighbors, QList<QgsFeatureId> &list ) const;
+
+  private:
+
+    struct Header
+    {
+      char magic[8];
+      quint32 version;
+      quint32 byteOrder;
+      quint32 nodeSize;
+      quint32 levelCount;
+      quint64 itemCount;
+      quint64 entryCount;
+      qint64 sourceModified;
+      qint64 sourceFeatureCount;
+    };
+
+    struct Candidate
+    {
+      double distance;
+      quint64 index;
+      int level;
+
+      bool operator>( const Candidate &other ) const { return distance > other.distance; }
+    };
+
+    static const char MAGIC[8];
+    static const quint32 VERSION = 1;
+    static const quint32 BYTE_ORDER = 0x01020304;
+    static const quint32 NODE_SIZE = 16;
+
+    static quint32 hilbert( quint32 x, quint32 y );
+
+    bool children( const Entry &entry, int level, quint64 &begin, quint64 &end ) const;
+
+    QFile mFile;
+    QByteArray mBuffer;
+    const Header *mHeader = nullptr;
+    const quint64 *mLevelEnds = nullptr;
+    const Entry *mEntries = nullptr;
+
+    Q_DISABLE_COPY( QgsPackedRTree )
+};
+
+const char QgsPackedRTree::MAGIC[8] = { 'Q', 'G', 'S', 'R', 'T', 'R', 'E', 'E' };
+
+quint32 QgsPackedRTree::hilbert( quint32 x, quint32 y )
+{
+  // position of (x, y) on the Hilbert curve of order 16, from "Fast Hilbert curve generation"
+  // by rawrunprotected (public domain)
+  quint32 a = x ^ y;
+  quint32 b = 0xFFFF ^ a;
+  quint32 c = 0xFFFF ^ ( x | y );
+  quint32 d = x & ( y ^ 0xFFFF );
+
+  quint32 A = a | ( b >> 1 );
+  quint32 B = ( a >> 1 ) ^ a;
+  quint32 C = ( ( c >> 1 ) ^ ( b & ( d >> 1 ) ) ) ^ c;
+  quint32 D = ( ( a & ( c >> 1 ) ) ^ ( d >> 1 ) ) ^ d;
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( a & ( a >> 2 ) ) ^ ( b & ( b >> 2 ) );
+  B = ( a & ( b >> 2 ) ) ^ ( b & ( ( a ^ b ) >> 2 ) );
+  C ^= ( a & ( c >> 2 ) ) ^ ( b & ( d >> 2 ) );
+  D ^= ( b & ( c >> 2 ) ) ^ ( ( a ^ b ) & ( d >> 2 ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  A = ( a & ( a >> 4 ) ) ^ ( b & ( b >> 4 ) );
+  B = ( a & ( b >> 4 ) ) ^ ( b & ( ( a ^ b ) >> 4 ) );
+  C ^= ( a & ( c >> 4 ) ) ^ ( b & ( d >> 4 ) );
+  D ^= ( b & ( c >> 4 ) ) ^ ( ( a ^ b ) & ( d >> 4 ) );
+
+  a = A;
+  b = B;
+  c = C;
+  d = D;
+  C ^= ( a & ( c >> 8 ) ) ^ ( b & ( d >> 8 ) );
+  D ^= ( b & ( c >> 8 ) ) ^ ( ( a ^ b ) & ( d >> 8 ) );
+
+  a = C ^ ( C >> 1 );
+  b = D ^ ( D >> 1 );
+
+  quint32 i0 = x ^ y;
+  quint32 i1 = b | ( 0xFFFF ^ ( i0 | a ) );
+
+  i0 = ( i0 | ( i0 << 8 ) ) & 0x00FF00FF;
+  i0 = ( i0 | ( i0 << 4 ) ) & 0x0F0F0F0F;
+  i0 = ( i0 | ( i0 << 2 ) ) & 0x33333333;
+  i0 = ( i0 | ( i0 << 1 ) ) & 0x55555555;
+
+  i1 = ( i1 | ( i1 << 8 ) ) & 0x00FF00FF;
+  i1 = ( i1 | ( i1 << 4 ) ) & 0x0F0F0F0F;
+  i1 = ( i1 | ( i1 << 2 ) ) & 0x33333333;
+  i1 = ( i1 | ( i1 << 1 ) ) & 0x55555555;
+
+  return ( i1 << 1 ) | i0;
+}
+
+bool QgsPackedRTree::write( const QString &fileName, QVector<Entry> &items, const QDateTime &sourceModified, long sourceFeatureCount )
+{
+  QVector<quint64> levelEnds;
+  QVector<Entry> entries;
+
+  if ( !items.isEmpty() )
+  {
+    // sort the items along the Hilbert curve of their centers, so that
+    // consecutive items - which end up in the same node - are close to each other
+    QgsRectangle extent;
+    extent.setMinimal();
+    Q_FOREACH ( const Entry &item, items )
+    {
+      extent.combineExtentWith( item.xMin, item.yMin );
+      extent.combineExtentWith( item.xMax, item.yMax );
+    }
+
+    QVector< QPair< quint32, int > > order;
+    order.reserve( items.count() );
+    for ( int i = 0; i < items.count(); ++i )
+    {
+      const Entry &item = items.at( i );
+      double x = extent.width() > 0 ? ( ( item.xMin + item.xMax ) / 2 - extent.xMinimum() ) / extent.width() : 0;
+      double y = extent.height() > 0 ? ( ( item.yMin + item.yMax ) / 2 - extent.yMinimum() ) / extent.height() : 0;
+      order << qMakePair( hilbert( static_cast< quint32 >( x * 0xFFFF ), static_cast< quint32 >( y * 0xFFFF ) ), i );
+    }
+    std::sort( order.begin(), order.end() );
+
+    entries.reserve( items.count() + items.count() / ( NODE_SIZE - 1 ) + 1 );
+    for ( int i = 0; i < order.count(); ++i )
+      entries << items.at( order.at( i ).second );
+
+    // build the upper levels bottom up until a single root is left
+    int levelBegin = 0;
+    levelEnds << entries.count();
+    while ( levelEnds.last() - levelBegin > 1 )
+    {
+      int levelEnd = static_cast< int >( levelEnds.last() );
+      for ( int first = levelBegin; first < levelEnd; first += NODE_SIZE )
+      {
+        int last = std::min( first + static_cast< int >( NODE_SIZE ), levelEnd );
+        Entry node = entries.at( first );
+        node.value = first;
+        for ( int i = first + 1; i < last; ++i )
+        {
+          const Entry &child = entries.at( i );
+          node.xMin = std::min( node.xMin, child.xMin );
+          node.yMin = std::min( node.yMin, child.yMin );
+          node.xMax = std::max( node.xMax, child.xMax );
+          node.yMax = std::max( node.yMax, child.yMax );
+        }
+        entries << node;
+      }
+      levelBegin = levelEnd;
+      levelEnds << entries.count();
+    }
+  }
+
+  Header header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, MAGIC, sizeof( header.magic ) );
+  header.version = VERSION;
+  header.byteOrder = BYTE_ORDER;
+  header.nodeSize = NODE_SIZE;
+  header.levelCount = levelEnds.count();
+  header.itemCount = items.count();
+  header.entryCount = entries.count();
+  header.sourceModified = sourceModified.isValid() ? sourceModified.toMSecsSinceEpoch() : -1;
+  header.sourceFeatureCount = sourceFeatureCount;
+
+  // QSaveFile replaces the index atomically, readers never see a partially written file
+  QSaveFile file( fileName );
+  if ( !file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( QString( "Cannot write spatial index %1: %2" ).arg( fileName, file.errorString() ) );
+    return false;
+  }
+
+  file.write( reinterpret_cast< const char * >( &header ), sizeof( header ) );
+  file.write( reinterpret_cast< const char * >( levelEnds.constData() ), levelEnds.count() * sizeof( quint64 ) );
+  file.write( reinterpret_cast< const char * >( entries.constData() ), entries.count() * sizeof( Entry ) );
+  return file.commit();
+}
+
+bool QgsPackedRTree::open( const QString &fileName, const QDateTime &sourceModified, long sourceFeatureCount )
+{
+  mFile.setFileName( fileName );
+  if ( !mFile.open( QIODevice::ReadOnly ) )
+    return false;
+
+  qint64 size = mFile.size();
+  if ( size < static_cast< qint64 >( sizeof( Header ) ) )
+    return false;
+
+  const uchar *data = mFile.map( 0, size );
+  if ( !data )
+  {
+    // mapping is not supported by all file systems
+    mBuffer = mFile.readAll();
+    if ( mBuffer.size() != size )
+      return false;
+    data = reinterpret_cast< const uchar * >( mBuffer.constData() );
+  }
+
+  const Header *header = reinterpret_cast< const Header * >( data );
+  if ( memcmp( header->magic, MAGIC, sizeof( header->magic ) ) != 0
+       || header->version != VERSION
+       || header->byteOrder != BYTE_ORDER
+       || header->nodeSize < 2 )
+  {
+    QgsDebugMsg( QString( "%1 is not a valid spatial index" ).arg( fileName ) );
+    return false;
+  }
+
+  if ( ( sourceModified.isValid() && header->sourceModified != sourceModified.toMSecsSinceEpoch() )
+       || ( sourceFeatureCount >= 0 && header->sourceFeatureCount != sourceFeatureCount ) )
+  {
+    QgsDebugMsg( QString( "Spatial index %1 is outdated" ).arg( fileName ) );
+    return false;
+  }
+
+  if ( header->itemCount > static_cast< quint64 >( std::numeric_limits<int>::max() )
+       || static_cast< quint64 >( size ) != sizeof( Header ) + header->levelCount * sizeof( quint64 ) + header->entryCount * sizeof( Entry ) )
+    return false;
+
+  const quint64 *levelEnds = reinterpret_cast< const quint64 * >( data + sizeof( Header ) );
+  if ( header->itemCount == 0 )
+  {
+    if ( header->levelCount != 0 || header->entryCount != 0 )
+      return false;
+  }
+  else
+  {
+    if ( header->levelCount == 0 || levelEnds[0] != header->itemCount
+         || levelEnds[header->levelCount - 1] != header->entryCount )
+      return false;
+    for ( quint32 level = 1; level < header->levelCount; ++level )
+    {
+      if ( levelEnds[level] <= levelEnds[level - 1] )
+        return false;
+    }
+    // the last level must be the root
+    if ( header->levelCount > 1 && levelEnds[header->levelCount - 1] - levelEnds[header->levelCount - 2] != 1 )
+      return false;
+  }
+
+  mHeader = header;
+  mLevelEnds = levelEnds;
+  mEntries = reinterpret_cast< const Entry * >( data + sizeof( Header ) + header->levelCount * sizeof( quint64 ) );
+  return true;
+}
+
+bool QgsPackedRTree::children( const Entry &entry, int level, quint64 &begin, quint64 &end ) const
+{
+  // children of an entry at given level are in the level below
+  quint64 levelBegin = level > 1 ? mLevelEnds[level - 2] : 0;
+  quint64 levelEnd = mLevelEnds[level - 1];
+  begin = static_cast< quint64 >( entry.value );
+  end = std::min( begin + mHeader->nodeSize, levelEnd );
+  return entry.value >= 0 && begin >= levelBegin && begin < levelEnd;
+}
+
+void QgsPackedRTree::intersects( const QgsRectangle &rect, QList<QgsFeatureId> &list ) const
+{
+  if ( count() == 0 )
+    return;
+
+  QVector< QPair< quint64, int > > stack;
+  stack << qMakePair( mHeader->entryCount - 1, static_cast< int >( mHeader->levelCount ) - 1 );
+  while ( !stack.isEmpty() )
+  {
+    QPair< quint64, int > node = stack.takeLast();
+    const Entry &entry = mEntries[node.first];
+    if ( entry.xMax < rect.xMinimum() || entry.xMin > rect.xMaximum() ||
+         entry.yMax < rect.yMinimum() || entry.yMin > rect.yMaximum() )
+      continue;
+
+    if ( node.second == 0 )
+    {
+      list.append( entry.value );
+      continue;
+    }
+
+    quint64 begin, end;
+    if ( !children( entry, node.second, begin, end ) )
+      continue;
+    for ( quint64 i = begin; i < end; ++i )
+      stack << qMakePair( i, node.second - 1 );
+  }
+}
+
+void QgsPackedRTree::nearestNeighbor( const QgsPointXY &point, int neighbors, QList<QgsFeatureId> &list ) const
+{
+  if ( count() == 0 )
+    return;
+
+  auto distance = [&point]( const Entry & entry )
+  {
+    double dx = std::max( std::max( entry.xMin - point.x(), point.x() - entry.xMax ), 0.0 );
+    double dy = std::max( std::max( entry.yMin - point.y(), point.y() - entry.yMax ), 0.0 );
+    return dx * dx + dy * dy;
+  };
+
+  // best first search - items are reported in order of their distance, and like
+  // libspatialindex all items as far as the last neighbor are included
+  std::priority_queue< Candidate, std::vector< Candidate >, std::greater< Candidate > > queue;
+  quint64 root = mHeader->entryCount - 1;
+  queue.push( { distance( mEntries[root] ), root, static_cast< int >( mHeader->levelCount ) - 1 } );
+  double lastDistance = -1;
+  while ( !queue.empty() )
+  {
+    Candidate candidate = queue.top();
+    queue.pop();
+    if ( list.count() >= neighbors && candidate.distance > lastDistance )
+      break;
+
+    const Entry &entry = mEntries[candidate.index];
+    if ( candidate.level == 0 )
+    {
+      list.append( entry.value );
+      lastDistance = candidate.distance;
+      continue;
+    }
+
+    quint64 begin, end;
+    if ( !children( entry, candidate.level, begin, end ) )
+      continue;
+    for ( quint64 i = begin; i < end; ++i )
+      queue.push( { distance( mEntries[i] ), i, candidate.level - 1 } );
+  }
+}
+
+
+/** \ingroup core
+ * \class QgsPackedRTreeDataStream
+ * \brief Utility class for bulk loading of R-trees from a packed R-tree. Not a part of public API.
+ * \note not available in Python bindings
+*/
+class QgsPackedRTreeDataStream : public IDataStream
+{
+  public:
+    explicit QgsPackedRTreeDataStream( const QgsPackedRTree &tree )
+      : mTree( tree )
+    {}
+
+    IData *getNext() override
+    {
+      if ( mNext >= mTree.count() )
+        return nullptr;
+
+      const QgsPackedRTree::Entry &entry = mTree.items()[mNext++];
+      double low[2] = { entry.xMin, entry.yMin };
+      double high[2] = { entry.xMax, entry.yMax };
+      return new RTree::Data( 0, nullptr, SpatialIndex::Region( low, high, 2 ), entry.value );
+    }
+
+    bool hasNext() override { return mNext < mTree.count(); }
+
+    uint32_t size() override { return mTree.count(); }
+
+    void rewind() override { mNext = 0; }
+
+  private:
+    const QgsPackedRTree &mTree;
+    int mNext = 0;
+};
+
+/** \ingroup core
+ * \class QgsSpatialIndexEntriesVisitor
+ * \brief Custom visitor that collects bounding boxes and IDs of all items.
+ * \note not available in Python bindings
+ */
+class QgsSpatialIndexEntriesVisitor : public SpatialIndex::IVisitor
+{
+  public:
+    explicit QgsSpatialIndexEntriesVisitor( QVector<QgsPackedRTree::Entry> &entries )
+      : mEntries( entries ) {}
+
+    void visitNode( const INode &n ) override
+    { Q_UNUSED( n ); }
+
+    void visitData( const IData &d ) override
+    {
+      SpatialIndex::IShape *shape = nullptr;
+      d.getShape( &shape );
+      SpatialIndex::Region r;
+      shape->getMBR( r );
+      delete shape;
+
+      QgsPackedRTree::Entry entry;
+      entry.xMin = r.getLow( 0 );
+      entry.yMin = r.getLow( 1 );
+      entry.xMax = r.getHigh( 0 );
+      entry.yMax = r.getHigh( 1 );
+      entry.value = d.getIdentifier();
+      mEntries << entry;
+    }
+
+    void visitData( std::vector<const IData *> &v ) override
+    { Q_UNUSED( v ); }
+
+  private:
+    QVector<QgsPackedRTree::Entry> &mEntries;
+};
+
+
 /** \ingroup core
  *  \class QgsSpatialIndexData
  * \brief Data of spatial index that may be implicitly shared
@@ -177,9 +645,25 @@ class QgsSpatialIndexData : public QSharedData
       initTree( &fids );
     }
 
+    /**
+     * Constructor for QgsSpatialIndexData which uses a \a packed R-tree loaded from a file.
+     * It is copied to an in-memory R-tree only when the index gets modified.
+     */
+    explicit QgsSpatialIndexData( const std::shared_ptr< const QgsPackedRTree > &packed )
+      : mPacked( packed )
+    {
+    }
+
     QgsSpatialIndexData( const QgsSpatialIndexData &other )
       : QSharedData( other )
     {
+      if ( other.mPacked )
+      {
+        // read-only data can be shared
+        mPacked = other.mPacked;
+        return;
+      }
+
       initTree();
 
       // copy R-tree data one by one (is there a faster way??)
@@ -219,12 +703,33 @@ class QgsSpatialIndexData : public QSharedData
                                         leafCapacity, dimension, variant, indexId );
     }
 
+    //! Converts a packed R-tree loaded from a file to a modifiable R-tree
+    void ensureTree()
+    {
+      if ( !mPacked )
+        return;
+
+      if ( mPacked->count() > 0 )
+      {
+        QgsPackedRTreeDataStream stream( *mPacked );
+        initTree( &stream );
+      }
+      else
+      {
+        initTree();
+      }
+      mPacked.reset();
+    }
+
     //! Storage manager
     SpatialIndex::IStorageManager *mStorage = nullptr;
 
     //! R-tree containing spatial index
     SpatialIndex::ISpatialIndex *mRTree = nullptr;
 
+    //! Packed R-tree loaded from a file, used instead of mRTree until the index is modified
+    std::shared_ptr< const QgsPackedRTree > mPacked;
+
   private:
 
     QgsSpatialIndexData &operator=( const QgsSpatialIndexData &rh );
@@ -308,6 +813,7 @@ bool QgsSpatialIndex::insertFeature( QgsFeatureId id, const QgsRectangle &rect )
   // TODO: handle possible exceptions correctly
   try
   {
+    d->ensureTree();
     d->mRTree->insertData( 0, nullptr, r, FID_TO_NUMBER( id ) );
     return true;
   }
@@ -337,12 +843,19 @@ bool QgsSpatialIndex::deleteFeature( const QgsFeature &f )
     return false;
 
   // TODO: handle exceptions
+  d->ensureTree();
   return d->mRTree->deleteData( r, FID_TO_NUMBER( id ) );
 }
 
 QList<QgsFeatureId> QgsSpatialIndex::intersects( const QgsRectangle &rect ) const
 {
   QList<QgsFeatureId> list;
+  if ( d->mPacked )
+  {
+    d->mPacked->intersects( rect, list );
+    return list;
+  }
+
   QgisVisitor visitor( list );
 
   SpatialIndex::Region r = rectToRegion( rect );
@@ -355,6 +868,12 @@ QList<QgsFeatureId> QgsSpatialIndex::intersects( const QgsRectangle &rect ) cons
 QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, int neighbors ) const
 {
   QList<QgsFeatureId> list;
+  if ( d->mPacked )
+  {
+    d->mPacked->nearestNeighbor( point, neighbors, list );
+    return list;
+  }
+
   QgisVisitor visitor( list );
 
   double pt[2] = { point.x(), point.y() };
@@ -365,6 +884,42 @@ QList<QgsFeatureId> QgsSpatialIndex::nearestNeighbor( const QgsPointXY &point, i
   return list;
 }
 
+bool QgsSpatialIndex::writeToFile( const QString &fileName, const QDateTime &sourceModified, long sourceFeatureCount ) const
+{
+  QVector<QgsPackedRTree::Entry> entries;
+  if ( d->mPacked )
+  {
+    entries.reserve( d->mPacked->count() );
+    for ( int i = 0; i < d->mPacked->count(); ++i )
+      entries << d->mPacked->items()[i];
+  }
+  else
+  {
+    double low[] = { -DBL_MAX, -DBL_MAX };
+    double high[] = { DBL_MAX, DBL_MAX };
+    SpatialIndex::Region query( low, high, 2 );
+    QgsSpatialIndexEntriesVisitor visitor( entries );
+    d->mRTree->intersectsWithQuery( query, visitor );
+  }
+
+  return QgsPackedRTree::write( fileName, entries, sourceModified, sourceFeatureCount );
+}
+
+bool QgsSpatialIndex::readFromFile( const QString &fileName, const QDateTime &sourceModified, long sourceFeatureCount )
+{
+  std::shared_ptr< QgsPackedRTree > packed = std::make_shared< QgsPackedRTree >();
+  if ( !packed->open( fileName, sourceModified, sourceFeatureCount ) )
+    return false;
+
+  d = new QgsSpatialIndexData( packed );
+  return true;
+}
+
+QString QgsSpatialIndex::indexFileName( const QString &dataSourcePath )
+{
+  return dataSourcePath + QStringLiteral( ".qsi" );
+}
+
 QAtomicInt QgsSpatialIndex::refs() const
 {
   return d->ref;
@@ -40,6 +40,7 @@ class QgsPointXY;
 
 #include "qgis_core.h"
 #include "qgis_sip.h"
+#include <QDateTime>
 #include <QList>
 #include <QSharedDataPointer>
 
@@ -119,6 +120,43 @@ class CORE_EXPORT QgsSpatialIndex
     //! Returns nearest neighbors (their count is specified by second parameter)
     QList<QgsFeatureId> nearestNeighbor( const QgsPointXY &point, int neighbors ) const;
 
+    /* persistence */
+
+    /**
+     * Writes the index to a file at \a fileName, as a packed Hilbert R-tree which can be
+     * memory-mapped by readFromFile().
+     *
+     * The modification time \a sourceModified and the feature count \a sourceFeatureCount of
+     * the data source the index was built from are stored in the file, so that an outdated index
+     * can be detected when reading it.
+     * \returns true if the file was written successfully
+     * \see readFromFile()
+     * \see indexFileName()
+     * \since QGIS 3.0
+     */
+    bool writeToFile( const QString &fileName, const QDateTime &sourceModified = QDateTime(), long sourceFeatureCount = -1 ) const;
+
+    /**
+     * Replaces the content of the index by the index stored in \a fileName by writeToFile().
+     *
+     * The file is memory-mapped, so opening an index does not depend on its size. The index
+     * stays read-only until it is modified with insertFeature() or deleteFeature(), when it
+     * gets copied into memory.
+     *
+     * If \a sourceModified is valid or \a sourceFeatureCount is not negative they must match
+     * the values stored in the file, otherwise the file is considered outdated.
+     * \returns true if the index was loaded. The index is left unchanged on failure.
+     * \see writeToFile()
+     * \since QGIS 3.0
+     */
+    bool readFromFile( const QString &fileName, const QDateTime &sourceModified = QDateTime(), long sourceFeatureCount = -1 );
+
+    /**
+     * Returns the name of the index file stored next to a file based data source at \a dataSourcePath.
+     * \since QGIS 3.0
+     */
+    static QString indexFileName( const QString &dataSourcePath );
+
     /* debugging */
 
     //! get reference count - just for debugging!
@@ -322,6 +322,15 @@ typedef QSet<int> QgsAttributeIds;
  *
  *   Determines whether the provider generates a spatial index.  The default is no.
  *
+ * -recordIndex=(yes|file|no)
+ *
+ *   Determines whether the file is memory-mapped and the positions of its lines
+ *   recorded, so that features are read faster and can be retrieved by id without
+ *   reading the file from its beginning.  With file, the positions and the results of
+ *   the initial scan of the file (field types, extent, feature count) are also kept
+ *   in a file next to the data file and reused while the data file is unchanged.
+ *   The default is no.
+ *
  * -watchFile=(yes|no)
  *
  *   Defines whether the file will be monitored for changes. The default is
@@ -24,8 +24,10 @@
 #include "feature.h"
 #include "labelposition.h"
 
+#include <algorithm>
+
 QgsVectorLayerDiagramProvider::QgsVectorLayerDiagramProvider( QgsVectorLayer *layer, bool ownFeatureLoop )
-  : QgsAbstractLabelProvider( layer )
+  : QgsAbstractLabelProvider( layer, QStringLiteral( "diagrams" ) ) // distinct from the layer's label provider
   , mSettings( *layer->diagramLayerSettings() )
   , mDiagRenderer( layer->diagramRenderer()->clone() )
   , mFields( layer->fields() )
@@ -159,6 +161,14 @@ bool QgsVectorLayerDiagramProvider::prepare( const QgsRenderContext &context, QS
 }
 
 
+void QgsVectorLayerDiagramProvider::sortLabelFeatures()
+{
+  std::stable_sort( mFeatures.begin(), mFeatures.end(), []( const QgsLabelFeature * a, const QgsLabelFeature * b )
+  {
+    return a->id() < b->id();
+  } );
+}
+
 void QgsVectorLayerDiagramProvider::registerFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry )
 {
   QgsLabelFeature *label = registerDiagram( feature, context, obstacleGeometry );
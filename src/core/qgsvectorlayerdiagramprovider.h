@@ -95,6 +95,12 @@ class CORE_EXPORT QgsVectorLayerDiagramProvider : public QgsAbstractLabelProvide
      */
     virtual void registerFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry = QgsGeometry() );
 
+    /**
+     * Sorts the registered diagram features by feature id, as QgsVectorLayerLabelProvider::sortLabelFeatures().
+     * \since QGIS 3.0
+     */
+    void sortLabelFeatures();
+
   protected:
     //! initialization method - called from constructors
     void init();
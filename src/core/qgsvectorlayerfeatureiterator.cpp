@@ -370,6 +370,33 @@ bool QgsVectorLayerFeatureIterator::fetchFeature( QgsFeature &f )
 }
 
 
+int QgsVectorLayerFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  // features from the provider can only be passed through untouched if there are
+  // no edits, joins or expression fields and no per-feature post processing
+  if ( mSource->mHasEditBuffer || mHasVirtualAttributes || mTransform.isValid()
+       || mRequest.invalidGeometryCheck() != QgsFeatureRequest::GeometryNoCheck
+       || mProviderRequest.filterType() != mRequest.filterType() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  if ( mClosed )
+    return 0;
+
+  if ( mProviderIterator.isClosed() )
+  {
+    mChangedFeaturesIterator.close();
+    mProviderIterator = mSource->mProviderFeatureSource->getFeatures( mProviderRequest );
+    mProviderIterator.setInterruptionChecker( mInterruptionChecker );
+  }
+
+  int count = mProviderIterator.nextBatch( batch, maxFeatures );
+  if ( count == 0 )
+    close();
+
+  return count;
+}
+
+
 
 bool QgsVectorLayerFeatureIterator::rewind()
 {
@@ -143,6 +143,9 @@ class CORE_EXPORT QgsVectorLayerFeatureIterator : public QgsAbstractFeatureItera
     //! while for others filtering is left to the provider implementation.
     virtual bool nextFeatureFilterExpression( QgsFeature &f ) override { return fetchFeature( f ); }
 
+    //! Passes the batch to the provider's iterator when no features need to be modified by the layer
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override SIP_SKIP;
+
     //! Setup the simplification of geometries to fetch using the specified simplify method
     virtual bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
@@ -32,6 +32,8 @@
 
 #include <QPicture>
 
+#include <algorithm>
+
 using namespace pal;
 
 QgsVectorLayerLabelProvider::QgsVectorLayerLabelProvider( QgsVectorLayer *layer, const QString &providerId, bool withFeatureLoop, const QgsPalLayerSettings *settings, const QString &layerName )
@@ -261,6 +263,14 @@ void QgsVectorLayerLabelProvider::registerFeature( QgsFeature &feature, QgsRende
     mLabels << label;
 }
 
+void QgsVectorLayerLabelProvider::sortLabelFeatures()
+{
+  std::stable_sort( mLabels.begin(), mLabels.end(), []( const QgsLabelFeature * a, const QgsLabelFeature * b )
+  {
+    return a->id() < b->id();
+  } );
+}
+
 QgsGeometry QgsVectorLayerLabelProvider::getPointObstacleGeometry( QgsFeature &fet, QgsRenderContext &context, const QgsSymbolList &symbols )
 {
   if ( !fet.hasGeometry() || fet.geometry().type() != QgsWkbTypes::PointGeometry )
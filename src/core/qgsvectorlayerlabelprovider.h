@@ -75,6 +75,14 @@ class CORE_EXPORT QgsVectorLayerLabelProvider : public QgsAbstractLabelProvider
      */
     virtual void registerFeature( QgsFeature &feature, QgsRenderContext &context, const QgsGeometry &obstacleGeometry = QgsGeometry() );
 
+    /**
+     * Sorts the registered label features by feature id, which is the order in which a single feature loop
+     * registers them for most data providers. Used when features were registered by several renderers drawing
+     * tiles of the layer at once, so that the labeling results do not depend on the order the tiles were drawn.
+     * \since QGIS 3.0
+     */
+    virtual void sortLabelFeatures();
+
     /** Returns the geometry for a point feature which should be used as an obstacle for labels. This
      * obstacle geometry will respect the dimensions and offsets of the symbol used to render the
      * point, and ensures that labels will not overlap large or offset points.
@@ -37,6 +37,7 @@
 #include "qgssettings.h"
 
 #include <QPicture>
+#include <QMutexLocker>
 
 
 QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context )
@@ -102,6 +103,22 @@ QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRender
   prepareDiagrams( layer, mAttrNames );
 }
 
+QgsVectorLayerRenderer::QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context, QgsVectorLayerRenderer *parent, const QRect &tileRect, const QSize &mapSize )
+  : QgsVectorLayerRenderer( layer, context )
+{
+  mParentRenderer = parent;
+  mTileRect = tileRect;
+  mMapSize = mapSize;
+
+  if ( mParentRenderer )
+  {
+    // share the providers of the parent renderer, they are only registered with the engine once
+    mLabelProvider = mParentRenderer->mLabelProvider;
+    mDiagramProvider = mParentRenderer->mDiagramProvider;
+    mAttrNames.unite( mParentRenderer->mAttrNames );
+  }
+}
+
 
 QgsVectorLayerRenderer::~QgsVectorLayerRenderer()
 {
@@ -289,29 +306,9 @@ void QgsVectorLayerRenderer::drawRenderer( QgsFeatureIterator &fit )
       if ( rendered )
       {
         // new labeling engine
-        if ( mContext.labelingEngine() && ( mLabelProvider || mDiagramProvider ) )
+        if ( ( mLabelProvider || mDiagramProvider ) && ownsLabelFeature( fet ) )
         {
-          QgsGeometry obstacleGeometry;
-          QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
-
-          if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
-          {
-            obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, mContext, symbols );
-          }
-
-          if ( !symbols.isEmpty() )
-          {
-            QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
-          }
-
-          if ( mLabelProvider )
-          {
-            mLabelProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
-          if ( mDiagramProvider )
-          {
-            mDiagramProvider->registerFeature( fet, mContext, obstacleGeometry );
-          }
+          registerLabelFeature( fet, symbolScope );
         }
       }
     }
@@ -373,29 +370,9 @@ void QgsVectorLayerRenderer::drawRendererLevels( QgsFeatureIterator &fit )
     features[sym].append( fet );
 
     // new labeling engine
-    if ( mContext.labelingEngine() )
+    if ( ( mLabelProvider || mDiagramProvider ) && ownsLabelFeature( fet ) )
     {
-      QgsGeometry obstacleGeometry;
-      QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( fet, mContext );
-
-      if ( !symbols.isEmpty() && fet.geometry().type() == QgsWkbTypes::PointGeometry )
-      {
-        obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( fet, mContext, symbols );
-      }
-
-      if ( !symbols.isEmpty() )
-      {
-        QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
-      }
-
-      if ( mLabelProvider )
-      {
-        mLabelProvider->registerFeature( fet, mContext, obstacleGeometry );
-      }
-      if ( mDiagramProvider )
-      {
-        mDiagramProvider->registerFeature( fet, mContext, obstacleGeometry );
-      }
+      registerLabelFeature( fet, symbolScope );
     }
   }
 
@@ -479,6 +456,67 @@ void QgsVectorLayerRenderer::stopRenderer( QgsSingleSymbolRenderer *selRenderer
 
 
 
+void QgsVectorLayerRenderer::sortLabelFeatures()
+{
+  if ( mLabelProvider )
+    mLabelProvider->sortLabelFeatures();
+  if ( mDiagramProvider )
+    mDiagramProvider->sortLabelFeatures();
+}
+
+void QgsVectorLayerRenderer::registerLabelFeature( QgsFeature &feature, QgsExpressionContextScope *symbolScope )
+{
+  QgsGeometry obstacleGeometry;
+  QgsSymbolList symbols = mRenderer->originalSymbolsForFeature( feature, mContext );
+
+  if ( !symbols.isEmpty() && feature.geometry().type() == QgsWkbTypes::PointGeometry )
+  {
+    obstacleGeometry = QgsVectorLayerLabelProvider::getPointObstacleGeometry( feature, mContext, symbols );
+  }
+
+  if ( !symbols.isEmpty() )
+  {
+    QgsExpressionContextUtils::updateSymbolScope( symbols.at( 0 ), symbolScope );
+  }
+
+  // providers may be shared with other tiles of the layer rendered at the same time
+  QMutexLocker locker( mParentRenderer ? &mParentRenderer->mLabelingMutex : nullptr );
+
+  if ( mLabelProvider )
+  {
+    mLabelProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+  if ( mDiagramProvider )
+  {
+    mDiagramProvider->registerFeature( feature, mContext, obstacleGeometry );
+  }
+}
+
+bool QgsVectorLayerRenderer::ownsLabelFeature( const QgsFeature &feature ) const
+{
+  if ( !mParentRenderer )
+    return true;
+
+  // a feature is owned by the tile containing the center of its bounding box, clamped
+  // to the map so that features only partially visible still end up in exactly one tile
+  QgsPointXY center = feature.geometry().boundingBox().center();
+  try
+  {
+    if ( mContext.coordinateTransform().isValid() )
+      center = mContext.coordinateTransform().transform( center );
+  }
+  catch ( QgsCsException &cse )
+  {
+    Q_UNUSED( cse );
+    return false;
+  }
+
+  QgsPointXY pixel = mContext.mapToPixel().transform( center );
+  int x = qBound( 0, static_cast< int >( std::floor( pixel.x() ) ), mMapSize.width() - 1 );
+  int y = qBound( 0, static_cast< int >( std::floor( pixel.y() ) ), mMapSize.height() - 1 );
+  return mTileRect.contains( x, y );
+}
+
 void QgsVectorLayerRenderer::prepareLabeling( QgsVectorLayer *layer, QSet<QString> &attributeNames )
 {
   if ( QgsLabelingEngine *engine2 = mContext.labelingEngine() )
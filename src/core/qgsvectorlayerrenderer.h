@@ -26,11 +26,14 @@ class QgsDiagramLayerSettings;
 
 class QgsFeatureIterator;
 class QgsSingleSymbolRenderer;
+class QgsExpressionContextScope;
 
 #define SIP_NO_FILE
 
 #include <QList>
+#include <QMutex>
 #include <QPainter>
+#include <QRect>
 
 typedef QList<int> QgsAttributeList;
 
@@ -69,10 +72,31 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
 {
   public:
     QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context );
+
+    /**
+     * Constructor for a renderer which draws just a single tile of the layer, as part of
+     * a layer split into several tiles rendered in parallel.
+     *
+     * The tile renderer does not create its own label and diagram providers, instead
+     * it registers features with the providers of the \a parent renderer (which must
+     * be created with the labeling engine set in its render context and must outlive
+     * the tile renderer). Only features with bounding box center inside \a tileRect
+     * (in map pixels) are registered, so that each feature is labeled just once.
+     *
+     * \since QGIS 3.0
+     */
+    QgsVectorLayerRenderer( QgsVectorLayer *layer, QgsRenderContext &context, QgsVectorLayerRenderer *parent, const QRect &tileRect, const QSize &mapSize );
+
     ~QgsVectorLayerRenderer();
 
     virtual bool render() override;
 
+    /**
+     * Sorts the features registered with the label and diagram providers of the renderer
+     * by feature id. To be called once the tiles sharing the providers are all rendered.
+     */
+    void sortLabelFeatures();
+
   private:
 
     /** Registers label and diagram layer
@@ -93,6 +117,12 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     //! Stop version 2 renderer and selected renderer (if required)
     void stopRenderer( QgsSingleSymbolRenderer *selRenderer );
 
+    //! Registers feature with label and diagram providers
+    void registerLabelFeature( QgsFeature &feature, QgsExpressionContextScope *symbolScope );
+
+    //! Returns true if the feature should be labeled by this renderer (always true unless rendering a tile)
+    bool ownsLabelFeature( const QgsFeature &feature ) const;
+
 
   protected:
 
@@ -131,6 +161,15 @@ class QgsVectorLayerRenderer : public QgsMapLayerRenderer
     //! may be null. no need to delete: if exists it is owned by labeling engine
     QgsVectorLayerDiagramProvider *mDiagramProvider = nullptr;
 
+    //! Renderer owning the label and diagram providers if this renderer only draws a tile of the layer
+    QgsVectorLayerRenderer *mParentRenderer = nullptr;
+    //! Pixel rectangle of the map covered by this renderer (only used when rendering a tile)
+    QRect mTileRect;
+    //! Size of the whole map in pixels (only used when rendering a tile)
+    QSize mMapSize;
+    //! Serializes registration of features from tile renderers sharing this renderer's providers
+    QMutex mLabelingMutex;
+
     QPainter::CompositionMode mFeatureBlendMode;
 
     QgsVectorSimplifyMethod mSimplifyMethod;
@@ -440,7 +440,88 @@ bool ProjectorData::srcRowCol( int destRow, int destCol, int *srcRow, int *srcCo
   }
 }
 
+void ProjectorData::calcPreciseSrcRow( int destRow )
+{
+  mPreciseDestRow = destRow;
+  mPreciseSrcRows.fill( -1, mDestCols );
+  mPreciseSrcCols.fill( -1, mDestCols );
+
+  if ( mSrcRows <= 0 || mSrcCols <= 0 )
+    return;
+
+  // Get coordinates of centers of destination cells
+  QVector<double> x( mDestCols );
+  QVector<double> y( mDestCols, mDestExtent.yMaximum() - ( destRow + 0.5 ) * mDestYRes );
+  QVector<double> z( mDestCols, 0.0 );
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    x[destCol] = mDestExtent.xMinimum() + ( destCol + 0.5 ) * mDestXRes;
+  }
+
+  int *srcRows = mPreciseSrcRows.data();
+  int *srcCols = mPreciseSrcCols.data();
+
+  if ( mInverseCt.isValid() )
+  {
+    try
+    {
+      // cells which cannot be transformed get HUGE_VAL coordinates
+      mInverseCt.transformCoords( mDestCols, x.data(), y.data(), z.data() );
+    }
+    catch ( QgsCsException & )
+    {
+      // transform the cells one by one, so that only those which fail are left outside of the source
+      for ( int destCol = 0; destCol < mDestCols; ++destCol )
+      {
+        try
+        {
+          if ( !transformSrcRowCol( destRow, destCol, srcRows + destCol, srcCols + destCol ) )
+          {
+            srcRows[destCol] = -1;
+            srcCols[destCol] = -1;
+          }
+        }
+        catch ( QgsCsException & )
+        {
+          srcRows[destCol] = -1;
+          srcCols[destCol] = -1;
+        }
+      }
+      return;
+    }
+  }
+
+  for ( int destCol = 0; destCol < mDestCols; ++destCol )
+  {
+    if ( !mExtent.contains( QgsPointXY( x[destCol], y[destCol] ) ) )
+      continue;
+
+    int srcRow = static_cast< int >( std::floor( ( mSrcExtent.yMaximum() - y[destCol] ) / mSrcYRes ) );
+    int srcCol = static_cast< int >( std::floor( ( x[destCol] - mSrcExtent.xMinimum() ) / mSrcXRes ) );
+    if ( srcRow < 0 || srcRow >= mSrcRows || srcCol < 0 || srcCol >= mSrcCols )
+      continue;
+
+    srcRows[destCol] = srcRow;
+    srcCols[destCol] = srcCol;
+  }
+}
+
 bool ProjectorData::preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
+{
+  if ( destRow != mPreciseDestRow )
+  {
+    calcPreciseSrcRow( destRow );
+  }
+
+  if ( mPreciseSrcRows.at( destCol ) < 0 )
+    return false;
+
+  *srcRow = mPreciseSrcRows.at( destCol );
+  *srcCol = mPreciseSrcCols.at( destCol );
+  return true;
+}
+
+bool ProjectorData::transformSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol )
 {
 #ifdef QGISDEBUG
   QgsDebugMsgLevel( QString( "theDestRow = %1" ).arg( destRow ), 5 );
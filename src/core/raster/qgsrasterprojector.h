@@ -118,7 +118,7 @@ class CORE_EXPORT QgsRasterProjector : public QgsRasterInterface
  * QgsRasterProjector creates it and then keeps calling srcRowCol() to get source pixel position
  * for every destination pixel position.
  */
-class ProjectorData
+class CORE_EXPORT ProjectorData
 {
   public:
     //! Initialize reprojector and calculate matrix
@@ -150,6 +150,15 @@ class ProjectorData
     //! \brief Get precise source row and column indexes for current source extent and resolution
     inline bool preciseSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
 
+    /**
+     * \brief Calculate precise source row and column indexes of all cells of a destination row.
+     * The row is transformed with a single call to QgsCoordinateTransform::transformCoords().
+     */
+    void calcPreciseSrcRow( int destRow );
+
+    //! \brief Transform the center of a single destination cell to get its source row and column indexes
+    bool transformSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
+
     //! \brief Get approximate source row and column indexes for current source extent and resolution
     inline bool approximateSrcRowCol( int destRow, int destCol, int *srcRow, int *srcCol );
 
@@ -207,6 +216,15 @@ class ProjectorData
     //! Source raster extent
     QgsRectangle mExtent;
 
+    //! Destination row of the precise source rows and columns, -1 if not calculated yet
+    int mPreciseDestRow = -1;
+
+    //! Precise source rows of the cells of mPreciseDestRow, -1 if outside of the source
+    QVector<int> mPreciseSrcRows;
+
+    //! Precise source columns of the cells of mPreciseDestRow
+    QVector<int> mPreciseSrcCols;
+
     //! Number of destination rows
     int mDestRows;
 
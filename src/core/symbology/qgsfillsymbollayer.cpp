@@ -29,7 +29,11 @@
 #include "qgsunittypes.h"
 
 #include <QPainter>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QFile>
+#include <QMutex>
 #include <QSvgRenderer>
 #include <QDomDocument>
 #include <QDomElement>
@@ -942,6 +946,56 @@ QgsMapUnitScale QgsGradientFillSymbolLayer::mapUnitScale() const
 
 //QgsShapeburstFillSymbolLayer
 
+///@cond PRIVATE
+
+/**
+ * Bounded cache of rendered shapeburst fill images. The least recently used images
+ * are discarded first.
+ */
+class QgsShapeburstFillSymbolLayer::ImageCache
+{
+  public:
+
+    //! Maximum size of the cached images, in kilobytes
+    static const int MAX_COST = 64 * 1024;
+
+    ImageCache()
+    {
+      mImages.setMaxCost( MAX_COST );
+    }
+
+    //! Returns the image with the given key, or a null image if it is not in the cache
+    QImage image( const QByteArray &key )
+    {
+      QMutexLocker locker( &mMutex );
+      QImage *image = mImages.object( key );
+      return image ? *image : QImage();
+    }
+
+    //! Inserts an image, the cost is in kilobytes to fit in an int
+    void insertImage( const QByteArray &key, const QImage &image )
+    {
+      QMutexLocker locker( &mMutex );
+      mImages.insert( key, new QImage( image ), std::max( 1, image.byteCount() / 1024 ) );
+    }
+
+  private:
+    QMutex mMutex;
+    QCache< QByteArray, QImage > mImages;
+};
+
+//! Writes the vertices of a polygon relative to the image origin, rounded to 1/256 pixel so that translated polygons give the same cache key
+static void writePolygonToCacheKey( QDataStream &stream, const QPolygonF &polygon, const QPointF &origin )
+{
+  stream << polygon.size();
+  for ( const QPointF &point : polygon )
+  {
+    stream << qRound64( ( point.x() - origin.x() ) * 256 ) << qRound64( ( point.y() - origin.y() ) * 256 );
+  }
+}
+
+///@endcond
+
 QgsShapeburstFillSymbolLayer::QgsShapeburstFillSymbolLayer( const QColor &color, const QColor &color2, ShapeburstColorType colorType,
     int blurRadius, bool useWholeShape, double maxDistance )
   : mBlurRadius( blurRadius )
@@ -954,6 +1008,7 @@ QgsShapeburstFillSymbolLayer::QgsShapeburstFillSymbolLayer( const QColor &color,
   , mTwoColorGradientRamp( nullptr )
   , mIgnoreRings( false )
   , mOffsetUnit( QgsUnitTypes::RenderMillimeters )
+  , mImageCache( std::make_shared< ImageCache >() )
 {
   mColor = color;
 }
@@ -1129,6 +1184,13 @@ void QgsShapeburstFillSymbolLayer::startRender( QgsSymbolRenderContext &context
   if ( ! SELECTION_IS_OPAQUE )
     selColor.setAlphaF( context.opacity() );
   mSelBrush = QBrush( selColor );
+
+  mRampSignature.clear();
+  if ( mGradientRamp )
+  {
+    QDataStream stream( &mRampSignature, QIODevice::WriteOnly );
+    stream << mGradientRamp->type() << mGradientRamp->properties();
+  }
 }
 
 void QgsShapeburstFillSymbolLayer::stopRender( QgsSymbolRenderContext &context )
@@ -1179,48 +1241,133 @@ void QgsShapeburstFillSymbolLayer::renderPolygon( const QPolygonF &points, QList
     outputPixelMaxDist = context.renderContext().convertToPainterUnits( maxDistance, mDistanceUnit, mDistanceMapUnitScale );
   }
 
+  //no stroke for shapeburst fills
+  p->setPen( QPen( Qt::NoPen ) );
+
+  QPointF offset;
+  if ( !mOffset.isNull() )
+  {
+    offset.setX( context.renderContext().convertToPainterUnits( mOffset.x(), mOffsetUnit, mOffsetMapUnitScale ) );
+    offset.setY( context.renderContext().convertToPainterUnits( mOffset.y(), mOffsetUnit, mOffsetMapUnitScale ) );
+  }
+
+  //calculate margin size in pixels so that QImage of polygon has sufficient space to draw the full blur effect
+  int sideBuffer = 4 + ( blurRadius + 2 ) * 4;
+  //the shapeburst image covers the polygon and the margin, its rect is relative to the image origin
+  QRectF bounds = points.boundingRect();
+  QPointF imageOrigin( bounds.left() - sideBuffer, bounds.top() - sideBuffer );
+  QRect imageRect( 0, 0, static_cast< int >( bounds.width() + ( sideBuffer * 2 ) ), static_cast< int >( bounds.height() + ( sideBuffer * 2 ) ) );
+
+  //when the distances are capped, the polygon boundary further than the maximum distance from
+  //the visible area cannot affect it, so only the visible part of the image needs to be shaded
+  if ( !useWholeShape && outputPixelMaxDist > 0 && p->device() && p->device()->devType() == QInternal::Image )
+  {
+    bool invertible = false;
+    QTransform inverse = p->worldTransform().inverted( &invertible );
+    if ( invertible )
+    {
+      QRectF visible = inverse.mapRect( QRectF( 0, 0, p->device()->width(), p->device()->height() ) ).translated( -offset );
+      double margin = outputPixelMaxDist + sideBuffer;
+      visible.adjust( -margin, -margin, margin, margin );
+      //the clipped rect stays aligned on the pixels of the whole image
+      int left = std::max( imageRect.left(), static_cast< int >( std::floor( visible.left() - imageOrigin.x() ) ) );
+      int top = std::max( imageRect.top(), static_cast< int >( std::floor( visible.top() - imageOrigin.y() ) ) );
+      int right = std::min( imageRect.left() + imageRect.width(), static_cast< int >( std::ceil( visible.right() - imageOrigin.x() ) ) );
+      int bottom = std::min( imageRect.top() + imageRect.height(), static_cast< int >( std::ceil( visible.bottom() - imageOrigin.y() ) ) );
+      if ( right <= left || bottom <= top )
+      {
+        //polygon is not visible
+        return;
+      }
+      imageRect = QRect( left, top, right - left, bottom - top );
+    }
+  }
+
+  //the image only depends on the shape of the polygon in painter units and on the fill settings,
+  //so the images of the previous renders can be reused when the map is redrawn or panned
+  QByteArray keyData;
+  QDataStream keyStream( &keyData, QIODevice::WriteOnly );
+  keyStream << imageRect << color1.rgba() << color2.rgba() << static_cast< int >( mColorType ) << mRampSignature
+            << blurRadius << useWholeShape << outputPixelMaxDist << ignoreRings << context.opacity()
+            << static_cast< int >( context.renderContext().vectorSimplifyMethod().simplifyHints() )
+            << context.renderContext().vectorSimplifyMethod().threshold();
+  writePolygonToCacheKey( keyStream, points, imageOrigin );
+  keyStream << ( rings ? rings->size() : -1 );
+  if ( rings )
+  {
+    for ( const QPolygonF &ring : qgsAsConst( *rings ) )
+    {
+      writePolygonToCacheKey( keyStream, ring, imageOrigin );
+    }
+  }
+  QByteArray key = QCryptographicHash::hash( keyData, QCryptographicHash::Md5 );
+
+  QImage fillImage = mImageCache->image( key );
+  if ( fillImage.isNull() )
+  {
+    fillImage = renderFillImage( points, rings, context, imageRect, imageOrigin, color1, color2, blurRadius, useWholeShape, outputPixelMaxDist, ignoreRings );
+    mImageCache->insertImage( key, fillImage );
+  }
+
+  //draw shapeburst image in correct place in the destination painter
+
+  p->save();
+  if ( !mOffset.isNull() )
+  {
+    p->translate( offset );
+  }
+
+  p->drawImage( imageOrigin.x() + imageRect.left(), imageOrigin.y() + imageRect.top(), fillImage );
+
+  if ( !mOffset.isNull() )
+  {
+    p->translate( -offset );
+  }
+  p->restore();
+
+}
+
+QImage QgsShapeburstFillSymbolLayer::renderFillImage( const QPolygonF &points, QList<QPolygonF> *rings, QgsSymbolRenderContext &context, const QRect &imageRect,
+    const QPointF &imageOrigin, const QColor &color1, const QColor &color2, int blurRadius,
+    bool useWholeShape, int outputPixelMaxDist, bool ignoreRings )
+{
   //if we are using the two color mode, create a gradient ramp
   if ( mColorType == QgsShapeburstFillSymbolLayer::SimpleTwoColor )
   {
     mTwoColorGradientRamp = new QgsGradientColorRamp( color1, color2 );
   }
 
-  //no stroke for shapeburst fills
-  p->setPen( QPen( Qt::NoPen ) );
+  //translation from painter coordinates to image coordinates
+  QPointF imageTranslation( -imageOrigin.x() - imageRect.left(), -imageOrigin.y() - imageRect.top() );
 
-  //calculate margin size in pixels so that QImage of polygon has sufficient space to draw the full blur effect
-  int sideBuffer = 4 + ( blurRadius + 2 ) * 4;
   //create a QImage to draw shapeburst in
-  double imWidth = points.boundingRect().width() + ( sideBuffer * 2 );
-  double imHeight = points.boundingRect().height() + ( sideBuffer * 2 );
-  QImage *fillImage = new QImage( imWidth,
-                                  imHeight, QImage::Format_ARGB32_Premultiplied );
+  QImage fillImage( imageRect.width(), imageRect.height(), QImage::Format_ARGB32_Premultiplied );
   //Fill this image with black. Initially the distance transform is drawn in greyscale, where black pixels have zero distance from the
   //polygon boundary. Since we don't care about pixels which fall outside the polygon, we start with a black image and then draw over it the
   //polygon in white. The distance transform function then fills in the correct distance values for the white pixels.
-  fillImage->fill( Qt::black );
+  fillImage.fill( Qt::black );
 
   //also create an image to store the alpha channel
-  QImage *alphaImage = new QImage( fillImage->width(), fillImage->height(), QImage::Format_ARGB32_Premultiplied );
+  QImage alphaImage( fillImage.width(), fillImage.height(), QImage::Format_ARGB32_Premultiplied );
   //initially fill the alpha channel image with a transparent color
-  alphaImage->fill( Qt::transparent );
+  alphaImage.fill( Qt::transparent );
 
   //now, draw the polygon in the alpha channel image
   QPainter imgPainter;
-  imgPainter.begin( alphaImage );
+  imgPainter.begin( &alphaImage );
   imgPainter.setRenderHint( QPainter::Antialiasing, true );
   imgPainter.setBrush( QBrush( Qt::white ) );
   imgPainter.setPen( QPen( Qt::black ) );
-  imgPainter.translate( -points.boundingRect().left() + sideBuffer, - points.boundingRect().top() + sideBuffer );
+  imgPainter.translate( imageTranslation );
   _renderPolygon( &imgPainter, points, rings, context );
   imgPainter.end();
 
   //now that we have a render of the polygon in white, draw this onto the shapeburst fill image too
   //(this avoids calling _renderPolygon twice, since that can be slow)
-  imgPainter.begin( fillImage );
+  imgPainter.begin( &fillImage );
   if ( !ignoreRings )
   {
-    imgPainter.drawImage( 0, 0, *alphaImage );
+    imgPainter.drawImage( 0, 0, alphaImage );
   }
   else
   {
@@ -1229,16 +1376,16 @@ void QgsShapeburstFillSymbolLayer::renderPolygon( const QPolygonF &points, QList
     //to draw now without any rings
     imgPainter.setBrush( QBrush( Qt::white ) );
     imgPainter.setPen( QPen( Qt::black ) );
-    imgPainter.translate( -points.boundingRect().left() + sideBuffer, - points.boundingRect().top() + sideBuffer );
+    imgPainter.translate( imageTranslation );
     _renderPolygon( &imgPainter, points, nullptr, context );
   }
   imgPainter.end();
 
   //apply distance transform to image, uses the current color ramp to calculate final pixel colors
-  double *dtArray = distanceTransform( fillImage );
+  double *dtArray = distanceTransform( &fillImage );
 
   //copy distance transform values back to QImage, shading by appropriate color ramp
-  dtArrayToQImage( dtArray, fillImage, mColorType == QgsShapeburstFillSymbolLayer::SimpleTwoColor ? mTwoColorGradientRamp : mGradientRamp,
+  dtArrayToQImage( dtArray, &fillImage, mColorType == QgsShapeburstFillSymbolLayer::SimpleTwoColor ? mTwoColorGradientRamp : mGradientRamp,
                    context.opacity(), useWholeShape, outputPixelMaxDist );
 
   //clean up some variables
@@ -1246,43 +1393,22 @@ void QgsShapeburstFillSymbolLayer::renderPolygon( const QPolygonF &points, QList
   if ( mColorType == QgsShapeburstFillSymbolLayer::SimpleTwoColor )
   {
     delete mTwoColorGradientRamp;
+    mTwoColorGradientRamp = nullptr;
   }
 
   //apply blur if desired
   if ( blurRadius > 0 )
   {
-    QgsSymbolLayerUtils::blurImageInPlace( *fillImage, QRect( 0, 0, fillImage->width(), fillImage->height() ), blurRadius, false );
+    QgsSymbolLayerUtils::blurImageInPlace( fillImage, QRect( 0, 0, fillImage.width(), fillImage.height() ), blurRadius, false );
   }
 
   //apply alpha channel to distance transform image, so that areas outside the polygon are transparent
-  imgPainter.begin( fillImage );
+  imgPainter.begin( &fillImage );
   imgPainter.setCompositionMode( QPainter::CompositionMode_DestinationIn );
-  imgPainter.drawImage( 0, 0, *alphaImage );
+  imgPainter.drawImage( 0, 0, alphaImage );
   imgPainter.end();
-  //we're finished with the alpha channel image now
-  delete alphaImage;
-
-  //draw shapeburst image in correct place in the destination painter
-
-  p->save();
-  QPointF offset;
-  if ( !mOffset.isNull() )
-  {
-    offset.setX( context.renderContext().convertToPainterUnits( mOffset.x(), mOffsetUnit, mOffsetMapUnitScale ) );
-    offset.setY( context.renderContext().convertToPainterUnits( mOffset.y(), mOffsetUnit, mOffsetMapUnitScale ) );
-    p->translate( offset );
-  }
-
-  p->drawImage( points.boundingRect().left() - sideBuffer, points.boundingRect().top() - sideBuffer, *fillImage );
-
-  delete fillImage;
-
-  if ( !mOffset.isNull() )
-  {
-    p->translate( -offset );
-  }
-  p->restore();
 
+  return fillImage;
 }
 
 //fast distance transform code, adapted from http://cs.brown.edu/~pff/dt/
@@ -1507,6 +1633,7 @@ QgsShapeburstFillSymbolLayer *QgsShapeburstFillSymbolLayer::clone() const
   sl->setOffsetMapUnitScale( mOffsetMapUnitScale );
   copyDataDefinedProperties( sl );
   copyPaintEffect( sl );
+  sl->mImageCache = mImageCache;
   return sl;
 }
 
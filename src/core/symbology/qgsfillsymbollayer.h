@@ -32,6 +32,8 @@
 #include <QPen>
 #include <QBrush>
 
+#include <memory>
+
 /** \ingroup core
  * \class QgsSimpleFillSymbolLayer
  */
@@ -565,10 +567,26 @@ class CORE_EXPORT QgsShapeburstFillSymbolLayer : public QgsFillSymbolLayer
 
   private:
 
+    class ImageCache;
+
+    /**
+     * Rendered fill images, shared with the clones of the symbol layer so that
+     * they are reused by the following rendering jobs.
+     */
+    std::shared_ptr< ImageCache > mImageCache;
+
+    //! Signature of the color ramp used for the current rendering, part of the image cache keys
+    QByteArray mRampSignature;
+
     //helper functions for data defined symbology
     void applyDataDefinedSymbology( QgsSymbolRenderContext &context, QColor &color, QColor &color2, int &blurRadius, bool &useWholeShape,
                                     double &maxDistance, bool &ignoreRings );
 
+    //! Renders the fill image of a polygon, the \a imageRect is in painter coordinates
+    QImage renderFillImage( const QPolygonF &points, QList<QPolygonF> *rings, QgsSymbolRenderContext &context, const QRect &imageRect,
+                            const QPointF &imageOrigin, const QColor &color1, const QColor &color2, int blurRadius,
+                            bool useWholeShape, int outputPixelMaxDist, bool ignoreRings );
+
     /* distance transform of a 1d function using squared distance */
     void distanceTransform1d( double *f, int n, int *v, double *z, double *d );
     /* distance transform of 2d function using squared distance */
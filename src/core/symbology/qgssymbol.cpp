@@ -38,6 +38,7 @@
 #include "qgslinestring.h"
 #include "qgspolygon.h"
 #include "qgsclipper.h"
+#include "qgswkbgeometryview.h"
 #include "qgsproperty.h"
 
 #include <QColor>
@@ -99,22 +100,36 @@ QgsSymbol::QgsSymbol( SymbolType type, const QgsSymbolLayerList &layers )
   }
 }
 
+//! Returns the extent to which lines and polygons are clipped, a bit larger than the map extent
+static QgsRectangle _clipRect( const QgsRenderContext &context )
+{
+  const QgsRectangle &e = context.extent();
+  const double cw = e.width() / 10;
+  const double ch = e.height() / 10;
+  return QgsRectangle( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
+}
+
+//! Transforms points in map coordinates to screen coordinates
+static void _toScreen( const QgsRenderContext &context, QPolygonF &pts )
+{
+  const QgsCoordinateTransform ct = context.coordinateTransform();
+  if ( ct.isValid() )
+  {
+    ct.transformPolygon( pts );
+  }
+
+  context.mapToPixel().transformInPlace( pts );
+}
+
 QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
   const unsigned int nPoints = curve.numPoints();
-
-  QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
   QPolygonF pts;
 
   //apply clipping for large lines to achieve a better rendering performance
   if ( clipToExtent && nPoints > 1 )
   {
-    const QgsRectangle &e = context.extent();
-    const double cw = e.width() / 10;
-    const double ch = e.height() / 10;
-    const QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-    pts = QgsClipper::clippedLine( curve, clipRect );
+    pts = QgsClipper::clippedLine( curve, _clipRect( context ) );
   }
   else
   {
@@ -122,53 +137,49 @@ QPolygonF QgsSymbol::_getLineString( QgsRenderContext &context, const QgsCurve &
   }
 
   //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
-  {
-    ct.transformPolygon( pts );
-  }
-
-  QPointF *ptr = pts.data();
-  for ( int i = 0; i < pts.size(); ++i, ++ptr )
-  {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
-  }
-
+  _toScreen( context, pts );
   return pts;
 }
 
 QPolygonF QgsSymbol::_getPolygonRing( QgsRenderContext &context, const QgsCurve &curve, bool clipToExtent )
 {
-  const QgsCoordinateTransform ct = context.coordinateTransform();
-  const QgsMapToPixel &mtp = context.mapToPixel();
-  const QgsRectangle &e = context.extent();
-  const double cw = e.width() / 10;
-  const double ch = e.height() / 10;
-  QgsRectangle clipRect( e.xMinimum() - cw, e.yMinimum() - ch, e.xMaximum() + cw, e.yMaximum() + ch );
-
-  QPolygonF poly = curve.asQPolygonF();
-
   if ( curve.numPoints() < 1 )
     return QPolygonF();
 
+  QPolygonF poly = curve.asQPolygonF();
+
   //clip close to view extent, if needed
-  const QRectF ptsRect = poly.boundingRect();
-  if ( clipToExtent && !context.extent().contains( ptsRect ) )
+  if ( clipToExtent && !context.extent().contains( curve.boundingBox() ) )
   {
-    QgsClipper::trimPolygon( poly, clipRect );
+    QgsClipper::trimPolygon( poly, _clipRect( context ) );
   }
 
   //transform the QPolygonF to screen coordinates
-  if ( ct.isValid() )
-  {
-    ct.transformPolygon( poly );
-  }
+  _toScreen( context, poly );
+  return poly;
+}
+
+//! Creates a line string in screen coordinates from the points of a WKB line string, as QgsSymbol::_getLineString()
+static QPolygonF _getWkbLineString( QgsRenderContext &context, const QPolygonF &points, bool clipToExtent )
+{
+  QPolygonF pts = clipToExtent && points.size() > 1 ? QgsClipper::clippedLine( points, _clipRect( context ) ) : points;
+  _toScreen( context, pts );
+  return pts;
+}
 
-  QPointF *ptr = poly.data();
-  for ( int i = 0; i < poly.size(); ++i, ++ptr )
+//! Creates a polygon ring in screen coordinates from the points of a WKB ring, as QgsSymbol::_getPolygonRing()
+static QPolygonF _getWkbPolygonRing( QgsRenderContext &context, const QPolygonF &points, bool clipToExtent )
+{
+  if ( points.isEmpty() )
+    return QPolygonF();
+
+  QPolygonF poly = points;
+  if ( clipToExtent && !context.extent().contains( QgsRectangle( points.boundingRect() ) ) )
   {
-    mtp.transformInPlace( ptr->rx(), ptr->ry() );
+    QgsClipper::trimPolygon( poly, _clipRect( context ) );
   }
 
+  _toScreen( context, poly );
   return poly;
 }
 
@@ -683,23 +694,38 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
 
   QgsGeometry segmentizedGeometry = geom;
   bool usingSegmentizedGeometry = false;
-  context.setGeometry( geom.geometry() );
 
   bool tileMapRendering = context.testFlag( QgsRenderContext::RenderMapTile );
 
-  //convert curve types to normal point/line/polygon ones
-  if ( QgsWkbTypes::isCurvedType( geom.geometry()->wkbType() ) )
+  // line strings and polygons which are still stored as WKB are rendered straight from it, without parsing the geometry
+  const QgsWkbGeometryView *wkbView = geom.wkbView();
+  const bool renderWkb = wkbView && !drawVertexMarker && !context.vectorSimplifyMethod().forceLocalOptimization()
+                         && ( ( mType == Line && QgsWkbTypes::geometryType( wkbView->wkbType() ) == QgsWkbTypes::LineGeometry )
+                              || ( mType == Fill && QgsWkbTypes::geometryType( wkbView->wkbType() ) == QgsWkbTypes::PolygonGeometry ) );
+  if ( renderWkb )
+  {
+    // the geometry is only needed by symbol layers for curved geometries
+    context.setGeometry( nullptr );
+    mSymbolRenderContext->setGeometryPartCount( wkbView->partCount() );
+  }
+  else
   {
-    QgsAbstractGeometry *g = geom.geometry()->segmentize( context.segmentationTolerance(), context.segmentationToleranceType() );
-    if ( !g )
+    context.setGeometry( geom.geometry() );
+
+    //convert curve types to normal point/line/polygon ones
+    if ( QgsWkbTypes::isCurvedType( geom.geometry()->wkbType() ) )
     {
-      return;
+      QgsAbstractGeometry *g = geom.geometry()->segmentize( context.segmentationTolerance(), context.segmentationToleranceType() );
+      if ( !g )
+      {
+        return;
+      }
+      segmentizedGeometry = QgsGeometry( g );
+      usingSegmentizedGeometry = true;
     }
-    segmentizedGeometry = QgsGeometry( g );
-    usingSegmentizedGeometry = true;
-  }
 
-  mSymbolRenderContext->setGeometryPartCount( segmentizedGeometry.geometry()->partCount() );
+    mSymbolRenderContext->setGeometryPartCount( segmentizedGeometry.geometry()->partCount() );
+  }
   mSymbolRenderContext->setGeometryPartNum( 1 );
 
   ExpressionContextScopePopper scopePopper;
@@ -718,6 +744,12 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
     mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, 1, true ) );
   }
 
+  if ( renderWkb )
+  {
+    renderWkbView( *wkbView, feature, context, layer, selected );
+    return;
+  }
+
   // Collection of markers to paint, only used for no curve types.
   QPolygonF markers;
 
@@ -992,6 +1024,72 @@ void QgsSymbol::renderFeature( const QgsFeature &feature, QgsRenderContext &cont
   }
 }
 
+void QgsSymbol::renderWkbView( const QgsWkbGeometryView &view, const QgsFeature &feature, QgsRenderContext &context, int layer, bool selected )
+{
+  const bool clipToExtent = !context.testFlag( QgsRenderContext::RenderMapTile ) && clipFeaturesToExtent();
+  const bool multi = QgsWkbTypes::isMultiType( view.wkbType() );
+  const int partCount = view.partCount();
+
+  if ( mType == QgsSymbol::Line )
+  {
+    QList<QPolygonF> rings;
+    for ( int i = 0; i < partCount; ++i )
+    {
+      if ( multi )
+      {
+        mSymbolRenderContext->setGeometryPartNum( i + 1 );
+        mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, i + 1, true ) );
+      }
+
+      view.partRings( i, rings );
+      const QPolygonF pts = _getWkbLineString( context, rings.at( 0 ), clipToExtent );
+      static_cast<QgsLineSymbol *>( this )->renderPolyline( pts, &feature, context, layer, selected );
+    }
+    return;
+  }
+
+  QVector< QList<QPolygonF> > parts( partCount );
+  for ( int i = 0; i < partCount; ++i )
+  {
+    view.partRings( i, parts[i] );
+  }
+
+  // Draw starting with larger parts down to smaller parts, as for parsed multi polygons (#15419)
+  std::map<double, QList<int> > mapAreaToPartNum;
+  for ( int i = 0; i < partCount; ++i )
+  {
+    if ( parts.at( i ).isEmpty() )
+      continue;
+
+    const QRectF r = parts.at( i ).at( 0 ).boundingRect();
+    mapAreaToPartNum[ r.width() * r.height()] << i;
+  }
+
+  QList<QPolygonF> holes;
+  std::map<double, QList<int> >::const_reverse_iterator iter = mapAreaToPartNum.rbegin();
+  for ( ; iter != mapAreaToPartNum.rend(); ++iter )
+  {
+    Q_FOREACH ( int i, iter->second )
+    {
+      if ( multi )
+      {
+        mSymbolRenderContext->setGeometryPartNum( i + 1 );
+        mSymbolRenderContext->expressionContextScope()->addVariable( QgsExpressionContextScope::StaticVariable( QgsExpressionContext::EXPR_GEOMETRY_PART_NUM, i + 1, true ) );
+      }
+
+      const QList<QPolygonF> &rings = parts.at( i );
+      const QPolygonF pts = _getWkbPolygonRing( context, rings.at( 0 ), clipToExtent );
+      holes.clear();
+      for ( int idx = 1; idx < rings.size(); ++idx )
+      {
+        const QPolygonF hole = _getWkbPolygonRing( context, rings.at( idx ), clipToExtent );
+        if ( !hole.isEmpty() ) holes.append( hole );
+      }
+      static_cast<QgsFillSymbol *>( this )->renderPolygon( pts, ( !holes.isEmpty() ? &holes : nullptr ), &feature, context, layer, selected );
+    }
+  }
+}
+
 QgsSymbolRenderContext *QgsSymbol::symbolRenderContext()
 {
   return mSymbolRenderContext.get();
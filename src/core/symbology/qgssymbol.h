@@ -50,6 +50,7 @@ class QgsSymbolRenderContext;
 class QgsFeatureRenderer;
 class QgsCurve;
 class QgsPolygonV2;
+class QgsWkbGeometryView;
 class QgsExpressionContext;
 
 typedef QList<QgsSymbolLayer *> QgsSymbolLayerList;
@@ -395,6 +396,12 @@ class CORE_EXPORT QgsSymbol
     //! Initialized in startRender, destroyed in stopRender
     std::unique_ptr< QgsSymbolRenderContext > mSymbolRenderContext;
 
+    /**
+     * Renders the line strings or polygons of a feature straight from the \a view of
+     * the WKB of its geometry, without parsing it.
+     */
+    void renderWkbView( const QgsWkbGeometryView &view, const QgsFeature &feature, QgsRenderContext &context, int layer, bool selected );
+
     Q_DISABLE_COPY( QgsSymbol )
 
 };
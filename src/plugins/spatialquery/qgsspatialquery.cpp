@@ -281,9 +281,8 @@ void QgsSpatialQuery::populateIndexResult(
     return;
   }
 
-  //prepare geometry
-  QgsGeometryEngine *geomEngine = geomTarget.createGeometryEngine( geomTarget.geometry() );
-  geomEngine->prepareGeometry();
+  //prepare geometry, or reuse the one prepared by a former query
+  QgsGeometryEngine *geomEngine = QgsGeometry::createGeometryEngine( geomTarget, mLayerTarget->id(), idTarget );
 
   QgsFeature featureReference;
   QgsGeometry geomReference;
@@ -314,9 +313,8 @@ void QgsSpatialQuery::populateIndexResultDisjoint(
     return;
   }
 
-  //prepare geometry
-  QgsGeometryEngine *geomEngine = geomTarget.createGeometryEngine( geomTarget.geometry() );
-  geomEngine->prepareGeometry();
+  //prepare geometry, or reuse the one prepared by a former query
+  QgsGeometryEngine *geomEngine = QgsGeometry::createGeometryEngine( geomTarget, mLayerTarget->id(), idTarget );
 
   QgsFeature featureReference;
   QgsGeometry geomReference;
@@ -169,6 +169,24 @@ QgsDelimitedTextFeatureIterator::QgsDelimitedTextFeatureIterator( QgsDelimitedTe
     mRequest.setSubsetOfAttributes( attrs );
   }
 
+  // Fields of other columns do not need to be decoded from the file
+  if ( ! mTestSubset && ( mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ) )
+  {
+    QList<int> columns;
+    Q_FOREACH ( int fieldIdx, mRequest.subsetOfAttributes() )
+    {
+      if ( fieldIdx >= 0 && fieldIdx < mSource->attributeColumns.count() )
+        columns << mSource->attributeColumns.at( fieldIdx );
+    }
+    if ( mLoadGeometry )
+      columns << mSource->mWktFieldIndex << mSource->mXFieldIndex << mSource->mYFieldIndex;
+    mSource->mFile->setRequestedColumns( columns );
+  }
+  else
+  {
+    mSource->mFile->resetRequestedColumns();
+  }
+
   QgsDebugMsg( QString( "Iterator is scanning file: " ) + ( mMode == FileScan ? "Yes" : "No" ) );
   QgsDebugMsg( QString( "Iterator is loading geometries: " ) + ( mLoadGeometry ? "Yes" : "No" ) );
   QgsDebugMsg( QString( "Iterator is testing geometries: " ) + ( mTestGeometry ? "Yes" : "No" ) );
@@ -528,6 +546,8 @@ QgsDelimitedTextFeatureSource::QgsDelimitedTextFeatureSource( const QgsDelimited
 
   mFile.reset( new QgsDelimitedTextFile() );
   mFile->setFromUrl( url );
+  // the line offsets recorded by the provider scan allow to read features by id quickly
+  mFile->setLineOffsets( p->mFile->lineOffsets() );
 
   mExpressionContext << QgsExpressionContextUtils::globalScope()
                      << QgsExpressionContextUtils::projectScope( QgsProject::instance() );
@@ -29,6 +29,21 @@
 #include <QRegExp>
 #include <QUrl>
 
+#include <algorithm>
+#include <cstring>
+
+// Number of lines between the offsets recorded in the mapped file
+static const int LINE_OFFSET_INTERVAL = 64;
+
+// Classes of the bytes of the mapped file for parseQuotedBytes()
+enum ByteClass
+{
+  ByteDelimiter = 1,
+  ByteQuote = 2,
+  ByteEscape = 4,
+  ByteSpace = 8,
+  ByteNonAscii = 16
+};
 
 QgsDelimitedTextFile::QgsDelimitedTextFile( const QString &url )
   : mFileName( QString() )
@@ -83,6 +98,12 @@ void QgsDelimitedTextFile::close()
     delete mWatcher;
     mWatcher = nullptr;
   }
+  mData = nullptr;
+  mDataSize = 0;
+  mDataStart = 0;
+  mDataPos = 0;
+  mCodec = nullptr;
+  mParseBytes = false;
   mLineNumber = -1;
   mRecordLineNumber = -1;
   mRecordNumber = -1;
@@ -102,7 +123,11 @@ bool QgsDelimitedTextFile::open()
       delete mFile;
       mFile = nullptr;
     }
-    if ( mFile )
+    if ( mFile && mUseRecordIndex )
+    {
+      mapFile();
+    }
+    if ( mFile && ! mData )
     {
       mStream = new QTextStream( mFile );
       if ( ! mEncoding.isEmpty() )
@@ -110,6 +135,9 @@ bool QgsDelimitedTextFile::open()
         QTextCodec *codec =  QTextCodec::codecForName( mEncoding.toLatin1() );
         mStream->setCodec( codec );
       }
+    }
+    if ( mFile )
+    {
       if ( mUseWatcher )
       {
         mWatcher = new QFileSystemWatcher();
@@ -121,9 +149,74 @@ bool QgsDelimitedTextFile::open()
   return nullptr != mFile;
 }
 
+void QgsDelimitedTextFile::mapFile()
+{
+  // ASCII characters must be single bytes which are not part of other characters
+  QTextCodec *codec = QTextCodec::codecForName( mEncoding.toLatin1() );
+  QByteArray codecName = codec ? codec->name().toLower() : QByteArray();
+  if ( codecName != "utf-8" && ! codecName.startsWith( "iso-8859-" ) && ! codecName.startsWith( "windows-125" ) )
+    return;
+
+  qint64 size = mFile->size();
+  uchar *data = size > 0 ? mFile->map( 0, size ) : nullptr;
+  if ( ! data )
+  {
+    QgsDebugMsg( "Data file " + mFileName + " could not be mapped" );
+    return;
+  }
+
+  // Like QTextStream, skip a UTF-8 byte order mark and leave UTF-16 and UTF-32 files to QTextStream
+  const char *bytes = reinterpret_cast< const char * >( data );
+  mDataStart = 0;
+  if ( size >= 3 && memcmp( bytes, "\xEF\xBB\xBF", 3 ) == 0 )
+  {
+    codec = QTextCodec::codecForName( "UTF-8" );
+    mDataStart = 3;
+  }
+  else if ( size >= 2 && ( memcmp( bytes, "\xFF\xFE", 2 ) == 0 || memcmp( bytes, "\xFE\xFF", 2 ) == 0 ||
+                           ( size >= 4 && memcmp( bytes, "\0\0\xFE\xFF", 4 ) == 0 ) ) )
+  {
+    mFile->unmap( data );
+    return;
+  }
+
+  mData = bytes;
+  mDataSize = size;
+  mDataPos = mDataStart;
+  mCodec = codec;
+
+  // CSV records are split from the bytes if the special characters are ASCII
+  memset( mByteClass, 0, sizeof( mByteClass ) );
+  for ( int i = 0x80; i < 0x100; i++ )
+    mByteClass[i] = ByteNonAscii;
+  Q_FOREACH ( char c, QByteArray( " \t\n\v\f\r" ) )
+    mByteClass[static_cast< unsigned char >( c )] |= ByteSpace;
+
+  mParseBytes = mType == DelimTypeCSV;
+  auto classify = [this]( const QString & chars, unsigned char byteClass )
+  {
+    Q_FOREACH ( QChar c, chars )
+    {
+      if ( c.unicode() < 0x80 )
+        mByteClass[c.unicode()] |= byteClass;
+      else
+        mParseBytes = false;
+    }
+  };
+  classify( mDelimChars, ByteDelimiter );
+  classify( mQuoteChar, ByteQuote );
+  classify( mEscapeChar, ByteEscape );
+}
+
+QString QgsDelimitedTextFile::decode( const char *data, qint64 size ) const
+{
+  return mCodec->toUnicode( data, static_cast< int >( size ) );
+}
+
 void QgsDelimitedTextFile::updateFile()
 {
   close();
+  mLineOffsets.clear();
   emit fileUpdated();
 }
 
@@ -133,6 +226,7 @@ void QgsDelimitedTextFile::resetDefinition()
   close();
   mFieldNames.clear();
   mMaxFieldCount = 0;
+  mLineOffsets.clear();
 }
 
 // Extract the provider definition from the url
@@ -163,6 +257,11 @@ bool QgsDelimitedTextFile::setFromUrl( const QUrl &url )
     mUseWatcher = url.queryItemValue( QStringLiteral( "watchFile" ) ).toUpper().startsWith( 'Y' );
   }
 
+  if ( url.hasQueryItem( QStringLiteral( "recordIndex" ) ) )
+  {
+    mUseRecordIndex = ! url.queryItemValue( QStringLiteral( "recordIndex" ) ).toUpper().startsWith( 'N' );
+  }
+
   // The default type is csv, to be consistent with the
   // previous implementation (except that quoting should be handled properly)
 
@@ -240,6 +339,7 @@ bool QgsDelimitedTextFile::setFromUrl( const QUrl &url )
   QgsDebugMsg( "Use headers: " + QString( mUseHeader ? "Yes" : "No" ) );
   QgsDebugMsg( "Discard empty fields: " + QString( mDiscardEmptyFields ? "Yes" : "No" ) );
   QgsDebugMsg( "Trim fields: " + QString( mTrimFields ? "Yes" : "No" ) );
+  QgsDebugMsg( "Record index: " + QString( mUseRecordIndex ? "Yes" : "No" ) );
 
   // Support for previous version of plain characters
   if ( type == QLatin1String( "csv" ) || type == QLatin1String( "plain" ) )
@@ -274,6 +374,11 @@ QUrl QgsDelimitedTextFile::url()
     url.addQueryItem( QStringLiteral( "watchFile" ), QStringLiteral( "yes" ) );
   }
 
+  if ( mUseRecordIndex )
+  {
+    url.addQueryItem( QStringLiteral( "recordIndex" ), QStringLiteral( "yes" ) );
+  }
+
   url.addQueryItem( QStringLiteral( "type" ), type() );
   if ( mType == DelimTypeRegexp )
   {
@@ -326,6 +431,50 @@ void QgsDelimitedTextFile::setUseWatcher( bool useWatcher )
   mUseWatcher = useWatcher;
 }
 
+void QgsDelimitedTextFile::setUseRecordIndex( bool useRecordIndex )
+{
+  resetDefinition();
+  mUseRecordIndex = useRecordIndex;
+}
+
+void QgsDelimitedTextFile::setLineOffsets( const QVector<qint64> &offsets )
+{
+  mLineOffsets = offsets;
+}
+
+int QgsDelimitedTextFile::lineOffsetInterval()
+{
+  return LINE_OFFSET_INTERVAL;
+}
+
+void QgsDelimitedTextFile::setRequestedColumns( const QList<int> &columns )
+{
+  QVector<bool> requested;
+  Q_FOREACH ( int column, columns )
+  {
+    if ( column < 0 ) continue;
+    if ( column >= requested.size() ) requested.resize( column + 1 );
+    requested[column] = true;
+  }
+  if ( ! mAllColumnsRequested && requested == mRequestedColumns ) return;
+
+  mAllColumnsRequested = false;
+  mRequestedColumns = requested;
+  // The current record may lack the fields which are now required
+  mHoldCurrentRecord = false;
+  mRecordLineNumber = -1;
+}
+
+void QgsDelimitedTextFile::resetRequestedColumns()
+{
+  if ( mAllColumnsRequested ) return;
+
+  mAllColumnsRequested = true;
+  mRequestedColumns.clear();
+  mHoldCurrentRecord = false;
+  mRecordLineNumber = -1;
+}
+
 QString QgsDelimitedTextFile::type()
 {
   if ( mType == DelimTypeWhitespace ) return QStringLiteral( "whitespace" );
@@ -529,7 +678,12 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &reco
 
     // Find the first non-blank line to read
     QString buffer;
-    status = nextLine( buffer, true );
+    const char *bytes = nullptr;
+    qint64 size = 0;
+    if ( mData && mParseBytes )
+      status = nextLineBytes( bytes, size, true );
+    else
+      status = nextLine( buffer, true );
     if ( status != RecordOk ) return RecordEOF;
 
     mCurrentRecord.clear();
@@ -539,7 +693,20 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextRecord( QStringList &reco
       mRecordNumber++;
       if ( mRecordNumber > mMaxRecordNumber ) mMaxRecordNumber = mRecordNumber;
     }
-    status = ( this->*mParser )( buffer, mCurrentRecord );
+    if ( bytes )
+    {
+      status = parseQuotedBytes( bytes, size, mCurrentRecord );
+      // The record needs to be decoded to recognise whitespace
+      if ( status == InvalidDefinition )
+      {
+        buffer = decode( bytes, size );
+        status = parseQuoted( buffer, mCurrentRecord );
+      }
+    }
+    else
+    {
+      status = ( this->*mParser )( buffer, mCurrentRecord );
+    }
   }
   if ( status == RecordOk )
   {
@@ -555,7 +722,10 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   if ( ! isValid() || ! open() ) return InvalidDefinition;
 
   // Reset the file pointer
-  mStream->seek( 0 );
+  if ( mData )
+    mDataPos = mDataStart;
+  else
+    mStream->seek( 0 );
   mLineNumber = 0;
   mRecordNumber = -1;
   mRecordLineNumber = -1;
@@ -563,6 +733,13 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   // Skip header lines
   for ( int i = mSkipLines; i-- > 0; )
   {
+    if ( mData )
+    {
+      const char *buffer = nullptr;
+      qint64 size = 0;
+      if ( nextLineBytes( buffer, size, false ) != RecordOk ) return RecordEOF;
+      continue;
+    }
     if ( mStream->readLine().isNull() ) return RecordEOF;
     mLineNumber++;
   }
@@ -570,8 +747,12 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
   Status result = RecordOk;
   if ( mUseHeader )
   {
+    // All the names are required, whatever the requested columns
     QStringList names;
+    bool allColumnsRequested = mAllColumnsRequested;
+    mAllColumnsRequested = true;
     result = nextRecord( names );
+    mAllColumnsRequested = allColumnsRequested;
     setFieldNames( names );
   }
   if ( result == RecordOk ) mRecordNumber = 0;
@@ -580,12 +761,21 @@ QgsDelimitedTextFile::Status  QgsDelimitedTextFile::reset()
 
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bool skipBlank )
 {
-  if ( ! mStream )
+  if ( ! mStream && ! mData )
   {
     Status status = reset();
     if ( status != RecordOk ) return status;
   }
 
+  if ( mData )
+  {
+    const char *bytes = nullptr;
+    qint64 size = 0;
+    Status status = nextLineBytes( bytes, size, skipBlank );
+    if ( status == RecordOk ) buffer = decode( bytes, size );
+    return status;
+  }
+
   while ( ! mStream->atEnd() )
   {
     buffer = mStream->readLine();
@@ -599,19 +789,61 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLine( QString &buffer, bo
   return RecordEOF;
 }
 
+QgsDelimitedTextFile::Status QgsDelimitedTextFile::nextLineBytes( const char *&buffer, qint64 &size, bool skipBlank )
+{
+  while ( mDataPos < mDataSize )
+  {
+    if ( mLineNumber % LINE_OFFSET_INTERVAL == 0 && mLineNumber / LINE_OFFSET_INTERVAL == mLineOffsets.size() )
+      mLineOffsets.append( mDataPos );
+
+    // As QTextStream, end lines with \n and remove a \r before it
+    buffer = mData + mDataPos;
+    const char *end = static_cast< const char * >( memchr( buffer, '\n', static_cast< size_t >( mDataSize - mDataPos ) ) );
+    size = end ? end - buffer : mDataSize - mDataPos;
+    mDataPos += end ? size + 1 : size;
+    if ( size > 0 && buffer[size - 1] == '\r' ) size--;
+    mLineNumber++;
+    if ( skipBlank && size == 0 ) continue;
+    return RecordOk;
+  }
+
+  return RecordEOF;
+}
+
 bool QgsDelimitedTextFile::setNextLineNumber( long nextLineNumber )
 {
-  if ( ! mStream ) return false;
+  if ( ! mStream && ! mData ) return false;
+  if ( mData )
+  {
+    // Start from the closest recorded line offset if the line is not already closer
+    int offsetIndex = std::min( static_cast< int >( std::max( nextLineNumber - 1, 0L ) / LINE_OFFSET_INTERVAL ), mLineOffsets.size() - 1 );
+    long offsetLineNumber = static_cast< long >( offsetIndex ) * LINE_OFFSET_INTERVAL;
+    if ( offsetIndex >= 0 && ( mLineNumber > nextLineNumber - 1 || mLineNumber < offsetLineNumber ) )
+    {
+      if ( mLineNumber > nextLineNumber - 1 ) mRecordNumber = -1;
+      mDataPos = mLineOffsets.at( offsetIndex );
+      mLineNumber = offsetLineNumber;
+    }
+  }
   if ( mLineNumber > nextLineNumber - 1 )
   {
     mRecordNumber = -1;
-    mStream->seek( 0 );
+    if ( mData )
+      mDataPos = mDataStart;
+    else
+      mStream->seek( 0 );
     mLineNumber = 0;
   }
   QString buffer;
   while ( mLineNumber < nextLineNumber - 1 )
   {
-    if ( nextLine( buffer, false ) != RecordOk ) return false;
+    if ( mData )
+    {
+      const char *bytes = nullptr;
+      qint64 size = 0;
+      if ( nextLineBytes( bytes, size, false ) != RecordOk ) return false;
+    }
+    else if ( nextLine( buffer, false ) != RecordOk ) return false;
   }
   return true;
 
@@ -636,6 +868,49 @@ void QgsDelimitedTextFile::appendField( QStringList &record, QString field, bool
   }
 }
 
+void QgsDelimitedTextFile::appendFieldBytes( QStringList &record, const std::string &field, bool quoted )
+{
+  if ( mMaxFields > 0 && record.size() >= mMaxFields ) return;
+
+  const char *data = field.data();
+  qint64 size = static_cast< qint64 >( field.size() );
+  bool trim = ! quoted && mTrimFields;
+  if ( trim )
+  {
+    while ( size > 0 && ( mByteClass[static_cast< unsigned char >( data[0] )] & ByteSpace ) )
+    {
+      data++;
+      size--;
+    }
+    while ( size > 0 && ( mByteClass[static_cast< unsigned char >( data[size - 1] )] & ByteSpace ) )
+      size--;
+  }
+
+  // Only decode required fields, the first non empty field of the record so that
+  // empty records are recognised, and fields which may start or end with whitespace
+  // which is not ASCII
+  int column = record.size();
+  bool required = mAllColumnsRequested || ( column < mRequestedColumns.size() && mRequestedColumns.at( column ) );
+  bool nonAsciiEnds = trim && size > 0 && ( ( mByteClass[static_cast< unsigned char >( data[0] )] & ByteNonAscii ) ||
+                      ( mByteClass[static_cast< unsigned char >( data[size - 1] )] & ByteNonAscii ) );
+  bool empty = size == 0;
+  QString value;
+  if ( required || nonAsciiEnds || ( ! empty && ! mRecordHasValue ) )
+  {
+    value = decode( data, size );
+    if ( trim ) value = value.trimmed();
+    empty = value.isEmpty();
+  }
+
+  if ( quoted || !( mDiscardEmptyFields && empty ) ) record.append( value );
+  // Keep track of maximum number of non-empty fields in a record
+  if ( record.size() > mMaxFieldCount && ! empty )
+  {
+    mMaxFieldCount = record.size();
+  }
+  if ( ! empty ) mRecordHasValue = true;
+}
+
 QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseRegexp( QString &buffer, QStringList &fields )
 {
 
@@ -838,6 +1113,144 @@ QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseQuoted( QString &buffer,
   return status;
 }
 
+// Same logic as parseQuoted(), applied to the bytes of the mapped file
+
+QgsDelimitedTextFile::Status QgsDelimitedTextFile::parseQuotedBytes( const char *buffer, qint64 size, QStringList &fields )
+{
+  // Position after the first line of the record, in case it must be parsed again
+  const qint64 dataPos = mDataPos;
+  const long lineNumber = mLineNumber;
+
+  Status status = RecordOk;
+  std::string &field = mFieldBuffer; // Bytes of the next field, keeps its capacity
+  field.clear();
+  bool escaped = false; // Next char is escaped
+  bool quoted = false;  // In quotes
+  char quoteChar = 0;   // Actual quote character used to open quotes
+  bool started = false; // Non-blank chars in field or quotes started
+  bool ended = false;   // Quoted field ended
+  qint64 cp = 0;        // Pointer to the next character in the buffer
+  mRecordHasValue = false;
+
+  while ( true )
+  {
+    // If end of line then if escaped or buffered then try to get more...
+    if ( cp >= size )
+    {
+      if ( quoted || escaped )
+      {
+        status = nextLineBytes( buffer, size, false );
+        if ( status != RecordOk )
+        {
+          status = RecordInvalid;
+          break;
+        }
+        field += '\n';
+        cp = 0;
+        escaped = false;
+        continue;
+      }
+      break;
+    }
+
+    char c = buffer[cp];
+    cp++;
+
+    // If escaped, then just append the character
+    if ( escaped )
+    {
+      field += c;
+      escaped = false;
+      continue;
+    }
+
+    unsigned char byteClass = mByteClass[static_cast< unsigned char >( c )];
+    bool isQuote = false;
+    bool isEscape = false;
+    bool isDelim = byteClass & ByteDelimiter;
+    if ( ! isDelim )
+    {
+      bool isQuoteChar = byteClass & ByteQuote;
+      isQuote = quoted ? c == quoteChar : isQuoteChar;
+      isEscape = byteClass & ByteEscape;
+      if ( isQuoteChar && isEscape ) isEscape = isQuote;
+    }
+
+    if ( isQuote )
+    {
+      if ( quoted )
+      {
+        if ( isEscape && cp < size && buffer[cp] == quoteChar )
+        {
+          field += quoteChar;
+          cp++;
+        }
+        else
+        {
+          quoted = false;
+          ended =  true;
+        }
+      }
+      else if ( ! started )
+      {
+        field.clear();
+        quoteChar = c;
+        quoted = true;
+        started = true;
+      }
+      else
+      {
+        fields.clear();
+        return RecordInvalid;
+      }
+    }
+    else if ( isEscape )
+    {
+      escaped = true;
+    }
+    else if ( quoted )
+    {
+      field += c;
+    }
+    else if ( isDelim )
+    {
+      appendFieldBytes( fields, field, ended );
+      field.clear();
+      started = false;
+      ended = false;
+    }
+    // Characters which are not ASCII may be whitespace, which is only significant
+    // before the start of a field or after the end
+    else if ( ( byteClass & ByteNonAscii ) && ( ! started || ended ) )
+    {
+      fields.clear();
+      mDataPos = dataPos;
+      mLineNumber = lineNumber;
+      return InvalidDefinition;
+    }
+    else if ( byteClass & ByteSpace )
+    {
+      if ( ! ended ) field += c;
+    }
+    else
+    {
+      if ( ended )
+      {
+        fields.clear();
+        return RecordInvalid;
+      }
+      field += c;
+      started = true;
+    }
+  }
+  // If reached the end of the record, then add the last field...
+  if ( started )
+  {
+    appendFieldBytes( fields, field, ended );
+  }
+  return status;
+}
+
 bool QgsDelimitedTextFile::isValid()
 {
   return mDefinitionValid && QFile::exists( mFileName ) && QFileInfo( mFileName ).size() > 0;
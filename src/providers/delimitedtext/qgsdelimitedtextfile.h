@@ -22,11 +22,15 @@
 #include <QRegExp>
 #include <QUrl>
 #include <QObject>
+#include <QVector>
+
+#include <string>
 
 class QgsFeature;
 class QgsField;
 class QFile;
 class QFileSystemWatcher;
+class QTextCodec;
 class QTextStream;
 
 
@@ -65,6 +69,8 @@ class QTextStream;
 *   The field is ignored for csv and whitespace
 * - quoteChar, optional, a single character used for quoting plain fields
 * - escapeChar, optional, a single character used for escaping (may be the same as quoteChar)
+* - recordIndex, optional, if yes the file is memory-mapped instead of being read through
+*   a QTextStream (see setUseRecordIndex())
 */
 
 // Note: this has been implemented as a single class rather than a set of classes based
@@ -306,6 +312,53 @@ class QgsDelimitedTextFile : public QObject
 
     void setUseWatcher( bool useWatcher );
 
+    /** Set to read the file through a memory mapping rather than a QTextStream.
+     *  The offsets of the lines are recorded while the file is read (see lineOffsets()),
+     *  so that setNextRecordId() does not need to read the file from its beginning,
+     *  and CSV records are split into fields directly from the mapped bytes (see
+     *  setRequestedColumns()).  The mapping is only used for encodings in which
+     *  ASCII characters are single bytes, and the file must not be rewritten while
+     *  it is open.
+     *  \param useRecordIndex True to map the file, false otherwise
+     */
+    void setUseRecordIndex( bool useRecordIndex );
+
+    /** Return the option for mapping the file
+     *  \returns useRecordIndex The file is memory-mapped if possible if true
+     */
+    bool useRecordIndex() { return mUseRecordIndex; }
+
+    /** Return the offsets of the lines of the mapped file read so far.  Element i
+     *  is the offset in bytes of the start of the line following the first
+     *  i * lineOffsetInterval() lines.
+     *  \returns offsets The offsets of the lines
+     */
+    QVector<qint64> lineOffsets() const { return mLineOffsets; }
+
+    /** Set the offsets of the lines of the file, as returned by lineOffsets()
+     *  for the same file content, e.g. to share them with another parser of the file.
+     *  \param offsets The offsets of the lines
+     */
+    void setLineOffsets( const QVector<qint64> &offsets );
+
+    /** Return the number of lines between the offsets recorded in lineOffsets()
+     */
+    static int lineOffsetInterval();
+
+    /** Set the columns of the records which are required.  When CSV records
+     *  are split from the mapped file, the other fields are returned as null
+     *  strings (except the first non empty field of a record, so that empty
+     *  records can still be recognised), which avoids decoding them.
+     *  \param columns The zero based indexes of the required columns
+     *  \see resetRequestedColumns()
+     */
+    void setRequestedColumns( const QList<int> &columns );
+
+    /** Require all the columns of the records (the default)
+     *  \see setRequestedColumns()
+     */
+    void resetRequestedColumns();
+
   signals:
 
     /** Signal sent when the file is updated by another process
@@ -330,6 +383,10 @@ class QgsDelimitedTextFile : public QObject
      */
     void close();
 
+    /** Map the opened file if its encoding allows parsing its bytes
+     */
+    void mapFile();
+
     /** Reset the status if the definition is changing (e.g., clear
      *  existing field names, etc...
      */
@@ -340,6 +397,20 @@ class QgsDelimitedTextFile : public QObject
     //! Parse quote delimited fields, where quote and escape are different
     Status parseQuoted( QString &buffer, QStringList &fields );
 
+    /** Parse quote delimited fields directly from a line of the mapped file.
+     *  Returns InvalidDefinition if the record must be parsed with parseQuoted()
+     *  instead, as it contains characters which may be whitespace and are not ASCII.
+     */
+    Status parseQuotedBytes( const char *buffer, qint64 size, QStringList &fields );
+
+    /** Return the next line from the mapped file, without its end of line
+     *  characters.  The line is not decoded.
+     */
+    Status nextLineBytes( const char *&buffer, qint64 &size, bool skipBlank );
+
+    //! Decode a string from the mapped file
+    QString decode( const char *data, qint64 size ) const;
+
     /** Return the next line from the data file.  If skipBlank is true then
      * blank lines will be skipped - this is for compatibility with previous
      * delimited text parser implementation.
@@ -355,6 +426,11 @@ class QgsDelimitedTextFile : public QObject
      */
     void appendField( QStringList &record, QString field, bool quoted = false );
 
+    /** Add a field parsed from the mapped file to a record, decoding it only if
+     *  it is required.
+     */
+    void appendFieldBytes( QStringList &record, const std::string &field, bool quoted );
+
     // Pointer to the currently selected parser
     Status( QgsDelimitedTextFile::*mParser )( QString &buffer, QStringList &fields );
 
@@ -365,6 +441,22 @@ class QgsDelimitedTextFile : public QObject
     bool mUseWatcher;
     QFileSystemWatcher *mWatcher = nullptr;
 
+    // Memory-mapped file
+    bool mUseRecordIndex = false;
+    const char *mData = nullptr;
+    qint64 mDataSize = 0;
+    qint64 mDataStart = 0;
+    qint64 mDataPos = 0;
+    QTextCodec *mCodec = nullptr;
+    bool mParseBytes = false;
+    QVector<qint64> mLineOffsets;
+    bool mAllColumnsRequested = true;
+    QVector<bool> mRequestedColumns;
+    bool mRecordHasValue = false;
+    std::string mFieldBuffer;
+    // Character classes of the bytes, used by parseQuotedBytes()
+    unsigned char mByteClass[256];
+
     // Parameters common to parsers
     bool mDefinitionValid;
     DelimiterType mType;
@@ -25,6 +25,7 @@
 #include <QStringList>
 #include <QSettings>
 #include <QRegExp>
+#include <QSaveFile>
 #include <QUrl>
 #include <QUrlQuery>
 
@@ -57,6 +58,10 @@ static const QString TEXT_PROVIDER_DESCRIPTION = QStringLiteral( "Delimited text
 
 static const int SUBSET_ID_THRESHOLD_FACTOR = 10;
 
+// Header of the record index file
+static const quint32 RECORD_INDEX_MAGIC = 0x51445449; // QDTI
+static const quint32 RECORD_INDEX_VERSION = 1;
+
 QRegExp QgsDelimitedTextProvider::sWktPrefixRegexp( "^\\s*(?:\\d+\\s+|SRID\\=\\d+\\;)", Qt::CaseInsensitive );
 QRegExp QgsDelimitedTextProvider::sCrdDmsRegexp( "^\\s*(?:([-+nsew])\\s*)?(\\d{1,3})(?:[^0-9.]+([0-5]?\\d))?[^0-9.]+([0-5]?\\d(?:\\.\\d+)?)[^0-9.]*([-+nsew])?\\s*$", Qt::CaseInsensitive );
 
@@ -83,6 +88,8 @@ QgsDelimitedTextProvider::QgsDelimitedTextProvider( const QString &uri )
   , mWkbType( QgsWkbTypes::NoGeometry )
   , mGeometryType( QgsWkbTypes::UnknownGeometry )
   , mBuildSpatialIndex( false )
+  , mSpatialIndexFile( false )
+  , mRecordIndexFile( false )
   , mSpatialIndex( nullptr )
 {
 
@@ -152,7 +159,15 @@ QgsDelimitedTextProvider::QgsDelimitedTextProvider( const QString &uri )
 
   if ( url.hasQueryItem( QStringLiteral( "spatialIndex" ) ) )
   {
-    mBuildSpatialIndex = ! url.queryItemValue( QStringLiteral( "spatialIndex" ) ).toLower().startsWith( 'n' );
+    QString spatialIndex = url.queryItemValue( QStringLiteral( "spatialIndex" ) ).toLower();
+    mBuildSpatialIndex = ! spatialIndex.startsWith( 'n' );
+    mSpatialIndexFile = spatialIndex == QLatin1String( "file" );
+  }
+
+  // The data file itself is memory-mapped unless recordIndex=no, see QgsDelimitedTextFile
+  if ( url.hasQueryItem( QStringLiteral( "recordIndex" ) ) )
+  {
+    mRecordIndexFile = url.queryItemValue( QStringLiteral( "recordIndex" ) ).toLower() == QLatin1String( "file" );
   }
 
   if ( url.hasQueryItem( QStringLiteral( "subset" ) ) )
@@ -302,6 +317,135 @@ void QgsDelimitedTextProvider::resetIndexes() const
   if ( mBuildSpatialIndex && mGeomRep != GeomNone ) mSpatialIndex = new QgsSpatialIndex();
 }
 
+void QgsDelimitedTextProvider::saveSpatialIndex() const
+{
+  if ( !mSpatialIndexFile || !mSpatialIndex )
+    return;
+
+  QString fileName = mFile->fileName();
+  if ( !mSpatialIndex->writeToFile( QgsSpatialIndex::indexFileName( fileName ), QFileInfo( fileName ).lastModified(), mNumberFeatures ) )
+  {
+    QgsDebugMsg( "Cannot write spatial index for " + fileName );
+  }
+}
+
+QString QgsDelimitedTextProvider::recordIndexFileName( const QString &filename )
+{
+  return filename + QStringLiteral( ".qdi" );
+}
+
+QString QgsDelimitedTextProvider::scanDefinition() const
+{
+  QUrl url = QUrl::fromEncoded( dataSourceUri().toLatin1() );
+  Q_FOREACH ( const QString &item, QStringList() << QStringLiteral( "subset" ) << QStringLiteral( "subsetIndex" )
+              << QStringLiteral( "spatialIndex" ) << QStringLiteral( "recordIndex" ) << QStringLiteral( "crs" )
+              << QStringLiteral( "quiet" ) << QStringLiteral( "watchFile" ) )
+  {
+    url.removeAllQueryItems( item );
+  }
+  return QString::fromAscii( url.toEncoded() );
+}
+
+bool QgsDelimitedTextProvider::readRecordIndex( ScanResults &scanResults, bool buildSubsetIndex )
+{
+  QString fileName = mFile->fileName();
+  QFile file( recordIndexFileName( fileName ) );
+  if ( ! file.open( QIODevice::ReadOnly ) )
+    return false;
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  quint32 magic = 0;
+  quint32 version = 0;
+  stream >> magic >> version;
+  if ( magic != RECORD_INDEX_MAGIC || version != RECORD_INDEX_VERSION )
+  {
+    QgsDebugMsg( file.fileName() + " is not a valid record index" );
+    return false;
+  }
+
+  // The index is only valid for the same file content and the same parsing options
+  QFileInfo info( fileName );
+  qint64 modified = 0;
+  qint64 size = 0;
+  QString definition;
+  stream >> modified >> size >> definition;
+  if ( modified != info.lastModified().toMSecsSinceEpoch() || size != info.size() || definition != scanDefinition() )
+  {
+    QgsDebugMsg( "Record index of " + fileName + " is outdated" );
+    return false;
+  }
+
+  ScanResults results;
+  qint32 wkbType = 0;
+  qint32 geometryType = 0;
+  QgsRectangle extent;
+  qint64 numberFeatures = 0;
+  bool wktHasPrefix = false;
+  bool useSubsetIndex = false;
+  QVector<qint64> subsetIndex;
+  QVector<qint64> lineOffsets;
+  stream >> results.fieldNames >> results.isEmpty >> results.couldBeInt >> results.couldBeLongLong >> results.couldBeDouble
+         >> results.warnings >> wkbType >> geometryType >> extent >> numberFeatures >> wktHasPrefix
+         >> useSubsetIndex >> subsetIndex >> lineOffsets;
+  if ( stream.status() != QDataStream::Ok )
+  {
+    QgsDebugMsg( "Cannot read record index of " + fileName );
+    return false;
+  }
+
+  scanResults = results;
+  mWkbType = static_cast< QgsWkbTypes::Type >( wkbType );
+  mGeometryType = static_cast< QgsWkbTypes::GeometryType >( geometryType );
+  mExtent = extent;
+  mNumberFeatures = numberFeatures;
+  mWktHasPrefix = wktHasPrefix;
+  if ( buildSubsetIndex && useSubsetIndex )
+  {
+    mUseSubsetIndex = true;
+    mSubsetIndex.reserve( subsetIndex.size() );
+    Q_FOREACH ( qint64 id, subsetIndex )
+      mSubsetIndex.append( static_cast< quintptr >( id ) );
+  }
+  mFile->setLineOffsets( lineOffsets );
+  return true;
+}
+
+void QgsDelimitedTextProvider::writeRecordIndex( const ScanResults &results ) const
+{
+  QString fileName = mFile->fileName();
+  QFileInfo info( fileName );
+  QSaveFile file( recordIndexFileName( fileName ) );
+  if ( ! file.open( QIODevice::WriteOnly ) )
+  {
+    QgsDebugMsg( "Cannot write record index for " + fileName );
+    return;
+  }
+
+  QVector<qint64> subsetIndex;
+  if ( mUseSubsetIndex )
+  {
+    subsetIndex.reserve( mSubsetIndex.size() );
+    Q_FOREACH ( quintptr id, mSubsetIndex )
+      subsetIndex.append( static_cast< qint64 >( id ) );
+  }
+
+  QDataStream stream( &file );
+  stream.setVersion( QDataStream::Qt_5_0 );
+  stream << RECORD_INDEX_MAGIC << RECORD_INDEX_VERSION
+         << info.lastModified().toMSecsSinceEpoch() << info.size() << scanDefinition()
+         << results.fieldNames << results.isEmpty << results.couldBeInt << results.couldBeLongLong << results.couldBeDouble
+         << results.warnings << static_cast< qint32 >( mWkbType ) << static_cast< qint32 >( mGeometryType ) << mExtent
+         << static_cast< qint64 >( mNumberFeatures ) << mWktHasPrefix
+         << mUseSubsetIndex << subsetIndex << mFile->lineOffsets();
+  if ( stream.status() != QDataStream::Ok )
+    file.cancelWriting();
+  if ( ! file.commit() )
+  {
+    QgsDebugMsg( "Cannot write record index for " + fileName );
+  }
+}
+
 bool QgsDelimitedTextProvider::createSpatialIndex()
 {
   if ( mBuildSpatialIndex ) return true; // Already built
@@ -343,6 +487,15 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   resetIndexes();
   bool buildSpatialIndex = buildIndexes && nullptr != mSpatialIndex;
 
+  // A spatial index stored next to the file saves inserting all features. Together
+  // with the scan results stored in the record index it saves scanning the file at
+  // all. It is validated against the number of features once these are known.
+
+  QString spatialIndexFileName = QgsSpatialIndex::indexFileName( mFile->fileName() );
+  QDateTime fileModified = QFileInfo( mFile->fileName() ).lastModified();
+  bool spatialIndexFromFile = buildSpatialIndex && mSpatialIndexFile && mSpatialIndex->readFromFile( spatialIndexFileName, fileModified );
+  bool insertIntoSpatialIndex = buildSpatialIndex && ! spatialIndexFromFile;
+
   // No point building a subset index if there is no geometry, as all
   // records will be included.
 
@@ -399,22 +552,37 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   //
   // Also build subset and spatial indexes.
 
+  // The results of a previous scan are read from the record index file, unless
+  // the geometries need to be inserted into the spatial index. A spatial index file
+  // always comes with such a record index.
+
+  ScanResults results;
+  bool readIndex = ( mRecordIndexFile || spatialIndexFromFile ) && ! insertIntoSpatialIndex && readRecordIndex( results, buildSubsetIndex );
+
   QStringList parts;
   long nEmptyRecords = 0;
   long nBadFormatRecords = 0;
   long nIncompatibleGeometry = 0;
   long nInvalidGeometry = 0;
   long nEmptyGeometry = 0;
-  mNumberFeatures = 0;
-  mExtent = QgsRectangle();
 
-  QList<bool> isEmpty;
-  QList<bool> couldBeInt;
-  QList<bool> couldBeLongLong;
-  QList<bool> couldBeDouble;
+  if ( readIndex )
+  {
+    QgsDebugMsg( "Scan results read from the record index of " + mFile->fileName() );
+  }
+  else
+  {
+    mNumberFeatures = 0;
+    mExtent = QgsRectangle();
+  }
+
+  QList<bool> isEmpty = results.isEmpty;
+  QList<bool> couldBeInt = results.couldBeInt;
+  QList<bool> couldBeLongLong = results.couldBeLongLong;
+  QList<bool> couldBeDouble = results.couldBeDouble;
   bool foundFirstGeometry = false;
 
-  while ( true )
+  while ( ! readIndex )
   {
     QgsDelimitedTextFile::Status status = mFile->nextRecord( parts );
     if ( status == QgsDelimitedTextFile::RecordEOF ) break;
@@ -474,7 +642,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
                 QgsRectangle bbox( geom.boundingBox() );
                 mExtent.combineExtentWith( bbox );
               }
-              if ( buildSpatialIndex )
+              if ( insertIntoSpatialIndex )
               {
                 QgsFeature f;
                 f.setId( mFile->recordId() );
@@ -529,7 +697,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
             foundFirstGeometry = true;
           }
           mNumberFeatures++;
-          if ( buildSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
+          if ( insertIntoSpatialIndex && std::isfinite( pt.x() ) && std::isfinite( pt.y() ) )
           {
             QgsFeature f;
             f.setId( mFile->recordId() );
@@ -612,10 +780,26 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
     }
   }
 
+  if ( spatialIndexFromFile && ! mSpatialIndex->readFromFile( spatialIndexFileName, fileModified, mNumberFeatures ) )
+  {
+    // The index file does not match the file content, drop it and scan the file
+    // again to rebuild it
+    QgsDebugMsg( "Spatial index file does not match " + mFile->fileName() );
+    QFile::remove( recordIndexFileName( mFile->fileName() ) );
+    if ( QFile::remove( spatialIndexFileName ) )
+    {
+      mFile->reset();
+      scanFile( buildIndexes );
+      return;
+    }
+    // cannot drop it, rebuild the index in memory when the layer is used
+    mRescanRequired = true;
+  }
+
   // Now create the attribute fields.  Field types are integer by preference,
   // failing that double, failing that text.
 
-  QStringList fieldNames = mFile->fieldNames();
+  QStringList fieldNames = readIndex ? results.fieldNames : mFile->fieldNames();
   mFieldCount = fieldNames.size();
   attributeColumns.clear();
   attributeFields.clear();
@@ -676,16 +860,19 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   QgsDebugMsg( "geometry type is: " + QString::number( mWkbType ) );
   QgsDebugMsg( "feature count is: " + QString::number( mNumberFeatures ) );
 
-  QStringList warnings;
-  if ( ! csvtMessage.isEmpty() ) warnings.append( csvtMessage );
+  QStringList scanWarnings = results.warnings;
   if ( nBadFormatRecords > 0 )
-    warnings.append( tr( "%1 records discarded due to invalid format" ).arg( nBadFormatRecords ) );
+    scanWarnings.append( tr( "%1 records discarded due to invalid format" ).arg( nBadFormatRecords ) );
   if ( nEmptyGeometry > 0 )
-    warnings.append( tr( "%1 records have missing geometry definitions" ).arg( nEmptyGeometry ) );
+    scanWarnings.append( tr( "%1 records have missing geometry definitions" ).arg( nEmptyGeometry ) );
   if ( nInvalidGeometry > 0 )
-    warnings.append( tr( "%1 records discarded due to invalid geometry definitions" ).arg( nInvalidGeometry ) );
+    scanWarnings.append( tr( "%1 records discarded due to invalid geometry definitions" ).arg( nInvalidGeometry ) );
   if ( nIncompatibleGeometry > 0 )
-    warnings.append( tr( "%1 records discarded due to incompatible geometry types" ).arg( nIncompatibleGeometry ) );
+    scanWarnings.append( tr( "%1 records discarded due to incompatible geometry types" ).arg( nIncompatibleGeometry ) );
+
+  QStringList warnings;
+  if ( ! csvtMessage.isEmpty() ) warnings.append( csvtMessage );
+  warnings.append( scanWarnings );
 
   reportErrors( warnings );
 
@@ -693,7 +880,7 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
   // If more than 10% of records are being skipped, then use index.  (Not based on any experimentation,
   // could do with some analysis?)
 
-  if ( buildSubsetIndex )
+  if ( buildSubsetIndex && ! readIndex )
   {
     long recordCount = mFile->recordCount();
     recordCount -= recordCount / SUBSET_ID_THRESHOLD_FACTOR;
@@ -703,9 +890,25 @@ void QgsDelimitedTextProvider::scanFile( bool buildIndexes )
 
   mUseSpatialIndex = buildSpatialIndex;
 
+  if ( insertIntoSpatialIndex )
+  {
+    saveSpatialIndex();
+  }
+
   mValid = mGeometryType != QgsWkbTypes::UnknownGeometry;
   mLayerValid = mValid;
 
+  if ( mValid && ( mRecordIndexFile || mSpatialIndexFile ) && ! readIndex )
+  {
+    results.fieldNames = fieldNames;
+    results.isEmpty = isEmpty;
+    results.couldBeInt = couldBeInt;
+    results.couldBeLongLong = couldBeLongLong;
+    results.couldBeDouble = couldBeDouble;
+    results.warnings = scanWarnings;
+    writeRecordIndex( results );
+  }
+
   // If it is valid, then watch for changes to the file
   connect( mFile, &QgsDelimitedTextFile::fileUpdated, this, &QgsDelimitedTextProvider::onFileUpdated );
 
@@ -807,6 +1010,9 @@ void QgsDelimitedTextProvider::rescanFile() const
   }
 
   mUseSpatialIndex = buildSpatialIndex;
+
+  // the index of a subset does not match the whole file
+  if ( buildSpatialIndex && ! mSubsetExpression ) saveSpatialIndex();
 }
 
 QgsGeometry QgsDelimitedTextProvider::geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp )
@@ -183,24 +183,52 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
      */
     QStringList readCsvtFieldTypes( const QString &filename, QString *message = nullptr );
 
+    /**
+     * Returns the name of the file in which the record index and the results of the
+     * scan of the delimited text file \a filename are kept (recordIndex=file).
+     */
+    static QString recordIndexFileName( const QString &filename );
+
   private slots:
 
     void onFileUpdated();
 
   private:
 
+    //! Results of the scan of the file, besides the provider members, kept in the record index file
+    struct ScanResults
+    {
+      QStringList fieldNames;
+      QList<bool> isEmpty;
+      QList<bool> couldBeInt;
+      QList<bool> couldBeLongLong;
+      QList<bool> couldBeDouble;
+      QStringList warnings;
+    };
+
     void scanFile( bool buildIndexes );
 
     //some of these methods const, as they need to be called from const methods such as extent()
     void rescanFile() const;
     void resetCachedSubset() const;
     void resetIndexes() const;
+    void saveSpatialIndex() const;
     void clearInvalidLines() const;
     void recordInvalidLine( const QString &message );
     void reportErrors( const QStringList &messages = QStringList(), bool showDialog = false ) const;
     static bool recordIsEmpty( QStringList &record );
     void setUriParameter( const QString &parameter, const QString &value );
 
+    /**
+     * Reads the results of a previous scan of the file from the record index file,
+     * if it is still up to date. The subset index is only read if \a buildSubsetIndex is true.
+     */
+    bool readRecordIndex( ScanResults &results, bool buildSubsetIndex );
+    //! Writes the results of the scan of the file to the record index file
+    void writeRecordIndex( const ScanResults &results ) const;
+    //! Returns the parts of the uri which affect the results of the scan of the file
+    QString scanDefinition() const;
+
 
     static QgsGeometry geomFromWkt( QString &sWkt, bool wktHasPrefixRegexp );
     static bool pointFromXY( QString &sX, QString &sY, QgsPointXY &point, const QString &decimalPoint, bool xyDms );
@@ -269,6 +297,10 @@ class QgsDelimitedTextProvider : public QgsVectorDataProvider
 
     // Spatial index
     bool mBuildSpatialIndex;
+    //! Keep the spatial index in a file next to the data file (spatialIndex=file)
+    bool mSpatialIndexFile;
+    //! Keep the record index and scan results in a file next to the data file (recordIndex=file)
+    bool mRecordIndexFile;
     mutable bool mUseSpatialIndex;
     mutable bool mCachedUseSpatialIndex;
     mutable QgsSpatialIndex *mSpatialIndex;
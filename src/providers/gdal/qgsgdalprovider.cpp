@@ -267,6 +267,37 @@ void QgsGdalProvider::closeDataset()
   mGdalDataset = nullptr;
 }
 
+void QgsGdalProvider::reloadData()
+{
+  if ( !mGdalBaseDataset )
+    return;
+
+  bool warped = mGdalDataset != mGdalBaseDataset;
+
+  GDALDereferenceDataset( mGdalBaseDataset );
+  GDALClose( mGdalDataset );
+  mGdalDataset = nullptr;
+
+  mGdalBaseDataset = gdalOpen( dataSourceUri().toUtf8().constData(), mUpdate ? GA_Update : GA_ReadOnly );
+  if ( !mGdalBaseDataset )
+  {
+    mValid = false;
+    appendError( ERRMSG( tr( "Cannot reopen GDAL dataset %1" ).arg( dataSourceUri() ) ) );
+    return;
+  }
+
+  if ( warped )
+  {
+    mGdalDataset = GDALAutoCreateWarpedVRT( mGdalBaseDataset, nullptr, nullptr,
+                                            GRA_NearestNeighbour, 0.2, nullptr );
+  }
+  if ( !mGdalDataset )
+  {
+    mGdalDataset = mGdalBaseDataset;
+    GDALReferenceDataset( mGdalDataset );
+  }
+}
+
 QString QgsGdalProvider::metadata()
 {
   QString myMetadata;
@@ -143,6 +143,12 @@ class QgsGdalProvider : public QgsRasterDataProvider, QgsGdalProviderBase
     //! \brief Close data set and release related data
     void closeDataset();
 
+    /**
+     * Reopens the GDAL dataset, keeping the settings of the provider. This
+     * gives a forked server worker its own file handles.
+     */
+    void reloadData() override;
+
     static QMap<QString, QString> supportedMimes();
 
     bool isEditable() const override;
@@ -20,6 +20,7 @@
 
 #include "qgsogrutils.h"
 #include "qgsapplication.h"
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgslogger.h"
 #include "qgsmessagelog.h"
@@ -262,6 +263,41 @@ bool QgsOgrFeatureIterator::fetchFeature( QgsFeature &feature )
 }
 
 
+int QgsOgrFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  // features which need per-feature geometry handling are read one by one
+  if ( mTransform.isValid()
+       || mRequest.flags() & QgsFeatureRequest::ExactIntersect
+       || mSource->mOgrGeometryTypeFilter != wkbUnknown
+       || mRequest.filterType() == QgsFeatureRequest::FilterFid
+       || mRequest.filterType() == QgsFeatureRequest::FilterFids )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  if ( mClosed || !ogrLayer )
+    return 0;
+
+  int count = 0;
+  OGRFeatureH fet;
+  while ( count < maxFeatures && ( fet = OGR_L_GetNextFeature( ogrLayer ) ) )
+  {
+    if ( !mFilterRect.isNull() && !OGR_F_GetGeometryRef( fet ) )
+    {
+      OGR_F_Destroy( fet );
+      continue;
+    }
+
+    readFeatureToBatch( fet, batch );
+    OGR_F_Destroy( fet );
+    ++count;
+  }
+
+  if ( count < maxFeatures )
+    close();
+
+  return count;
+}
+
+
 bool QgsOgrFeatureIterator::rewind()
 {
   if ( mClosed || !ogrLayer )
@@ -388,6 +424,78 @@ bool QgsOgrFeatureIterator::readFeature( OGRFeatureH fet, QgsFeature &feature )
 }
 
 
+void QgsOgrFeatureIterator::readFeatureToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const
+{
+  batch.addRow( OGR_F_GetFID( fet ) );
+
+  // strings can be passed through without decoding when the source is UTF-8 already
+  bool utf8 = !mSource->mEncoding || mSource->mEncoding->mibEnum() == 106;
+
+  for ( int column = 0; column < batch.columnCount(); ++column )
+  {
+    int attindex = batch.fieldIndex( column );
+    if ( mSource->mFirstFieldIsFid && attindex == 0 )
+    {
+      batch.setInt64( column, OGR_F_GetFID( fet ) );
+      continue;
+    }
+
+    int ogrIndex = mSource->mFirstFieldIsFid ? attindex - 1 : attindex;
+    if ( !OGR_F_IsFieldSetAndNotNull( fet, ogrIndex ) )
+      continue;
+
+    switch ( batch.columnType( column ) )
+    {
+      case QgsFeatureBatch::Double:
+        batch.setDouble( column, OGR_F_GetFieldAsDouble( fet, ogrIndex ) );
+        break;
+
+      case QgsFeatureBatch::Int64:
+        batch.setInt64( column, OGR_F_GetFieldAsInteger64( fet, ogrIndex ) );
+        break;
+
+      case QgsFeatureBatch::String:
+      {
+        const char *value = OGR_F_GetFieldAsString( fet, ogrIndex );
+        if ( utf8 )
+          batch.setString( column, value, static_cast< int >( strlen( value ) ) );
+        else
+          batch.setValue( column, mSource->mEncoding->toUnicode( value ) );
+        break;
+      }
+
+      case QgsFeatureBatch::Variant:
+        batch.setValue( column, QgsOgrUtils::getOgrFeatureAttribute( fet, mSource->mFieldsWithoutFid, ogrIndex, mSource->mEncoding ) );
+        break;
+    }
+  }
+
+  if ( !mFetchGeometry || !batch.fetchGeometry() )
+    return;
+
+  OGRGeometryH geom = OGR_F_GetGeometryRef( fet );
+  if ( !geom )
+    return;
+
+  QgsWkbTypes::Type flatType = static_cast< QgsWkbTypes::Type >( wkbFlatten( OGR_G_GetGeometryType( geom ) ) );
+  if ( QgsWkbTypes::isMultiType( mSource->mWkbType ) && !QgsWkbTypes::isMultiType( flatType ) )
+  {
+    // Insure that multipart datasets return multipart geometry
+    QgsGeometry g = QgsOgrUtils::ogrGeometryToQgsGeometry( geom );
+    g.convertToMultiType();
+    QByteArray wkb = g.exportToWkb();
+    if ( !wkb.isEmpty() )
+      memcpy( batch.allocateWkb( wkb.size() ), wkb.constData(), wkb.size() );
+    return;
+  }
+
+  // export straight into the batch buffer
+  int size = OGR_G_WkbSize( geom );
+  if ( size > 0 )
+    OGR_G_ExportToWkb( geom, ( OGRwkbByteOrder ) QgsApplication::endian(), batch.allocateWkb( size ) );
+}
+
+
 QgsOgrFeatureSource::QgsOgrFeatureSource( const QgsOgrProvider *p )
   : mDataSource( p->dataSourceUri() )
   , mLayerName( p->layerName() )
@@ -63,11 +63,15 @@ class QgsOgrFeatureIterator : public QgsAbstractFeatureIteratorFromSource<QgsOgr
   protected:
     virtual bool fetchFeature( QgsFeature &feature ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
+    int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
 
   private:
 
     bool readFeature( OGRFeatureH fet, QgsFeature &feature ) const;
 
+    //! Appends attributes and geometry of an OGR feature to a new row of the batch
+    void readFeatureToBatch( OGRFeatureH fet, QgsFeatureBatch &batch ) const;
+
     //! Get an attribute associated with a feature
     void getFeatureAttribute( OGRFeatureH ogrFet, QgsFeature &f, int attindex ) const;
 
@@ -32,12 +32,15 @@
 #include <QThread>
 
 #include <climits>
+#include <cstring>
+#include <limits>
 
 // for htonl
 #ifdef Q_OS_WIN
 #include <winsock.h>
 #else
 #include <netinet/in.h>
+#include <unistd.h>
 #endif
 
 
@@ -218,6 +221,7 @@ QgsPostgresConn::QgsPostgresConn( const QString &conninfo, bool readOnly, bool s
   QString expandedConnectionInfo = uri.connectionInfo( true );
 
   mConn = PQconnectdb( expandedConnectionInfo.toLocal8Bit() );  // use what is set based on locale; after connecting, use Utf8
+  mPid = QCoreApplication::applicationPid();
 
   // remove temporary cert/key/CA if they exist
   QgsDataSourceUri expandedUri( expandedConnectionInfo );
@@ -326,11 +330,50 @@ QgsPostgresConn::QgsPostgresConn( const QString &conninfo, bool readOnly, bool s
 QgsPostgresConn::~QgsPostgresConn()
 {
   Q_ASSERT( mRef == 0 );
-  if ( mConn )
-    ::PQfinish( mConn );
+  finishConnection();
+}
+
+void QgsPostgresConn::finishConnection()
+{
+  if ( !mConn )
+    return;
+
+#ifndef Q_OS_WIN
+  // a connection inherited from the parent process is still used by it: closing
+  // the socket first, PQfinish() cannot send the termination message which would
+  // end the session of the parent
+  if ( mPid != QCoreApplication::applicationPid() )
+    ::close( ::PQsocket( mConn ) );
+#endif
+  ::PQfinish( mConn );
   mConn = nullptr;
 }
 
+void QgsPostgresConn::reconnectInChild()
+{
+  if ( !mConn || mPid == QCoreApplication::applicationPid() )
+    return;
+
+  QgsDebugMsg( "Reconnecting in forked process to " + mConnInfo );
+  finishConnection();
+
+  QgsDataSourceUri uri( mConnInfo );
+  mConn = PQconnectdb( uri.connectionInfo( true ).toLocal8Bit() );
+  mPid = QCoreApplication::applicationPid();
+  if ( PQstatus() != CONNECTION_OK )
+  {
+    QgsMessageLog::logMessage( tr( "Connection to database failed" ) + '\n' + PQerrorMessage(), tr( "PostGIS" ) );
+    return;
+  }
+
+  PQsetClientEncoding( mConn, QStringLiteral( "UNICODE" ).toLocal8Bit() );
+  if ( mPostgresqlVersion >= 90000 )
+  {
+    PQexecNR( QStringLiteral( "SET application_name='QGIS'" ) );
+  }
+  PQsetNoticeProcessor( mConn, noticeProcessor, nullptr );
+}
+
 void QgsPostgresConn::unref()
 {
   if ( --mRef > 0 )
@@ -1012,6 +1055,8 @@ QString QgsPostgresConn::quotedValue( const QVariant &value )
 
 PGresult *QgsPostgresConn::PQexec( const QString &query, bool logError )
 {
+  reconnectInChild();
+
   if ( PQstatus() != CONNECTION_OK )
   {
     if ( logError )
@@ -1159,11 +1204,14 @@ PGresult *QgsPostgresConn::PQgetResult()
 
 PGresult *QgsPostgresConn::PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes )
 {
+  reconnectInChild();
   return ::PQprepare( mConn, stmtName.toUtf8(), query.toUtf8(), nParams, paramTypes );
 }
 
 PGresult *QgsPostgresConn::PQexecPrepared( const QString &stmtName, const QStringList &params )
 {
+  reconnectInChild();
+
   const char **param = new const char *[ params.size()];
   QList<QByteArray> qparam;
 
@@ -1188,8 +1236,7 @@ PGresult *QgsPostgresConn::PQexecPrepared( const QString &stmtName, const QStrin
 void QgsPostgresConn::PQfinish()
 {
   Q_ASSERT( mConn );
-  ::PQfinish( mConn );
-  mConn = nullptr;
+  finishConnection();
 }
 
 int QgsPostgresConn::PQstatus()
@@ -1204,9 +1251,22 @@ QString QgsPostgresConn::PQerrorMessage()
   return QString::fromUtf8( ::PQerrorMessage( mConn ) );
 }
 
+int QgsPostgresConn::PQputCopyData( const QByteArray &buffer )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyData( mConn, buffer.constData(), buffer.size() );
+}
+
+int QgsPostgresConn::PQputCopyEnd( const QString &errorMessage )
+{
+  Q_ASSERT( mConn );
+  return ::PQputCopyEnd( mConn, errorMessage.isNull() ? nullptr : errorMessage.toUtf8().constData() );
+}
+
 int QgsPostgresConn::PQsendQuery( const QString &query )
 {
   Q_ASSERT( mConn );
+  reconnectInChild();
   return ::PQsendQuery( mConn, query.toUtf8() );
 }
 
@@ -1331,6 +1391,35 @@ qint64 QgsPostgresConn::getBinaryInt( QgsPostgresResult &queryResult, int row, i
   return oid;
 }
 
+double QgsPostgresConn::getBinaryDouble( QgsPostgresResult &queryResult, int row, int col )
+{
+  const char *p = ::PQgetvalue( queryResult.result(), row, col );
+  int s = ::PQgetlength( queryResult.result(), row, col );
+
+  if ( s != 8 )
+  {
+    QgsDebugMsg( QString( "unexpected size %1" ).arg( s ) );
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  quint64 bits;
+  if ( mSwapEndian )
+  {
+    quint32 high, low;
+    memcpy( &high, p, sizeof( high ) );
+    memcpy( &low, p + sizeof( high ), sizeof( low ) );
+    bits = ( static_cast< quint64 >( ntohl( high ) ) << 32 ) | ntohl( low );
+  }
+  else
+  {
+    memcpy( &bits, p, sizeof( bits ) );
+  }
+
+  double d;
+  memcpy( &d, &bits, sizeof( d ) );
+  return d;
+}
+
 QString QgsPostgresConn::fieldExpression( const QgsField &fld, QString expr )
 {
   const QString &type = fld.typeName();
@@ -1838,6 +1927,9 @@ void QgsPostgresConn::deleteConnection( const QString &connName )
 
 bool QgsPostgresConn::cancel()
 {
+  // never cancel the queries of the parent process
+  reconnectInChild();
+
   PGcancel *c = ::PQgetCancel( mConn );
   if ( !c )
   {
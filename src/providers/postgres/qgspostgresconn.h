@@ -252,6 +252,8 @@ class QgsPostgresConn : public QObject
     PGresult *PQgetResult();
     PGresult *PQprepare( const QString &stmtName, const QString &query, int nParams, const Oid *paramTypes );
     PGresult *PQexecPrepared( const QString &stmtName, const QStringList &params );
+    int PQputCopyData( const QByteArray &buffer );
+    int PQputCopyEnd( const QString &errorMessage = QString() );
 
     bool begin();
     bool commit();
@@ -306,6 +308,9 @@ class QgsPostgresConn : public QObject
 
     qint64 getBinaryInt( QgsPostgresResult &queryResult, int row, int col );
 
+    //! Returns a float8 value of a binary cursor
+    double getBinaryDouble( QgsPostgresResult &queryResult, int row, int col );
+
     QString fieldExpression( const QgsField &fld, QString expr = "%1" );
 
     QString connInfo() const { return mConnInfo; }
@@ -343,9 +348,22 @@ class QgsPostgresConn : public QObject
     QgsPostgresConn( const QString &conninfo, bool readOnly, bool shared, bool transaction );
     ~QgsPostgresConn();
 
+    /**
+     * Replaces a connection inherited from the parent process by a new one when
+     * used for the first time in a forked child process, e.g. a QGIS server worker.
+     * The inherited connection is dropped without ending its session, which is
+     * still used by the parent.
+     */
+    void reconnectInChild();
+
+    //! Closes the connection, without ending the session if it was inherited from the parent process
+    void finishConnection();
+
     int mRef;
     int mOpenCursors;
     PGconn *mConn = nullptr;
+    //! Process which opened mConn
+    qint64 mPid = 0;
     QString mConnInfo;
 
     //! GEOS capability
@@ -12,6 +12,7 @@
  *   (at your option) any later version.                                   *
  *                                                                         *
  ***************************************************************************/
+#include "qgsfeaturebatch.h"
 #include "qgsgeometry.h"
 #include "qgspostgresconnpool.h"
 #include "qgspostgresexpressioncompiler.h"
@@ -26,6 +27,9 @@
 #include <QElapsedTimer>
 #include <QObject>
 
+#include <algorithm>
+#include <cstdlib>
+
 QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource *source, bool ownSource, const QgsFeatureRequest &request )
   : QgsAbstractFeatureIteratorFromSource<QgsPostgresFeatureSource>( source, ownSource, request )
   , mFeatureQueueSize( 1 )
@@ -47,6 +51,10 @@ QgsPostgresFeatureIterator::QgsPostgresFeatureIterator( QgsPostgresFeatureSource
     mIsTransactionConnection = true;
   }
 
+  // a fetch sent in advance keeps the connection busy, so the connection must not be shared.
+  // Requests of single features do not need it either.
+  mPrefetch = !mIsTransactionConnection && mRequest.filterType() != QgsFeatureRequest::FilterFid;
+
   if ( !mConn )
   {
     mClosed = true;
@@ -252,34 +260,13 @@ bool QgsPostgresFeatureIterator::fetchFeature( QgsFeature &feature )
     QElapsedTimer timer;
     timer.start();
 
-    QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( mFeatureQueueSize ).arg( mCursorName );
     QgsDebugMsgLevel( QString( "fetching %1 features." ).arg( mFeatureQueueSize ), 4 );
 
     lock();
-    if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
-    {
-      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-    }
-
     QgsPostgresResult queryResult;
-    for ( ;; )
+    if ( fetchRows( mFeatureQueueSize, queryResult ) )
     {
-      queryResult = mConn->PQgetResult();
-      if ( !queryResult.result() )
-        break;
-
-      if ( queryResult.PQresultStatus() != PGRES_TUPLES_OK )
-      {
-        QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
-        break;
-      }
-
       int rows = queryResult.PQntuples();
-      if ( rows == 0 )
-        continue;
-
-      mLastFetch = rows < mFeatureQueueSize;
-
       for ( int row = 0; row < rows; row++ )
       {
         mFeatureQueue.enqueue( QgsFeature() );
@@ -326,6 +313,153 @@ bool QgsPostgresFeatureIterator::nextFeatureFilterExpression( QgsFeature &f )
     return fetchFeature( f );
 }
 
+int QgsPostgresFeatureIterator::fetchBatch( QgsFeatureBatch &batch, int maxFeatures )
+{
+  // geometries need to be transformed feature by feature
+  if ( mTransform.isValid() )
+    return QgsAbstractFeatureIterator::fetchBatch( batch, maxFeatures );
+
+  if ( mClosed )
+    return 0;
+
+  int count = 0;
+
+  // features already queued by fetchFeature() go first
+  while ( count < maxFeatures && !mFeatureQueue.empty() )
+  {
+    batch.appendFeature( mFeatureQueue.dequeue() );
+    mFetched++;
+    count++;
+  }
+
+  // then the rows are parsed straight into the batch, without creating features
+  while ( count < maxFeatures && !mLastFetch )
+  {
+    int fetchSize = maxFeatures - count;
+    QgsDebugMsgLevel( QString( "fetching %1 features into batch." ).arg( fetchSize ), 4 );
+
+    lock();
+    QgsPostgresResult queryResult;
+    if ( !fetchRows( fetchSize, queryResult, maxFeatures ) || !queryResult.result() )
+    {
+      unlock();
+      QgsDebugMsg( QString( "Fetch failed after %1 features" ).arg( mFetched ) );
+      close();
+      return count;
+    }
+
+    // rows fetched in advance may be more than the batch can take, they are queued for the next call
+    int rows = queryResult.PQntuples();
+    int batchRows = std::min( rows, fetchSize );
+    for ( int row = 0; row < batchRows; row++ )
+    {
+      getBatchRow( queryResult, row, batch );
+    }
+    for ( int row = batchRows; row < rows; row++ )
+    {
+      mFeatureQueue.enqueue( QgsFeature() );
+      getFeature( queryResult, row, mFeatureQueue.back() );
+    }
+    unlock();
+
+    mFetched += batchRows;
+    count += batchRows;
+  }
+
+  if ( count < maxFeatures && mFeatureQueue.empty() )
+  {
+    QgsDebugMsg( QString( "Finished after %1 features" ).arg( mFetched ) );
+    close();
+
+    mSource->mShared->ensureFeaturesCountedAtLeast( mFetched );
+  }
+
+  return count;
+}
+
+bool QgsPostgresFeatureIterator::sendFetch( int rows )
+{
+  QString fetch = QStringLiteral( "FETCH FORWARD %1 FROM %2" ).arg( rows ).arg( mCursorName );
+  if ( mConn->PQsendQuery( fetch ) == 0 ) // fetch features asynchronously
+  {
+    QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+    return false;
+  }
+
+  mPendingFetchRows = rows;
+  return true;
+}
+
+bool QgsPostgresFeatureIterator::fetchRows( int rows, QgsPostgresResult &queryResult, int nextRows )
+{
+  // the rows may have been requested in advance, possibly a different number of them
+  if ( mPendingFetchRows == 0 && !sendFetch( rows ) )
+    return false;
+
+  int requestedRows = mPendingFetchRows;
+  mPendingFetchRows = 0;
+  mFetchCount++;
+
+  bool success = true;
+  for ( ;; )
+  {
+    PGresult *result = mConn->PQgetResult();
+    if ( !result )
+      break;
+
+    if ( ::PQresultStatus( result ) != PGRES_TUPLES_OK )
+    {
+      QgsMessageLog::logMessage( QObject::tr( "Fetching from cursor %1 failed\nDatabase error: %2" ).arg( mCursorName, mConn->PQerrorMessage() ), QObject::tr( "PostGIS" ) );
+      ::PQclear( result );
+      success = false;
+      continue;
+    }
+
+    // a FETCH returns a single set of rows
+    queryResult = result;
+  }
+
+  mLastFetch = !success || queryResult.PQntuples() < requestedRows;
+
+  // request the next rows before the caller parses these ones, so that the server and the
+  // network work meanwhile. Not done for the first fetch, as many requests are satisfied by it.
+  if ( mPrefetch && !mLastFetch && mFetchCount > 1 )
+    sendFetch( nextRows > 0 ? nextRows : rows );
+
+  return success;
+}
+
+void QgsPostgresFeatureIterator::discardPrefetch()
+{
+  if ( mPendingFetchRows == 0 )
+    return;
+
+  while ( PGresult *result = mConn->PQgetResult() )
+    ::PQclear( result );
+  mPendingFetchRows = 0;
+}
+
+bool QgsPostgresFeatureIterator::binaryAttribute( const QgsField &field ) const
+{
+  switch ( field.type() )
+  {
+    case QVariant::Int:
+    case QVariant::LongLong:
+      return field.typeName() == QLatin1String( "int2" ) ||
+             field.typeName() == QLatin1String( "int4" ) ||
+             field.typeName() == QLatin1String( "int8" );
+
+    // float4 values are kept as text, the binary single precision value is not the one shown by PostgreSQL.
+    // float8 values are shown with all the digits needed to read them back exactly since PostgreSQL 12,
+    // older servers round them to 15 significant digits unless extra_float_digits is set.
+    case QVariant::Double:
+      return field.typeName() == QLatin1String( "float8" ) && mConn->pgVersion() >= 120000;
+
+    default:
+      return false;
+  }
+}
+
 bool QgsPostgresFeatureIterator::prepareSimplification( const QgsSimplifyMethod &simplifyMethod )
 {
   // setup simplification of geometries to fetch
@@ -379,10 +513,12 @@ bool QgsPostgresFeatureIterator::rewind()
   // move cursor to first record
 
   lock();
+  discardPrefetch();
   mConn->PQexecNR( QStringLiteral( "move absolute 0 in %1" ).arg( mCursorName ) );
   unlock();
   mFeatureQueue.clear();
   mFetched = 0;
+  mFetchCount = 0;
   mLastFetch = false;
 
   return true;
@@ -394,6 +530,7 @@ bool QgsPostgresFeatureIterator::close()
     return false;
 
   lock();
+  discardPrefetch();
   mConn->closeCursor( mCursorName );
   unlock();
 
@@ -640,7 +777,9 @@ bool QgsPostgresFeatureIterator::declareCursor( const QString &whereClause, long
     if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
       continue;
 
-    query += delim + mConn->fieldExpression( mSource->mFields.at( idx ) );
+    // numbers are fetched in the binary format of the cursor rather than converted to text
+    const QgsField &fld = mSource->mFields.at( idx );
+    query += delim + ( binaryAttribute( fld ) ? QgsPostgresConn::quotedIdentifier( fld.name() ) : mConn->fieldExpression( fld ) );
   }
 
   query += " FROM " + mSource->mQuery;
@@ -686,45 +825,7 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
       memcpy( featureGeom, PQgetvalue( queryResult.result(), row, col ), returnedLength );
       memset( featureGeom + returnedLength, 0, 1 );
 
-      unsigned int wkbType;
-      memcpy( &wkbType, featureGeom + 1, sizeof( wkbType ) );
-      QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
-
-      if ( ( unsigned int )newType != wkbType )
-      {
-        // overwrite type
-        unsigned int n = newType;
-        memcpy( featureGeom + 1, &n, sizeof( n ) );
-      }
-
-      // PostGIS stores TIN as a collection of Triangles.
-      // Since Triangles are not supported, they have to be converted to Polygons
-      const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
-      if ( wkbType % 1000 == 16 )
-      {
-        unsigned int numGeoms;
-        memcpy( &numGeoms, featureGeom + 5, sizeof( unsigned int ) );
-        unsigned char *wkb = featureGeom + 9;
-        for ( unsigned int i = 0; i < numGeoms; ++i )
-        {
-          const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
-          memcpy( wkb + 1, &localType, sizeof( localType ) );
-
-          // skip endian and type info
-          wkb += sizeof( unsigned int ) + 1;
-
-          // skip coordinates
-          unsigned int nRings;
-          memcpy( &nRings, wkb, sizeof( int ) );
-          wkb += sizeof( int );
-          for ( unsigned int j = 0; j < nRings; ++j )
-          {
-            unsigned int nPoints;
-            memcpy( &nPoints, wkb, sizeof( int ) );
-            wkb += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
-          }
-        }
-      }
+      fixupWkb( featureGeom );
 
       QgsGeometry g;
       g.fromWkb( featureGeom, returnedLength + 1 );
@@ -811,19 +912,221 @@ bool QgsPostgresFeatureIterator::getFeature( QgsPostgresResult &queryResult, int
   return true;
 }
 
+void QgsPostgresFeatureIterator::fixupWkb( unsigned char *wkb )
+{
+  unsigned int wkbType;
+  memcpy( &wkbType, wkb + 1, sizeof( wkbType ) );
+  QgsWkbTypes::Type newType = QgsPostgresConn::wkbTypeFromOgcWkbType( wkbType );
+
+  if ( ( unsigned int )newType != wkbType )
+  {
+    // overwrite type
+    unsigned int n = newType;
+    memcpy( wkb + 1, &n, sizeof( n ) );
+  }
+
+  // PostGIS stores TIN as a collection of Triangles.
+  // Since Triangles are not supported, they have to be converted to Polygons
+  const int nDims = 2 + ( QgsWkbTypes::hasZ( newType ) ? 1 : 0 ) + ( QgsWkbTypes::hasM( newType ) ? 1 : 0 );
+  if ( wkbType % 1000 == 16 )
+  {
+    unsigned int numGeoms;
+    memcpy( &numGeoms, wkb + 5, sizeof( unsigned int ) );
+    unsigned char *p = wkb + 9;
+    for ( unsigned int i = 0; i < numGeoms; ++i )
+    {
+      const unsigned int localType = QgsWkbTypes::singleType( newType ); // polygon(Z|M)
+      memcpy( p + 1, &localType, sizeof( localType ) );
+
+      // skip endian and type info
+      p += sizeof( unsigned int ) + 1;
+
+      // skip coordinates
+      unsigned int nRings;
+      memcpy( &nRings, p, sizeof( int ) );
+      p += sizeof( int );
+      for ( unsigned int j = 0; j < nRings; ++j )
+      {
+        unsigned int nPoints;
+        memcpy( &nPoints, p, sizeof( int ) );
+        p += sizeof( nPoints ) + sizeof( double ) * nDims * nPoints;
+      }
+    }
+  }
+}
+
 void QgsPostgresFeatureIterator::getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature )
 {
   if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
     return;
 
   const QgsField fld = mSource->mFields.at( idx );
-  QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  QVariant v;
+  if ( !binaryAttribute( fld ) )
+    v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+  else if ( queryResult.PQgetisnull( row, col ) )
+    v = QVariant( fld.type() );
+  else if ( fld.type() == QVariant::Double )
+    v = mConn->getBinaryDouble( queryResult, row, col );
+  else if ( fld.type() == QVariant::Int )
+    v = static_cast< int >( mConn->getBinaryInt( queryResult, row, col ) );
+  else
+    v = mConn->getBinaryInt( queryResult, row, col );
   feature.setAttribute( idx, v );
 
   col++;
 }
 
 
+void QgsPostgresFeatureIterator::getBatchRow( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch )
+{
+  PGresult *result = queryResult.result();
+  int col = 0;
+  int geomCol = -1;
+
+  if ( mFetchGeometry )
+    geomCol = col++;
+
+  QgsFeatureId fid = 0;
+  QVector< QPair< int, QVariant > > pkValues;
+
+  switch ( mSource->mPrimaryKeyType )
+  {
+    case PktOid:
+    case PktTid:
+      fid = mConn->getBinaryInt( queryResult, row, col++ );
+      break;
+
+    case PktInt:
+    case PktUint64:
+      fid = mConn->getBinaryInt( queryResult, row, col++ );
+      pkValues << qMakePair( mSource->mPrimaryKeyAttrs.at( 0 ), QVariant( fid ) );
+      if ( mSource->mPrimaryKeyType == PktInt )
+        fid = QgsPostgresUtils::int32pk_to_fid( fid );
+      break;
+
+    case PktFidMap:
+    {
+      QVariantList primaryKeyVals;
+
+      Q_FOREACH ( int idx, mSource->mPrimaryKeyAttrs )
+      {
+        QgsField fld = mSource->mFields.at( idx );
+
+        QVariant v = QgsPostgresProvider::convertValue( fld.type(), fld.subType(), queryResult.PQgetvalue( row, col ) );
+        primaryKeyVals << v;
+        pkValues << qMakePair( idx, v );
+
+        col++;
+      }
+
+      fid = mSource->mShared->lookupFid( primaryKeyVals );
+    }
+    break;
+
+    case PktUnknown:
+      Q_ASSERT( !"FAILURE: cannot get feature with unknown primary key" );
+      return;
+  }
+
+  batch.addRow( fid );
+
+  for ( int i = 0; i < pkValues.count(); ++i )
+  {
+    int column = batch.columnForField( pkValues.at( i ).first );
+    if ( column >= 0 )
+      batch.setValue( column, pkValues.at( i ).second );
+  }
+
+  // the attribute columns follow in the order they were selected by declareCursor()
+  QgsAttributeList fetchAttributes = mRequest.flags() & QgsFeatureRequest::SubsetOfAttributes ? mRequest.subsetOfAttributes() : mSource->mFields.allAttributesList();
+  Q_FOREACH ( int idx, fetchAttributes )
+  {
+    if ( mSource->mPrimaryKeyAttrs.contains( idx ) )
+      continue;
+
+    int currentCol = col++;
+    int column = batch.columnForField( idx );
+    if ( column < 0 || ::PQgetisnull( result, row, currentCol ) )
+      continue;
+
+    const char *value = ::PQgetvalue( result, row, currentCol );
+    int length = ::PQgetlength( result, row, currentCol );
+    const QgsField &fld = mSource->mFields.at( idx );
+
+    if ( binaryAttribute( fld ) )
+    {
+      bool isDouble = fld.type() == QVariant::Double;
+      switch ( batch.columnType( column ) )
+      {
+        case QgsFeatureBatch::Double:
+          batch.setDouble( column, isDouble ? mConn->getBinaryDouble( queryResult, row, currentCol ) : mConn->getBinaryInt( queryResult, row, currentCol ) );
+          break;
+
+        case QgsFeatureBatch::Int64:
+          if ( !isDouble )
+            batch.setInt64( column, mConn->getBinaryInt( queryResult, row, currentCol ) );
+          break;
+
+        case QgsFeatureBatch::String:
+        case QgsFeatureBatch::Variant:
+          batch.setValue( column, isDouble ? QVariant( mConn->getBinaryDouble( queryResult, row, currentCol ) ) : QVariant( mConn->getBinaryInt( queryResult, row, currentCol ) ) );
+          break;
+      }
+      continue;
+    }
+
+    switch ( batch.columnType( column ) )
+    {
+      case QgsFeatureBatch::Double:
+      {
+        char *end = nullptr;
+        double d = strtod( value, &end );
+        if ( end == value + length )
+          batch.setDouble( column, d );
+        break;
+      }
+
+      case QgsFeatureBatch::Int64:
+      {
+        if ( fld.type() == QVariant::Bool )
+        {
+          if ( length == 1 && ( value[0] == 't' || value[0] == 'f' ) )
+            batch.setInt64( column, value[0] == 't' ? 1 : 0 );
+          break;
+        }
+
+        char *end = nullptr;
+        qint64 v = strtoll( value, &end, 10 );
+        if ( end == value + length )
+          batch.setInt64( column, v );
+        break;
+      }
+
+      case QgsFeatureBatch::String:
+        // the connection uses UTF-8 client encoding
+        batch.setString( column, value, length );
+        break;
+
+      case QgsFeatureBatch::Variant:
+        batch.setValue( column, QgsPostgresProvider::convertValue( fld.type(), fld.subType(), QString::fromUtf8( value, length ) ) );
+        break;
+    }
+  }
+
+  if ( geomCol >= 0 && batch.fetchGeometry() )
+  {
+    int returnedLength = ::PQgetlength( result, row, geomCol );
+    if ( returnedLength > 0 )
+    {
+      unsigned char *wkb = batch.allocateWkb( returnedLength );
+      memcpy( wkb, ::PQgetvalue( result, row, geomCol ), returnedLength );
+      fixupWkb( wkb );
+    }
+  }
+}
+
+
 //  ------------------
 
 QgsPostgresFeatureSource::QgsPostgresFeatureSource( const QgsPostgresProvider *p )
@@ -82,6 +82,7 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
   protected:
     virtual bool fetchFeature( QgsFeature &feature ) override;
     bool nextFeatureFilterExpression( QgsFeature &f ) override;
+    virtual int fetchBatch( QgsFeatureBatch &batch, int maxFeatures ) override;
     virtual bool prepareSimplification( const QgsSimplifyMethod &simplifyMethod ) override;
 
   private:
@@ -92,6 +93,26 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     QString whereClauseRect();
     bool getFeature( QgsPostgresResult &queryResult, int row, QgsFeature &feature );
     void getFeatureAttribute( int idx, QgsPostgresResult &queryResult, int row, int &col, QgsFeature &feature );
+    //! Appends a row of the result to the batch, parsing values straight into the batch columns
+    void getBatchRow( QgsPostgresResult &queryResult, int row, QgsFeatureBatch &batch );
+    //! Rewrites WKB returned by PostGIS in place to types supported by QGIS
+    static void fixupWkb( unsigned char *wkb );
+
+    /**
+     * Fetches the next \a rows from the cursor into \a queryResult (or the rows requested in advance).
+     * When prefetching, the following \a nextRows (or \a rows) are requested before returning.
+     * \returns false if the fetch failed
+     */
+    bool fetchRows( int rows, QgsPostgresResult &queryResult, int nextRows = 0 );
+    //! Sends a query fetching rows from the cursor, without waiting for the result
+    bool sendFetch( int rows );
+    //! Discards the rows requested in advance, so that the connection can be used for other queries
+    void discardPrefetch();
+    /**
+     * Returns true if the values of a field are fetched in the binary format of the cursor rather than as text.
+     * Only the types whose binary value is the one PostgreSQL shows as text are fetched in the binary format.
+     */
+    bool binaryAttribute( const QgsField &field ) const;
     bool declareCursor( const QString &whereClause, long limit = -1, bool closeOnFail = true, const QString &orderBy = QString() );
 
     QString mCursorName;
@@ -108,6 +129,15 @@ class QgsPostgresFeatureIterator : public QgsAbstractFeatureIteratorFromSource<Q
     //! Number of retrieved features
     int mFetched;
 
+    //! Whether the next rows are requested while the current ones are parsed
+    bool mPrefetch = false;
+
+    //! Number of rows requested in advance and not received yet, 0 if there is no pending fetch
+    int mPendingFetchRows = 0;
+
+    //! Number of fetches from the cursor
+    int mFetchCount = 0;
+
     //! Set to true, if geometry is in the requested columns
     bool mFetchGeometry;
 
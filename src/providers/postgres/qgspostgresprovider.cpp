@@ -46,6 +46,11 @@ const QString POSTGRES_KEY = QStringLiteral( "postgres" );
 const QString POSTGRES_DESCRIPTION = QStringLiteral( "PostgreSQL/PostGIS data provider" );
 static const QString EDITOR_WIDGET_STYLES_TABLE = QStringLiteral( "qgis_editor_widget_styles" );
 
+//! Minimum number of features added with a COPY statement rather than INSERT statements
+static const int COPY_MIN_FEATURES = 10;
+//! Size of the chunks of data sent to the server during a COPY
+static const int COPY_BUFFER_SIZE = 1024 * 1024;
+
 inline qint64 PKINT2FID( qint32 x )
 {
   return QgsPostgresUtils::int32pk_to_fid( x );
@@ -1959,6 +1964,15 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   {
     conn->begin();
 
+    // without the ids of the new features to return, large batches are copied rather than inserted
+    if ( ( flags & QgsFeatureSink::FastInsert ) && flist.size() >= COPY_MIN_FEATURES && copyFeatures( conn, flist ) )
+    {
+      returnvalue &= conn->commit();
+      mShared->addFeaturesCounted( flist.size() );
+      conn->unlock();
+      return returnvalue;
+    }
+
     // Prepare the INSERT statement
     QString insert = QStringLiteral( "INSERT INTO %1(" ).arg( mQuery );
     QString values = QStringLiteral( ") VALUES (" );
@@ -2217,6 +2231,181 @@ bool QgsPostgresProvider::addFeatures( QgsFeatureList &flist, Flags flags )
   return returnvalue;
 }
 
+//! Appends a value to a row of a COPY statement in text format
+static void appendCopyValue( QByteArray &row, const QByteArray &value )
+{
+  for ( const char c : value )
+  {
+    switch ( c )
+    {
+      case '\\':
+        row.append( "\\\\" );
+        break;
+      case '\t':
+        row.append( "\\t" );
+        break;
+      case '\n':
+        row.append( "\\n" );
+        break;
+      case '\r':
+        row.append( "\\r" );
+        break;
+      default:
+        row.append( c );
+    }
+  }
+}
+
+bool QgsPostgresProvider::copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist )
+{
+  if ( mSpatialColType == SctTopoGeometry )
+    return false;
+
+  // The columns which the INSERT statements fill with their default are left out, so that the
+  // default is evaluated for each row: those where all the features have the default value,
+  // and the primary key when it is NULL. Other NULL values are copied as NULL.
+  // The values are converted to text as when they are passed as parameters of INSERT statements.
+  QStringList columns;
+  QList<int> fieldIds;
+  for ( int idx = 0; idx < mAttributeFields.count(); ++idx )
+  {
+    const QgsField &fld = mAttributeFields.at( idx );
+    if ( fld.name().isEmpty() || fld.name() == mGeometryColumn )
+      continue;
+
+    QString defVal = defaultValueClause( idx );
+    int defaults = 0;
+    int nulls = 0;
+    for ( const QgsFeature &feature : flist )
+    {
+      QVariant v = feature.attribute( idx );
+      if ( v.isNull() )
+        nulls++;
+      else if ( !defVal.isNull() && v.toString() == defVal )
+        defaults++;
+    }
+
+    if ( !defVal.isNull() )
+    {
+      if ( defaults + nulls == flist.size() && ( defaults > 0 || mPrimaryKeyAttrs.contains( idx ) ) )
+        continue;
+
+      // INSERT statements evaluate the default for the NULL values of a column unless they are all NULL,
+      // default values of a part of the features need to be evaluated for each feature
+      if ( defaults > 0 || ( nulls > 0 && nulls < flist.size() ) )
+        return false;
+    }
+
+    // arrays and hstore are quoted by INSERT statements
+    if ( fld.type() == QVariant::Map || fld.type() == QVariant::List || fld.type() == QVariant::StringList )
+      return false;
+
+    columns << quotedIdentifier( fld.name() );
+    fieldIds << idx;
+  }
+
+  if ( !mGeometryColumn.isNull() )
+    columns.prepend( quotedIdentifier( mGeometryColumn ) );
+
+  if ( columns.isEmpty() )
+    return false;
+
+  QString copy = QStringLiteral( "COPY %1(%2) FROM STDIN" ).arg( mQuery, columns.join( ',' ) );
+  QgsDebugMsg( QString( "copy features: %1" ).arg( copy ) );
+
+  QgsPostgresResult result( conn->PQexec( copy, false ) );
+  if ( result.PQresultStatus() != PGRES_COPY_IN )
+    throw PGException( result );
+
+  QString srid = mRequestedSrid.isEmpty() ? mDetectedSrid : mRequestedSrid;
+  bool forceMulti = QgsWkbTypes::isMultiType( wkbType() );
+
+  QByteArray buffer;
+  bool sent = true;
+  for ( const QgsFeature &feature : flist )
+  {
+    if ( !mGeometryColumn.isNull() )
+    {
+      QgsGeometry geom = feature.geometry();
+      if ( geom.isNull() )
+      {
+        buffer.append( "\\N" );
+      }
+      else
+      {
+        QgsGeometry convertedGeom( convertToProviderType( geom ) );
+        if ( !convertedGeom.isNull() )
+          geom = convertedGeom;
+        if ( forceMulti )
+          geom.convertToMultiType();
+
+        // hex EWKB, i.e. WKB with the SRID after the type
+        QByteArray wkb = geom.exportToWkb();
+        if ( !srid.isEmpty() && wkb.size() >= 5 )
+        {
+          quint32 type;
+          memcpy( &type, wkb.constData() + 1, sizeof( type ) );
+          type |= 0x20000000;
+          qint32 sridValue = srid.toInt();
+
+          QByteArray ewkb;
+          ewkb.reserve( wkb.size() + 4 );
+          ewkb.append( wkb.constData(), 1 );
+          ewkb.append( reinterpret_cast< const char * >( &type ), sizeof( type ) );
+          ewkb.append( reinterpret_cast< const char * >( &sridValue ), sizeof( sridValue ) );
+          ewkb.append( wkb.constData() + 5, wkb.size() - 5 );
+          wkb = ewkb;
+        }
+        buffer.append( wkb.toHex() );
+      }
+    }
+
+    for ( int i = 0; i < fieldIds.size(); ++i )
+    {
+      if ( i > 0 || !mGeometryColumn.isNull() )
+        buffer.append( '\t' );
+
+      QVariant v = feature.attribute( fieldIds.at( i ) );
+      if ( v.isNull() )
+        buffer.append( "\\N" );
+      else
+        appendCopyValue( buffer, v.toString().toUtf8() );
+    }
+    buffer.append( '\n' );
+
+    if ( buffer.size() >= COPY_BUFFER_SIZE )
+    {
+      sent = conn->PQputCopyData( buffer ) == 1;
+      buffer.clear();
+      if ( !sent )
+        break;
+    }
+  }
+
+  if ( sent && !buffer.isEmpty() )
+    sent = conn->PQputCopyData( buffer ) == 1;
+
+  conn->PQputCopyEnd( sent ? QString() : tr( "Sending the features failed" ) );
+
+  // keep the first error
+  bool success = true;
+  while ( PGresult *copyResult = conn->PQgetResult() )
+  {
+    if ( !success )
+    {
+      ::PQclear( copyResult );
+      continue;
+    }
+
+    result = copyResult;
+    success = result.PQresultStatus() == PGRES_COMMAND_OK;
+  }
+  if ( !success || !sent )
+    throw PGException( result );
+
+  return true;
+}
+
 bool QgsPostgresProvider::deleteFeatures( const QgsFeatureIds &id )
 {
   bool returnvalue = true;
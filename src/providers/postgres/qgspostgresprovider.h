@@ -385,6 +385,15 @@ class QgsPostgresProvider : public QgsVectorDataProvider
     QgsVectorDataProvider::Capabilities mEnabledCapabilities;
 
     void appendGeomParam( const QgsGeometry &geom, QStringList &param ) const;
+
+    /**
+     * Adds the features with a COPY statement, which is much faster than INSERT statements
+     * for large numbers of features but does not return the ids of the new features.
+     * \returns false if the features cannot be copied (e.g. default values to evaluate for
+     * some features only), in which case nothing is done
+     * \throws PGException on database errors
+     */
+    bool copyFeatures( QgsPostgresConn *conn, const QgsFeatureList &flist );
     void appendPkParams( QgsFeatureId fid, QStringList &param ) const;
 
     QString paramValue( const QString &fieldvalue, const QString &defaultValue ) const;
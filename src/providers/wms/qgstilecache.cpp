@@ -19,39 +19,93 @@
 #include "qgsapplication.h"
 #include <QAbstractNetworkCache>
 #include <QImage>
+#include <QtConcurrentMap>
 
-QCache<QUrl, QImage> QgsTileCache::sTileCache( 256 );
+#include <algorithm>
+
+// 64 MB, i.e. 256 tiles of 256x256 pixels
+QCache<QUrl, QImage> QgsTileCache::sTileCache( 64 * 1024 );
 QMutex QgsTileCache::sTileCacheMutex;
+QThreadPool QgsTileCache::sDecodeThreadPool;
 
 
 void QgsTileCache::insertTile( const QUrl &url, const QImage &image )
 {
   QMutexLocker locker( &sTileCacheMutex );
-  sTileCache.insert( url, new QImage( image ) );
+  sTileCache.insert( url, new QImage( image ), std::max( 1, image.byteCount() / 1024 ) );
 }
 
 bool QgsTileCache::tile( const QUrl &url, QImage &image )
 {
-  QMutexLocker locker( &sTileCacheMutex );
-  if ( QImage *i = sTileCache.object( url ) )
+  image = tiles( QList<QUrl>() << url ).at( 0 );
+  return !image.isNull();
+}
+
+QList<QImage> QgsTileCache::tiles( const QList<QUrl> &urls )
+{
+  QList<QImage> images;
+  QList<int> missingIndexes;
   {
-    image = *i;
-    return true;
+    QMutexLocker locker( &sTileCacheMutex );
+    for ( int i = 0; i < urls.count(); ++i )
+    {
+      if ( QImage *image = sTileCache.object( urls.at( i ) ) )
+      {
+        images << *image;
+      }
+      else
+      {
+        images << QImage();
+        missingIndexes << i;
+      }
+    }
   }
-  else if ( QgsNetworkAccessManager::instance()->cache()->metaData( url ).isValid() )
+
+  QAbstractNetworkCache *diskCache = QgsNetworkAccessManager::instance()->cache();
+  if ( missingIndexes.isEmpty() || !diskCache )
+    return images;
+
+  // reading from the disk cache is sequential, the decoding is done in parallel
+  QList<int> encodedIndexes;
+  QList<QByteArray> encodedTiles;
+  Q_FOREACH ( int i, missingIndexes )
   {
-    if ( QIODevice *data = QgsNetworkAccessManager::instance()->cache()->data( url ) )
+    if ( !diskCache->metaData( urls.at( i ) ).isValid() )
+      continue;
+
+    if ( QIODevice *data = diskCache->data( urls.at( i ) ) )
     {
-      QByteArray imageData = data->readAll();
+      encodedIndexes << i;
+      encodedTiles << data->readAll();
       delete data;
+    }
+  }
 
-      image = QImage::fromData( imageData );
+  QList<QImage> decodedTiles;
+  if ( encodedTiles.count() == 1 )
+    decodedTiles << decodeTile( encodedTiles.at( 0 ) );
+  else if ( !encodedTiles.isEmpty() )
+    decodedTiles = QtConcurrent::blockingMapped( encodedTiles, &QgsTileCache::decodeTile );
 
-      // cache it as well (mutex is already locked)
-      sTileCache.insert( url, new QImage( image ) );
+  for ( int k = 0; k < encodedIndexes.count(); ++k )
+  {
+    const QImage &image = decodedTiles.at( k );
+    if ( image.isNull() )
+      continue;
 
-      return true;
-    }
+    images[ encodedIndexes.at( k )] = image;
+    insertTile( urls.at( encodedIndexes.at( k ) ), image );
   }
-  return false;
+
+  return images;
+}
+
+QImage QgsTileCache::decodeTile( const QByteArray &data )
+{
+  QImage image = QImage::fromData( data );
+  if ( image.isNull() )
+    return image;
+
+  // convert once rather than each time the tile is painted (e.g. paletted PNG tiles)
+  return image.convertToFormat( image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32 );
 }
@@ -18,8 +18,11 @@
 
 
 #include <QCache>
+#include <QList>
 #include <QMutex>
+#include <QThreadPool>
 
+class QByteArray;
 class QImage;
 class QUrl;
 
@@ -28,6 +31,9 @@ class QUrl;
  * The in-memory cache is there to save CPU time otherwise wasted to read and
  * uncompress data saved on the disk.
  *
+ * Tiles are kept decoded in a format ready for painting, and tiles read
+ * from the disk cache are decoded in parallel (see tiles()).
+ *
  * The class is thread safe (its methods can be called from any thread).
  */
 class QgsTileCache
@@ -41,16 +47,37 @@ class QgsTileCache
     //! \returns true if the tile exists in the cache
     static bool tile( const QUrl &url, QImage &image );
 
-    //! how many tiles are stored in the in-memory cache
+    /**
+     * Looks up the tiles with given URLs. The tiles which are only in the disk cache
+     * are decoded in parallel and added to the in-memory cache.
+     * \returns one image per URL, null for the tiles which are not in the cache
+     */
+    static QList<QImage> tiles( const QList<QUrl> &urls );
+
+    /**
+     * Decodes the encoded data of a tile (e.g. PNG or JPEG) into an image in a format
+     * which is fast to paint. Can be called from worker threads.
+     */
+    static QImage decodeTile( const QByteArray &data );
+
+    /**
+     * Thread pool decoding the tiles received by the download handlers. It is separate from the
+     * global thread pool, whose threads may all be rendering layers and waiting for these decodes.
+     */
+    static QThreadPool *decodeThreadPool() { return &sDecodeThreadPool; }
+
+    //! size of the tiles stored in the in-memory cache (in KB)
     static int totalCost() { return sTileCache.totalCost(); }
-    //! how many tiles can be stored in the in-memory cache
+    //! maximum size of the tiles stored in the in-memory cache (in KB)
     static int maxCost() { return sTileCache.maxCost(); }
 
   private:
-    //! in-memory cache
+    //! in-memory cache, with the size of the images as cost
     static QCache<QUrl, QImage> sTileCache;
     //! mutex to protect the in-memory cache
     static QMutex sTileCacheMutex;
+    //! threads decoding the downloaded tiles
+    static QThreadPool sDecodeThreadPool;
 };
 
 #endif // QGSTILECACHE_H
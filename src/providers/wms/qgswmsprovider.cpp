@@ -62,6 +62,7 @@
 #include <QScriptValueIterator>
 #include <QNetworkDiskCache>
 #include <QTimer>
+#include <QtConcurrentRun>
 
 #include <ogr_api.h>
 
@@ -547,11 +548,17 @@ void QgsWmsProvider::fetchOtherResTiles( QgsTileMode tileMode, const QgsRectangl
       break;
   }
 
-  QList<QRectF> missingRectsToDelete;
+  QList<QUrl> urls;
   Q_FOREACH ( const TileRequest &r, requests )
+    urls << r.url;
+  QList<QImage> cachedImages = QgsTileCache::tiles( urls );
+
+  QList<QRectF> missingRectsToDelete;
+  for ( int i = 0; i < requests.count(); ++i )
   {
-    QImage localImage;
-    if ( ! QgsTileCache::tile( r.url, localImage ) )
+    const TileRequest &r = requests.at( i );
+    const QImage &localImage = cachedImages.at( i );
+    if ( localImage.isNull() )
       continue;
 
     double cr = viewExtent.width() / imageWidth;
@@ -754,10 +761,15 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     QTime t;
     t.start();
     TileRequests requestsFinal;
+    QList<QUrl> urls;
     Q_FOREACH ( const TileRequest &r, requests )
+      urls << r.url;
+    QList<QImage> cachedImages = QgsTileCache::tiles( urls );
+    for ( int i = 0; i < requests.count(); ++i )
     {
-      QImage localImage;
-      if ( QgsTileCache::tile( r.url, localImage ) )
+      const TileRequest &r = requests.at( i );
+      const QImage &localImage = cachedImages.at( i );
+      if ( !localImage.isNull() )
       {
         double cr = viewExtent.width() / image->width();
 
@@ -778,9 +790,11 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
     int t0 = t.elapsed();
 
 
-    // draw other res tiles if preview
+    // draw other res tiles if preview, or as placeholders replaced by the tiles as they arrive
+    // if the partial output is rendered
     QPainter p( image );
-    if ( feedback && feedback->isPreviewOnly() && missing.count() > 0 )
+    bool placeholders = feedback && ( feedback->isPreviewOnly() || feedback->renderPartialOutput() ) && missing.count() > 0;
+    if ( placeholders )
     {
       // some tiles are still missing, so let's see if we have any cached tiles
       // from lower or higher resolution available to give the user a bit of context
@@ -851,7 +865,7 @@ QImage *QgsWmsProvider::draw( QgsRectangle const &viewExtent, int pixelWidth, in
       cmp.center = viewExtent.center();
       std::sort( requestsFinal.begin(), requestsFinal.end(), cmp );
 
-      QgsWmsTiledImageDownloadHandler handler( dataSourceUri(), mSettings.authorization(), mTileReqNo, requestsFinal, image, viewExtent, mSettings.mSmoothPixmapTransform, feedback );
+      QgsWmsTiledImageDownloadHandler handler( dataSourceUri(), mSettings.authorization(), mTileReqNo, requestsFinal, image, viewExtent, mSettings.mSmoothPixmapTransform, feedback, placeholders );
       handler.downloadBlocking();
     }
 
@@ -3703,7 +3717,7 @@ void QgsWmsImageDownloadHandler::canceled()
 // ----------
 
 
-QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int tileReqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback )
+QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int tileReqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback, bool replacePlaceholders )
   : mProviderUri( providerUri )
   , mAuth( auth )
   , mImage( image )
@@ -3711,6 +3725,7 @@ QgsWmsTiledImageDownloadHandler::QgsWmsTiledImageDownloadHandler( const QString
   , mEventLoop( new QEventLoop )
   , mTileReqNo( tileReqNo )
   , mSmoothPixmapTransform( smoothPixmapTransform )
+  , mReplacePlaceholders( replacePlaceholders )
   , mFeedback( feedback )
 {
   if ( feedback )
@@ -3754,6 +3769,7 @@ void QgsWmsTiledImageDownloadHandler::downloadBlocking()
   mEventLoop->exec( QEventLoop::ExcludeUserInputEvents );
 
   Q_ASSERT( mReplies.isEmpty() );
+  Q_ASSERT( mDecodes.isEmpty() );
 }
 
 
@@ -3852,7 +3868,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodes.isEmpty() )
         finish();
 
       return;
@@ -3891,7 +3907,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
       mReplies.removeOne( reply );
       reply->deleteLater();
 
-      if ( mReplies.isEmpty() )
+      if ( mReplies.isEmpty() && mDecodes.isEmpty() )
         finish();
 
       return;
@@ -3900,43 +3916,23 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     // only take results from current request number
     if ( mTileReqNo == tileReqNo )
     {
-      double cr = mViewExtent.width() / mImage->width();
-
-      QRectF dst( ( r.left() - mViewExtent.xMinimum() ) / cr,
-                  ( mViewExtent.yMaximum() - r.bottom() ) / cr,
-                  r.width() / cr,
-                  r.height() / cr );
-
       QgsDebugMsg( QString( "tile reply: length %1" ).arg( reply->bytesAvailable() ) );
 
-      QImage myLocalImage = QImage::fromData( reply->readAll() );
-
-      if ( !myLocalImage.isNull() )
-      {
-        QPainter p( mImage );
-        if ( mSmoothPixmapTransform )
-          p.setRenderHint( QPainter::SmoothPixmapTransform, true );
-        p.drawImage( dst, myLocalImage );
-#if 0
-        myLocalImage.save( QString( "%1/%2-tile-%3.png" ).arg( QDir::tempPath() ).arg( mTileReqNo ).arg( tileNo ) );
-        p.drawRect( dst ); // show tile bounds
-        p.drawText( dst, Qt::AlignCenter, QString( "(%1)\n%2,%3\n%4,%5\n%6x%7" )
-                    .arg( tileNo )
-                    .arg( r.left() ).arg( r.bottom() )
-                    .arg( r.right() ).arg( r.top() )
-                    .arg( r.width() ).arg( r.height() ) );
+      TileDecode decode;
+      decode.url = reply->url();
+      decode.rect = r;
+      decode.contentType = contentType;
+
+#if QT_VERSION >= 0x050400
+      // decode the tile in a worker thread, so that the other replies are handled meanwhile. The
+      // decoding threads are not those of the global pool, which may all be rendering layers.
+      QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>( this );
+      connect( watcher, &QFutureWatcherBase::finished, this, &QgsWmsTiledImageDownloadHandler::tileDecoded );
+      mDecodes.insert( watcher, decode );
+      watcher->setFuture( QtConcurrent::run( QgsTileCache::decodeThreadPool(), &QgsTileCache::decodeTile, reply->readAll() ) );
+#else
+      drawTile( decode, QgsTileCache::decodeTile( reply->readAll() ) );
 #endif
-
-        QgsTileCache::insertTile( reply->url(), myLocalImage );
-
-        if ( mFeedback )
-          mFeedback->onNewData();
-      }
-      else
-      {
-        QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
-                                   .arg( contentType, reply->url().toString() ), tr( "WMS" ) );
-      }
     }
     else
     {
@@ -3946,7 +3942,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodes.isEmpty() )
       finish();
 
   }
@@ -3969,7 +3965,7 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
     mReplies.removeOne( reply );
     reply->deleteLater();
 
-    if ( mReplies.isEmpty() )
+    if ( mReplies.isEmpty() && mDecodes.isEmpty() )
       finish();
   }
 
@@ -3983,6 +3979,49 @@ void QgsWmsTiledImageDownloadHandler::tileReplyFinished()
 #endif
 }
 
+void QgsWmsTiledImageDownloadHandler::tileDecoded()
+{
+  QFutureWatcher<QImage> *watcher = static_cast< QFutureWatcher<QImage> * >( sender() );
+  TileDecode decode = mDecodes.take( watcher );
+  QImage image = watcher->result();
+  watcher->deleteLater();
+
+  drawTile( decode, image );
+
+  if ( mReplies.isEmpty() && mDecodes.isEmpty() )
+    finish();
+}
+
+void QgsWmsTiledImageDownloadHandler::drawTile( const TileDecode &decode, const QImage &myLocalImage )
+{
+  if ( !myLocalImage.isNull() )
+  {
+    double cr = mViewExtent.width() / mImage->width();
+
+    QRectF dst( ( decode.rect.left() - mViewExtent.xMinimum() ) / cr,
+                ( mViewExtent.yMaximum() - decode.rect.bottom() ) / cr,
+                decode.rect.width() / cr,
+                decode.rect.height() / cr );
+
+    QPainter p( mImage );
+    if ( mReplacePlaceholders )
+      p.setCompositionMode( QPainter::CompositionMode_Source );
+    if ( mSmoothPixmapTransform )
+      p.setRenderHint( QPainter::SmoothPixmapTransform, true );
+    p.drawImage( dst, myLocalImage );
+
+    QgsTileCache::insertTile( decode.url, myLocalImage );
+
+    if ( mFeedback )
+      mFeedback->onNewData();
+  }
+  else
+  {
+    QgsMessageLog::logMessage( tr( "Returned image is flawed [Content-Type:%1; URL: %2]" )
+                               .arg( decode.contentType, decode.url.toString() ), tr( "WMS" ) );
+  }
+}
+
 void QgsWmsTiledImageDownloadHandler::canceled()
 {
   QgsDebugMsg( "Caught canceled() signal" );
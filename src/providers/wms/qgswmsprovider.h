@@ -28,6 +28,7 @@
 #include <QString>
 #include <QStringList>
 #include <QDomElement>
+#include <QFutureWatcher>
 #include <QHash>
 #include <QMap>
 #include <QVector>
@@ -498,17 +499,32 @@ class QgsWmsTiledImageDownloadHandler : public QObject
     Q_OBJECT
   public:
 
-    QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int reqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback );
+    /**
+     * Constructor. If \a replacePlaceholders is true, the downloaded tiles replace the content of the
+     * image where they are drawn, e.g. the tiles of other resolutions drawn as placeholders.
+     */
+    QgsWmsTiledImageDownloadHandler( const QString &providerUri, const QgsWmsAuthorization &auth, int reqNo, const QgsWmsProvider::TileRequests &requests, QImage *image, const QgsRectangle &viewExtent, bool smoothPixmapTransform, QgsRasterBlockFeedback *feedback, bool replacePlaceholders = false );
     ~QgsWmsTiledImageDownloadHandler();
 
     void downloadBlocking();
 
   protected slots:
     void tileReplyFinished();
+    //! Draws a tile decoded in a worker thread
+    void tileDecoded();
     void canceled();
 
   protected:
 
+    //! Tile being decoded in a worker thread
+    struct TileDecode
+    {
+      QUrl url;
+      //! Rectangle of the tile in map coordinates
+      QRectF rect;
+      QString contentType;
+    };
+
     /**
      * \brief Relaunch tile request cloning previous request parameters and managing max repeat
      *
@@ -518,6 +534,9 @@ class QgsWmsTiledImageDownloadHandler : public QObject
      */
     void repeatTileRequest( QNetworkRequest const &oldRequest );
 
+    //! Draws a decoded tile into the image, and adds it to the tile cache
+    void drawTile( const TileDecode &decode, const QImage &image );
+
     void finish() { QMetaObject::invokeMethod( mEventLoop, "quit", Qt::QueuedConnection ); }
 
     QString mProviderUri;
@@ -531,10 +550,14 @@ class QgsWmsTiledImageDownloadHandler : public QObject
 
     int mTileReqNo;
     bool mSmoothPixmapTransform;
+    bool mReplacePlaceholders;
 
     //! Running tile requests
     QList<QNetworkReply *> mReplies;
 
+    //! Tiles being decoded
+    QHash<QFutureWatcher<QImage> *, TileDecode> mDecodes;
+
     QgsRasterBlockFeedback *mFeedback = nullptr;
 };
 
@@ -21,6 +21,8 @@
 #include "qgsserver.h"
 #include "qgsfcgiserverresponse.h"
 #include "qgsfcgiserverrequest.h"
+#include "qgsserversettings.h"
+#include "qgsserverworkerpool.h"
 
 #include <fcgi_stdio.h>
 #include <cstdlib>
@@ -44,8 +46,21 @@ int main( int argc, char *argv[] )
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   server.initPython();
 #endif
+
+  // Forks the worker processes, the master only returns on shutdown
+  QgsServerSettings settings;
+  if ( settings.workers() > 0 && !FCGX_IsCGI() )
+  {
+    QgsServerWorkerPool pool( settings.workers(), settings.preloadProjects() );
+    if ( !pool.exec() )
+    {
+      app.exitQgis();
+      return 0;
+    }
+  }
+
   // Starts FCGI loop
-  while ( fcgi_accept() >= 0 )
+  while ( !QgsServerWorkerPool::stopRequested() && fcgi_accept() >= 0 )
   {
     QgsFcgiServerRequest  request;
     QgsFcgiServerResponse response( request.method() );
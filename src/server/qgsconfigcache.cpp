@@ -22,8 +22,12 @@
 #include "qgssldconfigparser.h"
 #include "qgsaccesscontrol.h"
 #include "qgsproject.h"
+#include "qgsmaplayer.h"
+#include "qgsdataprovider.h"
 
 #include <QFile>
+#include <QSocketNotifier>
+#include <QTimer>
 
 QgsConfigCache *QgsConfigCache::instance()
 {
@@ -36,8 +40,9 @@ QgsConfigCache *QgsConfigCache::instance()
 }
 
 QgsConfigCache::QgsConfigCache()
+  : mFileSystemWatcher( new QFileSystemWatcher( this ) )
 {
-  QObject::connect( &mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::removeChangedEntry );
+  QObject::connect( mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::removeChangedEntry );
 }
 
 const QgsProject *QgsConfigCache::project( const QString &path )
@@ -48,12 +53,83 @@ const QgsProject *QgsConfigCache::project( const QString &path )
     if ( prj->read( path ) )
     {
       mProjectCache.insert( path, prj.release() );
+      mFileSystemWatcher->addPath( path );
     }
   }
 
   return mProjectCache[ path ];
 }
 
+bool QgsConfigCache::preload( const QString &path )
+{
+  QgsMessageLog::logMessage( QStringLiteral( "Preload the project file '%1'." ).arg( path ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+
+  if ( !xmlDocument( path ) )
+    return false;
+
+  if ( !project( path ) )
+  {
+    QgsMessageLog::logMessage( "Error, cannot read project file '" + path + "'", QStringLiteral( "Server" ), QgsMessageLog::CRITICAL );
+    return false;
+  }
+  return true;
+}
+
+void QgsConfigCache::reopenDataSources()
+{
+  // providers which hold no file handle nor database connection, or which replace
+  // the connections inherited from the parent process on their first use
+  static const QStringList sForkSafeProviders = QStringList() << QStringLiteral( "postgres" ) << QStringLiteral( "memory" )
+      << QStringLiteral( "wms" ) << QStringLiteral( "wcs" ) << QStringLiteral( "WFS" )
+      << QStringLiteral( "arcgisfeatureserver" ) << QStringLiteral( "arcgismapserver" );
+  // providers which open their files again in reloadData()
+  static const QStringList sReopenedProviders = QStringList() << QStringLiteral( "ogr" ) << QStringLiteral( "gdal" );
+
+  Q_FOREACH ( const QString &path, mProjectCache.keys() )
+  {
+    const QgsProject *prj = mProjectCache.object( path );
+    QList< QgsMapLayer * > reopenedLayers;
+    bool shared = true;
+    Q_FOREACH ( QgsMapLayer *layer, prj->mapLayers() )
+    {
+      QString provider = layer->dataProvider() ? layer->dataProvider()->name() : QString();
+      if ( sReopenedProviders.contains( provider ) )
+        reopenedLayers << layer;
+      else if ( !provider.isEmpty() && !sForkSafeProviders.contains( provider ) )
+        shared = false;
+    }
+
+    if ( shared )
+    {
+      Q_FOREACH ( QgsMapLayer *layer, reopenedLayers )
+        layer->reload();
+    }
+    else
+    {
+      // e.g. SpatiaLite connections cannot be reopened: the project is read again by this process when requested
+      QgsMessageLog::logMessage( QStringLiteral( "The project file '%1' has layers which cannot be shared with the parent process, it will be read again." ).arg( path ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+      removeEntry( path );
+    }
+  }
+}
+
+void QgsConfigCache::detachFileSystemWatcher()
+{
+  // The inotify watches are shared with the parent process: removing them, which
+  // also happens when the watcher is destroyed, would stop the notifications
+  // for the parent too. The old watcher is only silenced and stays owned by the
+  // cache, which lives as long as the process.
+  mFileSystemWatcher->disconnect( this );
+  Q_FOREACH ( QSocketNotifier *notifier, mFileSystemWatcher->findChildren<QSocketNotifier *>() )
+    notifier->setEnabled( false );
+  Q_FOREACH ( QTimer *timer, mFileSystemWatcher->findChildren<QTimer *>() )
+    timer->stop();
+  mDetachedFileSystemWatchers << mFileSystemWatcher;
+
+  mFileSystemWatcher = new QFileSystemWatcher( this );
+  QObject::connect( mFileSystemWatcher, &QFileSystemWatcher::fileChanged, this, &QgsConfigCache::removeChangedEntry );
+}
+
 QgsServerProjectParser *QgsConfigCache::serverConfiguration( const QString &filePath )
 {
   QgsMessageLog::logMessage(
@@ -159,7 +235,7 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
       return nullptr;
     }
     mXmlDocumentCache.insert( filePath, xmlDoc );
-    mFileSystemWatcher.addPath( filePath );
+    mFileSystemWatcher->addPath( filePath );
     xmlDoc = mXmlDocumentCache.object( filePath );
     Q_ASSERT( xmlDoc );
   }
@@ -168,17 +244,19 @@ QDomDocument *QgsConfigCache::xmlDocument( const QString &filePath )
 
 void QgsConfigCache::removeChangedEntry( const QString &path )
 {
-  mWMSConfigCache.remove( path );
-
-  //xml document must be removed last, as other config cache destructors may require it
-  mXmlDocumentCache.remove( path );
-
-  mFileSystemWatcher.removePath( path );
+  removeEntry( path );
+  emit fileChanged( path );
 }
 
 
 void QgsConfigCache::removeEntry( const QString &path )
 {
-  removeChangedEntry( path );
+  mWMSConfigCache.remove( path );
+  mProjectCache.remove( path );
+
+  //xml document must be removed last, as other config cache destructors may require it
+  mXmlDocumentCache.remove( path );
+
+  mFileSystemWatcher->removePath( path );
 }
 
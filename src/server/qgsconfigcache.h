@@ -55,11 +55,53 @@ class SERVER_EXPORT QgsConfigCache : public QObject
      */
     const QgsProject *project( const QString &path );
 
+    /**
+     * Loads the project file \a path and its layers into the cache, so that
+     * worker processes forked afterwards share them.
+     * \returns true if the project could be read
+     * \since QGIS 3.0
+     */
+    bool preload( const QString &path );
+
+    /**
+     * Gives the current process its own file handles and database connections for the
+     * layers of the cached projects. This is needed in a forked worker process, which
+     * must not share them with the process it was forked from.
+     *
+     * The OGR and GDAL layers reopen their files. The PostgreSQL layers connect again
+     * on their first use, and the layers of web services and memory layers hold nothing
+     * to reopen. Projects with layers of other providers, e.g. SpatiaLite, are removed
+     * from the cache and read again when requested.
+     * \since QGIS 3.0
+     */
+    void reopenDataSources();
+
+    /**
+     * Stops watching the files of the cached entries in the current process,
+     * and watches files loaded later with a new file system watcher.
+     * The watches inherited from the process this one was forked from are left
+     * untouched, so that it keeps receiving the change notifications.
+     * \since QGIS 3.0
+     */
+    void detachFileSystemWatcher();
+
+  signals:
+
+    /**
+     * Emitted when the file \a path was modified and its entries were
+     * removed from the cache.
+     * \since QGIS 3.0
+     */
+    void fileChanged( const QString &path );
+
   private:
     QgsConfigCache() SIP_FORCE;
 
     //! Check for configuration file updates (remove entry from cache if file changes)
-    QFileSystemWatcher mFileSystemWatcher;
+    QFileSystemWatcher *mFileSystemWatcher = nullptr;
+
+    //! Silenced watchers inherited from the parent process, see detachFileSystemWatcher()
+    QList<QFileSystemWatcher *> mDetachedFileSystemWatchers;
 
     //! Returns xml document for project file / sld or 0 in case of errors
     QDomDocument *xmlDocument( const QString &filePath );
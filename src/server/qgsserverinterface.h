@@ -35,6 +35,7 @@ class QgsAccessControl;
 class QgsAccessControlFilter;
 #endif
 #include "qgsserviceregistry.h"
+#include "qgsservertilecache.h"
 #include "qgis_server.h"
 #include "qgis_sip.h"
 
@@ -158,6 +159,21 @@ class SERVER_EXPORT QgsServerInterface
      */
     virtual QgsServerSettings *serverSettings() = 0 SIP_SKIP;
 
+    /**
+     * Returns the cache of the map tiles rendered by the WMS service for tile
+     * aligned GetMap requests. Unless a cache was set with setTileCache(), this
+     * is a cache in memory or in the directory defined by the server settings.
+     * \since QGIS 3.0
+     */
+    virtual QgsServerTileCache *tileCache() = 0 SIP_KEEPREFERENCE;
+
+    /**
+     * Sets the cache of the map tiles rendered by the WMS service. Ownership
+     * of \a cache is transferred to the interface.
+     * \since QGIS 3.0
+     */
+    virtual void setTileCache( QgsServerTileCache *cache SIP_TRANSFER ) = 0;
+
   private:
 #ifdef SIP_RUN
     QgsServerInterface();
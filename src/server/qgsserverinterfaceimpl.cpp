@@ -33,6 +33,13 @@ QgsServerInterfaceImpl::QgsServerInterfaceImpl( QgsCapabilitiesCache *capCache,
 #else
   mAccessControls = nullptr;
 #endif
+
+  // tiles of a changed project are outdated
+  mFileChangedConnection = QObject::connect( QgsConfigCache::instance(), &QgsConfigCache::fileChanged, [this]( const QString & path )
+  {
+    if ( mTileCache )
+      mTileCache->removeProject( path );
+  } );
 }
 
 QString QgsServerInterfaceImpl::getEnv( const QString &name ) const
@@ -43,6 +50,7 @@ QString QgsServerInterfaceImpl::getEnv( const QString &name ) const
 
 QgsServerInterfaceImpl::~QgsServerInterfaceImpl()
 {
+  QObject::disconnect( mFileChangedConnection );
 #ifdef HAVE_SERVER_PYTHON_PLUGINS
   delete mAccessControls;
 #endif
@@ -93,6 +101,10 @@ void QgsServerInterfaceImpl::removeConfigCacheEntry( const QString &path )
     mCapabilitiesCache->removeCapabilitiesDocument( path );
   }
   QgsConfigCache::instance()->removeEntry( path );
+  if ( mTileCache )
+  {
+    mTileCache->removeProject( path );
+  }
 }
 
 void QgsServerInterfaceImpl::removeProjectLayers( const QString &path )
@@ -109,3 +121,21 @@ QgsServerSettings *QgsServerInterfaceImpl::serverSettings()
 {
   return mServerSettings;
 }
+
+QgsServerTileCache *QgsServerInterfaceImpl::tileCache()
+{
+  if ( !mTileCache )
+  {
+    QString directory = mServerSettings->tileCacheDirectory();
+    if ( directory.isEmpty() )
+      mTileCache.reset( new QgsServerMemoryTileCache( mServerSettings->tileCacheSize() ) );
+    else
+      mTileCache.reset( new QgsServerFileTileCache( directory, mServerSettings->tileCacheSize() ) );
+  }
+  return mTileCache.get();
+}
+
+void QgsServerInterfaceImpl::setTileCache( QgsServerTileCache *cache )
+{
+  mTileCache.reset( cache );
+}
@@ -25,6 +25,9 @@
 #include "qgsserverinterface.h"
 #include "qgscapabilitiescache.h"
 
+#include <QMetaObject>
+#include <memory>
+
 /**
  * QgsServerInterface
  * Class defining interfaces exposed by QGIS Server and
@@ -71,6 +74,9 @@ class QgsServerInterfaceImpl : public QgsServerInterface
 
     QgsServerSettings *serverSettings() override;
 
+    QgsServerTileCache *tileCache() override;
+    void setTileCache( QgsServerTileCache *cache ) override;
+
   private:
 
     QString mConfigFilePath;
@@ -80,6 +86,9 @@ class QgsServerInterfaceImpl : public QgsServerInterface
     QgsRequestHandler *mRequestHandler = nullptr;
     QgsServiceRegistry *mServiceRegistry = nullptr;
     QgsServerSettings *mServerSettings = nullptr;
+    std::unique_ptr<QgsServerTileCache> mTileCache;
+    //! Connection removing the tiles of changed projects, the interface is not a QObject to be its context
+    QMetaObject::Connection mFileChangedConnection;
 };
 
 #endif // QGSSERVERINTERFACEIMPL_H
@@ -21,6 +21,7 @@
 
 #include <QSettings>
 
+#include <algorithm>
 #include <iostream>
 
 QgsServerSettings::QgsServerSettings()
@@ -130,6 +131,61 @@ void QgsServerSettings::initSettings()
                                QVariant()
                              };
   mSettings[ sCacheSize.envVar ] = sCacheSize;
+
+  // workers
+  const Setting sWorkers = { QgsServerSettingsEnv::QGIS_SERVER_WORKERS,
+                             QgsServerSettingsEnv::DEFAULT_VALUE,
+                             "Number of worker processes sharing the projects loaded by the master process",
+                             "/qgis/server_workers",
+                             QVariant::Int,
+                             QVariant( 0 ),
+                             QVariant()
+                           };
+  mSettings[ sWorkers.envVar ] = sWorkers;
+
+  // preloaded projects
+  const Setting sPreload = { QgsServerSettingsEnv::QGIS_SERVER_PRELOAD_PROJECTS,
+                             QgsServerSettingsEnv::DEFAULT_VALUE,
+                             "Semicolon separated list of projects loaded before forking worker processes",
+                             "/qgis/server_preload_projects",
+                             QVariant::String,
+                             QVariant( "" ),
+                             QVariant()
+                           };
+  mSettings[ sPreload.envVar ] = sPreload;
+
+  // metatile size
+  const Setting sMetatileSize = { QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Number of tiles along each side of the metatiles rendered for tile aligned GetMap requests",
+                                  "/qgis/server_metatile_size",
+                                  QVariant::Int,
+                                  QVariant( 0 ),
+                                  QVariant()
+                                };
+  mSettings[ sMetatileSize.envVar ] = sMetatileSize;
+
+  // tile cache directory
+  const Setting sTileCacheDir = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY,
+                                  QgsServerSettingsEnv::DEFAULT_VALUE,
+                                  "Specify the directory of the tile cache, tiles are cached in memory if empty",
+                                  "/cache/tile_directory",
+                                  QVariant::String,
+                                  QVariant( "" ),
+                                  QVariant()
+                                };
+  mSettings[ sTileCacheDir.envVar ] = sTileCacheDir;
+
+  // tile cache size
+  const Setting sTileCacheSize = { QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE,
+                                   QgsServerSettingsEnv::DEFAULT_VALUE,
+                                   "Specify the size of the tile cache, in memory or in its directory",
+                                   "/cache/tile_size",
+                                   QVariant::LongLong,
+                                   QVariant( 64 * 1024 * 1024 ),
+                                   QVariant()
+                                 };
+  mSettings[ sTileCacheSize.envVar ] = sTileCacheSize;
 }
 
 void QgsServerSettings::load()
@@ -305,3 +361,38 @@ QString QgsServerSettings::cacheDirectory() const
 {
   return value( QgsServerSettingsEnv::QGIS_SERVER_CACHE_DIRECTORY ).toString();
 }
+
+int QgsServerSettings::workers() const
+{
+  return std::max( 0, value( QgsServerSettingsEnv::QGIS_SERVER_WORKERS ).toInt() );
+}
+
+QStringList QgsServerSettings::preloadProjects() const
+{
+  QStringList projects;
+  if ( !projectFile().isEmpty() )
+    projects << projectFile();
+
+  const QStringList paths = value( QgsServerSettingsEnv::QGIS_SERVER_PRELOAD_PROJECTS ).toString().split( ';', QString::SkipEmptyParts );
+  for ( const QString &path : paths )
+  {
+    if ( !projects.contains( path.trimmed() ) )
+      projects << path.trimmed();
+  }
+  return projects;
+}
+
+int QgsServerSettings::metatileSize() const
+{
+  return std::max( 0, value( QgsServerSettingsEnv::QGIS_SERVER_METATILE_SIZE ).toInt() );
+}
+
+QString QgsServerSettings::tileCacheDirectory() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_DIRECTORY ).toString();
+}
+
+qint64 QgsServerSettings::tileCacheSize() const
+{
+  return value( QgsServerSettingsEnv::QGIS_SERVER_TILE_CACHE_SIZE ).toLongLong();
+}
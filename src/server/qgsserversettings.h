@@ -56,7 +56,12 @@ class SERVER_EXPORT QgsServerSettingsEnv : public QObject
       QGIS_PROJECT_FILE,
       MAX_CACHE_LAYERS,
       QGIS_SERVER_CACHE_DIRECTORY,
-      QGIS_SERVER_CACHE_SIZE
+      QGIS_SERVER_CACHE_SIZE,
+      QGIS_SERVER_WORKERS,
+      QGIS_SERVER_PRELOAD_PROJECTS,
+      QGIS_SERVER_METATILE_SIZE,
+      QGIS_SERVER_TILE_CACHE_DIRECTORY,
+      QGIS_SERVER_TILE_CACHE_SIZE
     };
     Q_ENUM( EnvVar )
 };
@@ -144,6 +149,43 @@ class SERVER_EXPORT QgsServerSettings
       */
     QString cacheDirectory() const;
 
+    /**
+      * Returns the number of worker processes forked by the FastCGI server.
+      * \returns the number of workers, 0 if the server runs in a single process.
+      * \since QGIS 3.0
+      */
+    int workers() const;
+
+    /**
+      * Returns the QGS project files loaded before forking worker processes.
+      * The default project file is always part of the list.
+      * \returns the paths of the projects to preload.
+      * \since QGIS 3.0
+      */
+    QStringList preloadProjects() const;
+
+    /**
+      * Returns the number of tiles along each side of the metatiles rendered
+      * for tile aligned WMS GetMap requests.
+      * \returns the metatile size, 0 if tile aligned requests are not cached.
+      * \since QGIS 3.0
+      */
+    int metatileSize() const;
+
+    /**
+      * Returns the directory of the tile cache.
+      * \returns the directory, or an empty string if tiles are cached in memory.
+      * \since QGIS 3.0
+      */
+    QString tileCacheDirectory() const;
+
+    /**
+      * Returns the maximum size of the tile cache, in memory or in its directory.
+      * \returns the cache size in bytes.
+      * \since QGIS 3.0
+      */
+    qint64 tileCacheSize() const;
+
   private:
     void initSettings();
     QVariant value( QgsServerSettingsEnv::EnvVar envVar ) const;
@@ -0,0 +1,245 @@
+/***************************************************************************
+                              qgsservertilecache.cpp
+                              ----------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsservertilecache.h"
+#include "qgsmessagelog.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+//! Time in milliseconds a request waits for the rendering of tiles by another one
+static const int LOCK_TIMEOUT = 60000;
+
+//! The files of a full cache are purged down to this fraction of its maximum size
+static const double PURGE_RATIO = 0.8;
+
+static QString cacheKey( const QString &project, const QString &key )
+{
+  return project + '\n' + key;
+}
+
+void QgsServerTileCache::lockTiles( const QString &project, const QString &key )
+{
+  const QString lockKey = cacheKey( project, key );
+  QElapsedTimer timer;
+  timer.start();
+
+  QMutexLocker locker( &mLockMutex );
+  while ( mLockedTiles.contains( lockKey ) )
+  {
+    const qint64 remaining = LOCK_TIMEOUT - timer.elapsed();
+    if ( remaining <= 0 || !mLockReleased.wait( &mLockMutex, static_cast< unsigned long >( remaining ) ) )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Timeout while waiting for the rendering of tiles of '%1'" ).arg( project ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+      return;
+    }
+  }
+  mLockedTiles.insert( lockKey );
+}
+
+void QgsServerTileCache::unlockTiles( const QString &project, const QString &key )
+{
+  QMutexLocker locker( &mLockMutex );
+  mLockedTiles.remove( cacheKey( project, key ) );
+  mLockReleased.wakeAll();
+}
+
+QgsServerMemoryTileCache::QgsServerMemoryTileCache( qint64 maxSize )
+{
+  mTiles.setMaxCost( static_cast< int >( std::min< qint64 >( maxSize / 1024, std::numeric_limits<int>::max() ) ) );
+}
+
+QImage QgsServerMemoryTileCache::tile( const QString &project, const QString &key )
+{
+  QMutexLocker locker( &mMutex );
+  QImage *image = mTiles.object( cacheKey( project, key ) );
+  return image ? *image : QImage();
+}
+
+void QgsServerMemoryTileCache::insertTile( const QString &project, const QString &key, const QImage &image )
+{
+  QMutexLocker locker( &mMutex );
+  mTiles.insert( cacheKey( project, key ), new QImage( image ), std::max( 1, image.byteCount() / 1024 ) );
+}
+
+void QgsServerMemoryTileCache::removeProject( const QString &project )
+{
+  QMutexLocker locker( &mMutex );
+  const QString prefix = cacheKey( project, QString() );
+  Q_FOREACH ( const QString &key, mTiles.keys() )
+  {
+    if ( key.startsWith( prefix ) )
+      mTiles.remove( key );
+  }
+}
+
+
+QgsServerFileTileCache::QgsServerFileTileCache( const QString &directory, qint64 maxSize )
+  : mDirectory( directory )
+  , mMaxSize( maxSize )
+  , mWrittenSize( maxSize ) // files may be left by a previous run, check them on the first insertion
+{
+}
+
+QgsServerFileTileCache::~QgsServerFileTileCache()
+{
+  qDeleteAll( mLockFiles );
+}
+
+QImage QgsServerFileTileCache::tile( const QString &project, const QString &key )
+{
+  QString fileName = tileFileName( project, key );
+  if ( !QFileInfo::exists( fileName ) )
+    return QImage();
+
+  return QImage( fileName, "PNG" );
+}
+
+void QgsServerFileTileCache::insertTile( const QString &project, const QString &key, const QImage &image )
+{
+  QDir dir( projectDirectory( project ) );
+  if ( !dir.exists() && !dir.mkpath( QStringLiteral( "." ) ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot create the tile cache directory '%1'" ).arg( dir.path() ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    return;
+  }
+
+  // other server processes may read the tile while it is written
+  QSaveFile file( tileFileName( project, key ) );
+  if ( !file.open( QIODevice::WriteOnly ) || !image.save( &file, "PNG" ) || !file.commit() )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot write the tile '%1' to the cache" ).arg( file.fileName() ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    return;
+  }
+
+  if ( mMaxSize <= 0 )
+    return;
+
+  // scanning the directory is expensive, it is only done once a fraction of the
+  // maximum size was written
+  bool checkSize = false;
+  {
+    QMutexLocker locker( &mMutex );
+    mWrittenSize += QFileInfo( file.fileName() ).size();
+    if ( mWrittenSize >= mMaxSize * ( 1 - PURGE_RATIO ) )
+    {
+      mWrittenSize = 0;
+      checkSize = true;
+    }
+  }
+  if ( checkSize )
+    purge();
+}
+
+void QgsServerFileTileCache::purge()
+{
+  struct TileFile
+  {
+    QString path;
+    qint64 size;
+    QDateTime modified;
+  };
+
+  // the tiles written by all the processes sharing the directory
+  QVector<TileFile> files;
+  qint64 totalSize = 0;
+  QDirIterator it( mDirectory, QStringList() << QStringLiteral( "*.png" ), QDir::Files, QDirIterator::Subdirectories );
+  while ( it.hasNext() )
+  {
+    it.next();
+    const QFileInfo info = it.fileInfo();
+    files.append( { info.filePath(), info.size(), info.lastModified() } );
+    totalSize += info.size();
+  }
+  if ( totalSize <= mMaxSize )
+    return;
+
+  std::sort( files.begin(), files.end(), []( const TileFile & a, const TileFile & b )
+  {
+    return a.modified < b.modified;
+  } );
+
+  const qint64 targetSize = static_cast< qint64 >( mMaxSize * PURGE_RATIO );
+  for ( int i = 0; i < files.count() && totalSize > targetSize; ++i )
+  {
+    // another process may have removed it already
+    QFile::remove( files.at( i ).path );
+    totalSize -= files.at( i ).size;
+  }
+}
+
+void QgsServerFileTileCache::lockTiles( const QString &project, const QString &key )
+{
+  // threads of this process
+  QgsServerTileCache::lockTiles( project, key );
+
+  // other processes sharing the directory
+  QDir dir( projectDirectory( project ) );
+  if ( !dir.exists() && !dir.mkpath( QStringLiteral( "." ) ) )
+    return;
+
+  QByteArray hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  std::unique_ptr< QLockFile > lockFile( new QLockFile( dir.filePath( QString::fromLatin1( hash ) + QStringLiteral( ".lock" ) ) ) );
+  // rendering may take long, the lock file is only stale if its process died
+  lockFile->setStaleLockTime( 0 );
+  if ( !lockFile->tryLock( LOCK_TIMEOUT ) )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Timeout while waiting for the rendering of tiles of '%1'" ).arg( project ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    return;
+  }
+
+  QMutexLocker locker( &mMutex );
+  mLockFiles.insert( cacheKey( project, key ), lockFile.release() );
+}
+
+void QgsServerFileTileCache::unlockTiles( const QString &project, const QString &key )
+{
+  {
+    QMutexLocker locker( &mMutex );
+    delete mLockFiles.take( cacheKey( project, key ) );
+  }
+  QgsServerTileCache::unlockTiles( project, key );
+}
+
+void QgsServerFileTileCache::removeProject( const QString &project )
+{
+  QDir dir( projectDirectory( project ) );
+  if ( dir.exists() )
+    dir.removeRecursively();
+}
+
+QString QgsServerFileTileCache::projectDirectory( const QString &project ) const
+{
+  QByteArray hash = QCryptographicHash::hash( project.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  return mDirectory + '/' + QString::fromLatin1( hash );
+}
+
+QString QgsServerFileTileCache::tileFileName( const QString &project, const QString &key ) const
+{
+  QByteArray hash = QCryptographicHash::hash( key.toUtf8(), QCryptographicHash::Sha1 ).toHex();
+  return projectDirectory( project ) + '/' + QString::fromLatin1( hash ) + QStringLiteral( ".png" );
+}
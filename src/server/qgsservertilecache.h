@@ -0,0 +1,153 @@
+/***************************************************************************
+                              qgsservertilecache.h
+                              --------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERTILECACHE_H
+#define QGSSERVERTILECACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+
+#include "qgis_server.h"
+#include "qgis_sip.h"
+
+class QLockFile;
+
+/** \ingroup server
+ * Interface for caches of the map tiles rendered by the WMS service.
+ *
+ * Tiles are stored per project file, so that all the tiles of a project
+ * can be removed when the project changes. The key identifies a tile
+ * within a project, and is built from the request parameters.
+ *
+ * Implementations must be safe to use from several threads.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerTileCache
+{
+  public:
+
+    virtual ~QgsServerTileCache() = default;
+
+    /**
+     * Returns the tile of a \a project with the given \a key, or a null
+     * image if it is not in the cache.
+     */
+    virtual QImage tile( const QString &project, const QString &key ) = 0;
+
+    //! Inserts the \a image of the tile of a \a project with the given \a key
+    virtual void insertTile( const QString &project, const QString &key, const QImage &image ) = 0;
+
+    //! Removes all the tiles of a \a project
+    virtual void removeProject( const QString &project ) = 0;
+
+    /**
+     * Waits until no other request renders the tiles of a \a project identified
+     * by \a key, then reserves their rendering for the caller until unlockTiles()
+     * is called. Requests for the tiles of a metatile being rendered then wait for
+     * it and find their tile in the cache instead of rendering the metatile again.
+     * A request waiting for too long gets the reservation anyway.
+     *
+     * The default implementation only serializes the threads of the current process.
+     */
+    virtual void lockTiles( const QString &project, const QString &key );
+
+    //! Releases the rendering of the tiles reserved by lockTiles()
+    virtual void unlockTiles( const QString &project, const QString &key );
+
+  private:
+    QMutex mLockMutex;
+    QWaitCondition mLockReleased;
+    QSet<QString> mLockedTiles;
+};
+
+/** \ingroup server
+ * Tile cache keeping the most recently used tiles in memory.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerMemoryTileCache : public QgsServerTileCache
+{
+  public:
+
+    //! Constructor for a cache holding up to \a maxSize bytes of tiles
+    explicit QgsServerMemoryTileCache( qint64 maxSize );
+
+    QImage tile( const QString &project, const QString &key ) override;
+    void insertTile( const QString &project, const QString &key, const QImage &image ) override;
+    void removeProject( const QString &project ) override;
+
+  private:
+#ifdef SIP_RUN
+    QgsServerMemoryTileCache( const QgsServerMemoryTileCache &rh );
+#endif
+
+    //! Tiles by project and key, the cost is in kilobytes to fit in an int
+    QCache<QString, QImage> mTiles;
+    QMutex mMutex;
+};
+
+/** \ingroup server
+ * Tile cache storing the tiles as PNG files in a directory, which may be
+ * shared by several server processes.
+ *
+ * When the files exceed the maximum size of the cache, the oldest ones are
+ * removed, whichever process wrote them. Tile rendering is reserved with lock
+ * files, so that the processes sharing the directory render each metatile once.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerFileTileCache : public QgsServerTileCache
+{
+  public:
+
+    /**
+     * Constructor for a cache storing the tiles in \a directory, up to
+     * \a maxSize bytes of files. The size is not limited if \a maxSize is 0.
+     */
+    explicit QgsServerFileTileCache( const QString &directory, qint64 maxSize = 0 );
+
+    ~QgsServerFileTileCache();
+
+    QImage tile( const QString &project, const QString &key ) override;
+    void insertTile( const QString &project, const QString &key, const QImage &image ) override;
+    void removeProject( const QString &project ) override;
+    void lockTiles( const QString &project, const QString &key ) override;
+    void unlockTiles( const QString &project, const QString &key ) override;
+
+  private:
+#ifdef SIP_RUN
+    QgsServerFileTileCache( const QgsServerFileTileCache &rh );
+#endif
+
+    QString projectDirectory( const QString &project ) const;
+    QString tileFileName( const QString &project, const QString &key ) const;
+
+    //! Removes the oldest tiles until the files fit in the maximum size
+    void purge();
+
+    QString mDirectory;
+    qint64 mMaxSize = 0;
+    //! Bytes written since the size of the directory was last checked
+    qint64 mWrittenSize = 0;
+    //! Lock files of the tiles reserved by this process
+    QHash<QString, QLockFile *> mLockFiles;
+    QMutex mMutex;
+};
+
+#endif // QGSSERVERTILECACHE_H
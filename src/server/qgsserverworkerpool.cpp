@@ -0,0 +1,222 @@
+/***************************************************************************
+                              qgsserverworkerpool.cpp
+                              -----------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include "qgsserverworkerpool.h"
+#include "qgsconfigcache.h"
+#include "qgsmessagelog.h"
+
+#include <csignal>
+
+#ifndef Q_OS_WIN
+#include <cerrno>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+//! Set in the master by SIGTERM and SIGINT
+static volatile sig_atomic_t sStopMaster = 0;
+//! Set in a worker by SIGTERM
+static volatile sig_atomic_t sStopWorker = 0;
+
+#ifndef Q_OS_WIN
+static void stopMasterHandler( int )
+{
+  sStopMaster = 1;
+}
+
+static void stopWorkerHandler( int )
+{
+  sStopWorker = 1;
+}
+
+static void installHandler( int signum, void ( *handler )( int ) )
+{
+  // no SA_RESTART: a worker blocked in accept() must return from it
+  struct sigaction action;
+  action.sa_handler = handler;
+  sigemptyset( &action.sa_mask );
+  action.sa_flags = 0;
+  sigaction( signum, &action, nullptr );
+}
+#endif
+
+QgsServerWorkerPool::QgsServerWorkerPool( int workerCount, const QStringList &projects )
+  : mWorkerCount( workerCount )
+  , mProjects( projects )
+{
+  mTimer.setInterval( 500 );
+  connect( &mTimer, &QTimer::timeout, this, &QgsServerWorkerPool::checkWorkers );
+  connect( QgsConfigCache::instance(), &QgsConfigCache::fileChanged, this, &QgsServerWorkerPool::fileChanged );
+}
+
+bool QgsServerWorkerPool::stopRequested()
+{
+  return sStopWorker != 0;
+}
+
+bool QgsServerWorkerPool::exec()
+{
+#ifdef Q_OS_WIN
+  QgsMessageLog::logMessage( QStringLiteral( "Worker processes are not supported on this platform" ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+  return true;
+#else
+  Q_FOREACH ( const QString &path, mProjects )
+  {
+    QgsConfigCache::instance()->preload( path );
+  }
+
+  installHandler( SIGTERM, stopMasterHandler );
+  installHandler( SIGINT, stopMasterHandler );
+
+  for ( int i = 0; i < mWorkerCount; ++i )
+  {
+    if ( spawnWorker() == 0 )
+      return true;
+  }
+
+  QgsMessageLog::logMessage( QStringLiteral( "Started %1 worker processes" ).arg( mWorkers.count() ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+
+  // workers forked from a slot leave the event loop to handle requests
+  mTimer.start();
+  mLoop.exec();
+  if ( mIsWorker )
+    return true;
+
+  mTimer.stop();
+  stopWorkers();
+  return false;
+#endif
+}
+
+void QgsServerWorkerPool::checkWorkers()
+{
+#ifndef Q_OS_WIN
+  if ( sStopMaster )
+  {
+    mLoop.quit();
+    return;
+  }
+
+  int status = 0;
+  pid_t pid;
+  while ( ( pid = waitpid( -1, &status, WNOHANG ) ) > 0 )
+  {
+    mWorkers.remove( pid );
+    if ( WIFSIGNALED( status ) && WTERMSIG( status ) != SIGTERM )
+    {
+      QgsMessageLog::logMessage( QStringLiteral( "Worker process %1 was terminated by signal %2" ).arg( pid ).arg( WTERMSIG( status ) ), QStringLiteral( "Server" ), QgsMessageLog::WARNING );
+    }
+  }
+
+  while ( mWorkers.count() < mWorkerCount )
+  {
+    qint64 worker = spawnWorker();
+    if ( worker == 0 )
+    {
+      mLoop.quit();
+      return;
+    }
+    else if ( worker < 0 )
+    {
+      break;
+    }
+  }
+#endif
+}
+
+void QgsServerWorkerPool::fileChanged( const QString &path )
+{
+#ifndef Q_OS_WIN
+  if ( mIsWorker )
+    return;
+
+  QgsMessageLog::logMessage( QStringLiteral( "Project file '%1' changed, restarting the worker processes" ).arg( path ), QStringLiteral( "Server" ), QgsMessageLog::INFO );
+
+  // the project was removed from the cache and is watched again once reloaded
+  if ( mProjects.contains( path ) )
+    QgsConfigCache::instance()->preload( path );
+
+  // the workers finish their current request, then get replaced by checkWorkers()
+  Q_FOREACH ( qint64 worker, mWorkers )
+  {
+    kill( static_cast< pid_t >( worker ), SIGTERM );
+  }
+#else
+  Q_UNUSED( path );
+#endif
+}
+
+qint64 QgsServerWorkerPool::spawnWorker()
+{
+#ifdef Q_OS_WIN
+  return -1;
+#else
+  pid_t pid = fork();
+  if ( pid < 0 )
+  {
+    QgsMessageLog::logMessage( QStringLiteral( "Cannot fork a worker process: %1" ).arg( QString::fromLocal8Bit( strerror( errno ) ) ), QStringLiteral( "Server" ), QgsMessageLog::CRITICAL );
+  }
+  else if ( pid == 0 )
+  {
+    initWorker();
+  }
+  else
+  {
+    mWorkers.insert( pid );
+  }
+  return pid;
+#endif
+}
+
+void QgsServerWorkerPool::initWorker()
+{
+#ifndef Q_OS_WIN
+  mIsWorker = true;
+  mWorkers.clear();
+  mTimer.stop();
+
+  installHandler( SIGTERM, stopWorkerHandler );
+  signal( SIGINT, SIG_DFL );
+
+  // the master keeps watching the preloaded projects
+  QgsConfigCache::instance()->detachFileSystemWatcher();
+
+  // file handles and database connections must not be shared with the master
+  QgsConfigCache::instance()->reopenDataSources();
+#endif
+}
+
+void QgsServerWorkerPool::stopWorkers()
+{
+#ifndef Q_OS_WIN
+  Q_FOREACH ( qint64 worker, mWorkers )
+  {
+    kill( static_cast< pid_t >( worker ), SIGTERM );
+  }
+
+  while ( !mWorkers.isEmpty() )
+  {
+    int status = 0;
+    pid_t pid = waitpid( -1, &status, 0 );
+    if ( pid < 0 && errno != EINTR )
+      break;
+    mWorkers.remove( pid );
+  }
+  mWorkers.clear();
+#endif
+}
@@ -0,0 +1,98 @@
+/***************************************************************************
+                              qgsserverworkerpool.h
+                              ---------------------
+  begin                : October 2017
+  copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef QGSSERVERWORKERPOOL_H
+#define QGSSERVERWORKERPOOL_H
+
+#define SIP_NO_FILE
+
+#include <QEventLoop>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+
+#include "qgis_server.h"
+
+/** \ingroup server
+ * Preforking mode of the FastCGI server.
+ *
+ * The master process loads the projects and their layers once in the
+ * QgsConfigCache, then forks worker processes which share this read-only
+ * state copy-on-write instead of each one parsing the projects again.
+ * The master watches the worker processes and replaces those which exit.
+ *
+ * When a preloaded project file changes, the master reloads it through
+ * the QgsConfigCache invalidation and replaces all the workers, which
+ * finish the request they are handling before exiting.
+ *
+ * Forking is not supported on Windows, where the server keeps running in
+ * a single process.
+ * \since QGIS 3.0
+ */
+class SERVER_EXPORT QgsServerWorkerPool : public QObject
+{
+    Q_OBJECT
+
+  public:
+
+    /**
+     * Constructor for a pool of \a workerCount processes sharing the
+     * \a projects loaded by the master process.
+     */
+    QgsServerWorkerPool( int workerCount, const QStringList &projects );
+
+    /**
+     * Preloads the projects and forks the workers.
+     *
+     * In the master process, this only returns once the server is stopped
+     * with SIGTERM or SIGINT, and returns false. In the worker processes it
+     * returns true as soon as the worker is ready to accept requests.
+     */
+    bool exec();
+
+    //! Returns true if the current worker process was asked to stop by the master
+    static bool stopRequested();
+
+  private slots:
+    //! Reaps the exited workers and forks new ones
+    void checkWorkers();
+    //! Reloads a changed project and replaces the workers
+    void fileChanged( const QString &path );
+
+  private:
+
+    /**
+     * Forks a new worker.
+     * \returns the pid of the worker in the master, 0 in the worker and -1 on error
+     */
+    qint64 spawnWorker();
+
+    //! Prepares a freshly forked process for handling requests
+    void initWorker();
+
+    //! Stops all the workers and waits until they exit
+    void stopWorkers();
+
+    int mWorkerCount = 0;
+    QStringList mProjects;
+    QSet<qint64> mWorkers;
+    QTimer mTimer;
+    QEventLoop mLoop;
+    bool mIsWorker = false;
+};
+
+#endif // QGSSERVERWORKERPOOL_H
@@ -37,6 +37,7 @@
 #include "qgswfsgetfeature.h"
 
 #include <QStringList>
+#include <QTextStream>
 
 namespace QgsWfs
 {
@@ -44,22 +45,40 @@ namespace QgsWfs
   namespace
   {
 
-    QString createFeatureGeoJSON( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes,
+    //! Number of bytes written to the response after which they are flushed to the client
+    const qint64 FLUSH_THRESHOLD = 64 * 1024;
+
+    /**
+     * Serialisation state reused for all the features of a GetFeature response,
+     * so that each feature is written straight to the response without building
+     * a document.
+     */
+    struct getFeatureStream
+    {
+      //! Scratch document for the GML geometries, the nodes are released after each feature
+      QDomDocument geometryDoc;
+      //! GeoJSON exporter, its source CRS is set once per layer
+      QgsJsonExporter jsonExporter;
+      //! Bytes written to the response since the last flush
+      qint64 pendingBytes = 0;
+    };
+
+    QString createFeatureGeoJSON( QgsFeature *feat, QgsJsonExporter &exporter, const QgsAttributeList &attrIndexes,
                                   const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom,
                                   const QString &geometryName );
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString &geometryName );
+    QString createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
+                               const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
+                               bool withGeom, const QString &geometryName );
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
-                                   const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
-                                   bool withGeom, const QString geometryName );
+    QString createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs,
+                               const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName,
+                               bool withGeom, const QString &geometryName );
 
     void startGetFeature( const QgsServerRequest &request, QgsServerResponse &response, const QgsProject *project, const QString &format,
                           int prec, QgsCoordinateReferenceSystem &crs, QgsRectangle *rect, const QStringList &typeNames );
 
-    void setGetFeature( QgsServerResponse &response, const QString &format, QgsFeature *feat, int featIdx, int prec,
+    void setGetFeature( QgsServerResponse &response, getFeatureStream &stream, const QString &format, QgsFeature *feat, int featIdx, int prec,
                         QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
                         const QString &typeName, bool withGeom, const QString &geometryName );
 
@@ -162,6 +181,9 @@ namespace QgsWfs
     //there's LOTS of potential exit paths here, so we avoid having to restore the filters manually
     std::unique_ptr< QgsOWSServerFilterRestorer > filterRestorer( new QgsOWSServerFilterRestorer( accessControl ) );
 
+    // features are serialised one by one straight to the response
+    getFeatureStream stream;
+
     // features counters
     long sentFeatures = 0;
     long iteratedFeatures = 0;
@@ -307,6 +329,10 @@ namespace QgsWfs
         geometryName = QLatin1String( "NONE" );
       }
 
+      //QgsJsonExporter force transform geometry to ESPG:4326
+      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
+      stream.jsonExporter.setSourceCrs( layerCrs );
+
       // Iterate through features
       QgsFeatureIterator fit = vlayer->getFeatures( featureRequest );
       while ( fit.nextFeature( feature ) && ( aRequest.maxFeatures == -1 || sentFeatures < aRequest.maxFeatures ) )
@@ -316,7 +342,7 @@ namespace QgsWfs
 
         if ( iteratedFeatures >= aRequest.startIndex )
         {
-          setGetFeature( response, aRequest.outputFormat, &feature, sentFeatures, layerPrecision, layerCrs, attrIndexes, layerExcludedAttributes,
+          setGetFeature( response, stream, aRequest.outputFormat, &feature, sentFeatures, layerPrecision, layerCrs, attrIndexes, layerExcludedAttributes,
                          typeName, withGeom, geometryName );
           ++sentFeatures;
         }
@@ -933,44 +959,39 @@ namespace QgsWfs
       }
     }
 
-    void setGetFeature( QgsServerResponse &response, const QString &format, QgsFeature *feat, int featIdx, int prec,
+    void setGetFeature( QgsServerResponse &response, getFeatureStream &stream, const QString &format, QgsFeature *feat, int featIdx, int prec,
                         QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes,
                         const QString &typeName, bool withGeom, const QString &geometryName )
     {
       if ( !feat->isValid() )
         return;
 
+      QString fcString;
       if ( format == QLatin1String( "GeoJSON" ) )
       {
-        QString fcString;
         if ( featIdx == 0 )
           fcString += QLatin1String( "  " );
         else
           fcString += QLatin1String( " ," );
-        fcString += createFeatureGeoJSON( feat, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
+        fcString += createFeatureGeoJSON( feat, stream.jsonExporter, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
         fcString += QLatin1String( "\n" );
-
-        response.write( fcString.toUtf8() );
+      }
+      else if ( format == QLatin1String( "GML3" ) )
+      {
+        fcString = createFeatureGML3( feat, stream.geometryDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
       }
       else
       {
-        QDomDocument gmlDoc;
-        QDomElement featureElement;
-        if ( format == QLatin1String( "GML3" ) )
-        {
-          featureElement = createFeatureGML3( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
-        }
-        else
-        {
-          featureElement = createFeatureGML2( feat, gmlDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
-          gmlDoc.appendChild( featureElement );
-        }
-        response.write( gmlDoc.toByteArray() );
+        fcString = createFeatureGML2( feat, stream.geometryDoc, prec, crs, attrIndexes, excludedAttributes, typeName, withGeom, geometryName );
       }
+      stream.pendingBytes += response.write( fcString.toUtf8() );
 
-      // Stream partial content
-      response.flush();
+      // Stream partial content, the first feature is sent straight away
+      if ( featIdx == 0 || stream.pendingBytes >= FLUSH_THRESHOLD )
+      {
+        response.flush();
+        stream.pendingBytes = 0;
+      }
     }
 
     void endGetFeature( QgsServerResponse &response, const QString &format )
@@ -989,17 +1010,10 @@ namespace QgsWfs
     }
 
 
-    QString createFeatureGeoJSON( QgsFeature *feat, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    QString createFeatureGeoJSON( QgsFeature *feat, QgsJsonExporter &exporter, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
     {
       QString id = QStringLiteral( "%1.%2" ).arg( typeName, FID_TO_STRING( feat->id() ) );
 
-      QgsJsonExporter exporter;
-      exporter.setSourceCrs( crs );
-      //QgsJsonExporter force transform geometry to ESPG:4326
-      //and the RFC 7946 GeoJSON specification recommends limiting coordinate precision to 6
-      Q_UNUSED( prec );
-      //exporter.setPrecision( prec );
-
       //copy feature so we can modify its geometry as required
       QgsFeature f( *feat );
       QgsGeometry geom = feat->geometry();
@@ -1044,62 +1058,104 @@ namespace QgsWfs
     }
 
 
-    QDomElement createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    /**
+     * Escapes a value written as the text of an element or the value of an attribute
+     * exactly as QDomNode::save() does, so that the streamed features read back as
+     * the documents built with QDom did.
+     */
+    QString xmlEscaped( const QString &value, bool attribute )
     {
-      //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
-
-      //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "fid" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      QString escaped;
+      escaped.reserve( value.size() );
+      for ( int i = 0; i < value.size(); ++i )
+      {
+        const QChar c = value.at( i );
+        if ( c == '<' )
+          escaped += QLatin1String( "&lt;" );
+        else if ( c == '&' )
+          escaped += QLatin1String( "&amp;" );
+        else if ( c == '>' && i >= 2 && value.at( i - 1 ) == ']' && value.at( i - 2 ) == ']' )
+          escaped += QLatin1String( "&gt;" );
+        else if ( attribute && c == '"' )
+          escaped += QLatin1String( "&quot;" );
+        else if ( attribute && ( c == '\n' || c == '\t' ) )
+          escaped += QStringLiteral( "&#x%1;" ).arg( c.unicode(), 0, 16 );
+        else if ( c == '\r' )
+          escaped += QLatin1String( "&#xd;" );
+        else
+          escaped += c;
+      }
+      return escaped;
+    }
 
-      if ( withGeom && geometryName != QLatin1String( "NONE" ) )
+    void appendElement( QString &out, const QDomElement &element, int depth )
+    {
+      // QDomNode::save() indents the element by one level
+      QString xml;
+      QTextStream xmlStream( &xml );
+      element.save( xmlStream, 1 );
+      xmlStream.flush();
+
+      const QString indent( depth - 1, ' ' );
+      int start = 0;
+      int end;
+      while ( ( end = xml.indexOf( '\n', start ) ) != -1 )
       {
-        //add geometry column (as gml)
-        QgsGeometry geom = feat->geometry();
+        out += indent;
+        out += xml.midRef( start, end - start + 1 );
+        start = end + 1;
+      }
+    }
 
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
-        if ( geometryName == QLatin1String( "EXTENT" ) )
-        {
-          QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( bbox, doc, prec );
-        }
-        else if ( geometryName == QLatin1String( "CENTROID" ) )
-        {
-          QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, prec );
-        }
-        else
+    QString gmlGeometryElement( QgsFeature *feat, QDomDocument &doc, bool gml3, int prec, QgsCoordinateReferenceSystem &crs,
+                                const QString &geometryName, QgsRectangle &box )
+    {
+      QgsGeometry geom = feat->geometry();
+
+      QDomElement gmlElem;
+      if ( geometryName == QLatin1String( "EXTENT" ) )
+      {
+        QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
+        gmlElem = gml3 ? QgsOgcUtils::geometryToGML( bbox, doc, QStringLiteral( "GML3" ), prec ) : QgsOgcUtils::geometryToGML( bbox, doc, prec );
+      }
+      else if ( geometryName == QLatin1String( "CENTROID" ) )
+      {
+        QgsGeometry centroid = geom.centroid();
+        gmlElem = gml3 ? QgsOgcUtils::geometryToGML( centroid, doc, QStringLiteral( "GML3" ), prec ) : QgsOgcUtils::geometryToGML( centroid, doc, prec );
+      }
+      else
+      {
+        QgsAbstractGeometry *abstractGeom = geom.geometry();
+        if ( abstractGeom )
         {
-          QgsAbstractGeometry *abstractGeom = geom.geometry();
-          if ( abstractGeom )
-          {
-            gmlElem = abstractGeom->asGML2( doc, prec, "http://www.opengis.net/gml" );
-          }
+          gmlElem = gml3 ? abstractGeom->asGML3( doc, prec, "http://www.opengis.net/gml" ) : abstractGeom->asGML2( doc, prec, "http://www.opengis.net/gml" );
         }
+      }
 
-        if ( !gmlElem.isNull() )
-        {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLBox( &box, doc, prec );
+      if ( gmlElem.isNull() )
+        return QString();
 
-          if ( crs.isValid() )
-          {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-          }
+      box = geom.boundingBox();
+      if ( crs.isValid() )
+      {
+        gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
+      }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+      QString xml;
+      appendElement( xml, gmlElem, 3 );
+      return xml;
+    }
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
-        }
-      }
+    QString srsNameAttribute( const QgsCoordinateReferenceSystem &crs )
+    {
+      if ( !crs.isValid() )
+        return QString();
+
+      return QStringLiteral( " srsName=\"%1\"" ).arg( xmlEscaped( crs.authid(), true ) );
+    }
 
+    void appendAttributesGML( QString &out, QgsFeature *feat, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes )
+    {
       //read all attribute values from the feature
       QgsAttributes featureAttributes = feat->attributes();
       QgsFields fields = feat->fields();
@@ -1117,103 +1173,85 @@ namespace QgsWfs
           continue;
         }
 
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
+        QString fieldName = "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) );
+        out += QLatin1String( "  <" ) + fieldName + '>';
+        out += xmlEscaped( featureAttributes[idx].toString(), false );
+        out += QLatin1String( "</" ) + fieldName + QLatin1String( ">\n" );
       }
-
-      return featureElement;
     }
 
-    QDomElement createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString geometryName )
+    QString createFeatureGML2( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
     {
       //gml:FeatureMember
-      QDomElement featureElement = doc.createElement( QStringLiteral( "gml:featureMember" )/*wfs:FeatureMember*/ );
+      QString fcString = QStringLiteral( "<gml:featureMember>\n" );
 
       //qgs:%TYPENAME%
-      QDomElement typeNameElement = doc.createElement( "qgs:" + typeName /*qgs:%TYPENAME%*/ );
-      typeNameElement.setAttribute( QStringLiteral( "gml:id" ), typeName + "." + QString::number( feat->id() ) );
-      featureElement.appendChild( typeNameElement );
+      fcString += QStringLiteral( " <qgs:%1 fid=\"%2\">\n" ).arg( typeName, xmlEscaped( typeName + "." + QString::number( feat->id() ), true ) );
 
       if ( withGeom && geometryName != QLatin1String( "NONE" ) )
       {
         //add geometry column (as gml)
-        QgsGeometry geom = feat->geometry();
-
-        QDomElement geomElem = doc.createElement( QStringLiteral( "qgs:geometry" ) );
-        QDomElement gmlElem;
-        if ( geometryName == QLatin1String( "EXTENT" ) )
+        QgsRectangle box;
+        QString gmlString = gmlGeometryElement( feat, doc, false, prec, crs, geometryName, box );
+        if ( !gmlString.isEmpty() )
         {
-          QgsGeometry bbox = QgsGeometry::fromRect( geom.boundingBox() );
-          gmlElem = QgsOgcUtils::geometryToGML( bbox, doc, QStringLiteral( "GML3" ), prec );
-        }
-        else if ( geometryName == QLatin1String( "CENTROID" ) )
-        {
-          QgsGeometry centroid = geom.centroid();
-          gmlElem = QgsOgcUtils::geometryToGML( centroid, doc, QStringLiteral( "GML3" ), prec );
-        }
-        else
-        {
-          QgsAbstractGeometry *abstractGeom = geom.geometry();
-          if ( abstractGeom )
-          {
-            gmlElem = abstractGeom->asGML3( doc, prec, "http://www.opengis.net/gml" );
-          }
+          fcString += QLatin1String( "  <gml:boundedBy>\n" );
+          fcString += QStringLiteral( "   <gml:Box%1>\n" ).arg( srsNameAttribute( crs ) );
+          fcString += QLatin1String( "    <gml:coordinates cs=\",\" ts=\" \">" );
+          fcString += qgsDoubleToString( box.xMinimum(), prec ) + ',' + qgsDoubleToString( box.yMinimum(), prec ) + ' ';
+          fcString += qgsDoubleToString( box.xMaximum(), prec ) + ',' + qgsDoubleToString( box.yMaximum(), prec );
+          fcString += QLatin1String( "</gml:coordinates>\n" );
+          fcString += QLatin1String( "   </gml:Box>\n" );
+          fcString += QLatin1String( "  </gml:boundedBy>\n" );
+
+          fcString += QLatin1String( "  <qgs:geometry>\n" );
+          fcString += gmlString;
+          fcString += QLatin1String( "  </qgs:geometry>\n" );
         }
+      }
 
-        if ( !gmlElem.isNull() )
-        {
-          QgsRectangle box = geom.boundingBox();
-          QDomElement bbElem = doc.createElement( QStringLiteral( "gml:boundedBy" ) );
-          QDomElement boxElem = QgsOgcUtils::rectangleToGMLEnvelope( &box, doc, prec );
+      appendAttributesGML( fcString, feat, attrIndexes, excludedAttributes );
 
-          if ( crs.isValid() )
-          {
-            boxElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-            gmlElem.setAttribute( QStringLiteral( "srsName" ), crs.authid() );
-          }
+      fcString += QStringLiteral( " </qgs:%1>\n" ).arg( typeName );
+      fcString += QLatin1String( "</gml:featureMember>\n" );
+      return fcString;
+    }
 
-          bbElem.appendChild( boxElem );
-          typeNameElement.appendChild( bbElem );
+    QString createFeatureGML3( QgsFeature *feat, QDomDocument &doc, int prec, QgsCoordinateReferenceSystem &crs, const QgsAttributeList &attrIndexes, const QSet<QString> &excludedAttributes, const QString &typeName, bool withGeom, const QString &geometryName )
+    {
+      //gml:FeatureMember
+      QString fcString = QStringLiteral( "<gml:featureMember>\n" );
 
-          geomElem.appendChild( gmlElem );
-          typeNameElement.appendChild( geomElem );
-        }
-      }
+      //qgs:%TYPENAME%
+      fcString += QStringLiteral( " <qgs:%1 gml:id=\"%2\">\n" ).arg( typeName, xmlEscaped( typeName + "." + QString::number( feat->id() ), true ) );
 
-      //read all attribute values from the feature
-      QgsAttributes featureAttributes = feat->attributes();
-      QgsFields fields = feat->fields();
-      for ( int i = 0; i < attrIndexes.count(); ++i )
+      if ( withGeom && geometryName != QLatin1String( "NONE" ) )
       {
-        int idx = attrIndexes[i];
-        if ( idx >= fields.count() )
-        {
-          continue;
-        }
-        QString attributeName = fields.at( idx ).name();
-        //skip attribute if it is excluded from WFS publication
-        if ( excludedAttributes.contains( attributeName ) )
+        //add geometry column (as gml)
+        QgsRectangle box;
+        QString gmlString = gmlGeometryElement( feat, doc, true, prec, crs, geometryName, box );
+        if ( !gmlString.isEmpty() )
         {
-          continue;
+          fcString += QLatin1String( "  <gml:boundedBy>\n" );
+          fcString += QStringLiteral( "   <gml:Envelope%1>\n" ).arg( srsNameAttribute( crs ) );
+          fcString += QLatin1String( "    <gml:lowerCorner>" ) + qgsDoubleToString( box.xMinimum(), prec ) + ' ' + qgsDoubleToString( box.yMinimum(), prec ) + QLatin1String( "</gml:lowerCorner>\n" );
+          fcString += QLatin1String( "    <gml:upperCorner>" ) + qgsDoubleToString( box.xMaximum(), prec ) + ' ' + qgsDoubleToString( box.yMaximum(), prec ) + QLatin1String( "</gml:upperCorner>\n" );
+          fcString += QLatin1String( "   </gml:Envelope>\n" );
+          fcString += QLatin1String( "  </gml:boundedBy>\n" );
+
+          fcString += QLatin1String( "  <qgs:geometry>\n" );
+          fcString += gmlString;
+          fcString += QLatin1String( "  </qgs:geometry>\n" );
         }
-
-        QDomElement fieldElem = doc.createElement( "qgs:" + attributeName.replace( QStringLiteral( " " ), QStringLiteral( "_" ) ) );
-        QDomText fieldText = doc.createTextNode( featureAttributes[idx].toString() );
-        fieldElem.appendChild( fieldText );
-        typeNameElement.appendChild( fieldElem );
       }
 
-      return featureElement;
-    }
-
-
+      appendAttributesGML( fcString, feat, attrIndexes, excludedAttributes );
 
+      fcString += QStringLiteral( " </qgs:%1>\n" ).arg( typeName );
+      fcString += QLatin1String( "</gml:featureMember>\n" );
+      return fcString;
+    }
 
   } // namespace
 
 } // samespace QgsWfs
-
-
-
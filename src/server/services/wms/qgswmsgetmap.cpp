@@ -21,12 +21,199 @@
 #include "qgswmsutils.h"
 #include "qgswmsgetmap.h"
 #include "qgswmsrenderer.h"
+#include "qgsserverprojectutils.h"
+#include "qgsservertilecache.h"
+#include "qgscoordinatereferencesystem.h"
 
+#include <QFileInfo>
 #include <QImage>
 
+#include <algorithm>
+#include <cmath>
+
 namespace QgsWms
 {
 
+  /**
+   * Returns true if the BBOX is a tile of a grid with its origin at 0, 0, as
+   * requested by tiled clients: the usual tiling schemes have their origin at
+   * a multiple of the tile size at every zoom level. Sets the indexes of the
+   * tile and its size along both BBOX axes.
+   */
+  static bool tileAligned( const QgsServerRequest::Parameters &params, qint64 &tileA, qint64 &tileB, double &spanA, double &spanB )
+  {
+    const QStringList bbox = params.value( QStringLiteral( "BBOX" ) ).split( ',' );
+    if ( bbox.count() != 4 )
+      return false;
+
+    double values[4];
+    for ( int i = 0; i < 4; ++i )
+    {
+      bool ok = false;
+      values[i] = bbox.at( i ).toDouble( &ok );
+      if ( !ok )
+        return false;
+    }
+
+    spanA = values[2] - values[0];
+    spanB = values[3] - values[1];
+    if ( !( spanA > 0 ) || !( spanB > 0 ) )
+      return false;
+
+    const double a = values[0] / spanA;
+    const double b = values[1] / spanB;
+    tileA = qRound64( a );
+    tileB = qRound64( b );
+    if ( std::fabs( a - tileA ) > 1e-6 || std::fabs( b - tileB ) > 1e-6 )
+      return false;
+
+    const int width = params.value( QStringLiteral( "WIDTH" ) ).toInt();
+    const int height = params.value( QStringLiteral( "HEIGHT" ) ).toInt();
+    return width > 0 && height > 0 && width <= 1024 && height <= 1024;
+  }
+
+  //! Returns true if the first BBOX axis is the horizontal one, as for the map extent
+  static bool firstAxisHorizontal( const QgsWmsParameters &wmsParameters )
+  {
+    bool inverted = false;
+    QString crs = wmsParameters.crs();
+    if ( crs.compare( QLatin1String( "CRS:84" ), Qt::CaseInsensitive ) == 0 )
+    {
+      crs = QStringLiteral( "EPSG:4326" );
+      inverted = true;
+    }
+    if ( wmsParameters.versionAsNumber() >= QgsProjectVersion( 1, 3, 0 ) && QgsCoordinateReferenceSystem::fromOgcWmsCrs( crs ).hasAxisInverted() )
+    {
+      inverted = !inverted;
+    }
+    return !inverted;
+  }
+
+  static qint64 floorDiv( qint64 value, int divisor )
+  {
+    return value >= 0 ? value / divisor : -( ( -value + divisor - 1 ) / divisor );
+  }
+
+  //! Reserves the rendering of the tiles of a metatile while it exists
+  class TileLocker
+  {
+    public:
+      TileLocker( QgsServerTileCache *cache, const QString &project, const QString &key )
+        : mCache( cache )
+        , mProject( project )
+        , mKey( key )
+      {
+        mCache->lockTiles( mProject, mKey );
+      }
+
+      ~TileLocker()
+      {
+        mCache->unlockTiles( mProject, mKey );
+      }
+
+    private:
+      QgsServerTileCache *mCache = nullptr;
+      QString mProject;
+      QString mKey;
+  };
+
+  /**
+   * Returns the image of a tile aligned GetMap request from the tile cache, or renders
+   * the metatile containing the tile, fills the cache with its slices and returns the
+   * requested one. Labels are then only cut at the metatile edges.
+   * Returns nullptr if the request is not tile aligned or must not be cached.
+   */
+  static QImage *getCachedTile( QgsServerInterface *serverIface, const QgsProject *project,
+                                const QgsServerRequest::Parameters &params )
+  {
+    qint64 tileA, tileB;
+    double spanA, spanB;
+    if ( !tileAligned( params, tileA, tileB, spanA, spanB ) )
+      return nullptr;
+
+    QString projectPath = serverIface->configFilePath();
+
+    // every parameter but the BBOX may change the rendering, the modification time
+    // of the project keeps tiles of a file cache from being reused after a restart
+    QStringList cacheKeyList;
+    for ( auto it = params.constBegin(); it != params.constEnd(); ++it )
+    {
+      if ( it.key() != QLatin1String( "BBOX" ) )
+        cacheKeyList << it.key() + '=' + it.value();
+    }
+    cacheKeyList << QString::number( QFileInfo( projectPath ).lastModified().toMSecsSinceEpoch() );
+    cacheKeyList << QString::number( spanA, 'g', 17 ) << QString::number( spanB, 'g', 17 );
+
+#ifdef HAVE_SERVER_PYTHON_PLUGINS
+    QgsAccessControl *accessControl = serverIface->accessControls();
+    if ( accessControl && !accessControl->fillCacheKey( cacheKeyList ) )
+      return nullptr;
+#endif
+
+    const QString cacheKey = cacheKeyList.join( QStringLiteral( "&" ) );
+    auto tileKey = [&cacheKey]( qint64 a, qint64 b )
+    {
+      return cacheKey + QStringLiteral( "&%1,%2" ).arg( a ).arg( b );
+    };
+
+    QgsServerTileCache *cache = serverIface->tileCache();
+    QImage cached = cache->tile( projectPath, tileKey( tileA, tileB ) );
+    if ( !cached.isNull() )
+      return new QImage( cached );
+
+    // the metatile must fit in the maximum size allowed by the project
+    const int width = params.value( QStringLiteral( "WIDTH" ) ).toInt();
+    const int height = params.value( QStringLiteral( "HEIGHT" ) ).toInt();
+    int metatileSize = serverIface->serverSettings()->metatileSize();
+    const int maxWidth = QgsServerProjectUtils::wmsMaxWidth( *project );
+    const int maxHeight = QgsServerProjectUtils::wmsMaxHeight( *project );
+    if ( maxWidth != -1 )
+      metatileSize = std::min( metatileSize, maxWidth / width );
+    if ( maxHeight != -1 )
+      metatileSize = std::min( metatileSize, maxHeight / height );
+    metatileSize = std::max( metatileSize, 1 );
+
+    const qint64 metaA = floorDiv( tileA, metatileSize ) * metatileSize;
+    const qint64 metaB = floorDiv( tileB, metatileSize ) * metatileSize;
+
+    // concurrent requests for the tiles of the metatile wait until it is rendered,
+    // then get their tile from the cache
+    TileLocker locker( cache, projectPath, tileKey( metaA, metaB ) + QStringLiteral( "&metatile=%1" ).arg( metatileSize ) );
+    cached = cache->tile( projectPath, tileKey( tileA, tileB ) );
+    if ( !cached.isNull() )
+      return new QImage( cached );
+
+    QgsServerRequest::Parameters metaParams = params;
+    metaParams[ QStringLiteral( "BBOX" )] = QStringLiteral( "%1,%2,%3,%4" )
+                                            .arg( qgsDoubleToString( metaA * spanA, 17 ), qgsDoubleToString( metaB * spanB, 17 ),
+                                                qgsDoubleToString( ( metaA + metatileSize ) * spanA, 17 ),
+                                                qgsDoubleToString( ( metaB + metatileSize ) * spanB, 17 ) );
+    metaParams[ QStringLiteral( "WIDTH" )] = QString::number( width * metatileSize );
+    metaParams[ QStringLiteral( "HEIGHT" )] = QString::number( height * metatileSize );
+
+    QgsRenderer renderer( serverIface, project, metaParams, getConfigParser( serverIface ) );
+    std::unique_ptr<QImage> metatile( renderer.getMap() );
+    if ( !metatile || metatile->width() != width * metatileSize || metatile->height() != height * metatileSize )
+      return nullptr;
+
+    // image rows go downwards, map axes upwards
+    const bool horizontal = firstAxisHorizontal( QgsWmsParameters( params ) );
+    QImage *result = nullptr;
+    for ( int i = 0; i < metatileSize; ++i )
+    {
+      for ( int j = 0; j < metatileSize; ++j )
+      {
+        int column = horizontal ? i : j;
+        int row = metatileSize - 1 - ( horizontal ? j : i );
+        QImage slice = metatile->copy( column * width, row * height, width, height );
+        cache->insertTile( projectPath, tileKey( metaA + i, metaB + j ), slice );
+        if ( metaA + i == tileA && metaB + j == tileB )
+          result = new QImage( slice );
+      }
+    }
+    return result;
+  }
+
   void writeGetMap( QgsServerInterface *serverIface, const QgsProject *project,
                     const QString &version, const QgsServerRequest &request,
                     QgsServerResponse &response )
@@ -36,7 +223,12 @@ namespace QgsWms
     QgsServerRequest::Parameters params = request.parameters();
     QgsRenderer renderer( serverIface, project, params, getConfigParser( serverIface ) );
 
-    std::unique_ptr<QImage> result( renderer.getMap() );
+    std::unique_ptr<QImage> result;
+    if ( serverIface->serverSettings()->metatileSize() > 0 )
+      result.reset( getCachedTile( serverIface, project, params ) );
+    if ( !result )
+      result.reset( renderer.getMap() );
+
     if ( result )
     {
       QString format = params.value( QStringLiteral( "FORMAT" ), QStringLiteral( "PNG" ) );
@@ -0,0 +1,148 @@
+/***************************************************************************
+    qgsexpressionbench.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Compares the tree interpreter of QgsExpression with the bytecode evaluator
+ * working on QgsFeatureBatch, using filters typical for rule based renderers.
+ *
+ * Usage: qgis_expression_bench [feature count] [batch size]
+ */
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "qgsapplication.h"
+#include "qgsexpression.h"
+#include "qgsexpressioncontext.h"
+#include "qgsfeature.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfields.h"
+
+static QgsFields benchFields()
+{
+  QgsFields fields;
+  fields.append( QgsField( QStringLiteral( "type" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "lanes" ), QVariant::Int ) );
+  fields.append( QgsField( QStringLiteral( "pop" ), QVariant::Double ) );
+  fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "class" ), QVariant::String ) );
+  fields.append( QgsField( QStringLiteral( "area" ), QVariant::Double ) );
+  return fields;
+}
+
+static QList<QgsFeature> benchFeatures( const QgsFields &fields, int count )
+{
+  const QStringList types = QStringList() << QStringLiteral( "road" ) << QStringLiteral( "path" ) << QStringLiteral( "rail" ) << QStringLiteral( "river" );
+  const QStringList names = QStringList() << QStringLiteral( "a" ) << QStringLiteral( "b" ) << QStringLiteral( "c" ) << QStringLiteral( "d" ) << QStringLiteral( "e" );
+
+  QList<QgsFeature> features;
+  features.reserve( count );
+  qsrand( 1 );
+  for ( int i = 0; i < count; ++i )
+  {
+    QgsFeature f( fields, i );
+    f.setAttribute( 0, types.at( qrand() % types.count() ) );
+    f.setAttribute( 1, qrand() % 6 );
+    f.setAttribute( 2, static_cast< double >( qrand() % 100000 ) );
+    f.setAttribute( 3, names.at( qrand() % names.count() ) );
+    f.setAttribute( 4, qrand() % 3 == 0 ? QVariant( QVariant::String ) : QVariant( QStringLiteral( "class%1" ).arg( i % 10 ) ) );
+    f.setAttribute( 5, qrand() % 10000 + 0.5 );
+    features << f;
+  }
+  return features;
+}
+
+int main( int argc, char *argv[] )
+{
+  int featureCount = argc > 1 ? atoi( argv[1] ) : 200000;
+  int batchSize = argc > 2 ? atoi( argv[2] ) : 1024;
+  if ( featureCount <= 0 || batchSize <= 0 )
+  {
+    fprintf( stderr, "Usage: %s [feature count] [batch size]\n", argv[0] );
+    return 1;
+  }
+
+  QgsApplication app( argc, argv, false );
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  const QgsFields fields = benchFields();
+  const QList<QgsFeature> features = benchFeatures( fields, featureCount );
+
+  QList<QgsFeatureBatch> batches;
+  QgsAttributeList attributes = fields.allAttributesList();
+  for ( int i = 0; i < features.count(); ++i )
+  {
+    if ( i % batchSize == 0 )
+      batches << QgsFeatureBatch( fields, attributes, false );
+    batches.last().appendFeature( features.at( i ) );
+  }
+
+  const QStringList filters = QStringList()
+                              << QStringLiteral( "\"type\" = 'road' AND \"lanes\" >= 2" )
+                              << QStringLiteral( "\"pop\" > 10000 OR \"name\" IN ('a', 'b')" )
+                              << QStringLiteral( "\"class\" IS NULL" )
+                              << QStringLiteral( "\"area\" / 1000 > 5 AND NOT \"type\" = 'rail'" )
+                              << QStringLiteral( "\"lanes\" * 2 + 1 BETWEEN 3 AND 7" )
+                              << QStringLiteral( "\"type\" || '_' || \"name\" = 'road_a'" )
+                              << QStringLiteral( "upper(\"name\") = 'A' AND \"pop\" < 50000" );
+
+  printf( "%d features, batches of %d\n\n", featureCount, batchSize );
+  printf( "%-48s %10s %10s %8s %s\n", "filter", "tree [ms]", "batch [ms]", "speedup", "" );
+
+  bool allMatch = true;
+  Q_FOREACH ( const QString &filter, filters )
+  {
+    QgsExpressionContext context;
+    context.setFields( fields );
+
+    QgsExpression treeExpression( filter );
+    treeExpression.prepare( &context );
+    QgsExpression batchExpression( filter );
+    batchExpression.prepare( &context );
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<bool> treeResult;
+    treeResult.reserve( features.count() );
+    Q_FOREACH ( const QgsFeature &f, features )
+    {
+      context.setFeature( f );
+      treeResult << treeExpression.evaluate( &context ).toBool();
+    }
+    qint64 treeTime = timer.elapsed();
+
+    timer.restart();
+    QVector<bool> batchResult;
+    batchResult.reserve( features.count() );
+    Q_FOREACH ( const QgsFeatureBatch &batch, batches )
+    {
+      batchResult << batchExpression.evaluateFilter( batch, &context );
+    }
+    qint64 batchTime = timer.elapsed();
+
+    bool match = treeResult == batchResult;
+    allMatch = allMatch && match;
+    printf( "%-48s %10lld %10lld %7.1fx %s\n", filter.toUtf8().constData(),
+            static_cast< long long >( treeTime ), static_cast< long long >( batchTime ),
+            batchTime > 0 ? static_cast< double >( treeTime ) / batchTime : 0.0,
+            match ? "" : "MISMATCH" );
+  }
+
+  QgsApplication::exitQgis();
+  return allMatch ? 0 : 2;
+}
@@ -0,0 +1,286 @@
+/***************************************************************************
+    qgsgeometrybench.cpp
+    ---------------------
+    begin                : October 2017
+    copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+/*
+ * Times the geometry operations of the rendering path on line strings, comparing
+ * vertex by vertex loops through the QgsCurve interface with the bulk kernels
+ * working on the coordinate arrays of QgsLineString.
+ *
+ * Usage: qgis_geometry_bench [vertex count] [vertices per line]
+ */
+
+#include <QElapsedTimer>
+#include <QTransform>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+
+#include "qgsapplication.h"
+#include "qgsclipper.h"
+#include "qgslinestring.h"
+#include "qgsmaptopixel.h"
+#include "qgsrectangle.h"
+
+static QList<QgsLineString> benchLines( int vertexCount, int lineSize )
+{
+  QList<QgsLineString> lines;
+  qsrand( 1 );
+  for ( int start = 0; start < vertexCount; start += lineSize )
+  {
+    const int count = std::min( lineSize, vertexCount - start );
+    QVector<double> x( count );
+    QVector<double> y( count );
+    double px = qrand() % 100000;
+    double py = qrand() % 100000;
+    for ( int i = 0; i < count; ++i )
+    {
+      px += qrand() % 21 - 10;
+      py += qrand() % 21 - 10;
+      x[i] = px;
+      y[i] = py;
+    }
+    lines << QgsLineString( x, y );
+  }
+  return lines;
+}
+
+//! Times \a function, which returns a checksum of its results
+static qint64 timed( const std::function< double() > &function, double &checksum )
+{
+  QElapsedTimer timer;
+  timer.start();
+  checksum = function();
+  return timer.elapsed();
+}
+
+static double polygonChecksum( const QPolygonF &polygon )
+{
+  return polygon.isEmpty() ? 0 : polygon.size() + polygon.first().x() + polygon.last().y();
+}
+
+int main( int argc, char *argv[] )
+{
+  int vertexCount = argc > 1 ? atoi( argv[1] ) : 10000000;
+  int lineSize = argc > 2 ? atoi( argv[2] ) : 1000;
+  if ( vertexCount <= 0 || lineSize <= 1 )
+  {
+    fprintf( stderr, "Usage: %s [vertex count] [vertices per line]\n", argv[0] );
+    return 1;
+  }
+
+  QgsApplication app( argc, argv, false );
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  const QList<QgsLineString> lines = benchLines( vertexCount, lineSize );
+  QgsRectangle extent;
+  extent.setMinimal();
+  Q_FOREACH ( const QgsLineString &line, lines )
+    extent.combineExtentWith( line.boundingBox() );
+
+  const QgsMapToPixel mtp( extent.width() / 1000, extent.center().x(), extent.center().y(), 1000, 1000, 15 );
+  const QTransform matrix = QTransform().rotate( 10 ).scale( 0.5, 2 ).translate( 100, -100 );
+  QgsRectangle halfExtent = extent;
+  halfExtent.scale( 0.5 );
+
+  printf( "%d vertices, lines of %d vertices\n\n", vertexCount, lineSize );
+  printf( "%-28s %12s %12s %8s %s\n", "operation", "vertex [ms]", "kernel [ms]", "speedup", "" );
+
+  struct Operation
+  {
+    const char *name;
+    std::function< double() > vertexByVertex;
+    std::function< double() > kernel;
+  };
+
+  QList<Operation> operations;
+  operations << Operation
+  {
+    "bounding box",
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        const QgsCurve &curve = line;
+        double xmin = std::numeric_limits<double>::max(), xmax = -std::numeric_limits<double>::max();
+        for ( int i = 0; i < curve.numPoints(); ++i )
+        {
+          xmin = std::min( xmin, curve.xAt( i ) );
+          xmax = std::max( xmax, curve.xAt( i ) );
+        }
+        sum += xmax - xmin;
+      }
+      return sum;
+    },
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QgsLineString copy( line ); // no cached bounding box
+        sum += copy.boundingBox().width();
+      }
+      return sum;
+    }
+  };
+  operations << Operation
+  {
+    "length",
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        for ( int i = 1; i < line.numPoints(); ++i )
+          sum += line.pointN( i ).distance( line.pointN( i - 1 ) );
+      }
+      return sum;
+    },
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+        sum += line.length();
+      return sum;
+    }
+  };
+  operations << Operation
+  {
+    "transform by matrix",
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QgsLineString copy( line );
+        for ( int i = 0; i < copy.numPoints(); ++i )
+        {
+          qreal x, y;
+          matrix.map( copy.xAt( i ), copy.yAt( i ), &x, &y );
+          copy.setXAt( i, x );
+          copy.setYAt( i, y );
+        }
+        sum += copy.xAt( copy.numPoints() - 1 );
+      }
+      return sum;
+    },
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QgsLineString copy( line );
+        copy.transform( matrix );
+        sum += copy.xAt( copy.numPoints() - 1 );
+      }
+      return sum;
+    }
+  };
+  operations << Operation
+  {
+    "to QPolygonF",
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        const QgsCurve &curve = line;
+        QPolygonF polygon;
+        polygon.reserve( curve.numPoints() );
+        for ( int i = 0; i < curve.numPoints(); ++i )
+          polygon << QPointF( curve.xAt( i ), curve.yAt( i ) );
+        sum += polygonChecksum( polygon );
+      }
+      return sum;
+    },
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+        sum += polygonChecksum( line.asQPolygonF() );
+      return sum;
+    }
+  };
+  operations << Operation
+  {
+    "map to pixel",
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QPolygonF polygon = line.asQPolygonF();
+        QPointF *ptr = polygon.data();
+        for ( int i = 0; i < polygon.size(); ++i, ++ptr )
+          mtp.transformInPlace( ptr->rx(), ptr->ry() );
+        sum += polygonChecksum( polygon );
+      }
+      return sum;
+    },
+    [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QPolygonF polygon = line.asQPolygonF();
+        mtp.transformInPlace( polygon );
+        sum += polygonChecksum( polygon );
+      }
+      return sum;
+    }
+  };
+
+  bool allMatch = true;
+  Q_FOREACH ( const Operation &operation, operations )
+  {
+    double vertexChecksum = 0;
+    double kernelChecksum = 0;
+    qint64 vertexTime = timed( operation.vertexByVertex, vertexChecksum );
+    qint64 kernelTime = timed( operation.kernel, kernelChecksum );
+
+    bool match = std::fabs( vertexChecksum - kernelChecksum ) <= 1e-6 * std::max( 1.0, std::fabs( vertexChecksum ) );
+    allMatch = allMatch && match;
+    printf( "%-28s %12lld %12lld %7.1fx %s\n", operation.name,
+            static_cast< long long >( vertexTime ), static_cast< long long >( kernelTime ),
+            kernelTime > 0 ? static_cast< double >( vertexTime ) / kernelTime : 0.0,
+            match ? "" : "MISMATCH" );
+  }
+
+  // clipping has no vertex by vertex counterpart any more, only the two paths are timed
+  printf( "\n%-28s %12s\n", "clipping", "[ms]" );
+  Q_FOREACH ( const QgsRectangle &clipExtent, QList<QgsRectangle>() << extent << halfExtent )
+  {
+    double checksum = 0;
+    qint64 time = timed( [&]()
+    {
+      double sum = 0;
+      Q_FOREACH ( const QgsLineString &line, lines )
+      {
+        QPolygonF polygon = QgsClipper::clippedLine( line, clipExtent );
+        mtp.transformInPlace( polygon );
+        sum += polygon.size();
+      }
+      return sum;
+    }, checksum );
+    printf( "%-28s %12lld\n", clipExtent == extent ? "inside of the extent" : "crossing the extent", static_cast< long long >( time ) );
+  }
+
+  QgsApplication::exitQgis();
+  return allMatch ? 0 : 2;
+}
@@ -0,0 +1,199 @@
+/***************************************************************************
+  testqgsgraphanalyzer.cpp
+  ------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+//header for class being tested
+#include "qgsgraphanalyzer.h"
+#include "qgsgraph.h"
+#include "qgscsrgraph.h"
+#include "qgscontractionhierarchy.h"
+#include "qgstestutils.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+
+class TestQgsGraphAnalyzer : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void csrGraph();
+    void dijkstra();
+    void costMatrix();
+    void contractionHierarchy();
+
+  private:
+
+    //! Creates a grid network with one way streets and some long distance links
+    QgsGraph *createGraph( int size );
+};
+
+void TestQgsGraphAnalyzer::initTestCase()
+{
+}
+
+void TestQgsGraphAnalyzer::cleanupTestCase()
+{
+}
+
+QgsGraph *TestQgsGraphAnalyzer::createGraph( int size )
+{
+  QgsGraph *graph = new QgsGraph();
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+      graph->addVertex( QgsPointXY( x, y ) );
+  }
+
+  for ( int y = 0; y < size; ++y )
+  {
+    for ( int x = 0; x < size; ++x )
+    {
+      int v = y * size + x;
+      double cost = 1 + ( x * 7 + y * 3 ) % 5;
+      if ( x + 1 < size )
+      {
+        graph->addEdge( v, v + 1, QVector< QVariant >() << cost << 1.0 );
+        if ( ( x + y ) % 4 != 0 )
+          graph->addEdge( v + 1, v, QVector< QVariant >() << cost + 1 << 1.0 );
+      }
+      if ( y + 1 < size )
+      {
+        graph->addEdge( v, v + size, QVector< QVariant >() << cost << 1.0 );
+        graph->addEdge( v + size, v, QVector< QVariant >() << cost << 1.0 );
+      }
+      if ( v % 13 == 0 )
+        graph->addEdge( v, ( v * 31 ) % ( size * size ), QVector< QVariant >() << 4.0 << 1.0 );
+    }
+  }
+  return graph;
+}
+
+void TestQgsGraphAnalyzer::csrGraph()
+{
+  std::unique_ptr< QgsGraph > graph( createGraph( 5 ) );
+  QgsCsrGraph csr( graph.get(), 0 );
+  QCOMPARE( csr.vertexCount(), graph->vertexCount() );
+  QCOMPARE( csr.edgeCount(), graph->edgeCount() );
+
+  for ( int v = 0; v < csr.vertexCount(); ++v )
+  {
+    QgsGraphEdgeIds outEdges = graph->vertex( v ).outEdges();
+    QCOMPARE( csr.endEdge( v ) - csr.firstEdge( v ), outEdges.count() );
+    for ( int e = csr.firstEdge( v ); e < csr.endEdge( v ); ++e )
+    {
+      const QgsGraphEdge &edge = graph->edge( csr.sourceEdge( e ) );
+      QCOMPARE( edge.outVertex(), v );
+      QCOMPARE( csr.edgeTarget( e ), edge.inVertex() );
+      QCOMPARE( csr.edgeCost( e ), edge.cost( 0 ).toDouble() );
+    }
+  }
+
+  QgsCsrGraph second( graph.get(), 1 );
+  QCOMPARE( second.edgeCost( 0 ), 1.0 );
+}
+
+void TestQgsGraphAnalyzer::dijkstra()
+{
+  std::unique_ptr< QgsGraph > graph( createGraph( 10 ) );
+  QgsCsrGraph csr( graph.get(), 0 );
+
+  QVector<int> tree;
+  QVector<double> costs;
+  QgsGraphAnalyzer::dijkstra( graph.get(), 12, 0, &tree, &costs );
+
+  QVector<int> csrTree;
+  QVector<double> csrCosts;
+  QgsGraphAnalyzer::dijkstra( &csr, 12, &csrTree, &csrCosts );
+
+  QCOMPARE( csrCosts, costs );
+  QCOMPARE( csrTree.count(), tree.count() );
+  QCOMPARE( csrTree.at( 12 ), -1 );
+  for ( int v = 0; v < csrTree.count(); ++v )
+  {
+    if ( v == 12 )
+      continue;
+    // trees may differ for paths of equal cost, but must be consistent with the costs
+    const QgsGraphEdge &edge = graph->edge( csrTree.at( v ) );
+    QCOMPARE( edge.inVertex(), v );
+    QCOMPARE( csrCosts.at( edge.outVertex() ) + edge.cost( 0 ).toDouble(), csrCosts.at( v ) );
+  }
+}
+
+void TestQgsGraphAnalyzer::costMatrix()
+{
+  std::unique_ptr< QgsGraph > graph( createGraph( 10 ) );
+  QgsCsrGraph csr( graph.get(), 0 );
+
+  QVector<int> origins = QVector<int>() << 0 << 55 << 99 << 55;
+  QVector<int> destinations = QVector<int>() << 99 << 0 << 42 << 42 << 7;
+  QVector<double> matrix = QgsGraphAnalyzer::costMatrix( &csr, origins, destinations );
+  QCOMPARE( matrix.count(), origins.count() * destinations.count() );
+
+  for ( int i = 0; i < origins.count(); ++i )
+  {
+    QVector<double> costs;
+    QgsGraphAnalyzer::dijkstra( &csr, origins.at( i ), nullptr, &costs );
+    for ( int j = 0; j < destinations.count(); ++j )
+      QCOMPARE( matrix.at( i * destinations.count() + j ), costs.at( destinations.at( j ) ) );
+  }
+
+  // unreachable vertex and invalid indexes
+  graph->addVertex( QgsPointXY( 100, 100 ) );
+  QgsCsrGraph disconnected( graph.get(), 0 );
+  matrix = QgsGraphAnalyzer::costMatrix( &disconnected, QVector<int>() << 0 << -1, QVector<int>() << 100 << 1 );
+  QVERIFY( std::isinf( matrix.at( 0 ) ) );
+  QCOMPARE( matrix.at( 1 ), 1.0 );
+  QVERIFY( std::isinf( matrix.at( 2 ) ) );
+  QVERIFY( std::isinf( matrix.at( 3 ) ) );
+}
+
+void TestQgsGraphAnalyzer::contractionHierarchy()
+{
+  std::unique_ptr< QgsGraph > graph( createGraph( 20 ) );
+  graph->addVertex( QgsPointXY( 100, 100 ) );
+  QgsCsrGraph csr( graph.get(), 0 );
+
+  QgsContractionHierarchy hierarchy( csr );
+  QVERIFY( hierarchy.isValid() );
+  QCOMPARE( hierarchy.vertexCount(), csr.vertexCount() );
+
+  QVector<int> vertices;
+  for ( int v = 0; v < csr.vertexCount(); v += 17 )
+    vertices << v;
+  vertices << csr.vertexCount() - 1;
+
+  QVector<double> expected = QgsGraphAnalyzer::costMatrix( &csr, vertices, vertices );
+  QVector<double> matrix = hierarchy.costMatrix( vertices, vertices );
+  QCOMPARE( matrix.count(), expected.count() );
+  for ( int i = 0; i < matrix.count(); ++i )
+  {
+    if ( std::isinf( expected.at( i ) ) )
+      QVERIFY( std::isinf( matrix.at( i ) ) );
+    else
+      QGSCOMPARENEAR( matrix.at( i ), expected.at( i ), 1e-9 );
+  }
+
+  QVector<double> costs;
+  QgsGraphAnalyzer::dijkstra( &csr, 3, nullptr, &costs );
+  QGSCOMPARENEAR( hierarchy.cost( 3, 398 ), costs.at( 398 ), 1e-9 );
+  QCOMPARE( hierarchy.cost( 3, 3 ), 0.0 );
+  QVERIFY( std::isinf( hierarchy.cost( 3, 400 ) ) );
+}
+
+QGSTEST_MAIN( TestQgsGraphAnalyzer )
+#include "testqgsgraphanalyzer.moc"
@@ -0,0 +1,166 @@
+/***************************************************************************
+  testqgsninecellfilters.cpp
+  --------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsslopefilter.h"
+#include "qgshillshadefilter.h"
+
+#include <QTemporaryDir>
+
+#include <cmath>
+#include <vector>
+
+#include "gdal.h"
+#include "cpl_string.h"
+
+class TestQgsNineCellFilters : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void slope();
+    void hillshade();
+
+  private:
+
+    //! Checks the output of a filter against the windows computed cell by cell, with one or several threads
+    void checkFilter( QgsNineCellFilter &filter, const QString &outputFile );
+
+    //! Reads the first band of a raster
+    static std::vector< float > readRaster( const QString &fileName );
+
+    QTemporaryDir mDir;
+    QString mDemFile;
+};
+
+// large enough to be computed in several strips and batches
+const int DEM_WIDTH = 2050;
+const int DEM_HEIGHT = 1100;
+const float DEM_NODATA = -9999;
+
+void TestQgsNineCellFilters::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+  GDALAllRegister();
+
+  // tiled DEM, so that strips are aligned to blocks smaller than the raster
+  mDemFile = mDir.path() + "/dem.tif";
+  char **options = nullptr;
+  options = CSLSetNameValue( options, "TILED", "YES" );
+  options = CSLSetNameValue( options, "BLOCKXSIZE", "64" );
+  options = CSLSetNameValue( options, "BLOCKYSIZE", "32" );
+  GDALDatasetH dataset = GDALCreate( GDALGetDriverByName( "GTiff" ), mDemFile.toUtf8().constData(), DEM_WIDTH, DEM_HEIGHT, 1, GDT_Float32, options );
+  CSLDestroy( options );
+  QVERIFY( dataset );
+
+  double geotransform[] = { 1000, 10, 0, 5000, 0, -10 };
+  GDALSetGeoTransform( dataset, geotransform );
+  GDALRasterBandH band = GDALGetRasterBand( dataset, 1 );
+  GDALSetRasterNoDataValue( band, DEM_NODATA );
+
+  std::vector< float > values( DEM_WIDTH * DEM_HEIGHT );
+  for ( int y = 0; y < DEM_HEIGHT; ++y )
+  {
+    for ( int x = 0; x < DEM_WIDTH; ++x )
+    {
+      float z = 100 + 0.02 * x * x + 0.5 * y + 20 * std::sin( x / 7.0 ) * std::cos( y / 11.0 );
+      values[ y * DEM_WIDTH + x ] = ( x * 7 + y * 3 ) % 97 == 0 ? DEM_NODATA : z;
+    }
+  }
+  QCOMPARE( GDALRasterIO( band, GF_Write, 0, 0, DEM_WIDTH, DEM_HEIGHT, values.data(), DEM_WIDTH, DEM_HEIGHT, GDT_Float32, 0, 0 ), CE_None );
+  GDALClose( dataset );
+}
+
+void TestQgsNineCellFilters::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+std::vector< float > TestQgsNineCellFilters::readRaster( const QString &fileName )
+{
+  std::vector< float > values;
+  GDALDatasetH dataset = GDALOpen( fileName.toUtf8().constData(), GA_ReadOnly );
+  if ( !dataset )
+    return values;
+
+  int xSize = GDALGetRasterXSize( dataset );
+  int ySize = GDALGetRasterYSize( dataset );
+  values.resize( xSize * ySize );
+  if ( GDALRasterIO( GDALGetRasterBand( dataset, 1 ), GF_Read, 0, 0, xSize, ySize, values.data(), xSize, ySize, GDT_Float32, 0, 0 ) != CE_None )
+    values.clear();
+  GDALClose( dataset );
+  return values;
+}
+
+void TestQgsNineCellFilters::checkFilter( QgsNineCellFilter &filter, const QString &outputFile )
+{
+  int maxThreads = QgsApplication::maxThreads();
+  QList< std::vector< float > > results;
+  Q_FOREACH ( int threads, QList<int>() << 1 << -1 )
+  {
+    QgsApplication::setMaxThreads( threads );
+    QCOMPARE( filter.processRaster(), 0 );
+    results << readRaster( outputFile );
+  }
+  QgsApplication::setMaxThreads( maxThreads );
+
+  // expected values, with nodata outside of the raster
+  std::vector< float > dem = readRaster( mDemFile );
+  QCOMPARE( static_cast< int >( dem.size() ), DEM_WIDTH * DEM_HEIGHT );
+  float nodata = DEM_NODATA;
+  auto cell = [&]( int x, int y ) -> float *
+  {
+    if ( x < 0 || y < 0 || x >= DEM_WIDTH || y >= DEM_HEIGHT )
+      return &nodata;
+    return &dem[ y * DEM_WIDTH + x ];
+  };
+
+  for ( const std::vector< float > &result : results )
+  {
+    QCOMPARE( result.size(), dem.size() );
+    for ( int y = 0; y < DEM_HEIGHT; ++y )
+    {
+      for ( int x = 0; x < DEM_WIDTH; ++x )
+      {
+        float expected = filter.processNineCellWindow( cell( x - 1, y - 1 ), cell( x, y - 1 ), cell( x + 1, y - 1 ),
+                         cell( x - 1, y ), cell( x, y ), cell( x + 1, y ),
+                         cell( x - 1, y + 1 ), cell( x, y + 1 ), cell( x + 1, y + 1 ) );
+        if ( result[ y * DEM_WIDTH + x ] != expected )
+          QCOMPARE( result[ y * DEM_WIDTH + x ], expected );
+      }
+    }
+  }
+}
+
+void TestQgsNineCellFilters::slope()
+{
+  QString outputFile = mDir.path() + "/slope.tif";
+  QgsSlopeFilter filter( mDemFile, outputFile, QStringLiteral( "GTiff" ) );
+  checkFilter( filter, outputFile );
+}
+
+void TestQgsNineCellFilters::hillshade()
+{
+  QString outputFile = mDir.path() + "/hillshade.tif";
+  QgsHillshadeFilter filter( mDemFile, outputFile, QStringLiteral( "GTiff" ), 315, 45 );
+  filter.setZFactor( 2 );
+  checkFilter( filter, outputFile );
+}
+
+QGSTEST_MAIN( TestQgsNineCellFilters )
+#include "testqgsninecellfilters.moc"
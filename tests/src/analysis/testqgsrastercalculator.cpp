@@ -23,6 +23,8 @@ Email                : nyall dot dawson at gmail dot com
 #include "qgsproject.h"
 #include "qgstestutils.h"
 
+#include <memory>
+
 Q_DECLARE_METATYPE( QgsRasterCalcNode::Operator )
 
 class TestQgsRasterCalculator : public QObject
@@ -54,6 +56,7 @@ class TestQgsRasterCalculator : public QObject
 
     void rasterRefOp();
     void dualOpRasterRaster(); //test dual op on raster ref and raster ref
+    void calculatePixelRasterRefs(); //test per pixel evaluation of raster refs
 
     void calcWithLayers();
     void calcWithReprojectedLayers();
@@ -164,6 +167,9 @@ void TestQgsRasterCalculator::dualOp()
   qDebug() << "Result: " << result.number() << " expected: " << expected;
   QCOMPARE( result.number(), expected );
 
+  // per pixel evaluation
+  QCOMPARE( node.calculatePixel( nullptr, -9999 ), expected );
+
 }
 
 void TestQgsRasterCalculator::singleOp_data()
@@ -214,6 +220,9 @@ void TestQgsRasterCalculator::singleOp()
   qDebug() << "Result: " << result.number() << " expected: " << expected;
   QGSCOMPARENEAR( result.number(), expected, 0.0000000001 );
 
+  // per pixel evaluation
+  QGSCOMPARENEAR( node.calculatePixel( nullptr, -9999 ), expected, 0.0000000001 );
+
 }
 
 void TestQgsRasterCalculator::singleOpMatrices()
@@ -421,6 +430,24 @@ void TestQgsRasterCalculator::dualOpRasterRaster()
   QCOMPARE( result.data()[5], -9999.0 );
 }
 
+void TestQgsRasterCalculator::calculatePixelRasterRefs()
+{
+  QString error;
+  std::unique_ptr< QgsRasterCalcNode > node( QgsRasterCalcNode::parseRasterCalcString( QStringLiteral( "\"raster2@1\" - \"raster1@1\" * 2" ), error ) );
+  QVERIFY( node );
+
+  // unknown raster
+  QVERIFY( !node->prepareRasterRefs( QStringList() << QStringLiteral( "raster1@1" ) ) );
+
+  QVERIFY( node->prepareRasterRefs( QStringList() << QStringLiteral( "raster1@1" ) << QStringLiteral( "raster2@1" ) ) );
+  double values[] = { 3.0, 10.0 };
+  QCOMPARE( node->calculatePixel( values, -9999 ), 4.0 );
+
+  // nodata operands result in nodata
+  values[1] = -9999;
+  QCOMPARE( node->calculatePixel( values, -9999 ), -9999.0 );
+}
+
 void TestQgsRasterCalculator::calcWithLayers()
 {
   QgsRasterCalculatorEntry entry1;
@@ -22,6 +22,9 @@
 #include "qgsrasterlayer.h"
 #include "qgszonalstatistics.h"
 #include "qgsproject.h"
+#include "qgsvectordataprovider.h"
+
+#include <memory>
 
 /** \ingroup UnitTests
  * This is a unit test for the zonal statistics class
@@ -37,6 +40,7 @@ class TestQgsZonalStatistics : public QObject
     void cleanup() {}
 
     void testStatistics();
+    void testHolesAndMultipart();
 
   private:
     QgsVectorLayer *mVectorLayer = nullptr;
@@ -181,5 +185,56 @@ void TestQgsZonalStatistics::testStatistics()
   QCOMPARE( f.attribute( "myqgis2__4" ).toDouble(), 0.13888888888889 );
 }
 
+void TestQgsZonalStatistics::testHolesAndMultipart()
+{
+  // cells of edge_problem.asc:
+  //  1 1 0 0
+  //  1 1 0 0
+  //  1 1 1 1
+  double left = mRasterLayer->extent().xMinimum();
+  double top = mRasterLayer->extent().yMaximum();
+  double cellSize = mRasterLayer->rasterUnitsPerPixelX();
+  auto ring = [ = ]( double column1, double row1, double column2, double row2 )
+  {
+    QString x1 = qgsDoubleToString( left + column1 * cellSize, 12 );
+    QString x2 = qgsDoubleToString( left + column2 * cellSize, 12 );
+    QString y1 = qgsDoubleToString( top - row1 * cellSize, 12 );
+    QString y2 = qgsDoubleToString( top - row2 * cellSize, 12 );
+    return QStringLiteral( "(%1 %3, %2 %3, %2 %4, %1 %4, %1 %3)" ).arg( x1, x2, y1, y2 );
+  };
+
+  std::unique_ptr< QgsVectorLayer > layer( new QgsVectorLayer( QStringLiteral( "MultiPolygon?crs=%1" ).arg( mRasterLayer->crs().authid() ), QStringLiteral( "zones" ), QStringLiteral( "memory" ) ) );
+  QVERIFY( layer->isValid() );
+
+  // whole raster, with a hole around the center of the cell in the second row and third column
+  QgsFeature withHole;
+  withHole.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon((%1,%2))" ).arg( ring( 0, 0, 4, 3 ), ring( 2.25, 1.25, 2.75, 1.75 ) ) ) );
+  // the top left and bottom right cells
+  QgsFeature multipart;
+  multipart.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon((%1),(%2))" ).arg( ring( 0.1, 0.1, 0.9, 0.9 ), ring( 3.1, 2.1, 3.9, 2.9 ) ) ) );
+  QgsFeatureList features;
+  features << withHole << multipart;
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsZonalStatistics zs( layer.get(), mRasterLayer, QStringLiteral( "z" ), 1, QgsZonalStatistics::Count | QgsZonalStatistics::Sum | QgsZonalStatistics::Median | QgsZonalStatistics::Majority | QgsZonalStatistics::Variety );
+  QCOMPARE( zs.calculateStatistics( nullptr ), 0 );
+
+  QgsFeatureIterator it = layer->getFeatures();
+  QgsFeature f;
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.attribute( "zcount" ).toDouble(), 11.0 );
+  QCOMPARE( f.attribute( "zsum" ).toDouble(), 8.0 );
+  QCOMPARE( f.attribute( "zmedian" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "zmajority" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "zvariety" ).toDouble(), 2.0 );
+
+  QVERIFY( it.nextFeature( f ) );
+  QCOMPARE( f.attribute( "zcount" ).toDouble(), 2.0 );
+  QCOMPARE( f.attribute( "zsum" ).toDouble(), 2.0 );
+  QCOMPARE( f.attribute( "zmedian" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "zmajority" ).toDouble(), 1.0 );
+  QCOMPARE( f.attribute( "zvariety" ).toDouble(), 1.0 );
+}
+
 QGSTEST_MAIN( TestQgsZonalStatistics )
 #include "testqgszonalstatistics.moc"
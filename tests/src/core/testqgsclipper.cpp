@@ -22,6 +22,8 @@
 //header for class being tested
 #include <qgsclipper.h>
 #include <qgspoint.h>
+#include "qgscircularstring.h"
+#include "qgslinestring.h"
 #include "qgslogger.h"
 
 class TestQgsClipper: public QObject
@@ -34,6 +36,7 @@ class TestQgsClipper: public QObject
     void init() {} // will be called before each testfunction is executed.
     void cleanup() {} // will be called after every testfunction.
     void basic();
+    void clippedLine();
   private:
     bool checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect );
 };
@@ -78,6 +81,43 @@ void TestQgsClipper::basic()
   QVERIFY( ! checkBoundingBox( polygon, clipRectInner ) );
 }
 
+void TestQgsClipper::clippedLine()
+{
+  QgsRectangle clipRect( 0, 0, 10, 10 );
+
+  // totally inside, boundary included
+  QgsLineString inside( QVector< double >() << 1 << 5 << 10 << 0, QVector< double >() << 1 << 9 << 10 << 3 );
+  QPolygonF clipped = QgsClipper::clippedLine( inside, clipRect );
+  QCOMPARE( clipped, inside.asQPolygonF() );
+
+  // a single point is not a line
+  QgsLineString single( QVector< double >() << 1, QVector< double >() << 1 );
+  QVERIFY( QgsClipper::clippedLine( single, clipRect ).isEmpty() );
+
+  // crossing the extent
+  QgsLineString crossing( QVector< double >() << -5 << 5 << 15, QVector< double >() << 5 << 5 << 5 );
+  clipped = QgsClipper::clippedLine( crossing, clipRect );
+  QCOMPARE( clipped, QPolygonF() << QPointF( 0, 5 ) << QPointF( 5, 5 ) << QPointF( 10, 5 ) );
+
+  // leaving and entering the extent again, the parts are connected along the boundary
+  QgsLineString outAndIn( QVector< double >() << 2 << 2 << 8 << 8, QVector< double >() << 2 << 20 << 20 << 2 );
+  clipped = QgsClipper::clippedLine( outAndIn, clipRect );
+  QVERIFY( checkBoundingBox( clipped, clipRect ) );
+  QCOMPARE( clipped.first(), QPointF( 2, 2 ) );
+  QCOMPARE( clipped.last(), QPointF( 8, 2 ) );
+
+  // other curves give the same result as line strings through the same points
+  QgsCircularString circular;
+  circular.setPoints( QgsPointSequence() << QgsPoint( -5, 5 ) << QgsPoint( 5, 5 ) << QgsPoint( 15, 5 ) );
+  QCOMPARE( QgsClipper::clippedLine( circular, clipRect ), QgsClipper::clippedLine( crossing, clipRect ) );
+
+  // and so do the points of the line strings
+  QCOMPARE( QgsClipper::clippedLine( inside.asQPolygonF(), clipRect ), inside.asQPolygonF() );
+  QCOMPARE( QgsClipper::clippedLine( crossing.asQPolygonF(), clipRect ), QgsClipper::clippedLine( crossing, clipRect ) );
+  QCOMPARE( QgsClipper::clippedLine( outAndIn.asQPolygonF(), clipRect ), QgsClipper::clippedLine( outAndIn, clipRect ) );
+  QVERIFY( QgsClipper::clippedLine( single.asQPolygonF(), clipRect ).isEmpty() );
+}
+
 bool TestQgsClipper::checkBoundingBox( const QPolygonF &polygon, const QgsRectangle &clipRect )
 {
   QgsRectangle bBox( polygon.boundingRect() );
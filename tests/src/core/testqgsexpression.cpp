@@ -21,6 +21,7 @@
 //header for class being tested
 #include "qgsexpression.h"
 #include "qgsfeature.h"
+#include "qgsfeaturebatch.h"
 #include "qgsfeatureiterator.h"
 #include "qgsfeaturerequest.h"
 #include "qgsgeometry.h"
@@ -33,6 +34,7 @@
 #include "qgsrasterlayer.h"
 #include "qgsproject.h"
 #include "qgsexpressionnodeimpl.h"
+#include "qgsexpressionbytecode.h"
 #include "qgstestutils.h"
 
 static void _parseAndEvalExpr( int arg )
@@ -1267,6 +1269,130 @@ class TestQgsExpression: public QObject
       QCOMPARE( res2.type(), QVariant::Invalid );
     }
 
+    void eval_batch_data()
+    {
+      QTest::addColumn<QString>( "string" );
+      QTest::addColumn<bool>( "compiled" );
+      QTest::addColumn<bool>( "fullyCompiled" );
+
+      QTest::newRow( "field" ) << "\"count\"" << true << true;
+      QTest::newRow( "and" ) << "\"name\" = 'f2' AND \"count\" >= 2" << true << true;
+      QTest::newRow( "or in" ) << "\"value\" > 3 OR \"name\" IN ('f1', 'f4')" << true << true;
+      QTest::newRow( "not in" ) << "\"count\" NOT IN (1, 2, NULL)" << true << true;
+      QTest::newRow( "is null" ) << "\"value\" IS NULL" << true << true;
+      QTest::newRow( "is not" ) << "\"value\" IS NOT 1.5" << true << true;
+      QTest::newRow( "arithmetic" ) << "\"count\" * 2 + 1" << true << true;
+      QTest::newRow( "division" ) << "\"count\" / \"value\"" << true << true;
+      QTest::newRow( "int division" ) << "\"count\" // 3 - 1" << true << true;
+      QTest::newRow( "modulo" ) << "\"count\" % 3 = 0" << true << true;
+      QTest::newRow( "negate" ) << "-\"value\" < -2" << true << true;
+      QTest::newRow( "concat" ) << "\"name\" || '_' || \"name\"" << true << true;
+      QTest::newRow( "add strings" ) << "\"name\" + 'x'" << true << true;
+      QTest::newRow( "add string fields" ) << "\"name\" + \"name\"" << true << true;
+      QTest::newRow( "add strings untyped null" ) << "(\"name\" || NULL) + 'x'" << true << true;
+      QTest::newRow( "big integers" ) << "\"big\" + 2" << true << true;
+      QTest::newRow( "big integer compare" ) << "\"big\" - \"count\" * 2 = 9007199254740993 - \"count\"" << true << true;
+      QTest::newRow( "big negate" ) << "-\"big\" - 1" << true << true;
+      QTest::newRow( "integer overflow" ) << "\"big\" * \"big\"" << true << true;
+      QTest::newRow( "integer modulo" ) << "\"big\" % (\"count\" - 4)" << true << true;
+      QTest::newRow( "string compare" ) << "\"name\" > 'f5'" << true << true;
+      QTest::newRow( "like" ) << "\"name\" LIKE 'f%'" << false << false;
+      QTest::newRow( "function" ) << "upper(\"name\") = 'F3' OR \"count\" > 7" << true << false;
+      QTest::newRow( "static" ) << "\"count\" > 1 + 2" << true << true;
+      QTest::newRow( "null logic" ) << "NOT (\"value\" > 1) AND NULL" << true << true;
+      QTest::newRow( "mixed types" ) << "\"name\" = \"count\"" << false << false;
+    }
+
+    void eval_batch()
+    {
+      QFETCH( QString, string );
+      QFETCH( bool, compiled );
+      QFETCH( bool, fullyCompiled );
+
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "name" ), QVariant::String ) );
+      fields.append( QgsField( QStringLiteral( "count" ), QVariant::Int ) );
+      fields.append( QgsField( QStringLiteral( "value" ), QVariant::Double ) );
+      fields.append( QgsField( QStringLiteral( "big" ), QVariant::LongLong ) );
+
+      QgsFeatureBatch batch( fields, fields.allAttributesList(), false );
+      QgsFeatureList features;
+      for ( int i = 0; i < 10; ++i )
+      {
+        QgsFeature f( fields, i );
+        f.setAttributes( QgsAttributes() << QStringLiteral( "f%1" ).arg( i ) << i << i * 0.5 << Q_INT64_C( 9007199254740993 ) - i );
+        if ( i == 3 )
+          f.setAttribute( 0, QVariant( QVariant::String ) );
+        if ( i == 5 )
+          f.setAttribute( 1, QVariant( QVariant::Int ) );
+        if ( i == 7 )
+          f.setAttribute( 2, QVariant( QVariant::Double ) );
+        features << f;
+        batch.appendFeature( f );
+      }
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+      QgsExpression exp( string );
+      QVERIFY( !exp.hasParserError() );
+      QVERIFY( exp.prepare( &context ) );
+
+      QgsExpressionBytecode bytecode;
+      QCOMPARE( bytecode.compile( const_cast< QgsExpressionNode * >( exp.rootNode() ), fields ), compiled );
+      QCOMPARE( bytecode.isFullyCompiled(), fullyCompiled );
+
+      QVector<QVariant> values = exp.evaluate( batch, &context );
+      QVector<bool> filter = exp.evaluateFilter( batch, &context );
+      QCOMPARE( values.count(), features.count() );
+      QCOMPARE( filter.count(), features.count() );
+
+      QgsExpression reference( string );
+      reference.prepare( &context );
+      for ( int i = 0; i < features.count(); ++i )
+      {
+        context.setFeature( features.at( i ) );
+        QVariant expected = reference.evaluate( &context );
+        QCOMPARE( values.at( i ).isNull(), expected.isNull() );
+        if ( !expected.isNull() )
+          QCOMPARE( values.at( i ).toString(), expected.toString() );
+        QCOMPARE( filter.at( i ), expected.toInt() != 0 );
+      }
+    }
+
+    void eval_batch_lazy_compile()
+    {
+      QgsFields fields;
+      fields.append( QgsField( QStringLiteral( "count" ), QVariant::Int ) );
+
+      QgsExpressionContext context;
+      context.setFields( fields );
+      QgsExpression exp( QStringLiteral( "\"count\" * 2" ) );
+      QVERIFY( exp.prepare( &context ) );
+
+      // evaluating single features never needs the bytecode
+      QgsFeature f( fields, 1 );
+      f.setAttributes( QgsAttributes() << 3 );
+      context.setFeature( f );
+      QCOMPARE( exp.evaluate( &context ).toInt(), 6 );
+
+      QgsFeatureBatch batch( fields, fields.allAttributesList(), false );
+      batch.appendFeature( f );
+      QVector<QVariant> values = exp.evaluate( batch, &context );
+      QCOMPARE( values.count(), 1 );
+      QCOMPARE( values.at( 0 ).toInt(), 6 );
+
+      // copies evaluate batches as well
+      QgsExpression copy( exp );
+      values = copy.evaluate( batch, &context );
+      QCOMPARE( values.count(), 1 );
+      QCOMPARE( values.at( 0 ).toInt(), 6 );
+
+      // preparing again drops the compiled bytecode
+      QVERIFY( exp.prepare( &context ) );
+      values = exp.evaluate( batch, &context );
+      QCOMPARE( values.at( 0 ).toInt(), 6 );
+    }
+
     void eval_feature_id()
     {
       QgsFeature f( 100 );
@@ -0,0 +1,192 @@
+/***************************************************************************
+     testqgsfeaturebatch.cpp
+     -----------------------
+    Date                 : October 2017
+    Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+#include <QObject>
+
+#include "qgsapplication.h"
+#include "qgsfeaturebatch.h"
+#include "qgsfeatureiterator.h"
+#include "qgsgeometry.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+class TestQgsFeatureBatch: public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void appendFeature();
+    void columnTypes();
+    void nextBatch();
+    void nextBatchFiltered();
+
+  private:
+    QgsVectorLayer *mLayer = nullptr;
+};
+
+void TestQgsFeatureBatch::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  mLayer = new QgsVectorLayer( QStringLiteral( "Point?field=name:string&field=count:integer&field=value:double&field=day:date" ), QStringLiteral( "batch" ), QStringLiteral( "memory" ) );
+  QVERIFY( mLayer->isValid() );
+
+  QgsFeatureList features;
+  for ( int i = 0; i < 10; ++i )
+  {
+    QgsFeature f( mLayer->fields() );
+    f.setAttributes( QgsAttributes() << QStringLiteral( "f%1" ).arg( i ) << i << i * 0.5 << QDate( 2017, 10, i + 1 ) );
+    if ( i != 3 )
+      f.setGeometry( QgsGeometry::fromPoint( QgsPointXY( i, 2 * i ) ) );
+    if ( i == 5 )
+      f.setAttribute( 2, QVariant( QVariant::Double ) );
+    features << f;
+  }
+  QVERIFY( mLayer->dataProvider()->addFeatures( features ) );
+}
+
+void TestQgsFeatureBatch::cleanupTestCase()
+{
+  delete mLayer;
+  QgsApplication::exitQgis();
+}
+
+void TestQgsFeatureBatch::appendFeature()
+{
+  QgsFeatureBatch batch( mLayer->fields(), QgsAttributeList() << 2 << 0 );
+  QCOMPARE( batch.columnCount(), 2 );
+  QCOMPARE( batch.columnForField( 2 ), 0 );
+  QCOMPARE( batch.columnForField( 0 ), 1 );
+  QCOMPARE( batch.columnForField( 1 ), -1 );
+  QVERIFY( batch.isEmpty() );
+
+  QgsFeature f( mLayer->fields(), 42 );
+  f.setAttributes( QgsAttributes() << QStringLiteral( "abc" ) << 5 << 1.5 << QDate( 2017, 1, 1 ) );
+  f.setGeometry( QgsGeometry::fromWkt( QStringLiteral( "LineString(0 0, 1 1)" ) ) );
+  batch.appendFeature( f );
+
+  QCOMPARE( batch.count(), 1 );
+  QCOMPARE( batch.id( 0 ), 42LL );
+  QCOMPARE( batch.doubleData( 0 )[0], 1.5 );
+  QCOMPARE( batch.value( 1, 0 ).toString(), QStringLiteral( "abc" ) );
+  QVERIFY( batch.hasGeometry( 0 ) );
+  QCOMPARE( batch.geometry( 0 ).exportToWkt(), QStringLiteral( "LineString (0 0, 1 1)" ) );
+
+  QgsFeature out = batch.feature( 0 );
+  QCOMPARE( out.id(), 42LL );
+  QCOMPARE( out.attribute( 0 ).toString(), QStringLiteral( "abc" ) );
+  QVERIFY( out.attribute( 1 ).isNull() );
+  QCOMPARE( out.attribute( 2 ).toDouble(), 1.5 );
+
+  batch.clear();
+  QVERIFY( batch.isEmpty() );
+  QCOMPARE( batch.columnCount(), 2 );
+}
+
+void TestQgsFeatureBatch::columnTypes()
+{
+  QgsFeatureBatch batch( mLayer->fields(), mLayer->fields().allAttributesList(), false );
+  QCOMPARE( batch.columnType( 0 ), QgsFeatureBatch::String );
+  QCOMPARE( batch.columnType( 1 ), QgsFeatureBatch::Int64 );
+  QCOMPARE( batch.columnType( 2 ), QgsFeatureBatch::Double );
+  QCOMPARE( batch.columnType( 3 ), QgsFeatureBatch::Variant );
+
+  batch.addRow( 1 );
+  QVERIFY( batch.isNull( 0, 0 ) );
+  QVERIFY( batch.isNull( 2, 0 ) );
+  batch.setString( 0, "xyz", 2 );
+  batch.setInt64( 1, 7 );
+  batch.setDouble( 2, 3.25 );
+  batch.setValue( 3, QDate( 2017, 2, 3 ) );
+  QVERIFY( !batch.allocateWkb( 10 ) );
+
+  int length = 0;
+  const char *data = batch.stringData( 0, 0, length );
+  QCOMPARE( QByteArray( data, length ), QByteArray( "xy" ) );
+  QCOMPARE( batch.value( 1, 0 ), QVariant( 7 ) );
+  QCOMPARE( batch.value( 1, 0 ).type(), QVariant::Int );
+  bool ok = false;
+  QCOMPARE( batch.doubleValue( 1, 0, &ok ), 7.0 );
+  QVERIFY( ok );
+  QCOMPARE( batch.value( 3, 0 ).toDate(), QDate( 2017, 2, 3 ) );
+  QVERIFY( !batch.hasGeometry( 0 ) );
+  QVERIFY( !batch.doubleData( 1 ) );
+  QVERIFY( !batch.int64Data( 2 ) );
+}
+
+void TestQgsFeatureBatch::nextBatch()
+{
+  QgsFeatureBatch batch( mLayer->fields(), mLayer->fields().allAttributesList() );
+  QgsFeatureIterator it = mLayer->getFeatures();
+
+  QList<QgsFeature> expected;
+  QgsFeatureIterator expectedIt = mLayer->getFeatures();
+  QgsFeature f;
+  while ( expectedIt.nextFeature( f ) )
+    expected << f;
+  QCOMPARE( expected.count(), 10 );
+
+  int total = 0;
+  int n = 0;
+  while ( ( n = it.nextBatch( batch, 4 ) ) > 0 )
+  {
+    QVERIFY( n <= 4 );
+    QCOMPARE( batch.count(), n );
+    for ( int row = 0; row < n; ++row )
+    {
+      const QgsFeature &e = expected.at( total + row );
+      QCOMPARE( batch.id( row ), e.id() );
+      QCOMPARE( batch.value( 0, row ), e.attribute( 0 ) );
+      QCOMPARE( batch.value( 1, row ), e.attribute( 1 ) );
+      QCOMPARE( batch.isNull( 2, row ), e.attribute( 2 ).isNull() );
+      if ( !e.attribute( 2 ).isNull() )
+        QCOMPARE( batch.doubleData( 2 )[row], e.attribute( 2 ).toDouble() );
+      QCOMPARE( batch.value( 3, row ), e.attribute( 3 ) );
+      QCOMPARE( batch.hasGeometry( row ), e.hasGeometry() );
+      if ( e.hasGeometry() )
+        QCOMPARE( batch.geometry( row ).exportToWkt(), e.geometry().exportToWkt() );
+    }
+    total += n;
+  }
+  QCOMPARE( total, 10 );
+  QVERIFY( batch.isEmpty() );
+}
+
+void TestQgsFeatureBatch::nextBatchFiltered()
+{
+  QgsFeatureBatch batch( mLayer->fields(), QgsAttributeList() << 1 );
+
+  // limit
+  QgsFeatureIterator it = mLayer->getFeatures( QgsFeatureRequest().setLimit( 3 ) );
+  QCOMPARE( it.nextBatch( batch, 2 ), 2 );
+  QCOMPARE( it.nextBatch( batch, 2 ), 1 );
+  QCOMPARE( it.nextBatch( batch, 2 ), 0 );
+
+  // filter expression is evaluated feature by feature
+  it = mLayer->getFeatures( QgsFeatureRequest().setFilterExpression( QStringLiteral( "count >= 6" ) ) );
+  QCOMPARE( it.nextBatch( batch, 100 ), 4 );
+  for ( int row = 0; row < batch.count(); ++row )
+    QVERIFY( batch.int64Data( 0 )[row] >= 6 );
+
+  // filter rect skips features without geometry
+  it = mLayer->getFeatures( QgsFeatureRequest().setFilterRect( QgsRectangle( 2, 4, 4, 8 ) ) );
+  QCOMPARE( it.nextBatch( batch, 100 ), 2 );
+  QCOMPARE( batch.int64Data( 0 )[0] + batch.int64Data( 0 )[1], 6LL );
+}
+
+QGSTEST_MAIN( TestQgsFeatureBatch )
+#include "testqgsfeaturebatch.moc"
@@ -44,6 +44,7 @@
 #include "qgscircularstring.h"
 #include "qgsgeometrycollection.h"
 #include "qgsgeometryfactory.h"
+#include "qgsgeos.h"
 #include "qgstestutils.h"
 
 //qgs unit test utility class
@@ -130,6 +131,8 @@ class TestQgsGeometry : public QObject
 
     void minimalEnclosingCircle( );
 
+    void cachedGeometryEngine();
+
   private:
     //! A helper method to do a render check to see if the geometry op is as expected
     bool renderCheck( const QString &testName, const QString &comment = QLatin1String( QLatin1String( "" ) ), int mismatchCount = 0 );
@@ -5664,6 +5667,84 @@ void TestQgsGeometry::minimalEnclosingCircle()
 
 }
 
+void TestQgsGeometry::cachedGeometryEngine()
+{
+  QgsGeometry square = QgsGeometry::fromWkt( QStringLiteral( "POLYGON((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  QgsGeometry inside = QgsGeometry::fromWkt( QStringLiteral( "POINT(5 5)" ) );
+  QgsGeometry outside = QgsGeometry::fromWkt( QStringLiteral( "POINT(15 5)" ) );
+
+  QgsGeos::clearPreparedGeometryCache();
+  int hits = QgsGeos::preparedGeometryCacheHits();
+  std::unique_ptr< QgsGeometryEngine > engine( QgsGeometry::createGeometryEngine( square, QStringLiteral( "layer" ), 1 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits );
+  QVERIFY( engine->intersects( inside.geometry() ) );
+  QVERIFY( !engine->intersects( outside.geometry() ) );
+
+  // a second engine for the same feature shares the prepared geometry, and preparing it again has no effect
+  std::unique_ptr< QgsGeometryEngine > engine2( QgsGeometry::createGeometryEngine( square, QStringLiteral( "layer" ), 1 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 1 );
+  engine2->prepareGeometry();
+  QVERIFY( engine2->contains( inside.geometry() ) );
+  QVERIFY( !engine2->contains( outside.geometry() ) );
+
+  // as does the feature geometry when it is fetched again, as a new but identical geometry
+  QgsGeometry fetchedAgain = QgsGeometry::fromWkt( QStringLiteral( "POLYGON((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  std::unique_ptr< QgsGeometryEngine > fetchedEngine( QgsGeometry::createGeometryEngine( fetchedAgain, QStringLiteral( "layer" ), 1 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 2 );
+  QVERIFY( fetchedEngine->intersects( inside.geometry() ) );
+
+  // the cached geometry is not used once the feature has changed
+  QgsGeometry moved = square;
+  QCOMPARE( moved.translate( 10, 0 ), QgsGeometry::Success );
+  std::unique_ptr< QgsGeometryEngine > movedEngine( QgsGeometry::createGeometryEngine( moved, QStringLiteral( "layer" ), 1 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 2 );
+  QVERIFY( !movedEngine->intersects( inside.geometry() ) );
+  QVERIFY( movedEngine->intersects( outside.geometry() ) );
+
+  // or when it has been modified in place, behind the same geometry object
+  QgsGeometry edited = QgsGeometry::fromWkt( QStringLiteral( "POLYGON((0 0, 10 0, 10 10, 0 10, 0 0))" ) );
+  std::unique_ptr< QgsGeometryEngine > editedEngine( QgsGeometry::createGeometryEngine( edited, QStringLiteral( "layer" ), 5 ) );
+  QVERIFY( !editedEngine->intersects( QgsGeometry::fromPointXY( QgsPointXY( 12, 12 ) ).geometry() ) );
+  QVERIFY( edited.geometry()->moveVertex( QgsVertexId( 0, 0, 2 ), QgsPoint( 20, 20 ) ) );
+  editedEngine.reset( QgsGeometry::createGeometryEngine( edited, QStringLiteral( "layer" ), 5 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 2 );
+  QVERIFY( editedEngine->intersects( QgsGeometry::fromPointXY( QgsPointXY( 12, 12 ) ).geometry() ) );
+
+  // even if only a z value has changed
+  QgsGeometry square3D = QgsGeometry::fromWkt( QStringLiteral( "POLYGONZ((0 0 1, 10 0 1, 10 10 1, 0 10 1, 0 0 1))" ) );
+  std::unique_ptr< QgsGeometryEngine > engine3D( QgsGeometry::createGeometryEngine( square3D, QStringLiteral( "layer" ), 4 ) );
+  QgsGeometry raised = QgsGeometry::fromWkt( QStringLiteral( "POLYGONZ((0 0 1, 10 0 1, 10 10 2, 0 10 1, 0 0 1))" ) );
+  std::unique_ptr< QgsGeometryEngine > raisedEngine( QgsGeometry::createGeometryEngine( raised, QStringLiteral( "layer" ), 4 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 2 );
+
+  // nor for other features or sources
+  std::unique_ptr< QgsGeometryEngine > otherEngine( QgsGeometry::createGeometryEngine( moved, QStringLiteral( "other layer" ), 1 ) );
+  QVERIFY( otherEngine->intersects( outside.geometry() ) );
+  otherEngine.reset( QgsGeometry::createGeometryEngine( square, QStringLiteral( "layer" ), 2 ) );
+  QVERIFY( !otherEngine->intersects( outside.geometry() ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits + 2 );
+
+  // engines stay valid when the cache is cleared
+  QgsGeos::clearPreparedGeometryCache();
+  QVERIFY( engine->intersects( inside.geometry() ) );
+  QVERIFY( engine2->contains( inside.geometry() ) );
+
+  // and the results are the same without cache
+  int cacheSize = QgsGeos::preparedGeometryCacheSize();
+  QgsGeos::setPreparedGeometryCacheSize( 0 );
+  QCOMPARE( QgsGeos::preparedGeometryCacheSize(), 0 );
+  hits = QgsGeos::preparedGeometryCacheHits();
+  std::unique_ptr< QgsGeometryEngine > uncachedEngine( QgsGeometry::createGeometryEngine( square, QStringLiteral( "layer" ), 1 ) );
+  QCOMPARE( QgsGeos::preparedGeometryCacheHits(), hits );
+  QVERIFY( uncachedEngine->within( QgsGeometry::fromRect( QgsRectangle( -1, -1, 11, 11 ) ).geometry() ) );
+  QVERIFY( !uncachedEngine->intersects( outside.geometry() ) );
+  QgsGeos::setPreparedGeometryCacheSize( cacheSize );
+
+  // null geometries give an engine too
+  QgsGeometry nullGeometry;
+  std::unique_ptr< QgsGeometryEngine > nullEngine( QgsGeometry::createGeometryEngine( nullGeometry, QStringLiteral( "layer" ), 3 ) );
+  QVERIFY( !nullEngine->intersects( inside.geometry() ) );
+}
 
 QGSTEST_MAIN( TestQgsGeometry )
 #include "testqgsgeometry.moc"
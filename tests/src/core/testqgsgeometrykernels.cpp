@@ -0,0 +1,196 @@
+/***************************************************************************
+  testqgsgeometrykernels.cpp
+  --------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsgeometrykernels.h"
+#include "qgslinestring.h"
+#include "qgspolygon.h"
+#include "qgstestutils.h"
+
+#include <QVector>
+
+#include <cmath>
+#include <limits>
+
+class TestQgsGeometryKernels : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void boundingBox();
+    void allInside();
+    void length();
+    void transform_data();
+    void transform();
+    void toPolygon();
+    void lineString();
+
+  private:
+
+    //! Returns the x and y coordinates of a wiggly line with \a count points
+    static void line( int count, QVector< double > &x, QVector< double > &y );
+};
+
+void TestQgsGeometryKernels::line( int count, QVector< double > &x, QVector< double > &y )
+{
+  x.resize( count );
+  y.resize( count );
+  for ( int i = 0; i < count; ++i )
+  {
+    x[i] = 100 + i * 0.5 + 3 * std::sin( i / 7.0 );
+    y[i] = -50 + 10 * std::cos( i / 13.0 );
+  }
+}
+
+void TestQgsGeometryKernels::boundingBox()
+{
+  QVector< double > x, y;
+  line( 1000, x, y );
+
+  double xmin = x.at( 0 ), xmax = x.at( 0 ), ymin = y.at( 0 ), ymax = y.at( 0 );
+  for ( int i = 1; i < x.size(); ++i )
+  {
+    xmin = std::min( xmin, x.at( i ) );
+    xmax = std::max( xmax, x.at( i ) );
+    ymin = std::min( ymin, y.at( i ) );
+    ymax = std::max( ymax, y.at( i ) );
+  }
+  QCOMPARE( QgsGeometryKernels::boundingBox( x.constData(), y.constData(), x.size() ), QgsRectangle( xmin, ymin, xmax, ymax ) );
+
+  // a single point
+  QCOMPARE( QgsGeometryKernels::boundingBox( x.constData(), y.constData(), 1 ), QgsRectangle( x.at( 0 ), y.at( 0 ), x.at( 0 ), y.at( 0 ) ) );
+
+  // NaN coordinates are ignored
+  x[10] = std::numeric_limits< double >::quiet_NaN();
+  y[20] = std::numeric_limits< double >::quiet_NaN();
+  QCOMPARE( QgsGeometryKernels::boundingBox( x.constData(), y.constData(), x.size() ), QgsRectangle( xmin, ymin, xmax, ymax ) );
+}
+
+void TestQgsGeometryKernels::allInside()
+{
+  QVector< double > x, y;
+  line( 1000, x, y );
+  QgsRectangle bbox = QgsGeometryKernels::boundingBox( x.constData(), y.constData(), x.size() );
+
+  // the boundary is inside
+  QVERIFY( QgsGeometryKernels::allInside( x.constData(), y.constData(), x.size(), bbox ) );
+  QVERIFY( QgsGeometryKernels::allInside( x.constData(), y.constData(), 0, QgsRectangle( 0, 0, 1, 1 ) ) );
+
+  // a single point outside, in the last block
+  double lastX = x.last();
+  x.last() = bbox.xMaximum() + 1;
+  QVERIFY( !QgsGeometryKernels::allInside( x.constData(), y.constData(), x.size(), bbox ) );
+  QVERIFY( QgsGeometryKernels::allInside( x.constData(), y.constData(), x.size() - 1, bbox ) );
+  x.last() = lastX;
+
+  y[300] = bbox.yMinimum() - 0.001;
+  QVERIFY( !QgsGeometryKernels::allInside( x.constData(), y.constData(), x.size(), bbox ) );
+  y[300] = std::numeric_limits< double >::quiet_NaN();
+  QVERIFY( !QgsGeometryKernels::allInside( x.constData(), y.constData(), x.size(), bbox ) );
+}
+
+void TestQgsGeometryKernels::length()
+{
+  QVector< double > x, y;
+  line( 1000, x, y );
+
+  double expected = 0;
+  for ( int i = 1; i < x.size(); ++i )
+    expected += std::sqrt( std::pow( x.at( i ) - x.at( i - 1 ), 2 ) + std::pow( y.at( i ) - y.at( i - 1 ), 2 ) );
+  QGSCOMPARENEAR( QgsGeometryKernels::length( x.constData(), y.constData(), x.size() ), expected, 0.0000001 );
+
+  QCOMPARE( QgsGeometryKernels::length( x.constData(), y.constData(), 1 ), 0.0 );
+  QCOMPARE( QgsGeometryKernels::length( x.constData(), y.constData(), 0 ), 0.0 );
+}
+
+void TestQgsGeometryKernels::transform_data()
+{
+  QTest::addColumn< QTransform >( "transform" );
+
+  QTest::newRow( "none" ) << QTransform();
+  QTest::newRow( "translate" ) << QTransform::fromTranslate( 10, -20 );
+  QTest::newRow( "scale" ) << QTransform::fromScale( 2, -0.5 ).translate( 3, 4 );
+  QTest::newRow( "rotate" ) << QTransform().rotate( 30 ).translate( -7, 12 );
+  QTest::newRow( "shear" ) << QTransform().shear( 0.3, -0.1 );
+  QTest::newRow( "project" ) << QTransform( 1, 0, 0.001, 0, 1, 0.002, 5, 6, 1 );
+}
+
+void TestQgsGeometryKernels::transform()
+{
+  QFETCH( QTransform, transform );
+
+  QVector< double > x, y;
+  line( 1000, x, y );
+  QPolygonF polygon = QgsGeometryKernels::toPolygon( x.constData(), y.constData(), x.size() );
+  QVector< double > tx = x, ty = y;
+  QgsGeometryKernels::transform( tx.data(), ty.data(), tx.size(), transform );
+  QgsGeometryKernels::transform( polygon, transform );
+
+  // same results as QTransform::map()
+  for ( int i = 0; i < x.size(); ++i )
+  {
+    qreal mx, my;
+    transform.map( x.at( i ), y.at( i ), &mx, &my );
+    QGSCOMPARENEAR( tx.at( i ), mx, 0.000000001 );
+    QGSCOMPARENEAR( ty.at( i ), my, 0.000000001 );
+    QGSCOMPARENEAR( polygon.at( i ).x(), mx, 0.000000001 );
+    QGSCOMPARENEAR( polygon.at( i ).y(), my, 0.000000001 );
+  }
+}
+
+void TestQgsGeometryKernels::toPolygon()
+{
+  QVector< double > x, y;
+  line( 100, x, y );
+  QPolygonF polygon = QgsGeometryKernels::toPolygon( x.constData(), y.constData(), x.size() );
+  QCOMPARE( polygon.size(), x.size() );
+  for ( int i = 0; i < x.size(); ++i )
+    QCOMPARE( polygon.at( i ), QPointF( x.at( i ), y.at( i ) ) );
+
+  QVERIFY( QgsGeometryKernels::toPolygon( x.constData(), y.constData(), 0 ).isEmpty() );
+}
+
+void TestQgsGeometryKernels::lineString()
+{
+  QVector< double > x, y;
+  line( 1000, x, y );
+  QgsLineString ls( x, y );
+
+  QCOMPARE( ls.xData()[500], x.at( 500 ) );
+  QCOMPARE( ls.yData()[500], y.at( 500 ) );
+  QCOMPARE( ls.boundingBox(), QgsGeometryKernels::boundingBox( x.constData(), y.constData(), x.size() ) );
+  QCOMPARE( ls.length(), QgsGeometryKernels::length( x.constData(), y.constData(), x.size() ) );
+  QCOMPARE( ls.asQPolygonF(), QgsGeometryKernels::toPolygon( x.constData(), y.constData(), x.size() ) );
+
+  // the asQPolygonF() override is used through the curve interface
+  const QgsCurve &curve = ls;
+  QCOMPARE( curve.asQPolygonF().size(), x.size() );
+
+  // transforming clears the cached bounding box
+  ls.transform( QTransform::fromTranslate( 1000, 2000 ) );
+  QgsRectangle bbox = QgsGeometryKernels::boundingBox( x.constData(), y.constData(), x.size() );
+  QGSCOMPARENEAR( ls.boundingBox().xMinimum(), bbox.xMinimum() + 1000, 0.000000001 );
+  QGSCOMPARENEAR( ls.boundingBox().yMaximum(), bbox.yMaximum() + 2000, 0.000000001 );
+
+  // polygons use the kernels through their rings
+  QgsPolygonV2 polygon;
+  QgsLineString *ring = new QgsLineString( QVector< double >() << 0 << 10 << 10 << 0 << 0, QVector< double >() << 0 << 0 << 5 << 5 << 0 );
+  polygon.setExteriorRing( ring );
+  polygon.transform( QTransform::fromScale( 2, 2 ) );
+  QCOMPARE( polygon.boundingBox(), QgsRectangle( 0, 0, 20, 10 ) );
+  QGSCOMPARENEAR( polygon.perimeter(), 60.0, 0.000000001 );
+}
+
+QGSTEST_MAIN( TestQgsGeometryKernels )
+#include "testqgsgeometrykernels.moc"
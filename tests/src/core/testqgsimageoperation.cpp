@@ -22,6 +22,7 @@
 #include "qgsrenderchecker.h"
 #include "qgssymbollayerutils.h"
 #include "qgsapplication.h"
+#include <memory>
 
 class TestQgsImageOperation : public QObject
 {
@@ -77,6 +78,9 @@ class TestQgsImageOperation : public QObject
     void gaussianBlurSmall();
     void gaussianBlurNoChange();
 
+    //threaded block operations
+    void largeImageBlocks();
+
     //flip
     void flipHorizontal();
     void flipVertical();
@@ -88,6 +92,7 @@ class TestQgsImageOperation : public QObject
     QString mTransparentSampleImage;
 
     bool imageCheck( const QString &testName, QImage &image, int mismatchCount );
+    QImage shapesImage( int width, int height );
 };
 
 void TestQgsImageOperation::initTestCase()
@@ -428,6 +433,44 @@ void TestQgsImageOperation::gaussianBlurNoChange()
   QVERIFY( result );
 }
 
+void TestQgsImageOperation::largeImageBlocks()
+{
+  //the shapes are far enough from the edges of the small image for the operations to
+  //give the same pixels there as in the large image, which is processed in blocks in threads
+  QImage small = shapesImage( 200, 200 );
+  QImage large = shapesImage( 800, 800 );
+  QVERIFY( small.width() * small.height() < 100000 );
+  QVERIFY( large.width() * large.height() >= 100000 );
+
+  QImage smallStack = small;
+  QImage largeStack = large;
+  QgsImageOperation::stackBlur( smallStack, 10 );
+  QgsImageOperation::stackBlur( largeStack, 10 );
+  QCOMPARE( largeStack.copy( 0, 0, 200, 200 ), smallStack );
+
+  QImage smallAlpha = small;
+  QImage largeAlpha = large;
+  QgsImageOperation::stackBlur( smallAlpha, 10, true );
+  QgsImageOperation::stackBlur( largeAlpha, 10, true );
+  QCOMPARE( largeAlpha.copy( 0, 0, 200, 200 ), smallAlpha );
+
+  std::unique_ptr< QImage > smallGaussian( QgsImageOperation::gaussianBlur( small, 20 ) );
+  std::unique_ptr< QImage > largeGaussian( QgsImageOperation::gaussianBlur( large, 20 ) );
+  QCOMPARE( largeGaussian->copy( 0, 0, 200, 200 ), *smallGaussian );
+
+  QgsGradientColorRamp ramp;
+  QgsImageOperation::DistanceTransformProperties props;
+  props.useMaxDistance = false;
+  props.spread = 30;
+  props.ramp = &ramp;
+  props.shadeExterior = true;
+  QImage smallDistance = small;
+  QImage largeDistance = large;
+  QgsImageOperation::distanceTransform( smallDistance, props );
+  QgsImageOperation::distanceTransform( largeDistance, props );
+  QCOMPARE( largeDistance.copy( 0, 0, 200, 200 ), smallDistance );
+}
+
 void TestQgsImageOperation::flipHorizontal()
 {
   QImage image( mSampleImage );
@@ -450,6 +493,21 @@ void TestQgsImageOperation::flipVertical()
 // Private helper functions not called directly by CTest
 //
 
+QImage TestQgsImageOperation::shapesImage( int width, int height )
+{
+  QImage image( width, height, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::transparent );
+  QPainter painter( &image );
+  painter.setRenderHint( QPainter::Antialiasing );
+  painter.setPen( Qt::NoPen );
+  painter.setBrush( QColor( 200, 30, 60 ) );
+  painter.drawEllipse( QRectF( 50, 60, 70, 80 ) );
+  painter.setBrush( QColor( 20, 80, 220, 120 ) );
+  painter.drawRect( QRectF( 90, 50, 60, 90 ) );
+  painter.end();
+  return image;
+}
+
 bool TestQgsImageOperation::imageCheck( const QString &testName, QImage &image, int mismatchCount )
 {
   //draw background
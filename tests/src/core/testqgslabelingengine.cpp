@@ -16,6 +16,7 @@
 #include "qgstest.h"
 
 #include <qgsapplication.h>
+#include <qgslabelcache.h>
 #include <qgslabelingengine.h>
 #include <qgsproject.h>
 #include <qgsmaprenderersequentialjob.h>
@@ -28,6 +29,8 @@
 #include "qgsrenderchecker.h"
 #include "qgsfontutils.h"
 
+#include <algorithm>
+
 class TestQgsLabelingEngine : public QObject
 {
     Q_OBJECT
@@ -48,6 +51,8 @@ class TestQgsLabelingEngine : public QObject
     void testCapitalization();
     void testParticipatingLayers();
     void testRegisterFeatureUnprojectible();
+    void testConcurrentSolver();
+    void testLabelCache();
 
   private:
     QgsVectorLayer *vl = nullptr;
@@ -623,5 +628,152 @@ void TestQgsLabelingEngine::testRegisterFeatureUnprojectible()
   QCOMPARE( provider->mLabels.size(), 0 );
 }
 
+static bool labelPositionLessThan( const QgsLabelPosition &p1, const QgsLabelPosition &p2 )
+{
+  return p1.featureId < p2.featureId;
+}
+
+void TestQgsLabelingEngine::testConcurrentSolver()
+{
+  // many separate clusters of points, so that the problem is split into several sub problems
+  std::unique_ptr< QgsVectorLayer> vl2( new QgsVectorLayer( "Point?crs=epsg:4326&field=id:integer", "vl", "memory" ) );
+  QgsFeatureList features;
+  for ( int cluster = 0; cluster < 400; ++cluster )
+  {
+    double x = -190 + ( cluster % 20 ) * 20;
+    double y = -190 + ( cluster / 20 ) * 20;
+    for ( int i = 0; i < 4; ++i )
+    {
+      QgsFeature f( vl2->fields(), cluster * 4 + i );
+      f.setAttribute( 0, cluster * 4 + i );
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( x + ( i % 2 ), y + ( i / 2 ) ) ) );
+      features << f;
+    }
+  }
+  vl2->dataProvider()->addFeatures( features );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 800, 800 ) );
+  mapSettings.setExtent( QgsRectangle( -200, -200, 200, 200 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl2.get() );
+  mapSettings.setOutputDpi( 96 );
+
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "'ab'" );
+  settings.isExpression = true;
+  setDefaultLabelParams( settings );
+
+  // the first run is the default search over the whole problem, the others split it
+  // into sub problems, solved serially and then concurrently
+  QList< QPair< bool, int > > runs;
+  runs << qMakePair( false, 1 ) << qMakePair( true, 1 ) << qMakePair( true, 4 );
+
+  int maxThreads = QgsApplication::maxThreads();
+  QList< QList< QgsLabelPosition > > results;
+  Q_FOREACH ( const auto &run, runs )
+  {
+    QgsLabelingEngineSettings engineSettings;
+    engineSettings.setFlag( QgsLabelingEngineSettings::SplitProblems, run.first );
+    mapSettings.setLabelingEngineSettings( engineSettings );
+    QgsApplication::setMaxThreads( run.second );
+
+    QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+
+    QgsLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    engine.addProvider( new QgsVectorLayerLabelProvider( vl2.get(), QString(), true, &settings ) );
+    engine.run( context );
+    p.end();
+
+    std::unique_ptr< QgsLabelingResults > labelingResults( engine.takeResults() );
+    QList< QgsLabelPosition > labels = labelingResults->labelsWithinRect( mapSettings.extent() );
+    std::sort( labels.begin(), labels.end(), labelPositionLessThan );
+    results << labels;
+  }
+  QgsApplication::setMaxThreads( maxThreads );
+
+  QVERIFY( results.at( 0 ).count() > 1000 );
+  for ( int run = 1; run < results.count(); ++run )
+  {
+    QCOMPARE( results.at( run ).count(), results.at( 0 ).count() );
+    for ( int i = 0; i < results.at( 0 ).count(); ++i )
+    {
+      QCOMPARE( results.at( run ).at( i ).featureId, results.at( 0 ).at( i ).featureId );
+      QCOMPARE( results.at( run ).at( i ).labelRect, results.at( 0 ).at( i ).labelRect );
+    }
+  }
+}
+
+void TestQgsLabelingEngine::testLabelCache()
+{
+  QgsPalLayerSettings settings;
+  settings.fieldName = QStringLiteral( "Class" );
+  setDefaultLabelParams( settings );
+
+  QgsMapSettings mapSettings;
+  mapSettings.setOutputSize( QSize( 600, 400 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << vl );
+  mapSettings.setOutputDpi( 96 );
+
+  QgsRectangle extent = vl->extent();
+  extent.scale( 1.2 );
+  QgsRectangle panned = extent;
+  panned.setXMinimum( extent.xMinimum() + extent.width() / 10 );
+  panned.setXMaximum( extent.xMaximum() + extent.width() / 10 );
+
+  QgsLabelCache cache;
+  QList< QList< QgsLabelPosition > > results;
+  Q_FOREACH ( const QgsRectangle &rect, QList< QgsRectangle >() << extent << panned )
+  {
+    mapSettings.setExtent( rect );
+
+    QImage img( mapSettings.outputSize(), QImage::Format_ARGB32_Premultiplied );
+    QPainter p( &img );
+    QgsRenderContext context = QgsRenderContext::fromMapSettings( mapSettings );
+    context.setPainter( &p );
+
+    QgsLabelingEngine engine;
+    engine.setMapSettings( mapSettings );
+    engine.setLabelCache( &cache );
+    engine.addProvider( new QgsVectorLayerLabelProvider( vl, QString(), true, &settings ) );
+    engine.run( context );
+    p.end();
+
+    std::unique_ptr< QgsLabelingResults > labelingResults( engine.takeResults() );
+    results << labelingResults->labelsWithinRect( mapSettings.visibleExtent() );
+  }
+
+  QVERIFY( !results.at( 0 ).isEmpty() );
+  QVERIFY( !cache.placements( vl->id(), QString() ).isEmpty() );
+
+  // labels which are still in the view after panning keep their placement
+  int kept = 0;
+  Q_FOREACH ( const QgsLabelPosition &label, results.at( 0 ) )
+  {
+    if ( !mapSettings.visibleExtent().contains( label.labelRect ) )
+      continue;
+
+    Q_FOREACH ( const QgsLabelPosition &pannedLabel, results.at( 1 ) )
+    {
+      if ( pannedLabel.featureId == label.featureId )
+      {
+        QCOMPARE( pannedLabel.labelRect, label.labelRect );
+        ++kept;
+      }
+    }
+  }
+  QVERIFY( kept > 0 );
+
+  // placements are dropped when zooming
+  QgsRectangle zoomed = extent;
+  zoomed.scale( 3 );
+  mapSettings.setExtent( zoomed );
+  QVERIFY( !cache.init( mapSettings ) );
+  QVERIFY( cache.placements( vl->id(), QString() ).isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsLabelingEngine )
 #include "testqgslabelingengine.moc"
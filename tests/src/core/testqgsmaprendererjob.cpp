@@ -32,12 +32,19 @@
 #include <qgsfield.h>
 #include <qgis.h> //defines GEOWkt
 #include "qgsmaprenderersequentialjob.h"
+#include "qgsmaprendererparalleljob.h"
 #include <qgsmaplayer.h>
 #include <qgsreadwritecontext.h>
 #include <qgsvectorlayer.h>
 #include <qgsapplication.h>
 #include <qgsproviderregistry.h>
 #include <qgsproject.h>
+#include "qgspallabeling.h"
+#include "qgssinglesymbolrenderer.h"
+#include "qgssymbol.h"
+#include "qgsvectorlayerlabeling.h"
+
+#include <QThreadPool>
 
 //qgs unit test utility class
 #include "qgsrenderchecker.h"
@@ -79,6 +86,9 @@ class TestQgsMapRendererJob : public QObject
     void testFourAdjacentTiles_data();
     void testFourAdjacentTiles();
 
+    //! Checks that rendering layers split into parallel tiles gives the same result as rendering them as a whole
+    void testParallelLayerTiles();
+
   private:
     QString mEncoding;
     QgsVectorFileWriter::WriterError mError;
@@ -333,7 +343,72 @@ void TestQgsMapRendererJob::testFourAdjacentTiles()
 }
 
 
-QGSTEST_MAIN( TestQgsMapRendererJob )
-#include "testqgsmaprendererjob.moc"
+void TestQgsMapRendererJob::testParallelLayerTiles()
+{
+  // make sure there are threads enough to split the layers, whatever the machine
+  int maxThreadCount = QThreadPool::globalInstance()->maxThreadCount();
+  QThreadPool::globalInstance()->setMaxThreadCount( 8 );
+
+  // labeled points with symbols reaching far away from them, into neighboring tiles
+  QString pointsFileName = QStringLiteral( TEST_DATA_DIR ) + "/points.shp";
+  std::unique_ptr< QgsVectorLayer > pointsLayer( new QgsVectorLayer( pointsFileName, QStringLiteral( "points" ), QStringLiteral( "ogr" ) ) );
+  QVERIFY( pointsLayer->isValid() );
+  QgsStringMap markerProperties;
+  markerProperties.insert( QStringLiteral( "name" ), QStringLiteral( "circle" ) );
+  markerProperties.insert( QStringLiteral( "color" ), QStringLiteral( "200,100,0,100" ) );
+  markerProperties.insert( QStringLiteral( "size" ), QStringLiteral( "40" ) );
+  pointsLayer->setRenderer( new QgsSingleSymbolRenderer( QgsMarkerSymbol::createSimple( markerProperties ) ) );
+  QgsPalLayerSettings labelSettings;
+  labelSettings.fieldName = QStringLiteral( "Class" );
+  pointsLayer->setLabeling( new QgsVectorLayerSimpleLabeling( labelSettings ) );
+
+  QgsMapSettings mapSettings;
+  QgsRectangle extent = pointsLayer->extent();
+  extent.scale( 1.2 );
+  mapSettings.setExtent( extent );
+  mapSettings.setOutputSize( QSize( 1024, 1024 ) );
+  mapSettings.setLayers( QList<QgsMapLayer *>() << pointsLayer.get() << mpPolysLayer );
+  mapSettings.setFlag( QgsMapSettings::Antialiasing );
+
+  QgsMapRendererParallelJob job( mapSettings );
+  job.start();
+  job.waitForFinished();
+  QImage expected = job.renderedImage();
+  std::unique_ptr< QgsLabelingResults > expectedLabels( job.takeLabelingResults() );
+
+  mapSettings.setFlag( QgsMapSettings::RenderLayerTiles );
+  QgsMapRendererParallelJob tiledJob( mapSettings );
+  tiledJob.start();
+  tiledJob.waitForFinished();
+  QImage tiled = tiledJob.renderedImage();
+  std::unique_ptr< QgsLabelingResults > tiledLabels( tiledJob.takeLabelingResults() );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreadCount );
+
+  QVERIFY( tiledJob.errors().isEmpty() );
+  QCOMPARE( tiled.size(), expected.size() );
+  QVERIFY( tiled == expected );
+
+  // labels are placed at the same positions
+  QList<QgsLabelPosition> expectedPositions = expectedLabels->labelsWithinRect( mapSettings.visibleExtent() );
+  QList<QgsLabelPosition> tiledPositions = tiledLabels->labelsWithinRect( mapSettings.visibleExtent() );
+  QVERIFY( !expectedPositions.isEmpty() );
+  QCOMPARE( tiledPositions.count(), expectedPositions.count() );
+  for ( int i = 0; i < expectedPositions.count(); ++i )
+  {
+    bool found = false;
+    Q_FOREACH ( const QgsLabelPosition &position, tiledPositions )
+    {
+      if ( position.featureId == expectedPositions.at( i ).featureId )
+      {
+        QCOMPARE( position.labelRect, expectedPositions.at( i ).labelRect );
+        found = true;
+      }
+    }
+    QVERIFY( found );
+  }
+}
 
 
+QGSTEST_MAIN( TestQgsMapRendererJob )
+#include "testqgsmaprendererjob.moc"
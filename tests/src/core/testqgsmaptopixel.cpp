@@ -30,6 +30,7 @@ class TestQgsMapToPixel: public QObject
     void getters();
     void fromScale();
     void toMapPoint();
+    void transformPolygon();
 };
 
 void TestQgsMapToPixel::rotation()
@@ -120,6 +121,33 @@ void TestQgsMapToPixel::toMapPoint()
   QCOMPARE( p, QgsPointXY( 20, 20 ) );
 }
 
+void TestQgsMapToPixel::transformPolygon()
+{
+  QPolygonF polygon;
+  polygon << QPointF( 5, 5 ) << QPointF( 10, 10 ) << QPointF( -3.5, 7.25 ) << QPointF( 1000, -20 );
+
+  // without and with rotation, the points are transformed as one by one
+  Q_FOREACH ( double rotation, QList< double >() << 0 << 90 << 33.3 )
+  {
+    QgsMapToPixel m2p( 0.5, 5, 5, 10, 10, rotation );
+    QPolygonF transformed = polygon;
+    m2p.transformInPlace( transformed );
+    QCOMPARE( transformed.size(), polygon.size() );
+    for ( int i = 0; i < polygon.size(); ++i )
+    {
+      double x = polygon.at( i ).x();
+      double y = polygon.at( i ).y();
+      m2p.transformInPlace( x, y );
+      QGSCOMPARENEAR( transformed.at( i ).x(), x, 0.000000001 );
+      QGSCOMPARENEAR( transformed.at( i ).y(), y, 0.000000001 );
+    }
+  }
+
+  QPolygonF empty;
+  QgsMapToPixel().transformInPlace( empty );
+  QVERIFY( empty.isEmpty() );
+}
+
 QGSTEST_MAIN( TestQgsMapToPixel )
 #include "testqgsmaptopixel.moc"
 
@@ -22,6 +22,9 @@
 #include "qgsprocessingcontext.h"
 #include "qgsprocessingmodelalgorithm.h"
 #include <QObject>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QtConcurrentRun>
 #include <QtTest/QSignalSpy>
 #include "qgis.h"
 #include "qgstest.h"
@@ -33,6 +36,9 @@
 #include "qgsvectorfilewriter.h"
 #include "qgsexpressioncontext.h"
 #include "qgsxmlutils.h"
+#include "qgsexception.h"
+#include "qgsprocessingfeedback.h"
+#include <stdexcept>
 
 class DummyAlgorithm : public QgsProcessingAlgorithm
 {
@@ -287,6 +293,59 @@ class DummyProviderNoLoad : public DummyProvider
 
 };
 
+//dummy feature based algorithm for testing, which skips the features with odd ids
+class DummyFeatureBasedAlgorithm : public QgsProcessingFeatureBasedAlgorithm
+{
+  public:
+
+    DummyFeatureBasedAlgorithm( int failingId = -1, bool processingException = true )
+      : mFailingId( failingId )
+      , mProcessingException( processingException )
+    {}
+
+    QString name() const override { return QStringLiteral( "featurebased" ); }
+    QString displayName() const override { return name(); }
+    Flags flags() const override { return QgsProcessingFeatureBasedAlgorithm::flags() | FlagProcessFeaturesInParallel; }
+    DummyFeatureBasedAlgorithm *createInstance() const override { return new DummyFeatureBasedAlgorithm( mFailingId, mProcessingException ); }
+
+    int mFailingId = -1;
+    bool mProcessingException = true;
+
+  protected:
+
+    QString outputName() const override { return QStringLiteral( "output" ); }
+
+    QgsFeature processFeature( const QgsFeature &feature, QgsProcessingFeedback *feedback ) override
+    {
+      int id = feature.attribute( 0 ).toInt();
+      if ( id == mFailingId && mProcessingException )
+        throw QgsProcessingException( QStringLiteral( "failed %1" ).arg( id ) );
+      else if ( id == mFailingId )
+        throw std::runtime_error( QStringLiteral( "failed %1" ).arg( id ).toStdString() );
+
+      if ( id % 2 )
+      {
+        feedback->pushInfo( QStringLiteral( "skipped %1" ).arg( id ) );
+        return QgsFeature();
+      }
+
+      QgsFeature f = feature;
+      f.setGeometry( QgsGeometry::fromPointXY( QgsPointXY( id, -id ) ) );
+      return f;
+    }
+};
+
+//feedback keeping the messages reported by an algorithm
+class LoggingFeedback : public QgsProcessingFeedback
+{
+  public:
+
+    void reportError( const QString &error ) override { messages << error; }
+    void pushInfo( const QString &info ) override { messages << info; }
+
+    QStringList messages;
+};
+
 class TestQgsProcessing: public QObject
 {
     Q_OBJECT
@@ -352,6 +411,7 @@ class TestQgsProcessing: public QObject
     void tempUtils();
     void convertCompatible();
     void create();
+    void featureBasedAlgorithm();
 
   private:
 
@@ -5370,5 +5430,103 @@ void TestQgsProcessing::create()
   QCOMPARE( newInstance->provider(), &p );
 }
 
+void TestQgsProcessing::featureBasedAlgorithm()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( "Point?field=id:integer", "v1", "memory" );
+  QVERIFY( layer->isValid() );
+  QgsFeatureList features;
+  // several chunks of features when processed in parallel
+  for ( int i = 0; i < 5000; ++i )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttribute( 0, i );
+    features << f;
+  }
+  QVERIFY( layer->dataProvider()->addFeatures( features ) );
+
+  QgsProcessingContext context;
+  context.temporaryLayerStore()->addMapLayer( layer );
+
+  QVariantMap params;
+  params.insert( QStringLiteral( "INPUT" ), layer->id() );
+  params.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  int maxThreads = QgsApplication::maxThreads();
+  // explicit thread counts, QgsApplication::setMaxThreads() would limit them to the number of cores
+  Q_FOREACH ( int threads, QList<int>() << 1 << 4 )
+  {
+    QThreadPool::globalInstance()->setMaxThreadCount( threads );
+
+    DummyFeatureBasedAlgorithm alg;
+    LoggingFeedback feedback;
+    bool ok = false;
+    QVariantMap results = alg.run( params, context, &feedback, &ok );
+    QVERIFY( ok );
+
+    // features and messages are in the order of the source features
+    QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( results.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+    QVERIFY( output );
+    QCOMPARE( output->featureCount(), 2500L );
+    QgsFeatureIterator it = output->getFeatures();
+    QgsFeature f;
+    int expected = 0;
+    while ( it.nextFeature( f ) )
+    {
+      QCOMPARE( f.attribute( 0 ).toInt(), expected );
+      QCOMPARE( f.geometry().asPoint(), QgsPointXY( expected, -expected ) );
+      expected += 2;
+    }
+    QCOMPARE( expected, 5000 );
+
+    QCOMPARE( feedback.messages.size(), 2500 );
+    for ( int i = 0; i < feedback.messages.size(); ++i )
+      QCOMPARE( feedback.messages.at( i ), QStringLiteral( "skipped %1" ).arg( 2 * i + 1 ) );
+
+    // an exception stops the algorithm after the messages of the previous features
+    DummyFeatureBasedAlgorithm failingAlg( 3000 );
+    LoggingFeedback failingFeedback;
+    failingAlg.run( params, context, &failingFeedback, &ok );
+    QVERIFY( !ok );
+    QCOMPARE( failingFeedback.messages.size(), 1501 );
+    QCOMPARE( failingFeedback.messages.at( 1499 ), QStringLiteral( "skipped 2999" ) );
+    QCOMPARE( failingFeedback.messages.last(), QStringLiteral( "failed 3000" ) );
+
+    if ( threads > 1 )
+    {
+      // other exceptions thrown by worker threads are reported as processing exceptions
+      DummyFeatureBasedAlgorithm otherFailingAlg( 3000, false );
+      LoggingFeedback otherFailingFeedback;
+      otherFailingAlg.run( params, context, &otherFailingFeedback, &ok );
+      QVERIFY( !ok );
+      QCOMPARE( otherFailingFeedback.messages.size(), 1501 );
+      QCOMPARE( otherFailingFeedback.messages.last(), QStringLiteral( "failed 3000" ) );
+    }
+  }
+
+  // the features are still processed when the algorithm runs in a thread of the global pool
+  // and all the other threads of the pool are busy
+  QThreadPool::globalInstance()->setMaxThreadCount( 2 );
+  QSemaphore busy;
+  QFuture< void > busyFuture = QtConcurrent::run( [&busy] { busy.acquire(); } );
+  QVariantMap busyResults;
+  bool busyOk = false;
+  // as for QgsProcessingAlgRunnerTask, the context is only used by the thread running the algorithm
+  QFuture< void > algFuture = QtConcurrent::run( [&params, &context, &busyResults, &busyOk]
+  {
+    DummyFeatureBasedAlgorithm alg;
+    QgsProcessingFeedback feedback;
+    busyResults = alg.run( params, context, &feedback, &busyOk );
+  } );
+  QTRY_VERIFY_WITH_TIMEOUT( algFuture.isFinished(), 60000 );
+  busy.release();
+  busyFuture.waitForFinished();
+  QVERIFY( busyOk );
+  QgsVectorLayer *busyOutput = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( busyResults.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+  QVERIFY( busyOutput );
+  QCOMPARE( busyOutput->featureCount(), 2500L );
+
+  QgsApplication::setMaxThreads( maxThreads );
+}
+
 QGSTEST_MAIN( TestQgsProcessing )
 #include "testqgsprocessing.moc"
@@ -0,0 +1,169 @@
+/***************************************************************************
+  testqgsrasterprojector.cpp
+  --------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgscoordinatetransform.h"
+#include "qgsexception.h"
+#include "qgsrasterdataprovider.h"
+#include "qgsrasterlayer.h"
+#include "qgsrasterprojector.h"
+
+#include <memory>
+
+class TestQgsRasterProjector : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void exactVsPerPixelTransform();
+    void exactVsApproximate();
+
+  private:
+
+    //! Returns a projector of the landsat layer to WGS 84
+    std::unique_ptr< QgsRasterProjector > projector( QgsRasterProjector::Precision precision ) const;
+
+    //! Counts the pixels which differ between two blocks
+    static int differences( QgsRasterBlock *block1, QgsRasterBlock *block2 );
+
+    QgsRasterLayer *mLayer = nullptr;
+    QgsRectangle mDestExtent;
+    int mDestWidth = 0;
+    int mDestHeight = 0;
+};
+
+void TestQgsRasterProjector::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+
+  QString landsatFileName = QStringLiteral( TEST_DATA_DIR ) + "/landsat.tif";
+  mLayer = new QgsRasterLayer( landsatFileName, QStringLiteral( "landsat" ) );
+  QVERIFY( mLayer->isValid() );
+
+  std::unique_ptr< QgsRasterProjector > p = projector( QgsRasterProjector::Exact );
+  QVERIFY( p->destExtentSize( mLayer->extent(), mLayer->width(), mLayer->height(), mDestExtent, mDestWidth, mDestHeight ) );
+}
+
+void TestQgsRasterProjector::cleanupTestCase()
+{
+  delete mLayer;
+  QgsApplication::exitQgis();
+}
+
+std::unique_ptr< QgsRasterProjector > TestQgsRasterProjector::projector( QgsRasterProjector::Precision precision ) const
+{
+  std::unique_ptr< QgsRasterProjector > p( new QgsRasterProjector() );
+  p->setCrs( mLayer->crs(), QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ) );
+  p->setInput( mLayer->dataProvider() );
+  p->setPrecision( precision );
+  return p;
+}
+
+int TestQgsRasterProjector::differences( QgsRasterBlock *block1, QgsRasterBlock *block2 )
+{
+  int count = 0;
+  for ( int i = 0; i < block1->height(); ++i )
+  {
+    for ( int j = 0; j < block1->width(); ++j )
+    {
+      if ( block1->isNoData( i, j ) != block2->isNoData( i, j ) ||
+           ( !block1->isNoData( i, j ) && block1->value( i, j ) != block2->value( i, j ) ) )
+        count++;
+    }
+  }
+  return count;
+}
+
+void TestQgsRasterProjector::exactVsPerPixelTransform()
+{
+  // inverse transform, from the destination to the source crs
+  QgsCoordinateTransform inverseCt( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:4326" ) ), mLayer->crs() );
+  ProjectorData pd( mDestExtent, mDestWidth, mDestHeight, mLayer->dataProvider(), inverseCt, QgsRasterProjector::Exact );
+  QVERIFY( pd.srcRows() > 0 );
+  QVERIFY( pd.srcCols() > 0 );
+
+  QgsRectangle srcExtent = pd.srcExtent();
+  double srcXRes = srcExtent.width() / pd.srcCols();
+  double srcYRes = srcExtent.height() / pd.srcRows();
+  double destXRes = mDestExtent.width() / mDestWidth;
+  double destYRes = mDestExtent.height() / mDestHeight;
+
+  // the source positions of whole rows must match the ones of each pixel transformed on its own
+  int inside = 0;
+  for ( int i = 0; i < mDestHeight; ++i )
+  {
+    for ( int j = 0; j < mDestWidth; ++j )
+    {
+      int expectedRow = -1;
+      int expectedCol = -1;
+      try
+      {
+        QgsPointXY p = inverseCt.transform( mDestExtent.xMinimum() + ( j + 0.5 ) * destXRes,
+                                            mDestExtent.yMaximum() - ( i + 0.5 ) * destYRes );
+        if ( mLayer->extent().contains( p ) )
+        {
+          expectedRow = static_cast< int >( std::floor( ( srcExtent.yMaximum() - p.y() ) / srcYRes ) );
+          expectedCol = static_cast< int >( std::floor( ( p.x() - srcExtent.xMinimum() ) / srcXRes ) );
+          if ( expectedRow < 0 || expectedRow >= pd.srcRows() || expectedCol < 0 || expectedCol >= pd.srcCols() )
+          {
+            expectedRow = -1;
+            expectedCol = -1;
+          }
+        }
+      }
+      catch ( QgsCsException & )
+      {
+      }
+
+      int srcRow = -1;
+      int srcCol = -1;
+      QCOMPARE( pd.srcRowCol( i, j, &srcRow, &srcCol ), expectedRow >= 0 );
+      if ( expectedRow < 0 )
+        continue;
+
+      QCOMPARE( srcRow, expectedRow );
+      QCOMPARE( srcCol, expectedCol );
+      inside++;
+    }
+  }
+  QVERIFY( inside > mDestWidth * mDestHeight / 2 );
+
+  // blocks of other bands are projected the same way
+  std::unique_ptr< QgsRasterProjector > p = projector( QgsRasterProjector::Exact );
+  std::unique_ptr< QgsRasterBlock > band1( p->block( 1, mDestExtent, mDestWidth, mDestHeight ) );
+  std::unique_ptr< QgsRasterBlock > band2( p->block( 2, mDestExtent, mDestWidth, mDestHeight ) );
+  QVERIFY( !band1->isEmpty() );
+  QVERIFY( !band2->isEmpty() );
+  QCOMPARE( band1->width(), mDestWidth );
+  QCOMPARE( band2->height(), mDestHeight );
+}
+
+void TestQgsRasterProjector::exactVsApproximate()
+{
+  std::unique_ptr< QgsRasterProjector > exact = projector( QgsRasterProjector::Exact );
+  std::unique_ptr< QgsRasterProjector > approximate = projector( QgsRasterProjector::Approximate );
+
+  std::unique_ptr< QgsRasterBlock > exactBlock( exact->block( 1, mDestExtent, mDestWidth, mDestHeight ) );
+  std::unique_ptr< QgsRasterBlock > approximateBlock( approximate->block( 1, mDestExtent, mDestWidth, mDestHeight ) );
+
+  // the approximation is within half a destination pixel, so only a few pixels may differ
+  QVERIFY( differences( exactBlock.get(), approximateBlock.get() ) < mDestWidth * mDestHeight / 20 );
+}
+
+QGSTEST_MAIN( TestQgsRasterProjector )
+#include "testqgsrasterprojector.moc"
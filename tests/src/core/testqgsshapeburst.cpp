@@ -63,6 +63,7 @@ class TestQgsShapeburst : public QObject
     void shapeburstMaxDistanceMm();
     void shapeburstMaxDistanceMapUnits();
     void shapeburstIgnoreRings();
+    void shapeburstCachedImages();
     void shapeburstSymbolFromQml();
 
   private:
@@ -208,6 +209,22 @@ void TestQgsShapeburst::shapeburstIgnoreRings()
   mShapeburstFill->setIgnoreRings( false );
 }
 
+void TestQgsShapeburst::shapeburstCachedImages()
+{
+  mReport += QLatin1String( "<h2>Shapeburst symbol renderer cached images test</h2>\n" );
+  mShapeburstFill->setColor( QColor( "red" ) );
+  mShapeburstFill->setColor2( QColor( "blue" ) );
+  // second render reuses the images of the first one
+  QVERIFY( imageCheck( "shapeburst" ) );
+  QVERIFY( imageCheck( "shapeburst" ) );
+  // changed settings must not reuse them
+  mShapeburstFill->setColor( QColor( "green" ) );
+  mShapeburstFill->setColor2( QColor( "white" ) );
+  QVERIFY( imageCheck( "shapeburst_colors" ) );
+  mShapeburstFill->setColor( QColor( "red" ) );
+  mShapeburstFill->setColor2( QColor( "blue" ) );
+}
+
 void TestQgsShapeburst::shapeburstSymbolFromQml()
 {
   mReport += QLatin1String( "<h2>Shapeburst symbol from QML test</h2>\n" );
@@ -16,6 +16,10 @@
 #include "qgstest.h"
 #include <QObject>
 #include <QString>
+#include <QDir>
+#include <QFile>
+
+#include <algorithm>
 
 #include <qgsapplication.h>
 #include "qgsfeatureiterator.h"
@@ -136,6 +140,68 @@ class TestQgsSpatialIndex : public QObject
       QVERIFY( fids[0] == 1 );
     }
 
+    void testPersistence()
+    {
+      QgsSpatialIndex index;
+      for ( int i = 0; i < 100; ++i )
+      {
+        for ( int k = 0; k < 100; ++k )
+        {
+          index.insertFeature( i * 1000 + k, QgsRectangle( i, k, i + 0.5, k + 0.5 ) );
+        }
+      }
+
+      QString fileName = QDir::tempPath() + "/testqgsspatialindex.dat";
+      QString indexFileName = QgsSpatialIndex::indexFileName( fileName );
+      QCOMPARE( indexFileName, fileName + ".qsi" );
+      QDateTime modified( QDate( 2017, 10, 1 ), QTime( 12, 0 ) );
+      QVERIFY( index.writeToFile( indexFileName, modified, 10000 ) );
+
+      // outdated files are refused
+      QgsSpatialIndex loaded;
+      QVERIFY( !loaded.readFromFile( indexFileName, modified.addSecs( 1 ) ) );
+      QVERIFY( !loaded.readFromFile( indexFileName, modified, 10001 ) );
+      QVERIFY( !loaded.readFromFile( fileName + ".missing" ) );
+      QVERIFY( loaded.intersects( QgsRectangle( 0, 0, 100, 100 ) ).isEmpty() );
+
+      QVERIFY( loaded.readFromFile( indexFileName, modified, 10000 ) );
+
+      QList<QgsRectangle> queries;
+      queries << QgsRectangle( 0, 0, 100, 100 ) << QgsRectangle( 10.2, 20.2, 12.7, 21.3 )
+              << QgsRectangle( 50.5, 50.5, 50.6, 50.6 ) << QgsRectangle( -10, -10, -5, -5 )
+              << QgsRectangle( 99.5, 99.5, 99.5, 99.5 );
+      Q_FOREACH ( const QgsRectangle &rect, queries )
+      {
+        QList<QgsFeatureId> expected = index.intersects( rect );
+        QList<QgsFeatureId> result = loaded.intersects( rect );
+        std::sort( expected.begin(), expected.end() );
+        std::sort( result.begin(), result.end() );
+        QCOMPARE( result, expected );
+      }
+
+      QList<QgsFeatureId> nearest = loaded.nearestNeighbor( QgsPointXY( 10.75, 20.25 ), 2 );
+      QCOMPARE( nearest.count(), 2 );
+      QVERIFY( nearest.contains( 10020 ) );
+      QVERIFY( nearest.contains( 11020 ) );
+      QCOMPARE( loaded.nearestNeighbor( QgsPointXY( -3, -3 ), 1 ), QList<QgsFeatureId>() << 0 );
+
+      // copies share the mapped file, modifications go to memory
+      QgsSpatialIndex copy( loaded );
+      QVERIFY( copy.insertFeature( 1, QgsRectangle( -10, -10, -9, -9 ) ) );
+      QCOMPARE( copy.intersects( QgsRectangle( -10, -10, -5, -5 ) ), QList<QgsFeatureId>() << 1 );
+      QVERIFY( loaded.intersects( QgsRectangle( -10, -10, -5, -5 ) ).isEmpty() );
+      QCOMPARE( copy.intersects( QgsRectangle( 0, 0, 100, 100 ) ).count(), 10001 );
+
+      // round trip of an empty index
+      QgsSpatialIndex empty;
+      QVERIFY( empty.writeToFile( indexFileName ) );
+      QVERIFY( loaded.readFromFile( indexFileName ) );
+      QVERIFY( loaded.intersects( QgsRectangle( 0, 0, 100, 100 ) ).isEmpty() );
+      QVERIFY( loaded.nearestNeighbor( QgsPointXY( 0, 0 ), 1 ).isEmpty() );
+
+      QFile::remove( indexFileName );
+    }
+
     void benchmarkIntersect()
     {
       // add 50K features to the index
@@ -0,0 +1,277 @@
+/***************************************************************************
+  testqgsspatialpartitions.cpp
+  --------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsgeometry.h"
+#include "qgsprocessingalgorithm.h"
+#include "qgsprocessingcontext.h"
+#include "qgsprocessingfeedback.h"
+#include "qgsprocessingregistry.h"
+#include "qgsprocessingutils.h"
+#include "qgsproject.h"
+#include "qgsspatialpartitions.h"
+#include "qgstestutils.h"
+#include "qgsvectordataprovider.h"
+#include "qgsvectorlayer.h"
+
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <memory>
+
+class TestQgsSpatialPartitions : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void cells();
+    void unaryUnion();
+    void dissolveAlgorithm();
+    void clipAlgorithm();
+
+  private:
+
+    //! Returns squares of side 2 on a grid of 1 x 1 cells, so that neighbours overlap
+    static QList< QgsGeometry > squares( int x0, int y0, int count );
+
+    //! Returns a layer with the squares of a 40 x 40 grid, whose class is their row modulo 3
+    static QgsVectorLayer *squaresLayer();
+
+    //! Runs a native algorithm with \a threads threads and returns the features of its output
+    static QgsFeatureList runAlgorithm( const QString &id, QVariantMap parameters, QgsVectorLayer *layer, int threads );
+};
+
+void TestQgsSpatialPartitions::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsSpatialPartitions::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+QList< QgsGeometry > TestQgsSpatialPartitions::squares( int x0, int y0, int count )
+{
+  QList< QgsGeometry > geometries;
+  for ( int y = y0; y < y0 + count; ++y )
+  {
+    for ( int x = x0; x < x0 + count; ++x )
+      geometries << QgsGeometry::fromRect( QgsRectangle( x, y, x + 2, y + 2 ) );
+  }
+  return geometries;
+}
+
+QgsVectorLayer *TestQgsSpatialPartitions::squaresLayer()
+{
+  QgsVectorLayer *layer = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857&field=id:integer&field=class:integer" ), QStringLiteral( "squares" ), QStringLiteral( "memory" ) );
+  QgsFeatureList features;
+  int id = 0;
+  Q_FOREACH ( const QgsGeometry &square, squares( 0, 0, 40 ) )
+  {
+    QgsFeature f( layer->fields() );
+    f.setAttributes( QgsAttributes() << id << ( id / 40 ) % 3 );
+    f.setGeometry( square );
+    features << f;
+    id++;
+  }
+  layer->dataProvider()->addFeatures( features );
+  return layer;
+}
+
+QgsFeatureList TestQgsSpatialPartitions::runAlgorithm( const QString &id, QVariantMap parameters, QgsVectorLayer *layer, int threads )
+{
+  QThreadPool::globalInstance()->setMaxThreadCount( threads );
+
+  QgsProcessingContext context;
+  context.setProject( QgsProject::instance() );
+  context.temporaryLayerStore()->addMapLayer( layer );
+  parameters.insert( QStringLiteral( "INPUT" ), layer->id() );
+  parameters.insert( QStringLiteral( "OUTPUT" ), QStringLiteral( "memory:" ) );
+
+  const QgsProcessingAlgorithm *alg = QgsApplication::processingRegistry()->algorithmById( id );
+  QgsProcessingFeedback feedback;
+  bool ok = false;
+  QVariantMap results = alg->run( parameters, context, &feedback, &ok );
+  context.temporaryLayerStore()->takeMapLayer( layer );
+  if ( !ok )
+    return QgsFeatureList();
+
+  QgsVectorLayer *output = qobject_cast< QgsVectorLayer * >( QgsProcessingUtils::mapLayerFromString( results.value( QStringLiteral( "OUTPUT" ) ).toString(), context ) );
+  QgsFeatureList features;
+  QgsFeature f;
+  QgsFeatureIterator it = output->getFeatures();
+  while ( it.nextFeature( f ) )
+    features << f;
+  return features;
+}
+
+void TestQgsSpatialPartitions::cells()
+{
+  QgsSpatialPartitions partitions( QgsRectangle( 0, 0, 100, 100 ), 4 );
+  QCOMPARE( partitions.size(), 4 );
+  QCOMPARE( partitions.cell( QgsRectangle( 5, 5, 15, 15 ) ), 0 );
+  QCOMPARE( partitions.cell( QgsRectangle( 30, 5, 40, 15 ) ), 1 );
+  QCOMPARE( partitions.cell( QgsRectangle( 5, 30, 15, 40 ) ), 4 );
+  QCOMPARE( partitions.cell( QgsRectangle( 90, 90, 99, 99 ) ), 15 );
+  // cell of the center of the bounding box
+  QCOMPARE( partitions.cell( QgsRectangle( 0, 0, 100, 100 ) ), 10 );
+  // outside of the extent
+  QCOMPARE( partitions.cell( QgsRectangle( -20, -20, -10, -10 ) ), 0 );
+  QCOMPARE( partitions.cell( QgsRectangle( 120, 120, 130, 130 ) ), 15 );
+
+  QCOMPARE( QgsSpatialPartitions::parentCell( 0, 4 ), 0 );
+  QCOMPARE( QgsSpatialPartitions::parentCell( 5, 4 ), 0 );
+  QCOMPARE( QgsSpatialPartitions::parentCell( 6, 4 ), 1 );
+  QCOMPARE( QgsSpatialPartitions::parentCell( 9, 4 ), 2 );
+  QCOMPARE( QgsSpatialPartitions::parentCell( 15, 4 ), 3 );
+  QCOMPARE( QgsSpatialPartitions::parentCell( 3, 2 ), 0 );
+
+  // empty extent
+  QgsSpatialPartitions single( QgsRectangle( 10, 10, 10, 10 ), 1 );
+  QCOMPARE( single.size(), 2 );
+  QCOMPARE( single.cell( QgsRectangle( 10, 10, 10, 10 ) ), 0 );
+}
+
+void TestQgsSpatialPartitions::unaryUnion()
+{
+  QList< QList< QgsGeometry > > lists;
+  for ( int i = 0; i < 16; ++i )
+    lists << squares( 100 * i, 0, 10 );
+
+  // the unions are computed in worker threads, each with its own GEOS context
+  QList< QgsGeometry > unions = QtConcurrent::blockingMapped( lists, QgsGeometry::unaryUnion );
+  QCOMPARE( unions.size(), lists.size() );
+  for ( int i = 0; i < lists.size(); ++i )
+  {
+    QCOMPARE( unions.at( i ).wkbType(), QgsWkbTypes::Polygon );
+    QGSCOMPARENEAR( unions.at( i ).area(), 121.0, 0.000001 );
+    QVERIFY( unions.at( i ).equals( QgsGeometry::fromRect( QgsRectangle( 100 * i, 0, 100 * i + 11, 11 ) ) ) );
+  }
+}
+
+void TestQgsSpatialPartitions::dissolveAlgorithm()
+{
+  std::unique_ptr< QgsVectorLayer > layer( squaresLayer() );
+  int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+  // serial result: the union of all the geometries of each class
+  QList< QList< QgsGeometry > > classGeometries;
+  classGeometries << QList< QgsGeometry >() << QList< QgsGeometry >() << QList< QgsGeometry >();
+  QgsFeature f;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( f ) )
+    classGeometries[ f.attribute( 1 ).toInt()] << f.geometry();
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "FIELD" ), QStringList() << QStringLiteral( "class" ) );
+  QgsFeatureList previous;
+  Q_FOREACH ( int threads, QList< int >() << 1 << 4 << 4 )
+  {
+    QgsFeatureList features = runAlgorithm( QStringLiteral( "native:dissolve" ), parameters, layer.get(), threads );
+    QCOMPARE( features.size(), 3 );
+    for ( int i = 0; i < features.size(); ++i )
+    {
+      // groups are written in the order they are found
+      QCOMPARE( features.at( i ).attribute( 1 ).toInt(), i );
+      QVERIFY( features.at( i ).geometry().equals( QgsGeometry::unaryUnion( classGeometries.at( i ) ) ) );
+    }
+
+    // the output does not change from run to run with the same partitions
+    if ( threads == 4 && !previous.isEmpty() )
+    {
+      for ( int i = 0; i < features.size(); ++i )
+        QCOMPARE( features.at( i ).geometry().exportToWkt(), previous.at( i ).geometry().exportToWkt() );
+    }
+    previous = features;
+  }
+
+  // dissolve all
+  QgsFeatureList features = runAlgorithm( QStringLiteral( "native:dissolve" ), QVariantMap(), layer.get(), 4 );
+  QCOMPARE( features.size(), 1 );
+  QVERIFY( features.at( 0 ).geometry().equals( QgsGeometry::fromRect( QgsRectangle( 0, 0, 41, 41 ) ) ) );
+
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+}
+
+void TestQgsSpatialPartitions::clipAlgorithm()
+{
+  std::unique_ptr< QgsVectorLayer > layer( squaresLayer() );
+  int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+  QList< QgsGeometry > maskGeometries;
+  // no vertex on the corners of the squares, so that the mask does not just touch them
+  maskGeometries << QgsGeometry::fromWkt( QStringLiteral( "Polygon((5.5 5.3, 35.2 5.7, 20.1 30.4, 5.5 5.3))" ) )
+                 << QgsGeometry::fromPointXY( QgsPointXY( 30.5, 30.5 ) ).buffer( 8, 8 );
+  QgsVectorLayer *mask = new QgsVectorLayer( QStringLiteral( "Polygon?crs=epsg:3857" ), QStringLiteral( "mask" ), QStringLiteral( "memory" ) );
+  QgsFeatureList maskFeatures;
+  Q_FOREACH ( const QgsGeometry &geometry, maskGeometries )
+  {
+    QgsFeature maskFeature( mask->fields() );
+    maskFeature.setGeometry( geometry );
+    maskFeatures << maskFeature;
+  }
+  mask->dataProvider()->addFeatures( maskFeatures );
+  QgsProject::instance()->addMapLayer( mask );
+
+  // serial result: each feature clipped with the union of the whole mask
+  QgsGeometry maskUnion = QgsGeometry::unaryUnion( maskGeometries );
+  QMap< int, QgsGeometry > expected;
+  QgsFeature f;
+  QgsFeatureIterator it = layer->getFeatures();
+  while ( it.nextFeature( f ) )
+  {
+    if ( maskUnion.intersects( f.geometry() ) )
+      expected.insert( f.attribute( 0 ).toInt(), maskUnion.intersection( f.geometry() ) );
+  }
+  QVERIFY( expected.size() > 100 );
+
+  QVariantMap parameters;
+  parameters.insert( QStringLiteral( "OVERLAY" ), mask->id() );
+  QgsFeatureList previous;
+  Q_FOREACH ( int threads, QList< int >() << 1 << 4 << 4 )
+  {
+    QgsFeatureList features = runAlgorithm( QStringLiteral( "native:clip" ), parameters, layer.get(), threads );
+    QCOMPARE( features.size(), expected.size() );
+    Q_FOREACH ( const QgsFeature &feature, features )
+    {
+      int id = feature.attribute( 0 ).toInt();
+      QVERIFY( expected.contains( id ) );
+      // the mask is clipped to the extent of the cells first, which may move the vertices by a rounding error
+      QGSCOMPARENEAR( feature.geometry().area(), expected.value( id ).area(), 0.000001 );
+      QVERIFY( feature.geometry().symDifference( expected.value( id ) ).area() < 0.000001 );
+    }
+
+    // the output does not change from run to run with the same partitions
+    if ( threads == 4 && !previous.isEmpty() )
+    {
+      for ( int i = 0; i < features.size(); ++i )
+      {
+        QCOMPARE( features.at( i ).attribute( 0 ), previous.at( i ).attribute( 0 ) );
+        QCOMPARE( features.at( i ).geometry().exportToWkt(), previous.at( i ).geometry().exportToWkt() );
+      }
+    }
+    previous = features;
+  }
+
+  QgsProject::instance()->removeMapLayer( mask );
+  QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+}
+
+QGSTEST_MAIN( TestQgsSpatialPartitions )
+#include "testqgsspatialpartitions.moc"
@@ -0,0 +1,349 @@
+/***************************************************************************
+  testqgswkbgeometryview.cpp
+  --------------------------
+Date                 : October 2017
+Copyright            : (C) 2017 by QGIS contributors
+ ***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+#include "qgstest.h"
+
+#include "qgsapplication.h"
+#include "qgsfeature.h"
+#include "qgsgeometry.h"
+#include "qgsgeometryfactory.h"
+#include "qgsmaptopixel.h"
+#include "qgsrendercontext.h"
+#include "qgssymbol.h"
+#include "qgstestutils.h"
+#include "qgswkbgeometryview.h"
+#include "qgswkbptr.h"
+
+#include <QImage>
+#include <QPainter>
+
+class TestQgsWkbGeometryView : public QObject
+{
+    Q_OBJECT
+
+  private slots:
+    void initTestCase();// will be called before the first testfunction is executed.
+    void cleanupTestCase();// will be called after the last testfunction was executed.
+    void view_data();
+    void view();
+    void invalid();
+    void byteOrder();
+    void lazyGeometry();
+    void render();
+
+  private:
+
+    //! Writes WKB in the native or the swapped byte order
+    class WkbWriter
+    {
+      public:
+        explicit WkbWriter( bool swap = false ) : mSwap( swap ) {}
+
+        WkbWriter &header( QgsWkbTypes::Type type )
+        {
+          char byteOrder = QgsApplication::endian();
+          if ( mSwap )
+            byteOrder = byteOrder == QgsApplication::NDR ? QgsApplication::XDR : QgsApplication::NDR;
+          mWkb.append( byteOrder );
+          return *this << static_cast< quint32 >( type );
+        }
+
+        template<typename T> WkbWriter &operator<<( T value )
+        {
+          if ( mSwap )
+            QgsApplication::endian_swap( value );
+          mWkb.append( reinterpret_cast< const char * >( &value ), sizeof( value ) );
+          return *this;
+        }
+
+        QByteArray wkb() const { return mWkb; }
+
+      private:
+        bool mSwap;
+        QByteArray mWkb;
+    };
+
+    //! Renders \a geometry with \a symbol to an image
+    static QImage renderImage( QgsSymbol *symbol, const QgsGeometry &geometry );
+};
+
+void TestQgsWkbGeometryView::initTestCase()
+{
+  QgsApplication::init();
+  QgsApplication::initQgis();
+}
+
+void TestQgsWkbGeometryView::cleanupTestCase()
+{
+  QgsApplication::exitQgis();
+}
+
+void TestQgsWkbGeometryView::view_data()
+{
+  QTest::addColumn< QString >( "wkt" );
+
+  QTest::newRow( "point" ) << "Point (1 2)";
+  QTest::newRow( "point zm" ) << "PointZM (1 2 3 4)";
+  QTest::newRow( "line string" ) << "LineString (0 0, 10 5, 20 -5, 30 0)";
+  QTest::newRow( "line string z" ) << "LineStringZ (0 0 1, 10 5 2, 20 -5 3)";
+  QTest::newRow( "empty line string" ) << "LineString EMPTY";
+  QTest::newRow( "polygon" ) << "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0))";
+  QTest::newRow( "polygon with hole" ) << "Polygon ((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 2 4, 4 4, 4 2, 2 2))";
+  QTest::newRow( "clockwise polygon m" ) << "PolygonM ((0 0 1, 0 10 2, 10 10 3, 10 0 4, 0 0 1))";
+  QTest::newRow( "empty polygon" ) << "Polygon EMPTY";
+  QTest::newRow( "multi point" ) << "MultiPoint ((1 2),(3 4),(-5 6))";
+  QTest::newRow( "multi line string m" ) << "MultiLineStringM ((0 0 1, 10 0 2),(0 5 3, 10 5 4, 10 20 5))";
+  QTest::newRow( "multi polygon" ) << "MultiPolygon (((0 0, 10 0, 10 10, 0 10, 0 0),(2 2, 2 4, 4 4, 4 2, 2 2)),((20 20, 30 20, 30 25, 20 20)))";
+  QTest::newRow( "empty multi polygon" ) << "MultiPolygon EMPTY";
+  QTest::newRow( "flat polygon" ) << "Polygon ((0 0, 10 0, 20 0, 0 0))";
+}
+
+void TestQgsWkbGeometryView::view()
+{
+  QFETCH( QString, wkt );
+
+  QgsGeometry geometry = QgsGeometry::fromWkt( wkt );
+  QVERIFY( !geometry.isNull() );
+  const QByteArray wkb = geometry.geometry()->asWkb();
+
+  QgsWkbGeometryView view( wkb );
+  QVERIFY( view.isValid() );
+  QCOMPARE( view.wkbSize(), wkb.size() );
+  QVERIFY( view.hasNativeByteOrder() );
+  QCOMPARE( view.wkbType(), geometry.geometry()->wkbType() );
+  QCOMPARE( view.partCount(), geometry.geometry()->partCount() );
+  QCOMPARE( view.isEmpty(), geometry.geometry()->isEmpty() );
+  QCOMPARE( view.boundingBox(), geometry.geometry()->boundingBox() );
+
+  if ( !geometry.isEmpty() )
+  {
+    // same centroid as GEOS
+    QgsPointXY centroid = geometry.centroid().asPoint();
+    QGSCOMPARENEAR( view.centroid().x(), centroid.x(), 0.000000001 );
+    QGSCOMPARENEAR( view.centroid().y(), centroid.y(), 0.000000001 );
+  }
+
+  // the rings of the parts, as the vertices of the parsed geometry
+  QList< QPolygonF > rings;
+  QgsVertexId vertexId;
+  QgsPoint vertex;
+  for ( int part = 0; part < view.partCount(); ++part )
+  {
+    view.partRings( part, rings );
+    Q_FOREACH ( const QPolygonF &ring, rings )
+    {
+      Q_FOREACH ( QPointF point, ring )
+      {
+        QVERIFY( geometry.geometry()->nextVertex( vertexId, vertex ) );
+        QCOMPARE( vertexId.part, part );
+        QCOMPARE( point, vertex.toQPointF() );
+      }
+    }
+  }
+  QVERIFY( !geometry.geometry()->nextVertex( vertexId, vertex ) );
+
+  view.partRings( view.partCount(), rings );
+  QVERIFY( rings.isEmpty() );
+}
+
+void TestQgsWkbGeometryView::invalid()
+{
+  QVERIFY( !QgsWkbGeometryView().isValid() );
+  QVERIFY( !QgsWkbGeometryView( QByteArray() ).isValid() );
+  QCOMPARE( QgsWkbGeometryView().boundingBox(), QgsRectangle() );
+
+  const QByteArray wkb = QgsGeometry::fromWkt( QStringLiteral( "MultiLineString ((0 0, 10 0),(0 5, 10 5))" ) ).exportToWkb();
+  QVERIFY( QgsWkbGeometryView( wkb ).isValid() );
+  // truncated
+  QVERIFY( !QgsWkbGeometryView( wkb.left( wkb.size() - 1 ) ).isValid() );
+  QVERIFY( !QgsWkbGeometryView( wkb.left( 3 ) ).isValid() );
+  // invalid byte order
+  QByteArray badByteOrder = wkb;
+  badByteOrder[0] = 2;
+  QVERIFY( !QgsWkbGeometryView( badByteOrder ).isValid() );
+
+  // curves and collections are not viewed
+  QVERIFY( !QgsWkbGeometryView( QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).exportToWkb() ).isValid() );
+  QVERIFY( !QgsWkbGeometryView( QgsGeometry::fromWkt( QStringLiteral( "GeometryCollection (Point (1 2))" ) ).exportToWkb() ).isValid() );
+
+  // negative counts
+  WkbWriter negative;
+  negative.header( QgsWkbTypes::LineString ) << -1;
+  QVERIFY( !QgsWkbGeometryView( negative.wkb() ).isValid() );
+
+  // a count larger than the WKB
+  WkbWriter tooLarge;
+  tooLarge.header( QgsWkbTypes::Polygon ) << 1 << 1000000000 << 0.0 << 0.0;
+  QVERIFY( !QgsWkbGeometryView( tooLarge.wkb() ).isValid() );
+
+  // parts which would change the type of the collection when parsed
+  WkbWriter mixed;
+  mixed.header( QgsWkbTypes::MultiPoint ) << 1;
+  mixed.header( QgsWkbTypes::PointZ ) << 1.0 << 2.0 << 3.0;
+  QVERIFY( !QgsWkbGeometryView( mixed.wkb() ).isValid() );
+
+  WkbWriter multi25D;
+  multi25D.header( QgsWkbTypes::MultiPoint25D ) << 1;
+  multi25D.header( QgsWkbTypes::Point25D ) << 1.0 << 2.0 << 3.0;
+  QVERIFY( !QgsWkbGeometryView( multi25D.wkb() ).isValid() );
+
+  WkbWriter single25D;
+  single25D.header( QgsWkbTypes::LineString25D ) << 2 << 1.0 << 2.0 << 3.0 << 4.0 << 5.0 << 6.0;
+  QgsWkbGeometryView view25D( single25D.wkb() );
+  QVERIFY( view25D.isValid() );
+  QCOMPARE( view25D.boundingBox(), QgsRectangle( 1, 2, 4, 5 ) );
+
+  // geometries which cannot be viewed are still parsed
+  QgsGeometry geometry;
+  geometry.fromWkb( multi25D.wkb() );
+  QVERIFY( !geometry.wkbView() );
+  QCOMPARE( geometry.wkbType(), QgsWkbTypes::MultiPointZ );
+}
+
+void TestQgsWkbGeometryView::byteOrder()
+{
+  WkbWriter swapped( true );
+  swapped.header( QgsWkbTypes::MultiLineStringZ ) << 2;
+  swapped.header( QgsWkbTypes::LineStringZ ) << 2 << 0.0 << 0.0 << 1.0 << 10.0 << 5.0 << 2.0;
+  swapped.header( QgsWkbTypes::LineStringZ ) << 3 << -5.0 << 20.0 << 3.0 << 0.0 << 3.0 << 4.0 << 5.0 << 5.0 << 5.0;
+  const QByteArray wkb = swapped.wkb();
+
+  QgsConstWkbPtr ptr( wkb );
+  std::unique_ptr< QgsAbstractGeometry > parsed( QgsGeometryFactory::geomFromWkb( ptr ) );
+  QVERIFY( parsed );
+
+  QgsWkbGeometryView view( wkb );
+  QVERIFY( view.isValid() );
+  QVERIFY( !view.hasNativeByteOrder() );
+  QCOMPARE( view.wkbType(), QgsWkbTypes::MultiLineStringZ );
+  QCOMPARE( view.partCount(), 2 );
+  QCOMPARE( view.boundingBox(), parsed->boundingBox() );
+  QCOMPARE( view.boundingBox(), QgsRectangle( -5, 0, 10, 20 ) );
+
+  QList< QPolygonF > rings;
+  view.partRings( 1, rings );
+  QCOMPARE( rings.size(), 1 );
+  QCOMPARE( rings.at( 0 ), QPolygonF() << QPointF( -5, 20 ) << QPointF( 0, 3 ) << QPointF( 5, 5 ) );
+
+  // exported in the native byte order
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb );
+  QVERIFY( geometry.wkbView() );
+  QCOMPARE( geometry.exportToWkb(), parsed->asWkb() );
+}
+
+void TestQgsWkbGeometryView::lazyGeometry()
+{
+  QgsGeometry parsed = QgsGeometry::fromWkt( QStringLiteral( "MultiPolygon (((0 0, 10 0, 10 10, 0 10, 0 0)),((20 20, 30 20, 30 25, 20 20)))" ) );
+  const QByteArray wkb = parsed.exportToWkb();
+
+  QgsGeometry geometry;
+  geometry.fromWkb( wkb + QByteArray( "trailing bytes" ) );
+  QVERIFY( geometry.wkbView() );
+
+  // answered from the WKB, without parsing it
+  QVERIFY( !geometry.isNull() );
+  QVERIFY( !geometry.isEmpty() );
+  QVERIFY( geometry.isMultipart() );
+  QCOMPARE( geometry.wkbType(), QgsWkbTypes::MultiPolygon );
+  QCOMPARE( geometry.type(), QgsWkbTypes::PolygonGeometry );
+  QCOMPARE( geometry.boundingBox(), parsed.boundingBox() );
+  QCOMPARE( geometry.exportToWkb(), wkb );
+  QVERIFY( geometry.wkbView() );
+
+  // copies share the WKB until they are modified
+  QgsGeometry copy = geometry;
+  QVERIFY( copy.wkbView() );
+  QCOMPARE( copy.translate( 100, 100 ), QgsGeometry::Success );
+  QVERIFY( !copy.wkbView() );
+  QCOMPARE( copy.boundingBox(), QgsRectangle( 100, 100, 130, 125 ) );
+  QVERIFY( geometry.wkbView() );
+  QCOMPARE( geometry.boundingBox(), QgsRectangle( 0, 0, 30, 25 ) );
+
+  // parsed when the geometry is accessed
+  QVERIFY( geometry.geometry() );
+  QVERIFY( !geometry.wkbView() );
+  QCOMPARE( geometry.exportToWkt(), parsed.exportToWkt() );
+  QCOMPARE( geometry.exportToWkb(), wkb );
+  QVERIFY( geometry.equals( parsed ) );
+
+  // from a buffer owned by the geometry
+  unsigned char *buffer = new unsigned char[wkb.size()];
+  memcpy( buffer, wkb.constData(), wkb.size() );
+  QgsGeometry fromBuffer;
+  fromBuffer.fromWkb( buffer, wkb.size() );
+  QVERIFY( fromBuffer.wkbView() );
+  QCOMPARE( fromBuffer.exportToWkt(), parsed.exportToWkt() );
+
+  // curves are parsed straight away
+  QgsGeometry curve;
+  curve.fromWkb( QgsGeometry::fromWkt( QStringLiteral( "CircularString (0 0, 1 1, 2 0)" ) ).exportToWkb() );
+  QVERIFY( !curve.wkbView() );
+  QCOMPARE( curve.wkbType(), QgsWkbTypes::CircularString );
+
+  // invalid WKB gives a null geometry, as before
+  QgsGeometry invalid;
+  invalid.fromWkb( wkb.left( 20 ) );
+  QVERIFY( invalid.isNull() );
+  QVERIFY( !invalid.wkbView() );
+}
+
+QImage TestQgsWkbGeometryView::renderImage( QgsSymbol *symbol, const QgsGeometry &geometry )
+{
+  QImage image( 200, 200, QImage::Format_ARGB32_Premultiplied );
+  image.fill( Qt::white );
+  QPainter painter( &image );
+
+  QgsRenderContext context = QgsRenderContext::fromQPainter( &painter );
+  context.setExtent( QgsRectangle( 0, 0, 100, 100 ) );
+  context.setMapToPixel( QgsMapToPixel( 0.5, 50, 50, 200, 200, 0 ) );
+
+  QgsFeature feature;
+  feature.setGeometry( geometry );
+  symbol->startRender( context );
+  symbol->renderFeature( feature, context );
+  symbol->stopRender( context );
+  painter.end();
+  return image;
+}
+
+void TestQgsWkbGeometryView::render()
+{
+  QgsStringMap lineProperties;
+  lineProperties.insert( QStringLiteral( "line_width" ), QStringLiteral( "2" ) );
+  std::unique_ptr< QgsLineSymbol > lineSymbol( QgsLineSymbol::createSimple( lineProperties ) );
+  QgsStringMap fillProperties;
+  fillProperties.insert( QStringLiteral( "color" ), QStringLiteral( "255,0,0" ) );
+  std::unique_ptr< QgsFillSymbol > fillSymbol( QgsFillSymbol::createSimple( fillProperties ) );
+
+  QList< QPair< QgsSymbol *, QString > > cases;
+  cases << qMakePair< QgsSymbol *, QString >( lineSymbol.get(), QStringLiteral( "LineString (10 10, 50 90, 90 20)" ) )
+        << qMakePair< QgsSymbol *, QString >( lineSymbol.get(), QStringLiteral( "MultiLineStringZ ((-500 50 1, 500 60 1),(20 20 1, 30 80 1))" ) )
+        << qMakePair< QgsSymbol *, QString >( fillSymbol.get(), QStringLiteral( "Polygon ((10 10, 90 10, 90 90, 10 90, 10 10),(30 30, 30 60, 60 60, 60 30, 30 30))" ) )
+        << qMakePair< QgsSymbol *, QString >( fillSymbol.get(), QStringLiteral( "MultiPolygon (((-200 -200, 50 -200, 50 50, -200 50, -200 -200)),((60 60, 95 60, 95 95, 60 60)))" ) );
+
+  for ( int i = 0; i < cases.size(); ++i )
+  {
+    const QgsGeometry parsed = QgsGeometry::fromWkt( cases.at( i ).second );
+    QgsGeometry lazy;
+    lazy.fromWkb( parsed.exportToWkb() );
+
+    // the same image as rendered from the parsed geometry, without parsing the WKB
+    const QImage expected = renderImage( cases.at( i ).first, parsed );
+    QCOMPARE( renderImage( cases.at( i ).first, lazy ), expected );
+    QVERIFY( lazy.wkbView() );
+  }
+}
+
+QGSTEST_MAIN( TestQgsWkbGeometryView )
+#include "testqgswkbgeometryview.moc"
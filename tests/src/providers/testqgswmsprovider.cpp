@@ -12,11 +12,83 @@
  *   (at your option) any later version.                                   *
  *                                                                         *
  ***************************************************************************/
+#include <QBuffer>
 #include <QFile>
 #include <QObject>
+#include <QSemaphore>
+#include <QSignalSpy>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+#include <QThreadPool>
 #include "qgstest.h"
 #include <qgswmsprovider.h>
+#include <qgstilecache.h>
 #include <qgsapplication.h>
+#include <qgsdatasourceuri.h>
+#include <qgsmaprendererparalleljob.h>
+#include <qgsmapsettings.h>
+#include <qgsrasterlayer.h>
+
+/**
+ * Minimal HTTP server answering every request with the same tile. It runs in its own
+ * thread, as the main thread is waiting for the map renderer.
+ */
+class TileServer : public QThread
+{
+  public:
+    explicit TileServer( const QByteArray &tile )
+      : mTile( tile )
+    {}
+
+    ~TileServer()
+    {
+      quit();
+      wait();
+    }
+
+    //! Starts the server and returns the port it listens to
+    quint16 listen()
+    {
+      start();
+      mReady.acquire();
+      return mPort;
+    }
+
+  protected:
+    void run() override
+    {
+      QTcpServer server;
+      server.listen( QHostAddress::LocalHost );
+      QByteArray tile = mTile;
+      connect( &server, &QTcpServer::newConnection, &server, [&server, tile]
+      {
+        while ( QTcpSocket *socket = server.nextPendingConnection() )
+        {
+          connect( socket, &QTcpSocket::readyRead, socket, [socket, tile]
+          {
+            QByteArray request = socket->property( "request" ).toByteArray() + socket->readAll();
+            socket->setProperty( "request", request );
+            if ( !request.contains( "\r\n\r\n" ) )
+              return;
+
+            socket->write( "HTTP/1.1 200 OK\r\nContent-Type: image/png\r\nContent-Length: " + QByteArray::number( tile.size() ) +
+                           "\r\nConnection: close\r\n\r\n" + tile );
+            socket->disconnectFromHost();
+          } );
+          connect( socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater );
+        }
+      } );
+      mPort = server.serverPort();
+      mReady.release();
+      exec();
+    }
+
+  private:
+    QByteArray mTile;
+    quint16 mPort = 0;
+    QSemaphore mReady;
+};
 
 /** \ingroup UnitTests
  * This is a unit test for the WMS provider.
@@ -75,6 +147,70 @@ class TestQgsWmsProvider: public QObject
       QCOMPARE( provider.getLegendGraphicUrl(), QString( "http://localhost:8380/mapserv?" ) );
     }
 
+    void tileCache()
+    {
+      // paletted tiles are converted to a format which is fast to paint
+      QImage paletted( 16, 16, QImage::Format_Indexed8 );
+      paletted.setColorTable( QVector<QRgb>() << qRgb( 255, 0, 0 ) << qRgba( 0, 0, 255, 0 ) );
+      paletted.fill( 0 );
+      paletted.setPixel( 3, 4, 1 );
+      QByteArray data;
+      QBuffer buffer( &data );
+      QVERIFY( paletted.save( &buffer, "PNG" ) );
+
+      QImage decoded = QgsTileCache::decodeTile( data );
+      QCOMPARE( decoded.format(), QImage::Format_ARGB32_Premultiplied );
+      QCOMPARE( decoded.pixel( 0, 0 ), qRgb( 255, 0, 0 ) );
+      QCOMPARE( qAlpha( decoded.pixel( 3, 4 ) ), 0 );
+      QVERIFY( QgsTileCache::decodeTile( QByteArray( "not an image" ) ).isNull() );
+
+      QUrl url( QStringLiteral( "http://localhost/tiles/1/2/3.png" ) );
+      QUrl missingUrl( QStringLiteral( "http://localhost/tiles/1/2/4.png" ) );
+      QgsTileCache::insertTile( url, decoded );
+      QList<QImage> images = QgsTileCache::tiles( QList<QUrl>() << missingUrl << url );
+      QCOMPARE( images.count(), 2 );
+      QVERIFY( images.at( 0 ).isNull() );
+      QCOMPARE( images.at( 1 ), decoded );
+    }
+
+    void renderTilesWithOneThread()
+    {
+      // tiles are decoded by threads of their own, so a layer is rendered even when it
+      // takes the only thread of the global pool
+      QImage tile( 256, 256, QImage::Format_RGB32 );
+      tile.fill( qRgb( 255, 0, 0 ) );
+      QByteArray data;
+      QBuffer buffer( &data );
+      QVERIFY( tile.save( &buffer, "PNG" ) );
+
+      TileServer server( data );
+      quint16 port = server.listen();
+      QVERIFY( port > 0 );
+
+      QgsDataSourceUri uri;
+      uri.setParam( QStringLiteral( "type" ), QStringLiteral( "xyz" ) );
+      uri.setParam( QStringLiteral( "url" ), QStringLiteral( "http://127.0.0.1:%1/{z}/{x}/{y}.png" ).arg( port ) );
+      uri.setParam( QStringLiteral( "zmax" ), QStringLiteral( "0" ) );
+      QgsRasterLayer layer( QString( uri.encodedUri() ), QStringLiteral( "tiles" ), QStringLiteral( "wms" ) );
+      QVERIFY( layer.isValid() );
+
+      QgsMapSettings settings;
+      settings.setLayers( QList<QgsMapLayer *>() << &layer );
+      settings.setDestinationCrs( QgsCoordinateReferenceSystem( QStringLiteral( "EPSG:3857" ) ) );
+      settings.setExtent( QgsRectangle( -20037508.34, -20037508.34, 20037508.34, 20037508.34 ) );
+      settings.setOutputSize( QSize( 256, 256 ) );
+
+      int maxThreads = QThreadPool::globalInstance()->maxThreadCount();
+      QThreadPool::globalInstance()->setMaxThreadCount( 1 );
+      QgsMapRendererParallelJob job( settings );
+      QSignalSpy spy( &job, &QgsMapRendererJob::finished );
+      job.start();
+      bool finished = spy.wait( 60000 );
+      QThreadPool::globalInstance()->setMaxThreadCount( maxThreads );
+      QVERIFY( finished );
+      QCOMPARE( job.renderedImage().pixel( 128, 128 ), qRgb( 255, 0, 0 ) );
+    }
+
   private:
     QgsWmsCapabilities *mCapabilities = nullptr;
 };
@@ -23,7 +23,9 @@ from qgis.core import (
     QgsVectorLayerExporter,
     QgsFeatureRequest,
     QgsFeature,
+    QgsFeatureSink,
     QgsFieldConstraints,
+    QgsGeometry,
     QgsDataProvider,
     NULL,
     QgsVectorLayerUtils,
@@ -157,6 +159,112 @@ class TestPyQgsPostgresProvider(unittest.TestCase, ProviderTestCase):
 
         test_query(self.dbconn, '(SELECT NULL::integer "Id1", NULL::integer "Id2", NULL::geometry(Point, 4326) geom LIMIT 0)', '"Id1","Id2"')
 
+    def testNumericTypesManyFeatures(self):
+        """
+        Test numeric attributes read in the binary format, over several fetches from the cursor
+        """
+        query = ('(SELECT i "id", i::int2 "i2", (i * 1000)::int4 "i4", (i * 10000000000)::int8 "i8", '
+                 '(i + 0.1)::float4 "f4", i::float8 / 3 "f8", (i::float8 / 3)::text "f8text", CASE WHEN i % 7 = 0 THEN NULL ELSE i END "withnull" '
+                 'FROM generate_series(1, 20000) i)')
+        vl = QgsVectorLayer('%s table="%s" key=\'id\' sql=' % (self.dbconn, query), "numbers", "postgres")
+        self.assertTrue(vl.isValid())
+
+        fields = vl.fields()
+        self.assertEqual(fields.at(fields.indexFromName('i2')).type(), QVariant.Int)
+        self.assertEqual(fields.at(fields.indexFromName('i8')).type(), QVariant.LongLong)
+        self.assertEqual(fields.at(fields.indexFromName('f4')).type(), QVariant.Double)
+
+        count = 0
+        for f in vl.getFeatures():
+            i = f['id']
+            self.assertEqual(f['i2'], i)
+            self.assertEqual(f['i4'], i * 1000)
+            self.assertEqual(f['i8'], i * 10000000000)
+            # float4 values are read with the precision PostgreSQL shows them with
+            self.assertEqual(f['f4'], float('{}.1'.format(i)))
+            # so are float8 values, whether they are read in the binary format or as text
+            self.assertEqual(f['f8'], float(f['f8text']))
+            self.assertEqual(f['withnull'], NULL if i % 7 == 0 else i)
+            count += 1
+        self.assertEqual(count, 20000)
+        self.assertEqual(vl.getFeature(1)['f4'], 1.1)
+
+        # stop iterating after a few features
+        it = vl.getFeatures()
+        f = QgsFeature()
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.nextFeature(f))
+        self.assertTrue(it.nextFeature(f))
+        it.close()
+        self.assertEqual(len([f for f in vl.getFeatures(QgsFeatureRequest().setLimit(3))]), 3)
+
+    def testPrefetchPendingOnRewindAndClose(self):
+        """
+        Test iterators rewound or closed while the next rows of the cursor are being fetched
+        """
+        query = '(SELECT i "id", i * 2 "value" FROM generate_series(1, 100) i ORDER BY i)'
+        vl = QgsVectorLayer('%s table="%s" key=\'id\' sql=' % (self.dbconn, query), "numbers", "postgres")
+        self.assertTrue(vl.isValid())
+
+        def readFeatures(it, count):
+            ids = []
+            f = QgsFeature()
+            while len(ids) < count and it.nextFeature(f):
+                self.assertEqual(f['value'], f['id'] * 2)
+                ids.append(f['id'])
+            return ids
+
+        # the cursor is fetched 1, 2, 4... rows at a time, the next rows are requested from the second fetch on
+        it = vl.getFeatures()
+        self.assertEqual(readFeatures(it, 10), list(range(1, 11)))
+        self.assertTrue(it.rewind())
+        self.assertEqual(readFeatures(it, 100), list(range(1, 101)))
+        f = QgsFeature()
+        self.assertFalse(it.nextFeature(f))
+
+        # the connection released with a pending fetch is usable by the next iterators
+        for i in range(3):
+            it = vl.getFeatures()
+            self.assertEqual(readFeatures(it, 10), list(range(1, 11)))
+            self.assertTrue(it.close())
+        self.assertEqual(len([f for f in vl.getFeatures()]), 100)
+
+    def testAddFeaturesFastInsert(self):
+        """
+        Test features added in bulk, without returning the ids of the new features
+        """
+        self.execSQLCommand('DROP TABLE IF EXISTS qgis_test.copy_test')
+        self.execSQLCommand('CREATE TABLE qgis_test.copy_test ( pk SERIAL NOT NULL PRIMARY KEY, cnt integer, name text, value double precision, flag integer DEFAULT 42, geom public.geometry(MultiPoint, 4326))')
+        vl = QgsVectorLayer('%s sslmode=disable key=\'pk\' srid=4326 type=MULTIPOINT table="qgis_test"."copy_test" (geom) sql=' % (self.dbconn), "copy_test", "postgres")
+        self.assertTrue(vl.isValid())
+
+        features = []
+        for i in range(100):
+            f = QgsFeature(vl.fields())
+            f['cnt'] = i
+            f['name'] = 'name\t{}\n\\'.format(i) if i % 2 else NULL
+            f['value'] = i / 3.0
+            if i % 10:
+                f.setGeometry(QgsGeometry.fromWkt('Point ({} {})'.format(i, -i)))
+            features.append(f)
+        self.assertTrue(vl.dataProvider().addFeatures(features, QgsFeatureSink.FastInsert))
+
+        vl = QgsVectorLayer('%s sslmode=disable key=\'pk\' srid=4326 type=MULTIPOINT table="qgis_test"."copy_test" (geom) sql=' % (self.dbconn), "copy_test", "postgres")
+        self.assertEqual(vl.featureCount(), 100)
+        pks = set()
+        for f in vl.getFeatures():
+            i = f['cnt']
+            pks.add(f['pk'])
+            self.assertEqual(f['name'], 'name\t{}\n\\'.format(i) if i % 2 else NULL)
+            self.assertAlmostEqual(f['value'], i / 3.0)
+            # NULL values are copied rather than replaced by the default, like with INSERT statements
+            self.assertEqual(f['flag'], NULL)
+            if i % 10:
+                self.assertEqual(f.geometry().exportToWkt(), 'MultiPoint (({} {}))'.format(i, -i))
+            else:
+                self.assertFalse(f.hasGeometry())
+        self.assertEqual(len(pks), 100)
+
     def testWkbTypes(self):
         def test_table(dbconn, table_name, wkt):
             vl = QgsVectorLayer('%s srid=4326 table="qgis_test".%s (geom) sql=' % (dbconn, table_name), "testgeom", "postgres")
@@ -27,6 +27,7 @@ import qgis  # NOQA
 
 import os
 import re
+import shutil
 import tempfile
 import inspect
 import time
@@ -35,7 +36,7 @@ import collections
 
 rebuildTests = 'REBUILD_DELIMITED_TEXT_TESTS' in os.environ
 
-from qgis.PyQt.QtCore import QCoreApplication, QUrl, QObject
+from qgis.PyQt.QtCore import QCoreApplication, QUrl, QObject, QFileInfo
 
 from qgis.core import (
     QgsProviderRegistry,
@@ -43,7 +44,10 @@ from qgis.core import (
     QgsFeatureRequest,
     QgsRectangle,
     QgsApplication,
-    QgsFeature)
+    QgsFeature,
+    QgsGeometry,
+    QgsPointXY,
+    QgsSpatialIndex)
 
 from qgis.testing import start_app, unittest
 from utilities import unitTestDataPath, compareWkt
@@ -156,6 +160,34 @@ class TestQgsDelimitedTextProviderXY(unittest.TestCase, ProviderTestCase):
         """Run after all tests"""
 
 
+class TestQgsDelimitedTextProviderXYRecordIndex(unittest.TestCase, ProviderTestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        """Run before all tests"""
+        # Create test layer reading the memory-mapped file
+        srcpath = os.path.join(TEST_DATA_DIR, 'provider')
+        cls.basetestfile = os.path.join(srcpath, 'delimited_xy.csv')
+
+        url = MyUrl.fromLocalFile(cls.basetestfile)
+        url.addQueryItem("crs", "epsg:4326")
+        url.addQueryItem("type", "csv")
+        url.addQueryItem("xField", "X")
+        url.addQueryItem("yField", "Y")
+        url.addQueryItem("spatialIndex", "no")
+        url.addQueryItem("subsetIndex", "no")
+        url.addQueryItem("watchFile", "no")
+        url.addQueryItem("recordIndex", "yes")
+
+        cls.vl = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        assert cls.vl.isValid(), "{} is invalid".format(cls.basetestfile)
+        cls.source = cls.vl.dataProvider()
+
+    @classmethod
+    def tearDownClass(cls):
+        """Run after all tests"""
+
+
 class TestQgsDelimitedTextProviderWKT(unittest.TestCase, ProviderTestCase):
 
     @classmethod
@@ -805,6 +837,116 @@ class TestQgsDelimitedTextProviderOther(unittest.TestCase):
         requests = None
         self.runTest(filename, requests, **params)
 
+    def test_041_record_index(self):
+        # Parsing the memory-mapped file gives the same results as reading it as a text stream
+        tests = [
+            ('testfields.csv', {'geomType': 'none', 'type': 'csv'}, None),
+            ('testfields.csv', {'geomType': 'none', 'maxFields': '7', 'type': 'csv'}, None),
+            ('test.space', {'geomType': 'none', 'type': 'whitespace'}, None),
+            ('test.pipe', {'geomType': 'none', 'quote': '"', 'delimiter': '|', 'escape': '\\'}, None),
+            ('test.quote', {'geomType': 'none', 'quote': '\'"', 'type': 'csv', 'escape': '"\''}, None),
+            ('test.badquote', {'geomType': 'none', 'quote': '"', 'type': 'csv', 'escape': '"'}, None),
+            ('test2.csv', {'geomType': 'none', 'useHeader': 'no', 'type': 'csv', 'skipLines': '2'}, None),
+            ('testwkt.csv', {'delimiter': '|', 'type': 'csv', 'wktField': 'geom_wkt'}, None),
+            ('testdp.csv', {'yField': 'geom_y', 'xField': 'geom_x', 'type': 'csv', 'delimiter': ';', 'decimalPoint': ','}, None),
+            ('testre.txt', {'geomType': 'none', 'trimFields': 'Y', 'delimiter': 'RE(?:GEXP)?', 'type': 'regexp'}, None),
+            ('testutf8.csv', {'geomType': 'none', 'delimiter': '|', 'type': 'csv', 'encoding': 'utf-8'}, None),
+            ('testlatin1.csv', {'geomType': 'none', 'delimiter': '|', 'type': 'csv', 'encoding': 'latin1'}, None),
+            ('testextpt.txt', {'yField': 'y', 'delimiter': '|', 'type': 'csv', 'xField': 'x', 'spatialIndex': 'yes'},
+             [{'extents': [10, 30, 30, 50]}, {'extents': [110, 130, 130, 150]}]),
+            ('test.csv', {'geomType': 'none', 'type': 'csv'},
+             [{'fid': 20}, {'fid': 3}, {'attributes': [1, 3]}, {'attributes': [3, 1], 'fid': 9}, {'attributes': [], 'fid': 9}]),
+        ]
+        for filename, params, requests in tests:
+            expected = self.delimitedTextData('test_041', filename, requests, False, **params)
+            params['recordIndex'] = 'yes'
+            result = self.delimitedTextData('test_041', filename, requests, False, **params)
+            for key in ('fields', 'fieldTypes', 'geometryType', 'data', 'log'):
+                self.assertEqual(result[key], expected[key], '{} differs for {}'.format(key, filename))
+
+    def test_042_record_index_file(self):
+        # Scan results are read from the record index file while the data file is unchanged
+        tmpdir = tempfile.mkdtemp()
+        filename = os.path.join(tmpdir, 'testextpt.txt')
+        shutil.copy(os.path.join(unitTestDataPath("delimitedtext"), 'testextpt.txt'), filename)
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem('type', 'csv')
+        url.addQueryItem('delimiter', '|')
+        url.addQueryItem('xField', 'x')
+        url.addQueryItem('yField', 'y')
+        url.addQueryItem('recordIndex', 'file')
+
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer.isValid())
+        self.assertTrue(os.path.exists(filename + '.qdi'))
+        features = dict((f.id(), f.attributes()) for f in layer.getFeatures())
+
+        layer2 = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer2.isValid())
+        self.assertEqual(layer2.featureCount(), layer.featureCount())
+        self.assertEqual(layer2.extent(), layer.extent())
+        self.assertEqual([f.typeName() for f in layer2.fields()], [f.typeName() for f in layer.fields()])
+        for fid in reversed(sorted(features.keys())):
+            f = next(layer2.getFeatures(QgsFeatureRequest(fid)))
+            self.assertEqual(f.attributes(), features[fid])
+
+        # the index file is replaced once the data file changes
+        with open(filename, 'a') as f:
+            f.write('100|Added|1000|1000\n')
+        layer3 = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer3.isValid())
+        self.assertEqual(layer3.featureCount(), layer.featureCount() + 1)
+        self.assertEqual(layer3.extent().xMaximum(), 1000)
+        shutil.rmtree(tmpdir, True)
+
+    def test_043_spatial_index_file(self):
+        # A valid spatial index file is used without scanning the file again,
+        # a stale one is dropped and rebuilt
+        tmpdir = tempfile.mkdtemp()
+        filename = os.path.join(tmpdir, 'testextpt.txt')
+        shutil.copy(os.path.join(unitTestDataPath("delimitedtext"), 'testextpt.txt'), filename)
+        url = MyUrl.fromLocalFile(filename)
+        url.addQueryItem('type', 'csv')
+        url.addQueryItem('delimiter', '|')
+        url.addQueryItem('xField', 'x')
+        url.addQueryItem('yField', 'y')
+        url.addQueryItem('spatialIndex', 'file')
+
+        layer = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer.isValid())
+        indexFile = QgsSpatialIndex.indexFileName(filename)
+        self.assertTrue(os.path.exists(indexFile))
+        self.assertTrue(os.path.exists(filename + '.qdi'))
+        count = layer.featureCount()
+        extent = layer.extent()
+        modified = QFileInfo(filename).lastModified()
+        self.assertTrue(QgsSpatialIndex().readFromFile(indexFile, modified, count))
+        inExtent = sorted(f.id() for f in layer.getFeatures(QgsFeatureRequest(extent)))
+
+        # the record index is not rewritten when the scan results are read from it
+        recordIndexTime = os.path.getmtime(filename + '.qdi')
+        time.sleep(1.1)
+        layer2 = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer2.isValid())
+        self.assertEqual(os.path.getmtime(filename + '.qdi'), recordIndexTime)
+        self.assertEqual(layer2.featureCount(), count)
+        self.assertEqual(layer2.extent(), extent)
+        self.assertEqual(sorted(f.id() for f in layer2.getFeatures(QgsFeatureRequest(extent))), inExtent)
+
+        # an index with a different feature count is dropped and rebuilt
+        stale = QgsSpatialIndex()
+        f = QgsFeature(1)
+        f.setGeometry(QgsGeometry.fromPoint(QgsPointXY(1, 1)))
+        stale.insertFeature(f)
+        self.assertTrue(stale.writeToFile(indexFile, modified, count + 1))
+        layer3 = QgsVectorLayer(url.toString(), 'test', 'delimitedtext')
+        self.assertTrue(layer3.isValid())
+        self.assertEqual(layer3.featureCount(), count)
+        self.assertEqual(layer3.extent(), extent)
+        self.assertTrue(QgsSpatialIndex().readFromFile(indexFile, modified, count))
+        self.assertEqual(sorted(f.id() for f in layer3.getFeatures(QgsFeatureRequest(extent))), inExtent)
+        shutil.rmtree(tmpdir, True)
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -32,14 +32,17 @@ import os
 os.environ['QT_HASH_SEED'] = '1'
 
 import re
+import json
+import shutil
 import urllib.request
 import urllib.parse
 import urllib.error
 import email
+import xml.etree.ElementTree as ET
 
 from io import StringIO
 from qgis.server import QgsServer, QgsServerRequest, QgsBufferServerRequest, QgsBufferServerResponse
-from qgis.core import QgsRenderChecker, QgsApplication, QgsFontUtils
+from qgis.core import QgsRenderChecker, QgsApplication, QgsFontUtils, QgsProject, QgsVectorLayer
 from qgis.testing import unittest
 from qgis.PyQt.QtCore import QSize
 from utilities import unitTestDataPath
@@ -405,6 +408,34 @@ class TestQgsServer(QgsServerTestBase):
         for id, req in tests:
             self.wfs_getfeature_post_compare(id, req)
 
+    def test_getfeature_escaped_values(self):
+        """Attribute values read back from GetFeature responses as they are stored"""
+        value = 'lt < gt > amp & quot " apos \' cdata ]]> tab \t lf \n cr \r end'
+        tmpdir = tempfile.mkdtemp()
+        layerPath = os.path.join(tmpdir, 'escaped.geojson')
+        with open(layerPath, 'w') as f:
+            json.dump({'type': 'FeatureCollection',
+                       'features': [{'type': 'Feature',
+                                     'properties': {'name': value},
+                                     'geometry': {'type': 'Point', 'coordinates': [8.2, 44.9]}}]}, f)
+
+        project = QgsProject()
+        layer = QgsVectorLayer(layerPath, 'escaped', 'ogr')
+        self.assertTrue(layer.isValid())
+        project.addMapLayer(layer)
+        project.writeEntry('WFSLayers', '/', [layer.id()])
+        projectPath = os.path.join(tmpdir, 'escaped.qgs')
+        self.assertTrue(project.write(projectPath))
+
+        for version in ('1.0.0', '1.1.0'):
+            query_string = '?MAP=%s&SERVICE=WFS&VERSION=%s&REQUEST=GetFeature&TYPENAME=escaped' % (urllib.parse.quote(projectPath), version)
+            header, body = self._execute_request(query_string)
+            names = ET.fromstring(body).findall('.//{http://www.qgis.org/gml}name')
+            self.assertEqual(len(names), 1, body)
+            self.assertEqual(names[0].text, value, version)
+
+        shutil.rmtree(tmpdir, True)
+
     # WCS tests
     def wcs_request_compare(self, request):
         project = self.projectPath
@@ -133,6 +133,49 @@ class TestQgsServerSettings(unittest.TestCase):
         self.assertEqual(self.settings.cacheDirectory(), "/tmp/fake")
         os.environ.pop(env)
 
+    def test_env_workers(self):
+        env = "QGIS_SERVER_WORKERS"
+
+        self.assertEqual(self.settings.workers(), 0)
+
+        os.environ[env] = "4"
+        self.settings.load()
+        self.assertEqual(self.settings.workers(), 4)
+        os.environ.pop(env)
+
+    def test_env_preload_projects(self):
+        env = "QGIS_SERVER_PRELOAD_PROJECTS"
+        env_project = "QGIS_PROJECT_FILE"
+
+        self.assertEqual(self.settings.preloadProjects(), [])
+
+        os.environ[env] = "/tmp/myproject.qgs;/tmp/myproject2.qgs;"
+        self.settings.load()
+        self.assertEqual(self.settings.preloadProjects(), ["/tmp/myproject.qgs", "/tmp/myproject2.qgs"])
+
+        # the default project is always preloaded
+        os.environ[env_project] = "/tmp/myproject2.qgs"
+        self.settings.load()
+        self.assertEqual(self.settings.preloadProjects(), ["/tmp/myproject2.qgs", "/tmp/myproject.qgs"])
+        os.environ.pop(env)
+        os.environ.pop(env_project)
+
+    def test_env_tile_cache(self):
+        self.assertEqual(self.settings.metatileSize(), 0)
+        self.assertEqual(self.settings.tileCacheDirectory(), "")
+        self.assertEqual(self.settings.tileCacheSize(), 64 * 1024 * 1024)
+
+        os.environ["QGIS_SERVER_METATILE_SIZE"] = "4"
+        os.environ["QGIS_SERVER_TILE_CACHE_DIRECTORY"] = "/tmp/tiles"
+        os.environ["QGIS_SERVER_TILE_CACHE_SIZE"] = "1024"
+        self.settings.load()
+        self.assertEqual(self.settings.metatileSize(), 4)
+        self.assertEqual(self.settings.tileCacheDirectory(), "/tmp/tiles")
+        self.assertEqual(self.settings.tileCacheSize(), 1024)
+        os.environ.pop("QGIS_SERVER_METATILE_SIZE")
+        os.environ.pop("QGIS_SERVER_TILE_CACHE_DIRECTORY")
+        os.environ.pop("QGIS_SERVER_TILE_CACHE_SIZE")
+
     def test_priority(self):
         env = "QGIS_OPTIONS_PATH"
         dpath = "conf0"
@@ -0,0 +1,204 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for QgsServerTileCache.
+
+From build dir, run: ctest -R PyQgsServerTileCache -V
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS contributors'
+__date__ = '17/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import math
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from qgis.PyQt.QtGui import QImage, QColor
+from qgis.core import QgsProject, QgsRasterLayer, QgsCoordinateReferenceSystem
+from qgis.testing import start_app, unittest
+from qgis.server import QgsServer, QgsServerMemoryTileCache, QgsServerFileTileCache, QgsBufferServerRequest, QgsBufferServerResponse
+from utilities import unitTestDataPath
+
+start_app()
+
+# Renders the GetMap requests given as arguments with a server process caching
+# tiles, and writes the images next to the project
+RENDER_TILES_SCRIPT = '''
+import os, sys
+from qgis.core import QgsApplication
+from qgis.server import QgsServer, QgsBufferServerRequest, QgsBufferServerResponse
+app = QgsApplication([], False)
+server = QgsServer()
+for i, query in enumerate(sys.argv[2:]):
+    response = QgsBufferServerResponse()
+    server.handleRequest(QgsBufferServerRequest('http://server/?' + query), response)
+    with open(os.path.join(sys.argv[1], 'tile{}.png'.format(i)), 'wb') as f:
+        f.write(bytes(response.body()))
+app.exitQgis()
+'''
+
+
+class TestQgsServerTileCache(unittest.TestCase):
+
+    def tile(self, color):
+        image = QImage(256, 256, QImage.Format_ARGB32)
+        image.fill(color)
+        return image
+
+    def checkCache(self, cache):
+        self.assertTrue(cache.tile('/projects/a.qgs', 'key1').isNull())
+
+        cache.insertTile('/projects/a.qgs', 'key1', self.tile(QColor(255, 0, 0)))
+        cache.insertTile('/projects/a.qgs', 'key2', self.tile(QColor(0, 255, 0)))
+        cache.insertTile('/projects/b.qgs', 'key1', self.tile(QColor(0, 0, 255)))
+
+        self.assertEqual(cache.tile('/projects/a.qgs', 'key1').pixelColor(10, 10), QColor(255, 0, 0))
+        self.assertEqual(cache.tile('/projects/a.qgs', 'key2').pixelColor(10, 10), QColor(0, 255, 0))
+        self.assertEqual(cache.tile('/projects/b.qgs', 'key1').pixelColor(10, 10), QColor(0, 0, 255))
+
+        # tiles of other projects are kept
+        cache.removeProject('/projects/a.qgs')
+        self.assertTrue(cache.tile('/projects/a.qgs', 'key1').isNull())
+        self.assertTrue(cache.tile('/projects/a.qgs', 'key2').isNull())
+        self.assertFalse(cache.tile('/projects/b.qgs', 'key1').isNull())
+
+    def test_memory_cache(self):
+        self.checkCache(QgsServerMemoryTileCache(16 * 1024 * 1024))
+
+        # least recently used tiles are dropped
+        cache = QgsServerMemoryTileCache(256 * 256 * 4 * 2)
+        for i in range(3):
+            cache.insertTile('/projects/a.qgs', 'key{}'.format(i), self.tile(QColor(255, 0, 0)))
+        self.assertTrue(cache.tile('/projects/a.qgs', 'key0').isNull())
+        self.assertFalse(cache.tile('/projects/a.qgs', 'key2').isNull())
+
+    def test_file_cache(self):
+        directory = tempfile.mkdtemp()
+        try:
+            self.checkCache(QgsServerFileTileCache(directory))
+
+            # tiles are shared by caches using the same directory
+            cache = QgsServerFileTileCache(directory)
+            cache.insertTile('/projects/c.qgs', 'key1', self.tile(QColor(255, 0, 0)))
+            self.assertFalse(QgsServerFileTileCache(directory).tile('/projects/c.qgs', 'key1').isNull())
+        finally:
+            shutil.rmtree(directory, True)
+
+    def test_file_cache_size(self):
+        directory = tempfile.mkdtemp()
+        try:
+            cache = QgsServerFileTileCache(directory)
+            cache.insertTile('/projects/a.qgs', 'key', self.tile(QColor(255, 0, 0)))
+            tileSize = sum(os.path.getsize(os.path.join(root, f)) for root, dirs, files in os.walk(directory) for f in files)
+            shutil.rmtree(directory, True)
+
+            # the oldest tiles are removed once the files exceed the maximum size
+            cache = QgsServerFileTileCache(directory, tileSize * 3)
+            for i in range(10):
+                cache.insertTile('/projects/a.qgs', 'key{}'.format(i), self.tile(QColor(255, 0, 0)))
+                total = sum(os.path.getsize(os.path.join(root, f)) for root, dirs, files in os.walk(directory) for f in files if f.endswith('.png'))
+                self.assertLessEqual(total, tileSize * 3)
+            self.assertFalse(cache.tile('/projects/a.qgs', 'key9').isNull())
+            self.assertTrue(cache.tile('/projects/a.qgs', 'key0').isNull())
+        finally:
+            shutil.rmtree(directory, True)
+
+    def test_lock_tiles(self):
+        directory = tempfile.mkdtemp()
+        try:
+            for cache in (QgsServerMemoryTileCache(16 * 1024 * 1024), QgsServerFileTileCache(directory)):
+                cache.lockTiles('/projects/a.qgs', 'key1')
+                # other tiles are not reserved
+                cache.lockTiles('/projects/a.qgs', 'key2')
+                cache.unlockTiles('/projects/a.qgs', 'key2')
+                cache.unlockTiles('/projects/a.qgs', 'key1')
+                # released tiles can be reserved again
+                cache.lockTiles('/projects/a.qgs', 'key1')
+                cache.unlockTiles('/projects/a.qgs', 'key1')
+        finally:
+            shutil.rmtree(directory, True)
+
+
+class TestQgsServerMetatiles(unittest.TestCase):
+
+    """Compares the tiles sliced from cached metatiles with GetMap requests rendered directly"""
+
+    @classmethod
+    def setUpClass(cls):
+        cls.tmpdir = tempfile.mkdtemp()
+        layer = QgsRasterLayer(os.path.join(unitTestDataPath('raster'), 'band3_byte_noct_epsg4326.tif'), 'raster')
+        assert layer.isValid()
+        cls.extent = layer.extent()
+        project = QgsProject()
+        project.addMapLayer(layer)
+        project.setCrs(QgsCoordinateReferenceSystem('EPSG:4326'))
+        cls.projectPath = os.path.join(cls.tmpdir, 'metatiles.qgs')
+        assert project.write(cls.projectPath)
+
+        # this process renders the tiles directly
+        for env in ('QGIS_SERVER_METATILE_SIZE', 'QGIS_SERVER_TILE_CACHE_DIRECTORY', 'QGIS_PROJECT_FILE'):
+            os.environ.pop(env, None)
+        cls.server = QgsServer()
+
+    @classmethod
+    def tearDownClass(cls):
+        shutil.rmtree(cls.tmpdir, True)
+
+    def getMap(self, version, bbox):
+        crsParam = 'CRS' if version == '1.3.0' else 'SRS'
+        return '&'.join(['MAP=' + self.projectPath, 'SERVICE=WMS', 'VERSION=' + version, 'REQUEST=GetMap',
+                         'LAYERS=raster', 'STYLES=', crsParam + '=EPSG:4326', 'FORMAT=image/png',
+                         'WIDTH=256', 'HEIGHT=256', 'BBOX=' + ','.join(repr(v) for v in bbox)])
+
+    def renderDirectly(self, query):
+        response = QgsBufferServerResponse()
+        self.server.handleRequest(QgsBufferServerRequest('http://server/?' + query), response)
+        return QImage.fromData(bytes(response.body()), 'PNG').convertToFormat(QImage.Format_ARGB32)
+
+    def assertSameImage(self, image, expected, name):
+        self.assertFalse(image.isNull(), name)
+        self.assertEqual(image.size(), expected.size(), name)
+        # the metatile may only differ where the resampling of a raster cell is not exact
+        mismatch = sum(1 for y in range(image.height()) for x in range(image.width()) if image.pixel(x, y) != expected.pixel(x, y))
+        self.assertLess(mismatch, image.width() * image.height() // 100, name)
+
+    def test_metatile_slices(self):
+        # tiles of a grid with its origin at 0, 0, in the second column and row of a 2 x 2 metatile
+        span = min(self.extent.width(), self.extent.height()) / 6
+        col = 2 * int(math.ceil(self.extent.xMinimum() / (2 * span))) + 1
+        row = 2 * int(math.ceil(self.extent.yMinimum() / (2 * span))) + 1
+        tiles = [(col, row), (col - 1, row), (col, row - 1), (col - 1, row - 1)]
+
+        queries = []
+        for c, r in tiles:
+            # WMS 1.3.0 has latitude first for EPSG:4326, 1.1.1 longitude first
+            queries.append(self.getMap('1.3.0', (r * span, c * span, (r + 1) * span, (c + 1) * span)))
+            queries.append(self.getMap('1.1.1', (c * span, r * span, (c + 1) * span, (r + 1) * span)))
+
+        cacheDir = os.path.join(self.tmpdir, 'cache')
+        env = dict(os.environ)
+        env['QGIS_SERVER_METATILE_SIZE'] = '2'
+        env['QGIS_SERVER_TILE_CACHE_DIRECTORY'] = cacheDir
+        subprocess.check_call([sys.executable, '-c', RENDER_TILES_SCRIPT, self.tmpdir] + queries, env=env)
+
+        # one metatile per version, sliced in 4 tiles
+        tileFiles = [f for root, dirs, files in os.walk(cacheDir) for f in files if f.endswith('.png')]
+        self.assertEqual(len(tileFiles), 8)
+
+        for i, query in enumerate(queries):
+            expected = self.renderDirectly(query)
+            tile = QImage(os.path.join(self.tmpdir, 'tile{}.png'.format(i)), 'PNG').convertToFormat(QImage.Format_ARGB32)
+            self.assertSameImage(tile, expected, query)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,199 @@
+# -*- coding: utf-8 -*-
+"""QGIS Unit tests for the preforking worker processes of QGIS Server.
+
+.. note:: This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+"""
+__author__ = 'QGIS contributors'
+__date__ = '18/10/2017'
+__copyright__ = 'Copyright 2017, The QGIS Project'
+# This will get replaced with a git SHA1 when you do a git archive
+__revision__ = '$Format:%H$'
+
+import os
+import shutil
+import signal
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+from utilities import unitTestDataPath
+from qgis.testing import unittest
+
+FCGI_BEGIN_REQUEST = 1
+FCGI_END_REQUEST = 3
+FCGI_PARAMS = 4
+FCGI_STDIN = 5
+FCGI_STDOUT = 6
+FCGI_RESPONDER = 1
+
+
+def fcgiRecord(recordType, content, requestId=1):
+    return struct.pack('!BBHHBB', 1, recordType, requestId, len(content), 0, 0) + content
+
+
+def fcgiParams(params):
+    content = b''
+    for name, value in params.items():
+        name = name.encode()
+        value = value.encode()
+        for length in (len(name), len(value)):
+            content += struct.pack('!B', length) if length < 128 else struct.pack('!I', length | 0x80000000)
+        content += name + value
+    return content
+
+
+def fcgiRequest(address, queryString):
+    """Sends a GET request to the FastCGI server listening on address and returns the response"""
+    params = {
+        'REQUEST_METHOD': 'GET',
+        'QUERY_STRING': queryString,
+        'REQUEST_URI': '/qgis_mapserv.fcgi?' + queryString,
+        'SERVER_NAME': 'localhost',
+        'SERVER_PORT': '80',
+        'SERVER_PROTOCOL': 'HTTP/1.1',
+    }
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.settimeout(60)
+    s.connect(address)
+    s.sendall(fcgiRecord(FCGI_BEGIN_REQUEST, struct.pack('!HB5x', FCGI_RESPONDER, 0)) +
+              fcgiRecord(FCGI_PARAMS, fcgiParams(params)) +
+              fcgiRecord(FCGI_PARAMS, b'') +
+              fcgiRecord(FCGI_STDIN, b''))
+
+    data = b''
+    stdout = b''
+    while True:
+        chunk = s.recv(65536)
+        if not chunk:
+            break
+        data += chunk
+        while len(data) >= 8:
+            _, recordType, _, length, padding, _ = struct.unpack('!BBHHBB', data[:8])
+            if len(data) < 8 + length + padding:
+                break
+            if recordType == FCGI_STDOUT:
+                stdout += data[8:8 + length]
+            elif recordType == FCGI_END_REQUEST:
+                s.close()
+                return stdout
+            data = data[8 + length + padding:]
+    s.close()
+    return stdout
+
+
+def childProcesses(pid):
+    """Returns the pids of the processes whose parent is pid"""
+    children = []
+    for entry in os.listdir('/proc'):
+        if not entry.isdigit():
+            continue
+        try:
+            with open(os.path.join('/proc', entry, 'stat')) as f:
+                stat = f.read()
+        except IOError:
+            continue
+        # the command name may contain spaces, the parent pid follows the state after it
+        if int(stat[stat.rindex(')') + 2:].split()[1]) == pid:
+            children.append(int(entry))
+    return children
+
+
+@unittest.skipIf(not sys.platform.startswith('linux'), 'Worker processes are checked through /proc')
+class TestQgsServerWorkers(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.fcgiBin = os.path.join(os.environ.get('QGIS_PREFIX_PATH', ''), 'bin', 'qgis_mapserv.fcgi')
+
+    def setUp(self):
+        if not os.path.exists(self.fcgiBin):
+            self.skipTest('qgis_mapserv.fcgi not found')
+
+        self.tmpdir = tempfile.mkdtemp()
+        self.address = os.path.join(self.tmpdir, 'qgis_mapserv.sock')
+        self.listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self.listener.bind(self.address)
+        self.listener.listen(16)
+
+        env = dict(os.environ)
+        env['QGIS_SERVER_WORKERS'] = '2'
+        env['QGIS_PROJECT_FILE'] = os.path.join(unitTestDataPath('qgis_server'), 'test_project.qgs')
+        # FastCGI servers get their listening socket as standard input
+        self.server = subprocess.Popen([self.fcgiBin], stdin=self.listener.fileno(), env=env)
+
+    def tearDown(self):
+        if self.server.poll() is None:
+            self.server.kill()
+            self.server.wait()
+        self.listener.close()
+        shutil.rmtree(self.tmpdir, True)
+
+    def waitForWorkers(self, count, exclude=()):
+        workers = []
+        for i in range(200):
+            workers = [pid for pid in childProcesses(self.server.pid) if pid not in exclude]
+            if len(workers) == count:
+                break
+            time.sleep(0.1)
+        self.assertEqual(len(workers), count)
+        return workers
+
+    def test_serve_from_workers(self):
+        workers = self.waitForWorkers(2)
+
+        # each request is handled by one of the forked workers, which share the project preloaded by the master
+        for i in range(4):
+            response = fcgiRequest(self.address, 'SERVICE=WMS&VERSION=1.3.0&REQUEST=GetCapabilities')
+            self.assertIn(b'WMS_Capabilities', response)
+            self.assertIn(b'testlayer', response)
+        self.assertEqual(sorted(childProcesses(self.server.pid)), sorted(workers))
+
+        # a worker which exits is replaced by a new one
+        os.kill(workers[0], signal.SIGKILL)
+        self.waitForWorkers(1, exclude=workers)
+        response = fcgiRequest(self.address, 'SERVICE=WMS&VERSION=1.3.0&REQUEST=GetCapabilities')
+        self.assertIn(b'WMS_Capabilities', response)
+
+        # the master stops the workers and exits
+        self.server.send_signal(signal.SIGTERM)
+        self.assertEqual(self.server.wait(60), 0)
+
+    def test_concurrent_requests(self):
+        self.waitForWorkers(2)
+
+        # the workers read the shapefile of the preloaded project at the same time, each with its own file handle
+        getMap = ('SERVICE=WMS&VERSION=1.3.0&REQUEST=GetMap&LAYERS=testlayer%20%C3%A8%C3%A9&STYLES=&CRS=EPSG:4326'
+                  '&BBOX=44.9009,8.2020,44.9020,8.2061&WIDTH=200&HEIGHT=100&FORMAT=image/png')
+        getFeature = 'SERVICE=WFS&VERSION=1.0.0&REQUEST=GetFeature&TYPENAME=testlayer'
+        responses = {}
+
+        def run(index):
+            query = getMap if index % 2 == 0 else getFeature
+            responses[index] = fcgiRequest(self.address, query)
+
+        threads = [threading.Thread(target=run, args=(i,)) for i in range(16)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join(120)
+
+        self.assertEqual(len(responses), 16)
+        for index, response in responses.items():
+            if index % 2 == 0:
+                self.assertIn(b'image/png', response)
+                self.assertIn(b'\x89PNG', response)
+            else:
+                self.assertIn(b'featureMember', response)
+                self.assertEqual(response.count(b'<qgs:testlayer'), 3)
+
+
+if __name__ == '__main__':
+    unittest.main()